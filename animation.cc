@@ -0,0 +1,338 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#include "animation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_set>
+#include <vector>
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <glog/logging.h>
+
+#include "model.h"
+#include "simd_math.h"
+#include "thread_pool.h"
+#include "transformations.h"
+
+namespace wvu {
+namespace {
+
+// Number of keyframes the cursor is moved forward one by one before falling
+// back to a binary search, e.g., after a long pause.
+constexpr int kMaxCursorSteps = 4;
+
+// Number of rotations slerped together by the animator.
+constexpr int kSlerpBlockSize = 64;
+
+// Returns the index k of the keyframe that starts the segment containing the
+// time, i.e., times[k] <= time < times[k + 1], clamped to the valid segments.
+int FindKeyframe(const std::vector<float>& times,
+                 const float time,
+                 int* cursor) {
+  const int last_segment = static_cast<int>(times.size()) - 2;
+  int key = std::min(std::max(*cursor, 0), last_segment);
+  if (time < times[key]) {
+    // The time went backward, e.g., the clip looped.
+    key = std::upper_bound(times.begin(), times.begin() + key, time) -
+          times.begin() - 1;
+  } else {
+    int num_steps = 0;
+    while (key < last_segment && times[key + 1] <= time) {
+      if (++num_steps > kMaxCursorSteps) {
+        key = std::upper_bound(times.begin() + key, times.end() - 1, time) -
+              times.begin() - 1;
+        break;
+      }
+      ++key;
+    }
+  }
+  key = std::max(key, 0);
+  *cursor = key;
+  return key;
+}
+
+// Returns the interpolation parameter of the time in the segment [key,
+// key + 1], clamped to [0, 1].
+float ComputeSegmentParameter(const std::vector<float>& times,
+                              const int key,
+                              const float time) {
+  const float length = times[key + 1] - times[key];
+  if (length <= 0.0f) return 1.0f;
+  return std::min(std::max((time - times[key]) / length, 0.0f), 1.0f);
+}
+
+// Returns the derivative of the curve at the keyframe, estimated with the
+// differences of its neighbors (Catmull-Rom).
+template <typename Vector>
+Vector ComputeTangent(const float* times,
+                      const Vector* values,
+                      const int num_values,
+                      const int key) {
+  const int previous = std::max(key - 1, 0);
+  const int next = std::min(key + 1, num_values - 1);
+  const float length = times[next] - times[previous];
+  if (length <= 0.0f) return Vector::Zero();
+  return (values[next] - values[previous]) / length;
+}
+
+// Evaluates the cubic Hermite curve of the segment [key, key + 1].
+template <typename Vector>
+Vector InterpolateCubic(const float* times,
+                        const Vector* values,
+                        const int num_values,
+                        const int key,
+                        const float t) {
+  const float length = times[key + 1] - times[key];
+  const float t2 = t * t;
+  const float t3 = t2 * t;
+  return (2.0f * t3 - 3.0f * t2 + 1.0f) * values[key] +
+         (t3 - 2.0f * t2 + t) * length *
+             ComputeTangent(times, values, num_values, key) +
+         (-2.0f * t3 + 3.0f * t2) * values[key + 1] +
+         (t3 - t2) * length *
+             ComputeTangent(times, values, num_values, key + 1);
+}
+
+// Finds the keyframes of a rotation track around the time. Returns false
+// when the track holds a single rotation at that time.
+bool FindRotationSegment(const RotationTrack& track,
+                         const float time,
+                         int* cursor,
+                         int* key,
+                         float* t) {
+  if (track.values.size() == 1 || time <= track.times.front()) {
+    *key = 0;
+    return false;
+  }
+  if (time >= track.times.back()) {
+    *key = track.values.size() - 1;
+    return false;
+  }
+  *key = FindKeyframe(track.times, time, cursor);
+  *t = ComputeSegmentParameter(track.times, *key, time);
+  return true;
+}
+
+// Returns the position of the animation in its clip.
+float ComputeClipTime(const float time,
+                      const float start_time,
+                      const float duration,
+                      const bool loop) {
+  const float clip_time = time - start_time;
+  if (!loop || duration <= 0.0f) return clip_time;
+  const float wrapped_time = std::fmod(clip_time, duration);
+  return wrapped_time < 0.0f ? wrapped_time + duration : wrapped_time;
+}
+
+}  // namespace
+
+float GetClipDuration(const AnimationClip& clip) {
+  float duration = 0.0f;
+  if (!clip.position.times.empty()) {
+    duration = std::max(duration, clip.position.times.back());
+  }
+  if (!clip.rotation.times.empty()) {
+    duration = std::max(duration, clip.rotation.times.back());
+  }
+  if (!clip.scale.times.empty()) {
+    duration = std::max(duration, clip.scale.times.back());
+  }
+  return duration;
+}
+
+Eigen::Vector3f SampleTrack(const Vector3Track& track,
+                            const float time,
+                            int* cursor) {
+  CHECK(!track.values.empty());
+  CHECK_EQ(track.times.size(), track.values.size());
+  if (track.values.size() == 1 || time <= track.times.front()) {
+    return track.values.front();
+  }
+  if (time >= track.times.back()) return track.values.back();
+  const int key = FindKeyframe(track.times, time, cursor);
+  const float t = ComputeSegmentParameter(track.times, key, time);
+  if (track.interpolation == KeyframeInterpolation::CUBIC) {
+    return InterpolateCubic(track.times.data(), track.values.data(),
+                            track.values.size(), key, t);
+  }
+  return (1.0f - t) * track.values[key] + t * track.values[key + 1];
+}
+
+Eigen::Quaternionf SampleTrack(const RotationTrack& track,
+                               const float time,
+                               int* cursor) {
+  CHECK(!track.values.empty());
+  CHECK_EQ(track.times.size(), track.values.size());
+  int key;
+  float t;
+  if (!FindRotationSegment(track, time, cursor, &key, &t)) {
+    return track.values[key];
+  }
+  if (track.interpolation == KeyframeInterpolation::LINEAR) {
+    return Slerp(track.values[key], track.values[key + 1], t);
+  }
+  // The spline goes through the coefficients of the four rotations around
+  // the segment, flipped to the hemisphere of the first one so that it takes
+  // the shortest arcs.
+  const int first = std::max(key - 1, 0);
+  const int last = std::min<int>(key + 2, track.values.size() - 1);
+  const Eigen::Vector4f& reference = track.values[key].coeffs();
+  Eigen::Vector4f coefficients[4];
+  for (int i = first; i <= last; ++i) {
+    const Eigen::Vector4f& value = track.values[i].coeffs();
+    coefficients[i - first] = value.dot(reference) < 0.0f ? -value : value;
+  }
+  Eigen::Quaternionf rotation;
+  rotation.coeffs() = InterpolateCubic(&track.times[first], coefficients,
+                                       last - first + 1, key - first, t);
+  return rotation.normalized();
+}
+
+int TransformStore::Add(const Model& model) {
+  positions.push_back(model.position());
+  rotations.push_back(model.rotation());
+  scales.push_back(model.scale());
+  return positions.size() - 1;
+}
+
+void TransformStore::Apply(const int index, Model* model) const {
+  model->set_position(positions[index]);
+  model->set_rotation(rotations[index]);
+  model->set_scale(scales[index]);
+}
+
+void TransformStore::ComputeModelMatrices(
+    std::vector<Eigen::Matrix4f>* model_matrices) const {
+  const int num_transforms = positions.size();
+  std::vector<Quat> quaternions(num_transforms);
+  for (int i = 0; i < num_transforms; ++i) {
+    quaternions[i] = ToQuat(rotations[i]);
+  }
+  std::vector<Mat4> matrices(num_transforms);
+  QuatToMat4Batch(quaternions.data(), num_transforms, matrices.data());
+  model_matrices->resize(num_transforms);
+  for (int i = 0; i < num_transforms; ++i) {
+    Eigen::Matrix4f& model_matrix = (*model_matrices)[i];
+    model_matrix = ToEigen(matrices[i]);
+    model_matrix.topLeftCorner<3, 3>() *= scales[i].asDiagonal();
+    model_matrix.block<3, 1>(0, 3) = positions[i];
+  }
+}
+
+void Animator::Play(const AnimationClip* clip,
+                    const int transform_index,
+                    const float start_time) {
+  CHECK(clip != nullptr);
+  CHECK_GE(transform_index, 0);
+  CHECK(animated_transforms_.insert(transform_index).second)
+      << "The transform " << transform_index << " is already animated.";
+  Animation animation;
+  animation.clip = clip;
+  animation.transform_index = transform_index;
+  animation.start_time = start_time;
+  animation.duration = GetClipDuration(*clip);
+  animation.position_cursor = 0;
+  animation.rotation_cursor = 0;
+  animation.scale_cursor = 0;
+  animations_.push_back(animation);
+}
+
+void Animator::Evaluate(const float time,
+                        ThreadPool* thread_pool,
+                        TransformStore* transforms) {
+  // The ranges write distinct transforms (see Play) and cursors.
+  ParallelFor(animations_.size(), kSlerpBlockSize, thread_pool,
+              [&](const int begin, const int end) {
+    EvaluateRange(begin, end, time, transforms);
+  });
+}
+
+void Animator::EvaluateRange(const int begin,
+                             const int end,
+                             const float time,
+                             TransformStore* transforms) {
+  // The rotations slerped in the current block and their transforms. The
+  // inputs are zeroed since the compiler cannot tell that only the first
+  // num_slerps entries are read.
+  Quat from[kSlerpBlockSize] = {};
+  Quat to[kSlerpBlockSize] = {};
+  float weights[kSlerpBlockSize] = {};
+  Quat rotations[kSlerpBlockSize];
+  int transform_indices[kSlerpBlockSize];
+  int num_slerps = 0;
+  const auto flush_slerps = [&] {
+    SlerpQuatBatch(from, to, weights, num_slerps, rotations);
+    for (int i = 0; i < num_slerps; ++i) {
+      transforms->rotations[transform_indices[i]] = ToEigen(rotations[i]);
+    }
+    num_slerps = 0;
+  };
+
+  for (int i = begin; i < end; ++i) {
+    Animation& animation = animations_[i];
+    const AnimationClip& clip = *animation.clip;
+    const int index = animation.transform_index;
+    const float clip_time = ComputeClipTime(time, animation.start_time,
+                                            animation.duration, clip.loop);
+    if (!clip.position.values.empty()) {
+      transforms->positions[index] =
+          SampleTrack(clip.position, clip_time, &animation.position_cursor);
+    }
+    if (!clip.scale.values.empty()) {
+      transforms->scales[index] =
+          SampleTrack(clip.scale, clip_time, &animation.scale_cursor);
+    }
+    const RotationTrack& rotation = clip.rotation;
+    if (rotation.values.empty()) continue;
+    int key;
+    float t;
+    if (rotation.interpolation != KeyframeInterpolation::LINEAR ||
+        !FindRotationSegment(rotation, clip_time, &animation.rotation_cursor,
+                             &key, &t)) {
+      transforms->rotations[index] =
+          SampleTrack(rotation, clip_time, &animation.rotation_cursor);
+      continue;
+    }
+    from[num_slerps] = ToQuat(rotation.values[key]);
+    to[num_slerps] = ToQuat(rotation.values[key + 1]);
+    weights[num_slerps] = t;
+    transform_indices[num_slerps] = index;
+    if (++num_slerps == kSlerpBlockSize) flush_slerps();
+  }
+  flush_slerps();
+}
+
+}  // namespace wvu
@@ -0,0 +1,188 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef ANIMATION_H_
+#define ANIMATION_H_
+
+#include <unordered_set>
+#include <vector>
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+namespace wvu {
+class Model;
+class ThreadPool;
+
+// How the values between two keyframes are computed.
+enum struct KeyframeInterpolation {
+  // Linear interpolation of the vectors and slerp of the rotations.
+  LINEAR,
+  // Catmull-Rom spline through the neighboring keyframes. The rotations are
+  // interpolated component-wise and normalized.
+  CUBIC,
+};
+
+// A keyframed curve: values[i] is the value at times[i] (in seconds). The
+// times must be increasing. Before the first and after the last keyframe the
+// curve holds the value of the keyframe.
+template <typename T>
+struct KeyframeTrack {
+  std::vector<float> times;
+  std::vector<T> values;
+  KeyframeInterpolation interpolation = KeyframeInterpolation::LINEAR;
+};
+
+typedef KeyframeTrack<Eigen::Vector3f> Vector3Track;
+typedef KeyframeTrack<Eigen::Quaternionf> RotationTrack;
+
+// The animation of the pose of an object. Empty tracks do not animate their
+// part of the pose.
+struct AnimationClip {
+  Vector3Track position;
+  RotationTrack rotation;
+  Vector3Track scale;
+  // When true, the clip restarts after its last keyframe.
+  bool loop = false;
+};
+
+// Returns the time of the last keyframe of the clip.
+float GetClipDuration(const AnimationClip& clip);
+
+// Returns the value of the track at the given time. The cursor caches the
+// keyframe found by the previous call: when the calls move forward in time,
+// as the frames do, the keyframe is found in constant time. Each track needs
+// its own cursor, initialized to zero.
+// Params:
+//   track  The track. It must have at least one keyframe.
+//   time  The time in seconds.
+//   cursor  The cached keyframe of the track.
+Eigen::Vector3f SampleTrack(const Vector3Track& track,
+                            const float time,
+                            int* cursor);
+Eigen::Quaternionf SampleTrack(const RotationTrack& track,
+                               const float time,
+                               int* cursor);
+
+// The poses of a set of objects, stored as arrays so that they are evaluated
+// and turned into model matrices in batches. The three arrays have the same
+// size: the transform i is (positions[i], rotations[i], scales[i]).
+struct TransformStore {
+  std::vector<Eigen::Vector3f> positions;
+  std::vector<Eigen::Quaternionf> rotations;
+  std::vector<Eigen::Vector3f> scales;
+
+  // Appends the pose of a model and returns its index.
+  int Add(const Model& model);
+
+  // Sets the pose of a model to the transform at the given index.
+  void Apply(const int index, Model* model) const;
+
+  // Builds the model matrices (translation * rotation * scaling) of all the
+  // transforms with the batched kernels of simd_math.h.
+  void ComputeModelMatrices(std::vector<Eigen::Matrix4f>* model_matrices) const;
+};
+
+// Plays animation clips on the transforms of a TransformStore. Evaluating
+// the animations is separate from drawing: the cost depends on the number of
+// animated objects only, and the draw calls read the poses it wrote. Usage
+// example:
+//
+// wvu::TransformStore transforms;
+// wvu::Animator animator;
+// for (Model* model : models) {
+//   animator.Play(&clip, transforms.Add(*model), 0.0f);
+// }
+// ...
+// // Every frame.
+// animator.Evaluate(glfwGetTime(), &thread_pool, &transforms);
+// for (int i = 0; i < models.size(); ++i) {
+//   transforms.Apply(i, models[i]);
+// }
+class Animator {
+ public:
+  // Plays a clip on a transform. A transform can only be animated by one
+  // clip, since the animations are evaluated in parallel; playing a second
+  // clip on it is a fatal error.
+  // Params:
+  //   clip  The clip. It is not owned and must outlive the animator.
+  //   transform_index  The index of the transform in the store.
+  //   start_time  The time at which the clip starts, in seconds.
+  void Play(const AnimationClip* clip,
+            const int transform_index,
+            const float start_time);
+
+  // Writes the poses of all the animations at the given time into the
+  // store. The rotations of linear tracks are interpolated in batches with
+  // SlerpQuatBatch.
+  // Params:
+  //   time  The time in seconds.
+  //   thread_pool  The pool the animations are evaluated on, split in one
+  //     contiguous range per worker, or nullptr to evaluate them on the
+  //     calling thread.
+  //   transforms  The store the poses are written into.
+  void Evaluate(const float time,
+                ThreadPool* thread_pool,
+                TransformStore* transforms);
+
+  // Returns the number of animations played.
+  int num_animations() const {
+    return animations_.size();
+  }
+
+ private:
+  // A clip played on a transform, with the cursors of its tracks.
+  struct Animation {
+    const AnimationClip* clip;
+    int transform_index;
+    float start_time;
+    float duration;
+    int position_cursor;
+    int rotation_cursor;
+    int scale_cursor;
+  };
+
+  // Evaluates the animations in [begin, end).
+  void EvaluateRange(const int begin,
+                     const int end,
+                     const float time,
+                     TransformStore* transforms);
+
+  std::vector<Animation> animations_;
+  // The transforms animated by the animations.
+  std::unordered_set<int> animated_transforms_;
+};
+
+}  // namespace wvu
+
+#endif  // ANIMATION_H_
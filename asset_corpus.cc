@@ -0,0 +1,178 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#include "asset_corpus.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace wvu {
+namespace {
+
+// Appends a formatted line.
+template <typename... Args>
+void AppendLine(std::string* contents, const char* format, Args... args) {
+  char line[128];
+  const int size = std::snprintf(line, sizeof(line), format, args...);
+  contents->append(line, size);
+}
+
+// Appends a face element in the format of the attributes.
+void AppendFaceElement(const int index,
+                       const ObjAttributes attributes,
+                       std::string* contents) {
+  switch (attributes) {
+    case ObjAttributes::POSITIONS:
+      AppendLine(contents, " %d", index);
+      break;
+    case ObjAttributes::POSITIONS_TEXELS:
+      AppendLine(contents, " %d/%d", index, index);
+      break;
+    case ObjAttributes::POSITIONS_NORMALS:
+      AppendLine(contents, " %d//%d", index, index);
+      break;
+    case ObjAttributes::POSITIONS_TEXELS_NORMALS:
+      AppendLine(contents, " %d/%d/%d", index, index, index);
+      break;
+  }
+}
+
+}  // namespace
+
+const char* GetObjAttributesName(const ObjAttributes attributes) {
+  switch (attributes) {
+    case ObjAttributes::POSITIONS: return "v";
+    case ObjAttributes::POSITIONS_TEXELS: return "v_vt";
+    case ObjAttributes::POSITIONS_NORMALS: return "v_vn";
+    case ObjAttributes::POSITIONS_TEXELS_NORMALS: return "v_vt_vn";
+  }
+  return "";
+}
+
+void GenerateObjModel(const int num_triangles,
+                      const ObjAttributes attributes,
+                      std::string* contents) {
+  if (contents == nullptr) return;
+  const int num_cells = std::max(1, static_cast<int>(
+      std::ceil(std::sqrt(num_triangles / 2.0))));
+  const int num_columns = num_cells + 1;
+  const bool has_texels = attributes == ObjAttributes::POSITIONS_TEXELS ||
+      attributes == ObjAttributes::POSITIONS_TEXELS_NORMALS;
+  const bool has_normals = attributes == ObjAttributes::POSITIONS_NORMALS ||
+      attributes == ObjAttributes::POSITIONS_TEXELS_NORMALS;
+  contents->clear();
+  contents->reserve((has_texels + has_normals + 1) * 32 *
+                    num_columns * num_columns + 64 * num_cells * num_cells);
+  AppendLine(contents, "# Generated height field, %d triangles.\n",
+             2 * num_cells * num_cells);
+  for (int y = 0; y < num_columns; ++y) {
+    for (int x = 0; x < num_columns; ++x) {
+      const float u = static_cast<float>(x) / num_cells;
+      const float v = static_cast<float>(y) / num_cells;
+      const float height = 0.1f * std::sin(8.0f * u) * std::cos(8.0f * v);
+      AppendLine(contents, "v %f %f %f\n", u - 0.5f, height, v - 0.5f);
+    }
+  }
+  if (has_texels) {
+    for (int y = 0; y < num_columns; ++y) {
+      for (int x = 0; x < num_columns; ++x) {
+        AppendLine(contents, "vt %f %f\n",
+                   static_cast<float>(x) / num_cells,
+                   static_cast<float>(y) / num_cells);
+      }
+    }
+  }
+  if (has_normals) {
+    for (int y = 0; y < num_columns; ++y) {
+      for (int x = 0; x < num_columns; ++x) {
+        const float u = static_cast<float>(x) / num_cells;
+        const float v = static_cast<float>(y) / num_cells;
+        // The gradient of the height.
+        const float dx = 0.8f * std::cos(8.0f * u) * std::cos(8.0f * v);
+        const float dz = -0.8f * std::sin(8.0f * u) * std::sin(8.0f * v);
+        const float norm = std::sqrt(dx * dx + 1.0f + dz * dz);
+        AppendLine(contents, "vn %f %f %f\n",
+                   -dx / norm, 1.0f / norm, -dz / norm);
+      }
+    }
+  }
+  for (int y = 0; y < num_cells; ++y) {
+    for (int x = 0; x < num_cells; ++x) {
+      // OBJ indices start at 1.
+      const int top_left = y * num_columns + x + 1;
+      const int corners[2][3] = {
+        {top_left, top_left + num_columns, top_left + 1},
+        {top_left + 1, top_left + num_columns, top_left + num_columns + 1}};
+      for (const auto& triangle : corners) {
+        contents->push_back('f');
+        for (const int index : triangle) {
+          AppendFaceElement(index, attributes, contents);
+        }
+        contents->push_back('\n');
+      }
+    }
+  }
+}
+
+void GenerateImage(const int width,
+                   const int height,
+                   const uint32_t seed,
+                   std::vector<uint8_t>* rgb_pixels) {
+  if (rgb_pixels == nullptr) return;
+  std::mt19937 engine(seed);
+  std::uniform_int_distribution<int> noise(-8, 8);
+  rgb_pixels->resize(3 * width * height);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      const float u = static_cast<float>(x) / width;
+      const float v = static_cast<float>(y) / height;
+      const float base[3] = {
+        200.0f * u + 30.0f,
+        120.0f + 80.0f * std::sin(6.0f * u + 4.0f * v),
+        200.0f * (1.0f - v) + 20.0f};
+      for (int c = 0; c < 3; ++c) {
+        const int value = static_cast<int>(base[c]) + noise(engine);
+        (*rgb_pixels)[3 * (y * width + x) + c] =
+            static_cast<uint8_t>(std::min(255, std::max(0, value)));
+      }
+    }
+  }
+}
+
+}  // namespace wvu
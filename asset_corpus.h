@@ -0,0 +1,80 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef ASSET_CORPUS_H_
+#define ASSET_CORPUS_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace wvu {
+
+// Attributes of the vertices of the faces of an OBJ model, i.e., the face
+// element formats v, v/vt, v//vn and v/vt/vn.
+enum struct ObjAttributes {
+  POSITIONS = 0,
+  POSITIONS_TEXELS = 1,
+  POSITIONS_NORMALS = 2,
+  POSITIONS_TEXELS_NORMALS = 3
+};
+
+// Returns a short name of the attributes, e.g., "v_vt_vn".
+const char* GetObjAttributesName(const ObjAttributes attributes);
+
+// Generates an OBJ model: a wavy height field of square cells, two triangles
+// each, with one texel and one normal per vertex when requested.
+// Params:
+//   num_triangles  The minimum number of triangles.
+//   attributes  The attributes of the face elements.
+//   contents  The contents of the OBJ file.
+void GenerateObjModel(const int num_triangles,
+                      const ObjAttributes attributes,
+                      std::string* contents);
+
+// Generates an RGB image resembling a photograph for the decoders: smooth
+// gradients with a little noise.
+// Params:
+//   width  The width of the image.
+//   height  The height of the image.
+//   seed  The seed of the noise.
+//   rgb_pixels  The pixels, row by row.
+void GenerateImage(const int width,
+                   const int height,
+                   const uint32_t seed,
+                   std::vector<uint8_t>* rgb_pixels);
+
+}  // namespace wvu
+
+#endif  // ASSET_CORPUS_H_
@@ -0,0 +1,557 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#include "asset_manager.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <Eigen/Core>
+#include <GL/glew.h>
+// The macro below disables the capabilities of displaying images in CImg.
+#define cimg_display 0
+#include <CImg.h>
+
+#include "cooked_assets.h"
+#include "mesh_optimizer.h"
+#include "model.h"
+#include "model_loader.h"
+#include "pak_archive.h"
+#include "shader_program.h"
+#include "texture_compression.h"
+#include "thread_pool.h"
+#include "upload_thread.h"
+
+namespace wvu {
+namespace {
+bool HasSuffix(const std::string& str, const std::string& suffix) {
+  return str.size() >= suffix.size() &&
+      str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Returns the bytes of an asset: in place when the archive has it
+// uncompressed, or read into storage from the archive or the file system.
+bool GetAssetBytes(const PakReader* archive,
+                   const std::string& path,
+                   std::string* storage,
+                   ByteSpan* bytes) {
+  if (archive != nullptr && archive->GetSpan(path, bytes)) return true;
+  if (archive != nullptr && archive->Read(path, nullptr, storage)) {
+    *bytes = {storage->data(), storage->size()};
+    return true;
+  }
+  if (!ReadFileContents(path, storage)) return false;
+  *bytes = {storage->data(), storage->size()};
+  return true;
+}
+
+// Reads an asset from the archive, or from the file system when the archive
+// does not have it.
+bool ReadAsset(const PakReader* archive,
+               const std::string& path,
+               std::string* contents) {
+  if (archive != nullptr && archive->Read(path, nullptr, contents)) {
+    return true;
+  }
+  return ReadFileContents(path, contents);
+}
+
+bool LoadImageFromFile(const std::string& filepath,
+                       cimg_library::CImg<unsigned char>* image) {
+  try {
+    image->load(filepath.c_str());
+  } catch (const cimg_library::CImgException& exception) {
+    return false;
+  }
+  return true;
+}
+
+// Decodes an image held in memory. The format is given by the extension of
+// the path; JPEG and PNG need CImg to be built with libjpeg and libpng.
+bool LoadImageFromMemory(const std::string& path,
+                         const ByteSpan& bytes,
+                         cimg_library::CImg<unsigned char>* image) {
+  std::FILE* file = fmemopen(const_cast<char*>(bytes.data), bytes.size, "rb");
+  if (file == nullptr) return false;
+  bool success = true;
+  try {
+    if (HasSuffix(path, ".bmp")) {
+      image->load_bmp(file);
+    } else if (HasSuffix(path, ".jpg")) {
+      image->load_jpeg(file);
+    } else if (HasSuffix(path, ".png")) {
+      image->load_png(file);
+    } else {
+      success = false;
+    }
+  } catch (const cimg_library::CImgException& exception) {
+    success = false;
+  }
+  std::fclose(file);
+  return success;
+}
+
+// Creates the VAO of a mesh whose buffers are filled.
+void CreateMeshVertexArray(Mesh* mesh) {
+  glGenVertexArrays(1, &mesh->vertex_array_object_id);
+  glBindVertexArray(mesh->vertex_array_object_id);
+  glBindBuffer(GL_ARRAY_BUFFER, mesh->vertex_buffer_object_id);
+  Model::SetVertexAttributes();
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->element_buffer_object_id);
+  glBindVertexArray(0);
+}
+
+// Creates a texture from a full mipmap chain.
+void UploadMipLevels(const std::vector<MipLevel>& levels,
+                     const bool compressed,
+                     GLuint* texture_id) {
+  glGenTextures(1, texture_id);
+  glBindTexture(GL_TEXTURE_2D, *texture_id);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                  GL_LINEAR_MIPMAP_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels.size() - 1);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  for (int i = 0; i < levels.size(); ++i) {
+    if (compressed) {
+      glCompressedTexImage2D(GL_TEXTURE_2D, i,
+                             GL_COMPRESSED_RGB_S3TC_DXT1_EXT,
+                             levels[i].width, levels[i].height, 0,
+                             levels[i].data.size(), levels[i].data.data());
+    } else {
+      glTexImage2D(GL_TEXTURE_2D, i, GL_RGB, levels[i].width,
+                   levels[i].height, 0, GL_RGB, GL_UNSIGNED_BYTE,
+                   levels[i].data.data());
+    }
+  }
+  glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+}  // namespace
+
+AssetManager::AssetManager(const int num_threads) :
+    num_loading_(0), upload_thread_(nullptr), archive_(nullptr),
+    max_uploads_per_update_(4),
+    thread_pool_(num_threads) {}
+
+AssetManager::~AssetManager() {
+  thread_pool_.Wait();
+  for (const std::unique_ptr<AssetRecord>& record : records_) {
+    if (record->state != AssetState::READY) continue;
+    if (record->type == MESH) {
+      glDeleteVertexArrays(1, &record->mesh.vertex_array_object_id);
+      glDeleteBuffers(1, &record->mesh.vertex_buffer_object_id);
+      glDeleteBuffers(1, &record->mesh.element_buffer_object_id);
+    } else if (record->type == TEXTURE) {
+      glDeleteTextures(1, &record->texture.texture_id);
+    }
+  }
+}
+
+MeshHandle AssetManager::LoadMesh(const std::string& filepath) {
+  return MeshHandle(FindOrCreate(MESH, "mesh:" + filepath, {filepath}));
+}
+
+TextureHandle AssetManager::LoadTexture(const std::string& filepath) {
+  return TextureHandle(
+      FindOrCreate(TEXTURE, "texture:" + filepath, {filepath}));
+}
+
+ShaderHandle AssetManager::LoadShader(
+    const std::string& vertex_shader_filepath,
+    const std::string& fragment_shader_filepath) {
+  return ShaderHandle(FindOrCreate(
+      SHADER, "shader:" + vertex_shader_filepath + "|" +
+      fragment_shader_filepath,
+      {vertex_shader_filepath, fragment_shader_filepath}));
+}
+
+MaterialHandle AssetManager::CreateMaterial(
+    const ShaderHandle& shader,
+    const std::vector<TextureHandle>& textures) {
+  std::string key = "material:" + std::to_string(shader.id);
+  for (const TextureHandle& texture : textures) {
+    key += "," + std::to_string(texture.id);
+  }
+  const auto existing_id = ids_by_key_.find(key);
+  if (existing_id != ids_by_key_.end()) {
+    return MaterialHandle(existing_id->second);
+  }
+  // A material has nothing to decode: it only waits for its dependencies.
+  std::unique_ptr<AssetRecord> record(new AssetRecord());
+  record->type = MATERIAL;
+  record->state = AssetState::DECODED;
+  record->upload_request_id = -1;
+  record->dependencies.push_back(shader.id);
+  for (const TextureHandle& texture : textures) {
+    record->dependencies.push_back(texture.id);
+  }
+  record->material.shader_program = nullptr;
+  const int id = records_.size();
+  records_.push_back(std::move(record));
+  ids_by_key_[key] = id;
+  pending_ids_.push_back(id);
+  return MaterialHandle(id);
+}
+
+int AssetManager::FindOrCreate(const AssetType type,
+                               const std::string& key,
+                               const std::vector<std::string>& filepaths) {
+  const auto existing_id = ids_by_key_.find(key);
+  if (existing_id != ids_by_key_.end()) return existing_id->second;
+  std::unique_ptr<AssetRecord> record(new AssetRecord());
+  record->type = type;
+  record->state = AssetState::LOADING;
+  record->decoded_successfully = false;
+  record->mip_levels_compressed = false;
+  record->upload_request_id = -1;
+  record->mesh = {0, 0, 0, 0};
+  record->texture = {0, 0, 0};
+  record->material.shader_program = nullptr;
+  const int id = records_.size();
+  AssetRecord* record_ptr = record.get();
+  records_.push_back(std::move(record));
+  ids_by_key_[key] = id;
+  ++num_loading_;
+  thread_pool_.Schedule([this, id, filepaths, record_ptr] {
+    Decode(archive_, filepaths, record_ptr);
+    std::lock_guard<std::mutex> lock(mutex_);
+    decoded_ids_.push_back(id);
+  });
+  return id;
+}
+
+void AssetManager::Decode(const PakReader* archive,
+                          const std::vector<std::string>& filepaths,
+                          AssetRecord* record) {
+  switch (record->type) {
+    case MESH: {
+      std::string contents;
+      ByteSpan bytes;
+      if (HasSuffix(filepaths[0], ".wvumesh")) {
+        std::string error_info_log;
+        if (!GetAssetBytes(archive, filepaths[0], &contents, &bytes) ||
+            !DecodeCookedMesh(bytes.data, bytes.size, &record->vertices,
+                              &record->indices, &error_info_log)) {
+          record->error = "Could not load the mesh " + filepaths[0] + ". " +
+              error_info_log;
+          return;
+        }
+        break;
+      }
+      std::vector<Eigen::Vector3f> obj_vertices;
+      std::vector<Eigen::Vector2f> obj_texels;
+      std::vector<Eigen::Vector3f> obj_normals;
+      std::vector<Face> faces;
+      if (!ReadAsset(archive, filepaths[0], &contents)) {
+        record->error = "Could not load the mesh " + filepaths[0];
+        return;
+      }
+      ParseObjModel(contents, &obj_vertices, &obj_texels, &obj_normals,
+                    &faces);
+      if (faces.empty()) {
+        record->error = "Could not load the mesh " + filepaths[0];
+        return;
+      }
+      ConvertObjToMesh(obj_vertices, obj_texels, obj_normals, faces,
+                       &record->vertices, &record->indices);
+      break;
+    }
+    case TEXTURE: {
+      std::string contents;
+      ByteSpan bytes;
+      if (HasSuffix(filepaths[0], ".wvutex")) {
+        CookedTexture texture;
+        std::string error_info_log;
+        if (!GetAssetBytes(archive, filepaths[0], &contents, &bytes) ||
+            !DecodeCookedTexture(bytes.data, bytes.size, &texture,
+                                 &error_info_log) ||
+            texture.levels.empty()) {
+          record->error = "Could not load the texture " + filepaths[0] +
+              ". " + error_info_log;
+          return;
+        }
+        record->texture.width = texture.levels[0].width;
+        record->texture.height = texture.levels[0].height;
+        record->mip_levels_compressed =
+            texture.format == CookedTextureFormat::BC1;
+        if (record->mip_levels_compressed &&
+            !GLEW_EXT_texture_compression_s3tc) {
+          for (MipLevel& level : texture.levels) {
+            std::vector<uint8_t> rgb_pixels;
+            DecompressBc1(level.width, level.height, level.data, &rgb_pixels);
+            level.data.swap(rgb_pixels);
+          }
+          record->mip_levels_compressed = false;
+        }
+        record->mip_levels.swap(texture.levels);
+        break;
+      }
+      cimg_library::CImg<unsigned char> image;
+      const bool in_archive = archive != nullptr &&
+          archive->Contains(filepaths[0]);
+      if (in_archive && !GetAssetBytes(archive, filepaths[0], &contents,
+                                       &bytes)) {
+        record->error = "Could not load the texture " + filepaths[0];
+        return;
+      }
+      if (!(in_archive ? LoadImageFromMemory(filepaths[0], bytes, &image) :
+            LoadImageFromFile(filepaths[0], &image))) {
+        record->error = "Could not load the texture " + filepaths[0];
+        return;
+      }
+      record->texture.width = image.width();
+      record->texture.height = image.height();
+      // Interleave the channels, as OpenGL expects them (see LoadTexture in
+      // draw_scene.cc).
+      image.permute_axes("cxyz");
+      record->rgb_pixels.assign(image.data(), image.data() + image.size());
+      break;
+    }
+    case SHADER:
+      if (!ReadAsset(archive, filepaths[0], &record->vertex_shader_src) ||
+          !ReadAsset(archive, filepaths[1], &record->fragment_shader_src)) {
+        record->error = "Could not read the shader " + filepaths[0] + ", " +
+            filepaths[1];
+        return;
+      }
+      break;
+    case MATERIAL:
+      break;
+  }
+  record->decoded_successfully = true;
+}
+
+void AssetManager::Update() {
+  std::vector<int> decoded_ids;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    decoded_ids.swap(decoded_ids_);
+  }
+  for (const int id : decoded_ids) {
+    AssetRecord* record = records_[id].get();
+    record->state = record->decoded_successfully ? AssetState::DECODED :
+        AssetState::FAILED;
+    --num_loading_;
+    if (record->state == AssetState::DECODED) pending_ids_.push_back(id);
+  }
+  ReceiveUploads();
+
+  int num_uploads = 0;
+  std::vector<int> still_pending_ids;
+  for (const int id : pending_ids_) {
+    AssetRecord* record = records_[id].get();
+    // Done, or waiting for the upload thread.
+    if (record->state != AssetState::DECODED) continue;
+    if (record->upload_request_id >= 0) {
+      still_pending_ids.push_back(id);
+      continue;
+    }
+    bool dependencies_ready = true;
+    for (const int dependency_id : record->dependencies) {
+      const AssetState dependency_state = GetState(dependency_id);
+      if (dependency_state == AssetState::FAILED) {
+        record->state = AssetState::FAILED;
+        record->error = "A dependency failed to load.";
+        break;
+      }
+      dependencies_ready &= dependency_state == AssetState::READY;
+    }
+    if (record->state == AssetState::FAILED) continue;
+    if (!dependencies_ready || num_uploads >= max_uploads_per_update_) {
+      still_pending_ids.push_back(id);
+      continue;
+    }
+    if (record->type != MATERIAL) ++num_uploads;
+    if (!Upload(id)) still_pending_ids.push_back(id);
+  }
+  pending_ids_.swap(still_pending_ids);
+}
+
+void AssetManager::Finish() {
+  while (true) {
+    thread_pool_.Wait();
+    Update();
+    if (num_loading_ == 0 && pending_ids_.empty()) return;
+    std::this_thread::yield();
+  }
+}
+
+bool AssetManager::Upload(const int id) {
+  AssetRecord* record = records_[id].get();
+  switch (record->type) {
+    case MESH:
+      if (upload_thread_ != nullptr) {
+        record->upload_request_id =
+            upload_thread_->UploadMesh(record->vertices, record->indices);
+        break;
+      }
+      glGenBuffers(1, &record->mesh.vertex_buffer_object_id);
+      glBindBuffer(GL_ARRAY_BUFFER, record->mesh.vertex_buffer_object_id);
+      glBufferData(GL_ARRAY_BUFFER, record->vertices.size() * sizeof(GLfloat),
+                   record->vertices.data(), GL_STATIC_DRAW);
+      glBindBuffer(GL_ARRAY_BUFFER, 0);
+      // The element array binding belongs to the VAO, so the index buffer is
+      // filled through the copy-write target.
+      glGenBuffers(1, &record->mesh.element_buffer_object_id);
+      glBindBuffer(GL_COPY_WRITE_BUFFER, record->mesh.element_buffer_object_id);
+      glBufferData(GL_COPY_WRITE_BUFFER, record->indices.size() * sizeof(GLuint),
+                   record->indices.data(), GL_STATIC_DRAW);
+      glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+      CreateMeshVertexArray(&record->mesh);
+      break;
+    case TEXTURE:
+      if (!record->mip_levels.empty()) {
+        UploadMipLevels(record->mip_levels, record->mip_levels_compressed,
+                        &record->texture.texture_id);
+        break;
+      }
+      if (upload_thread_ != nullptr) {
+        record->upload_request_id = upload_thread_->UploadTexture(
+            record->texture.width, record->texture.height, record->rgb_pixels);
+        break;
+      }
+      glGenTextures(1, &record->texture.texture_id);
+      glBindTexture(GL_TEXTURE_2D, record->texture.texture_id);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+      glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, record->texture.width,
+                   record->texture.height, 0, GL_RGB, GL_UNSIGNED_BYTE,
+                   record->rgb_pixels.data());
+      glGenerateMipmap(GL_TEXTURE_2D);
+      glBindTexture(GL_TEXTURE_2D, 0);
+      break;
+    case SHADER:
+      record->shader_program.reset(new ShaderProgram());
+      record->shader_program->LoadVertexShaderFromString(
+          record->vertex_shader_src);
+      record->shader_program->LoadFragmentShaderFromString(
+          record->fragment_shader_src);
+      if (!record->shader_program->Create(&record->error)) {
+        record->state = AssetState::FAILED;
+        return true;
+      }
+      break;
+    case MATERIAL:
+      record->material.shader_program =
+          records_[record->dependencies[0]]->shader_program.get();
+      for (int i = 1; i < record->dependencies.size(); ++i) {
+        record->material.texture_ids.push_back(
+            records_[record->dependencies[i]]->texture.texture_id);
+      }
+      break;
+  }
+  if (record->type == MESH) {
+    record->mesh.num_indices = record->indices.size();
+  }
+  // The decoded data is not needed anymore.
+  record->vertices.resize(0, 0);
+  std::vector<GLuint>().swap(record->indices);
+  std::vector<GLubyte>().swap(record->rgb_pixels);
+  std::vector<MipLevel>().swap(record->mip_levels);
+  record->vertex_shader_src.clear();
+  record->fragment_shader_src.clear();
+  if (record->upload_request_id >= 0) {
+    asset_ids_by_upload_request_[record->upload_request_id] = id;
+    return false;
+  }
+  record->state = AssetState::READY;
+  return true;
+}
+
+void AssetManager::ReceiveUploads() {
+  if (upload_thread_ == nullptr) return;
+  UploadedResource resource;
+  while (upload_thread_->PollCompleted(&resource)) {
+    const auto asset_id = asset_ids_by_upload_request_.find(resource.request_id);
+    if (asset_id == asset_ids_by_upload_request_.end()) continue;
+    AssetRecord* record = records_[asset_id->second].get();
+    asset_ids_by_upload_request_.erase(asset_id);
+    if (record->type == MESH) {
+      record->mesh.vertex_buffer_object_id = resource.vertex_buffer_object_id;
+      record->mesh.element_buffer_object_id =
+          resource.element_buffer_object_id;
+      CreateMeshVertexArray(&record->mesh);
+    } else {
+      record->texture.texture_id = resource.texture_id;
+    }
+    record->upload_request_id = -1;
+    record->state = AssetState::READY;
+  }
+}
+
+AssetState AssetManager::GetState(const int id) const {
+  if (id < 0 || id >= records_.size()) return AssetState::FAILED;
+  return records_[id]->state;
+}
+
+const Mesh* AssetManager::GetMesh(const MeshHandle& handle) const {
+  if (GetState(handle.id) != AssetState::READY) return nullptr;
+  return &records_[handle.id]->mesh;
+}
+
+const Texture* AssetManager::GetTexture(const TextureHandle& handle) const {
+  if (GetState(handle.id) != AssetState::READY) return nullptr;
+  return &records_[handle.id]->texture;
+}
+
+const ShaderProgram* AssetManager::GetShader(
+    const ShaderHandle& handle) const {
+  if (GetState(handle.id) != AssetState::READY) return nullptr;
+  return records_[handle.id]->shader_program.get();
+}
+
+const Material* AssetManager::GetMaterial(
+    const MaterialHandle& handle) const {
+  if (GetState(handle.id) != AssetState::READY) return nullptr;
+  return &records_[handle.id]->material;
+}
+
+GLuint AssetManager::GetTextureId(const TextureHandle& handle) const {
+  const Texture* texture = GetTexture(handle);
+  return texture == nullptr ? 0 : texture->texture_id;
+}
+
+}  // namespace wvu
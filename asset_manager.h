@@ -0,0 +1,285 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef ASSET_MANAGER_H_
+#define ASSET_MANAGER_H_
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <Eigen/Core>
+#include <GL/glew.h>
+
+#include "mesh_optimizer.h"
+#include "model_loader.h"
+#include "shader_program.h"
+#include "texture_compression.h"
+#include "thread_pool.h"
+
+namespace wvu {
+class PakReader;
+class UploadThread;
+
+// GPU data of a mesh asset. The vertices have the layout of Model::SetVBO, so
+// the shader programs of the models can draw it.
+struct Mesh {
+  GLuint vertex_array_object_id;
+  GLuint vertex_buffer_object_id;
+  GLuint element_buffer_object_id;
+  GLsizei num_indices;
+};
+
+// GPU data of a texture asset.
+struct Texture {
+  GLuint texture_id;
+  int width;
+  int height;
+};
+
+// A material: a shader program and the textures bound to its units, in
+// order. It is ready once all of them are.
+struct Material {
+  const ShaderProgram* shader_program;
+  std::vector<GLuint> texture_ids;
+};
+
+// Typed id of an asset. The type parameter is the type of the loaded asset,
+// so that, e.g., a texture handle cannot be used as a mesh handle.
+template <typename T>
+struct AssetHandle {
+  AssetHandle() : id(-1) {}
+  explicit AssetHandle(const int id) : id(id) {}
+  bool is_valid() const { return id >= 0; }
+  bool operator==(const AssetHandle& other) const { return id == other.id; }
+  int id;
+};
+
+typedef AssetHandle<Mesh> MeshHandle;
+typedef AssetHandle<Texture> TextureHandle;
+typedef AssetHandle<ShaderProgram> ShaderHandle;
+typedef AssetHandle<Material> MaterialHandle;
+
+// Life cycle of an asset.
+enum struct AssetState {
+  // The file is being read and decoded on the worker pool.
+  LOADING = 0,
+  // Decoded; waiting for its GPU upload or for its dependencies.
+  DECODED = 1,
+  READY = 2,
+  FAILED = 3
+};
+
+// This class loads the assets of the application. A Load*() call returns a
+// typed handle right away and schedules the reading and decoding of the file
+// on a worker pool; Update(), called from the render loop, creates the GPU
+// objects of the decoded assets on the main thread, a few per call so that
+// the frame time stays flat. The accessors return nullptr (or zero) until the
+// asset is ready, so the rendering can proceed while the assets stream in.
+//
+// Loads are deduplicated: loading the same file, or the same material, twice
+// returns the same handle. A material depends on its shader and textures: it
+// becomes ready once they are, and fails if one of them fails.
+//
+// When an UploadThread is given, the buffers and textures are uploaded from
+// its shared context instead of the main thread. Usage example:
+//
+// wvu::AssetManager asset_manager(2);
+// const wvu::TextureHandle brick = asset_manager.LoadTexture("brick.bmp");
+// const wvu::ShaderHandle shader =
+//     asset_manager.LoadShader("shader.vert", "shader.frag");
+// const wvu::MaterialHandle material =
+//     asset_manager.CreateMaterial(shader, {brick});
+// while (...) {  // Rendering loop.
+//   asset_manager.Update();
+//   if (const wvu::Material* bricks = asset_manager.GetMaterial(material)) {
+//     ...  // Draw with it.
+//   }
+// }
+class AssetManager {
+ public:
+  // Params:
+  //   num_threads  The number of workers decoding the assets.
+  explicit AssetManager(const int num_threads);
+  // Waits for the workers and deletes the GPU objects. Main thread only.
+  ~AssetManager();
+
+  // Uploads through the given thread, or on the main thread when nullptr.
+  // The thread is not owned and must outlive the manager. Set it before
+  // loading any asset.
+  void set_upload_thread(UploadThread* upload_thread) {
+    upload_thread_ = upload_thread;
+  }
+
+  // Reads the assets from the archive when it has an entry with the path
+  // given to the Load*() call, and from the file system otherwise. The
+  // archive is not owned and must outlive the manager. Set it before loading
+  // any asset.
+  void set_archive(const PakReader* archive) {
+    archive_ = archive;
+  }
+
+  // Sets the maximum number of GPU uploads per Update() call.
+  void set_max_uploads_per_update(const int max_uploads_per_update) {
+    max_uploads_per_update_ = max_uploads_per_update;
+  }
+
+  // Loads a mesh from an OBJ file, or from a mesh cooked by wvu_cook
+  // (.wvumesh).
+  MeshHandle LoadMesh(const std::string& filepath);
+
+  // Loads an RGB texture from an image file, or from a texture cooked by
+  // wvu_cook (.wvutex). Cooked textures bring their own mipmaps and are
+  // always uploaded on the main thread; BC1 textures are decompressed by the
+  // workers when the GPU lacks S3TC support.
+  TextureHandle LoadTexture(const std::string& filepath);
+
+  // Loads a shader program from vertex and fragment shader files.
+  ShaderHandle LoadShader(const std::string& vertex_shader_filepath,
+                          const std::string& fragment_shader_filepath);
+
+  // Creates a material from assets loaded before.
+  MaterialHandle CreateMaterial(const ShaderHandle& shader,
+                                const std::vector<TextureHandle>& textures);
+
+  // Creates the GPU objects of the decoded assets and resolves the
+  // dependencies of the materials. Main thread only.
+  void Update();
+
+  // Blocks until every asset loaded so far is ready or failed. Main thread
+  // only.
+  void Finish();
+
+  // Returns the state of an asset.
+  template <typename T>
+  AssetState state(const AssetHandle<T>& handle) const {
+    return GetState(handle.id);
+  }
+
+  // Return the asset, or nullptr while it is not ready.
+  const Mesh* GetMesh(const MeshHandle& handle) const;
+  const Texture* GetTexture(const TextureHandle& handle) const;
+  const ShaderProgram* GetShader(const ShaderHandle& handle) const;
+  const Material* GetMaterial(const MaterialHandle& handle) const;
+
+  // Returns the texture id, or zero while the texture is not ready.
+  GLuint GetTextureId(const TextureHandle& handle) const;
+
+  // Returns the error message of a failed asset.
+  template <typename T>
+  const std::string& error(const AssetHandle<T>& handle) const {
+    return records_[handle.id]->error;
+  }
+
+  // Returns the number of assets, i.e., of distinct loads.
+  int num_assets() const {
+    return records_.size();
+  }
+
+ private:
+  enum AssetType {
+    MESH = 0,
+    TEXTURE = 1,
+    SHADER = 2,
+    MATERIAL = 3
+  };
+
+  // Everything the manager keeps about an asset. The workers only write the
+  // decoded fields of the record they were given.
+  struct AssetRecord {
+    AssetType type;
+    AssetState state;
+    std::string error;
+    // Assets that must be ready before this one.
+    std::vector<int> dependencies;
+    // Decoded data, released after the upload.
+    Eigen::MatrixXf vertices;
+    std::vector<GLuint> indices;
+    std::vector<GLubyte> rgb_pixels;
+    // Mipmap chain of a cooked texture, in RGB8 or BC1 blocks.
+    std::vector<MipLevel> mip_levels;
+    bool mip_levels_compressed;
+    std::string vertex_shader_src;
+    std::string fragment_shader_src;
+    bool decoded_successfully;
+    // Id of the pending request on the upload thread, or -1.
+    int upload_request_id;
+    // The asset.
+    Mesh mesh;
+    Texture texture;
+    std::unique_ptr<ShaderProgram> shader_program;
+    Material material;
+  };
+
+  // Returns the id of the asset with the given key, creating the record and
+  // scheduling its decoding when it does not exist yet.
+  int FindOrCreate(const AssetType type,
+                   const std::string& key,
+                   const std::vector<std::string>& filepaths);
+  // Reads and decodes the files of a record. Runs on the workers.
+  static void Decode(const PakReader* archive,
+                     const std::vector<std::string>& filepaths,
+                     AssetRecord* record);
+  // Creates the GPU objects of a decoded record, or hands them to the upload
+  // thread. Returns false while the upload thread has them.
+  bool Upload(const int id);
+  // Receives the resources of the upload thread.
+  void ReceiveUploads();
+  // Returns the state of an asset or FAILED for invalid ids.
+  AssetState GetState(const int id) const;
+
+  std::vector<std::unique_ptr<AssetRecord> > records_;
+  std::unordered_map<std::string, int> ids_by_key_;
+  // Records decoded by the workers and not seen by Update() yet, guarded by
+  // mutex_.
+  std::mutex mutex_;
+  std::vector<int> decoded_ids_;
+  // Records decoded and waiting for their upload or their dependencies, in
+  // the order they were decoded.
+  std::vector<int> pending_ids_;
+  // Asset ids of the requests sent to the upload thread.
+  std::unordered_map<int, int> asset_ids_by_upload_request_;
+  int num_loading_;
+  UploadThread* upload_thread_;
+  const PakReader* archive_;
+  int max_uploads_per_update_;
+  // Declared last so that it is destroyed first: the workers finish before
+  // the records go away.
+  ThreadPool thread_pool_;
+};
+
+}  // namespace wvu
+
+#endif  // ASSET_MANAGER_H_
@@ -36,8 +36,15 @@
 
 // C++ headers.
 #include <algorithm>  // For std::reverse.
+#include <atomic>  // For std::atomic.
+#include <cstdio>  // For std::remove.
+#include <cstring>  // For std::memcpy.
+#include <functional>  // For std::function.
+#include <memory>  // For std::unique_ptr.
 #include <numeric>  // For std::accumulate.
 #include <random>  // For random operations.
+#include <sstream>  // For std::ostringstream.
+#include <thread>  // For std::thread.
 #include <unordered_set>
 #include <vector>
 
@@ -47,7 +54,36 @@
 #include "glog/logging.h"
 #include "gtest/gtest.h"
 
+#include "animation.h"
+#include "asset_corpus.h"
+#include "asset_manager.h"
+#include "benchmark.h"
+#include "camera_utils.h"
+#include "cooked_assets.h"
+#include "debug_draw.h"
+#include "deferred_renderer.h"
+#include "frustum.h"
+#include "gl_trace.h"
+#include "headless_gl.h"
+#include "impostor.h"
+#include "lz_codec.h"
+#include "mesh_optimizer.h"
+#include "pak_archive.h"
+#include "particle_system.h"
+#include "perf_gate.h"
+#include "scene_file.h"
+#include "shadow_maps.h"
+#include "simd_math.h"
+#include "skinning.h"
+#include "spsc_queue.h"
+#include "static_batching.h"
+#include "stress_scene.h"
+#include "texture_compression.h"
+#include "thread_pool.h"
+#include "transparency_pass.h"
 #include "transformations.h"
+#include "vertex_pulling.h"
+#include "wireframe.h"
 #include "model.h"
 
 #define GLEW_STATIC
@@ -90,50 +126,28 @@ const std::string fragment_shader_src =
     "color = vec4(1.0f, 0.5f, 0.2f, 1.0f);\n"
     "}\n";
 
+// The OpenGL tests run in a headless context, so that they run on machines
+// without a display.
 struct ModelTest : public ::testing::Test {
   static void SetUpTestCase() {
-    // Initialize the GLFW library.
-    if (!glfwInit()) {
-      LOG(FATAL) << "GLFW did not initialize correctly";
-    }
-    // Sets properties of windows and have to be set before creation.
-    // GLFW_CONTEXT_VERSION_{MAJOR|MINOR} sets the minimum OpenGL API version
-    // that this program will use.
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 2);
-    // Sets the OpenGL profile.
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
-    // Sets the property of resizability of a window.
-    glfwWindowHint(GLFW_RESIZABLE, GL_FALSE);
-    glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
-    // Create a window and its OpenGL context.
-    const std::string window_name = "Hello Triangle";
-    window = glfwCreateWindow(480,
-                              640,
-                              window_name.c_str(),
-                              nullptr,
-                              nullptr);
-    glfwMakeContextCurrent(window);
-    // Initialize GLEW.
-    glewExperimental = GL_TRUE;
-    if (glewInit() != GLEW_OK) {
-      glfwTerminate();
-      LOG(FATAL) << "Glew did not initialize properly!";
+    context = new HeadlessGlContext;
+    std::string error_info_log;
+    if (!context->Initialize(&error_info_log)) {
+      LOG(FATAL) << error_info_log;
     }
+    LOG(INFO) << "OpenGL context: "
+              << GetGlContextBackendName(context->backend());
   }
 
   static void TearDownTestCase() {
-    // Destroy window.
-    glfwDestroyWindow(window);
-    // Tear down GLFW library.
-    glfwTerminate();
+    delete context;
+    context = nullptr;
   }
 
-  static GLFWwindow* window;
+  static HeadlessGlContext* context;
 };
 
-GLFWwindow* ModelTest::window = nullptr;
+HeadlessGlContext* ModelTest::context = nullptr;
 
 }  // namespace
 
@@ -243,4 +257,1862 @@ TEST_F(ModelTest, VerifyNonZeroVaoVboAndEboIds) {
   EXPECT_GT(model.element_buffer_object_id(), 0);
 }
 
+TEST(DeferredRendererTest, BinLightsIntoTiles) {
+  const int width = 64;
+  const int height = 48;
+  const int tile_size = 16;
+  const Eigen::Matrix4f projection =
+      ComputePerspectiveProjectionMatrix(M_PI / 4.0f, 4.0f / 3.0f,
+                                         0.1f, 20.0f);
+  const Eigen::Matrix4f view = Eigen::Matrix4f::Identity();
+  std::vector<PointLight> lights(3);
+  // A small light in front of the camera, at the center of the window.
+  lights[0] = {Eigen::Vector3f(0.0f, 0.0f, -10.0f),
+               Eigen::Vector3f::Ones(), 0.1f};
+  // A light behind the camera.
+  lights[1] = {Eigen::Vector3f(0.0f, 0.0f, 10.0f),
+               Eigen::Vector3f::Ones(), 1.0f};
+  // A light containing the camera.
+  lights[2] = {Eigen::Vector3f::Zero(), Eigen::Vector3f::Ones(), 1.0f};
+  std::vector<GLint> tile_ranges;
+  std::vector<GLint> light_indices;
+  BinLightsIntoTiles(lights, view, projection, width, height, tile_size,
+                     &tile_ranges, &light_indices);
+  const int num_tiles = (width / tile_size) * (height / tile_size);
+  ASSERT_EQ(tile_ranges.size(), 2 * num_tiles);
+  for (int tile = 0; tile < num_tiles; ++tile) {
+    const GLint offset = tile_ranges[2 * tile];
+    const GLint count = tile_ranges[2 * tile + 1];
+    // The light containing the camera covers every tile.
+    ASSERT_GE(count, 1);
+    bool has_camera_light = false;
+    for (int i = offset; i < offset + count; ++i) {
+      EXPECT_NE(light_indices[i], 1);
+      has_camera_light |= light_indices[i] == 2;
+    }
+    EXPECT_TRUE(has_camera_light);
+  }
+  // The small light only touches the tiles around the window center.
+  const int center_tile = (height / 2 / tile_size) * (width / tile_size) +
+      width / 2 / tile_size;
+  EXPECT_EQ(tile_ranges[2 * center_tile + 1], 2);
+  EXPECT_EQ(tile_ranges[1], 1);
+}
+
+TEST(ShadowMapsTest, CascadeSplits) {
+  const float near_plane = 0.1f;
+  const float far_plane = 100.0f;
+  const int num_cascades = 4;
+  // Uniform splits.
+  const std::vector<GLfloat> uniform_splits =
+      ComputeCascadeSplits(near_plane, far_plane, num_cascades, 0.0f);
+  ASSERT_EQ(uniform_splits.size(), num_cascades);
+  for (int i = 0; i < num_cascades; ++i) {
+    EXPECT_NEAR(uniform_splits[i],
+                near_plane + (i + 1) * (far_plane - near_plane) / num_cascades,
+                1e-3);
+  }
+  // Logarithmic splits keep a constant ratio between consecutive splits.
+  const std::vector<GLfloat> logarithmic_splits =
+      ComputeCascadeSplits(near_plane, far_plane, num_cascades, 1.0f);
+  const float ratio = logarithmic_splits[1] / logarithmic_splits[0];
+  EXPECT_NEAR(logarithmic_splits[2] / logarithmic_splits[1], ratio, 1e-3);
+  EXPECT_NEAR(logarithmic_splits[3] / logarithmic_splits[2], ratio, 1e-3);
+  // Practical splits are increasing and end at the far plane.
+  const std::vector<GLfloat> splits =
+      ComputeCascadeSplits(near_plane, far_plane, num_cascades, 0.75f);
+  for (int i = 1; i < num_cascades; ++i) {
+    EXPECT_GT(splits[i], splits[i - 1]);
+  }
+  EXPECT_EQ(splits.back(), far_plane);
+}
+
+TEST(FrustumTest, SphereVisibility) {
+  const float field_of_view = ConvertDegreesToRadians(90.0f);
+  const Eigen::Matrix4f projection =
+      ComputePerspectiveProjectionMatrix(field_of_view, 1.0f, 0.1f, 10.0f);
+  Eigen::Vector4f planes[kNumFrustumPlanes];
+  ExtractFrustumPlanes(projection, planes);
+  // The normals are unit vectors.
+  for (int i = 0; i < kNumFrustumPlanes; ++i) {
+    EXPECT_NEAR(planes[i].head<3>().norm(), 1.0f, 1e-5);
+  }
+  // In front of the camera.
+  EXPECT_TRUE(IsSphereInFrustum(planes, Eigen::Vector3f(0, 0, -5), 0.5f));
+  // Behind the camera and beyond the far plane.
+  EXPECT_FALSE(IsSphereInFrustum(planes, Eigen::Vector3f(0, 0, 5), 0.5f));
+  EXPECT_FALSE(IsSphereInFrustum(planes, Eigen::Vector3f(0, 0, -12), 0.5f));
+  // Outside the left plane, and crossing it.
+  EXPECT_FALSE(IsSphereInFrustum(planes, Eigen::Vector3f(-8, 0, -5), 0.5f));
+  EXPECT_TRUE(IsSphereInFrustum(planes, Eigen::Vector3f(-5.2f, 0, -5), 0.5f));
+}
+
+TEST(ParticleSystemTest, AccumulateEmission) {
+  GLfloat accumulator = 0.0f;
+  // 10 particles per second at 60 Hz: one particle every sixth frame.
+  int num_particles = 0;
+  for (int i = 0; i < 60; ++i) {
+    const int num_new_particles =
+        AccumulateEmission(10.0f, 1.0f / 60.0f, &accumulator);
+    EXPECT_LE(num_new_particles, 1);
+    num_particles += num_new_particles;
+  }
+  EXPECT_GE(num_particles, 9);
+  EXPECT_LE(num_particles, 10);
+  EXPECT_GE(accumulator, 0.0f);
+  EXPECT_LT(accumulator, 1.0f);
+  // Large steps emit many particles at once.
+  accumulator = 0.0f;
+  EXPECT_EQ(AccumulateEmission(1000.0f, 0.5f, &accumulator), 500);
+  EXPECT_EQ(AccumulateEmission(1000.0f, -1.0f, &accumulator), 0);
+}
+
+TEST_F(ModelTest, ParticleSystemEmitsUpdatesAndDraws) {
+  // The particles need compute shaders, which not every headless context
+  // has.
+  if (!ParticleSystem::IsSupported()) return;
+  std::string error_info_log;
+  OffscreenFramebuffer framebuffer;
+  ASSERT_TRUE(framebuffer.Initialize(32, 32, &error_info_log))
+      << error_info_log;
+  ParticleSystem particles;
+  ASSERT_TRUE(particles.Initialize(64, &error_info_log)) << error_info_log;
+  // Motionless red particles at the origin, whose billboards cover the
+  // center half of the framebuffer (the matrices are the identity).
+  ParticleEmitter emitter;
+  emitter.position.setZero();
+  emitter.position_spread = 0.0f;
+  emitter.velocity.setZero();
+  emitter.velocity_spread = 0.0f;
+  emitter.color = Eigen::Vector4f(1.0f, 0.0f, 0.0f, 1.0f);
+  emitter.min_lifetime = 10.0f;
+  emitter.max_lifetime = 10.0f;
+  emitter.size = 1.0f;
+  emitter.emission_rate = 1000.0f;
+  particles.set_emitter(emitter);
+  particles.set_gravity(Eigen::Vector3f::Zero());
+
+  std::vector<uint8_t> rgba_pixels;
+  const auto draw_particles = [&] {
+    framebuffer.Bind();
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    particles.Draw(Eigen::Matrix4f::Identity(), Eigen::Matrix4f::Identity());
+    framebuffer.Unbind();
+    framebuffer.ReadPixels(&rgba_pixels);
+  };
+  // Ten particles are emitted, and they add up to a saturated red.
+  particles.Update(0.01f);
+  draw_particles();
+  ASSERT_EQ(rgba_pixels.size(), 4 * 32 * 32);
+  EXPECT_EQ(glGetError(), GL_NO_ERROR);
+  const uint8_t* center = &rgba_pixels[4 * (16 * 32 + 16)];
+  EXPECT_EQ(center[0], 255);
+  EXPECT_EQ(center[1], 0);
+  const uint8_t* corner = &rgba_pixels[4 * (2 * 32 + 2)];
+  EXPECT_EQ(corner[0], 0);
+  // The particles die once their lifetime is over, and nothing is drawn.
+  emitter.emission_rate = 0.0f;
+  particles.set_emitter(emitter);
+  particles.Update(20.0f);
+  draw_particles();
+  EXPECT_EQ(glGetError(), GL_NO_ERROR);
+  EXPECT_EQ(rgba_pixels[4 * (16 * 32 + 16)], 0);
+}
+
+TEST(TransparencyPassTest, TransparencyWeight) {
+  // Closer fragments weigh more than farther ones.
+  EXPECT_GT(ComputeTransparencyWeight(0.2f, 0.5f),
+            ComputeTransparencyWeight(0.8f, 0.5f));
+  // More opaque fragments weigh more than more transparent ones.
+  EXPECT_GT(ComputeTransparencyWeight(0.99f, 0.05f),
+            ComputeTransparencyWeight(0.99f, 0.01f));
+  // The weights are bounded to keep the RGBA16F accumulation finite.
+  for (int i = 0; i <= 10; ++i) {
+    for (int j = 0; j <= 10; ++j) {
+      const GLfloat alpha = 0.1f * j;
+      const GLfloat weight = ComputeTransparencyWeight(0.1f * i, alpha);
+      EXPECT_GE(weight, 0.999f * 1e-2f * alpha);
+      EXPECT_LE(weight, 3e3f);
+    }
+  }
+}
+
+TEST_F(ModelTest, TransparencyPassBlendsOverlappingModels) {
+  // The pass needs per-render-target blend functions.
+  if (!TransparencyPass::IsSupported()) return;
+  std::string error_info_log;
+  OffscreenFramebuffer framebuffer;
+  ASSERT_TRUE(framebuffer.Initialize(32, 16, &error_info_log))
+      << error_info_log;
+  TransparencyPass transparency_pass;
+  ASSERT_TRUE(transparency_pass.Initialize(32, 16, &error_info_log))
+      << error_info_log;
+  transparency_pass.set_default_framebuffer_id(framebuffer.framebuffer_id());
+  // A red and a green texture.
+  GLuint texture_ids[2];
+  glGenTextures(2, texture_ids);
+  const GLubyte colors[2][4] = {{255, 0, 0, 255}, {0, 255, 0, 255}};
+  for (int i = 0; i < 2; ++i) {
+    glBindTexture(GL_TEXTURE_2D, texture_ids[i]);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA,
+                 GL_UNSIGNED_BYTE, colors[i]);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  }
+  glBindTexture(GL_TEXTURE_2D, 0);
+  // Two half-transparent triangles covering the left half of the
+  // framebuffer, in normalized device coordinates.
+  Eigen::MatrixXf vertices = Eigen::MatrixXf::Zero(8, 3);
+  vertices.col(0).head<2>() = Eigen::Vector2f(-1.0f, -1.0f);
+  vertices.col(1).head<2>() = Eigen::Vector2f(0.0f, -1.0f);
+  vertices.col(2).head<2>() = Eigen::Vector2f(-1.0f, 3.0f);
+  const std::vector<GLuint> indices = {0, 1, 2};
+  Model first(Eigen::Vector3f::Zero(), Eigen::Vector3f::Zero(), vertices,
+              indices);
+  Model second(Eigen::Vector3f::Zero(), Eigen::Vector3f::Zero(), vertices,
+               indices);
+  first.set_opacity(0.5f);
+  second.set_opacity(0.5f);
+  first.SetVerticesIntoGpu();
+  second.SetVerticesIntoGpu();
+  Model* models[2] = {&first, &second};
+
+  // The result does not depend on the order of the draws.
+  for (int first_index = 0; first_index < 2; ++first_index) {
+    SCOPED_TRACE(first_index);
+    framebuffer.Bind();
+    glClearColor(0.0f, 0.0f, 1.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    transparency_pass.Begin();
+    for (int i = 0; i < 2; ++i) {
+      const int index = (first_index + i) % 2;
+      transparency_pass.Draw(models[index], Eigen::Matrix4f::Identity(),
+                             Eigen::Matrix4f::Identity(),
+                             texture_ids[index]);
+    }
+    transparency_pass.Composite();
+    std::vector<uint8_t> rgba_pixels;
+    framebuffer.ReadPixels(&rgba_pixels);
+    EXPECT_EQ(glGetError(), GL_NO_ERROR);
+    // The triangles weigh the same, so their average color (0.5, 0.5, 0)
+    // covers the blue background by 1 - 0.5 * 0.5.
+    const uint8_t* left = &rgba_pixels[4 * (8 * 32 + 4)];
+    EXPECT_NEAR(left[0], 96, 2);
+    EXPECT_NEAR(left[1], 96, 2);
+    EXPECT_NEAR(left[2], 64, 2);
+    // The background shows through where nothing is transparent.
+    const uint8_t* right = &rgba_pixels[4 * (8 * 32 + 28)];
+    EXPECT_EQ(right[0], 0);
+    EXPECT_EQ(right[1], 0);
+    EXPECT_EQ(right[2], 255);
+  }
+  glDeleteTextures(2, texture_ids);
+}
+
+TEST(ImpostorTest, HemiOctahedralRoundTrip) {
+  // The grid cell centers decode to unit directions on the upper hemisphere
+  // that encode back to the same point.
+  const int frames_per_side = 8;
+  for (int j = 0; j < frames_per_side; ++j) {
+    for (int i = 0; i < frames_per_side; ++i) {
+      const Eigen::Vector2f coordinates =
+          2.0f * (Eigen::Vector2f(i, j).array() + 0.5f) / frames_per_side -
+          1.0f;
+      const Eigen::Vector3f direction = DecodeHemiOctahedral(coordinates);
+      EXPECT_NEAR(direction.norm(), 1.0f, 1e-5);
+      EXPECT_GE(direction.y(), 0.0f);
+      EXPECT_TRUE(EncodeHemiOctahedral(direction).isApprox(coordinates, 1e-4));
+    }
+  }
+  // The zenith maps to the center and the horizon to the border.
+  EXPECT_TRUE(EncodeHemiOctahedral(Eigen::Vector3f::UnitY())
+                  .isZero(1e-6));
+  EXPECT_NEAR(EncodeHemiOctahedral(Eigen::Vector3f::UnitX())
+                  .cwiseAbs().maxCoeff(), 1.0f, 1e-6);
+  // Directions below the horizon are clamped to it.
+  EXPECT_TRUE(EncodeHemiOctahedral(Eigen::Vector3f(1.0f, -1.0f, 0.0f))
+                  .isApprox(EncodeHemiOctahedral(Eigen::Vector3f::UnitX())));
+}
+
+TEST_F(ModelTest, DrawIntoOffscreenFramebuffer) {
+  ShaderProgram shader_program;
+  shader_program.LoadVertexShaderFromString(vertex_shader_src);
+  shader_program.LoadFragmentShaderFromString(fragment_shader_src);
+  std::string error_info_log;
+  ASSERT_TRUE(shader_program.Create(&error_info_log)) << error_info_log;
+  OffscreenFramebuffer framebuffer;
+  ASSERT_TRUE(framebuffer.Initialize(32, 16, &error_info_log))
+      << error_info_log;
+  // A triangle covering the left half of the framebuffer, in normalized
+  // device coordinates (the shader ignores the matrices).
+  Eigen::MatrixXf vertices = Eigen::MatrixXf::Zero(8, 3);
+  vertices.col(0).head<2>() = Eigen::Vector2f(-1.0f, -1.0f);
+  vertices.col(1).head<2>() = Eigen::Vector2f(0.0f, -1.0f);
+  vertices.col(2).head<2>() = Eigen::Vector2f(-1.0f, 3.0f);
+  const std::vector<GLuint> indices = {0, 1, 2};
+  Model model(Eigen::Vector3f::Zero(), Eigen::Vector3f::Zero(), vertices,
+              indices);
+  model.SetVerticesIntoGpu();
+
+  framebuffer.Bind();
+  glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  shader_program.Use();
+  model.Draw(shader_program, Eigen::Matrix4f::Identity(),
+             Eigen::Matrix4f::Identity(), 0);
+  framebuffer.Unbind();
+  std::vector<uint8_t> rgba_pixels;
+  framebuffer.ReadPixels(&rgba_pixels);
+  ASSERT_EQ(rgba_pixels.size(), 4 * 32 * 16);
+  EXPECT_EQ(glGetError(), GL_NO_ERROR);
+  // The fragment shader color on the left, the clear color on the right.
+  const uint8_t* left = &rgba_pixels[4 * (8 * 32 + 4)];
+  EXPECT_EQ(left[0], 255);
+  EXPECT_NEAR(left[1], 128, 1);
+  EXPECT_NEAR(left[2], 51, 1);
+  const uint8_t* right = &rgba_pixels[4 * (8 * 32 + 28)];
+  EXPECT_EQ(right[0], 0);
+  EXPECT_EQ(right[1], 0);
+  EXPECT_EQ(right[3], 255);
+}
+
+TEST_F(ModelTest, ShadowMapsCacheStaticCasters) {
+  CascadedShadowMaps shadow_maps;
+  std::string error_info_log;
+  ASSERT_TRUE(shadow_maps.Initialize(2, 64, &error_info_log))
+      << error_info_log;
+  Eigen::MatrixXf vertices = Eigen::MatrixXf::Zero(8, 3);
+  vertices.block(0, 0, 3, 3) = Eigen::Matrix3f::Identity();
+  const std::vector<GLuint> indices = {0, 1, 2};
+  const Eigen::Vector3f no_rotation(0.0f, 0.0f, 1e-6f);
+  Model static_caster(no_rotation, Eigen::Vector3f(0.0f, 0.0f, -5.0f),
+                      vertices, indices);
+  Model dynamic_caster(no_rotation, Eigen::Vector3f(1.0f, 0.0f, -5.0f),
+                       vertices, indices);
+  static_caster.SetVerticesIntoGpu();
+  dynamic_caster.SetVerticesIntoGpu();
+  const std::vector<Model*> static_casters = {&static_caster};
+  const std::vector<Model*> dynamic_casters = {&dynamic_caster};
+  // A camera at the origin looking down -z; its look-at is the identity.
+  CameraParameters camera_params;
+  camera_params.field_of_view = M_PI / 4.0f;
+  camera_params.aspect_ratio = 1.0f;
+  camera_params.near_plane_distance = 0.1f;
+  camera_params.far_plane_distance = 20.0f;
+  camera_params.position = Eigen::Vector3f::Zero();
+  camera_params.view_direction = -Eigen::Vector3f::UnitZ();
+  camera_params.up_vector = Eigen::Vector3f::UnitY();
+  const Camera camera(camera_params);
+  shadow_maps.set_light_direction(Eigen::Vector3f(0.0f, -1.0f, -0.5f));
+
+  // The first frame renders every static cascade.
+  shadow_maps.Render(camera, static_casters, dynamic_casters);
+  EXPECT_EQ(shadow_maps.num_static_refreshes(), 2);
+  // Moving only the dynamic casters keeps the cached cascades.
+  for (int i = 0; i < 3; ++i) {
+    dynamic_caster.set_position(Eigen::Vector3f(1.0f + i, 0.0f, -5.0f));
+    shadow_maps.Render(camera, static_casters, dynamic_casters);
+  }
+  EXPECT_EQ(shadow_maps.num_static_refreshes(), 2);
+  // Changing the light re-renders them.
+  shadow_maps.set_light_direction(Eigen::Vector3f(0.5f, -1.0f, 0.0f));
+  shadow_maps.Render(camera, static_casters, dynamic_casters);
+  EXPECT_EQ(shadow_maps.num_static_refreshes(), 4);
+  // So does invalidating the static casters.
+  shadow_maps.MarkStaticCastersDirty();
+  shadow_maps.Render(camera, static_casters, dynamic_casters);
+  EXPECT_EQ(shadow_maps.num_static_refreshes(), 6);
+  EXPECT_EQ(glGetError(), GL_NO_ERROR);
+
+  // The lighting shader, which clamps the lookups to the cascades, compiles.
+  // The lighting pass itself draws into the default framebuffer, which a
+  // headless context does not have.
+  DeferredRenderer renderer;
+  EXPECT_TRUE(renderer.Initialize(16, 16, &error_info_log))
+      << error_info_log;
+}
+
+TEST_F(ModelTest, StaticBatching) {
+  // A triangle with the layout of Model::SetVBO.
+  Eigen::MatrixXf vertices = Eigen::MatrixXf::Zero(8, 3);
+  vertices.block(0, 0, 3, 3) = Eigen::Matrix3f::Identity();
+  const std::vector<GLuint> indices = {0, 1, 2};
+  const Eigen::Vector3f no_rotation(0.0f, 0.0f, 1e-6f);
+  Model first(no_rotation, Eigen::Vector3f(1.0f, 0.0f, 0.0f), vertices,
+              indices);
+  Model second(no_rotation, Eigen::Vector3f(2.0f, 0.0f, 0.0f), vertices,
+               indices);
+  Model other_texture(no_rotation, Eigen::Vector3f::Zero(), vertices, indices);
+  Model far_away(no_rotation, Eigen::Vector3f(100.0f, 0.0f, 0.0f), vertices,
+                 indices);
+  Model dynamic(no_rotation, Eigen::Vector3f::Zero(), vertices, indices);
+  Model transparent(no_rotation, Eigen::Vector3f(1.0f, 0.0f, 0.0f), vertices,
+                    indices);
+  first.set_is_static(true);
+  second.set_is_static(true);
+  other_texture.set_is_static(true);
+  far_away.set_is_static(true);
+  transparent.set_is_static(true);
+  transparent.set_opacity(0.5f);
+  const std::vector<Model*> models = {&first, &second, &other_texture,
+                                      &far_away, &dynamic, &transparent};
+  const std::vector<GLuint> texture_ids = {1, 1, 2, 1, 1, 1};
+  std::vector<StaticBatch> batches;
+  BuildStaticBatches(models, texture_ids, 10.0f, &batches);
+  // The first two models share a batch, and the others get one each except
+  // for the dynamic model and the transparent one, which is left to the
+  // transparency pass.
+  ASSERT_EQ(batches.size(), 3);
+  EXPECT_EQ(batches[0].texture_id, 1);
+  EXPECT_EQ(batches[1].texture_id, 1);
+  EXPECT_EQ(batches[2].texture_id, 2);
+  const StaticBatch& merged =
+      batches[0].vertices.size() > batches[1].vertices.size() ?
+      batches[0] : batches[1];
+  ASSERT_EQ(merged.vertices.size(), 2 * 3 * 8);
+  EXPECT_EQ(merged.indices, std::vector<GLuint>({0, 1, 2, 3, 4, 5}));
+  // The vertices are in world coordinates.
+  EXPECT_NEAR(merged.vertices[0], 2.0f, 1e-5);
+  EXPECT_NEAR(merged.vertices[3 * 8], 3.0f, 1e-5);
+  EXPECT_TRUE(merged.min_corner.isApprox(Eigen::Vector3f(1.0f, 0.0f, 0.0f)));
+  EXPECT_TRUE(merged.max_corner.isApprox(Eigen::Vector3f(3.0f, 1.0f, 1.0f)));
+}
+
+TEST(VertexPullingTest, PackVertices) {
+  EXPECT_EQ(NumWordsPerVertex(VertexFormat::FULL), 8);
+  EXPECT_EQ(NumWordsPerVertex(VertexFormat::COMPACT), 5);
+  // 1.0 and 0.5 are 0x3c00 and 0x3800 as half floats.
+  EXPECT_EQ(PackHalf2x16(1.0f, 0.5f), 0x38003c00u);
+  EXPECT_EQ(PackHalf2x16(-2.0f, 0.0f), 0x0000c000u);
+  EXPECT_EQ(PackHalf2x16(1e6f, 0.0f), 0x00007c00u);
+  EXPECT_EQ(PackUnorm4x8(Eigen::Vector4f(1.0f, 0.0f, 0.5f, 2.0f)),
+            0xff8000ffu);
+
+  Eigen::MatrixXf vertices(8, 2);
+  vertices.col(0) << 1.0f, 2.0f, 3.0f, 1.0f, 0.0f, 0.5f, 0.25f, 0.75f;
+  vertices.col(1) << -1.0f, 0.1f, 7.0f, 0.0f, 1.0f, 1.0f, 1.0f, 0.0f;
+  std::vector<GLuint> words;
+  PackVertices(vertices, VertexFormat::FULL, &words);
+  ASSERT_EQ(words.size(), 16);
+  for (int i = 0; i < words.size(); ++i) {
+    GLfloat value;
+    std::memcpy(&value, &words[i], sizeof(value));
+    EXPECT_EQ(value, vertices(i % 8, i / 8));
+  }
+  words.clear();
+  PackVertices(vertices, VertexFormat::COMPACT, &words);
+  ASSERT_EQ(words.size(), 10);
+  GLfloat position_y;
+  std::memcpy(&position_y, &words[6], sizeof(position_y));
+  EXPECT_EQ(position_y, 0.1f);
+  EXPECT_EQ(words[3], PackUnorm4x8(Eigen::Vector4f(1.0f, 0.0f, 0.5f, 1.0f)));
+  EXPECT_EQ(words[4], PackHalf2x16(0.25f, 0.75f));
+}
+
+TEST_F(ModelTest, VertexPullingRendererDrawsBothFormats) {
+  // The vertices are fetched from storage buffers.
+  if (!VertexPullingRenderer::IsSupported()) return;
+  std::string error_info_log;
+  OffscreenFramebuffer framebuffer;
+  ASSERT_TRUE(framebuffer.Initialize(32, 16, &error_info_log))
+      << error_info_log;
+  VertexPullingRenderer renderer;
+  ASSERT_TRUE(renderer.Initialize(&error_info_log)) << error_info_log;
+  // A texture whose left texel is red and right texel is green.
+  GLuint texture_id;
+  glGenTextures(1, &texture_id);
+  glBindTexture(GL_TEXTURE_2D, texture_id);
+  const GLubyte texels[] = {255, 0, 0, 255, 0, 255, 0, 255};
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 2, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+               texels);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  // A triangle covering the left half of the framebuffer, in normalized
+  // device coordinates, textured with the red texel. The compact copy is
+  // indexed, textured with the green texel, and moved onto the right half.
+  Eigen::MatrixXf vertices = Eigen::MatrixXf::Zero(8, 3);
+  vertices.col(0).head<2>() = Eigen::Vector2f(-1.0f, -1.0f);
+  vertices.col(1).head<2>() = Eigen::Vector2f(0.0f, -1.0f);
+  vertices.col(2).head<2>() = Eigen::Vector2f(-1.0f, 3.0f);
+  vertices.bottomRows<2>().colwise() = Eigen::Vector2f(0.25f, 0.5f);
+  const int full_mesh = renderer.AddMesh(vertices, {}, VertexFormat::FULL);
+  vertices.bottomRows<2>().colwise() = Eigen::Vector2f(0.75f, 0.5f);
+  const int compact_mesh =
+      renderer.AddMesh(vertices, {0, 1, 2}, VertexFormat::COMPACT);
+  Eigen::Matrix4f right_half = Eigen::Matrix4f::Identity();
+  right_half(0, 3) = 1.0f;
+
+  framebuffer.Bind();
+  glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  renderer.Begin(Eigen::Matrix4f::Identity(), Eigen::Matrix4f::Identity());
+  renderer.Draw(full_mesh, Eigen::Matrix4f::Identity(), texture_id);
+  renderer.Draw(compact_mesh, right_half, texture_id);
+  renderer.End();
+  framebuffer.Unbind();
+  std::vector<uint8_t> rgba_pixels;
+  framebuffer.ReadPixels(&rgba_pixels);
+  EXPECT_EQ(glGetError(), GL_NO_ERROR);
+  const uint8_t* left = &rgba_pixels[4 * (8 * 32 + 4)];
+  EXPECT_EQ(left[0], 255);
+  EXPECT_EQ(left[1], 0);
+  const uint8_t* right = &rgba_pixels[4 * (8 * 32 + 20)];
+  EXPECT_EQ(right[0], 0);
+  EXPECT_EQ(right[1], 255);
+  glDeleteTextures(1, &texture_id);
+}
+
+TEST(WireframeTest, EdgeDistances) {
+  // Right triangle with legs 4 and 3: the hypotenuse is 5 pixels long.
+  const Eigen::Vector3f distances = ComputeEdgeDistances(
+      Eigen::Vector2f(0.0f, 0.0f), Eigen::Vector2f(4.0f, 0.0f),
+      Eigen::Vector2f(0.0f, 3.0f));
+  EXPECT_NEAR(distances[0], 2.4f, 1e-5f);
+  EXPECT_NEAR(distances[1], 4.0f, 1e-5f);
+  EXPECT_NEAR(distances[2], 3.0f, 1e-5f);
+  // The winding does not matter.
+  const Eigen::Vector3f flipped_distances = ComputeEdgeDistances(
+      Eigen::Vector2f(0.0f, 0.0f), Eigen::Vector2f(0.0f, 3.0f),
+      Eigen::Vector2f(4.0f, 0.0f));
+  EXPECT_NEAR(flipped_distances[0], 2.4f, 1e-5f);
+  EXPECT_NEAR(flipped_distances[1], 3.0f, 1e-5f);
+  EXPECT_NEAR(flipped_distances[2], 4.0f, 1e-5f);
+  // Degenerate triangles do not produce infinities.
+  const Eigen::Vector3f degenerate_distances = ComputeEdgeDistances(
+      Eigen::Vector2f(1.0f, 1.0f), Eigen::Vector2f(1.0f, 1.0f),
+      Eigen::Vector2f(1.0f, 1.0f));
+  EXPECT_TRUE(degenerate_distances.allFinite());
+}
+
+TEST_F(ModelTest, WireframeShaderDrawsTheEdges) {
+  std::string error_info_log;
+  OffscreenFramebuffer framebuffer;
+  ASSERT_TRUE(framebuffer.Initialize(32, 32, &error_info_log))
+      << error_info_log;
+  WireframeShader wireframe_shader;
+  ASSERT_TRUE(wireframe_shader.Initialize(32, 32, &error_info_log))
+      << error_info_log;
+  wireframe_shader.set_line_color(Eigen::Vector3f(1.0f, 0.0f, 0.0f));
+  wireframe_shader.set_line_width(2.0f);
+  // A white texture.
+  GLuint texture_id;
+  glGenTextures(1, &texture_id);
+  glBindTexture(GL_TEXTURE_2D, texture_id);
+  const GLubyte white[] = {255, 255, 255, 255};
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+               white);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  // A triangle with the corners (4, 4), (28, 4) and (4, 28) in window
+  // coordinates.
+  Eigen::MatrixXf vertices = Eigen::MatrixXf::Zero(8, 3);
+  vertices.col(0).head<2>() = Eigen::Vector2f(-0.75f, -0.75f);
+  vertices.col(1).head<2>() = Eigen::Vector2f(0.75f, -0.75f);
+  vertices.col(2).head<2>() = Eigen::Vector2f(-0.75f, 0.75f);
+  const std::vector<GLuint> indices = {0, 1, 2};
+  Model model(Eigen::Vector3f::Zero(), Eigen::Vector3f::Zero(), vertices,
+              indices);
+  model.SetVerticesIntoGpu();
+
+  for (const bool fill : {true, false}) {
+    SCOPED_TRACE(fill);
+    wireframe_shader.set_fill(fill);
+    framebuffer.Bind();
+    glClearColor(0.0f, 0.0f, 1.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    wireframe_shader.Use();
+    model.Draw(wireframe_shader.shader_program(), Eigen::Matrix4f::Identity(),
+               Eigen::Matrix4f::Identity(), texture_id);
+    framebuffer.Unbind();
+    std::vector<uint8_t> rgba_pixels;
+    framebuffer.ReadPixels(&rgba_pixels);
+    EXPECT_EQ(glGetError(), GL_NO_ERROR);
+    // Half a pixel away from the bottom edge: mostly the line color.
+    const uint8_t* edge = &rgba_pixels[4 * (4 * 32 + 10)];
+    EXPECT_EQ(edge[0], 255);
+    EXPECT_LT(edge[1], 128);
+    EXPECT_LT(edge[2], 128);
+    // More than six pixels away from every edge: the texture, or the clear
+    // color when the triangles are not filled.
+    const uint8_t* interior = &rgba_pixels[4 * (10 * 32 + 10)];
+    EXPECT_EQ(interior[0], fill ? 255 : 0);
+    EXPECT_EQ(interior[1], fill ? 255 : 0);
+    EXPECT_EQ(interior[2], 255);
+  }
+  glDeleteTextures(1, &texture_id);
+}
+
+#if WVU_DEBUG_DRAW
+TEST(DebugDrawTest, AccumulatesLines) {
+  DebugDraw debug_draw;
+  const Eigen::Vector3f color(1.0f, 0.0f, 0.0f);
+  debug_draw.Line(Eigen::Vector3f::Zero(), Eigen::Vector3f::Ones(), color);
+  EXPECT_EQ(debug_draw.num_vertices(), 2);
+  // A box has 12 edges.
+  debug_draw.Box(Eigen::Vector3f::Zero(), Eigen::Vector3f::Ones(), color);
+  EXPECT_EQ(debug_draw.num_vertices(), 2 + 24);
+  // The frustum of the identity matrix is the NDC cube.
+  debug_draw.Frustum(Eigen::Matrix4f::Identity(), color, false);
+  EXPECT_EQ(debug_draw.num_vertices(), 2 + 2 * 24);
+  debug_draw.Axes(Eigen::Matrix4f::Identity(), 1.0f);
+  EXPECT_EQ(debug_draw.num_vertices(), 2 + 2 * 24 + 6);
+  debug_draw.Sphere(Eigen::Vector3f::Zero(), 1.0f, color);
+  EXPECT_GT(debug_draw.num_vertices(), 2 + 2 * 24 + 6);
+}
+#endif  // WVU_DEBUG_DRAW
+
+TEST(SpscQueueTest, PushAndPopAcrossThreads) {
+  SpscQueue<int> queue(5);
+  // The capacity is rounded up to a power of two.
+  ASSERT_EQ(queue.capacity(), 8);
+  EXPECT_EQ(queue.Front(), nullptr);
+  for (int i = 0; i < queue.capacity(); ++i) {
+    EXPECT_TRUE(queue.Push(i));
+  }
+  EXPECT_FALSE(queue.Push(8));
+  EXPECT_EQ(*queue.Front(), 0);
+  queue.Pop();
+  EXPECT_TRUE(queue.Push(8));
+  for (int i = 1; i <= 8; ++i) {
+    ASSERT_NE(queue.Front(), nullptr);
+    EXPECT_EQ(*queue.Front(), i);
+    queue.Pop();
+  }
+  EXPECT_EQ(queue.Front(), nullptr);
+
+  // The values arrive in order when a producer thread fills the queue.
+  constexpr int kNumValues = 100000;
+  std::thread producer([&queue] {
+    for (int i = 0; i < kNumValues; ++i) {
+      while (!queue.Push(i)) std::this_thread::yield();
+    }
+  });
+  int expected_value = 0;
+  while (expected_value < kNumValues) {
+    int* value = queue.Front();
+    if (value == nullptr) {
+      std::this_thread::yield();
+      continue;
+    }
+    EXPECT_EQ(*value, expected_value);
+    queue.Pop();
+    ++expected_value;
+  }
+  producer.join();
+}
+
+TEST(ThreadPoolTest, RunsAllTasks) {
+  ThreadPool thread_pool(4);
+  EXPECT_EQ(thread_pool.num_threads(), 4);
+  std::atomic<int> sum(0);
+  for (int i = 1; i <= 1000; ++i) {
+    thread_pool.Schedule([&sum, i] { sum += i; });
+  }
+  thread_pool.Wait();
+  EXPECT_EQ(sum, 500500);
+}
+
+TEST(MeshOptimizerTest, ConvertObjToMesh) {
+  // A quad made of two triangles sharing the (vertex, texel) pairs of the
+  // diagonal.
+  const std::vector<Eigen::Vector3f> obj_vertices = {
+    Eigen::Vector3f(0, 0, 0), Eigen::Vector3f(1, 0, 0),
+    Eigen::Vector3f(1, 1, 0), Eigen::Vector3f(0, 1, 0)};
+  // The vector of Eigen::Vector2f is specialized (see model_loader.h) and
+  // has no initializer list constructor.
+  std::vector<Eigen::Vector2f> obj_texels;
+  obj_texels.push_back(Eigen::Vector2f(0, 0));
+  obj_texels.push_back(Eigen::Vector2f(1, 0));
+  obj_texels.push_back(Eigen::Vector2f(1, 1));
+  obj_texels.push_back(Eigen::Vector2f(0, 1));
+  const std::vector<Eigen::Vector3f> obj_normals = {Eigen::Vector3f(0, 0, 1)};
+  std::vector<Face> faces(2);
+  faces[0].vertex_indices = {0, 1, 2};
+  faces[0].texel_indices = {0, 1, 2};
+  faces[0].normal_indices = {0, 0, 0};
+  faces[1].vertex_indices = {0, 2, 3};
+  faces[1].texel_indices = {0, 2, 3};
+  faces[1].normal_indices = {0, 0, 0};
+  Eigen::MatrixXf vertices;
+  std::vector<GLuint> indices;
+  ConvertObjToMesh(obj_vertices, obj_texels, obj_normals, faces, &vertices,
+                   &indices);
+  ASSERT_EQ(vertices.rows(), 8);
+  EXPECT_EQ(vertices.cols(), 4);
+  EXPECT_EQ(indices, std::vector<GLuint>({0, 1, 2, 0, 2, 3}));
+  // Position, color from the normal, and texel of the last vertex.
+  Eigen::VectorXf expected_vertex(8);
+  expected_vertex << 0, 1, 0, 0.5f, 0.5f, 1, 0, 1;
+  EXPECT_TRUE(vertices.col(3).isApprox(expected_vertex));
+}
+
+TEST(AssetManagerTest, DeduplicatesAndPropagatesFailures) {
+  AssetManager asset_manager(2);
+  const TextureHandle texture =
+      asset_manager.LoadTexture("/nonexistent/texture.bmp");
+  EXPECT_EQ(asset_manager.LoadTexture("/nonexistent/texture.bmp"), texture);
+  const MeshHandle mesh = asset_manager.LoadMesh("/nonexistent/mesh.obj");
+  const ShaderHandle shader = asset_manager.LoadShader(
+      "/nonexistent/shader.vert", "/nonexistent/shader.frag");
+  const MaterialHandle material =
+      asset_manager.CreateMaterial(shader, {texture});
+  EXPECT_EQ(asset_manager.CreateMaterial(shader, {texture}), material);
+  EXPECT_EQ(asset_manager.num_assets(), 4);
+  EXPECT_EQ(asset_manager.GetMaterial(material), nullptr);
+
+  asset_manager.Finish();
+  EXPECT_EQ(asset_manager.state(texture), AssetState::FAILED);
+  EXPECT_EQ(asset_manager.state(mesh), AssetState::FAILED);
+  EXPECT_EQ(asset_manager.state(shader), AssetState::FAILED);
+  // The material fails with its dependencies.
+  EXPECT_EQ(asset_manager.state(material), AssetState::FAILED);
+  EXPECT_FALSE(asset_manager.error(material).empty());
+  EXPECT_EQ(asset_manager.GetTextureId(texture), 0);
+  EXPECT_EQ(asset_manager.GetMesh(mesh), nullptr);
+  EXPECT_EQ(asset_manager.state(MeshHandle()), AssetState::FAILED);
+}
+
+TEST(MeshOptimizerTest, OptimizationsPreserveTheTriangles) {
+  // A grid of quads whose triangles are shuffled, plus a duplicate of every
+  // vertex of the first row used by the last triangle.
+  const int kGridSize = 16;
+  Eigen::MatrixXf vertices(8, (kGridSize + 1) * (kGridSize + 1));
+  for (int y = 0; y <= kGridSize; ++y) {
+    for (int x = 0; x <= kGridSize; ++x) {
+      vertices.col(y * (kGridSize + 1) + x) << x, y, 0, 1, 1, 1, x, y;
+    }
+  }
+  std::vector<std::vector<GLuint> > triangles;
+  for (int y = 0; y < kGridSize; ++y) {
+    for (int x = 0; x < kGridSize; ++x) {
+      const GLuint corner = y * (kGridSize + 1) + x;
+      triangles.push_back({corner, corner + 1, corner + kGridSize + 2});
+      triangles.push_back({corner, corner + kGridSize + 2,
+                           corner + kGridSize + 1});
+    }
+  }
+  std::mt19937 random_engine(7);
+  std::shuffle(triangles.begin(), triangles.end(), random_engine);
+  const int num_grid_vertices = vertices.cols();
+  vertices.conservativeResize(8, num_grid_vertices + 3);
+  for (int i = 0; i < 3; ++i) {
+    vertices.col(num_grid_vertices + i) = vertices.col(triangles.back()[i]);
+    triangles.back()[i] = num_grid_vertices + i;
+  }
+  std::vector<GLuint> indices;
+  for (const std::vector<GLuint>& triangle : triangles) {
+    indices.insert(indices.end(), triangle.begin(), triangle.end());
+  }
+
+  // Triangles as positions, rotated to start at the smallest vertex so that
+  // the comparison ignores the order but not the winding.
+  const auto sorted_triangles = [](const Eigen::MatrixXf& vertices,
+                                   const std::vector<GLuint>& indices) {
+    std::vector<std::vector<float> > triangles;
+    for (int i = 0; i < indices.size(); i += 3) {
+      std::vector<std::vector<float> > corners;
+      for (int j = 0; j < 3; ++j) {
+        const Eigen::VectorXf vertex = vertices.col(indices[i + j]);
+        corners.push_back(std::vector<float>(vertex.data(),
+                                             vertex.data() + 8));
+      }
+      std::rotate(corners.begin(),
+                  std::min_element(corners.begin(), corners.end()),
+                  corners.end());
+      triangles.push_back(corners[0]);
+      triangles.back().insert(triangles.back().end(), corners[1].begin(),
+                              corners[1].end());
+      triangles.back().insert(triangles.back().end(), corners[2].begin(),
+                              corners[2].end());
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+  };
+  const auto expected_triangles = sorted_triangles(vertices, indices);
+  const float initial_acmr = ComputeAcmr(indices, 16);
+
+  WeldVertices(&vertices, &indices);
+  EXPECT_EQ(vertices.cols(), num_grid_vertices);
+  OptimizeVertexCache(vertices.cols(), 16, &indices);
+  OptimizeVertexFetch(&vertices, &indices);
+  EXPECT_EQ(vertices.cols(), num_grid_vertices);
+  EXPECT_EQ(sorted_triangles(vertices, indices), expected_triangles);
+  // The shuffled grid is close to the worst case; Tipsify gets below one
+  // vertex per triangle.
+  EXPECT_LT(ComputeAcmr(indices, 16), 1.0f);
+  EXPECT_LT(ComputeAcmr(indices, 16), initial_acmr);
+  // The vertices are fetched in order.
+  GLuint max_index = 0;
+  for (const GLuint index : indices) {
+    EXPECT_LE(index, max_index + 1);
+    max_index = std::max(max_index, index);
+  }
+}
+
+TEST(TextureCompressionTest, Bc1RoundTrip) {
+  // A ramp, whose colors lie on a line as BC1 assumes, in an image whose
+  // size is not a multiple of the block size.
+  const int kWidth = 10;
+  const int kHeight = 6;
+  std::vector<uint8_t> rgb_pixels(3 * kWidth * kHeight);
+  for (int y = 0; y < kHeight; ++y) {
+    for (int x = 0; x < kWidth; ++x) {
+      uint8_t* pixel = &rgb_pixels[3 * (y * kWidth + x)];
+      pixel[0] = 12 * (x + y);
+      pixel[1] = 255 - 12 * (x + y);
+      pixel[2] = 128;
+    }
+  }
+  std::vector<MipLevel> levels;
+  GenerateMipmaps(kWidth, kHeight, rgb_pixels, &levels);
+  ASSERT_EQ(levels.size(), 4);
+  EXPECT_EQ(levels[1].width, 5);
+  EXPECT_EQ(levels[1].height, 3);
+  EXPECT_EQ(levels[3].width, 1);
+  EXPECT_EQ(levels[3].height, 1);
+
+  std::vector<uint8_t> blocks;
+  CompressBc1(kWidth, kHeight, rgb_pixels, &blocks);
+  EXPECT_EQ(blocks.size(), 3 * 2 * 8);
+  std::vector<uint8_t> decompressed_pixels;
+  DecompressBc1(kWidth, kHeight, blocks, &decompressed_pixels);
+  ASSERT_EQ(decompressed_pixels.size(), rgb_pixels.size());
+  // Four colors spaced by about 24 along the ramp, plus the RGB565
+  // quantization.
+  int max_error = 0;
+  for (int i = 0; i < rgb_pixels.size(); ++i) {
+    max_error = std::max(max_error, std::abs(decompressed_pixels[i] -
+                                             rgb_pixels[i]));
+  }
+  EXPECT_LE(max_error, 16);
+}
+
+TEST(CookedAssetsTest, MeshAndManifestRoundTrip) {
+  Eigen::MatrixXf vertices(8, 3);
+  vertices << -1, 2, 0.5f,
+              0, 1, 3,
+              4, 4, 4,
+              0, 0.5f, 1,
+              1, 0.5f, 0,
+              0.25f, 0.75f, 1,
+              0, 1, 0.5f,
+              0, 0.25f, 1;
+  const std::vector<GLuint> indices = {0, 1, 2, 2, 1, 0};
+  std::string bytes;
+  EncodeCookedMesh(vertices, indices, &bytes);
+  // Header, 16 bytes per vertex, and 16-bit indices.
+  EXPECT_EQ(bytes.size(), 40 + 3 * 16 + 6 * 2);
+  Eigen::MatrixXf decoded_vertices;
+  std::vector<GLuint> decoded_indices;
+  std::string error_info_log;
+  ASSERT_TRUE(DecodeCookedMesh(bytes.data(), bytes.size(), &decoded_vertices,
+                               &decoded_indices, &error_info_log));
+  EXPECT_EQ(decoded_indices, indices);
+  ASSERT_EQ(decoded_vertices.cols(), 3);
+  // 16-bit positions, 8-bit colors, and half float texels.
+  EXPECT_LT((decoded_vertices.topRows<3>() - vertices.topRows<3>())
+            .cwiseAbs().maxCoeff(), 1e-4f);
+  EXPECT_LT((decoded_vertices.middleRows<3>(3) - vertices.middleRows<3>(3))
+            .cwiseAbs().maxCoeff(), 1.0f / 255.0f);
+  EXPECT_TRUE(decoded_vertices.bottomRows<2>().isApprox(
+      vertices.bottomRows<2>()));
+  EXPECT_FALSE(DecodeCookedMesh(bytes.data(), bytes.size() - 1,
+                                &decoded_vertices, &decoded_indices,
+                                &error_info_log));
+
+  const std::string manifest_filepath = "/tmp/wvu_cook_manifest_test.txt";
+  CookManifest manifest;
+  manifest.Set("meshes/cube.obj", "meshes/cube.wvumesh", HashBytes(bytes));
+  manifest.Set("brick.bmp", "brick.wvutex", 42);
+  ASSERT_TRUE(manifest.Save(manifest_filepath, &error_info_log));
+  CookManifest loaded_manifest;
+  ASSERT_TRUE(loaded_manifest.Load(manifest_filepath, &error_info_log));
+  std::remove(manifest_filepath.c_str());
+  EXPECT_EQ(loaded_manifest.num_entries(), 2);
+  EXPECT_TRUE(loaded_manifest.IsUpToDate("meshes/cube.obj",
+                                         HashBytes(bytes)));
+  EXPECT_TRUE(loaded_manifest.IsUpToDate("brick.bmp", 42));
+  EXPECT_FALSE(loaded_manifest.IsUpToDate("brick.bmp", 43));
+  EXPECT_FALSE(loaded_manifest.IsUpToDate("stone.bmp", 42));
+}
+
+TEST(CookedAssetsTest, RejectsCorruptedTextures) {
+  CookedTexture texture;
+  texture.format = CookedTextureFormat::RGB8;
+  MipLevel level;
+  level.width = 2;
+  level.height = 2;
+  level.data.assign(3 * 2 * 2, 128);
+  texture.levels.push_back(level);
+  std::string bytes;
+  EncodeCookedTexture(texture, &bytes);
+  CookedTexture decoded_texture;
+  std::string error_info_log;
+  ASSERT_TRUE(DecodeCookedTexture(bytes.data(), bytes.size(),
+                                  &decoded_texture, &error_info_log));
+  ASSERT_EQ(decoded_texture.levels.size(), 1);
+  EXPECT_EQ(decoded_texture.levels[0].data, level.data);
+  // More levels than the bytes left can hold.
+  std::string corrupted = bytes;
+  const uint32_t num_levels = 0xffffffffu;
+  std::memcpy(&corrupted[12], &num_levels, sizeof(num_levels));
+  EXPECT_FALSE(DecodeCookedTexture(corrupted.data(), corrupted.size(),
+                                   &decoded_texture, &error_info_log));
+  // An empty level whose 32-bit size 3 * 65536 * 65536 would wrap to zero.
+  corrupted = bytes.substr(0, 16 + 3 * sizeof(uint32_t));
+  const uint32_t level_header[3] = {65536, 65536, 0};
+  std::memcpy(&corrupted[16], level_header, sizeof(level_header));
+  EXPECT_FALSE(DecodeCookedTexture(corrupted.data(), corrupted.size(),
+                                   &decoded_texture, &error_info_log));
+}
+
+TEST(LzCodecTest, RoundTrip) {
+  std::mt19937 random_engine(11);
+  std::uniform_int_distribution<int> byte_distribution(0, 255);
+  std::uniform_int_distribution<int> letter_distribution(0, 3);
+  // Random bytes do not compress; repeated text and runs do.
+  std::string random_bytes(5000, '\0');
+  for (char& byte : random_bytes) byte = byte_distribution(random_engine);
+  std::string text;
+  while (text.size() < 20000) {
+    text += "v 0.5 1.0 -2.0\nvt 0.25 0.75\n";
+    text.push_back('a' + letter_distribution(random_engine));
+  }
+  const std::string run(1000, 'x');
+  for (const std::string& input : {std::string(), random_bytes, text, run}) {
+    std::string compressed;
+    CompressLz(input.data(), input.size(), &compressed);
+    EXPECT_LE(compressed.size(), GetMaxLzCompressedSize(input.size()));
+    std::string decompressed(input.size(), '\0');
+    ASSERT_TRUE(DecompressLz(compressed.data(), compressed.size(),
+                             &decompressed[0], decompressed.size()));
+    EXPECT_EQ(decompressed, input);
+    // A wrong size is detected.
+    std::string too_large(input.size() + 1, '\0');
+    EXPECT_FALSE(DecompressLz(compressed.data(), compressed.size(),
+                              &too_large[0], too_large.size()));
+  }
+  std::string compressed;
+  CompressLz(text.data(), text.size(), &compressed);
+  EXPECT_LT(compressed.size(), text.size() / 4);
+  CompressLz(run.data(), run.size(), &compressed);
+  EXPECT_LT(compressed.size(), 32);
+}
+
+TEST(PakArchiveTest, WriteAndRead) {
+  std::string large_entry;
+  while (large_entry.size() < 5 * kPakBlockSize / 2) {
+    large_entry += "f 1/1/1 2/2/2 3/3/3 " + std::to_string(large_entry.size());
+  }
+  const std::string pak_filepath = "/tmp/wvu_pak_archive_test.pak";
+  PakWriter writer(64);
+  writer.AddEntry("shaders/shader.vert", "#version 330 core\n", false);
+  writer.AddEntry("meshes/large.obj", large_entry, true);
+  // Too small to compress: it is stored as is.
+  writer.AddEntry("tiny.txt", "abc", true);
+  writer.AddEntry("empty.txt", "", true);
+  std::string error_info_log;
+  ASSERT_TRUE(writer.Write(pak_filepath, &error_info_log));
+
+  PakReader reader;
+  ASSERT_TRUE(reader.Open(pak_filepath, &error_info_log)) << error_info_log;
+  std::remove(pak_filepath.c_str());
+  EXPECT_EQ(reader.num_entries(), 4);
+  EXPECT_FALSE(reader.Contains("missing.txt"));
+  ByteSpan span;
+  ASSERT_TRUE(reader.GetSpan("shaders/shader.vert", &span));
+  EXPECT_EQ(std::string(span.data, span.size), "#version 330 core\n");
+  // The entries are aligned.
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(span.data) % 64, 0);
+  ASSERT_TRUE(reader.GetSpan("tiny.txt", &span));
+  EXPECT_EQ(std::string(span.data, span.size), "abc");
+  EXPECT_FALSE(reader.GetSpan("meshes/large.obj", &span));
+
+  std::string contents;
+  ASSERT_TRUE(reader.Read("meshes/large.obj", nullptr, &contents));
+  EXPECT_EQ(contents, large_entry);
+  ThreadPool thread_pool(3);
+  contents.clear();
+  ASSERT_TRUE(reader.Read("meshes/large.obj", &thread_pool, &contents));
+  EXPECT_EQ(contents, large_entry);
+  ASSERT_TRUE(reader.Read("empty.txt", &thread_pool, &contents));
+  EXPECT_TRUE(contents.empty());
+  EXPECT_FALSE(reader.Read("missing.txt", nullptr, &contents));
+  std::vector<std::string> names = reader.GetEntryNames();
+  std::sort(names.begin(), names.end());
+  EXPECT_EQ(names, std::vector<std::string>({"empty.txt", "meshes/large.obj",
+                                             "shaders/shader.vert",
+                                             "tiny.txt"}));
+}
+
+
+TEST(SceneFileTest, TextToBinaryRoundTrip) {
+  const std::string text =
+      "// A test scene.\n"
+      "{\n"
+      "  \"meshes\": {\"cube\": \"builtin:cube\", \"rock\": \"rock.obj\"},\n"
+      "  \"materials\": {\n"
+      "    \"stone\": {\"vertex_shader\": \"shader.vert\",\n"
+      "              \"fragment_shader\": \"shader.frag\",\n"
+      "              \"textures\": [\"stone.bmp\", \"stone_normal.bmp\"]}\n"
+      "  },\n"
+      "  \"entities\": [\n"
+      "    {\"name\": \"ground\", \"mesh\": \"cube\", \"material\": \"stone\",\n"
+      "     \"position\": [0, -1, -15], \"scale\": [10, 0.1, 10],\n"
+      "     \"static\": true, \"comment\": {\"unknown\": [1, null]}},\n"
+      "    {\"mesh\": \"rock\", \"rotation\": [0, 1.5707963, 0],\n"
+      "     \"scale\": 2}\n"
+      "  ]\n"
+      "}\n";
+  SceneDescription scene;
+  std::string error_info_log;
+  ASSERT_TRUE(ParseSceneText(text, &scene, &error_info_log))
+      << error_info_log;
+  ASSERT_EQ(scene.entities.size(), 2);
+  EXPECT_EQ(scene.entities[1].material_index, -1);
+  EXPECT_TRUE(scene.entities[1].orientation.isApprox(
+      Eigen::Quaternionf(Eigen::AngleAxisf(M_PI / 2, Eigen::Vector3f::UnitY())),
+      1e-5f));
+  std::string bytes;
+  EncodeScene(scene, &bytes);
+
+  // The binary scene is used in place from the mapped file.
+  const std::string scene_filepath = "scene_file_test.wvuscene";
+  ASSERT_TRUE(WriteFileContents(scene_filepath, bytes));
+  SceneFile scene_file;
+  ASSERT_TRUE(scene_file.Open(scene_filepath, &error_info_log))
+      << error_info_log;
+  std::remove(scene_filepath.c_str());
+  const SceneView& view = scene_file.view();
+  ASSERT_EQ(view.num_entities(), 2);
+  ASSERT_EQ(view.num_meshes(), 2);
+  ASSERT_EQ(view.num_materials(), 1);
+  const SceneEntity& ground = view.entity(0);
+  EXPECT_STREQ(view.string(ground.name), "ground");
+  EXPECT_STREQ(view.mesh(ground.mesh_index), "builtin:cube");
+  EXPECT_EQ(ground.flags, kStaticSceneEntity);
+  EXPECT_EQ(ground.position[2], -15.0f);
+  EXPECT_EQ(ground.scale[1], 0.1f);
+  EXPECT_EQ(ground.orientation[3], 1.0f);
+  const SceneMaterial& stone = view.material(ground.material_index);
+  EXPECT_STREQ(view.string(stone.fragment_shader), "shader.frag");
+  ASSERT_EQ(stone.num_textures, 2);
+  EXPECT_STREQ(view.texture(stone, 1), "stone_normal.bmp");
+  const SceneEntity& rock = view.entity(1);
+  EXPECT_STREQ(view.string(rock.name), "");
+  EXPECT_STREQ(view.mesh(rock.mesh_index), "rock.obj");
+  EXPECT_EQ(rock.material_index, kNoSceneMaterial);
+  EXPECT_EQ(rock.flags, 0);
+  EXPECT_EQ(rock.scale[0], 2.0f);
+
+  // Broken scenes are rejected.
+  SceneView truncated_view;
+  EXPECT_FALSE(truncated_view.Initialize(bytes.data(), bytes.size() - 1,
+                                         &error_info_log));
+  SceneDescription broken_scene;
+  EXPECT_FALSE(ParseSceneText("{\"meshes\": {}, \"entities\": [\n"
+                              "  {\"mesh\": \"cube\"}]}", &broken_scene,
+                              &error_info_log));
+  EXPECT_FALSE(ParseSceneText("{\"entities\": [\n  {\"mesh\" 1}]}",
+                              &broken_scene, &error_info_log));
+  EXPECT_EQ(error_info_log.compare(0, 7, "Line 2:"), 0) << error_info_log;
+}
+
+
+TEST(BenchmarkTest, SummaryAndSuite) {
+  const SampleSummary summary = SummarizeSamples({5.0, 1.0, 3.0, 2.0, 100.0});
+  EXPECT_EQ(summary.num_samples, 5);
+  EXPECT_EQ(summary.min, 1.0);
+  EXPECT_EQ(summary.median, 3.0);
+  EXPECT_EQ(summary.mean, 22.2);
+  // The outlier barely moves the MAD: the deviations are 2, 2, 0, 1, 97.
+  EXPECT_EQ(summary.median_absolute_deviation, 2.0);
+  EXPECT_EQ(SummarizeSamples({4.0, 1.0, 2.0, 3.0}).median, 2.5);
+
+  BenchmarkOptions options;
+  options.num_warmup_repetitions = 1;
+  options.num_repetitions = 3;
+  options.min_repetition_time_ms = 0.1;
+  BenchmarkSuite suite(options);
+  int num_runs = 0;
+  suite.Add("Sum/batched", 16, [&num_runs](const int num_iterations) {
+    ++num_runs;
+    float sum = 0.0f;
+    for (int i = 0; i < num_iterations * 16; ++i) sum += i;
+    DoNotOptimize(sum);
+  });
+  suite.Add("Skipped", 1, [](const int) { FAIL(); });
+  suite.Run("Sum");
+  ASSERT_EQ(suite.results().size(), 1);
+  const BenchmarkResult& result = suite.results()[0];
+  EXPECT_EQ(result.name, "Sum/batched");
+  EXPECT_GE(result.num_iterations, 1);
+  EXPECT_EQ(result.ns_per_item.num_samples, 3);
+  // Calibration, warmup and measured repetitions.
+  EXPECT_GE(num_runs, 1 + 1 + 3);
+  const std::string json = suite.ToJson();
+  EXPECT_NE(json.find("\"name\": \"Sum/batched\""), std::string::npos);
+  EXPECT_NE(json.find("\"median_absolute_deviation\""), std::string::npos);
+}
+
+
+TEST(StressSceneTest, GeneratesTheRequestedScene) {
+  StressSceneOptions options;
+  options.num_objects = 2000;
+  options.triangles_per_mesh = 300;
+  options.num_unique_meshes = 3;
+  options.num_unique_textures = 5;
+  options.static_fraction = 0.25f;
+  options.texture_size = 16;
+  options.seed = 7;
+  StressScene scene;
+  GenerateStressScene(options, &scene);
+  ASSERT_EQ(scene.mesh_vertices.size(), 3);
+  ASSERT_EQ(scene.textures.size(), 5);
+  ASSERT_EQ(scene.objects.size(), 2000);
+  for (int i = 0; i < 3; ++i) {
+    const int num_triangles = scene.mesh_indices[i].size() / 3;
+    EXPECT_GE(num_triangles, 300);
+    EXPECT_LE(num_triangles, 330);
+    for (const GLuint index : scene.mesh_indices[i]) {
+      ASSERT_LT(index, scene.mesh_vertices[i].cols());
+    }
+  }
+  EXPECT_EQ(scene.textures[0].size(), 3 * 16 * 16);
+  int num_static = 0;
+  for (const StressObject& object : scene.objects) {
+    ASSERT_GE(object.mesh_index, 0);
+    ASSERT_LT(object.mesh_index, 3);
+    ASSERT_LT(object.texture_index, 5);
+    EXPECT_LE(std::abs(object.position.x()), options.extent);
+    EXPECT_LT(object.position.z(), -2.0f);
+    num_static += object.is_static;
+  }
+  EXPECT_NEAR(num_static, 500, 100);
+
+  // The same seed generates the same scene.
+  StressScene same_scene;
+  GenerateStressScene(options, &same_scene);
+  EXPECT_EQ(same_scene.objects.back().position,
+            scene.objects.back().position);
+  EXPECT_EQ(same_scene.mesh_indices[2], scene.mesh_indices[2]);
+}
+
+TEST(AssetCorpusTest, GeneratedObjModelsParse) {
+  const ObjAttributes kAttributes[] = {
+    ObjAttributes::POSITIONS,
+    ObjAttributes::POSITIONS_TEXELS,
+    ObjAttributes::POSITIONS_NORMALS,
+    ObjAttributes::POSITIONS_TEXELS_NORMALS
+  };
+  for (const ObjAttributes attributes : kAttributes) {
+    std::string contents;
+    GenerateObjModel(100, attributes, &contents);
+    std::vector<Eigen::Vector3f> vertices;
+    std::vector<Eigen::Vector2f> texels;
+    std::vector<Eigen::Vector3f> normals;
+    std::vector<Face> faces;
+    ParseObjModel(contents, &vertices, &texels, &normals, &faces);
+    // 8 x 8 cells of two triangles.
+    ASSERT_EQ(faces.size(), 128) << GetObjAttributesName(attributes);
+    ASSERT_EQ(vertices.size(), 81);
+    const bool has_texels = attributes == ObjAttributes::POSITIONS_TEXELS ||
+        attributes == ObjAttributes::POSITIONS_TEXELS_NORMALS;
+    const bool has_normals = attributes == ObjAttributes::POSITIONS_NORMALS ||
+        attributes == ObjAttributes::POSITIONS_TEXELS_NORMALS;
+    EXPECT_EQ(texels.size(), has_texels ? 81 : 0);
+    EXPECT_EQ(normals.size(), has_normals ? 81 : 0);
+    for (const Face& face : faces) {
+      ASSERT_EQ(face.texel_indices.size(), has_texels ? 3 : 0);
+      ASSERT_EQ(face.normal_indices.size(), has_normals ? 3 : 0);
+      for (int i = 0; i < 3; ++i) {
+        ASSERT_GE(face.vertex_indices[i], 0);
+        ASSERT_LT(face.vertex_indices[i], 81);
+        if (has_normals) {
+          EXPECT_EQ(face.normal_indices[i], face.vertex_indices[i]);
+        }
+      }
+    }
+    // The triangles face up, as the normals do.
+    const Face& face = faces.front();
+    const Eigen::Vector3f normal =
+        (vertices[face.vertex_indices[1]] - vertices[face.vertex_indices[0]])
+        .cross(vertices[face.vertex_indices[2]] -
+               vertices[face.vertex_indices[0]]);
+    EXPECT_GT(normal.y(), 0.0f);
+    if (has_normals) {
+      EXPECT_GT(normals[face.normal_indices[0]].y(), 0.0f);
+    }
+  }
+
+  std::vector<uint8_t> rgb_pixels;
+  GenerateImage(32, 16, 1, &rgb_pixels);
+  EXPECT_EQ(rgb_pixels.size(), 3 * 32 * 16);
+}
+
+TEST(PerfGateTest, ComparesAgainstBaselines) {
+  PerfBaseline baseline;
+  baseline.median = 100.0;
+  baseline.median_absolute_deviation = 1.0;
+  baseline.tolerance = 0.1;
+  SampleSummary measured = SummarizeSamples({104.0, 105.0, 106.0});
+  // Within the tolerance and the noise: 100 * 1.1 + 3 * 1.4826 * 1.
+  PerfComparison comparison =
+      ComparePerformance("metric", measured, &baseline);
+  EXPECT_EQ(comparison.status, PerfStatus::PASSED);
+  EXPECT_NEAR(comparison.limit, 114.45, 0.01);
+  measured = SummarizeSamples({119.0, 120.0, 121.0});
+  comparison = ComparePerformance("metric", measured, &baseline);
+  EXPECT_EQ(comparison.status, PerfStatus::REGRESSED);
+  // A noisy run widens the limit.
+  measured = SummarizeSamples({100.0, 120.0, 140.0});
+  comparison = ComparePerformance("metric", measured, &baseline);
+  EXPECT_EQ(comparison.status, PerfStatus::PASSED);
+  measured = SummarizeSamples({50.0, 51.0, 52.0});
+  comparison = ComparePerformance("metric", measured, &baseline);
+  EXPECT_EQ(comparison.status, PerfStatus::IMPROVED);
+  comparison = ComparePerformance("metric", measured, nullptr);
+  EXPECT_EQ(comparison.status, PerfStatus::NO_BASELINE);
+
+  std::vector<PerfComparison> comparisons(1, comparison);
+  EXPECT_TRUE(PassesPerfGate(comparisons));
+  comparisons.push_back(ComparePerformance(
+      "other", SummarizeSamples({200.0}), &baseline));
+  EXPECT_FALSE(PassesPerfGate(comparisons));
+  std::ostringstream table;
+  PrintPerfComparisons(comparisons, &table);
+  EXPECT_NE(table.str().find("REGRESSED"), std::string::npos);
+
+  // The baselines round trip through their file.
+  const std::string filepath = "perf_gate_test_baselines.txt";
+  PerfBaselines baselines;
+  baselines.Set("load_obj/v/1000", baseline);
+  std::string error_info_log;
+  ASSERT_TRUE(baselines.Save(filepath, &error_info_log)) << error_info_log;
+  PerfBaselines loaded_baselines;
+  ASSERT_TRUE(loaded_baselines.Load(filepath, &error_info_log));
+  std::remove(filepath.c_str());
+  ASSERT_EQ(loaded_baselines.num_entries(), 1);
+  const PerfBaseline* loaded_baseline =
+      loaded_baselines.Find("load_obj/v/1000");
+  ASSERT_NE(loaded_baseline, nullptr);
+  EXPECT_EQ(loaded_baseline->median, 100.0);
+  EXPECT_EQ(loaded_baseline->tolerance, 0.1);
+  EXPECT_EQ(loaded_baselines.Find("missing"), nullptr);
+}
+
+TEST_F(ModelTest, GlTraceRecordAndReplay) {
+  const std::string trace_filepath = "/tmp/wvu_gl_trace_test.wvutrace";
+  std::string error_info_log;
+  ASSERT_TRUE(StartGlTraceRecording(trace_filepath, &error_info_log))
+      << error_info_log;
+  EXPECT_TRUE(IsRecordingGlTrace());
+  RecordGlCall(GlTraceOpcode::VIEWPORT, {0, 0, 16, 16});
+  RecordGlCall(GlTraceOpcode::CLEAR_COLOR,
+               {EncodeGlTraceFloat(1.0f), EncodeGlTraceFloat(0.0f),
+                EncodeGlTraceFloat(0.0f), EncodeGlTraceFloat(1.0f)});
+  RecordGlCall(GlTraceOpcode::USE_PROGRAM, {5});
+  // The other thread starts without a program: the trace unbinds the one of
+  // this thread, and binds it back when this thread records again.
+  std::thread other_thread([]() {
+    RecordGlCall(GlTraceOpcode::USE_PROGRAM, {7});
+  });
+  other_thread.join();
+  RecordGlCall(GlTraceOpcode::CLEAR, {GL_COLOR_BUFFER_BIT});
+  MarkGlTraceFrame();
+  StopGlTraceRecording();
+  EXPECT_FALSE(IsRecordingGlTrace());
+
+  GlTraceReplayer replayer;
+  ASSERT_TRUE(replayer.Open(trace_filepath, &error_info_log))
+      << error_info_log;
+  EXPECT_EQ(replayer.num_frames(), 1);
+  EXPECT_EQ(replayer.num_commands(), 8);
+  EXPECT_EQ(replayer.num_frame_commands(0), 8);
+  EXPECT_TRUE(replayer.unsupported_calls().empty());
+  OffscreenFramebuffer framebuffer;
+  ASSERT_TRUE(framebuffer.Initialize(16, 16, &error_info_log))
+      << error_info_log;
+  framebuffer.Bind();
+  replayer.set_default_framebuffer_id(framebuffer.framebuffer_id());
+  replayer.ReplayPrologue();
+  replayer.ReplayFrame(0);
+  replayer.ReplayEpilogue();
+  framebuffer.Unbind();
+  std::vector<uint8_t> rgba_pixels;
+  framebuffer.ReadPixels(&rgba_pixels);
+  EXPECT_EQ(glGetError(), GL_NO_ERROR);
+  EXPECT_EQ(rgba_pixels[0], 255);
+  EXPECT_EQ(rgba_pixels[1], 0);
+  EXPECT_EQ(rgba_pixels[2], 0);
+
+  // A truncated trace is rejected.
+  std::FILE* file = std::fopen(trace_filepath.c_str(), "ab");
+  ASSERT_NE(file, nullptr);
+  std::fputc(0, file);
+  std::fclose(file);
+  EXPECT_FALSE(replayer.Open(trace_filepath, &error_info_log));
+
+  // So are the commands whose arguments or data do not match their opcode,
+  // since replaying them would read past the command.
+  const GLuint buffer_names[2] = {1, 2};
+  const GLubyte pixels[3] = {255, 0, 0};
+  const std::vector<std::function<void()>> malformed_commands = {
+    []() { RecordGlCall(GlTraceOpcode::BIND_FRAMEBUFFER, {GL_FRAMEBUFFER}); },
+    []() { RecordGlCall(GlTraceOpcode::GEN_BUFFERS, {2}); },
+    [&buffer_names]() {
+      RecordGlCall(GlTraceOpcode::DELETE_BUFFERS, {3}, buffer_names,
+                   sizeof(buffer_names));
+    },
+    // The rows of a 1x2 RGB image are padded to the default alignment of 4.
+    [&pixels]() {
+      RecordGlCall(GlTraceOpcode::TEX_IMAGE_2D,
+                   {GL_TEXTURE_2D, 0, GL_RGB, 1, 2, 0, GL_RGB,
+                    GL_UNSIGNED_BYTE, 1}, pixels, sizeof(pixels));
+    },
+  };
+  for (const std::function<void()>& record_command : malformed_commands) {
+    ASSERT_TRUE(StartGlTraceRecording(trace_filepath, &error_info_log))
+        << error_info_log;
+    record_command();
+    StopGlTraceRecording();
+    EXPECT_FALSE(replayer.Open(trace_filepath, nullptr));
+  }
+  ASSERT_TRUE(StartGlTraceRecording(trace_filepath, &error_info_log))
+      << error_info_log;
+  RecordGlCall(GlTraceOpcode::PIXEL_STORE_I, {GL_UNPACK_ALIGNMENT, 1});
+  RecordGlCall(GlTraceOpcode::TEX_IMAGE_2D,
+               {GL_TEXTURE_2D, 0, GL_RGB, 1, 1, 0, GL_RGB, GL_UNSIGNED_BYTE,
+                1}, pixels, sizeof(pixels));
+  StopGlTraceRecording();
+  EXPECT_TRUE(replayer.Open(trace_filepath, nullptr));
+  std::remove(trace_filepath.c_str());
+}
+
+TEST(SimdMathTest, MatchesEigenForEverySupportedIsa) {
+  // Not a multiple of the lanes, to cover the remainders of the batches.
+  const int kNumElements = 19;
+  std::srand(0);
+  std::vector<Eigen::Matrix4f> eigen_lhs, eigen_rhs;
+  std::vector<Eigen::Vector4f> eigen_points;
+  std::vector<Eigen::Quaternionf> eigen_quaternions;
+  std::vector<Mat4> lhs, rhs;
+  std::vector<Vec4> points;
+  std::vector<Quat> quaternions;
+  for (int i = 0; i < kNumElements; ++i) {
+    eigen_lhs.push_back(Eigen::Matrix4f::Random() +
+                        4.0f * Eigen::Matrix4f::Identity());
+    eigen_rhs.push_back(Eigen::Matrix4f::Random());
+    eigen_points.push_back(Eigen::Vector4f::Random());
+    eigen_quaternions.push_back(
+        Eigen::Quaternionf(Eigen::Vector4f::Random()).normalized());
+    lhs.push_back(ToMat4(eigen_lhs.back()));
+    rhs.push_back(ToMat4(eigen_rhs.back()));
+    points.push_back(ToVec4(eigen_points.back()));
+    quaternions.push_back(ToQuat(eigen_quaternions.back()));
+  }
+  EXPECT_TRUE(IsSimdIsaSupported(SimdIsa::SCALAR));
+  const SimdIsa default_isa = GetSimdIsa();
+  const float kTolerance = 1e-5f;
+  for (const SimdIsa isa :
+       {SimdIsa::SCALAR, SimdIsa::SSE2, SimdIsa::AVX2_FMA}) {
+    if (!SetSimdIsa(isa)) continue;
+    SCOPED_TRACE(GetSimdIsaName(isa));
+    EXPECT_EQ(GetSimdIsa(), isa);
+    std::vector<Mat4> products(kNumElements), common_products(kNumElements),
+        inverses(kNumElements);
+    std::vector<Vec4> transformed_points(kNumElements);
+    std::vector<Vec4> planes(kNumFrustumPlanes * kNumElements);
+    std::vector<Quat> quaternion_products(kNumElements);
+    MultiplyMat4Batch(lhs.data(), rhs.data(), kNumElements, products.data());
+    MultiplyMat4Batch(lhs[0], rhs.data(), kNumElements,
+                      common_products.data());
+    InvertMat4Batch(lhs.data(), kNumElements, inverses.data());
+    TransformPointBatch(lhs[0], points.data(), kNumElements,
+                        transformed_points.data());
+    ExtractFrustumPlanesBatch(lhs.data(), kNumElements, planes.data());
+    MultiplyQuatBatch(quaternions.data(), quaternions.data() + 1,
+                      kNumElements - 1, quaternion_products.data());
+    for (int i = 0; i < kNumElements; ++i) {
+      EXPECT_TRUE(ToEigen(products[i]).isApprox(eigen_lhs[i] * eigen_rhs[i],
+                                                kTolerance));
+      EXPECT_TRUE(ToEigen(common_products[i]).isApprox(
+          eigen_lhs[0] * eigen_rhs[i], kTolerance));
+      EXPECT_TRUE(ToEigen(inverses[i]).isApprox(eigen_lhs[i].inverse(),
+                                                kTolerance));
+      EXPECT_TRUE(ToEigen(transformed_points[i]).isApprox(
+          eigen_lhs[0] * eigen_points[i], kTolerance));
+      Eigen::Vector4f expected_planes[kNumFrustumPlanes];
+      ExtractFrustumPlanes(eigen_lhs[i], expected_planes);
+      for (int j = 0; j < kNumFrustumPlanes; ++j) {
+        EXPECT_TRUE(ToEigen(planes[kNumFrustumPlanes * i + j]).isApprox(
+            expected_planes[j], kTolerance));
+      }
+      if (i + 1 < kNumElements) {
+        EXPECT_TRUE(ToEigen(quaternion_products[i]).coeffs().isApprox(
+            (eigen_quaternions[i] * eigen_quaternions[i + 1]).coeffs(),
+            kTolerance));
+      }
+    }
+  }
+  EXPECT_TRUE(SetSimdIsa(default_isa));
+}
+
+TEST(TransformationsTest, QuaternionConversionsAndInterpolation) {
+  const Eigen::Vector3f rodrigues(0.3f, -0.2f, 0.5f);
+  const Eigen::Quaternionf rotation = ConvertRodriguesToQuaternion(rodrigues);
+  EXPECT_NEAR((ConvertQuaternionToRodrigues(rotation) - rodrigues).norm(),
+              0.0f, 1e-5);
+  EXPECT_NEAR((ComputeRotationMatrix(rotation) -
+               ComputeRotationMatrix(rodrigues.normalized(),
+                                     rodrigues.norm())).norm(), 0.0f, 1e-5);
+  EXPECT_TRUE(ConvertRodriguesToQuaternion(Eigen::Vector3f::Zero())
+                  .isApprox(Eigen::Quaternionf::Identity()));
+
+  const Eigen::Quaternionf from =
+      Eigen::Quaternionf(Eigen::Vector4f::Random()).normalized();
+  Eigen::Quaternionf to =
+      Eigen::Quaternionf(Eigen::Vector4f::Random()).normalized();
+  for (const float t : {0.0f, 0.25f, 0.5f, 1.0f}) {
+    EXPECT_NEAR(Slerp(from, to, t).angularDistance(from.slerp(t, to)), 0.0f,
+                1e-3);
+    EXPECT_NEAR(Nlerp(from, to, t).norm(), 1.0f, 1e-5);
+  }
+  // Both take the shortest arc: -to is the same rotation as to.
+  to.coeffs() *= -1.0f;
+  EXPECT_NEAR(Slerp(from, to, 0.5f).angularDistance(from.slerp(0.5f, to)),
+              0.0f, 1e-3);
+  EXPECT_NEAR(Nlerp(from, to, 1.0f).angularDistance(to), 0.0f, 1e-3);
+}
+
+TEST_F(ModelTest, QuaternionOrientation) {
+  const Eigen::Vector3f orientation(0.1f, 0.7f, -0.4f);
+  Model model(orientation, Eigen::Vector3f(1.0f, 2.0f, 3.0f),
+              Eigen::MatrixXf::Zero(8, 3));
+  EXPECT_NEAR((model.orientation() - orientation).norm(), 0.0f, 1e-5);
+
+  const Eigen::Quaternionf rotation(
+      Eigen::AngleAxisf(0.5f, Eigen::Vector3f::UnitY()));
+  const Eigen::Matrix4f model_matrix = model.ComputeModelMatrix();
+  model.Rotate(rotation);
+  Eigen::Matrix4f expected_model_matrix = model_matrix;
+  expected_model_matrix.topLeftCorner<3, 3>() =
+      rotation.toRotationMatrix() * model_matrix.topLeftCorner<3, 3>();
+  EXPECT_NEAR((model.ComputeModelMatrix() - expected_model_matrix).norm(),
+              0.0f, 1e-5);
+
+  // The batched model matrices match the ones of every model, including the
+  // models of the tail that the vector kernels do not cover.
+  std::vector<std::unique_ptr<Model> > models;
+  std::vector<Model*> model_pointers;
+  for (int i = 0; i < 11; ++i) {
+    models.emplace_back(new Model(Eigen::Vector3f::Random(),
+                                  Eigen::Vector3f::Random(),
+                                  Eigen::MatrixXf::Zero(8, 3)));
+    model_pointers.push_back(models.back().get());
+  }
+  std::vector<Eigen::Matrix4f> model_matrices;
+  Model::ComputeModelMatrices(model_pointers, &model_matrices);
+  ASSERT_EQ(model_matrices.size(), models.size());
+  for (int i = 0; i < models.size(); ++i) {
+    EXPECT_NEAR((model_matrices[i] - models[i]->ComputeModelMatrix()).norm(),
+                0.0f, 1e-5);
+  }
+}
+
+TEST(SimdMathTest, QuaternionKernelsMatchEigenForEverySupportedIsa) {
+  // Not a multiple of the lanes, so that the remainders are exercised.
+  const int kNumQuaternions = 37;
+  std::vector<Eigen::Quaternionf> eigen_from, eigen_to;
+  std::vector<Quat> from, to;
+  std::vector<float> weights;
+  for (int i = 0; i < kNumQuaternions; ++i) {
+    eigen_from.push_back(
+        Eigen::Quaternionf(Eigen::Vector4f::Random()).normalized());
+    eigen_to.push_back(
+        Eigen::Quaternionf(Eigen::Vector4f::Random()).normalized());
+    // Identical and opposite quaternions are the corner cases of slerp.
+    if (i % 5 == 0) eigen_to.back() = eigen_from.back();
+    if (i % 7 == 0) eigen_to.back().coeffs() = -eigen_from.back().coeffs();
+    from.push_back(ToQuat(eigen_from.back()));
+    to.push_back(ToQuat(eigen_to.back()));
+    weights.push_back(static_cast<float>(i) / (kNumQuaternions - 1));
+  }
+
+  const SimdIsa default_isa = GetSimdIsa();
+  for (const SimdIsa isa :
+       {SimdIsa::SCALAR, SimdIsa::SSE2, SimdIsa::AVX2_FMA}) {
+    if (!SetSimdIsa(isa)) continue;
+    SCOPED_TRACE(GetSimdIsaName(isa));
+    std::vector<Quat> interpolations(kNumQuaternions);
+    SlerpQuatBatch(from.data(), to.data(), weights.data(), kNumQuaternions,
+                   interpolations.data());
+    for (int i = 0; i < kNumQuaternions; ++i) {
+      const Eigen::Quaternionf expected =
+          eigen_from[i].slerp(weights[i], eigen_to[i]);
+      EXPECT_NEAR(ToEigen(interpolations[i]).angularDistance(expected), 0.0f,
+                  1e-3);
+      EXPECT_NEAR(ToEigen(interpolations[i]).norm(), 1.0f, 1e-5);
+    }
+    NlerpQuatBatch(from.data(), to.data(), weights.data(), kNumQuaternions,
+                   interpolations.data());
+    for (int i = 0; i < kNumQuaternions; ++i) {
+      EXPECT_NEAR(ToEigen(interpolations[i]).angularDistance(
+                      Nlerp(eigen_from[i], eigen_to[i], weights[i])),
+                  0.0f, 1e-3);
+    }
+    std::vector<Mat4> matrices(kNumQuaternions);
+    QuatToMat4Batch(from.data(), kNumQuaternions, matrices.data());
+    for (int i = 0; i < kNumQuaternions; ++i) {
+      EXPECT_NEAR((ToEigen(matrices[i]) -
+                   ComputeRotationMatrix(eigen_from[i])).norm(), 0.0f, 1e-5);
+    }
+  }
+  EXPECT_TRUE(SetSimdIsa(default_isa));
+}
+
+TEST(AnimationTest, SampleTrackInterpolatesTheKeyframes) {
+  Vector3Track track;
+  track.times = {0.0f, 1.0f, 3.0f, 4.0f};
+  track.values = {Eigen::Vector3f(0.0f, 0.0f, 0.0f),
+                  Eigen::Vector3f(1.0f, 2.0f, 0.0f),
+                  Eigen::Vector3f(3.0f, 0.0f, 1.0f),
+                  Eigen::Vector3f(4.0f, 4.0f, 4.0f)};
+  int cursor = 0;
+  EXPECT_TRUE(SampleTrack(track, -1.0f, &cursor).isApprox(track.values[0]));
+  EXPECT_TRUE(SampleTrack(track, 5.0f, &cursor).isApprox(track.values[3]));
+  EXPECT_TRUE(SampleTrack(track, 2.0f, &cursor)
+                  .isApprox(Eigen::Vector3f(2.0f, 1.0f, 0.5f)));
+  EXPECT_EQ(cursor, 1);
+  // Backward in time, e.g., when a clip loops.
+  EXPECT_TRUE(SampleTrack(track, 0.5f, &cursor)
+                  .isApprox(Eigen::Vector3f(0.5f, 1.0f, 0.0f)));
+  EXPECT_EQ(cursor, 0);
+
+  // The cubic curve goes through the keyframes and is continuous.
+  track.interpolation = KeyframeInterpolation::CUBIC;
+  for (int i = 0; i < track.times.size(); ++i) {
+    EXPECT_NEAR((SampleTrack(track, track.times[i], &cursor) -
+                 track.values[i]).norm(), 0.0f, 1e-5);
+    const float before = track.times[i] - 1e-4f;
+    const float after = track.times[i] + 1e-4f;
+    if (i == 0 || i + 1 == track.times.size()) continue;
+    EXPECT_NEAR((SampleTrack(track, before, &cursor) -
+                 SampleTrack(track, after, &cursor)).norm(), 0.0f, 1e-2);
+  }
+
+  // The cursor gives the same results whatever the order of the samples.
+  std::vector<float> times;
+  for (int i = 0; i <= 80; ++i) {
+    times.push_back(0.05f * i);
+  }
+  std::vector<Eigen::Vector3f> forward;
+  int forward_cursor = 0;
+  for (const float time : times) {
+    forward.push_back(SampleTrack(track, time, &forward_cursor));
+  }
+  int backward_cursor = 0;
+  for (int i = times.size() - 1; i >= 0; --i) {
+    EXPECT_TRUE(SampleTrack(track, times[i], &backward_cursor)
+                    .isApprox(forward[i]));
+  }
+}
+
+TEST(AnimationTest, SampleRotationTrack) {
+  RotationTrack track;
+  track.times = {0.0f, 1.0f, 2.0f};
+  for (const float angle : {0.0f, 1.0f, 2.5f}) {
+    track.values.push_back(Eigen::Quaternionf(
+        Eigen::AngleAxisf(angle, Eigen::Vector3f::UnitZ())));
+  }
+  int cursor = 0;
+  const Eigen::Quaternionf expected(
+      Eigen::AngleAxisf(1.75f, Eigen::Vector3f::UnitZ()));
+  EXPECT_NEAR(SampleTrack(track, 1.5f, &cursor).angularDistance(expected),
+              0.0f, 1e-5);
+  // The cubic curve of rotations about one axis stays about that axis.
+  track.interpolation = KeyframeInterpolation::CUBIC;
+  const Eigen::Quaternionf rotation = SampleTrack(track, 1.5f, &cursor);
+  EXPECT_NEAR(rotation.norm(), 1.0f, 1e-5);
+  EXPECT_NEAR(rotation.vec().head<2>().norm(), 0.0f, 1e-5);
+  EXPECT_NEAR(rotation.angularDistance(expected), 0.0f, 0.1f);
+}
+
+TEST(AnimationTest, AnimatorWritesTheTransformStore) {
+  AnimationClip clip;
+  clip.position.times = {0.0f, 2.0f};
+  clip.position.values = {Eigen::Vector3f::Zero(),
+                          Eigen::Vector3f(2.0f, 0.0f, 0.0f)};
+  clip.rotation.times = {0.0f, 1.0f, 2.0f};
+  for (const float angle : {0.0f, 1.5f, 3.0f}) {
+    clip.rotation.values.push_back(Eigen::Quaternionf(
+        Eigen::AngleAxisf(angle, Eigen::Vector3f::UnitY())));
+  }
+  clip.loop = true;
+  EXPECT_EQ(GetClipDuration(clip), 2.0f);
+
+  // Enough animations to be split among the workers, with a scale that is
+  // not animated.
+  const int kNumAnimations = 1000;
+  std::vector<std::unique_ptr<Model> > models;
+  TransformStore serial_transforms;
+  Animator serial_animator;
+  Animator parallel_animator;
+  for (int i = 0; i < kNumAnimations; ++i) {
+    models.emplace_back(new Model(Eigen::Vector3f::Zero(),
+                                  Eigen::Vector3f::Zero(),
+                                  Eigen::MatrixXf::Zero(8, 3)));
+    models.back()->set_scale(Eigen::Vector3f(1.0f, 2.0f, 3.0f));
+    const int index = serial_transforms.Add(*models.back());
+    EXPECT_EQ(index, i);
+    serial_animator.Play(&clip, index, 0.01f * i);
+    parallel_animator.Play(&clip, index, 0.01f * i);
+  }
+  TransformStore parallel_transforms = serial_transforms;
+  ThreadPool thread_pool(4);
+  for (const float time : {0.5f, 1.7f, 3.2f, 0.1f}) {
+    serial_animator.Evaluate(time, nullptr, &serial_transforms);
+    parallel_animator.Evaluate(time, &thread_pool, &parallel_transforms);
+    for (int i = 0; i < kNumAnimations; ++i) {
+      const float clip_time = std::fmod(time - 0.01f * i + 20.0f, 2.0f);
+      EXPECT_NEAR(serial_transforms.positions[i].x(), clip_time, 1e-4);
+      int cursor = 0;
+      EXPECT_NEAR(serial_transforms.rotations[i].angularDistance(
+                      SampleTrack(clip.rotation, clip_time, &cursor)),
+                  0.0f, 1e-3);
+      EXPECT_TRUE(
+          serial_transforms.positions[i].isApprox(
+              parallel_transforms.positions[i]));
+      EXPECT_TRUE(serial_transforms.rotations[i].isApprox(
+          parallel_transforms.rotations[i]));
+    }
+  }
+  EXPECT_TRUE(serial_transforms.scales[0].isApprox(
+      Eigen::Vector3f(1.0f, 2.0f, 3.0f)));
+
+  // The model matrices of the store are the ones of the models.
+  std::vector<Eigen::Matrix4f> model_matrices;
+  serial_transforms.ComputeModelMatrices(&model_matrices);
+  ASSERT_EQ(model_matrices.size(), kNumAnimations);
+  for (int i = 0; i < kNumAnimations; ++i) {
+    serial_transforms.Apply(i, models[i].get());
+    EXPECT_NEAR((model_matrices[i] - models[i]->ComputeModelMatrix()).norm(),
+                0.0f, 1e-4);
+  }
+}
+
+namespace {
+
+// A chain of two joints along x: the root at the origin and its child one
+// unit away from it.
+Skeleton CreateTwoJointSkeleton() {
+  Skeleton skeleton;
+  Joint joint;
+  joint.parent = -1;
+  joint.position = Eigen::Vector3f::Zero();
+  joint.rotation = Eigen::Quaternionf::Identity();
+  joint.scale = Eigen::Vector3f::Ones();
+  skeleton.joints.push_back(joint);
+  joint.parent = 0;
+  joint.position = Eigen::Vector3f::UnitX();
+  skeleton.joints.push_back(joint);
+  ComputeInverseBindMatrices(&skeleton);
+  return skeleton;
+}
+
+SkinInfluences CreateInfluences(const float weight0, const float weight1) {
+  const SkinInfluences influences = {{0, 1, 0, 0},
+                                     {weight0, weight1, 0.0f, 0.0f}};
+  return influences;
+}
+
+}  // namespace
+
+TEST(SkinningTest, PackSkinInfluences) {
+  const SkinInfluences influences = {{3, 200, 7, 0}, {0.5f, 0.3f, 0.1f, 0.1f}};
+  GLuint joint_word, weight_word;
+  PackSkinInfluences(influences, &joint_word, &weight_word);
+  EXPECT_EQ(joint_word, 3u | (200u << 8) | (7u << 16));
+  int weight_sum = 0;
+  for (int i = 0; i < kMaxJointInfluences; ++i) {
+    const int weight = (weight_word >> (8 * i)) & 0xff;
+    EXPECT_NEAR(weight / 255.0f, influences.weights[i], 1.0f / 255.0f);
+    weight_sum += weight;
+  }
+  EXPECT_EQ(weight_sum, 255);
+
+  std::string error_info_log;
+  Skeleton skeleton = CreateTwoJointSkeleton();
+  EXPECT_TRUE(IsValidSkeleton(skeleton, &error_info_log));
+  skeleton.joints[0].parent = 1;
+  EXPECT_FALSE(IsValidSkeleton(skeleton, &error_info_log));
+}
+
+TEST(SkinningTest, JointPaletteSkinsPositions) {
+  const Skeleton skeleton = CreateTwoJointSkeleton();
+  TransformStore local_poses;
+  for (const Joint& joint : skeleton.joints) {
+    local_poses.positions.push_back(joint.position);
+    local_poses.rotations.push_back(joint.rotation);
+    local_poses.scales.push_back(joint.scale);
+  }
+  const Eigen::Vector3f position(2.0f, 0.5f, 0.0f);
+  std::vector<Eigen::Matrix4f> global_matrices;
+  for (const SkinningMethod method :
+       {SkinningMethod::LINEAR_BLEND, SkinningMethod::DUAL_QUATERNION}) {
+    std::vector<GLfloat> palette(4 * NumPaletteVectorsPerJoint(method) *
+                                 skeleton.joints.size());
+    // The rest pose does not move the mesh.
+    local_poses.rotations[1] = Eigen::Quaternionf::Identity();
+    ComputeJointPalette(skeleton, local_poses, 0, method, &global_matrices,
+                        palette.data());
+    EXPECT_NEAR((SkinPosition(palette.data(), method,
+                              CreateInfluences(0.3f, 0.7f), position) -
+                 position).norm(), 0.0f, 1e-5);
+
+    // Bending the child joint by 90 degrees around z rotates the vertices
+    // bound to it around the joint.
+    local_poses.rotations[1] = Eigen::Quaternionf(
+        Eigen::AngleAxisf(M_PI / 2.0f, Eigen::Vector3f::UnitZ()));
+    ComputeJointPalette(skeleton, local_poses, 0, method, &global_matrices,
+                        palette.data());
+    EXPECT_NEAR((SkinPosition(palette.data(), method,
+                              CreateInfluences(0.0f, 1.0f), position) -
+                 Eigen::Vector3f(0.5f, 1.0f, 0.0f)).norm(), 0.0f, 1e-5);
+    EXPECT_NEAR((SkinPosition(palette.data(), method,
+                              CreateInfluences(1.0f, 0.0f), position) -
+                 position).norm(), 0.0f, 1e-5);
+    // Blended between the joints, the dual quaternions keep the distance to
+    // the bent joint, while the linear blend shrinks it.
+    const Eigen::Vector3f blended_position = SkinPosition(
+        palette.data(), method, CreateInfluences(0.5f, 0.5f), position);
+    const float distance =
+        (blended_position - Eigen::Vector3f::UnitX()).norm();
+    if (method == SkinningMethod::DUAL_QUATERNION) {
+      EXPECT_NEAR(distance, (position - Eigen::Vector3f::UnitX()).norm(),
+                  1e-5);
+    } else {
+      EXPECT_LT(distance, (position - Eigen::Vector3f::UnitX()).norm());
+    }
+  }
+}
+
+TEST(SkinningTest, SkeletalAnimatorMatchesAcrossThreads) {
+  const Skeleton skeleton = CreateTwoJointSkeleton();
+  std::vector<AnimationClip> joint_clips(skeleton.joints.size());
+  joint_clips[1].rotation.times = {0.0f, 1.0f};
+  joint_clips[1].rotation.values = {
+      Eigen::Quaternionf::Identity(),
+      Eigen::Quaternionf(
+          Eigen::AngleAxisf(M_PI / 2.0f, Eigen::Vector3f::UnitZ()))};
+  joint_clips[1].loop = true;
+  SkeletalAnimator serial_animator(&skeleton);
+  SkeletalAnimator parallel_animator(&skeleton);
+  const int kNumCharacters = 100;
+  for (int i = 0; i < kNumCharacters; ++i) {
+    EXPECT_EQ(serial_animator.AddCharacter(&joint_clips, 0.01f * i), i);
+    parallel_animator.AddCharacter(&joint_clips, 0.01f * i);
+  }
+  EXPECT_EQ(serial_animator.num_characters(), kNumCharacters);
+  ThreadPool thread_pool(4);
+  for (const SkinningMethod method :
+       {SkinningMethod::LINEAR_BLEND, SkinningMethod::DUAL_QUATERNION}) {
+    serial_animator.Evaluate(0.5f, method, nullptr);
+    parallel_animator.Evaluate(0.5f, method, &thread_pool);
+    ASSERT_EQ(serial_animator.palette().size(),
+              4 * NumPaletteVectorsPerJoint(method) * 2 * kNumCharacters);
+    ASSERT_EQ(serial_animator.palette(), parallel_animator.palette());
+    // The first character is bent by 45 degrees.
+    const Eigen::Vector3f position = SkinPosition(
+        serial_animator.palette().data(), method,
+        CreateInfluences(0.0f, 1.0f), Eigen::Vector3f(2.0f, 0.0f, 0.0f));
+    EXPECT_NEAR((position - Eigen::Vector3f(1.0f + M_SQRT1_2, M_SQRT1_2,
+                                            0.0f)).norm(), 0.0f, 1e-3);
+  }
+}
+
+TEST_F(ModelTest, SkinnedMeshRendererDrawsInstances) {
+  std::string error_info_log;
+  OffscreenFramebuffer framebuffer;
+  ASSERT_TRUE(framebuffer.Initialize(32, 16, &error_info_log))
+      << error_info_log;
+  // A white texture.
+  GLuint texture_id;
+  glGenTextures(1, &texture_id);
+  glBindTexture(GL_TEXTURE_2D, texture_id);
+  const GLubyte white[] = {255, 255, 255, 255};
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+               white);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  // A triangle covering the left half of the framebuffer, in normalized
+  // device coordinates, bound to a single joint.
+  Eigen::MatrixXf vertices = Eigen::MatrixXf::Zero(8, 3);
+  vertices.col(0).head<2>() = Eigen::Vector2f(-1.0f, -1.0f);
+  vertices.col(1).head<2>() = Eigen::Vector2f(0.0f, -1.0f);
+  vertices.col(2).head<2>() = Eigen::Vector2f(-1.0f, 3.0f);
+  const std::vector<SkinInfluences> influences(3, CreateInfluences(1.0f, 0.0f));
+  const std::vector<GLuint> indices = {0, 1, 2};
+  // More instances than a uniform buffer of 64 KB holds: only the last one
+  // is moved onto the right half, the others are moved out of the view.
+  const int kNumInstances = 1500;
+  const std::vector<Eigen::Matrix4f> model_matrices(
+      kNumInstances, Eigen::Matrix4f::Identity());
+
+  for (const JointPaletteBuffer palette_buffer :
+       {JointPaletteBuffer::UNIFORM_BUFFER,
+        JointPaletteBuffer::STORAGE_BUFFER}) {
+    if (!SkinnedMeshRenderer::IsSupported(palette_buffer)) continue;
+    for (const SkinningMethod method :
+         {SkinningMethod::LINEAR_BLEND, SkinningMethod::DUAL_QUATERNION}) {
+      SCOPED_TRACE(static_cast<int>(palette_buffer) * 2 +
+                   static_cast<int>(method));
+      SkinnedMeshRenderer renderer;
+      ASSERT_TRUE(renderer.Initialize(method, palette_buffer,
+                                      &error_info_log)) << error_info_log;
+      const int mesh_id = renderer.AddMesh(vertices, influences, indices);
+      const Skeleton skeleton = CreateTwoJointSkeleton();
+      TransformStore local_poses;
+      for (int i = 0; i < kNumInstances; ++i) {
+        for (const Joint& joint : skeleton.joints) {
+          local_poses.positions.push_back(joint.position);
+          local_poses.rotations.push_back(joint.rotation);
+          local_poses.scales.push_back(joint.scale);
+        }
+        local_poses.positions[2 * i] = i + 1 == kNumInstances ?
+            Eigen::Vector3f(1.0f, 0.0f, 0.0f) :
+            Eigen::Vector3f(10.0f, 0.0f, 0.0f);
+      }
+      const int num_floats_per_instance =
+          4 * NumPaletteVectorsPerJoint(method) * skeleton.joints.size();
+      std::vector<GLfloat> palette(num_floats_per_instance * kNumInstances);
+      std::vector<Eigen::Matrix4f> global_matrices;
+      for (int i = 0; i < kNumInstances; ++i) {
+        ComputeJointPalette(skeleton, local_poses, 2 * i, method,
+                            &global_matrices,
+                            &palette[num_floats_per_instance * i]);
+      }
+
+      framebuffer.Bind();
+      glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+      renderer.Draw(mesh_id, skeleton.joints.size(), model_matrices,
+                    palette.data(), Eigen::Matrix4f::Identity(),
+                    Eigen::Matrix4f::Identity(), texture_id);
+      framebuffer.Unbind();
+      std::vector<uint8_t> rgba_pixels;
+      framebuffer.ReadPixels(&rgba_pixels);
+      EXPECT_EQ(glGetError(), GL_NO_ERROR);
+      // The triangle was moved from the left half to the right half.
+      EXPECT_EQ(rgba_pixels[4 * (8 * 32 + 4)], 0);
+      EXPECT_EQ(rgba_pixels[4 * (8 * 32 + 20)], 255);
+    }
+  }
+  glDeleteTextures(1, &texture_id);
+}
+
 }  // namespace wvu
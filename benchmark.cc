@@ -0,0 +1,210 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#include "benchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <glog/logging.h>
+
+namespace wvu {
+namespace {
+
+double ComputeMedian(std::vector<double> samples) {
+  const size_t middle = samples.size() / 2;
+  std::nth_element(samples.begin(), samples.begin() + middle, samples.end());
+  if (samples.size() % 2 == 1) return samples[middle];
+  const double upper = samples[middle];
+  const double lower =
+      *std::max_element(samples.begin(), samples.begin() + middle);
+  return 0.5 * (lower + upper);
+}
+
+// Returns the milliseconds it takes to run the iterations.
+double TimeIterations(const std::function<void(int)>& run,
+                      const int num_iterations) {
+  const auto start = std::chrono::steady_clock::now();
+  run(num_iterations);
+  const auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+}  // namespace
+
+SampleSummary SummarizeSamples(const std::vector<double>& samples) {
+  CHECK(!samples.empty());
+  SampleSummary summary;
+  summary.num_samples = samples.size();
+  summary.min = *std::min_element(samples.begin(), samples.end());
+  summary.median = ComputeMedian(samples);
+  double sum = 0.0;
+  for (const double sample : samples) sum += sample;
+  summary.mean = sum / samples.size();
+  double squared_sum = 0.0;
+  std::vector<double> deviations;
+  for (const double sample : samples) {
+    squared_sum += (sample - summary.mean) * (sample - summary.mean);
+    deviations.push_back(std::abs(sample - summary.median));
+  }
+  summary.standard_deviation = samples.size() > 1 ?
+      std::sqrt(squared_sum / (samples.size() - 1)) : 0.0;
+  summary.median_absolute_deviation = ComputeMedian(deviations);
+  return summary;
+}
+
+double ComputeThroughput(const BenchmarkResult& result,
+                         const BenchmarkCounter& counter) {
+  const double seconds_per_iteration =
+      result.ns_per_item.median * result.items_per_iteration * 1e-9;
+  return counter.per_iteration / seconds_per_iteration;
+}
+
+BenchmarkSuite::BenchmarkSuite(const BenchmarkOptions& options) :
+    options_(options) {
+  CHECK_GT(options_.num_repetitions, 0);
+}
+
+void BenchmarkSuite::Add(const std::string& name,
+                         const int items_per_iteration,
+                         const std::function<void(int)>& run,
+                         const std::vector<BenchmarkCounter>& counters) {
+  CHECK_GT(items_per_iteration, 0);
+  benchmarks_.push_back({name, items_per_iteration, run, counters});
+}
+
+void BenchmarkSuite::Run(const std::string& filter) {
+  for (const Benchmark& benchmark : benchmarks_) {
+    if (benchmark.name.find(filter) == std::string::npos) continue;
+    // Double the iterations until a repetition is long enough for the clock
+    // resolution and the loop overhead not to matter.
+    int num_iterations = 1;
+    while (num_iterations < (1 << 30) &&
+           TimeIterations(benchmark.run, num_iterations) <
+           options_.min_repetition_time_ms) {
+      num_iterations *= 2;
+    }
+    for (int i = 0; i < options_.num_warmup_repetitions; ++i) {
+      TimeIterations(benchmark.run, num_iterations);
+    }
+    std::vector<double> samples;
+    const double num_items =
+        static_cast<double>(num_iterations) * benchmark.items_per_iteration;
+    for (int i = 0; i < options_.num_repetitions; ++i) {
+      samples.push_back(
+          TimeIterations(benchmark.run, num_iterations) * 1e6 / num_items);
+    }
+    BenchmarkResult result;
+    result.name = benchmark.name;
+    result.num_iterations = num_iterations;
+    result.items_per_iteration = benchmark.items_per_iteration;
+    result.ns_per_item = SummarizeSamples(samples);
+    result.counters = benchmark.counters;
+    results_.push_back(result);
+  }
+}
+
+void BenchmarkSuite::PrintTable(std::ostream* stream) const {
+  if (stream == nullptr) return;
+  size_t name_width = 9;
+  for (const BenchmarkResult& result : results_) {
+    name_width = std::max(name_width, result.name.size());
+  }
+  *stream << std::left << std::setw(name_width) << "Benchmark" << std::right
+          << std::setw(14) << "median ns" << std::setw(12) << "MAD ns"
+          << std::setw(14) << "min ns" << std::setw(14) << "items/s"
+          << "  throughput\n";
+  *stream << std::fixed << std::setprecision(2);
+  for (const BenchmarkResult& result : results_) {
+    const SampleSummary& summary = result.ns_per_item;
+    *stream << std::left << std::setw(name_width) << result.name << std::right
+            << std::setw(14) << summary.median
+            << std::setw(12) << summary.median_absolute_deviation
+            << std::setw(14) << summary.min
+            << std::setw(14) << std::setprecision(3) << std::scientific
+            << 1e9 / summary.median << std::fixed << std::setprecision(2);
+    for (const BenchmarkCounter& counter : result.counters) {
+      *stream << "  " << ComputeThroughput(result, counter) << " "
+              << counter.unit << "/s";
+    }
+    *stream << "\n";
+  }
+  stream->unsetf(std::ios_base::floatfield);
+}
+
+std::string BenchmarkSuite::ToJson() const {
+  std::ostringstream json;
+  json << std::setprecision(9);
+  json << "{\n  \"options\": {\"num_warmup_repetitions\": "
+       << options_.num_warmup_repetitions
+       << ", \"num_repetitions\": " << options_.num_repetitions
+       << ", \"min_repetition_time_ms\": " << options_.min_repetition_time_ms
+       << "},\n  \"benchmarks\": [";
+  for (int i = 0; i < results_.size(); ++i) {
+    const BenchmarkResult& result = results_[i];
+    const SampleSummary& summary = result.ns_per_item;
+    // The names are identifiers: no characters need escaping.
+    json << (i > 0 ? "," : "") << "\n    {\"name\": \"" << result.name
+         << "\", \"num_iterations\": " << result.num_iterations
+         << ", \"items_per_iteration\": " << result.items_per_iteration
+         << ", \"num_samples\": " << summary.num_samples
+         << ", \"ns_per_item\": {\"min\": " << summary.min
+         << ", \"median\": " << summary.median
+         << ", \"mean\": " << summary.mean
+         << ", \"standard_deviation\": " << summary.standard_deviation
+         << ", \"median_absolute_deviation\": "
+         << summary.median_absolute_deviation << "}";
+    if (!result.counters.empty()) {
+      json << ", \"throughput\": {";
+      for (int j = 0; j < result.counters.size(); ++j) {
+        const BenchmarkCounter& counter = result.counters[j];
+        json << (j > 0 ? ", " : "") << "\"" << counter.unit << "/s\": "
+             << ComputeThroughput(result, counter);
+      }
+      json << "}";
+    }
+    json << "}";
+  }
+  json << "\n  ]\n}\n";
+  return json.str();
+}
+
+}  // namespace wvu
@@ -0,0 +1,165 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef BENCHMARK_H_
+#define BENCHMARK_H_
+
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace wvu {
+
+// Robust summary of a set of timing samples. The median and the median
+// absolute deviation (MAD) are the statistics to compare runs with; the mean
+// and the standard deviation are skewed by the outliers (preemptions, page
+// faults) that every timing has.
+struct SampleSummary {
+  int num_samples;
+  double min;
+  double median;
+  double mean;
+  double standard_deviation;
+  double median_absolute_deviation;
+};
+
+// Computes the summary of a non-empty set of samples.
+SampleSummary SummarizeSamples(const std::vector<double>& samples);
+
+// Keeps the compiler from optimizing away a computation whose result is
+// unused by the benchmark.
+template <typename T>
+inline void DoNotOptimize(const T& value) {
+  asm volatile("" : : "r"(&value) : "memory");
+}
+
+// Options of a BenchmarkSuite.
+struct BenchmarkOptions {
+  BenchmarkOptions() :
+      num_warmup_repetitions(2), num_repetitions(10),
+      min_repetition_time_ms(20.0) {}
+  // Repetitions run and discarded before the measured ones.
+  int num_warmup_repetitions;
+  // Measured repetitions, i.e., the number of samples of a benchmark.
+  int num_repetitions;
+  // The number of iterations of a repetition is calibrated so that a
+  // repetition runs for at least this long.
+  double min_repetition_time_ms;
+};
+
+// An amount of work an iteration of a benchmark does besides its items,
+// e.g., 2.5 "MB" parsed or 4096 "triangles" uploaded. The suite reports it as
+// a throughput (e.g., MB/s) at the median time.
+struct BenchmarkCounter {
+  std::string unit;
+  double per_iteration;
+};
+
+// Result of a benchmark. The samples are in nanoseconds per item.
+struct BenchmarkResult {
+  std::string name;
+  // Iterations per repetition, as calibrated.
+  int num_iterations;
+  // Work items (e.g., matrices) per iteration.
+  int items_per_iteration;
+  SampleSummary ns_per_item;
+  std::vector<BenchmarkCounter> counters;
+};
+
+// Returns the throughput of the counter, in units per second, at the median
+// time of the result.
+double ComputeThroughput(const BenchmarkResult& result,
+                         const BenchmarkCounter& counter);
+
+// A minimal benchmark harness. Every benchmark is a function running a given
+// number of iterations of the measured code; the suite calibrates the number
+// of iterations, runs the warmup and the measured repetitions, and
+// summarizes the time per item. Usage example:
+//
+// wvu::BenchmarkSuite suite(options);
+// suite.Add("ComputeScalingMatrix", 1, [](const int num_iterations) {
+//   for (int i = 0; i < num_iterations; ++i) {
+//     wvu::DoNotOptimize(wvu::ComputeScalingMatrix(2.0f));
+//   }
+// });
+// suite.Run("Scaling");
+// suite.PrintTable(&std::cout);
+class BenchmarkSuite {
+ public:
+  explicit BenchmarkSuite(const BenchmarkOptions& options);
+
+  // Registers a benchmark.
+  // Params:
+  //   name  The name of the benchmark.
+  //   items_per_iteration  The number of work items an iteration processes.
+  //   run  Runs the given number of iterations.
+  //   counters  The additional work an iteration does, reported as
+  //     throughputs.
+  void Add(const std::string& name,
+           const int items_per_iteration,
+           const std::function<void(int)>& run,
+           const std::vector<BenchmarkCounter>& counters =
+               std::vector<BenchmarkCounter>());
+
+  // Runs the benchmarks whose name contains the filter (all of them when it
+  // is empty), in the order they were added.
+  void Run(const std::string& filter);
+
+  // Prints the results as a table.
+  void PrintTable(std::ostream* stream) const;
+
+  // Returns the results and the options as a JSON document.
+  std::string ToJson() const;
+
+  const std::vector<BenchmarkResult>& results() const {
+    return results_;
+  }
+
+ private:
+  struct Benchmark {
+    std::string name;
+    int items_per_iteration;
+    std::function<void(int)> run;
+    std::vector<BenchmarkCounter> counters;
+  };
+
+  const BenchmarkOptions options_;
+  std::vector<Benchmark> benchmarks_;
+  std::vector<BenchmarkResult> results_;
+};
+
+}  // namespace wvu
+
+#endif  // BENCHMARK_H_
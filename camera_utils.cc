@@ -85,5 +85,20 @@ Eigen::Matrix4f ComputePerspectiveProjectionMatrix(const GLfloat field_of_view,
   return projection_matrix;
 }
 
-}  // namespace wvu
+Eigen::Matrix4f ComputeOrthographicProjectionMatrix(const GLfloat left,
+                                                    const GLfloat right,
+                                                    const GLfloat bottom,
+                                                    const GLfloat top,
+                                                    const GLfloat near,
+                                                    const GLfloat far) {
+  Eigen::Matrix4f projection = Eigen::Matrix4f::Identity();
+  projection(0, 0) = 2.0f / (right - left);
+  projection(1, 1) = 2.0f / (top - bottom);
+  projection(2, 2) = -2.0f / (far - near);
+  projection(0, 3) = -(right + left) / (right - left);
+  projection(1, 3) = -(top + bottom) / (top - bottom);
+  projection(2, 3) = -(far + near) / (far - near);
+  return projection;
+}
 
+}  // namespace wvu
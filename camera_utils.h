@@ -49,6 +49,23 @@ Eigen::Matrix4f ComputePerspectiveProjectionMatrix(const GLfloat field_of_view,
                                                    const GLfloat aspect_ratio,
                                                    const GLfloat near,
                                                    const GLfloat far);
+
+// Computes an orthographic projection matrix that maps the box
+// [left, right] x [bottom, top] x [-far, -near] in camera coordinates into the
+// canonical view volume.
+// Params:
+//   left  The left plane of the box.
+//   right  The right plane of the box.
+//   bottom  The bottom plane of the box.
+//   top  The top plane of the box.
+//   near  The near distance plane.
+//   far  The far distance plane.
+Eigen::Matrix4f ComputeOrthographicProjectionMatrix(const GLfloat left,
+                                                    const GLfloat right,
+                                                    const GLfloat bottom,
+                                                    const GLfloat top,
+                                                    const GLfloat near,
+                                                    const GLfloat far);
 }  // namespace wvu
 
 #endif  // CAMERA_UTILS_H_
@@ -0,0 +1,403 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#include "cooked_assets.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <Eigen/Core>
+#include <GL/glew.h>
+
+#include "packing.h"
+#include "texture_compression.h"
+
+namespace wvu {
+namespace {
+// FNV-1a constants.
+constexpr uint64_t kFnvOffsetBasis = 14695981039346656037ull;
+constexpr uint64_t kFnvPrime = 1099511628211ull;
+// Number of floats per vertex (see Model::SetVBO).
+constexpr int kNumFloatsPerVertex = 8;
+
+struct CookedMeshHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t num_vertices;
+  uint32_t num_indices;
+  float bounds_min[3];
+  float bounds_extent[3];
+};
+static_assert(sizeof(CookedMeshHeader) == 40, "Unexpected padding.");
+
+struct CookedVertex {
+  uint16_t position[3];
+  uint16_t padding;
+  uint32_t color;
+  uint32_t texel;
+};
+static_assert(sizeof(CookedVertex) == 16, "Unexpected padding.");
+
+struct CookedTextureHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t format;
+  uint32_t num_levels;
+};
+
+struct CookedLevelHeader {
+  uint32_t width;
+  uint32_t height;
+  uint32_t size;
+};
+
+// Indices fit in 16 bits when every vertex can be addressed with them.
+bool UsesShortIndices(const uint32_t num_vertices) {
+  return num_vertices <= 65536;
+}
+
+template <typename T>
+void Append(const T& value, std::string* bytes) {
+  bytes->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+// Reads a value and advances the offset. Returns false past the end.
+template <typename T>
+bool Consume(const char* data, const size_t size, size_t* offset, T* value) {
+  if (*offset + sizeof(*value) > size) return false;
+  std::memcpy(value, data + *offset, sizeof(*value));
+  *offset += sizeof(*value);
+  return true;
+}
+
+}  // namespace
+
+uint64_t HashBytes(const std::string& bytes) {
+  uint64_t hash = kFnvOffsetBasis;
+  for (const char byte : bytes) {
+    hash ^= static_cast<uint8_t>(byte);
+    hash *= kFnvPrime;
+  }
+  return hash;
+}
+
+bool ReadFileContents(const std::string& filepath, std::string* contents) {
+  if (contents == nullptr) return false;
+  std::ifstream in(filepath, std::ios::binary);
+  if (!in.is_open()) return false;
+  std::stringstream string_buffer;
+  string_buffer << in.rdbuf();
+  *contents = string_buffer.str();
+  return true;
+}
+
+bool WriteFileContents(const std::string& filepath,
+                       const std::string& contents) {
+  const std::string temporary_filepath = filepath + ".tmp";
+  {
+    std::ofstream out(temporary_filepath, std::ios::binary);
+    if (!out.is_open()) return false;
+    out.write(contents.data(), contents.size());
+    if (!out.good()) return false;
+  }
+  return std::rename(temporary_filepath.c_str(), filepath.c_str()) == 0;
+}
+
+void EncodeCookedMesh(const Eigen::MatrixXf& vertices,
+                      const std::vector<GLuint>& indices,
+                      std::string* bytes) {
+  if (bytes == nullptr) return;
+  CookedMeshHeader header;
+  std::memcpy(header.magic, "WVUM", 4);
+  header.version = kCookedAssetVersion;
+  header.num_vertices = vertices.cols();
+  header.num_indices = indices.size();
+  Eigen::Vector3f bounds_min = Eigen::Vector3f::Zero();
+  Eigen::Vector3f bounds_extent = Eigen::Vector3f::Zero();
+  if (vertices.cols() > 0) {
+    bounds_min = vertices.topRows<3>().rowwise().minCoeff();
+    bounds_extent = vertices.topRows<3>().rowwise().maxCoeff() - bounds_min;
+  }
+  std::copy(bounds_min.data(), bounds_min.data() + 3, header.bounds_min);
+  std::copy(bounds_extent.data(), bounds_extent.data() + 3,
+            header.bounds_extent);
+
+  bytes->clear();
+  bytes->reserve(sizeof(header) + vertices.cols() * sizeof(CookedVertex) +
+                 indices.size() * sizeof(uint32_t));
+  Append(header, bytes);
+  for (int i = 0; i < vertices.cols(); ++i) {
+    CookedVertex vertex;
+    for (int j = 0; j < 3; ++j) {
+      const float normalized = bounds_extent[j] > 0.0f ?
+          (vertices(j, i) - bounds_min[j]) / bounds_extent[j] : 0.0f;
+      vertex.position[j] = std::round(
+          65535.0f * std::min(std::max(normalized, 0.0f), 1.0f));
+    }
+    vertex.padding = 0;
+    vertex.color = PackUnorm4x8(Eigen::Vector4f(
+        vertices(3, i), vertices(4, i), vertices(5, i), 1.0f));
+    vertex.texel = PackHalf2x16(vertices(6, i), vertices(7, i));
+    Append(vertex, bytes);
+  }
+  if (UsesShortIndices(header.num_vertices)) {
+    for (const GLuint index : indices) {
+      Append(static_cast<uint16_t>(index), bytes);
+    }
+  } else {
+    for (const GLuint index : indices) {
+      Append(static_cast<uint32_t>(index), bytes);
+    }
+  }
+}
+
+bool DecodeCookedMesh(const char* data,
+                      const size_t size,
+                      Eigen::MatrixXf* vertices,
+                      std::vector<GLuint>* indices,
+                      std::string* error_info_log) {
+  if (vertices == nullptr || indices == nullptr) return false;
+  size_t offset = 0;
+  CookedMeshHeader header;
+  if (!Consume(data, size, &offset, &header) ||
+      std::memcmp(header.magic, "WVUM", 4) != 0) {
+    if (error_info_log != nullptr) *error_info_log = "Not a cooked mesh.";
+    return false;
+  }
+  if (header.version != kCookedAssetVersion) {
+    if (error_info_log != nullptr) {
+      *error_info_log = "Unsupported cooked mesh version " +
+          std::to_string(header.version) + ".";
+    }
+    return false;
+  }
+  const size_t index_size =
+      UsesShortIndices(header.num_vertices) ? sizeof(uint16_t) :
+      sizeof(uint32_t);
+  if (size - offset != header.num_vertices * sizeof(CookedVertex) +
+      header.num_indices * index_size) {
+    if (error_info_log != nullptr) *error_info_log = "Truncated cooked mesh.";
+    return false;
+  }
+  vertices->resize(kNumFloatsPerVertex, header.num_vertices);
+  for (int i = 0; i < header.num_vertices; ++i) {
+    CookedVertex vertex;
+    if (!Consume(data, size, &offset, &vertex)) {
+      if (error_info_log != nullptr) *error_info_log = "Truncated cooked mesh.";
+      return false;
+    }
+    for (int j = 0; j < 3; ++j) {
+      (*vertices)(j, i) = header.bounds_min[j] +
+          header.bounds_extent[j] * (vertex.position[j] / 65535.0f);
+    }
+    vertices->block<3, 1>(3, i) = UnpackUnorm4x8(vertex.color).head<3>();
+    vertices->block<2, 1>(6, i) = UnpackHalf2x16(vertex.texel);
+  }
+  indices->resize(header.num_indices);
+  for (GLuint& index : *indices) {
+    bool has_index;
+    if (index_size == sizeof(uint16_t)) {
+      uint16_t short_index = 0;
+      has_index = Consume(data, size, &offset, &short_index);
+      index = short_index;
+    } else {
+      uint32_t long_index = 0;
+      has_index = Consume(data, size, &offset, &long_index);
+      index = long_index;
+    }
+    if (!has_index) {
+      if (error_info_log != nullptr) *error_info_log = "Truncated cooked mesh.";
+      return false;
+    }
+    if (index >= header.num_vertices) {
+      if (error_info_log != nullptr) {
+        *error_info_log = "Cooked mesh index out of range.";
+      }
+      return false;
+    }
+  }
+  return true;
+}
+
+void EncodeCookedTexture(const CookedTexture& texture, std::string* bytes) {
+  if (bytes == nullptr) return;
+  CookedTextureHeader header;
+  std::memcpy(header.magic, "WVUT", 4);
+  header.version = kCookedAssetVersion;
+  header.format = static_cast<uint32_t>(texture.format);
+  header.num_levels = texture.levels.size();
+  bytes->clear();
+  Append(header, bytes);
+  for (const MipLevel& level : texture.levels) {
+    CookedLevelHeader level_header;
+    level_header.width = level.width;
+    level_header.height = level.height;
+    level_header.size = level.data.size();
+    Append(level_header, bytes);
+    bytes->append(reinterpret_cast<const char*>(level.data.data()),
+                  level.data.size());
+  }
+}
+
+bool DecodeCookedTexture(const char* data,
+                         const size_t size,
+                         CookedTexture* texture,
+                         std::string* error_info_log) {
+  if (texture == nullptr) return false;
+  size_t offset = 0;
+  CookedTextureHeader header;
+  if (!Consume(data, size, &offset, &header) ||
+      std::memcmp(header.magic, "WVUT", 4) != 0 ||
+      header.version != kCookedAssetVersion ||
+      header.format > static_cast<uint32_t>(CookedTextureFormat::BC1)) {
+    if (error_info_log != nullptr) {
+      *error_info_log = "Not a supported cooked texture.";
+    }
+    return false;
+  }
+  // Every level takes at least its header, which bounds the number of levels
+  // before allocating them.
+  if (header.num_levels > (size - offset) / sizeof(CookedLevelHeader)) {
+    if (error_info_log != nullptr) {
+      *error_info_log = "Truncated cooked texture.";
+    }
+    return false;
+  }
+  texture->format = static_cast<CookedTextureFormat>(header.format);
+  texture->levels.resize(header.num_levels);
+  for (MipLevel& level : texture->levels) {
+    CookedLevelHeader level_header;
+    if (!Consume(data, size, &offset, &level_header) ||
+        offset + level_header.size > size) {
+      if (error_info_log != nullptr) {
+        *error_info_log = "Truncated cooked texture.";
+      }
+      return false;
+    }
+    // The sizes are computed in 64 bits so that they cannot wrap around, and
+    // the dimensions have to fit the ints of MipLevel.
+    const uint64_t width = level_header.width;
+    const uint64_t height = level_header.height;
+    const uint64_t expected_size =
+        texture->format == CookedTextureFormat::BC1 ?
+        8 * ((width + 3) / 4) * ((height + 3) / 4) :
+        3 * width * height;
+    if (width > std::numeric_limits<int>::max() ||
+        height > std::numeric_limits<int>::max() ||
+        level_header.size != expected_size) {
+      if (error_info_log != nullptr) {
+        *error_info_log = "Corrupted cooked texture level.";
+      }
+      return false;
+    }
+    level.width = level_header.width;
+    level.height = level_header.height;
+    level.data.assign(data + offset, data + offset + level_header.size);
+    offset += level_header.size;
+  }
+  return true;
+}
+
+bool CookManifest::Load(const std::string& filepath,
+                        std::string* error_info_log) {
+  entries_.clear();
+  std::ifstream in(filepath);
+  // Nothing was cooked yet.
+  if (!in.is_open()) return true;
+  std::string line;
+  int line_number = 0;
+  while (std::getline(in, line)) {
+    ++line_number;
+    if (line.empty()) continue;
+    const size_t first_tab = line.find('\t');
+    const size_t second_tab = line.find('\t', first_tab + 1);
+    if (first_tab == std::string::npos || second_tab == std::string::npos) {
+      if (error_info_log != nullptr) {
+        *error_info_log = "Malformed manifest line " +
+            std::to_string(line_number) + " in " + filepath;
+      }
+      return false;
+    }
+    Entry entry;
+    entry.hash = std::strtoull(line.substr(0, first_tab).c_str(), nullptr, 16);
+    entry.output_filepath = line.substr(second_tab + 1);
+    entries_[line.substr(first_tab + 1, second_tab - first_tab - 1)] = entry;
+  }
+  return true;
+}
+
+bool CookManifest::Save(const std::string& filepath,
+                        std::string* error_info_log) const {
+  // Sorted, so that the manifest diffs well.
+  const std::map<std::string, Entry> sorted_entries(entries_.begin(),
+                                                    entries_.end());
+  std::string contents;
+  char hash[17];
+  for (const auto& entry : sorted_entries) {
+    std::snprintf(hash, sizeof(hash), "%016llx",
+                  static_cast<unsigned long long>(entry.second.hash));
+    contents += std::string(hash) + "\t" + entry.first + "\t" +
+        entry.second.output_filepath + "\n";
+  }
+  if (!WriteFileContents(filepath, contents)) {
+    if (error_info_log != nullptr) {
+      *error_info_log = "Could not write the manifest " + filepath;
+    }
+    return false;
+  }
+  return true;
+}
+
+bool CookManifest::IsUpToDate(const std::string& input_filepath,
+                              const uint64_t hash) const {
+  const auto entry = entries_.find(input_filepath);
+  return entry != entries_.end() && entry->second.hash == hash;
+}
+
+void CookManifest::Set(const std::string& input_filepath,
+                       const std::string& output_filepath,
+                       const uint64_t hash) {
+  entries_[input_filepath] = {hash, output_filepath};
+}
+
+}  // namespace wvu
@@ -0,0 +1,156 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef COOKED_ASSETS_H_
+#define COOKED_ASSETS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <Eigen/Core>
+#include <GL/glew.h>
+
+#include "texture_compression.h"
+
+namespace wvu {
+
+// Version of the cooked formats. Bumping it invalidates every cooked asset.
+constexpr uint32_t kCookedAssetVersion = 1;
+
+// Pixel formats of a cooked texture.
+enum struct CookedTextureFormat {
+  // Interleaved RGB8 pixels.
+  RGB8 = 0,
+  // BC1 (DXT1) blocks; see CompressBc1.
+  BC1 = 1
+};
+
+// A decoded cooked texture: its mipmap chain, the largest level first.
+struct CookedTexture {
+  CookedTextureFormat format;
+  std::vector<MipLevel> levels;
+};
+
+// Returns the 64-bit FNV-1a hash of the bytes.
+uint64_t HashBytes(const std::string& bytes);
+
+// Reads a whole file. Returns true upon success and false otherwise.
+bool ReadFileContents(const std::string& filepath, std::string* contents);
+
+// Writes a whole file. The contents go to a temporary file first, which is
+// then renamed, so that readers never see a partially written file. Returns
+// true upon success and false otherwise.
+bool WriteFileContents(const std::string& filepath,
+                       const std::string& contents);
+
+// Encodes a mesh in the cooked mesh format ("WVUM"):
+//   - A header with the magic, the version, the number of vertices and of
+//     indices, and the bounding box of the positions.
+//   - 16 bytes per vertex: the position as 16-bit unorms relative to the
+//     bounding box, two bytes of padding, the color as RGBA8, and the texel as
+//     two half floats.
+//   - The indices, as 16-bit integers when the vertices allow it or as
+//     32-bit integers otherwise.
+// The data is little-endian, as the files are only meant for this machine.
+// Params:
+//   vertices  The 8 x n vertex matrix with the layout of Model::SetVBO.
+//   indices  The triangle indices.
+//   bytes  The encoded mesh.
+void EncodeCookedMesh(const Eigen::MatrixXf& vertices,
+                      const std::vector<GLuint>& indices,
+                      std::string* bytes);
+
+// Decodes a mesh encoded by EncodeCookedMesh. Returns true upon success and
+// false otherwise.
+// Params:
+//   data  The encoded mesh.
+//   size  The number of bytes of the encoded mesh.
+//   vertices  The 8 x n vertex matrix with the layout of Model::SetVBO.
+//   indices  The triangle indices.
+//   error_info_log  A pointer to a string that holds the error log.
+bool DecodeCookedMesh(const char* data,
+                      const size_t size,
+                      Eigen::MatrixXf* vertices,
+                      std::vector<GLuint>* indices,
+                      std::string* error_info_log);
+
+// Encodes a texture in the cooked texture format ("WVUT"): a header with the
+// magic, the version, the pixel format, and the number of levels, followed
+// by the size and the data of every level.
+void EncodeCookedTexture(const CookedTexture& texture, std::string* bytes);
+
+// Decodes a texture encoded by EncodeCookedTexture. Returns true upon success
+// and false otherwise.
+bool DecodeCookedTexture(const char* data,
+                         const size_t size,
+                         CookedTexture* texture,
+                         std::string* error_info_log);
+
+// The manifest of the cooker: for every input file, the hash of what it was
+// cooked from (its contents and the cooking options) and the cooked file.
+// An input is cooked again only when its hash changes. It is stored as a
+// text file with one tab-separated "hash input output" line per input.
+class CookManifest {
+ public:
+  // Loads the manifest. A missing file is an empty manifest. Returns true
+  // upon success and false otherwise.
+  bool Load(const std::string& filepath, std::string* error_info_log);
+
+  // Saves the manifest. Returns true upon success and false otherwise.
+  bool Save(const std::string& filepath, std::string* error_info_log) const;
+
+  // Returns true when the input was cooked from contents with the given hash.
+  bool IsUpToDate(const std::string& input_filepath,
+                  const uint64_t hash) const;
+
+  // Records that the input was cooked into the output.
+  void Set(const std::string& input_filepath,
+           const std::string& output_filepath,
+           const uint64_t hash);
+
+  int num_entries() const { return entries_.size(); }
+
+ private:
+  struct Entry {
+    uint64_t hash;
+    std::string output_filepath;
+  };
+  std::unordered_map<std::string, Entry> entries_;
+};
+
+}  // namespace wvu
+
+#endif  // COOKED_ASSETS_H_
@@ -0,0 +1,245 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#include "debug_draw.h"
+
+#if WVU_DEBUG_DRAW
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <Eigen/Core>
+#include <Eigen/LU>
+#include <GL/glew.h>
+
+#include "camera.h"
+#include "packing.h"
+#include "shader_program.h"
+
+namespace wvu {
+namespace {
+// Number of line segments of every circle of a sphere.
+constexpr int kNumCircleSegments = 32;
+
+const std::string vertex_shader_src =
+    "#version 330 core\n"
+    "layout (location = 0) in vec3 position;\n"
+    "layout (location = 1) in vec4 passed_color;\n"
+    "uniform mat4 view_projection;\n"
+    "out vec4 line_color;\n"
+    "void main() {\n"
+    "  gl_Position = view_projection * vec4(position, 1.0f);\n"
+    "  line_color = passed_color;\n"
+    "}\n";
+
+const std::string fragment_shader_src =
+    "#version 330 core\n"
+    "in vec4 line_color;\n"
+    "out vec4 color;\n"
+    "void main() {\n"
+    "  color = line_color;\n"
+    "}\n";
+
+// Appends the 12 edges of the box with the given 8 corners. The corner i has
+// the maximum x, y, and z coordinates when the bits 0, 1, and 2 of i are set.
+void AddBoxEdges(const Eigen::Vector3f corners[8],
+                 const Eigen::Vector3f& color,
+                 const bool depth_test,
+                 DebugDraw* debug_draw) {
+  for (int i = 0; i < 8; ++i) {
+    for (int axis_bit = 1; axis_bit < 8; axis_bit <<= 1) {
+      // Every edge is added once, from the corner with the bit unset.
+      if ((i & axis_bit) == 0) {
+        debug_draw->Line(corners[i], corners[i | axis_bit], color, depth_test);
+      }
+    }
+  }
+}
+
+}  // namespace
+
+DebugDraw::DebugDraw() :
+    vertex_array_object_id_(0), vertex_buffer_object_id_(0),
+    buffer_capacity_(0) {}
+
+DebugDraw::~DebugDraw() {
+  glDeleteBuffers(1, &vertex_buffer_object_id_);
+  glDeleteVertexArrays(1, &vertex_array_object_id_);
+}
+
+bool DebugDraw::Initialize(std::string* error_info_log) {
+  shader_program_.LoadVertexShaderFromString(vertex_shader_src);
+  shader_program_.LoadFragmentShaderFromString(fragment_shader_src);
+  if (!shader_program_.Create(error_info_log)) {
+    return false;
+  }
+  glGenVertexArrays(1, &vertex_array_object_id_);
+  glGenBuffers(1, &vertex_buffer_object_id_);
+  glBindVertexArray(vertex_array_object_id_);
+  glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_object_id_);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(LineVertex),
+                        reinterpret_cast<GLvoid*>(0));
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(LineVertex),
+                        reinterpret_cast<GLvoid*>(3 * sizeof(GLfloat)));
+  glEnableVertexAttribArray(1);
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  return true;
+}
+
+void DebugDraw::Line(const Eigen::Vector3f& from,
+                     const Eigen::Vector3f& to,
+                     const Eigen::Vector3f& color,
+                     const bool depth_test) {
+  const GLuint packed_color = PackUnorm4x8(
+      Eigen::Vector4f(color.x(), color.y(), color.z(), 1.0f));
+  std::vector<LineVertex>* line_vertices = vertices(depth_test);
+  line_vertices->push_back({{from.x(), from.y(), from.z()}, packed_color});
+  line_vertices->push_back({{to.x(), to.y(), to.z()}, packed_color});
+}
+
+void DebugDraw::Box(const Eigen::Vector3f& min_corner,
+                    const Eigen::Vector3f& max_corner,
+                    const Eigen::Vector3f& color,
+                    const bool depth_test) {
+  Eigen::Vector3f corners[8];
+  for (int i = 0; i < 8; ++i) {
+    corners[i] = Eigen::Vector3f((i & 1) ? max_corner.x() : min_corner.x(),
+                                 (i & 2) ? max_corner.y() : min_corner.y(),
+                                 (i & 4) ? max_corner.z() : min_corner.z());
+  }
+  AddBoxEdges(corners, color, depth_test, this);
+}
+
+void DebugDraw::Sphere(const Eigen::Vector3f& center,
+                       const GLfloat radius,
+                       const Eigen::Vector3f& color,
+                       const bool depth_test) {
+  const GLfloat angle_step = 2.0f * M_PI / kNumCircleSegments;
+  for (int axis = 0; axis < 3; ++axis) {
+    // The circle lies in the plane of the two other axes.
+    const int u = (axis + 1) % 3;
+    const int v = (axis + 2) % 3;
+    Eigen::Vector3f previous_point = center;
+    previous_point[u] += radius;
+    for (int i = 1; i <= kNumCircleSegments; ++i) {
+      Eigen::Vector3f point = center;
+      point[u] += radius * std::cos(i * angle_step);
+      point[v] += radius * std::sin(i * angle_step);
+      Line(previous_point, point, color, depth_test);
+      previous_point = point;
+    }
+  }
+}
+
+void DebugDraw::Frustum(const Eigen::Matrix4f& view_projection,
+                        const Eigen::Vector3f& color,
+                        const bool depth_test) {
+  // The frustum is the image of the NDC cube under the inverse matrix.
+  const Eigen::Matrix4f inverse_view_projection = view_projection.inverse();
+  Eigen::Vector3f corners[8];
+  for (int i = 0; i < 8; ++i) {
+    const Eigen::Vector4f ndc_corner((i & 1) ? 1.0f : -1.0f,
+                                     (i & 2) ? 1.0f : -1.0f,
+                                     (i & 4) ? 1.0f : -1.0f,
+                                     1.0f);
+    const Eigen::Vector4f corner = inverse_view_projection * ndc_corner;
+    corners[i] = corner.head<3>() / corner.w();
+  }
+  AddBoxEdges(corners, color, depth_test, this);
+}
+
+void DebugDraw::Frustum(const Camera& camera,
+                        const Eigen::Vector3f& color,
+                        const bool depth_test) {
+  Frustum(camera.projection() * camera.look_at(), color, depth_test);
+}
+
+void DebugDraw::Axes(const Eigen::Matrix4f& model_matrix,
+                     const GLfloat size,
+                     const bool depth_test) {
+  const Eigen::Vector3f origin = model_matrix.block<3, 1>(0, 3);
+  for (int axis = 0; axis < 3; ++axis) {
+    const Eigen::Vector3f tip =
+        origin + size * model_matrix.block<3, 1>(0, axis);
+    Line(origin, tip, Eigen::Vector3f::Unit(axis), depth_test);
+  }
+}
+
+void DebugDraw::Flush(const Eigen::Matrix4f& projection,
+                      const Eigen::Matrix4f& view) {
+  const int num_depth_tested_vertices = depth_tested_vertices_.size();
+  const int num_overlay_vertices = overlay_vertices_.size();
+  if (num_depth_tested_vertices + num_overlay_vertices == 0) return;
+  // Orphan the buffer so that the driver does not wait for the draws of the
+  // previous frame. Both lists share the buffer.
+  glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_object_id_);
+  buffer_capacity_ = std::max(buffer_capacity_,
+                              num_depth_tested_vertices + num_overlay_vertices);
+  glBufferData(GL_ARRAY_BUFFER, buffer_capacity_ * sizeof(LineVertex), nullptr,
+               GL_STREAM_DRAW);
+  glBufferSubData(GL_ARRAY_BUFFER, 0,
+                  num_depth_tested_vertices * sizeof(LineVertex),
+                  depth_tested_vertices_.data());
+  glBufferSubData(GL_ARRAY_BUFFER,
+                  num_depth_tested_vertices * sizeof(LineVertex),
+                  num_overlay_vertices * sizeof(LineVertex),
+                  overlay_vertices_.data());
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  shader_program_.Use();
+  const Eigen::Matrix4f view_projection = projection * view;
+  glUniformMatrix4fv(glGetUniformLocation(shader_program_.shader_program_id(),
+                                          "view_projection"),
+                     1, GL_FALSE, view_projection.data());
+  glBindVertexArray(vertex_array_object_id_);
+  if (num_depth_tested_vertices > 0) {
+    glDrawArrays(GL_LINES, 0, num_depth_tested_vertices);
+  }
+  if (num_overlay_vertices > 0) {
+    glDisable(GL_DEPTH_TEST);
+    glDrawArrays(GL_LINES, num_depth_tested_vertices, num_overlay_vertices);
+    glEnable(GL_DEPTH_TEST);
+  }
+  glBindVertexArray(0);
+  glUseProgram(0);
+  depth_tested_vertices_.clear();
+  overlay_vertices_.clear();
+}
+
+}  // namespace wvu
+
+#endif  // WVU_DEBUG_DRAW
@@ -0,0 +1,210 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef DEBUG_DRAW_H_
+#define DEBUG_DRAW_H_
+
+// Debug drawing is compiled in debug builds only. Define WVU_DEBUG_DRAW to 0
+// or 1 to override the default.
+#ifndef WVU_DEBUG_DRAW
+#ifdef NDEBUG
+#define WVU_DEBUG_DRAW 0
+#else
+#define WVU_DEBUG_DRAW 1
+#endif
+#endif
+
+#include <string>
+#include <vector>
+#include <Eigen/Core>
+#include <GL/glew.h>
+
+#include "shader_program.h"
+
+namespace wvu {
+class Camera;
+
+// This class batches debug lines: every call appends line vertices to a
+// per-frame list, and Flush() streams the lists into a single vertex buffer
+// and draws them with at most two draw calls, one for the depth-tested lines
+// and one for the lines drawn on top of the scene.
+//
+// When WVU_DEBUG_DRAW is 0 (release builds by default) the member functions
+// are empty inline functions, so the calls and the class compile out
+// completely. Usage example:
+//
+// wvu::DebugDraw debug_draw;
+// std::string error_info_log;
+// if (!debug_draw.Initialize(&error_info_log)) {
+//   LOG(ERROR) << error_info_log;
+// }
+// while (...) {  // Rendering loop.
+//   ...  // Render the scene.
+//   debug_draw.Box(min_corner, max_corner, Eigen::Vector3f(0, 1, 0));
+//   debug_draw.Axes(model->ComputeModelMatrix(), 1.0f);
+//   debug_draw.Flush(projection, view);
+// }
+class DebugDraw {
+ public:
+#if WVU_DEBUG_DRAW
+  DebugDraw();
+  ~DebugDraw();
+
+  // Compiles the shader program and creates the streaming buffer. Returns
+  // true upon success and false otherwise.
+  // Params:
+  //   error_info_log  A pointer to a string that holds the error log.
+  bool Initialize(std::string* error_info_log);
+
+  // Adds a line segment.
+  // Params:
+  //   from, to  The end points in world coordinates.
+  //   color  The RGB color of the line.
+  //   depth_test  When false, the line is drawn on top of the scene.
+  void Line(const Eigen::Vector3f& from,
+            const Eigen::Vector3f& to,
+            const Eigen::Vector3f& color,
+            const bool depth_test = true);
+
+  // Adds the edges of an axis-aligned box.
+  // Params:
+  //   min_corner, max_corner  The corners of the box in world coordinates.
+  //   color  The RGB color of the lines.
+  //   depth_test  When false, the lines are drawn on top of the scene.
+  void Box(const Eigen::Vector3f& min_corner,
+           const Eigen::Vector3f& max_corner,
+           const Eigen::Vector3f& color,
+           const bool depth_test = true);
+
+  // Adds a sphere as three orthogonal circles.
+  // Params:
+  //   center  The center of the sphere in world coordinates.
+  //   radius  The radius of the sphere.
+  //   color  The RGB color of the lines.
+  //   depth_test  When false, the lines are drawn on top of the scene.
+  void Sphere(const Eigen::Vector3f& center,
+              const GLfloat radius,
+              const Eigen::Vector3f& color,
+              const bool depth_test = true);
+
+  // Adds the edges of the frustum of a view-projection matrix.
+  // Params:
+  //   view_projection  The projection times the view matrix.
+  //   color  The RGB color of the lines.
+  //   depth_test  When false, the lines are drawn on top of the scene.
+  void Frustum(const Eigen::Matrix4f& view_projection,
+               const Eigen::Vector3f& color,
+               const bool depth_test = true);
+
+  // Adds the edges of the frustum of a camera.
+  // Params:
+  //   camera  The camera.
+  //   color  The RGB color of the lines.
+  //   depth_test  When false, the lines are drawn on top of the scene.
+  void Frustum(const Camera& camera,
+               const Eigen::Vector3f& color,
+               const bool depth_test = true);
+
+  // Adds the x (red), y (green), and z (blue) axes of a model matrix.
+  // Params:
+  //   model_matrix  The model matrix.
+  //   size  The length of the axes before the model transformation.
+  //   depth_test  When false, the lines are drawn on top of the scene.
+  void Axes(const Eigen::Matrix4f& model_matrix,
+            const GLfloat size,
+            const bool depth_test = true);
+
+  // Draws the lines added since the last call and clears them.
+  // Params:
+  //   projection  The camera projection matrix.
+  //   view  The camera pose matrix (world -> camera transformation matrix).
+  void Flush(const Eigen::Matrix4f& projection, const Eigen::Matrix4f& view);
+
+  // Returns the number of vertices waiting to be drawn.
+  int num_vertices() const {
+    return depth_tested_vertices_.size() + overlay_vertices_.size();
+  }
+
+ private:
+  // Position and RGBA8 color of a line vertex.
+  struct LineVertex {
+    GLfloat position[3];
+    GLuint color;
+  };
+
+  // Returns the list the lines go to.
+  std::vector<LineVertex>* vertices(const bool depth_test) {
+    return depth_test ? &depth_tested_vertices_ : &overlay_vertices_;
+  }
+
+  // Lines of the current frame.
+  std::vector<LineVertex> depth_tested_vertices_;
+  std::vector<LineVertex> overlay_vertices_;
+  // Streaming buffer and its capacity in vertices.
+  GLuint vertex_array_object_id_;
+  GLuint vertex_buffer_object_id_;
+  int buffer_capacity_;
+  ShaderProgram shader_program_;
+#else
+  bool Initialize(std::string* error_info_log) { return true; }
+  void Line(const Eigen::Vector3f& from,
+            const Eigen::Vector3f& to,
+            const Eigen::Vector3f& color,
+            const bool depth_test = true) {}
+  void Box(const Eigen::Vector3f& min_corner,
+           const Eigen::Vector3f& max_corner,
+           const Eigen::Vector3f& color,
+           const bool depth_test = true) {}
+  void Sphere(const Eigen::Vector3f& center,
+              const GLfloat radius,
+              const Eigen::Vector3f& color,
+              const bool depth_test = true) {}
+  void Frustum(const Eigen::Matrix4f& view_projection,
+               const Eigen::Vector3f& color,
+               const bool depth_test = true) {}
+  void Frustum(const Camera& camera,
+               const Eigen::Vector3f& color,
+               const bool depth_test = true) {}
+  void Axes(const Eigen::Matrix4f& model_matrix,
+            const GLfloat size,
+            const bool depth_test = true) {}
+  void Flush(const Eigen::Matrix4f& projection,
+             const Eigen::Matrix4f& view) {}
+  int num_vertices() const { return 0; }
+#endif  // WVU_DEBUG_DRAW
+};
+
+}  // namespace wvu
+
+#endif  // DEBUG_DRAW_H_
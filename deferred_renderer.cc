@@ -0,0 +1,585 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#include "deferred_renderer.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <Eigen/LU>
+#include <GL/glew.h>
+
+#include "shader_program.h"
+#include "shadow_maps.h"
+
+namespace wvu {
+namespace {
+// Width and height of a lighting tile in pixels.
+constexpr int kTileSize = 16;
+// Number of texels (RGBA32F) used to describe a single light.
+constexpr int kTexelsPerLight = 2;
+
+// Texture units used by the lighting pass.
+constexpr GLint kAlbedoTextureUnit = 0;
+constexpr GLint kNormalTextureUnit = 1;
+constexpr GLint kDepthTextureUnit = 2;
+constexpr GLint kLightTextureUnit = 3;
+constexpr GLint kLightIndexTextureUnit = 4;
+constexpr GLint kTileTextureUnit = 5;
+constexpr GLint kShadowTextureUnit = 6;
+
+// The geometry pass uses the same vertex layout as the forward path (see
+// Model::SetVBO). The models do not carry normals, so the fragment shader
+// derives the face normal from the screen-space derivatives of the
+// view-space position.
+const std::string geometry_vertex_shader_src =
+    "#version 330 core\n"
+    "layout (location = 0) in vec3 position;\n"
+    "layout (location = 1) in vec3 passed_color;\n"
+    "layout (location = 2) in vec2 passed_texel;\n"
+    "uniform mat4 model;\n"
+    "uniform mat4 view;\n"
+    "uniform mat4 projection;\n"
+    "out vec3 view_position;\n"
+    "out vec2 texel;\n"
+    "void main() {\n"
+    "  vec4 position_in_view = view * model * vec4(position, 1.0f);\n"
+    "  view_position = position_in_view.xyz;\n"
+    "  texel = passed_texel;\n"
+    "  gl_Position = projection * position_in_view;\n"
+    "}\n";
+
+// Octahedral normal encoding maps the unit sphere onto the [-1, 1]^2 square,
+// so a normal fits in two channels with an almost uniform precision.
+const std::string geometry_fragment_shader_src =
+    "#version 330 core\n"
+    "in vec3 view_position;\n"
+    "in vec2 texel;\n"
+    "layout (location = 0) out vec4 albedo;\n"
+    "layout (location = 1) out vec2 encoded_normal;\n"
+    "uniform sampler2D texture_sampler;\n"
+    "vec2 SignNotZero(vec2 v) {\n"
+    "  return vec2(v.x >= 0.0f ? 1.0f : -1.0f, v.y >= 0.0f ? 1.0f : -1.0f);\n"
+    "}\n"
+    "vec2 EncodeOctahedral(vec3 n) {\n"
+    "  n /= (abs(n.x) + abs(n.y) + abs(n.z));\n"
+    "  return n.z >= 0.0f ? n.xy : (1.0f - abs(n.yx)) * SignNotZero(n.xy);\n"
+    "}\n"
+    "void main() {\n"
+    "  vec3 normal = normalize(cross(dFdx(view_position),\n"
+    "                                dFdy(view_position)));\n"
+    "  albedo = texture(texture_sampler, texel);\n"
+    "  encoded_normal = EncodeOctahedral(normal);\n"
+    "}\n";
+
+// The full-screen triangle is generated from gl_VertexID, so the lighting
+// pass does not need any vertex buffer.
+const std::string lighting_vertex_shader_src =
+    "#version 330 core\n"
+    "void main() {\n"
+    "  vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);\n"
+    "  gl_Position = vec4(2.0f * corner - 1.0f, 0.0f, 1.0f);\n"
+    "}\n";
+
+const std::string lighting_fragment_shader_src =
+    "#version 330 core\n"
+    "out vec4 color;\n"
+    "uniform sampler2D albedo_sampler;\n"
+    "uniform sampler2D normal_sampler;\n"
+    "uniform sampler2D depth_sampler;\n"
+    "uniform samplerBuffer light_sampler;\n"
+    "uniform isamplerBuffer light_index_sampler;\n"
+    "uniform isampler2D tile_sampler;\n"
+    "uniform mat4 inverse_projection;\n"
+    "uniform vec2 viewport_size;\n"
+    "uniform int tile_size;\n"
+    "uniform vec3 ambient_color;\n"
+    "uniform vec3 directional_light_direction;\n"
+    "uniform vec3 directional_light_color;\n"
+    "uniform sampler2DShadow shadow_sampler;\n"
+    "uniform int num_cascades;\n"
+    "uniform float cascade_splits[4];\n"
+    "uniform mat4 cascade_matrices[4];\n"
+    "float ComputeShadowFactor(vec3 view_position) {\n"
+    "  if (num_cascades == 0) {\n"
+    "    return 1.0f;\n"
+    "  }\n"
+    "  int cascade = 0;\n"
+    "  while (cascade < num_cascades - 1 &&\n"
+    "         -view_position.z > cascade_splits[cascade]) {\n"
+    "    ++cascade;\n"
+    "  }\n"
+    "  vec4 coords = cascade_matrices[cascade] * vec4(view_position, 1.0f);\n"
+    "  // The cascades share the atlas: keep the 2x2 PCF footprint inside the\n"
+    "  // cascade, or it reads the depths of the neighboring one.\n"
+    "  float cascade_width = 1.0f / float(num_cascades);\n"
+    "  float half_texel = 0.5f / float(textureSize(shadow_sampler, 0).x);\n"
+    "  coords.x = clamp(coords.x, float(cascade) * cascade_width + half_texel,\n"
+    "                   float(cascade + 1) * cascade_width - half_texel);\n"
+    "  return texture(shadow_sampler, coords.xyz);\n"
+    "}\n"
+    "vec3 DecodeOctahedral(vec2 e) {\n"
+    "  vec3 n = vec3(e, 1.0f - abs(e.x) - abs(e.y));\n"
+    "  float t = clamp(-n.z, 0.0f, 1.0f);\n"
+    "  n.x += n.x >= 0.0f ? -t : t;\n"
+    "  n.y += n.y >= 0.0f ? -t : t;\n"
+    "  return normalize(n);\n"
+    "}\n"
+    "void main() {\n"
+    "  ivec2 pixel = ivec2(gl_FragCoord.xy);\n"
+    "  float depth = texelFetch(depth_sampler, pixel, 0).r;\n"
+    "  vec4 albedo = texelFetch(albedo_sampler, pixel, 0);\n"
+    "  if (depth == 1.0f) {\n"
+    "    discard;\n"
+    "  }\n"
+    "  vec3 normal = DecodeOctahedral(texelFetch(normal_sampler, pixel, 0).xy);\n"
+    "  vec4 ndc = vec4(2.0f * gl_FragCoord.xy / viewport_size - 1.0f,\n"
+    "                  2.0f * depth - 1.0f, 1.0f);\n"
+    "  vec4 view_position = inverse_projection * ndc;\n"
+    "  view_position /= view_position.w;\n"
+    "  ivec2 range = texelFetch(tile_sampler, pixel / tile_size, 0).xy;\n"
+    "  vec3 lighting = ambient_color;\n"
+    "  lighting += directional_light_color *\n"
+    "      max(dot(normal, -directional_light_direction), 0.0f) *\n"
+    "      ComputeShadowFactor(view_position.xyz);\n"
+    "  for (int i = 0; i < range.y; ++i) {\n"
+    "    int light = texelFetch(light_index_sampler, range.x + i).r;\n"
+    "    vec4 position_and_radius = texelFetch(light_sampler, 2 * light);\n"
+    "    vec3 light_color = texelFetch(light_sampler, 2 * light + 1).rgb;\n"
+    "    vec3 to_light = position_and_radius.xyz - view_position.xyz;\n"
+    "    float distance = length(to_light);\n"
+    "    float falloff = clamp(1.0f - distance / position_and_radius.w,\n"
+    "                          0.0f, 1.0f);\n"
+    "    float diffuse = max(dot(normal, to_light / distance), 0.0f);\n"
+    "    lighting += light_color * diffuse * falloff * falloff;\n"
+    "  }\n"
+    "  color = vec4(albedo.rgb * lighting, 1.0f);\n"
+    "}\n";
+
+// Computes a conservative window-space rectangle (in pixels) covered by a
+// sphere given in camera coordinates. Returns false when the sphere is
+// entirely behind the camera. When the sphere crosses the near plane, the
+// rectangle covers the entire window.
+bool ComputeSphereWindowBounds(const Eigen::Vector3f& center,
+                               const GLfloat radius,
+                               const Eigen::Matrix4f& projection,
+                               const int width,
+                               const int height,
+                               Eigen::Vector4i* bounds) {
+  // Recover the near plane distance from the projection matrix.
+  const GLfloat near_plane_distance =
+      projection(2, 3) / (projection(2, 2) - 1.0f);
+  if (center.z() - radius > -near_plane_distance) {
+    return false;
+  }
+  if (center.z() + radius > -near_plane_distance) {
+    *bounds = Eigen::Vector4i(0, 0, width - 1, height - 1);
+    return true;
+  }
+  // The corners of the bounding box of the sphere are all in front of the
+  // near plane, so their projections bound the projection of the sphere.
+  Eigen::Vector2f min_ndc(1.0f, 1.0f);
+  Eigen::Vector2f max_ndc(-1.0f, -1.0f);
+  for (int corner = 0; corner < 8; ++corner) {
+    const Eigen::Vector3f offset((corner & 1) ? radius : -radius,
+                                 (corner & 2) ? radius : -radius,
+                                 (corner & 4) ? radius : -radius);
+    const Eigen::Vector4f clip =
+        projection * (center + offset).homogeneous();
+    const Eigen::Vector2f ndc = clip.head<2>() / clip.w();
+    min_ndc = min_ndc.cwiseMin(ndc);
+    max_ndc = max_ndc.cwiseMax(ndc);
+  }
+  if (min_ndc.x() > 1.0f || min_ndc.y() > 1.0f ||
+      max_ndc.x() < -1.0f || max_ndc.y() < -1.0f) {
+    return false;
+  }
+  const Eigen::Vector2f window_size(width, height);
+  const Eigen::Vector2f min_window = 0.5f *
+      (min_ndc.cwiseMax(-1.0f) + Eigen::Vector2f::Ones()).cwiseProduct(
+          window_size);
+  const Eigen::Vector2f max_window = 0.5f *
+      (max_ndc.cwiseMin(1.0f) + Eigen::Vector2f::Ones()).cwiseProduct(
+          window_size);
+  *bounds = Eigen::Vector4i(
+      static_cast<int>(min_window.x()),
+      static_cast<int>(min_window.y()),
+      std::min(static_cast<int>(max_window.x()), width - 1),
+      std::min(static_cast<int>(max_window.y()), height - 1));
+  return true;
+}
+
+// Creates a texture with the given format and attaches it to the currently
+// bound framebuffer.
+GLuint CreateAttachment(const GLenum internal_format,
+                        const GLenum format,
+                        const GLenum type,
+                        const GLenum attachment,
+                        const int width,
+                        const int height) {
+  GLuint texture_id;
+  glGenTextures(1, &texture_id);
+  glBindTexture(GL_TEXTURE_2D, texture_id);
+  glTexImage2D(GL_TEXTURE_2D, 0, internal_format, width, height, 0, format,
+               type, nullptr);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D,
+                         texture_id, 0);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  return texture_id;
+}
+
+// Creates a buffer texture that views the buffer with the given format.
+void CreateBufferTexture(const GLenum internal_format,
+                         GLuint* buffer_id,
+                         GLuint* texture_id) {
+  glGenBuffers(1, buffer_id);
+  glBindBuffer(GL_TEXTURE_BUFFER, *buffer_id);
+  glBufferData(GL_TEXTURE_BUFFER, 0, nullptr, GL_STREAM_DRAW);
+  glGenTextures(1, texture_id);
+  glBindTexture(GL_TEXTURE_BUFFER, *texture_id);
+  glTexBuffer(GL_TEXTURE_BUFFER, internal_format, *buffer_id);
+  glBindTexture(GL_TEXTURE_BUFFER, 0);
+  glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+// Replaces the contents of a buffer. Orphaning the old storage lets the
+// driver keep rendering from it while the new data is uploaded.
+template <typename T>
+void UploadBuffer(const GLuint buffer_id, const std::vector<T>& data) {
+  glBindBuffer(GL_TEXTURE_BUFFER, buffer_id);
+  // Texture buffers cannot be empty, hence the minimum size of one element.
+  const GLsizeiptr size_in_bytes =
+      std::max<size_t>(data.size(), 1) * sizeof(T);
+  glBufferData(GL_TEXTURE_BUFFER, size_in_bytes, nullptr, GL_STREAM_DRAW);
+  if (!data.empty()) {
+    glBufferSubData(GL_TEXTURE_BUFFER, 0, data.size() * sizeof(T),
+                    data.data());
+  }
+  glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+bool CreateProgram(const std::string& vertex_shader_src,
+                   const std::string& fragment_shader_src,
+                   ShaderProgram* shader_program,
+                   std::string* error_info_log) {
+  shader_program->LoadVertexShaderFromString(vertex_shader_src);
+  shader_program->LoadFragmentShaderFromString(fragment_shader_src);
+  return shader_program->Create(error_info_log);
+}
+
+}  // namespace
+
+void BinLightsIntoTiles(const std::vector<PointLight>& lights,
+                        const Eigen::Matrix4f& view,
+                        const Eigen::Matrix4f& projection,
+                        const int width,
+                        const int height,
+                        const int tile_size,
+                        std::vector<GLint>* tile_ranges,
+                        std::vector<GLint>* light_indices) {
+  const int num_tiles_x = (width + tile_size - 1) / tile_size;
+  const int num_tiles_y = (height + tile_size - 1) / tile_size;
+  const int num_tiles = num_tiles_x * num_tiles_y;
+  // Compute the tile rectangle of every light and count the lights per tile.
+  std::vector<Eigen::Vector4i> light_tiles(lights.size());
+  std::vector<bool> visible(lights.size(), false);
+  std::vector<GLint> counts(num_tiles, 0);
+  for (int i = 0; i < lights.size(); ++i) {
+    const Eigen::Vector3f center =
+        (view * lights[i].position.homogeneous()).head<3>();
+    Eigen::Vector4i bounds;
+    if (!ComputeSphereWindowBounds(center, lights[i].radius, projection,
+                                   width, height, &bounds)) {
+      continue;
+    }
+    visible[i] = true;
+    light_tiles[i] = bounds / tile_size;
+    for (int y = light_tiles[i][1]; y <= light_tiles[i][3]; ++y) {
+      for (int x = light_tiles[i][0]; x <= light_tiles[i][2]; ++x) {
+        ++counts[y * num_tiles_x + x];
+      }
+    }
+  }
+  // Prefix sum to compute the offsets of every tile list.
+  tile_ranges->resize(2 * num_tiles);
+  GLint offset = 0;
+  for (int tile = 0; tile < num_tiles; ++tile) {
+    (*tile_ranges)[2 * tile] = offset;
+    (*tile_ranges)[2 * tile + 1] = 0;
+    offset += counts[tile];
+  }
+  // Scatter the light indices into their tile lists.
+  light_indices->resize(offset);
+  for (int i = 0; i < lights.size(); ++i) {
+    if (!visible[i]) continue;
+    for (int y = light_tiles[i][1]; y <= light_tiles[i][3]; ++y) {
+      for (int x = light_tiles[i][0]; x <= light_tiles[i][2]; ++x) {
+        const int tile = y * num_tiles_x + x;
+        GLint& count = (*tile_ranges)[2 * tile + 1];
+        (*light_indices)[(*tile_ranges)[2 * tile] + count] = i;
+        ++count;
+      }
+    }
+  }
+}
+
+DeferredRenderer::DeferredRenderer() :
+    width_(0), height_(0), num_tiles_x_(0), num_tiles_y_(0),
+    gbuffer_id_(0), albedo_texture_id_(0), normal_texture_id_(0),
+    depth_texture_id_(0), light_buffer_id_(0), light_texture_id_(0),
+    light_index_buffer_id_(0), light_index_texture_id_(0),
+    tile_texture_id_(0), empty_vertex_array_object_id_(0),
+    ambient_color_(0.1f, 0.1f, 0.1f),
+    directional_light_direction_(0.0f, -1.0f, 0.0f),
+    directional_light_color_(Eigen::Vector3f::Zero()),
+    shadow_maps_(nullptr) {}
+
+DeferredRenderer::~DeferredRenderer() {
+  const GLuint textures[] = {albedo_texture_id_, normal_texture_id_,
+                             depth_texture_id_, light_texture_id_,
+                             light_index_texture_id_, tile_texture_id_};
+  glDeleteTextures(6, textures);
+  const GLuint buffers[] = {light_buffer_id_, light_index_buffer_id_};
+  glDeleteBuffers(2, buffers);
+  glDeleteFramebuffers(1, &gbuffer_id_);
+  glDeleteVertexArrays(1, &empty_vertex_array_object_id_);
+}
+
+bool DeferredRenderer::Initialize(const int width,
+                                  const int height,
+                                  std::string* error_info_log) {
+  width_ = width;
+  height_ = height;
+  num_tiles_x_ = (width_ + kTileSize - 1) / kTileSize;
+  num_tiles_y_ = (height_ + kTileSize - 1) / kTileSize;
+  if (!CreateProgram(geometry_vertex_shader_src, geometry_fragment_shader_src,
+                     &geometry_shader_program_, error_info_log)) {
+    return false;
+  }
+  if (!CreateProgram(lighting_vertex_shader_src, lighting_fragment_shader_src,
+                     &lighting_shader_program_, error_info_log)) {
+    return false;
+  }
+  if (!CreateGBuffer(error_info_log)) {
+    return false;
+  }
+  CreateBufferTexture(GL_RGBA32F, &light_buffer_id_, &light_texture_id_);
+  CreateBufferTexture(GL_R32I, &light_index_buffer_id_,
+                      &light_index_texture_id_);
+  // Per-tile (offset, count) pairs.
+  glGenTextures(1, &tile_texture_id_);
+  glBindTexture(GL_TEXTURE_2D, tile_texture_id_);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32I, num_tiles_x_, num_tiles_y_, 0,
+               GL_RG_INTEGER, GL_INT, nullptr);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glGenVertexArrays(1, &empty_vertex_array_object_id_);
+
+  // The sampler bindings never change, so they are set once.
+  const GLuint program_id = lighting_shader_program_.shader_program_id();
+  lighting_shader_program_.Use();
+  glUniform1i(glGetUniformLocation(program_id, "albedo_sampler"),
+              kAlbedoTextureUnit);
+  glUniform1i(glGetUniformLocation(program_id, "normal_sampler"),
+              kNormalTextureUnit);
+  glUniform1i(glGetUniformLocation(program_id, "depth_sampler"),
+              kDepthTextureUnit);
+  glUniform1i(glGetUniformLocation(program_id, "light_sampler"),
+              kLightTextureUnit);
+  glUniform1i(glGetUniformLocation(program_id, "light_index_sampler"),
+              kLightIndexTextureUnit);
+  glUniform1i(glGetUniformLocation(program_id, "tile_sampler"),
+              kTileTextureUnit);
+  glUniform1i(glGetUniformLocation(program_id, "shadow_sampler"),
+              kShadowTextureUnit);
+  glUniform1i(glGetUniformLocation(program_id, "tile_size"), kTileSize);
+  glUniform2f(glGetUniformLocation(program_id, "viewport_size"),
+              static_cast<GLfloat>(width_), static_cast<GLfloat>(height_));
+  glUseProgram(0);
+  return true;
+}
+
+bool DeferredRenderer::CreateGBuffer(std::string* error_info_log) {
+  glGenFramebuffers(1, &gbuffer_id_);
+  glBindFramebuffer(GL_FRAMEBUFFER, gbuffer_id_);
+  albedo_texture_id_ = CreateAttachment(GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE,
+                                        GL_COLOR_ATTACHMENT0, width_, height_);
+  normal_texture_id_ = CreateAttachment(GL_RG16F, GL_RG, GL_FLOAT,
+                                        GL_COLOR_ATTACHMENT1, width_, height_);
+  // The depth format matches the usual default framebuffer format so the
+  // depth can be blitted into it after the lighting pass.
+  depth_texture_id_ = CreateAttachment(GL_DEPTH24_STENCIL8, GL_DEPTH_STENCIL,
+                                       GL_UNSIGNED_INT_24_8,
+                                       GL_DEPTH_STENCIL_ATTACHMENT,
+                                       width_, height_);
+  const GLenum draw_buffers[] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+  glDrawBuffers(2, draw_buffers);
+  const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  if (status != GL_FRAMEBUFFER_COMPLETE) {
+    if (error_info_log) {
+      *error_info_log = "The G-buffer framebuffer is incomplete.";
+    }
+    return false;
+  }
+  return true;
+}
+
+void DeferredRenderer::BeginGeometryPass() {
+  glBindFramebuffer(GL_FRAMEBUFFER, gbuffer_id_);
+  glViewport(0, 0, width_, height_);
+  glEnable(GL_DEPTH_TEST);
+  glDisable(GL_BLEND);
+  glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  geometry_shader_program_.Use();
+}
+
+void DeferredRenderer::EndGeometryPass() {
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void DeferredRenderer::UploadLights(const std::vector<PointLight>& lights,
+                                    const Eigen::Matrix4f& view,
+                                    const Eigen::Matrix4f& projection) {
+  BinLightsIntoTiles(lights, view, projection, width_, height_, kTileSize,
+                     &tile_ranges_, &light_indices_);
+  // The lights are shaded in camera coordinates, so they are transformed
+  // once here instead of once per pixel.
+  light_data_.resize(4 * kTexelsPerLight * lights.size());
+  for (int i = 0; i < lights.size(); ++i) {
+    const Eigen::Vector4f position = view * lights[i].position.homogeneous();
+    GLfloat* light = &light_data_[4 * kTexelsPerLight * i];
+    light[0] = position.x();
+    light[1] = position.y();
+    light[2] = position.z();
+    light[3] = lights[i].radius;
+    light[4] = lights[i].color.x();
+    light[5] = lights[i].color.y();
+    light[6] = lights[i].color.z();
+    light[7] = 0.0f;
+  }
+  UploadBuffer(light_buffer_id_, light_data_);
+  UploadBuffer(light_index_buffer_id_, light_indices_);
+  glBindTexture(GL_TEXTURE_2D, tile_texture_id_);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, num_tiles_x_, num_tiles_y_,
+                  GL_RG_INTEGER, GL_INT, tile_ranges_.data());
+  glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void DeferredRenderer::LightingPass(const std::vector<PointLight>& lights,
+                                    const Eigen::Matrix4f& projection,
+                                    const Eigen::Matrix4f& view) {
+  UploadLights(lights, view, projection);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  glDisable(GL_DEPTH_TEST);
+
+  lighting_shader_program_.Use();
+  const GLuint program_id = lighting_shader_program_.shader_program_id();
+  const Eigen::Matrix4f inverse_projection = projection.inverse();
+  glUniformMatrix4fv(glGetUniformLocation(program_id, "inverse_projection"),
+                     1, GL_FALSE, inverse_projection.data());
+  glUniform3fv(glGetUniformLocation(program_id, "ambient_color"), 1,
+               ambient_color_.data());
+  const Eigen::Vector3f directional_light_direction =
+      view.block<3, 3>(0, 0) * directional_light_direction_;
+  glUniform3fv(glGetUniformLocation(program_id,
+                                    "directional_light_direction"),
+               1, directional_light_direction.data());
+  glUniform3fv(glGetUniformLocation(program_id, "directional_light_color"),
+               1, directional_light_color_.data());
+  const int num_cascades =
+      shadow_maps_ != nullptr ? shadow_maps_->num_cascades() : 0;
+  glUniform1i(glGetUniformLocation(program_id, "num_cascades"),
+              num_cascades);
+  if (num_cascades > 0) {
+    // The cascades map world coordinates, but the shading happens in camera
+    // coordinates.
+    const Eigen::Matrix4f inverse_view = view.inverse();
+    GLfloat cascade_matrices[16 * kMaxNumCascades];
+    for (int i = 0; i < num_cascades; ++i) {
+      Eigen::Map<Eigen::Matrix4f>(cascade_matrices + 16 * i) =
+          shadow_maps_->cascade_texture_matrices()[i] * inverse_view;
+    }
+    glUniformMatrix4fv(glGetUniformLocation(program_id, "cascade_matrices"),
+                       num_cascades, GL_FALSE, cascade_matrices);
+    glUniform1fv(glGetUniformLocation(program_id, "cascade_splits"),
+                 num_cascades, shadow_maps_->cascade_splits().data());
+    glActiveTexture(GL_TEXTURE0 + kShadowTextureUnit);
+    glBindTexture(GL_TEXTURE_2D, shadow_maps_->shadow_atlas_texture_id());
+  }
+
+  glActiveTexture(GL_TEXTURE0 + kAlbedoTextureUnit);
+  glBindTexture(GL_TEXTURE_2D, albedo_texture_id_);
+  glActiveTexture(GL_TEXTURE0 + kNormalTextureUnit);
+  glBindTexture(GL_TEXTURE_2D, normal_texture_id_);
+  glActiveTexture(GL_TEXTURE0 + kDepthTextureUnit);
+  glBindTexture(GL_TEXTURE_2D, depth_texture_id_);
+  glActiveTexture(GL_TEXTURE0 + kLightTextureUnit);
+  glBindTexture(GL_TEXTURE_BUFFER, light_texture_id_);
+  glActiveTexture(GL_TEXTURE0 + kLightIndexTextureUnit);
+  glBindTexture(GL_TEXTURE_BUFFER, light_index_texture_id_);
+  glActiveTexture(GL_TEXTURE0 + kTileTextureUnit);
+  glBindTexture(GL_TEXTURE_2D, tile_texture_id_);
+
+  glBindVertexArray(empty_vertex_array_object_id_);
+  glDrawArrays(GL_TRIANGLES, 0, 3);
+  glBindVertexArray(0);
+
+  // Leave texture unit zero active as Model::Draw expects.
+  for (GLint unit = kShadowTextureUnit; unit >= 0; --unit) {
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+  }
+  glEnable(GL_DEPTH_TEST);
+
+  // Forward passes (e.g., transparent objects) need the scene depth.
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, gbuffer_id_);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+  glBlitFramebuffer(0, 0, width_, height_, 0, 0, width_, height_,
+                    GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+}  // namespace wvu
@@ -0,0 +1,219 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef DEFERRED_RENDERER_H_
+#define DEFERRED_RENDERER_H_
+
+#include <string>
+#include <vector>
+#include <Eigen/Core>
+#include <GL/glew.h>
+
+#include "shader_program.h"
+
+namespace wvu {
+class CascadedShadowMaps;
+
+// A point light described in the world coordinate system.
+struct PointLight {
+  // Position of the light in the world.
+  Eigen::Vector3f position;
+  // Linear RGB color (intensity) of the light.
+  Eigen::Vector3f color;
+  // Distance at which the contribution of the light falls to zero.
+  GLfloat radius;
+};
+
+// Assigns every light to the screen tiles its bounding sphere may touch. The
+// result is a per-tile (offset, count) pair indexing into a flat list of
+// light indices, which is what the lighting pass reads. Tiles are stored in
+// row-major order starting at the lower-left corner of the window (the
+// OpenGL window convention).
+// Params:
+//   lights  The lights in world coordinates.
+//   view  The camera pose matrix (world -> camera transformation matrix).
+//   projection  The camera projection matrix.
+//   width  The width of the framebuffer in pixels.
+//   height  The height of the framebuffer in pixels.
+//   tile_size  The width and height of a tile in pixels.
+//   tile_ranges  Two entries (offset, count) per tile.
+//   light_indices  Concatenated per-tile light index lists.
+void BinLightsIntoTiles(const std::vector<PointLight>& lights,
+                        const Eigen::Matrix4f& view,
+                        const Eigen::Matrix4f& projection,
+                        const int width,
+                        const int height,
+                        const int tile_size,
+                        std::vector<GLint>* tile_ranges,
+                        std::vector<GLint>* light_indices);
+
+// This class implements a deferred shading pipeline. It is an alternative to
+// the forward path in draw_scene.cc: rather than shading every fragment of
+// every model as it is rasterized, the geometry is first rasterized into a
+// compact G-buffer and the lights are evaluated once per visible pixel.
+//
+// G-buffer layout:
+//   - Albedo: RGBA8 texture sampled from the model texture.
+//   - Normal: RG16F texture with the view-space normal in octahedral encoding.
+//   - Depth: 24-bit depth texture. The view-space position is reconstructed
+//     from it using the inverse of the projection matrix, so no position
+//     target is needed.
+//
+// The lighting pass is tiled: the lights are binned into screen tiles on the
+// CPU (see BinLightsIntoTiles) and the full-screen lighting shader only loops
+// over the lights of the tile the pixel belongs to.
+//
+// Besides the point lights, a single directional light is supported. It can
+// cast shadows from a CascadedShadowMaps instance (see shadow_maps.h).
+//
+// The geometry pass reuses Model::Draw. Usage example:
+//
+// wvu::DeferredRenderer renderer;
+// std::string error_info_log;
+// if (!renderer.Initialize(width, height, &error_info_log)) {
+//   LOG(ERROR) << error_info_log;
+// }
+// ...
+// renderer.BeginGeometryPass();
+// for (Model* model : models) {
+//   model->Draw(renderer.geometry_shader_program(), projection, view, texture);
+// }
+// renderer.EndGeometryPass();
+// renderer.LightingPass(lights, projection, view);
+class DeferredRenderer {
+ public:
+  DeferredRenderer();
+  ~DeferredRenderer();
+
+  // Creates the G-buffer and compiles the shader programs. Returns true upon
+  // success and false otherwise.
+  // Params:
+  //   width  The width of the framebuffer in pixels.
+  //   height  The height of the framebuffer in pixels.
+  //   error_info_log  A pointer to a string that holds the error log.
+  bool Initialize(const int width,
+                  const int height,
+                  std::string* error_info_log);
+
+  // Binds and clears the G-buffer and activates the geometry shader program.
+  void BeginGeometryPass();
+
+  // Restores the default framebuffer.
+  void EndGeometryPass();
+
+  // Shades the G-buffer into the default framebuffer and copies the depth of
+  // the G-buffer into it so that forward passes can be rendered on top.
+  // Params:
+  //   lights  The lights in world coordinates.
+  //   projection  The camera projection matrix.
+  //   view  The camera pose matrix (world -> camera transformation matrix).
+  void LightingPass(const std::vector<PointLight>& lights,
+                    const Eigen::Matrix4f& projection,
+                    const Eigen::Matrix4f& view);
+
+  // Returns the shader program that has to be passed to Model::Draw during
+  // the geometry pass.
+  const ShaderProgram& geometry_shader_program() const {
+    return geometry_shader_program_;
+  }
+
+  // Returns the depth texture of the G-buffer, e.g., to build the depth
+  // pyramid of a GpuCuller.
+  GLuint depth_texture_id() const { return depth_texture_id_; }
+
+  // Sets the ambient light term.
+  void set_ambient_color(const Eigen::Vector3f& ambient_color) {
+    ambient_color_ = ambient_color;
+  }
+
+  // Sets the directional light. The direction is the one in which the light
+  // travels in world coordinates. A black color disables the light.
+  void set_directional_light(const Eigen::Vector3f& direction,
+                             const Eigen::Vector3f& color) {
+    directional_light_direction_ = direction.normalized();
+    directional_light_color_ = color;
+  }
+
+  // Sets the shadow maps of the directional light, or nullptr to disable
+  // shadows. The instance is not owned and must outlive the renderer.
+  void set_shadow_maps(const CascadedShadowMaps* shadow_maps) {
+    shadow_maps_ = shadow_maps;
+  }
+
+ private:
+  // Creates the framebuffer and its attachments.
+  bool CreateGBuffer(std::string* error_info_log);
+  // Uploads the lights and the tile lists into the texture buffers.
+  void UploadLights(const std::vector<PointLight>& lights,
+                    const Eigen::Matrix4f& view,
+                    const Eigen::Matrix4f& projection);
+
+  // Dimensions of the G-buffer.
+  int width_;
+  int height_;
+  // Number of tiles along each dimension.
+  int num_tiles_x_;
+  int num_tiles_y_;
+  // Framebuffer object and its attachments.
+  GLuint gbuffer_id_;
+  GLuint albedo_texture_id_;
+  GLuint normal_texture_id_;
+  GLuint depth_texture_id_;
+  // Texture buffers holding the light data and the per-tile light lists.
+  GLuint light_buffer_id_;
+  GLuint light_texture_id_;
+  GLuint light_index_buffer_id_;
+  GLuint light_index_texture_id_;
+  // Per-tile (offset, count) texture.
+  GLuint tile_texture_id_;
+  // Empty vertex array object used to draw the full-screen triangle.
+  GLuint empty_vertex_array_object_id_;
+  // Scratch storage reused every frame to avoid allocations.
+  std::vector<GLint> tile_ranges_;
+  std::vector<GLint> light_indices_;
+  std::vector<GLfloat> light_data_;
+  // Ambient light term.
+  Eigen::Vector3f ambient_color_;
+  // Directional light and its shadows.
+  Eigen::Vector3f directional_light_direction_;
+  Eigen::Vector3f directional_light_color_;
+  const CascadedShadowMaps* shadow_maps_;
+  // Shader programs.
+  ShaderProgram geometry_shader_program_;
+  ShaderProgram lighting_shader_program_;
+};
+
+}  // namespace wvu
+
+#endif  // DEFERRED_RENDERER_H_
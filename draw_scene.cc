@@ -9,16 +9,16 @@
 #define _USE_MATH_DEFINES  // For using M_PI.
 #include <cmath>
 // Include second C++-Headers.
+#include <algorithm>
+#include <fstream>
 #include <iostream>
+#include <map>
 #include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
 // Include library headers.
-// Include CImg library to load textures.
-// The macro below disables the capabilities of displaying images in CImg.
-#define cimg_display 0
-#include <CImg.h>
-
 // The macro below tells the linker to use the GLEW library in a static way.
 // This is mainly for compatibility with Windows.
 // Glew is a library that "scans" and knows what "extensions" (i.e.,
@@ -38,12 +38,33 @@
 #include <glog/logging.h>
 
 // Include system headers.
-#include "camera.cc"
-#include "camera_controller.cc"
+#include "animation.h"
+#include "asset_manager.h"
+#include "camera.h"
 #include "camera_utils.h"
+#include "cooked_assets.h"
+#include "debug_draw.h"
+#include "deferred_renderer.h"
+#include "frame_profiler.h"
+#include "gl_trace.h"
+#include "gpu_culling.h"
+#include "impostor.h"
+#include "mesh_optimizer.h"
 #include "model.h"
+#include "model_loader.h"
+#include "pak_archive.h"
+#include "particle_system.h"
+#include "scene_file.h"
 #include "shader_program.h"
+#include "shadow_maps.h"
+#include "static_batching.h"
+#include "stress_scene.h"
+#include "thread_pool.h"
+#include "transparency_pass.h"
 #include "transformations.h"
+#include "upload_thread.h"
+#include "vertex_pulling.h"
+#include "wireframe.h"
 
 // Google flags.
 // (<name of the flag>, <default value>, <Brief description of flat>)
@@ -56,6 +77,77 @@ DEFINE_string(texture1_filepath, "texture1.bmp",
               "Filepath of the first texture.");
 DEFINE_string(texture2_filepath, "texture2.bmp",
               "Filepath of the second texture.");
+DEFINE_string(renderer, "forward",
+              "Rendering path: forward or deferred. The deferred path pays "
+              "off for scenes with heavy overdraw and many lights.");
+DEFINE_bool(shadows, false,
+            "Render cascaded shadow maps for the directional light. Only "
+            "used by the deferred renderer.");
+DEFINE_int32(num_particles, 0,
+             "Capacity of the GPU particle system. Zero disables it. "
+             "Requires OpenGL 4.3.");
+DEFINE_double(cube_opacity, 1.0,
+              "Opacity of the cube. Values below one draw it with weighted "
+              "blended order-independent transparency (requires OpenGL "
+              "4.0).");
+DEFINE_double(impostor_distance, 0.0,
+              "Models farther than this distance from the camera are drawn "
+              "as impostors baked at startup. Zero disables impostors.");
+DEFINE_bool(static_batching, false,
+            "Mark the models as static and merge them into world-space "
+            "batches, one draw call per texture and grid cell.");
+DEFINE_bool(gpu_culling, false,
+            "Cull the models in a compute shader and draw the survivors with "
+            "indirect draw calls. Requires OpenGL 4.3. In the deferred path "
+            "the G-buffer depth is also used for occlusion culling.");
+DEFINE_bool(vertex_pulling, false,
+            "Fetch the vertices of the forward path from storage buffers in "
+            "the vertex shader, in a compact format and with a single VAO. "
+            "Requires OpenGL 4.3.");
+DEFINE_string(wireframe, "off",
+              "Wireframe mode of the forward path: off, overlay (edges over "
+              "the textured models), or lines (edges only). Not used with "
+              "--vertex_pulling.");
+DEFINE_bool(debug_draw, false,
+            "Draw the bounding box and the axes of every model. Debug builds "
+            "only.");
+DEFINE_bool(upload_thread, false,
+            "Upload the textures from a background thread with a shared "
+            "context instead of the render loop.");
+DEFINE_string(asset_pak, "",
+              "Pak archive (see wvu_cook --pak) the assets are read from. "
+              "Assets missing from it are read from the file system.");
+DEFINE_string(scene, "",
+              "Scene (.scene text, or .wvuscene cooked by wvu_cook) drawn "
+              "instead of the default pyramid and cube.");
+DEFINE_int32(stress_objects, 0,
+             "When positive, a procedurally generated scene with this many "
+             "objects is drawn instead of the default pyramid and cube.");
+DEFINE_int32(stress_triangles_per_mesh, 128,
+             "Triangles of every mesh of the generated scene.");
+DEFINE_int32(stress_unique_meshes, 8,
+             "Distinct meshes of the generated scene.");
+DEFINE_int32(stress_unique_textures, 4,
+             "Distinct textures of the generated scene.");
+DEFINE_double(stress_static_fraction, 0.5,
+              "Fraction of static objects of the generated scene.");
+DEFINE_int32(benchmark_frames, 0,
+             "When positive, renders this many frames along a fixed camera "
+             "path in a hidden window, prints the frame statistics, and "
+             "exits.");
+DEFINE_int32(benchmark_warmup_frames, 30,
+             "Frames rendered before the measured ones in benchmark mode.");
+DEFINE_string(benchmark_output, "",
+              "When set, the frame statistics are also written to this JSON "
+              "file.");
+DEFINE_string(gl_trace_output, "",
+              "When set, the OpenGL calls are recorded into this trace file, "
+              "which wvu_gl_replay replays (see gl_trace.h).");
+DEFINE_int32(gl_trace_frames, 100,
+             "Frames recorded into the trace; the recording starts before "
+             "the assets are loaded.");
+DEFINE_bool(animate_models, true,
+            "Spins the dynamic models with a keyframed animation.");
 
 // Annonymous namespace for constants and helper functions.
 namespace {
@@ -65,84 +157,20 @@ using wvu::Model;
 constexpr int kWindowWidth = 640;
 constexpr int kWindowHeight = 480;
 
-// Pointer to the camera controller.
-static wvu::CameraController* camera_controller_ptr = nullptr;
-// Pointer to the moving vector.
-static std::vector<bool>* movement_vector_ptr = nullptr;
-
 // ------------------------ User Input Callbacks -----------------------------
 // Error callback function. This function follows the required signature of
 // GLFW. See http://www.glfw.org/docs/3.0/group__error.html for more
 // information.
 static void ErrorCallback(int error, const char* description) {
-  LOG(FATAL) << description;
-}
-
-void UpdateCameraPose() {
-  // Camera position.
-  if (movement_vector_ptr->at(GLFW_KEY_W)) {
-    camera_controller_ptr->MoveFront();
-  }
-  if (movement_vector_ptr->at(GLFW_KEY_S)) {
-    camera_controller_ptr->MoveBack();
-  }
-  if (movement_vector_ptr->at(GLFW_KEY_A)) {
-    camera_controller_ptr->MoveLeft();
-  }
-  if (movement_vector_ptr->at(GLFW_KEY_D)) {
-    camera_controller_ptr->MoveRight();
-  }
+  std::cerr << "ERROR: " << description << std::endl;
 }
 
-// Keyboard event callback. See glfw documentation for information about
-// parameters.
-static void KeyCallback(GLFWwindow* window,
-                        const int key,
-                        const int scancode,
-                        const int action,
-                        const int mods) {
+// Key callback. This function follows the required signature of GLFW. See
+// http://www.glfw.org/docs/latest/input_guide.html fore more information.
+static void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods) {
   if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) {
     glfwSetWindowShouldClose(window, GL_TRUE);
   }
-  // Camera position.
-  if (key >= 0 && key < 1024) {
-    if (action == GLFW_PRESS) {
-      movement_vector_ptr->at(key) = true;
-    } else if (action == GLFW_RELEASE) {
-      movement_vector_ptr->at(key) = false;
-    }
-  }
-}
-
-// Mouse events callback. See glfw documentation for information about
-// parameters.
-static void MouseCallback(GLFWwindow* window,
-                          const double x_position,
-                          const double y_position) {
-  static int last_x_position;
-  static int last_y_position;
-  static bool first_call = true;
-  // First call to this callback.
-  if (first_call) {
-    last_x_position = x_position;
-    last_y_position = y_position;
-    first_call = false;
-  }
-  // Offsets.
-  camera_controller_ptr->AddYawOffset(
-      camera_controller_ptr->rotation_sensitivity() *
-      (x_position - last_x_position));
-  camera_controller_ptr->AddPitchOffset(
-      camera_controller_ptr->rotation_sensitivity() *
-      (last_y_position - y_position));
-  last_x_position = x_position;
-  last_y_position = y_position;
-}
-
-static void ScrollCallback(GLFWwindow* window,
-                           const double x_offset,
-                           const double y_offset) {
-  camera_controller_ptr->AdjustZoom(y_offset);
 }
 
 // ------------------------ End of User Input Callbacks ----------------------
@@ -189,49 +217,6 @@ const std::string fragment_shader_src =
     "color = texture(texture_sampler, texel);\n"
   "}\n";
 
-// Error callback function. This function follows the required signature of
-// GLFW. See http://www.glfw.org/docs/3.0/group__error.html for more
-// information.
-static void ErrorCallback(int error, const char* description) {
-  std::cerr << "ERROR: " << description << std::endl;
-}
-
-// Key callback. This function follows the required signature of GLFW. See
-// http://www.glfw.org/docs/latest/input_guide.html fore more information.
-static void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods) {
-  if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) {
-    glfwSetWindowShouldClose(window, GL_TRUE);
-  }
-}
-
-GLuint LoadTexture(const std::string& texture_filepath) {
-  cimg_library::CImg<unsigned char> image;
-  image.load(texture_filepath.c_str());
-  const int width = image.width();
-  const int height = image.height();
-  // OpenGL expects to have the pixel values interleaved (e.g., RGBD, ...). CImg
-  // flatens out the planes. To have them interleaved, CImg has to re-arrange
-  // the values.
-  // Also, OpenGL has the y-axis of the texture flipped.
-  image.permute_axes("cxyz");
-  GLuint texture_id;
-  glGenTextures(1, &texture_id);
-  glBindTexture(GL_TEXTURE_2D, texture_id);
-  // We are configuring texture wrapper, each per dimension,s:x, t:y.
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-  // Define the interpolation behavior for this texture.
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-  /// Sending the texture information to the GPU.
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height,
-               0, GL_RGB, GL_UNSIGNED_BYTE, image.data());
-  // Generate a mipmap.
-  glGenerateMipmap(GL_TEXTURE_2D);
-  glBindTexture(GL_TEXTURE_2D, 0);
-  return texture_id;
-}
-
 // Configures glfw.
 void SetWindowHints() {
   // Sets properties of windows and have to be set before creation.
@@ -244,6 +229,10 @@ void SetWindowHints() {
   glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
   // Sets the property of resizability of a window.
   glfwWindowHint(GLFW_RESIZABLE, GL_FALSE);
+  // The benchmarks render offscreen.
+  if (FLAGS_benchmark_frames > 0) {
+    glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+  }
 }
 
 // Configures the view port.
@@ -285,22 +274,186 @@ bool CreateShaderProgram(wvu::ShaderProgram* shader_program) {
   return true;
 }
 
-// Renders the scene.
+// Renders the scene using the deferred path: the models are rasterized into
+// the G-buffer with their regular Draw() call and then the lights are applied
+// in a single full-screen pass.
+void RenderSceneDeferred(wvu::DeferredRenderer* deferred_renderer,
+                         const std::vector<wvu::PointLight>& lights,
+                         const Eigen::Matrix4f& projection,
+                         const Eigen::Matrix4f& view,
+                         std::vector<Model*>* models_to_draw,
+                         GLuint texture_ids[],
+                         wvu::StaticBatchRenderer* static_batch_renderer) {
+  deferred_renderer->BeginGeometryPass();
+  if (static_batch_renderer != nullptr) {
+    static_batch_renderer->Draw(deferred_renderer->geometry_shader_program(),
+                                projection, view);
+  }
+  for (int i = 0; i < models_to_draw->size(); i++) {
+    if (models_to_draw->at(i)->is_transparent()) continue;
+    if (static_batch_renderer != nullptr &&
+        models_to_draw->at(i)->is_static()) continue;
+    models_to_draw->at(i)->Draw(deferred_renderer->geometry_shader_program(),
+                                projection, view, texture_ids[i]);
+  }
+  deferred_renderer->EndGeometryPass();
+  deferred_renderer->LightingPass(lights, projection, view);
+}
+
+// Renders the scene with GPU culling. There is one culler per texture, whose
+// instances are the opaque models drawn with it (see culler_model_indices),
+// and their transforms are refreshed every frame. When a deferred renderer is
+// given, the models are rasterized into its G-buffer and the depth of the
+// G-buffer feeds the occlusion test of the next frame: the first culler builds
+// the depth pyramid once and the others share it.
+void RenderSceneGpuCulled(
+    const Eigen::Matrix4f& projection,
+    const Eigen::Matrix4f& view,
+    const std::vector<Model*>& models_to_draw,
+    const std::vector<wvu::GpuCuller*>& cullers,
+    const std::vector<std::vector<int> >& culler_model_indices,
+    GLuint texture_ids[],
+    wvu::DeferredRenderer* deferred_renderer,
+    const std::vector<wvu::PointLight>& lights,
+    const int width,
+    const int height) {
+  for (int i = 0; i < cullers.size(); i++) {
+    const std::vector<int>& model_indices = culler_model_indices[i];
+    for (int j = 0; j < model_indices.size(); j++) {
+      cullers[i]->SetInstanceTransform(
+          j, models_to_draw[model_indices[j]]->ComputeModelMatrix());
+    }
+    cullers[i]->Cull(projection, view);
+  }
+  if (deferred_renderer != nullptr) {
+    deferred_renderer->BeginGeometryPass();
+  } else {
+    ClearTheFrameBuffer();
+  }
+  // The models of a culler share their texture.
+  for (int i = 0; i < cullers.size(); i++) {
+    cullers[i]->Draw(projection, view,
+                     texture_ids[culler_model_indices[i].front()]);
+  }
+  if (deferred_renderer != nullptr) {
+    deferred_renderer->EndGeometryPass();
+    if (!cullers.empty()) {
+      cullers.front()->BuildDepthPyramid(
+          deferred_renderer->depth_texture_id(), width, height);
+    }
+    deferred_renderer->LightingPass(lights, projection, view);
+  }
+  glUseProgram(0);
+}
+
+// Renders the transparent models over the opaque scene. The models are drawn
+// in the order they are stored: the transparency pass does not need sorting.
+void RenderTransparentModels(wvu::TransparencyPass* transparency_pass,
+                             const Eigen::Matrix4f& projection,
+                             const Eigen::Matrix4f& view,
+                             std::vector<Model*>* models_to_draw,
+                             GLuint texture_ids[]) {
+  transparency_pass->Begin();
+  for (int i = 0; i < models_to_draw->size(); i++) {
+    if (!models_to_draw->at(i)->is_transparent()) continue;
+    transparency_pass->Draw(models_to_draw->at(i), projection, view,
+                            texture_ids[i]);
+  }
+  transparency_pass->Composite();
+}
+
+// Renders the scene with programmable vertex pulling. The mesh of every model
+// was added to the renderer in the order of models_to_draw. When a static
+// batch renderer is given, the static models are drawn through their batches.
+void RenderScenePulled(wvu::VertexPullingRenderer* vertex_pulling_renderer,
+                       const wvu::ShaderProgram& shader_program,
+                       const Eigen::Matrix4f& projection,
+                       const Eigen::Matrix4f& view,
+                       const std::vector<Model*>& models_to_draw,
+                       std::vector<Model*>* models_to_render,
+                       GLuint texture_ids[],
+                       wvu::StaticBatchRenderer* static_batch_renderer) {
+  ClearTheFrameBuffer();
+  if (static_batch_renderer != nullptr) {
+    static_batch_renderer->Draw(shader_program, projection, view);
+  }
+  vertex_pulling_renderer->Begin(projection, view);
+  for (int i = 0; i < models_to_render->size(); i++) {
+    Model* model = models_to_render->at(i);
+    if (model->is_transparent()) continue;
+    if (static_batch_renderer != nullptr && model->is_static()) continue;
+    const int mesh_id = std::find(models_to_draw.begin(), models_to_draw.end(),
+                                  model) - models_to_draw.begin();
+    vertex_pulling_renderer->Draw(mesh_id, model->ComputeModelMatrix(),
+                                  texture_ids[i]);
+  }
+  vertex_pulling_renderer->End();
+}
+
+// Adds the world-space bounding box and the axes of every model to the debug
+// lines of the frame.
+void AddModelDebugGeometry(const std::vector<Model*>& models_to_draw,
+                           wvu::DebugDraw* debug_draw) {
+  for (Model* model : models_to_draw) {
+    const Eigen::Matrix4f model_matrix = model->ComputeModelMatrix();
+    const Eigen::MatrixXf world_positions =
+        (model_matrix.block<3, 3>(0, 0) *
+         model->vertices().topRows<3>()).colwise() +
+        model_matrix.block<3, 1>(0, 3);
+    debug_draw->Box(world_positions.rowwise().minCoeff(),
+                    world_positions.rowwise().maxCoeff(),
+                    Eigen::Vector3f(1.0f, 1.0f, 0.0f));
+    debug_draw->Axes(model_matrix, 1.0f, false);
+  }
+}
+
+// Splits the models into the ones drawn with their geometry and the ones far
+// enough from the camera to be drawn with their impostors. The transparent
+// models always keep their geometry: the transparency pass draws them.
+void SelectImpostors(const Eigen::Vector3f& camera_position,
+                     const float impostor_distance,
+                     std::vector<Model*>* models_to_draw,
+                     GLuint texture_ids[],
+                     std::vector<Model*>* near_models,
+                     std::vector<GLuint>* near_texture_ids,
+                     std::vector<int>* far_model_indices) {
+  near_models->clear();
+  near_texture_ids->clear();
+  far_model_indices->clear();
+  for (int i = 0; i < models_to_draw->size(); i++) {
+    Model* model = models_to_draw->at(i);
+    if (!model->is_transparent() &&
+        (model->position() - camera_position).norm() > impostor_distance) {
+      far_model_indices->push_back(i);
+    } else {
+      near_models->push_back(model);
+      near_texture_ids->push_back(texture_ids[i]);
+    }
+  }
+}
+
+// Renders the scene. When a static batch renderer is given, the static models
+// are drawn through their batches.
 void RenderScene(const wvu::ShaderProgram& shader_program,
                   const Eigen::Matrix4f& projection,
         					const Eigen::Matrix4f& view,
         					std::vector<Model*>* models_to_draw,
-        					GLFWwindow* window, GLuint texture_ids[]) {
+        					GLFWwindow* window, GLuint texture_ids[],
+                  wvu::StaticBatchRenderer* static_batch_renderer) {
   // Clear the buffer.
   ClearTheFrameBuffer();
   // Let OpenGL know that we want to use our shader program.
   shader_program.Use();
-  // Render the models in a wireframe mode.
-  glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
   // Draw the models.
   // TODO: For every model in models_to_draw, call its Draw() method, passing
   // the view and projection matrices.
+  if (static_batch_renderer != nullptr) {
+    static_batch_renderer->Draw(shader_program, projection, view);
+  }
   for(int i = 0; i < models_to_draw->size(); i++){
+    if (models_to_draw->at(i)->is_transparent()) continue;
+    if (static_batch_renderer != nullptr &&
+        models_to_draw->at(i)->is_static()) continue;
     models_to_draw->at(i)->Draw(shader_program, projection, view, texture_ids[i]);
   }
   // Let OpenGL know that we are done with our vertex array object.
@@ -406,6 +559,164 @@ void DeleteModels(std::vector<Model*>* models_to_draw) {
   }
 }
 
+// Reads the vertices of a mesh referenced by a scene: an OBJ file or a mesh
+// cooked by wvu_cook, from the archive when it has it.
+bool LoadSceneMesh(const std::string& filepath,
+                   const wvu::PakReader& archive,
+                   Eigen::MatrixXf* vertices,
+                   std::vector<GLuint>* indices,
+                   std::string* error_info_log) {
+  std::string contents;
+  const bool read = archive.Contains(filepath) ?
+      archive.Read(filepath, nullptr, &contents) :
+      wvu::ReadFileContents(filepath, &contents);
+  if (!read) {
+    *error_info_log = "Could not read the mesh " + filepath;
+    return false;
+  }
+  const std::string extension = ".wvumesh";
+  if (filepath.size() >= extension.size() &&
+      filepath.compare(filepath.size() - extension.size(), extension.size(),
+                       extension) == 0) {
+    return wvu::DecodeCookedMesh(contents.data(), contents.size(), vertices,
+                                 indices, error_info_log);
+  }
+  std::vector<Eigen::Vector3f> obj_vertices;
+  std::vector<Eigen::Vector2f> obj_texels;
+  std::vector<Eigen::Vector3f> obj_normals;
+  std::vector<wvu::Face> faces;
+  wvu::ParseObjModel(contents, &obj_vertices, &obj_texels, &obj_normals,
+                     &faces);
+  if (faces.empty()) {
+    *error_info_log = "Could not parse the mesh " + filepath;
+    return false;
+  }
+  wvu::ConvertObjToMesh(obj_vertices, obj_texels, obj_normals, faces,
+                        vertices, indices);
+  return true;
+}
+
+// Constructs a model per entity of the scene, and returns the texture of
+// each one (the first one of its material, or an empty path). The meshes
+// "builtin:pyramid" and "builtin:cube" are those of ConstructModels. Model
+// has no scale, so the one of the entity is baked into the vertices.
+bool ConstructSceneModels(const wvu::SceneView& scene,
+                          const wvu::PakReader& archive,
+                          std::vector<Model*>* models_to_draw,
+                          std::vector<std::string>* texture_filepaths,
+                          std::string* error_info_log) {
+  std::vector<Model*> builtin_models;
+  ConstructModels(&builtin_models);
+  std::vector<Eigen::MatrixXf> mesh_vertices(scene.num_meshes());
+  std::vector<std::vector<GLuint> > mesh_indices(scene.num_meshes());
+  bool success = true;
+  for (int i = 0; i < scene.num_meshes() && success; i++) {
+    const std::string filepath = scene.mesh(i);
+    if (filepath == "builtin:pyramid" || filepath == "builtin:cube") {
+      const Model* model = builtin_models[filepath == "builtin:cube"];
+      mesh_vertices[i] = model->vertices();
+      mesh_indices[i] = model->indices();
+      continue;
+    }
+    success = LoadSceneMesh(filepath, archive, &mesh_vertices[i],
+                            &mesh_indices[i], error_info_log);
+  }
+  DeleteModels(&builtin_models);
+  if (!success) return false;
+
+  for (int i = 0; i < scene.num_entities(); i++) {
+    const wvu::SceneEntity& entity = scene.entity(i);
+    Eigen::MatrixXf vertices = mesh_vertices[entity.mesh_index];
+    vertices.topRows(3).array().colwise() *=
+        Eigen::Map<const Eigen::Array3f>(entity.scale);
+    const Eigen::AngleAxisf angle_axis(
+        Eigen::Quaternionf(Eigen::Map<const Eigen::Vector4f>(
+            entity.orientation)));
+    Model* model = new Model(angle_axis.angle() * angle_axis.axis(),
+                             Eigen::Map<const Eigen::Vector3f>(
+                                 entity.position),
+                             vertices, mesh_indices[entity.mesh_index]);
+    model->SetVerticesIntoGpu();
+    model->set_is_static((entity.flags & wvu::kStaticSceneEntity) != 0);
+    models_to_draw->push_back(model);
+    std::string texture_filepath;
+    if (entity.material_index != wvu::kNoSceneMaterial) {
+      const wvu::SceneMaterial& material =
+          scene.material(entity.material_index);
+      if (material.num_textures > 0) {
+        texture_filepath = scene.texture(material, 0);
+      }
+    }
+    texture_filepaths->push_back(texture_filepath);
+  }
+  return true;
+}
+
+// Constructs a model per object of a generated scene and creates its
+// textures. Every object gets its own copy of its mesh, as the models of
+// the other scenes do.
+void ConstructStressModels(const wvu::StressSceneOptions& options,
+                           std::vector<Model*>* models_to_draw,
+                           std::vector<GLuint>* object_texture_ids,
+                           std::vector<GLuint>* stress_texture_ids) {
+  wvu::StressScene scene;
+  wvu::GenerateStressScene(options, &scene);
+  stress_texture_ids->resize(scene.textures.size());
+  glGenTextures(stress_texture_ids->size(), stress_texture_ids->data());
+  for (int i = 0; i < scene.textures.size(); i++) {
+    glBindTexture(GL_TEXTURE_2D, stress_texture_ids->at(i));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                    GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, options.texture_size,
+                 options.texture_size, 0, GL_RGB, GL_UNSIGNED_BYTE,
+                 scene.textures[i].data());
+    glGenerateMipmap(GL_TEXTURE_2D);
+  }
+  glBindTexture(GL_TEXTURE_2D, 0);
+  for (const wvu::StressObject& object : scene.objects) {
+    Model* model = new Model(object.orientation, object.position,
+                             scene.mesh_vertices[object.mesh_index],
+                             scene.mesh_indices[object.mesh_index]);
+    model->SetVerticesIntoGpu();
+    model->set_is_static(object.is_static);
+    models_to_draw->push_back(model);
+    object_texture_ids->push_back(
+        stress_texture_ids->at(object.texture_index));
+  }
+}
+
+// Returns a looping clip that spins a model around the vertical axis at 50
+// degrees per second. The keyframes are a quarter turn apart, so that the
+// slerp between them takes the intended direction.
+wvu::AnimationClip CreateSpinClip() {
+  constexpr float kDegreesPerSecond = 50.0f;
+  wvu::AnimationClip clip;
+  for (int i = 0; i <= 4; ++i) {
+    const float angle_in_degrees = 90.0f * i;
+    clip.rotation.times.push_back(angle_in_degrees / kDegreesPerSecond);
+    clip.rotation.values.push_back(Eigen::Quaternionf(Eigen::AngleAxisf(
+        wvu::ConvertDegreesToRadians(angle_in_degrees),
+        Eigen::Vector3f::UnitY())));
+  }
+  clip.loop = true;
+  return clip;
+}
+
+// Returns the view matrix of the camera path of the benchmarks: the camera
+// moves into the scene while panning from side to side.
+Eigen::Matrix4f ComputeBenchmarkView(const int frame,
+                                     const int num_frames,
+                                     wvu::Camera* camera) {
+  const float progress = static_cast<float>(frame) / std::max(1, num_frames);
+  const float yaw = 0.4f * std::sin(2.0f * M_PI * progress);
+  camera->set_position(Eigen::Vector3f(0.0f, 0.0f, -4.0f * progress));
+  camera->set_view_direction(
+      Eigen::Vector3f(std::sin(yaw), 0.0f, -std::cos(yaw)));
+  return camera->ComputeLookAtMatrix();
+}
+
 }  // namespace
 
 int main(int argc, char** argv) {
@@ -436,7 +747,8 @@ int main(int argc, char** argv) {
 
   // Make the window's context current.
   glfwMakeContextCurrent(window);
-  glfwSwapInterval(1);
+  // The benchmarks are not limited by the refresh rate.
+  glfwSwapInterval(FLAGS_benchmark_frames > 0 ? 0 : 1);
   glfwSetKeyCallback(window, KeyCallback);
 
   // Initialize GLEW.
@@ -446,6 +758,14 @@ int main(int argc, char** argv) {
     glfwTerminate();
     return -1;
   }
+  if (!FLAGS_gl_trace_output.empty()) {
+    std::string error_info_log;
+    if (!wvu::StartGlTraceRecording(FLAGS_gl_trace_output,
+                                    &error_info_log)) {
+      std::cerr << "ERROR: " << error_info_log << "\n";
+    }
+  }
+  int num_traced_frames = 0;
 
   // Configure View Port.
   ConfigureViewPort(window);
@@ -455,14 +775,91 @@ int main(int argc, char** argv) {
   if (!CreateShaderProgram(&shader_program)) {
     return -1;
   }
+  // The wireframe modes replace the shader program of the forward path.
+  wvu::WireframeShader wireframe_shader;
+  const bool use_wireframe = FLAGS_wireframe != "off";
+  if (use_wireframe) {
+    if (FLAGS_wireframe != "overlay" && FLAGS_wireframe != "lines") {
+      std::cerr << "ERROR: Unknown wireframe mode " << FLAGS_wireframe
+                << ".\n";
+      return -1;
+    }
+    int framebuffer_width;
+    int framebuffer_height;
+    glfwGetFramebufferSize(window, &framebuffer_width, &framebuffer_height);
+    std::string error_info_log;
+    if (!wireframe_shader.Initialize(framebuffer_width, framebuffer_height,
+                                     &error_info_log)) {
+      std::cerr << "ERROR: " << error_info_log << "\n";
+      return -1;
+    }
+    wireframe_shader.set_fill(FLAGS_wireframe == "overlay");
+  }
+  const wvu::ShaderProgram& forward_shader_program =
+      use_wireframe ? wireframe_shader.shader_program() : shader_program;
 
-  // Construct the models to draw in the scene.
-  std::vector<Model*> models_to_draw;
-  ConstructModels(&models_to_draw);
+  // The textures stream in while the scene renders; the models are drawn
+  // untextured until they arrive.
+  // The archive outlives the manager, whose workers may still read it.
+  wvu::PakReader asset_pak;
+  wvu::UploadThread upload_thread;
+  wvu::AssetManager asset_manager(2);
+  if (FLAGS_upload_thread) {
+    std::string error_info_log;
+    if (!upload_thread.Start(window, &error_info_log)) {
+      std::cerr << "ERROR: " << error_info_log << "\n";
+      return -1;
+    }
+    asset_manager.set_upload_thread(&upload_thread);
+  }
+  if (!FLAGS_asset_pak.empty()) {
+    std::string error_info_log;
+    if (!asset_pak.Open(FLAGS_asset_pak, &error_info_log)) {
+      std::cerr << "ERROR: " << error_info_log << "\n";
+      return -1;
+    }
+    asset_manager.set_archive(&asset_pak);
+  }
 
-  GLuint texture_ids[2];
-  texture_ids[0] = LoadTexture(FLAGS_brick_filepath);
-  texture_ids[1] = LoadTexture(FLAGS_stone_filepath);
+  // Construct the models to draw in the scene, and load their textures.
+  std::vector<Model*> models_to_draw;
+  std::vector<std::string> texture_filepaths;
+  // Textures of the generated scene: one per distinct texture, and one per
+  // object.
+  std::vector<GLuint> stress_texture_ids;
+  std::vector<GLuint> stress_object_texture_ids;
+  if (FLAGS_stress_objects > 0) {
+    wvu::StressSceneOptions stress_options;
+    stress_options.num_objects = FLAGS_stress_objects;
+    stress_options.triangles_per_mesh = FLAGS_stress_triangles_per_mesh;
+    stress_options.num_unique_meshes = FLAGS_stress_unique_meshes;
+    stress_options.num_unique_textures = FLAGS_stress_unique_textures;
+    stress_options.static_fraction = FLAGS_stress_static_fraction;
+    ConstructStressModels(stress_options, &models_to_draw,
+                          &stress_object_texture_ids, &stress_texture_ids);
+  } else if (FLAGS_scene.empty()) {
+    ConstructModels(&models_to_draw);
+    texture_filepaths = {FLAGS_texture1_filepath, FLAGS_texture2_filepath};
+  } else {
+    wvu::SceneFile scene_file;
+    std::string error_info_log;
+    if (!scene_file.Open(FLAGS_scene, &error_info_log) ||
+        !ConstructSceneModels(scene_file.view(), asset_pak, &models_to_draw,
+                              &texture_filepaths, &error_info_log)) {
+      std::cerr << "ERROR: " << error_info_log << "\n";
+      return -1;
+    }
+  }
+  std::vector<wvu::TextureHandle> texture_handles;
+  for (const std::string& texture_filepath : texture_filepaths) {
+    texture_handles.push_back(texture_filepath.empty() ?
+                              wvu::TextureHandle() :
+                              asset_manager.LoadTexture(texture_filepath));
+  }
+  std::vector<GLuint> model_texture_ids(models_to_draw.size(), 0);
+  std::copy(stress_object_texture_ids.begin(),
+            stress_object_texture_ids.end(), model_texture_ids.begin());
+  GLuint* texture_ids = model_texture_ids.data();
 
   // Construct the camera projection matrix.
   const float field_of_view = wvu::ConvertDegreesToRadians(45.0f);
@@ -472,23 +869,391 @@ int main(int argc, char** argv) {
   const Eigen::Matrix4f& projection =
       wvu::ComputePerspectiveProjectionMatrix(field_of_view, aspect_ratio,
                                               near_plane, far_plane);
-  const Eigen::Matrix4f view = Eigen::Matrix4f::Identity();
+  // The view is fixed, except along the camera path of the benchmarks.
+  Eigen::Matrix4f view = Eigen::Matrix4f::Identity();
+
+  // Set up the deferred path when requested.
+  wvu::DeferredRenderer deferred_renderer;
+  const bool use_deferred_renderer = FLAGS_renderer == "deferred";
+  if (use_deferred_renderer) {
+    int framebuffer_width;
+    int framebuffer_height;
+    glfwGetFramebufferSize(window, &framebuffer_width, &framebuffer_height);
+    std::string error_info_log;
+    if (!deferred_renderer.Initialize(framebuffer_width, framebuffer_height,
+                                      &error_info_log)) {
+      std::cerr << "ERROR: " << error_info_log << "\n";
+      return -1;
+    }
+  }
+  // Set up the GPU culling path when requested and supported. The opaque
+  // models are grouped by texture, and every group is drawn by one culler. The
+  // textures streamed by the asset manager are identified by their handle,
+  // since their ids are only known once they are loaded.
+  std::vector<wvu::GpuCuller*> cullers;
+  std::vector<std::vector<int> > culler_model_indices;
+  const bool use_gpu_culling =
+      FLAGS_gpu_culling && wvu::GpuCuller::IsSupported();
+  if (FLAGS_gpu_culling && !use_gpu_culling) {
+    std::cerr << "WARNING: GPU culling requires OpenGL 4.3. Disabling it.\n";
+  }
+  if (use_gpu_culling) {
+    std::map<std::pair<int, GLuint>, int> culler_of_texture;
+    for (int i = 0; i < models_to_draw.size(); i++) {
+      const Model* model = models_to_draw[i];
+      // The transparent models are drawn by the transparency pass.
+      if (model->is_transparent()) continue;
+      const std::pair<int, GLuint> texture_key =
+          i < texture_handles.size() ?
+          std::make_pair(texture_handles[i].id, 0u) :
+          std::make_pair(-1, texture_ids[i]);
+      const auto culler_it = culler_of_texture.find(texture_key);
+      wvu::GpuCuller* culler = nullptr;
+      if (culler_it == culler_of_texture.end()) {
+        culler = new wvu::GpuCuller;
+        std::string error_info_log;
+        if (!culler->Initialize(&error_info_log)) {
+          std::cerr << "ERROR: " << error_info_log << "\n";
+          delete culler;
+          return -1;
+        }
+        if (!cullers.empty()) culler->ShareDepthPyramid(cullers.front());
+        culler_of_texture[texture_key] = cullers.size();
+        cullers.push_back(culler);
+        culler_model_indices.emplace_back();
+      } else {
+        culler = cullers[culler_it->second];
+      }
+      const int mesh_id = culler->AddMesh(model->vertices(), model->indices());
+      culler->AddInstance(mesh_id, model->ComputeModelMatrix());
+      culler_model_indices[culler_of_texture[texture_key]].push_back(i);
+    }
+  }
+  // Cascaded shadow maps for the directional light of the deferred path. The
+  // cascades are fitted to the camera near and far planes.
+  wvu::CameraParameters camera_params;
+  camera_params.field_of_view = field_of_view;
+  camera_params.aspect_ratio = aspect_ratio;
+  camera_params.near_plane_distance = near_plane;
+  camera_params.far_plane_distance = far_plane;
+  camera_params.position = Eigen::Vector3f::Zero();
+  camera_params.view_direction = -Eigen::Vector3f::UnitZ();
+  camera_params.up_vector = Eigen::Vector3f::UnitY();
+  wvu::Camera camera(camera_params);
+  camera.Initialize();
+  const Eigen::Vector3f sun_direction(-0.3f, -1.0f, -0.2f);
+  wvu::CascadedShadowMaps shadow_maps;
+  std::vector<Model*> static_models;
+  std::vector<Model*> dynamic_models;
+  if (use_deferred_renderer) {
+    deferred_renderer.set_directional_light(sun_direction,
+                                            Eigen::Vector3f(0.6f, 0.6f, 0.5f));
+  }
+  if (use_deferred_renderer && FLAGS_shadows) {
+    std::string error_info_log;
+    if (!shadow_maps.Initialize(3, 1024, &error_info_log)) {
+      std::cerr << "ERROR: " << error_info_log << "\n";
+      return -1;
+    }
+    shadow_maps.set_light_direction(sun_direction);
+    deferred_renderer.set_shadow_maps(&shadow_maps);
+    for (Model* model : models_to_draw) {
+      if (model->is_static()) {
+        static_models.push_back(model);
+      } else {
+        dynamic_models.push_back(model);
+      }
+    }
+  }
+  // GPU particle system: a fountain of sparks in the middle of the scene.
+  wvu::ParticleSystem particle_system;
+  bool use_particles = FLAGS_num_particles > 0;
+  if (use_particles && !wvu::ParticleSystem::IsSupported()) {
+    std::cerr << "WARNING: Particles require OpenGL 4.3. Disabling them.\n";
+    use_particles = false;
+  }
+  if (use_particles) {
+    std::string error_info_log;
+    if (!particle_system.Initialize(FLAGS_num_particles, &error_info_log)) {
+      std::cerr << "ERROR: " << error_info_log << "\n";
+      return -1;
+    }
+    wvu::ParticleEmitter emitter;
+    emitter.position = Eigen::Vector3f(0.0f, -1.0f, -13.0f);
+    emitter.position_spread = 0.2f;
+    emitter.velocity = Eigen::Vector3f(0.0f, 4.0f, 0.0f);
+    emitter.velocity_spread = 1.5f;
+    emitter.color = Eigen::Vector4f(1.0f, 0.6f, 0.2f, 0.8f);
+    emitter.min_lifetime = 1.0f;
+    emitter.max_lifetime = 2.5f;
+    emitter.size = 0.03f;
+    // Enough to keep the pool about full.
+    emitter.emission_rate = FLAGS_num_particles / emitter.max_lifetime;
+    particle_system.set_emitter(emitter);
+  }
+  // Transparent models are composited over the opaque scene. Without
+  // support for the transparency pass they are drawn as opaque models.
+  wvu::TransparencyPass transparency_pass;
+  // The cube is the second model of the default scene.
+  Model* cube = FLAGS_scene.empty() && FLAGS_stress_objects <= 0 ?
+      models_to_draw[1] : nullptr;
+  const bool use_transparency_pass = cube != nullptr &&
+      FLAGS_cube_opacity < 1.0 && wvu::TransparencyPass::IsSupported();
+  if (use_transparency_pass) {
+    int framebuffer_width;
+    int framebuffer_height;
+    glfwGetFramebufferSize(window, &framebuffer_width, &framebuffer_height);
+    std::string error_info_log;
+    if (!transparency_pass.Initialize(framebuffer_width, framebuffer_height,
+                                      &error_info_log)) {
+      std::cerr << "ERROR: " << error_info_log << "\n";
+      return -1;
+    }
+  }
+  if (cube != nullptr) {
+    cube->set_opacity(use_transparency_pass ? FLAGS_cube_opacity : 1.0f);
+  }
+  // Lights used by the deferred path.
+  const std::vector<wvu::PointLight> lights = {
+    {Eigen::Vector3f(-1.0f, 2.0f, -12.0f), Eigen::Vector3f(1.0f, 0.9f, 0.8f),
+     10.0f},
+    {Eigen::Vector3f(3.0f, 1.0f, -13.0f), Eigen::Vector3f(0.4f, 0.5f, 1.0f),
+     8.0f}};
+
+
+  // Impostors drawn instead of the models far from the camera.
+  wvu::ImpostorBaker impostor_baker;
+  wvu::ImpostorRenderer impostor_renderer;
+  std::vector<wvu::Impostor> impostors;
+  const bool use_impostors = FLAGS_impostor_distance > 0.0;
+  // The impostors and the static batches capture the textures when they are
+  // built, so they wait for them.
+  if (use_impostors || FLAGS_static_batching) {
+    asset_manager.Finish();
+    for (int i = 0; i < texture_handles.size(); i++) {
+      texture_ids[i] = asset_manager.GetTextureId(texture_handles[i]);
+    }
+  }
+  if (use_impostors) {
+    std::string error_info_log;
+    if (!impostor_baker.Initialize(&error_info_log) ||
+        !impostor_renderer.Initialize(&error_info_log)) {
+      std::cerr << "ERROR: " << error_info_log << "\n";
+      return -1;
+    }
+    for (int i = 0; i < models_to_draw.size(); i++) {
+      wvu::Impostor impostor;
+      if (!impostor_baker.Bake(*models_to_draw[i], texture_ids[i], 8, 128,
+                               &impostor, &error_info_log)) {
+        std::cerr << "ERROR: " << error_info_log << "\n";
+        return -1;
+      }
+      impostors.push_back(impostor);
+    }
+  }
+  std::vector<Model*> near_models;
+  std::vector<GLuint> near_texture_ids;
+  std::vector<int> far_model_indices;
 
+  // Static batches replacing the individual draws of the static models.
+  wvu::StaticBatchRenderer static_batch_renderer;
+  wvu::StaticBatchRenderer* static_batches = nullptr;
+  if (FLAGS_static_batching) {
+    for (Model* model : models_to_draw) {
+      model->set_is_static(true);
+    }
+    static_batch_renderer.Build(
+        models_to_draw,
+        std::vector<GLuint>(texture_ids,
+                            texture_ids + models_to_draw.size()),
+        10.0f);
+    static_batches = &static_batch_renderer;
+  }
+
+  // Storage buffers holding the meshes of all the models.
+  wvu::VertexPullingRenderer vertex_pulling_renderer;
+  bool use_vertex_pulling = FLAGS_vertex_pulling;
+  if (use_vertex_pulling && !wvu::VertexPullingRenderer::IsSupported()) {
+    std::cerr << "WARNING: Vertex pulling requires OpenGL 4.3. Disabling it.\n";
+    use_vertex_pulling = false;
+  }
+  if (use_vertex_pulling) {
+    std::string error_info_log;
+    if (!vertex_pulling_renderer.Initialize(&error_info_log)) {
+      std::cerr << "ERROR: " << error_info_log << "\n";
+      return -1;
+    }
+    for (const Model* model : models_to_draw) {
+      vertex_pulling_renderer.AddMesh(model->vertices(), model->indices(),
+                                      wvu::VertexFormat::COMPACT);
+    }
+  }
+
+  // Debug lines, compiled out in release builds.
+  wvu::DebugDraw debug_draw;
+  const bool use_debug_draw = WVU_DEBUG_DRAW && FLAGS_debug_draw;
+  if (use_debug_draw) {
+    std::string error_info_log;
+    if (!debug_draw.Initialize(&error_info_log)) {
+      std::cerr << "ERROR: " << error_info_log << "\n";
+      return -1;
+    }
+  }
+
+  // Animations of the dynamic models. They are evaluated at the start of
+  // every frame, so that drawing only reads the poses.
+  const wvu::AnimationClip spin_clip = CreateSpinClip();
+  wvu::TransformStore animated_transforms;
+  wvu::Animator animator;
+  std::vector<Model*> animated_models;
+  if (FLAGS_animate_models) {
+    for (Model* model : models_to_draw) {
+      if (model->is_static()) continue;
+      animator.Play(&spin_clip, animated_transforms.Add(*model), 0.0f);
+      animated_models.push_back(model);
+    }
+  }
+  wvu::ThreadPool animation_thread_pool(std::thread::hardware_concurrency());
+
+  // Statistics of the frames of the benchmarks.
+  wvu::FrameProfiler frame_profiler;
+  const bool is_benchmark = FLAGS_benchmark_frames > 0;
+  const int num_benchmark_frames =
+      FLAGS_benchmark_warmup_frames + FLAGS_benchmark_frames;
+  wvu::Camera benchmark_camera(camera_params);
+  benchmark_camera.Initialize();
+  if (is_benchmark) frame_profiler.Initialize();
+  int frame = 0;
 
   // Loop until the user closes the window.
+  double previous_time = glfwGetTime();
   while (!glfwWindowShouldClose(window)) {
+    const bool is_profiled =
+        is_benchmark && frame >= FLAGS_benchmark_warmup_frames;
+    if (is_profiled) {
+      frame_profiler.BeginFrame();
+      frame_profiler.BeginStage("update");
+    }
+    if (is_benchmark) {
+      view = ComputeBenchmarkView(frame, num_benchmark_frames,
+                                  &benchmark_camera);
+    }
+    asset_manager.Update();
+    if (animator.num_animations() > 0) {
+      animator.Evaluate(glfwGetTime(), &animation_thread_pool,
+                        &animated_transforms);
+      for (int i = 0; i < animated_models.size(); i++) {
+        animated_transforms.Apply(i, animated_models[i]);
+      }
+    }
+    for (int i = 0; i < texture_handles.size(); i++) {
+      texture_ids[i] = asset_manager.GetTextureId(texture_handles[i]);
+    }
+    // Models beyond the impostor distance are replaced by their impostors.
+    std::vector<Model*>* opaque_models = &models_to_draw;
+    GLuint* opaque_texture_ids = texture_ids;
+    if (is_profiled) frame_profiler.BeginStage("select");
+    if (use_impostors) {
+      SelectImpostors(camera.position(), FLAGS_impostor_distance,
+                      &models_to_draw, texture_ids, &near_models,
+                      &near_texture_ids, &far_model_indices);
+      opaque_models = &near_models;
+      opaque_texture_ids = near_texture_ids.data();
+    }
     // Render the scene!
-    RenderScene(shader_program, projection, view, &models_to_draw, window, texture_ids);
+    if (is_profiled) frame_profiler.BeginStage("render");
+    if (use_gpu_culling) {
+      int framebuffer_width;
+      int framebuffer_height;
+      glfwGetFramebufferSize(window, &framebuffer_width, &framebuffer_height);
+      if (use_deferred_renderer && FLAGS_shadows) {
+        shadow_maps.Render(camera, static_models, dynamic_models);
+      }
+      RenderSceneGpuCulled(projection, view, models_to_draw, cullers,
+                           culler_model_indices, texture_ids,
+                           use_deferred_renderer ? &deferred_renderer
+                                                 : nullptr,
+                           lights, framebuffer_width, framebuffer_height);
+    } else if (use_deferred_renderer) {
+      if (FLAGS_shadows) {
+        shadow_maps.Render(camera, static_models, dynamic_models);
+      }
+      RenderSceneDeferred(&deferred_renderer, lights, projection, view,
+                          opaque_models, opaque_texture_ids,
+                          static_batches);
+    } else if (use_vertex_pulling) {
+      RenderScenePulled(&vertex_pulling_renderer, shader_program, projection,
+                        view, models_to_draw, opaque_models,
+                        opaque_texture_ids, static_batches);
+    } else {
+      if (use_wireframe) wireframe_shader.Use();
+      RenderScene(forward_shader_program, projection, view, opaque_models,
+                  window, opaque_texture_ids, static_batches);
+    }
+    if (is_profiled) frame_profiler.BeginStage("overlays");
+    if (use_impostors && !use_gpu_culling) {
+      for (const int i : far_model_indices) {
+        if (FLAGS_static_batching && models_to_draw[i]->is_static()) continue;
+        impostor_renderer.Draw(impostors[i],
+                               {models_to_draw[i]->ComputeModelMatrix()},
+                               projection, view);
+      }
+    }
+    if (use_debug_draw) {
+      AddModelDebugGeometry(models_to_draw, &debug_draw);
+      debug_draw.Flush(projection, view);
+    }
+    if (use_transparency_pass) {
+      RenderTransparentModels(&transparency_pass, projection, view,
+                              &models_to_draw, texture_ids);
+    }
+    // The particles are drawn on top of the opaque scene.
+    const double current_time = glfwGetTime();
+    if (use_particles) {
+      particle_system.Update(current_time - previous_time);
+      particle_system.Draw(camera);
+    }
+    previous_time = current_time;
 
     // Swap front and back buffers.
+    if (is_profiled) frame_profiler.BeginStage("swap");
     glfwSwapBuffers(window);
+    if (wvu::IsRecordingGlTrace()) {
+      wvu::MarkGlTraceFrame();
+      if (++num_traced_frames == FLAGS_gl_trace_frames) {
+        wvu::StopGlTraceRecording();
+      }
+    }
 
     // Poll for and process events.
     glfwPollEvents();
+    if (is_profiled) frame_profiler.EndFrame();
+    if (is_benchmark && ++frame == num_benchmark_frames) break;
+  }
+  if (is_benchmark) {
+    frame_profiler.PrintReport(&std::cout);
+    if (!FLAGS_benchmark_output.empty()) {
+      std::ofstream json_file(FLAGS_benchmark_output);
+      json_file << frame_profiler.ToJson();
+      if (!json_file) {
+        std::cerr << "ERROR: Could not write " << FLAGS_benchmark_output
+                  << "\n";
+      }
+    }
   }
 
   // Cleaning up tasks.
+  for (wvu::Impostor& impostor : impostors) {
+    wvu::DeleteImpostor(&impostor);
+  }
+  // The shared context has to go before the main window.
+  upload_thread.Stop();
   DeleteModels(&models_to_draw);
+  glDeleteTextures(stress_texture_ids.size(), stress_texture_ids.data());
+  for (wvu::GpuCuller* culler : cullers) {
+    delete culler;
+  }
+  wvu::StopGlTraceRecording();
   // Destroy window.
   glfwDestroyWindow(window);
   // Tear down GLFW library.
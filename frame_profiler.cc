@@ -0,0 +1,187 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#include "frame_profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <GL/glew.h>
+
+#include "benchmark.h"
+#include "gl_stats.h"
+
+namespace wvu {
+namespace {
+
+// Number of frames in flight the timer queries can cover.
+constexpr int kNumTimerQueries = 4;
+
+double ElapsedMilliseconds(const std::chrono::steady_clock::time_point& start,
+                           const std::chrono::steady_clock::time_point& end) {
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+}  // namespace
+
+FrameProfiler::FrameProfiler() : current_stage_(-1), frame_index_(0) {}
+
+FrameProfiler::~FrameProfiler() {
+  if (!query_ids_.empty()) {
+    glDeleteQueries(query_ids_.size(), query_ids_.data());
+  }
+}
+
+void FrameProfiler::Initialize() {
+  if (!GLEW_VERSION_3_3 && !GLEW_ARB_timer_query) return;
+  query_ids_.resize(kNumTimerQueries);
+  is_query_pending_.assign(kNumTimerQueries, false);
+  glGenQueries(kNumTimerQueries, query_ids_.data());
+}
+
+void FrameProfiler::BeginFrame() {
+  ResetGlCallStats();
+  std::fill(current_stage_ms_.begin(), current_stage_ms_.end(), 0.0);
+  if (!query_ids_.empty()) {
+    const int slot = frame_index_ % kNumTimerQueries;
+    if (is_query_pending_[slot]) ReadQuery(slot);
+    glBeginQuery(GL_TIME_ELAPSED, query_ids_[slot]);
+  }
+  frame_start_ = Clock::now();
+}
+
+void FrameProfiler::BeginStage(const std::string& name) {
+  EndStage();
+  const auto stage = std::find(stage_names_.begin(), stage_names_.end(),
+                               name);
+  current_stage_ = stage - stage_names_.begin();
+  if (stage == stage_names_.end()) {
+    stage_names_.push_back(name);
+    current_stage_ms_.push_back(0.0);
+    // The frames before the first appearance of the stage spent no time in
+    // it.
+    stage_ms_.emplace_back(frame_ms_.size(), 0.0);
+  }
+  stage_start_ = Clock::now();
+}
+
+void FrameProfiler::EndStage() {
+  if (current_stage_ < 0) return;
+  current_stage_ms_[current_stage_] +=
+      ElapsedMilliseconds(stage_start_, Clock::now());
+  current_stage_ = -1;
+}
+
+void FrameProfiler::EndFrame() {
+  EndStage();
+  frame_ms_.push_back(ElapsedMilliseconds(frame_start_, Clock::now()));
+  for (int i = 0; i < stage_names_.size(); ++i) {
+    stage_ms_[i].push_back(current_stage_ms_[i]);
+  }
+  const GlCallStats stats = GetGlCallStats();
+  draw_calls_.push_back(stats.draw_calls);
+  state_changes_.push_back(stats.state_changes);
+  uniform_updates_.push_back(stats.uniform_updates);
+  if (!query_ids_.empty()) {
+    glEndQuery(GL_TIME_ELAPSED);
+    is_query_pending_[frame_index_ % kNumTimerQueries] = true;
+  }
+  ++frame_index_;
+}
+
+void FrameProfiler::ReadQuery(const int slot) {
+  GLuint64 elapsed_ns = 0;
+  glGetQueryObjectui64v(query_ids_[slot], GL_QUERY_RESULT, &elapsed_ns);
+  gpu_ms_.push_back(elapsed_ns * 1e-6);
+  is_query_pending_[slot] = false;
+}
+
+std::vector<std::pair<std::string, const std::vector<double>*> >
+FrameProfiler::GetMetrics() const {
+  std::vector<std::pair<std::string, const std::vector<double>*> > metrics;
+  for (int i = 0; i < stage_names_.size(); ++i) {
+    metrics.emplace_back("cpu_ms/" + stage_names_[i], &stage_ms_[i]);
+  }
+  metrics.emplace_back("cpu_ms/frame", &frame_ms_);
+  metrics.emplace_back("gpu_ms/frame", &gpu_ms_);
+  metrics.emplace_back("draw_calls", &draw_calls_);
+  metrics.emplace_back("state_changes", &state_changes_);
+  metrics.emplace_back("uniform_updates", &uniform_updates_);
+  return metrics;
+}
+
+void FrameProfiler::PrintReport(std::ostream* stream) const {
+  if (stream == nullptr) return;
+  *stream << "Frames: " << num_frames() << "\n"
+          << std::left << std::setw(20) << "Metric (per frame)" << std::right
+          << std::setw(12) << "median" << std::setw(12) << "MAD"
+          << std::setw(12) << "min" << "\n"
+          << std::fixed << std::setprecision(3);
+  for (const auto& metric : GetMetrics()) {
+    if (metric.second->empty()) continue;
+    const SampleSummary summary = SummarizeSamples(*metric.second);
+    *stream << std::left << std::setw(20) << metric.first << std::right
+            << std::setw(12) << summary.median
+            << std::setw(12) << summary.median_absolute_deviation
+            << std::setw(12) << summary.min << "\n";
+  }
+  stream->unsetf(std::ios_base::floatfield);
+}
+
+std::string FrameProfiler::ToJson() const {
+  std::ostringstream json;
+  json << std::setprecision(9);
+  json << "{\n  \"num_frames\": " << num_frames() << ",\n  \"metrics\": {";
+  bool is_first = true;
+  for (const auto& metric : GetMetrics()) {
+    if (metric.second->empty()) continue;
+    const SampleSummary summary = SummarizeSamples(*metric.second);
+    json << (is_first ? "" : ",") << "\n    \"" << metric.first
+         << "\": {\"min\": " << summary.min
+         << ", \"median\": " << summary.median
+         << ", \"mean\": " << summary.mean
+         << ", \"median_absolute_deviation\": "
+         << summary.median_absolute_deviation << "}";
+    is_first = false;
+  }
+  json << "\n  }\n}\n";
+  return json.str();
+}
+
+}  // namespace wvu
@@ -0,0 +1,122 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef FRAME_PROFILER_H_
+#define FRAME_PROFILER_H_
+
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <GL/glew.h>
+
+namespace wvu {
+
+// Collects per-frame statistics of the render loop: the CPU time of each
+// stage of the frame, the GPU time of the whole frame (through timer
+// queries), and the OpenGL calls of the render thread (see gl_stats.h).
+// Usage example:
+//
+// wvu::FrameProfiler profiler;
+// profiler.Initialize();
+// while (...) {  // Rendering loop.
+//   profiler.BeginFrame();
+//   profiler.BeginStage("update");
+//   ...
+//   profiler.BeginStage("render");
+//   ...
+//   profiler.EndFrame();
+// }
+// profiler.PrintReport(&std::cout);
+class FrameProfiler {
+ public:
+  FrameProfiler();
+  ~FrameProfiler();
+
+  // Creates the timer queries. Without timer query support (OpenGL 3.3) the
+  // GPU times are not reported.
+  void Initialize();
+
+  // Starts the timing of a frame.
+  void BeginFrame();
+
+  // Ends the running stage, if any, and starts the given one. A stage may
+  // run several times per frame; its times are added up.
+  void BeginStage(const std::string& name);
+
+  // Ends the running stage and the frame, and records its statistics.
+  void EndFrame();
+
+  // Prints the median and the MAD of every metric per frame.
+  void PrintReport(std::ostream* stream) const;
+
+  // Returns the summaries of the metrics as a JSON document.
+  std::string ToJson() const;
+
+  int num_frames() const { return frame_ms_.size(); }
+
+ private:
+  // Closes the running stage.
+  void EndStage();
+  // Records the GPU time of the query in the given slot of the ring.
+  void ReadQuery(const int slot);
+  // Returns the metrics and their samples, in report order.
+  std::vector<std::pair<std::string, const std::vector<double>*> >
+  GetMetrics() const;
+
+  typedef std::chrono::steady_clock Clock;
+  // Names of the stages, in order of appearance, and their time in the
+  // current frame and in every recorded frame.
+  std::vector<std::string> stage_names_;
+  std::vector<double> current_stage_ms_;
+  std::vector<std::vector<double> > stage_ms_;
+  int current_stage_;
+  Clock::time_point frame_start_;
+  Clock::time_point stage_start_;
+  // Per-frame samples.
+  std::vector<double> frame_ms_;
+  std::vector<double> gpu_ms_;
+  std::vector<double> draw_calls_;
+  std::vector<double> state_changes_;
+  std::vector<double> uniform_updates_;
+  // Ring of timer queries. A query is read when its slot is reused a few
+  // frames later, so reading it does not stall the pipeline.
+  std::vector<GLuint> query_ids_;
+  std::vector<bool> is_query_pending_;
+  int frame_index_;
+};
+
+}  // namespace wvu
+
+#endif  // FRAME_PROFILER_H_
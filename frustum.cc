@@ -0,0 +1,86 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#include "frustum.h"
+
+#include <Eigen/Core>
+
+namespace wvu {
+
+void ExtractFrustumPlanes(const Eigen::Matrix4f& view_projection,
+                          Eigen::Vector4f planes[kNumFrustumPlanes]) {
+  // A clip-space point is inside the frustum when -w <= x, y, z <= w, and
+  // every inequality is a plane equation on the rows of the matrix.
+  const Eigen::RowVector4f row_x = view_projection.row(0);
+  const Eigen::RowVector4f row_y = view_projection.row(1);
+  const Eigen::RowVector4f row_z = view_projection.row(2);
+  const Eigen::RowVector4f row_w = view_projection.row(3);
+  planes[0] = (row_w + row_x).transpose();
+  planes[1] = (row_w - row_x).transpose();
+  planes[2] = (row_w + row_y).transpose();
+  planes[3] = (row_w - row_y).transpose();
+  planes[4] = (row_w + row_z).transpose();
+  planes[5] = (row_w - row_z).transpose();
+  for (int i = 0; i < kNumFrustumPlanes; ++i) {
+    planes[i] /= planes[i].head<3>().norm();
+  }
+}
+
+bool IsSphereInFrustum(const Eigen::Vector4f planes[kNumFrustumPlanes],
+                       const Eigen::Vector3f& center,
+                       const float radius) {
+  for (int i = 0; i < kNumFrustumPlanes; ++i) {
+    if (planes[i].head<3>().dot(center) + planes[i].w() < -radius) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool IsBoxInFrustum(const Eigen::Vector4f planes[kNumFrustumPlanes],
+                    const Eigen::Vector3f& min_corner,
+                    const Eigen::Vector3f& max_corner) {
+  for (int i = 0; i < kNumFrustumPlanes; ++i) {
+    // The corner of the box farthest along the plane normal.
+    const Eigen::Vector3f farthest_corner =
+        (planes[i].head<3>().array() >= 0.0f)
+            .select(max_corner, min_corner);
+    if (planes[i].head<3>().dot(farthest_corner) + planes[i].w() < 0.0f) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace wvu
@@ -0,0 +1,78 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef FRUSTUM_H_
+#define FRUSTUM_H_
+
+#include <Eigen/Core>
+
+namespace wvu {
+// Number of planes bounding a view frustum.
+constexpr int kNumFrustumPlanes = 6;
+
+// Extracts the planes bounding the view frustum of a view-projection matrix
+// (Gribb-Hartmann method). Every plane is stored as (n, d), with n the unit
+// normal pointing inside the frustum, so a point p is inside the frustum when
+// n.dot(p) + d >= 0 for all the planes. The planes are ordered as left,
+// right, bottom, top, near, far.
+// Params:
+//   view_projection  The product projection * view.
+//   planes  The output planes.
+void ExtractFrustumPlanes(const Eigen::Matrix4f& view_projection,
+                          Eigen::Vector4f planes[kNumFrustumPlanes]);
+
+// Returns true when the sphere intersects or is inside the frustum. The test
+// is conservative: a few spheres near the frustum corners are reported as
+// visible even though they are outside.
+// Params:
+//   planes  The frustum planes (see ExtractFrustumPlanes).
+//   center  The center of the sphere.
+//   radius  The radius of the sphere.
+bool IsSphereInFrustum(const Eigen::Vector4f planes[kNumFrustumPlanes],
+                       const Eigen::Vector3f& center,
+                       const float radius);
+
+// Returns true when the axis-aligned box intersects or is inside the frustum.
+// Like IsSphereInFrustum, the test is conservative.
+// Params:
+//   planes  The frustum planes (see ExtractFrustumPlanes).
+//   min_corner  The corner of the box with the smallest coordinates.
+//   max_corner  The corner of the box with the largest coordinates.
+bool IsBoxInFrustum(const Eigen::Vector4f planes[kNumFrustumPlanes],
+                    const Eigen::Vector3f& min_corner,
+                    const Eigen::Vector3f& max_corner);
+
+}  // namespace wvu
+
+#endif  // FRUSTUM_H_
@@ -0,0 +1,526 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#include "gl_stats.h"
+
+// This file defines OpenGL entry points, so it cannot include GLEW, which
+// turns their names into macros. The types come from the system headers.
+#include <dlfcn.h>
+#include <GL/gl.h>
+#include <GL/glext.h>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include <glog/logging.h>
+
+#include "gl_trace.h"
+
+namespace wvu {
+namespace {
+
+thread_local GlCallStats thread_stats = {0, 0, 0};
+
+typedef void (*GlFunction)();
+typedef GlFunction (*GetProcAddressFunction)(const GLubyte*);
+
+// Returns the entry point of libGL that a wrapper forwards to.
+GlFunction ResolveGlFunction(const char* name) {
+  GlFunction function =
+      reinterpret_cast<GlFunction>(dlsym(RTLD_NEXT, name));
+  if (function != nullptr) return function;
+  // Not exported: ask the driver, bypassing the interposed loader.
+  static const GetProcAddressFunction get_proc_address =
+      reinterpret_cast<GetProcAddressFunction>(
+          dlsym(RTLD_NEXT, "glXGetProcAddressARB"));
+  return get_proc_address == nullptr ? nullptr :
+      get_proc_address(reinterpret_cast<const GLubyte*>(name));
+}
+
+// Records a call whose arguments are all 32-bit words.
+template <typename... Args>
+void Record(const GlTraceOpcode opcode, const Args... args) {
+  RecordGlCall(opcode, {static_cast<uint32_t>(args)...});
+}
+
+// Records a call with the data it reads.
+template <typename... Args>
+void RecordWithBlob(const GlTraceOpcode opcode,
+                    const void* blob,
+                    const size_t blob_size,
+                    const Args... args) {
+  RecordGlCall(opcode, {static_cast<uint32_t>(args)...}, blob, blob_size);
+}
+
+// Records a call the replayer cannot issue.
+void RecordUnsupported(const char* name) {
+  RecordGlCall(GlTraceOpcode::UNSUPPORTED, {}, name, std::strlen(name));
+}
+
+// The low and the high words of a 64-bit argument.
+uint32_t LowWord(const int64_t value) {
+  return static_cast<uint64_t>(value) & 0xFFFFFFFF;
+}
+uint32_t HighWord(const int64_t value) {
+  return static_cast<uint64_t>(value) >> 32;
+}
+int64_t ToInt64(const void* pointer) {
+  return reinterpret_cast<intptr_t>(pointer);
+}
+
+// Records the concatenated strings of glShaderSource.
+void RecordShaderSource(const GLuint shader,
+                        const GLsizei count,
+                        const GLchar* const* strings,
+                        const GLint* lengths) {
+  std::string source;
+  for (int i = 0; i < count; ++i) {
+    if (lengths == nullptr || lengths[i] < 0) {
+      source.append(strings[i]);
+    } else {
+      source.append(strings[i], lengths[i]);
+    }
+  }
+  RecordWithBlob(GlTraceOpcode::SHADER_SOURCE, source.data(), source.size(),
+                 shader);
+}
+
+// Returns the bound buffer of a target, bypassing the wrappers.
+GLint GetBinding(const GLenum binding) {
+  GLint buffer = 0;
+  glGetIntegerv(binding, &buffer);
+  return buffer;
+}
+
+// Returns the number of bytes glTexImage2D reads from client memory.
+size_t GetTexImageSize(const GLsizei width,
+                       const GLsizei height,
+                       const GLenum format,
+                       const GLenum type) {
+  GLint alignment = 4;
+  glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+  return wvu::GetGlTexImageSize(width, height, format, type, alignment);
+}
+
+}  // namespace
+
+GlCallStats GetGlCallStats() {
+  return thread_stats;
+}
+
+void ResetGlCallStats() {
+  thread_stats = {0, 0, 0};
+}
+
+}  // namespace wvu
+
+// Declares `function`, the entry point of libGL that a wrapper forwards to.
+#define WVU_RESOLVE_GL_FUNCTION(type, name, params)                       \
+  typedef type (GLAPIENTRY *Function) params;                            \
+  static const Function function =                                       \
+      reinterpret_cast<Function>(wvu::ResolveGlFunction(#name));         \
+  CHECK(function != nullptr) << "libGL does not provide " #name
+
+// Defines a wrapper that counts a call, forwards it to libGL and, while a
+// trace is recorded (see gl_trace.h), records it.
+#define WVU_COUNTED_GL_FUNCTION(counter, name, params, args, record)     \
+  extern "C" void GLAPIENTRY name params {                               \
+    ++wvu::thread_stats.counter;                                         \
+    WVU_RESOLVE_GL_FUNCTION(void, name, params);                         \
+    function args;                                                       \
+    if (wvu::IsRecordingGlTrace()) record;                               \
+  }
+
+// Defines a wrapper that forwards a call to libGL and records it.
+#define WVU_TRACED_GL_FUNCTION(name, params, args, record)               \
+  extern "C" void GLAPIENTRY name params {                               \
+    WVU_RESOLVE_GL_FUNCTION(void, name, params);                         \
+    function args;                                                       \
+    if (wvu::IsRecordingGlTrace()) record;                               \
+  }
+
+using wvu::GlTraceOpcode;
+
+WVU_COUNTED_GL_FUNCTION(draw_calls, glDrawArrays,
+    (GLenum mode, GLint first, GLsizei count), (mode, first, count),
+    (wvu::Record(GlTraceOpcode::DRAW_ARRAYS, mode, first, count)))
+WVU_COUNTED_GL_FUNCTION(draw_calls, glDrawElements,
+    (GLenum mode, GLsizei count, GLenum type, const GLvoid* indices),
+    (mode, count, type, indices),
+    (wvu::Record(GlTraceOpcode::DRAW_ELEMENTS, mode, count, type,
+                 wvu::LowWord(wvu::ToInt64(indices)),
+                 wvu::HighWord(wvu::ToInt64(indices)))))
+WVU_COUNTED_GL_FUNCTION(draw_calls, glDrawArraysInstanced,
+    (GLenum mode, GLint first, GLsizei count, GLsizei instance_count),
+    (mode, first, count, instance_count),
+    (wvu::Record(GlTraceOpcode::DRAW_ARRAYS_INSTANCED, mode, first, count,
+                 instance_count)))
+WVU_COUNTED_GL_FUNCTION(draw_calls, glDrawElementsInstanced,
+    (GLenum mode, GLsizei count, GLenum type, const void* indices,
+     GLsizei instance_count),
+    (mode, count, type, indices, instance_count),
+    (wvu::Record(GlTraceOpcode::DRAW_ELEMENTS_INSTANCED, mode, count, type,
+                 wvu::LowWord(wvu::ToInt64(indices)),
+                 wvu::HighWord(wvu::ToInt64(indices)), instance_count)))
+WVU_COUNTED_GL_FUNCTION(draw_calls, glDrawArraysIndirect,
+    (GLenum mode, const void* indirect), (mode, indirect),
+    (wvu::RecordUnsupported("glDrawArraysIndirect")))
+WVU_COUNTED_GL_FUNCTION(draw_calls, glMultiDrawElementsIndirect,
+    (GLenum mode, GLenum type, const void* indirect, GLsizei draw_count,
+     GLsizei stride),
+    (mode, type, indirect, draw_count, stride),
+    (wvu::RecordUnsupported("glMultiDrawElementsIndirect")))
+WVU_COUNTED_GL_FUNCTION(draw_calls, glDispatchCompute,
+    (GLuint num_groups_x, GLuint num_groups_y, GLuint num_groups_z),
+    (num_groups_x, num_groups_y, num_groups_z),
+    (wvu::RecordUnsupported("glDispatchCompute")))
+WVU_COUNTED_GL_FUNCTION(draw_calls, glDispatchComputeIndirect,
+    (GLintptr indirect), (indirect),
+    (wvu::RecordUnsupported("glDispatchComputeIndirect")))
+
+WVU_COUNTED_GL_FUNCTION(state_changes, glUseProgram,
+    (GLuint program), (program),
+    (wvu::Record(GlTraceOpcode::USE_PROGRAM, program)))
+WVU_COUNTED_GL_FUNCTION(state_changes, glBindVertexArray,
+    (GLuint array), (array),
+    (wvu::Record(GlTraceOpcode::BIND_VERTEX_ARRAY, array)))
+WVU_COUNTED_GL_FUNCTION(state_changes, glBindBuffer,
+    (GLenum target, GLuint buffer), (target, buffer),
+    (wvu::Record(GlTraceOpcode::BIND_BUFFER, target, buffer)))
+WVU_COUNTED_GL_FUNCTION(state_changes, glBindBufferBase,
+    (GLenum target, GLuint index, GLuint buffer), (target, index, buffer),
+    (wvu::RecordUnsupported("glBindBufferBase")))
+WVU_COUNTED_GL_FUNCTION(state_changes, glBindTexture,
+    (GLenum target, GLuint texture), (target, texture),
+    (wvu::Record(GlTraceOpcode::BIND_TEXTURE, target, texture)))
+WVU_COUNTED_GL_FUNCTION(state_changes, glActiveTexture,
+    (GLenum texture), (texture),
+    (wvu::Record(GlTraceOpcode::ACTIVE_TEXTURE, texture)))
+WVU_COUNTED_GL_FUNCTION(state_changes, glBindFramebuffer,
+    (GLenum target, GLuint framebuffer), (target, framebuffer),
+    (wvu::Record(GlTraceOpcode::BIND_FRAMEBUFFER, target, framebuffer)))
+WVU_COUNTED_GL_FUNCTION(state_changes, glEnable, (GLenum cap), (cap),
+    (wvu::Record(GlTraceOpcode::ENABLE, cap)))
+WVU_COUNTED_GL_FUNCTION(state_changes, glDisable, (GLenum cap), (cap),
+    (wvu::Record(GlTraceOpcode::DISABLE, cap)))
+WVU_COUNTED_GL_FUNCTION(state_changes, glBlendFunc,
+    (GLenum sfactor, GLenum dfactor), (sfactor, dfactor),
+    (wvu::Record(GlTraceOpcode::BLEND_FUNC, sfactor, dfactor)))
+WVU_COUNTED_GL_FUNCTION(state_changes, glDepthMask,
+    (GLboolean flag), (flag),
+    (wvu::Record(GlTraceOpcode::DEPTH_MASK, flag)))
+WVU_COUNTED_GL_FUNCTION(state_changes, glPolygonMode,
+    (GLenum face, GLenum mode), (face, mode),
+    (wvu::Record(GlTraceOpcode::POLYGON_MODE, face, mode)))
+
+WVU_COUNTED_GL_FUNCTION(uniform_updates, glUniform1i,
+    (GLint location, GLint v0), (location, v0),
+    (wvu::Record(GlTraceOpcode::UNIFORM_1I, location, v0)))
+WVU_COUNTED_GL_FUNCTION(uniform_updates, glUniform1ui,
+    (GLint location, GLuint v0), (location, v0),
+    (wvu::RecordUnsupported("glUniform1ui")))
+WVU_COUNTED_GL_FUNCTION(uniform_updates, glUniform1f,
+    (GLint location, GLfloat v0), (location, v0),
+    (wvu::Record(GlTraceOpcode::UNIFORM_1F, location,
+                 wvu::EncodeGlTraceFloat(v0))))
+WVU_COUNTED_GL_FUNCTION(uniform_updates, glUniform2f,
+    (GLint location, GLfloat v0, GLfloat v1), (location, v0, v1),
+    (wvu::RecordUnsupported("glUniform2f")))
+WVU_COUNTED_GL_FUNCTION(uniform_updates, glUniform1fv,
+    (GLint location, GLsizei count, const GLfloat* value),
+    (location, count, value),
+    (wvu::RecordUnsupported("glUniform1fv")))
+WVU_COUNTED_GL_FUNCTION(uniform_updates, glUniform3fv,
+    (GLint location, GLsizei count, const GLfloat* value),
+    (location, count, value),
+    (wvu::RecordWithBlob(GlTraceOpcode::UNIFORM_3FV, value,
+                         3 * count * sizeof(*value), location, count)))
+WVU_COUNTED_GL_FUNCTION(uniform_updates, glUniform4fv,
+    (GLint location, GLsizei count, const GLfloat* value),
+    (location, count, value),
+    (wvu::RecordWithBlob(GlTraceOpcode::UNIFORM_4FV, value,
+                         4 * count * sizeof(*value), location, count)))
+WVU_COUNTED_GL_FUNCTION(uniform_updates, glUniformMatrix3fv,
+    (GLint location, GLsizei count, GLboolean transpose,
+     const GLfloat* value),
+    (location, count, transpose, value),
+    (wvu::RecordUnsupported("glUniformMatrix3fv")))
+WVU_COUNTED_GL_FUNCTION(uniform_updates, glUniformMatrix4fv,
+    (GLint location, GLsizei count, GLboolean transpose,
+     const GLfloat* value),
+    (location, count, transpose, value),
+    (wvu::RecordWithBlob(GlTraceOpcode::UNIFORM_MATRIX_4FV, value,
+                         16 * count * sizeof(*value), location, count,
+                         transpose)))
+
+// The calls below are not counted; they are only interposed to be traced.
+WVU_TRACED_GL_FUNCTION(glGenBuffers, (GLsizei n, GLuint* buffers),
+    (n, buffers),
+    (wvu::RecordWithBlob(GlTraceOpcode::GEN_BUFFERS, buffers,
+                         n * sizeof(*buffers), n)))
+WVU_TRACED_GL_FUNCTION(glDeleteBuffers, (GLsizei n, const GLuint* buffers),
+    (n, buffers),
+    (wvu::RecordWithBlob(GlTraceOpcode::DELETE_BUFFERS, buffers,
+                         n * sizeof(*buffers), n)))
+WVU_TRACED_GL_FUNCTION(glBufferData,
+    (GLenum target, GLsizeiptr size, const GLvoid* data, GLenum usage),
+    (target, size, data, usage),
+    (wvu::RecordWithBlob(GlTraceOpcode::BUFFER_DATA, data,
+                         data == nullptr ? 0 : size, target,
+                         wvu::LowWord(size), wvu::HighWord(size), usage,
+                         data != nullptr)))
+WVU_TRACED_GL_FUNCTION(glBufferSubData,
+    (GLenum target, GLintptr offset, GLsizeiptr size, const GLvoid* data),
+    (target, offset, size, data),
+    (wvu::RecordWithBlob(GlTraceOpcode::BUFFER_SUB_DATA, data, size, target,
+                         wvu::LowWord(offset), wvu::HighWord(offset),
+                         wvu::LowWord(size), wvu::HighWord(size))))
+WVU_TRACED_GL_FUNCTION(glGenVertexArrays, (GLsizei n, GLuint* arrays),
+    (n, arrays),
+    (wvu::RecordWithBlob(GlTraceOpcode::GEN_VERTEX_ARRAYS, arrays,
+                         n * sizeof(*arrays), n)))
+WVU_TRACED_GL_FUNCTION(glDeleteVertexArrays,
+    (GLsizei n, const GLuint* arrays), (n, arrays),
+    (wvu::RecordWithBlob(GlTraceOpcode::DELETE_VERTEX_ARRAYS, arrays,
+                         n * sizeof(*arrays), n)))
+// Offsets into the bound buffer are recorded; client arrays are not.
+WVU_TRACED_GL_FUNCTION(glVertexAttribPointer,
+    (GLuint index, GLint size, GLenum type, GLboolean normalized,
+     GLsizei stride, const GLvoid* pointer),
+    (index, size, type, normalized, stride, pointer),
+    (wvu::Record(GlTraceOpcode::VERTEX_ATTRIB_POINTER, index, size, type,
+                 normalized, stride, wvu::LowWord(wvu::ToInt64(pointer)),
+                 wvu::HighWord(wvu::ToInt64(pointer)))))
+WVU_TRACED_GL_FUNCTION(glEnableVertexAttribArray, (GLuint index), (index),
+    (wvu::Record(GlTraceOpcode::ENABLE_VERTEX_ATTRIB_ARRAY, index)))
+WVU_TRACED_GL_FUNCTION(glGenTextures, (GLsizei n, GLuint* textures),
+    (n, textures),
+    (wvu::RecordWithBlob(GlTraceOpcode::GEN_TEXTURES, textures,
+                         n * sizeof(*textures), n)))
+WVU_TRACED_GL_FUNCTION(glDeleteTextures, (GLsizei n, const GLuint* textures),
+    (n, textures),
+    (wvu::RecordWithBlob(GlTraceOpcode::DELETE_TEXTURES, textures,
+                         n * sizeof(*textures), n)))
+WVU_TRACED_GL_FUNCTION(glTexParameteri,
+    (GLenum target, GLenum pname, GLint param), (target, pname, param),
+    (wvu::Record(GlTraceOpcode::TEX_PARAMETER_I, target, pname, param)))
+WVU_TRACED_GL_FUNCTION(glPixelStorei, (GLenum pname, GLint param),
+    (pname, param),
+    (wvu::Record(GlTraceOpcode::PIXEL_STORE_I, pname, param)))
+// Uploads from a pixel unpack buffer cannot be replayed: the contents of the
+// buffer are not known to the trace.
+WVU_TRACED_GL_FUNCTION(glTexImage2D,
+    (GLenum target, GLint level, GLint internal_format, GLsizei width,
+     GLsizei height, GLint border, GLenum format, GLenum type,
+     const GLvoid* pixels),
+    (target, level, internal_format, width, height, border, format, type,
+     pixels),
+    (wvu::GetBinding(GL_PIXEL_UNPACK_BUFFER_BINDING) != 0 ?
+         wvu::RecordUnsupported("glTexImage2D") :
+         wvu::RecordWithBlob(
+             GlTraceOpcode::TEX_IMAGE_2D, pixels,
+             pixels == nullptr ? 0 :
+                 wvu::GetTexImageSize(width, height, format, type),
+             target, level, internal_format, width, height, border, format,
+             type, pixels != nullptr)))
+WVU_TRACED_GL_FUNCTION(glCompressedTexImage2D,
+    (GLenum target, GLint level, GLenum internal_format, GLsizei width,
+     GLsizei height, GLint border, GLsizei image_size, const GLvoid* data),
+    (target, level, internal_format, width, height, border, image_size,
+     data),
+    (wvu::GetBinding(GL_PIXEL_UNPACK_BUFFER_BINDING) != 0 ?
+         wvu::RecordUnsupported("glCompressedTexImage2D") :
+         wvu::RecordWithBlob(GlTraceOpcode::COMPRESSED_TEX_IMAGE_2D, data,
+                             image_size, target, level, internal_format,
+                             width, height, border, image_size)))
+WVU_TRACED_GL_FUNCTION(glGenerateMipmap, (GLenum target), (target),
+    (wvu::Record(GlTraceOpcode::GENERATE_MIPMAP, target)))
+WVU_TRACED_GL_FUNCTION(glShaderSource,
+    (GLuint shader, GLsizei count, const GLchar* const* string,
+     const GLint* length),
+    (shader, count, string, length),
+    (wvu::RecordShaderSource(shader, count, string, length)))
+WVU_TRACED_GL_FUNCTION(glCompileShader, (GLuint shader), (shader),
+    (wvu::Record(GlTraceOpcode::COMPILE_SHADER, shader)))
+WVU_TRACED_GL_FUNCTION(glDeleteShader, (GLuint shader), (shader),
+    (wvu::Record(GlTraceOpcode::DELETE_SHADER, shader)))
+WVU_TRACED_GL_FUNCTION(glAttachShader, (GLuint program, GLuint shader),
+    (program, shader),
+    (wvu::Record(GlTraceOpcode::ATTACH_SHADER, program, shader)))
+WVU_TRACED_GL_FUNCTION(glLinkProgram, (GLuint program), (program),
+    (wvu::Record(GlTraceOpcode::LINK_PROGRAM, program)))
+WVU_TRACED_GL_FUNCTION(glDeleteProgram, (GLuint program), (program),
+    (wvu::Record(GlTraceOpcode::DELETE_PROGRAM, program)))
+WVU_TRACED_GL_FUNCTION(glViewport,
+    (GLint x, GLint y, GLsizei width, GLsizei height), (x, y, width, height),
+    (wvu::Record(GlTraceOpcode::VIEWPORT, x, y, width, height)))
+WVU_TRACED_GL_FUNCTION(glClearColor,
+    (GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha),
+    (red, green, blue, alpha),
+    (wvu::Record(GlTraceOpcode::CLEAR_COLOR, wvu::EncodeGlTraceFloat(red),
+                 wvu::EncodeGlTraceFloat(green),
+                 wvu::EncodeGlTraceFloat(blue),
+                 wvu::EncodeGlTraceFloat(alpha))))
+WVU_TRACED_GL_FUNCTION(glClear, (GLbitfield mask), (mask),
+    (wvu::Record(GlTraceOpcode::CLEAR, mask)))
+
+// The calls that return a name or a location record it with their arguments.
+extern "C" GLuint GLAPIENTRY glCreateShader(GLenum type) {
+  WVU_RESOLVE_GL_FUNCTION(GLuint, glCreateShader, (GLenum type));
+  const GLuint shader = function(type);
+  if (wvu::IsRecordingGlTrace()) {
+    wvu::Record(GlTraceOpcode::CREATE_SHADER, type, shader);
+  }
+  return shader;
+}
+
+extern "C" GLuint GLAPIENTRY glCreateProgram() {
+  WVU_RESOLVE_GL_FUNCTION(GLuint, glCreateProgram, ());
+  const GLuint program = function();
+  if (wvu::IsRecordingGlTrace()) {
+    wvu::Record(GlTraceOpcode::CREATE_PROGRAM, program);
+  }
+  return program;
+}
+
+extern "C" GLint GLAPIENTRY glGetUniformLocation(GLuint program,
+                                                 const GLchar* name) {
+  WVU_RESOLVE_GL_FUNCTION(GLint, glGetUniformLocation,
+                          (GLuint program, const GLchar* name));
+  const GLint location = function(program, name);
+  if (wvu::IsRecordingGlTrace()) {
+    wvu::RecordWithBlob(GlTraceOpcode::GET_UNIFORM_LOCATION, name,
+                        std::strlen(name), program, location);
+  }
+  return location;
+}
+
+#undef WVU_COUNTED_GL_FUNCTION
+#undef WVU_TRACED_GL_FUNCTION
+#undef WVU_RESOLVE_GL_FUNCTION
+
+namespace {
+
+struct InterposedGlFunction {
+  const char* name;
+  wvu::GlFunction wrapper;
+};
+
+#define WVU_GL_WRAPPER(name) \
+  {#name, reinterpret_cast<wvu::GlFunction>(&::name)}
+const InterposedGlFunction kInterposedGlFunctions[] = {
+  WVU_GL_WRAPPER(glDrawArrays),
+  WVU_GL_WRAPPER(glDrawElements),
+  WVU_GL_WRAPPER(glDrawArraysInstanced),
+  WVU_GL_WRAPPER(glDrawElementsInstanced),
+  WVU_GL_WRAPPER(glDrawArraysIndirect),
+  WVU_GL_WRAPPER(glMultiDrawElementsIndirect),
+  WVU_GL_WRAPPER(glDispatchCompute),
+  WVU_GL_WRAPPER(glDispatchComputeIndirect),
+  WVU_GL_WRAPPER(glUseProgram),
+  WVU_GL_WRAPPER(glBindVertexArray),
+  WVU_GL_WRAPPER(glBindBuffer),
+  WVU_GL_WRAPPER(glBindBufferBase),
+  WVU_GL_WRAPPER(glBindTexture),
+  WVU_GL_WRAPPER(glActiveTexture),
+  WVU_GL_WRAPPER(glBindFramebuffer),
+  WVU_GL_WRAPPER(glEnable),
+  WVU_GL_WRAPPER(glDisable),
+  WVU_GL_WRAPPER(glBlendFunc),
+  WVU_GL_WRAPPER(glDepthMask),
+  WVU_GL_WRAPPER(glPolygonMode),
+  WVU_GL_WRAPPER(glUniform1i),
+  WVU_GL_WRAPPER(glUniform1ui),
+  WVU_GL_WRAPPER(glUniform1f),
+  WVU_GL_WRAPPER(glUniform2f),
+  WVU_GL_WRAPPER(glUniform1fv),
+  WVU_GL_WRAPPER(glUniform3fv),
+  WVU_GL_WRAPPER(glUniform4fv),
+  WVU_GL_WRAPPER(glUniformMatrix3fv),
+  WVU_GL_WRAPPER(glUniformMatrix4fv),
+  WVU_GL_WRAPPER(glGenBuffers),
+  WVU_GL_WRAPPER(glDeleteBuffers),
+  WVU_GL_WRAPPER(glBufferData),
+  WVU_GL_WRAPPER(glBufferSubData),
+  WVU_GL_WRAPPER(glGenVertexArrays),
+  WVU_GL_WRAPPER(glDeleteVertexArrays),
+  WVU_GL_WRAPPER(glVertexAttribPointer),
+  WVU_GL_WRAPPER(glEnableVertexAttribArray),
+  WVU_GL_WRAPPER(glGenTextures),
+  WVU_GL_WRAPPER(glDeleteTextures),
+  WVU_GL_WRAPPER(glTexParameteri),
+  WVU_GL_WRAPPER(glPixelStorei),
+  WVU_GL_WRAPPER(glTexImage2D),
+  WVU_GL_WRAPPER(glCompressedTexImage2D),
+  WVU_GL_WRAPPER(glGenerateMipmap),
+  WVU_GL_WRAPPER(glCreateShader),
+  WVU_GL_WRAPPER(glShaderSource),
+  WVU_GL_WRAPPER(glCompileShader),
+  WVU_GL_WRAPPER(glDeleteShader),
+  WVU_GL_WRAPPER(glCreateProgram),
+  WVU_GL_WRAPPER(glAttachShader),
+  WVU_GL_WRAPPER(glLinkProgram),
+  WVU_GL_WRAPPER(glDeleteProgram),
+  WVU_GL_WRAPPER(glGetUniformLocation),
+  WVU_GL_WRAPPER(glViewport),
+  WVU_GL_WRAPPER(glClearColor),
+  WVU_GL_WRAPPER(glClear)};
+#undef WVU_GL_WRAPPER
+
+// Returns the wrapper of an interposed function, or nullptr.
+wvu::GlFunction FindWrapper(const GLubyte* name) {
+  for (const InterposedGlFunction& function : kInterposedGlFunctions) {
+    if (std::strcmp(function.name, reinterpret_cast<const char*>(name)) == 0) {
+      return function.wrapper;
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+// GLEW loads the entry points through these: the interposed ones are
+// replaced by their wrappers.
+extern "C" wvu::GlFunction glXGetProcAddressARB(const GLubyte* name) {
+  static const wvu::GetProcAddressFunction get_proc_address =
+      reinterpret_cast<wvu::GetProcAddressFunction>(
+          dlsym(RTLD_NEXT, "glXGetProcAddressARB"));
+  const wvu::GlFunction wrapper = FindWrapper(name);
+  if (wrapper != nullptr) return wrapper;
+  return get_proc_address == nullptr ? nullptr : get_proc_address(name);
+}
+
+extern "C" wvu::GlFunction glXGetProcAddress(const GLubyte* name) {
+  return glXGetProcAddressARB(name);
+}
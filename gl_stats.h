@@ -0,0 +1,71 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef GL_STATS_H_
+#define GL_STATS_H_
+
+#include <cstdint>
+
+namespace wvu {
+
+// Number of OpenGL calls by kind.
+struct GlCallStats {
+  // glDraw*, glMultiDraw* and glDispatchCompute* calls.
+  int64_t draw_calls;
+  // Binds of programs, vertex arrays, buffers, textures and framebuffers,
+  // and changes of the fixed-function state (enable/disable, blending,
+  // depth mask, polygon mode).
+  int64_t state_changes;
+  // glUniform* calls.
+  int64_t uniform_updates;
+};
+
+// Returns the calls made by the calling thread since the last reset. Every
+// thread has its own counters, so the upload thread does not pollute the
+// numbers of the render loop.
+GlCallStats GetGlCallStats();
+
+// Zeroes the counters of the calling thread.
+void ResetGlCallStats();
+
+// The counters are maintained by wrappers interposed on the OpenGL entry
+// points: the functions exported by libGL are defined by gl_stats.cc, and the
+// pointers GLEW loads through glXGetProcAddress(ARB) are redirected to the
+// same wrappers. This needs a dynamically linked libGL with GLX (Linux);
+// elsewhere the counters of the functions loaded by GLEW stay at zero. The
+// same wrappers record the calls into a trace (see gl_trace.h).
+
+}  // namespace wvu
+
+#endif  // GL_STATS_H_
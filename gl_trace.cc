@@ -0,0 +1,804 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#include "gl_trace.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <initializer_list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <GL/glew.h>
+#include <glog/logging.h>
+
+#include "mapped_file.h"
+
+namespace wvu {
+namespace {
+
+// The trace starts with the magic and the version.
+constexpr char kGlTraceMagic[4] = {'W', 'V', 'U', 'G'};
+constexpr uint32_t kGlTraceVersion = 1;
+constexpr size_t kGlTraceHeaderSize = 8;
+// A command starts with its opcode, its number of arguments and the size of
+// its blob; the blob is padded to 4 bytes.
+constexpr size_t kCommandHeaderSize = 8;
+// The recorded commands are written in chunks of this size.
+constexpr size_t kWriteChunkSize = 1 << 20;
+// Texture units whose bindings are restored when the thread changes.
+constexpr int kNumTextureUnits = 16;
+
+size_t PadToWord(const size_t size) {
+  return (size + 3) & ~static_cast<size_t>(3);
+}
+
+// The bindings of a context the replay depends on.
+struct Bindings {
+  Bindings() :
+      program(0), vertex_array(0), array_buffer(0), element_array_buffer(0),
+      active_texture(GL_TEXTURE0), unpack_alignment(4) {
+    std::memset(textures_2d, 0, sizeof(textures_2d));
+  }
+
+  uint32_t program;
+  uint32_t vertex_array;
+  uint32_t array_buffer;
+  // Only meaningful without a vertex array: it is vertex array state.
+  uint32_t element_array_buffer;
+  uint32_t active_texture;
+  uint32_t unpack_alignment;
+  uint32_t textures_2d[kNumTextureUnits];
+};
+
+// Updates the bindings with a recorded call.
+void UpdateBindings(const GlTraceOpcode opcode,
+                    const uint32_t* args,
+                    const uint32_t* names,
+                    const int num_names,
+                    Bindings* bindings) {
+  switch (opcode) {
+    case GlTraceOpcode::USE_PROGRAM:
+      bindings->program = args[0];
+      break;
+    case GlTraceOpcode::BIND_VERTEX_ARRAY:
+      bindings->vertex_array = args[0];
+      break;
+    case GlTraceOpcode::BIND_BUFFER:
+      if (args[0] == GL_ARRAY_BUFFER) bindings->array_buffer = args[1];
+      if (args[0] == GL_ELEMENT_ARRAY_BUFFER) {
+        bindings->element_array_buffer = args[1];
+      }
+      break;
+    case GlTraceOpcode::ACTIVE_TEXTURE:
+      bindings->active_texture = args[0];
+      break;
+    case GlTraceOpcode::BIND_TEXTURE: {
+      const uint32_t unit = bindings->active_texture - GL_TEXTURE0;
+      if (args[0] == GL_TEXTURE_2D && unit < kNumTextureUnits) {
+        bindings->textures_2d[unit] = args[1];
+      }
+      break;
+    }
+    case GlTraceOpcode::PIXEL_STORE_I:
+      if (args[0] == GL_UNPACK_ALIGNMENT) bindings->unpack_alignment = args[1];
+      break;
+    // Deleting an object unbinds it.
+    case GlTraceOpcode::DELETE_PROGRAM:
+      if (bindings->program == args[0]) bindings->program = 0;
+      break;
+    case GlTraceOpcode::DELETE_VERTEX_ARRAYS:
+      for (int i = 0; i < num_names; ++i) {
+        if (bindings->vertex_array == names[i]) bindings->vertex_array = 0;
+      }
+      break;
+    case GlTraceOpcode::DELETE_BUFFERS:
+      for (int i = 0; i < num_names; ++i) {
+        if (bindings->array_buffer == names[i]) bindings->array_buffer = 0;
+        if (bindings->element_array_buffer == names[i]) {
+          bindings->element_array_buffer = 0;
+        }
+      }
+      break;
+    case GlTraceOpcode::DELETE_TEXTURES:
+      for (int i = 0; i < num_names; ++i) {
+        for (uint32_t& texture : bindings->textures_2d) {
+          if (texture == names[i]) texture = 0;
+        }
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+class GlTraceRecorder {
+ public:
+  explicit GlTraceRecorder(std::FILE* file) : file_(file) {}
+
+  ~GlTraceRecorder() {
+    Flush();
+    std::fclose(file_);
+  }
+
+  void Record(const GlTraceOpcode opcode,
+              std::initializer_list<uint32_t> args,
+              const void* blob,
+              const size_t blob_size) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const std::thread::id thread_id = std::this_thread::get_id();
+    if (thread_id != last_thread_id_) {
+      RestoreBindings(thread_bindings_[thread_id]);
+      last_thread_id_ = thread_id;
+    }
+    Append(opcode, args.begin(), args.size(), blob, blob_size);
+    const bool deletes_objects =
+        opcode == GlTraceOpcode::DELETE_BUFFERS ||
+        opcode == GlTraceOpcode::DELETE_VERTEX_ARRAYS ||
+        opcode == GlTraceOpcode::DELETE_TEXTURES ||
+        opcode == GlTraceOpcode::DELETE_PROGRAM;
+    const uint32_t* names = static_cast<const uint32_t*>(blob);
+    const int num_names = blob_size / sizeof(uint32_t);
+    if (deletes_objects) {
+      // The objects are shared: every thread loses its bindings to them.
+      for (auto& bindings : thread_bindings_) {
+        UpdateBindings(opcode, args.begin(), names, num_names,
+                       &bindings.second);
+      }
+    } else {
+      UpdateBindings(opcode, args.begin(), names, num_names,
+                     &thread_bindings_[thread_id]);
+    }
+    UpdateBindings(opcode, args.begin(), names, num_names, &context_bindings_);
+  }
+
+  void Flush() {
+    std::fwrite(buffer_.data(), 1, buffer_.size(), file_);
+    buffer_.clear();
+  }
+
+ private:
+  void Append(const GlTraceOpcode opcode,
+              const uint32_t* args,
+              const int num_args,
+              const void* blob,
+              const size_t blob_size) {
+    const uint16_t header[2] = {static_cast<uint16_t>(opcode),
+                                static_cast<uint16_t>(num_args)};
+    const uint32_t size = blob_size;
+    buffer_.append(reinterpret_cast<const char*>(header), sizeof(header));
+    buffer_.append(reinterpret_cast<const char*>(&size), sizeof(size));
+    buffer_.append(reinterpret_cast<const char*>(args),
+                   num_args * sizeof(uint32_t));
+    if (blob_size > 0) {
+      buffer_.append(static_cast<const char*>(blob), blob_size);
+      buffer_.append(PadToWord(blob_size) - blob_size, '\0');
+    }
+    if (buffer_.size() >= kWriteChunkSize) Flush();
+  }
+
+  // Issues the calls that turn the bindings of the replay context into the
+  // given ones.
+  void RestoreBindings(const Bindings& bindings) {
+    Bindings& context = context_bindings_;
+    if (context.program != bindings.program) {
+      RecordBinding(GlTraceOpcode::USE_PROGRAM, {bindings.program});
+    }
+    if (context.vertex_array != bindings.vertex_array) {
+      RecordBinding(GlTraceOpcode::BIND_VERTEX_ARRAY, {bindings.vertex_array});
+    }
+    if (context.array_buffer != bindings.array_buffer) {
+      RecordBinding(GlTraceOpcode::BIND_BUFFER,
+                    {GL_ARRAY_BUFFER, bindings.array_buffer});
+    }
+    if (bindings.vertex_array == 0 &&
+        context.element_array_buffer != bindings.element_array_buffer) {
+      RecordBinding(GlTraceOpcode::BIND_BUFFER,
+                    {GL_ELEMENT_ARRAY_BUFFER, bindings.element_array_buffer});
+    }
+    for (int i = 0; i < kNumTextureUnits; ++i) {
+      if (context.textures_2d[i] == bindings.textures_2d[i]) continue;
+      RecordBinding(GlTraceOpcode::ACTIVE_TEXTURE,
+                    {static_cast<uint32_t>(GL_TEXTURE0 + i)});
+      RecordBinding(GlTraceOpcode::BIND_TEXTURE,
+                    {GL_TEXTURE_2D, bindings.textures_2d[i]});
+    }
+    if (context.active_texture != bindings.active_texture) {
+      RecordBinding(GlTraceOpcode::ACTIVE_TEXTURE, {bindings.active_texture});
+    }
+    if (context.unpack_alignment != bindings.unpack_alignment) {
+      RecordBinding(GlTraceOpcode::PIXEL_STORE_I,
+                    {GL_UNPACK_ALIGNMENT, bindings.unpack_alignment});
+    }
+  }
+
+  void RecordBinding(const GlTraceOpcode opcode,
+                     std::initializer_list<uint32_t> args) {
+    Append(opcode, args.begin(), args.size(), nullptr, 0);
+    UpdateBindings(opcode, args.begin(), nullptr, 0, &context_bindings_);
+  }
+
+  std::FILE* file_;
+  std::mutex mutex_;
+  std::string buffer_;
+  std::thread::id last_thread_id_;
+  std::unordered_map<std::thread::id, Bindings> thread_bindings_;
+  // The bindings of the single context the trace replays in.
+  Bindings context_bindings_;
+};
+
+std::atomic<bool> is_recording(false);
+GlTraceRecorder* recorder = nullptr;
+
+}  // namespace
+
+bool StartGlTraceRecording(const std::string& filepath,
+                           std::string* error_info_log) {
+  CHECK(!is_recording) << "A trace is already recorded.";
+  std::FILE* file = std::fopen(filepath.c_str(), "wb");
+  if (file == nullptr) {
+    if (error_info_log != nullptr) {
+      *error_info_log = "Could not open the trace " + filepath;
+    }
+    return false;
+  }
+  std::fwrite(kGlTraceMagic, 1, sizeof(kGlTraceMagic), file);
+  std::fwrite(&kGlTraceVersion, sizeof(kGlTraceVersion), 1, file);
+  recorder = new GlTraceRecorder(file);
+  is_recording = true;
+  return true;
+}
+
+void MarkGlTraceFrame() {
+  RecordGlCall(GlTraceOpcode::FRAME, {});
+}
+
+void StopGlTraceRecording() {
+  if (!is_recording) return;
+  is_recording = false;
+  delete recorder;
+  recorder = nullptr;
+}
+
+bool IsRecordingGlTrace() {
+  return is_recording.load(std::memory_order_relaxed);
+}
+
+void RecordGlCall(const GlTraceOpcode opcode,
+                  std::initializer_list<uint32_t> args,
+                  const void* blob,
+                  const size_t blob_size) {
+  if (!IsRecordingGlTrace()) return;
+  recorder->Record(opcode, args, blob, blob_size);
+}
+
+uint32_t EncodeGlTraceFloat(const float value) {
+  uint32_t word;
+  std::memcpy(&word, &value, sizeof(word));
+  return word;
+}
+
+size_t GetGlTexImageSize(const uint32_t width,
+                         const uint32_t height,
+                         const uint32_t format,
+                         const uint32_t type,
+                         const uint32_t unpack_alignment) {
+  int num_components = 4;
+  switch (format) {
+    case GL_RED:
+    case GL_RED_INTEGER:
+    case GL_DEPTH_COMPONENT:
+    case GL_STENCIL_INDEX:
+      num_components = 1;
+      break;
+    case GL_RG:
+    case GL_RG_INTEGER:
+    case GL_DEPTH_STENCIL:
+      num_components = 2;
+      break;
+    case GL_RGB:
+    case GL_BGR:
+    case GL_RGB_INTEGER:
+      num_components = 3;
+      break;
+  }
+  size_t pixel_size = 4;
+  switch (type) {
+    case GL_UNSIGNED_BYTE:
+    case GL_BYTE:
+      pixel_size = num_components;
+      break;
+    case GL_UNSIGNED_SHORT:
+    case GL_SHORT:
+    case GL_HALF_FLOAT:
+      pixel_size = 2 * num_components;
+      break;
+    case GL_UNSIGNED_INT:
+    case GL_INT:
+    case GL_FLOAT:
+      pixel_size = 4 * num_components;
+      break;
+    case GL_UNSIGNED_SHORT_5_6_5:
+    case GL_UNSIGNED_SHORT_4_4_4_4:
+    case GL_UNSIGNED_SHORT_5_5_5_1:
+      pixel_size = 2;
+      break;
+    case GL_FLOAT_32_UNSIGNED_INT_24_8_REV:
+      pixel_size = 8;
+      break;
+  }
+  const size_t row_size = width * pixel_size;
+  const size_t aligned_row_size =
+      (row_size + unpack_alignment - 1) / unpack_alignment * unpack_alignment;
+  return height == 0 ? 0 : aligned_row_size * (height - 1) + row_size;
+}
+
+namespace {
+
+// Decodes the 64-bit value of two arguments.
+int64_t DecodeInt64(const uint32_t* args) {
+  return static_cast<int64_t>(
+      static_cast<uint64_t>(args[0]) | (static_cast<uint64_t>(args[1]) << 32));
+}
+
+// The blob as a pointer, or nullptr when the call passed no data.
+const GLvoid* GetData(const uint32_t has_data, const char* blob) {
+  return has_data ? blob : nullptr;
+}
+
+void SetError(const std::string& error, std::string* error_info_log) {
+  if (error_info_log != nullptr) *error_info_log = error;
+}
+
+// The number of arguments of every opcode, in the order of GlTraceOpcode.
+// They are the ones gl_stats.cc records and Execute reads.
+constexpr int kNumOpcodeArgs[] = {
+  0,  // FRAME
+  0,  // UNSUPPORTED
+  1,  // GEN_BUFFERS
+  1,  // DELETE_BUFFERS
+  2,  // BIND_BUFFER
+  5,  // BUFFER_DATA
+  5,  // BUFFER_SUB_DATA
+  1,  // GEN_VERTEX_ARRAYS
+  1,  // DELETE_VERTEX_ARRAYS
+  1,  // BIND_VERTEX_ARRAY
+  7,  // VERTEX_ATTRIB_POINTER
+  1,  // ENABLE_VERTEX_ATTRIB_ARRAY
+  1,  // GEN_TEXTURES
+  1,  // DELETE_TEXTURES
+  2,  // BIND_TEXTURE
+  1,  // ACTIVE_TEXTURE
+  3,  // TEX_PARAMETER_I
+  2,  // PIXEL_STORE_I
+  9,  // TEX_IMAGE_2D
+  7,  // COMPRESSED_TEX_IMAGE_2D
+  1,  // GENERATE_MIPMAP
+  2,  // CREATE_SHADER
+  1,  // SHADER_SOURCE
+  1,  // COMPILE_SHADER
+  1,  // DELETE_SHADER
+  1,  // CREATE_PROGRAM
+  2,  // ATTACH_SHADER
+  1,  // LINK_PROGRAM
+  1,  // DELETE_PROGRAM
+  1,  // USE_PROGRAM
+  2,  // GET_UNIFORM_LOCATION
+  2,  // UNIFORM_1I
+  2,  // UNIFORM_1F
+  2,  // UNIFORM_3FV
+  2,  // UNIFORM_4FV
+  3,  // UNIFORM_MATRIX_4FV
+  2,  // BIND_FRAMEBUFFER
+  1,  // ENABLE
+  1,  // DISABLE
+  2,  // BLEND_FUNC
+  1,  // DEPTH_MASK
+  2,  // POLYGON_MODE
+  4,  // VIEWPORT
+  4,  // CLEAR_COLOR
+  1,  // CLEAR
+  3,  // DRAW_ARRAYS
+  5,  // DRAW_ELEMENTS
+  4,  // DRAW_ARRAYS_INSTANCED
+  6,  // DRAW_ELEMENTS_INSTANCED
+};
+static_assert(sizeof(kNumOpcodeArgs) / sizeof(kNumOpcodeArgs[0]) ==
+                  static_cast<size_t>(GlTraceOpcode::NUM_OPCODES),
+              "Every opcode needs its number of arguments.");
+
+// Returns true if the blob of a call holds exactly the data the arguments
+// say the call reads, so that replaying it never reads past the blob.
+// Params:
+//   opcode  The call.
+//   args  The arguments of the call; there are as many as the opcode takes.
+//   blob_size  The number of bytes of the blob.
+//   unpack_alignment  The GL_UNPACK_ALIGNMENT of the replay at the call.
+bool HasValidBlob(const GlTraceOpcode opcode,
+                  const uint32_t* args,
+                  const uint64_t blob_size,
+                  const uint32_t unpack_alignment) {
+  switch (opcode) {
+    case GlTraceOpcode::GEN_BUFFERS:
+    case GlTraceOpcode::DELETE_BUFFERS:
+    case GlTraceOpcode::GEN_VERTEX_ARRAYS:
+    case GlTraceOpcode::DELETE_VERTEX_ARRAYS:
+    case GlTraceOpcode::GEN_TEXTURES:
+    case GlTraceOpcode::DELETE_TEXTURES:
+      return blob_size == args[0] * static_cast<uint64_t>(sizeof(uint32_t));
+    case GlTraceOpcode::BUFFER_DATA:
+      return args[4] == 0 ||
+          blob_size == static_cast<uint64_t>(DecodeInt64(args + 1));
+    case GlTraceOpcode::BUFFER_SUB_DATA:
+      return blob_size == static_cast<uint64_t>(DecodeInt64(args + 3));
+    case GlTraceOpcode::TEX_IMAGE_2D:
+      return args[8] == 0 ||
+          blob_size == GetGlTexImageSize(args[3], args[4], args[6], args[7],
+                                         unpack_alignment);
+    case GlTraceOpcode::COMPRESSED_TEX_IMAGE_2D:
+      return blob_size == args[6];
+    case GlTraceOpcode::UNIFORM_3FV:
+      return blob_size == args[1] * static_cast<uint64_t>(3 * sizeof(float));
+    case GlTraceOpcode::UNIFORM_4FV:
+      return blob_size == args[1] * static_cast<uint64_t>(4 * sizeof(float));
+    case GlTraceOpcode::UNIFORM_MATRIX_4FV:
+      return blob_size == args[1] * static_cast<uint64_t>(16 * sizeof(float));
+    default:
+      return true;
+  }
+}
+
+}  // namespace
+
+GlTraceReplayer::GlTraceReplayer() :
+    default_framebuffer_id_(0), current_program_(0) {}
+
+bool GlTraceReplayer::Open(const std::string& filepath,
+                           std::string* error_info_log) {
+  commands_.clear();
+  frame_ends_.clear();
+  unsupported_calls_.clear();
+  if (!file_.Open(filepath, error_info_log)) return false;
+  const char* data = file_.data();
+  const size_t size = file_.size();
+  uint32_t version = 0;
+  if (size < kGlTraceHeaderSize ||
+      std::memcmp(data, kGlTraceMagic, sizeof(kGlTraceMagic)) != 0) {
+    SetError(filepath + " is not an OpenGL trace.", error_info_log);
+    return false;
+  }
+  std::memcpy(&version, data + sizeof(kGlTraceMagic), sizeof(version));
+  if (version != kGlTraceVersion) {
+    SetError("Unsupported version of the trace " + filepath, error_info_log);
+    return false;
+  }
+  // The sizes of the texture uploads depend on the unpack alignment, which
+  // the trace sets in order.
+  uint32_t unpack_alignment = 4;
+  size_t offset = kGlTraceHeaderSize;
+  while (offset < size) {
+    if (size - offset < kCommandHeaderSize) {
+      SetError("Truncated trace " + filepath, error_info_log);
+      return false;
+    }
+    uint16_t header[2];
+    Command command;
+    std::memcpy(header, data + offset, sizeof(header));
+    std::memcpy(&command.blob_size, data + offset + sizeof(header),
+                sizeof(command.blob_size));
+    command.opcode = static_cast<GlTraceOpcode>(header[0]);
+    command.num_args = header[1];
+    const size_t args_size = command.num_args * sizeof(uint32_t);
+    const size_t command_size =
+        kCommandHeaderSize + args_size + PadToWord(command.blob_size);
+    // Execute reads the arguments and the blob without checking them.
+    bool is_valid =
+        header[0] < static_cast<uint16_t>(GlTraceOpcode::NUM_OPCODES) &&
+        command.num_args == kNumOpcodeArgs[header[0]] &&
+        size - offset >= command_size;
+    if (is_valid) {
+      command.args = reinterpret_cast<const uint32_t*>(
+          data + offset + kCommandHeaderSize);
+      command.blob = data + offset + kCommandHeaderSize + args_size;
+      is_valid = HasValidBlob(command.opcode, command.args, command.blob_size,
+                              unpack_alignment);
+    }
+    if (!is_valid) {
+      SetError("Corrupted trace " + filepath + " at byte " +
+               std::to_string(offset), error_info_log);
+      return false;
+    }
+    offset += command_size;
+    // OpenGL ignores the alignments other than 1, 2, 4 and 8.
+    if (command.opcode == GlTraceOpcode::PIXEL_STORE_I &&
+        command.args[0] == GL_UNPACK_ALIGNMENT &&
+        (command.args[1] == 1 || command.args[1] == 2 ||
+         command.args[1] == 4 || command.args[1] == 8)) {
+      unpack_alignment = command.args[1];
+    }
+    if (command.opcode == GlTraceOpcode::UNSUPPORTED) {
+      unsupported_calls_.emplace_back(command.blob, command.blob_size);
+    } else if (command.opcode == GlTraceOpcode::BIND_FRAMEBUFFER &&
+               command.args[1] != 0) {
+      unsupported_calls_.push_back("glBindFramebuffer");
+    }
+    commands_.push_back(command);
+    if (command.opcode == GlTraceOpcode::FRAME) {
+      frame_ends_.push_back(commands_.size());
+    }
+  }
+  return true;
+}
+
+void GlTraceReplayer::ReplayPrologue() {
+  Replay(0, frame_ends_.empty() ? commands_.size() : frame_ends_.front());
+}
+
+void GlTraceReplayer::ReplayFrame(const int frame) {
+  CHECK_LT(frame, frame_ends_.size());
+  Replay(frame == 0 ? frame_ends_.front() : frame_ends_[frame - 1],
+         frame_ends_[frame]);
+}
+
+void GlTraceReplayer::ReplayEpilogue() {
+  if (frame_ends_.empty()) return;
+  Replay(frame_ends_.back(), commands_.size());
+}
+
+int GlTraceReplayer::num_frame_commands(const int frame) const {
+  CHECK_LT(frame, frame_ends_.size());
+  return frame_ends_[frame] - (frame == 0 ? 0 : frame_ends_[frame - 1]);
+}
+
+void GlTraceReplayer::Replay(const int begin, const int end) {
+  for (int i = begin; i < end; ++i) {
+    Execute(commands_[i]);
+  }
+}
+
+uint32_t GlTraceReplayer::MapName(
+    const std::unordered_map<uint32_t, uint32_t>& names,
+    const uint32_t name) const {
+  if (name == 0) return 0;
+  const auto mapped_name = names.find(name);
+  return mapped_name == names.end() ? 0 : mapped_name->second;
+}
+
+int32_t GlTraceReplayer::MapLocation(const uint32_t location) const {
+  const auto mapped_location = locations_.find(
+      (static_cast<uint64_t>(current_program_) << 32) | location);
+  return mapped_location == locations_.end() ? -1 : mapped_location->second;
+}
+
+void GlTraceReplayer::Execute(const Command& command) {
+  const uint32_t* args = command.args;
+  const char* blob = command.blob;
+  const uint32_t* names = reinterpret_cast<const uint32_t*>(blob);
+  const GLfloat* floats = reinterpret_cast<const GLfloat*>(blob);
+  GLfloat values[4];
+  std::vector<GLuint> replayed_names;
+  switch (command.opcode) {
+    case GlTraceOpcode::FRAME:
+    case GlTraceOpcode::UNSUPPORTED:
+    case GlTraceOpcode::NUM_OPCODES:
+      break;
+    case GlTraceOpcode::GEN_BUFFERS:
+      replayed_names.resize(args[0]);
+      glGenBuffers(args[0], replayed_names.data());
+      for (int i = 0; i < args[0]; ++i) buffers_[names[i]] = replayed_names[i];
+      break;
+    case GlTraceOpcode::DELETE_BUFFERS:
+      for (int i = 0; i < args[0]; ++i) {
+        replayed_names.push_back(MapName(buffers_, names[i]));
+        buffers_.erase(names[i]);
+      }
+      glDeleteBuffers(replayed_names.size(), replayed_names.data());
+      break;
+    case GlTraceOpcode::BIND_BUFFER:
+      glBindBuffer(args[0], MapName(buffers_, args[1]));
+      break;
+    case GlTraceOpcode::BUFFER_DATA:
+      glBufferData(args[0], DecodeInt64(args + 1), GetData(args[4], blob),
+                   args[3]);
+      break;
+    case GlTraceOpcode::BUFFER_SUB_DATA:
+      glBufferSubData(args[0], DecodeInt64(args + 1), DecodeInt64(args + 3),
+                      blob);
+      break;
+    case GlTraceOpcode::GEN_VERTEX_ARRAYS:
+      replayed_names.resize(args[0]);
+      glGenVertexArrays(args[0], replayed_names.data());
+      for (int i = 0; i < args[0]; ++i) {
+        vertex_arrays_[names[i]] = replayed_names[i];
+      }
+      break;
+    case GlTraceOpcode::DELETE_VERTEX_ARRAYS:
+      for (int i = 0; i < args[0]; ++i) {
+        replayed_names.push_back(MapName(vertex_arrays_, names[i]));
+        vertex_arrays_.erase(names[i]);
+      }
+      glDeleteVertexArrays(replayed_names.size(), replayed_names.data());
+      break;
+    case GlTraceOpcode::BIND_VERTEX_ARRAY:
+      glBindVertexArray(MapName(vertex_arrays_, args[0]));
+      break;
+    case GlTraceOpcode::VERTEX_ATTRIB_POINTER:
+      glVertexAttribPointer(
+          args[0], args[1], args[2], args[3], args[4],
+          reinterpret_cast<const GLvoid*>(DecodeInt64(args + 5)));
+      break;
+    case GlTraceOpcode::ENABLE_VERTEX_ATTRIB_ARRAY:
+      glEnableVertexAttribArray(args[0]);
+      break;
+    case GlTraceOpcode::GEN_TEXTURES:
+      replayed_names.resize(args[0]);
+      glGenTextures(args[0], replayed_names.data());
+      for (int i = 0; i < args[0]; ++i) textures_[names[i]] = replayed_names[i];
+      break;
+    case GlTraceOpcode::DELETE_TEXTURES:
+      for (int i = 0; i < args[0]; ++i) {
+        replayed_names.push_back(MapName(textures_, names[i]));
+        textures_.erase(names[i]);
+      }
+      glDeleteTextures(replayed_names.size(), replayed_names.data());
+      break;
+    case GlTraceOpcode::BIND_TEXTURE:
+      glBindTexture(args[0], MapName(textures_, args[1]));
+      break;
+    case GlTraceOpcode::ACTIVE_TEXTURE:
+      glActiveTexture(args[0]);
+      break;
+    case GlTraceOpcode::TEX_PARAMETER_I:
+      glTexParameteri(args[0], args[1], args[2]);
+      break;
+    case GlTraceOpcode::PIXEL_STORE_I:
+      glPixelStorei(args[0], args[1]);
+      break;
+    case GlTraceOpcode::TEX_IMAGE_2D:
+      glTexImage2D(args[0], args[1], args[2], args[3], args[4], args[5],
+                   args[6], args[7], GetData(args[8], blob));
+      break;
+    case GlTraceOpcode::COMPRESSED_TEX_IMAGE_2D:
+      glCompressedTexImage2D(args[0], args[1], args[2], args[3], args[4],
+                             args[5], args[6], blob);
+      break;
+    case GlTraceOpcode::GENERATE_MIPMAP:
+      glGenerateMipmap(args[0]);
+      break;
+    case GlTraceOpcode::CREATE_SHADER:
+      shaders_[args[1]] = glCreateShader(args[0]);
+      break;
+    case GlTraceOpcode::SHADER_SOURCE: {
+      const GLint length = command.blob_size;
+      glShaderSource(MapName(shaders_, args[0]), 1, &blob, &length);
+      break;
+    }
+    case GlTraceOpcode::COMPILE_SHADER:
+      glCompileShader(MapName(shaders_, args[0]));
+      break;
+    case GlTraceOpcode::DELETE_SHADER:
+      glDeleteShader(MapName(shaders_, args[0]));
+      shaders_.erase(args[0]);
+      break;
+    case GlTraceOpcode::CREATE_PROGRAM:
+      programs_[args[0]] = glCreateProgram();
+      break;
+    case GlTraceOpcode::ATTACH_SHADER:
+      glAttachShader(MapName(programs_, args[0]), MapName(shaders_, args[1]));
+      break;
+    case GlTraceOpcode::LINK_PROGRAM:
+      glLinkProgram(MapName(programs_, args[0]));
+      break;
+    case GlTraceOpcode::DELETE_PROGRAM:
+      glDeleteProgram(MapName(programs_, args[0]));
+      programs_.erase(args[0]);
+      break;
+    case GlTraceOpcode::USE_PROGRAM:
+      current_program_ = args[0];
+      glUseProgram(MapName(programs_, args[0]));
+      break;
+    case GlTraceOpcode::GET_UNIFORM_LOCATION: {
+      const std::string name(blob, command.blob_size);
+      locations_[(static_cast<uint64_t>(args[0]) << 32) | args[1]] =
+          glGetUniformLocation(MapName(programs_, args[0]), name.c_str());
+      break;
+    }
+    case GlTraceOpcode::UNIFORM_1I:
+      glUniform1i(MapLocation(args[0]), args[1]);
+      break;
+    case GlTraceOpcode::UNIFORM_1F:
+      std::memcpy(values, args + 1, sizeof(GLfloat));
+      glUniform1f(MapLocation(args[0]), values[0]);
+      break;
+    case GlTraceOpcode::UNIFORM_3FV:
+      glUniform3fv(MapLocation(args[0]), args[1], floats);
+      break;
+    case GlTraceOpcode::UNIFORM_4FV:
+      glUniform4fv(MapLocation(args[0]), args[1], floats);
+      break;
+    case GlTraceOpcode::UNIFORM_MATRIX_4FV:
+      glUniformMatrix4fv(MapLocation(args[0]), args[1], args[2], floats);
+      break;
+    case GlTraceOpcode::BIND_FRAMEBUFFER:
+      // Only the default framebuffer is known to the replay.
+      if (args[1] == 0) glBindFramebuffer(args[0], default_framebuffer_id_);
+      break;
+    case GlTraceOpcode::ENABLE:
+      glEnable(args[0]);
+      break;
+    case GlTraceOpcode::DISABLE:
+      glDisable(args[0]);
+      break;
+    case GlTraceOpcode::BLEND_FUNC:
+      glBlendFunc(args[0], args[1]);
+      break;
+    case GlTraceOpcode::DEPTH_MASK:
+      glDepthMask(args[0]);
+      break;
+    case GlTraceOpcode::POLYGON_MODE:
+      glPolygonMode(args[0], args[1]);
+      break;
+    case GlTraceOpcode::VIEWPORT:
+      glViewport(args[0], args[1], args[2], args[3]);
+      break;
+    case GlTraceOpcode::CLEAR_COLOR:
+      std::memcpy(values, args, 4 * sizeof(GLfloat));
+      glClearColor(values[0], values[1], values[2], values[3]);
+      break;
+    case GlTraceOpcode::CLEAR:
+      glClear(args[0]);
+      break;
+    case GlTraceOpcode::DRAW_ARRAYS:
+      glDrawArrays(args[0], args[1], args[2]);
+      break;
+    case GlTraceOpcode::DRAW_ELEMENTS:
+      glDrawElements(args[0], args[1], args[2],
+                     reinterpret_cast<const GLvoid*>(DecodeInt64(args + 3)));
+      break;
+    case GlTraceOpcode::DRAW_ARRAYS_INSTANCED:
+      glDrawArraysInstanced(args[0], args[1], args[2], args[3]);
+      break;
+    case GlTraceOpcode::DRAW_ELEMENTS_INSTANCED:
+      glDrawElementsInstanced(
+          args[0], args[1], args[2],
+          reinterpret_cast<const GLvoid*>(DecodeInt64(args + 3)), args[5]);
+      break;
+  }
+}
+
+}  // namespace wvu
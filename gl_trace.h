@@ -0,0 +1,258 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef GL_TRACE_H_
+#define GL_TRACE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "mapped_file.h"
+
+// This header does not include the OpenGL headers: it is included by the
+// wrappers of gl_stats.cc, which cannot include GLEW. The OpenGL types are
+// passed as 32-bit words.
+
+namespace wvu {
+
+// The calls of a trace. Every call is encoded as its opcode, its arguments as
+// 32-bit words (64-bit values take two words, low first; floats are bit
+// cast), and a blob with the data the call reads through pointers, e.g., the
+// contents of a buffer or of a texture.
+enum struct GlTraceOpcode : uint16_t {
+  // Marks the end of a frame; it has no arguments.
+  FRAME = 0,
+  // A call the replayer cannot issue; the blob holds its name.
+  UNSUPPORTED = 1,
+  // Objects. The Gen calls record the names they returned in the blob; the
+  // Create calls record the name they returned as their last argument.
+  GEN_BUFFERS = 2,
+  DELETE_BUFFERS = 3,
+  BIND_BUFFER = 4,
+  BUFFER_DATA = 5,
+  BUFFER_SUB_DATA = 6,
+  GEN_VERTEX_ARRAYS = 7,
+  DELETE_VERTEX_ARRAYS = 8,
+  BIND_VERTEX_ARRAY = 9,
+  VERTEX_ATTRIB_POINTER = 10,
+  ENABLE_VERTEX_ATTRIB_ARRAY = 11,
+  GEN_TEXTURES = 12,
+  DELETE_TEXTURES = 13,
+  BIND_TEXTURE = 14,
+  ACTIVE_TEXTURE = 15,
+  TEX_PARAMETER_I = 16,
+  PIXEL_STORE_I = 17,
+  TEX_IMAGE_2D = 18,
+  COMPRESSED_TEX_IMAGE_2D = 19,
+  GENERATE_MIPMAP = 20,
+  CREATE_SHADER = 21,
+  SHADER_SOURCE = 22,
+  COMPILE_SHADER = 23,
+  DELETE_SHADER = 24,
+  CREATE_PROGRAM = 25,
+  ATTACH_SHADER = 26,
+  LINK_PROGRAM = 27,
+  DELETE_PROGRAM = 28,
+  USE_PROGRAM = 29,
+  // The program, the location it returned, and the name in the blob.
+  GET_UNIFORM_LOCATION = 30,
+  UNIFORM_1I = 31,
+  UNIFORM_1F = 32,
+  UNIFORM_3FV = 33,
+  UNIFORM_4FV = 34,
+  UNIFORM_MATRIX_4FV = 35,
+  // Only the default framebuffer (0) can be replayed.
+  BIND_FRAMEBUFFER = 36,
+  ENABLE = 37,
+  DISABLE = 38,
+  BLEND_FUNC = 39,
+  DEPTH_MASK = 40,
+  POLYGON_MODE = 41,
+  VIEWPORT = 42,
+  CLEAR_COLOR = 43,
+  CLEAR = 44,
+  DRAW_ARRAYS = 45,
+  DRAW_ELEMENTS = 46,
+  DRAW_ARRAYS_INSTANCED = 47,
+  DRAW_ELEMENTS_INSTANCED = 48,
+  NUM_OPCODES = 49
+};
+
+// Starts recording the OpenGL calls of the process into a trace file. The
+// calls are captured by the wrappers of gl_stats.cc, so the program has to
+// link it; see gl_stats.h for the platforms where they see every call.
+// Returns true upon success and false otherwise.
+// Params:
+//   filepath  The trace file.
+//   error_info_log  A pointer to a string that holds the error log.
+bool StartGlTraceRecording(const std::string& filepath,
+                           std::string* error_info_log);
+
+// Marks the end of a frame in the trace, e.g., after swapping the buffers.
+void MarkGlTraceFrame();
+
+// Stops recording and closes the trace file.
+void StopGlTraceRecording();
+
+// Returns true while a trace is recorded.
+bool IsRecordingGlTrace();
+
+// Appends a call to the trace being recorded. The calls of every thread are
+// recorded in the order they are made. Since the bindings are per context,
+// when the recorded thread changes the trace first restores the bindings
+// (program, vertex array, buffers, textures, unpack alignment) the new
+// thread last set, so that the trace replays in a single context.
+// Params:
+//   opcode  The call.
+//   args  The arguments of the call.
+//   blob  The data the call reads, or nullptr.
+//   blob_size  The number of bytes of the data.
+void RecordGlCall(const GlTraceOpcode opcode,
+                  std::initializer_list<uint32_t> args,
+                  const void* blob = nullptr,
+                  const size_t blob_size = 0);
+
+// Encodes a float argument.
+uint32_t EncodeGlTraceFloat(const float value);
+
+// Returns the number of bytes glTexImage2D reads from client memory. The
+// recorder stores that many bytes, and the replayer checks that it did.
+// Params:
+//   width  The width of the image.
+//   height  The height of the image.
+//   format  The format of the pixels, e.g., GL_RGBA.
+//   type  The type of the pixels, e.g., GL_UNSIGNED_BYTE.
+//   unpack_alignment  The GL_UNPACK_ALIGNMENT of the upload.
+size_t GetGlTexImageSize(const uint32_t width,
+                         const uint32_t height,
+                         const uint32_t format,
+                         const uint32_t type,
+                         const uint32_t unpack_alignment);
+
+// Replays a trace as fast as possible in the current OpenGL context. The
+// names of the objects (buffers, textures, shaders, ...) and the uniform
+// locations are remapped to the ones of the replay. The commands before the
+// first frame (the loading) form the prologue, and those after the last frame
+// (the cleanup) the epilogue, so that the frames can be replayed many times.
+// Usage example:
+//
+// wvu::GlTraceReplayer replayer;
+// if (!replayer.Open("draw_scene.wvutrace", &error_info_log)) {
+//   ...
+// }
+// replayer.set_default_framebuffer_id(framebuffer.framebuffer_id());
+// replayer.ReplayPrologue();
+// for (int i = 0; i < replayer.num_frames(); ++i) {
+//   replayer.ReplayFrame(i);
+// }
+// replayer.ReplayEpilogue();
+class GlTraceReplayer {
+ public:
+  GlTraceReplayer();
+
+  // Maps and validates a trace. Returns true upon success and false
+  // otherwise.
+  bool Open(const std::string& filepath, std::string* error_info_log);
+
+  // Replays the commands before the first frame.
+  void ReplayPrologue();
+
+  // Replays the commands of a frame.
+  void ReplayFrame(const int frame);
+
+  // Replays the commands after the last frame.
+  void ReplayEpilogue();
+
+  int num_frames() const { return frame_ends_.size(); }
+
+  int num_commands() const { return commands_.size(); }
+
+  // Returns the number of commands of a frame.
+  int num_frame_commands(const int frame) const;
+
+  // Returns the names of the unsupported calls in the trace.
+  const std::vector<std::string>& unsupported_calls() const {
+    return unsupported_calls_;
+  }
+
+  // Sets the framebuffer the calls drawing into the default framebuffer are
+  // redirected to, e.g., an OffscreenFramebuffer in a headless context.
+  void set_default_framebuffer_id(const uint32_t framebuffer_id) {
+    default_framebuffer_id_ = framebuffer_id;
+  }
+
+ private:
+  struct Command {
+    GlTraceOpcode opcode;
+    int num_args;
+    const uint32_t* args;
+    uint32_t blob_size;
+    const char* blob;
+  };
+
+  // Replays the commands in [begin, end).
+  void Replay(const int begin, const int end);
+  // Issues a command.
+  void Execute(const Command& command);
+  // Returns the replayed name of a recorded one.
+  uint32_t MapName(const std::unordered_map<uint32_t, uint32_t>& names,
+                   const uint32_t name) const;
+  // Returns the replayed location of a uniform of the current program.
+  int32_t MapLocation(const uint32_t location) const;
+
+  MappedFile file_;
+  std::vector<Command> commands_;
+  // The index of the command after every frame marker.
+  std::vector<int> frame_ends_;
+  std::vector<std::string> unsupported_calls_;
+  uint32_t default_framebuffer_id_;
+  // Recorded name -> replayed name.
+  std::unordered_map<uint32_t, uint32_t> buffers_;
+  std::unordered_map<uint32_t, uint32_t> vertex_arrays_;
+  std::unordered_map<uint32_t, uint32_t> textures_;
+  std::unordered_map<uint32_t, uint32_t> shaders_;
+  std::unordered_map<uint32_t, uint32_t> programs_;
+  // (recorded program, recorded location) -> replayed location.
+  std::unordered_map<uint64_t, int32_t> locations_;
+  // The recorded name of the program in use.
+  uint32_t current_program_;
+};
+
+}  // namespace wvu
+
+#endif  // GL_TRACE_H_
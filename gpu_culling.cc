@@ -0,0 +1,559 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#include "gpu_culling.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <Eigen/Core>
+#include <GL/glew.h>
+#include <glog/logging.h>
+
+#include "frustum.h"
+#include "shader_program.h"
+
+namespace wvu {
+namespace {
+// Number of floats per vertex (see Model::SetVBO).
+constexpr int kNumFloatsPerVertex = 8;
+// Work group sizes of the compute shaders.
+constexpr GLuint kCullWorkGroupSize = 64;
+constexpr GLuint kPyramidWorkGroupSize = 8;
+// Buffer binding points shared by the compute and the draw shaders.
+constexpr GLuint kInstanceBinding = 0;
+constexpr GLuint kBoundingSphereBinding = 1;
+constexpr GLuint kCommandBinding = 2;
+constexpr GLuint kInstanceIdBinding = 3;
+// Vertex attribute holding the id of the instance.
+constexpr GLuint kInstanceIdAttribute = 3;
+
+const std::string cull_compute_shader_src =
+    "#version 430 core\n"
+    "layout (local_size_x = 64) in;\n"
+    "struct Instance {\n"
+    "  mat4 model;\n"
+    "  uint mesh_id;\n"
+    "  uint padding[3];\n"
+    "};\n"
+    "struct DrawCommand {\n"
+    "  uint count;\n"
+    "  uint instance_count;\n"
+    "  uint first_index;\n"
+    "  int base_vertex;\n"
+    "  uint base_instance;\n"
+    "};\n"
+    "layout (std430, binding = 0) readonly buffer Instances {\n"
+    "  Instance instances[];\n"
+    "};\n"
+    "layout (std430, binding = 1) readonly buffer BoundingSpheres {\n"
+    "  vec4 bounding_spheres[];\n"
+    "};\n"
+    "layout (std430, binding = 2) buffer Commands {\n"
+    "  DrawCommand commands[];\n"
+    "};\n"
+    "layout (std430, binding = 3) writeonly buffer InstanceIds {\n"
+    "  uint instance_ids[];\n"
+    "};\n"
+    "uniform uint num_instances;\n"
+    "uniform vec4 frustum_planes[6];\n"
+    "uniform bool occlusion_culling;\n"
+    "uniform mat4 previous_view;\n"
+    "uniform mat4 previous_projection;\n"
+    "uniform sampler2D depth_pyramid;\n"
+    "uniform vec2 depth_pyramid_size;\n"
+    "uniform float max_level;\n"
+    "// Tests the sphere against the max-depth pyramid of the previous frame.\n"
+    "bool IsOccluded(vec3 center, float radius) {\n"
+    "  vec3 center_in_view = (previous_view * vec4(center, 1.0f)).xyz;\n"
+    "  vec4 closest = previous_projection *\n"
+    "      vec4(center_in_view + vec3(0.0f, 0.0f, radius), 1.0f);\n"
+    "  // The sphere crosses the near plane.\n"
+    "  if (closest.w <= 0.0f || closest.z < -closest.w) {\n"
+    "    return false;\n"
+    "  }\n"
+    "  vec2 min_uv = vec2(1.0f);\n"
+    "  vec2 max_uv = vec2(0.0f);\n"
+    "  for (int i = 0; i < 8; ++i) {\n"
+    "    vec3 offset = vec3((i & 1) != 0 ? radius : -radius,\n"
+    "                       (i & 2) != 0 ? radius : -radius,\n"
+    "                       (i & 4) != 0 ? radius : -radius);\n"
+    "    vec4 clip = previous_projection * vec4(center_in_view + offset, 1.0f);\n"
+    "    vec2 uv = 0.5f * clip.xy / clip.w + 0.5f;\n"
+    "    min_uv = min(min_uv, uv);\n"
+    "    max_uv = max(max_uv, uv);\n"
+    "  }\n"
+    "  min_uv = clamp(min_uv, 0.0f, 1.0f);\n"
+    "  max_uv = clamp(max_uv, 0.0f, 1.0f);\n"
+    "  // At this level the rectangle spans at most 2x2 texels.\n"
+    "  vec2 size = (max_uv - min_uv) * depth_pyramid_size;\n"
+    "  float level = min(ceil(log2(max(max(size.x, size.y), 1.0f))),\n"
+    "                    max_level);\n"
+    "  float max_depth = max(\n"
+    "      max(textureLod(depth_pyramid, min_uv, level).r,\n"
+    "          textureLod(depth_pyramid, vec2(max_uv.x, min_uv.y), level).r),\n"
+    "      max(textureLod(depth_pyramid, vec2(min_uv.x, max_uv.y), level).r,\n"
+    "          textureLod(depth_pyramid, max_uv, level).r));\n"
+    "  float closest_depth = 0.5f * closest.z / closest.w + 0.5f;\n"
+    "  return closest_depth > max_depth;\n"
+    "}\n"
+    "void main() {\n"
+    "  uint id = gl_GlobalInvocationID.x;\n"
+    "  if (id >= num_instances) {\n"
+    "    return;\n"
+    "  }\n"
+    "  mat4 model = instances[id].model;\n"
+    "  uint mesh_id = instances[id].mesh_id;\n"
+    "  vec4 sphere = bounding_spheres[mesh_id];\n"
+    "  vec3 center = (model * vec4(sphere.xyz, 1.0f)).xyz;\n"
+    "  float scale = max(length(model[0].xyz),\n"
+    "                    max(length(model[1].xyz), length(model[2].xyz)));\n"
+    "  float radius = sphere.w * scale;\n"
+    "  for (int i = 0; i < 6; ++i) {\n"
+    "    if (dot(frustum_planes[i].xyz, center) + frustum_planes[i].w <\n"
+    "        -radius) {\n"
+    "      return;\n"
+    "    }\n"
+    "  }\n"
+    "  if (occlusion_culling && IsOccluded(center, radius)) {\n"
+    "    return;\n"
+    "  }\n"
+    "  uint slot = atomicAdd(commands[mesh_id].instance_count, 1u);\n"
+    "  instance_ids[commands[mesh_id].base_instance + slot] = id;\n"
+    "}\n";
+
+// Copies the depth texture into the first level of the pyramid. Depth
+// textures cannot be bound as images, hence this extra pass.
+const std::string depth_copy_compute_shader_src =
+    "#version 430 core\n"
+    "layout (local_size_x = 8, local_size_y = 8) in;\n"
+    "layout (r32f, binding = 0) writeonly uniform image2D destination;\n"
+    "uniform sampler2D depth_texture;\n"
+    "void main() {\n"
+    "  ivec2 texel = ivec2(gl_GlobalInvocationID.xy);\n"
+    "  if (any(greaterThanEqual(texel, imageSize(destination)))) {\n"
+    "    return;\n"
+    "  }\n"
+    "  imageStore(destination, texel,\n"
+    "             vec4(texelFetch(depth_texture, texel, 0).r));\n"
+    "}\n";
+
+// Computes a level of the pyramid as the maximum depth of the texels it
+// covers in the previous level.
+const std::string depth_reduce_compute_shader_src =
+    "#version 430 core\n"
+    "layout (local_size_x = 8, local_size_y = 8) in;\n"
+    "layout (r32f, binding = 0) readonly uniform image2D source;\n"
+    "layout (r32f, binding = 1) writeonly uniform image2D destination;\n"
+    "void main() {\n"
+    "  ivec2 texel = ivec2(gl_GlobalInvocationID.xy);\n"
+    "  ivec2 source_size = imageSize(source);\n"
+    "  ivec2 destination_size = imageSize(destination);\n"
+    "  if (any(greaterThanEqual(texel, destination_size))) {\n"
+    "    return;\n"
+    "  }\n"
+    "  // With odd source sizes, the last texel also covers the extra row or\n"
+    "  // column so that no depth is lost.\n"
+    "  ivec2 extent = ivec2(2) + ivec2(equal(texel, destination_size - 1)) *\n"
+    "      (source_size & 1);\n"
+    "  float depth = 0.0f;\n"
+    "  for (int y = 0; y < extent.y; ++y) {\n"
+    "    for (int x = 0; x < extent.x; ++x) {\n"
+    "      ivec2 source_texel = min(2 * texel + ivec2(x, y), source_size - 1);\n"
+    "      depth = max(depth, imageLoad(source, source_texel).r);\n"
+    "    }\n"
+    "  }\n"
+    "  imageStore(destination, texel, vec4(depth));\n"
+    "}\n";
+
+const std::string draw_vertex_shader_src =
+    "#version 430 core\n"
+    "layout (location = 0) in vec3 position;\n"
+    "layout (location = 1) in vec3 passed_color;\n"
+    "layout (location = 2) in vec2 passed_texel;\n"
+    "layout (location = 3) in uint instance_id;\n"
+    "struct Instance {\n"
+    "  mat4 model;\n"
+    "  uint mesh_id;\n"
+    "  uint padding[3];\n"
+    "};\n"
+    "layout (std430, binding = 0) readonly buffer Instances {\n"
+    "  Instance instances[];\n"
+    "};\n"
+    "uniform mat4 view;\n"
+    "uniform mat4 projection;\n"
+    "out vec2 texel;\n"
+    "void main() {\n"
+    "  gl_Position = projection * view * instances[instance_id].model *\n"
+    "      vec4(position, 1.0f);\n"
+    "  texel = passed_texel;\n"
+    "}\n";
+
+const std::string draw_fragment_shader_src =
+    "#version 430 core\n"
+    "in vec2 texel;\n"
+    "out vec4 color;\n"
+    "uniform sampler2D texture_sampler;\n"
+    "void main() {\n"
+    "  color = texture(texture_sampler, texel);\n"
+    "}\n";
+
+// Number of work groups needed to cover num_items with the group size.
+inline GLuint NumWorkGroups(const int num_items, const GLuint group_size) {
+  return (static_cast<GLuint>(num_items) + group_size - 1) / group_size;
+}
+
+// Replaces the contents of a buffer with the given data.
+template <typename T>
+void UploadBuffer(const GLenum target,
+                  const GLuint buffer_id,
+                  const std::vector<T>& data) {
+  glBindBuffer(target, buffer_id);
+  glBufferData(target, data.size() * sizeof(T), data.data(), GL_DYNAMIC_DRAW);
+  glBindBuffer(target, 0);
+}
+
+}  // namespace
+
+GpuCuller::GpuCuller() :
+    geometry_dirty_(false), instances_dirty_(false),
+    vertex_array_object_id_(0), vertex_buffer_object_id_(0),
+    element_buffer_object_id_(0), instance_buffer_id_(0),
+    bounding_sphere_buffer_id_(0), command_template_buffer_id_(0),
+    command_buffer_id_(0), instance_id_buffer_id_(0),
+    depth_pyramid_texture_id_(0), depth_pyramid_width_(0),
+    depth_pyramid_height_(0), depth_pyramid_levels_(0),
+    has_depth_pyramid_(false),
+    previous_projection_(Eigen::Matrix4f::Identity()),
+    previous_view_(Eigen::Matrix4f::Identity()),
+    last_projection_(Eigen::Matrix4f::Identity()),
+    last_view_(Eigen::Matrix4f::Identity()),
+    depth_pyramid_owner_(this) {}
+
+GpuCuller::~GpuCuller() {
+  const GLuint buffers[] = {vertex_buffer_object_id_,
+                            element_buffer_object_id_,
+                            instance_buffer_id_,
+                            bounding_sphere_buffer_id_,
+                            command_template_buffer_id_,
+                            command_buffer_id_,
+                            instance_id_buffer_id_};
+  glDeleteBuffers(7, buffers);
+  glDeleteVertexArrays(1, &vertex_array_object_id_);
+  glDeleteTextures(1, &depth_pyramid_texture_id_);
+}
+
+bool GpuCuller::IsSupported() {
+  return ShaderProgram::AreComputeShadersSupported();
+}
+
+bool GpuCuller::Initialize(std::string* error_info_log) {
+  cull_program_.LoadComputeShaderFromString(cull_compute_shader_src);
+  depth_copy_program_.LoadComputeShaderFromString(
+      depth_copy_compute_shader_src);
+  depth_reduce_program_.LoadComputeShaderFromString(
+      depth_reduce_compute_shader_src);
+  draw_program_.LoadVertexShaderFromString(draw_vertex_shader_src);
+  draw_program_.LoadFragmentShaderFromString(draw_fragment_shader_src);
+  if (!cull_program_.Create(error_info_log) ||
+      !depth_copy_program_.Create(error_info_log) ||
+      !depth_reduce_program_.Create(error_info_log) ||
+      !draw_program_.Create(error_info_log)) {
+    return false;
+  }
+  GLuint buffers[7];
+  glGenBuffers(7, buffers);
+  vertex_buffer_object_id_ = buffers[0];
+  element_buffer_object_id_ = buffers[1];
+  instance_buffer_id_ = buffers[2];
+  bounding_sphere_buffer_id_ = buffers[3];
+  command_template_buffer_id_ = buffers[4];
+  command_buffer_id_ = buffers[5];
+  instance_id_buffer_id_ = buffers[6];
+
+  // The vertex array object never changes: only the contents of its buffers
+  // do.
+  glGenVertexArrays(1, &vertex_array_object_id_);
+  glBindVertexArray(vertex_array_object_id_);
+  glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_object_id_);
+  constexpr GLsizei kStride = kNumFloatsPerVertex * sizeof(GLfloat);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, kStride, nullptr);
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, kStride,
+                        reinterpret_cast<GLvoid*>(3 * sizeof(GLfloat)));
+  glEnableVertexAttribArray(1);
+  glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, kStride,
+                        reinterpret_cast<GLvoid*>(6 * sizeof(GLfloat)));
+  glEnableVertexAttribArray(2);
+  // The instance id list is read as a per-instance attribute. The base
+  // instance of every command offsets it to the list of its mesh.
+  glBindBuffer(GL_ARRAY_BUFFER, instance_id_buffer_id_);
+  glVertexAttribIPointer(kInstanceIdAttribute, 1, GL_UNSIGNED_INT, 0,
+                         nullptr);
+  glVertexAttribDivisor(kInstanceIdAttribute, 1);
+  glEnableVertexAttribArray(kInstanceIdAttribute);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, element_buffer_object_id_);
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+  return true;
+}
+
+int GpuCuller::AddMesh(const Eigen::MatrixXf& vertices,
+                       const std::vector<GLuint>& indices) {
+  CHECK_EQ(vertices.rows(), kNumFloatsPerVertex);
+  MeshData mesh;
+  mesh.index_count = indices.size();
+  mesh.first_index = index_data_.size();
+  mesh.base_vertex = vertex_data_.size() / kNumFloatsPerVertex;
+  mesh.num_instances = 0;
+  meshes_.push_back(mesh);
+  vertex_data_.insert(vertex_data_.end(), vertices.data(),
+                      vertices.data() + vertices.size());
+  index_data_.insert(index_data_.end(), indices.begin(), indices.end());
+  // Bounding sphere centered at the center of the bounding box.
+  const Eigen::Vector3f min_corner = vertices.topRows<3>().rowwise().minCoeff();
+  const Eigen::Vector3f max_corner = vertices.topRows<3>().rowwise().maxCoeff();
+  const Eigen::Vector3f center = 0.5f * (min_corner + max_corner);
+  const GLfloat radius =
+      (vertices.topRows<3>().colwise() - center).colwise().norm().maxCoeff();
+  bounding_spheres_.insert(bounding_spheres_.end(),
+                           {center.x(), center.y(), center.z(), radius});
+  geometry_dirty_ = true;
+  return static_cast<int>(meshes_.size()) - 1;
+}
+
+int GpuCuller::AddInstance(const int mesh_id,
+                           const Eigen::Matrix4f& model_matrix) {
+  CHECK_GE(mesh_id, 0);
+  CHECK_LT(mesh_id, meshes_.size());
+  InstanceData instance;
+  Eigen::Map<Eigen::Matrix4f>(instance.model) = model_matrix;
+  instance.mesh_id = mesh_id;
+  instance.padding[0] = instance.padding[1] = instance.padding[2] = 0;
+  instances_.push_back(instance);
+  ++meshes_[mesh_id].num_instances;
+  // The instance id lists of the meshes are laid out from the instance
+  // counts, so the command templates have to be rebuilt.
+  geometry_dirty_ = true;
+  instances_dirty_ = true;
+  return static_cast<int>(instances_.size()) - 1;
+}
+
+void GpuCuller::SetInstanceTransform(const int instance_id,
+                                     const Eigen::Matrix4f& model_matrix) {
+  Eigen::Map<Eigen::Matrix4f>(instances_[instance_id].model) = model_matrix;
+  instances_dirty_ = true;
+}
+
+void GpuCuller::UploadGeometry() {
+  if (!geometry_dirty_) return;
+  UploadBuffer(GL_ARRAY_BUFFER, vertex_buffer_object_id_, vertex_data_);
+  UploadBuffer(GL_ELEMENT_ARRAY_BUFFER, element_buffer_object_id_,
+               index_data_);
+  UploadBuffer(GL_SHADER_STORAGE_BUFFER, bounding_sphere_buffer_id_,
+               bounding_spheres_);
+  // Every mesh owns a range of the instance id list large enough to hold all
+  // its instances.
+  std::vector<DrawElementsIndirectCommand> commands(meshes_.size());
+  GLuint base_instance = 0;
+  for (int i = 0; i < meshes_.size(); ++i) {
+    commands[i].count = meshes_[i].index_count;
+    commands[i].instance_count = 0;
+    commands[i].first_index = meshes_[i].first_index;
+    commands[i].base_vertex = meshes_[i].base_vertex;
+    commands[i].base_instance = base_instance;
+    base_instance += meshes_[i].num_instances;
+  }
+  UploadBuffer(GL_COPY_READ_BUFFER, command_template_buffer_id_, commands);
+  UploadBuffer(GL_DRAW_INDIRECT_BUFFER, command_buffer_id_, commands);
+  glBindBuffer(GL_ARRAY_BUFFER, instance_id_buffer_id_);
+  glBufferData(GL_ARRAY_BUFFER,
+               std::max<size_t>(instances_.size(), 1) * sizeof(GLuint),
+               nullptr, GL_DYNAMIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  geometry_dirty_ = false;
+}
+
+void GpuCuller::UploadInstances() {
+  if (!instances_dirty_) return;
+  UploadBuffer(GL_SHADER_STORAGE_BUFFER, instance_buffer_id_, instances_);
+  instances_dirty_ = false;
+}
+
+void GpuCuller::Cull(const Eigen::Matrix4f& projection,
+                     const Eigen::Matrix4f& view) {
+  last_projection_ = projection;
+  last_view_ = view;
+  if (instances_.empty()) return;
+  UploadGeometry();
+  UploadInstances();
+  // Reset the instance counts by copying the command templates.
+  const GLsizeiptr commands_size_in_bytes =
+      meshes_.size() * sizeof(DrawElementsIndirectCommand);
+  glBindBuffer(GL_COPY_READ_BUFFER, command_template_buffer_id_);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, command_buffer_id_);
+  glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0,
+                      commands_size_in_bytes);
+  glBindBuffer(GL_COPY_READ_BUFFER, 0);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+  cull_program_.Use();
+  const GLuint program_id = cull_program_.shader_program_id();
+  Eigen::Vector4f planes[kNumFrustumPlanes];
+  ExtractFrustumPlanes(projection * view, planes);
+  GLfloat plane_data[4 * kNumFrustumPlanes];
+  for (int i = 0; i < kNumFrustumPlanes; ++i) {
+    Eigen::Map<Eigen::Vector4f>(plane_data + 4 * i) = planes[i];
+  }
+  glUniform4fv(glGetUniformLocation(program_id, "frustum_planes"),
+               kNumFrustumPlanes, plane_data);
+  glUniform1ui(glGetUniformLocation(program_id, "num_instances"),
+               instances_.size());
+  const GpuCuller& pyramid = *depth_pyramid_owner_;
+  glUniform1i(glGetUniformLocation(program_id, "occlusion_culling"),
+              pyramid.has_depth_pyramid_);
+  if (pyramid.has_depth_pyramid_) {
+    glUniformMatrix4fv(glGetUniformLocation(program_id, "previous_view"), 1,
+                       GL_FALSE, pyramid.previous_view_.data());
+    glUniformMatrix4fv(glGetUniformLocation(program_id, "previous_projection"),
+                       1, GL_FALSE, pyramid.previous_projection_.data());
+    glUniform2f(glGetUniformLocation(program_id, "depth_pyramid_size"),
+                pyramid.depth_pyramid_width_, pyramid.depth_pyramid_height_);
+    glUniform1f(glGetUniformLocation(program_id, "max_level"),
+                pyramid.depth_pyramid_levels_ - 1);
+    glUniform1i(glGetUniformLocation(program_id, "depth_pyramid"), 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, pyramid.depth_pyramid_texture_id_);
+  }
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kInstanceBinding,
+                   instance_buffer_id_);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kBoundingSphereBinding,
+                   bounding_sphere_buffer_id_);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kCommandBinding,
+                   command_buffer_id_);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kInstanceIdBinding,
+                   instance_id_buffer_id_);
+  glDispatchCompute(NumWorkGroups(instances_.size(), kCullWorkGroupSize), 1,
+                    1);
+  // The commands and the instance ids are consumed by the draw.
+  glMemoryBarrier(GL_COMMAND_BARRIER_BIT |
+                  GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glUseProgram(0);
+}
+
+void GpuCuller::Draw(const Eigen::Matrix4f& projection,
+                     const Eigen::Matrix4f& view,
+                     const GLuint texture_id) {
+  if (instances_.empty()) return;
+  draw_program_.Use();
+  const GLuint program_id = draw_program_.shader_program_id();
+  glUniformMatrix4fv(glGetUniformLocation(program_id, "view"), 1, GL_FALSE,
+                     view.data());
+  glUniformMatrix4fv(glGetUniformLocation(program_id, "projection"), 1,
+                     GL_FALSE, projection.data());
+  glBindTexture(GL_TEXTURE_2D, texture_id);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kInstanceBinding,
+                   instance_buffer_id_);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, command_buffer_id_);
+  glBindVertexArray(vertex_array_object_id_);
+  glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr,
+                              meshes_.size(), 0);
+  glBindVertexArray(0);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+  glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void GpuCuller::BuildDepthPyramid(const GLuint depth_texture_id,
+                                  const int width,
+                                  const int height) {
+  if (width != depth_pyramid_width_ || height != depth_pyramid_height_) {
+    glDeleteTextures(1, &depth_pyramid_texture_id_);
+    depth_pyramid_width_ = width;
+    depth_pyramid_height_ = height;
+    depth_pyramid_levels_ = 1 + static_cast<int>(
+        std::floor(std::log2(std::max(width, height))));
+    glGenTextures(1, &depth_pyramid_texture_id_);
+    glBindTexture(GL_TEXTURE_2D, depth_pyramid_texture_id_);
+    glTexStorage2D(GL_TEXTURE_2D, depth_pyramid_levels_, GL_R32F, width,
+                   height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                    GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+  }
+  // Level zero is a copy of the depth texture.
+  depth_copy_program_.Use();
+  glUniform1i(glGetUniformLocation(depth_copy_program_.shader_program_id(),
+                                   "depth_texture"), 0);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, depth_texture_id);
+  glBindImageTexture(0, depth_pyramid_texture_id_, 0, GL_FALSE, 0,
+                     GL_WRITE_ONLY, GL_R32F);
+  glDispatchCompute(NumWorkGroups(width, kPyramidWorkGroupSize),
+                    NumWorkGroups(height, kPyramidWorkGroupSize), 1);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  // Every other level is the max-reduction of the previous one.
+  depth_reduce_program_.Use();
+  int level_width = width;
+  int level_height = height;
+  for (int level = 1; level < depth_pyramid_levels_; ++level) {
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    level_width = std::max(level_width / 2, 1);
+    level_height = std::max(level_height / 2, 1);
+    glBindImageTexture(0, depth_pyramid_texture_id_, level - 1, GL_FALSE, 0,
+                       GL_READ_ONLY, GL_R32F);
+    glBindImageTexture(1, depth_pyramid_texture_id_, level, GL_FALSE, 0,
+                       GL_WRITE_ONLY, GL_R32F);
+    glDispatchCompute(NumWorkGroups(level_width, kPyramidWorkGroupSize),
+                      NumWorkGroups(level_height, kPyramidWorkGroupSize), 1);
+  }
+  // The next Cull() call samples the pyramid as a texture.
+  glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+  glUseProgram(0);
+  previous_projection_ = last_projection_;
+  previous_view_ = last_view_;
+  has_depth_pyramid_ = true;
+}
+
+void GpuCuller::ShareDepthPyramid(const GpuCuller* culler) {
+  CHECK(culler != nullptr);
+  depth_pyramid_owner_ = culler;
+}
+
+}  // namespace wvu
@@ -0,0 +1,233 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef GPU_CULLING_H_
+#define GPU_CULLING_H_
+
+#include <string>
+#include <vector>
+#include <Eigen/Core>
+#include <GL/glew.h>
+
+#include "shader_program.h"
+
+namespace wvu {
+// This class culls and draws many instances of a set of meshes without any
+// per-object work on the CPU. It requires OpenGL 4.3 (compute shaders, shader
+// storage buffers and multi-draw indirect).
+//
+// All the meshes live in a single vertex buffer and a single element buffer,
+// with the vertex layout used by Model::SetVBO (position, color, texel). Every
+// frame:
+//
+// 1. A compute pass reads the instance transforms and the mesh bounding
+//    spheres from shader storage buffers, and tests every instance against
+//    the view frustum and against the depth pyramid (Hi-Z) of the previous
+//    frame.
+// 2. The visible instances are compacted, per mesh, into an instance id list
+//    and counted into a glMultiDrawElementsIndirect command buffer using
+//    atomics.
+// 3. A single indirect draw renders all the visible instances of all the
+//    meshes. The vertex shader fetches the transform of every instance from
+//    its id.
+//
+// Occlusion culling tests the bounds against the depth of the previous frame,
+// so the depth pyramid has to be rebuilt with BuildDepthPyramid() from a depth
+// texture after the opaque geometry is rendered (e.g., the G-buffer depth of
+// the deferred renderer). Until then only frustum culling is performed.
+//
+// Usage example:
+//
+// wvu::GpuCuller culler;
+// if (!wvu::GpuCuller::IsSupported() || !culler.Initialize(&error_info_log)) {
+//   ...  // Fall back to the regular path.
+// }
+// const int mesh = culler.AddMesh(vertices, indices);
+// for (...) culler.AddInstance(mesh, model_matrix);
+// ...
+// while (...) {  // Rendering loop.
+//   culler.Cull(projection, view);
+//   culler.Draw(projection, view, texture_id);
+//   culler.BuildDepthPyramid(depth_texture_id, width, height);
+// }
+//
+// Cullers drawing into the same frame (e.g., one per texture) build the
+// pyramid once: every other culler calls ShareDepthPyramid(&culler).
+class GpuCuller {
+ public:
+  GpuCuller();
+  ~GpuCuller();
+
+  // Returns true if the current OpenGL context supports the culler.
+  static bool IsSupported();
+
+  // Compiles the shader programs and creates the buffers. Returns true upon
+  // success and false otherwise.
+  // Params:
+  //   error_info_log  A pointer to a string that holds the error log.
+  bool Initialize(std::string* error_info_log);
+
+  // Adds a mesh to the shared geometry buffers and returns its id.
+  // Params:
+  //   vertices  The vertices (one per column) in the layout of Model::SetVBO.
+  //   indices  The triangle indices.
+  int AddMesh(const Eigen::MatrixXf& vertices,
+              const std::vector<GLuint>& indices);
+
+  // Adds an instance of a mesh and returns its id.
+  // Params:
+  //   mesh_id  The id returned by AddMesh.
+  //   model_matrix  The model transformation of the instance.
+  int AddInstance(const int mesh_id, const Eigen::Matrix4f& model_matrix);
+
+  // Updates the model transformation of an instance.
+  void SetInstanceTransform(const int instance_id,
+                            const Eigen::Matrix4f& model_matrix);
+
+  // Culls the instances and builds the indirect draw commands on the GPU.
+  // Params:
+  //   projection  The camera projection matrix.
+  //   view  The camera pose matrix (world -> camera transformation matrix).
+  void Cull(const Eigen::Matrix4f& projection, const Eigen::Matrix4f& view);
+
+  // Draws the visible instances with a single indirect draw call.
+  // Params:
+  //   projection  The camera projection matrix.
+  //   view  The camera pose matrix (world -> camera transformation matrix).
+  //   texture_id  The texture shared by all the instances.
+  void Draw(const Eigen::Matrix4f& projection,
+            const Eigen::Matrix4f& view,
+            const GLuint texture_id);
+
+  // Builds the max-depth pyramid used by the occlusion test of the next
+  // Cull() call. The view and projection matrices of the last Cull() call are
+  // assumed to be the ones used to render the depth texture.
+  // Params:
+  //   depth_texture_id  The depth texture of the frame.
+  //   width  The width of the depth texture.
+  //   height  The height of the depth texture.
+  void BuildDepthPyramid(const GLuint depth_texture_id,
+                         const int width,
+                         const int height);
+
+  // Makes the occlusion test sample the depth pyramid built by another culler
+  // instead of building its own, so that the cullers drawing into the same
+  // frame share a single pyramid. The other culler must outlive this one.
+  // Params:
+  //   culler  The culler whose BuildDepthPyramid() is called every frame.
+  void ShareDepthPyramid(const GpuCuller* culler);
+
+  // Returns the number of meshes.
+  int num_meshes() const {
+    return static_cast<int>(meshes_.size());
+  }
+
+  // Returns the number of instances.
+  int num_instances() const {
+    return static_cast<int>(instances_.size());
+  }
+
+ private:
+  // Per-instance data in the std430 layout of the shaders.
+  struct InstanceData {
+    GLfloat model[16];
+    GLuint mesh_id;
+    GLuint padding[3];
+  };
+
+  // Indirect draw command layout defined by glMultiDrawElementsIndirect.
+  struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instance_count;
+    GLuint first_index;
+    GLint base_vertex;
+    GLuint base_instance;
+  };
+
+  // Location of a mesh in the shared buffers.
+  struct MeshData {
+    GLuint index_count;
+    GLuint first_index;
+    GLint base_vertex;
+    GLuint num_instances;
+  };
+
+  // Uploads the geometry and the command templates when they changed.
+  void UploadGeometry();
+  // Uploads the instance data when it changed.
+  void UploadInstances();
+
+  // Geometry.
+  std::vector<GLfloat> vertex_data_;
+  std::vector<GLuint> index_data_;
+  std::vector<MeshData> meshes_;
+  // Bounding sphere (center, radius) of every mesh.
+  std::vector<GLfloat> bounding_spheres_;
+  std::vector<InstanceData> instances_;
+  bool geometry_dirty_;
+  bool instances_dirty_;
+
+  // Buffers.
+  GLuint vertex_array_object_id_;
+  GLuint vertex_buffer_object_id_;
+  GLuint element_buffer_object_id_;
+  GLuint instance_buffer_id_;
+  GLuint bounding_sphere_buffer_id_;
+  GLuint command_template_buffer_id_;
+  GLuint command_buffer_id_;
+  GLuint instance_id_buffer_id_;
+
+  // Depth pyramid of the previous frame.
+  GLuint depth_pyramid_texture_id_;
+  int depth_pyramid_width_;
+  int depth_pyramid_height_;
+  int depth_pyramid_levels_;
+  bool has_depth_pyramid_;
+  Eigen::Matrix4f previous_projection_;
+  Eigen::Matrix4f previous_view_;
+  Eigen::Matrix4f last_projection_;
+  Eigen::Matrix4f last_view_;
+  // The culler owning the depth pyramid sampled by Cull(); this by default.
+  const GpuCuller* depth_pyramid_owner_;
+
+  // Shader programs.
+  ShaderProgram cull_program_;
+  ShaderProgram depth_copy_program_;
+  ShaderProgram depth_reduce_program_;
+  ShaderProgram draw_program_;
+};
+
+}  // namespace wvu
+
+#endif  // GPU_CULLING_H_
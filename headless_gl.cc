@@ -0,0 +1,269 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#include "headless_gl.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <GL/glew.h>
+#ifdef WVU_HAVE_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+#include <GLFW/glfw3.h>
+#include <glog/logging.h>
+
+namespace wvu {
+
+const char* GetGlContextBackendName(const GlContextBackend backend) {
+  switch (backend) {
+    case GlContextBackend::NONE: return "none";
+    case GlContextBackend::EGL_SURFACELESS: return "EGL surfaceless";
+    case GlContextBackend::GLFW: return "GLFW";
+  }
+  return "";
+}
+
+HeadlessGlContext::HeadlessGlContext() :
+    backend_(GlContextBackend::NONE), egl_display_(nullptr),
+    egl_context_(nullptr), window_(nullptr) {}
+
+HeadlessGlContext::~HeadlessGlContext() {
+  Destroy();
+}
+
+bool HeadlessGlContext::Initialize(std::string* error_info_log) {
+  CHECK(backend_ == GlContextBackend::NONE) << "Initialized twice.";
+  std::string egl_error_info_log;
+  std::string glfw_error_info_log;
+  if (InitializeEgl(&egl_error_info_log)) {
+    backend_ = GlContextBackend::EGL_SURFACELESS;
+  } else if (InitializeGlfw(&glfw_error_info_log)) {
+    backend_ = GlContextBackend::GLFW;
+  } else {
+    if (error_info_log != nullptr) {
+      *error_info_log = "Could not create an OpenGL context. EGL: " +
+          egl_error_info_log + " GLFW: " + glfw_error_info_log;
+    }
+    return false;
+  }
+  glewExperimental = GL_TRUE;
+  const GLenum glew_status = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+  // GLEW built for GLX loads the core and the extension functions first, and
+  // then fails to find the GLX display an EGL context does not have.
+  const bool glew_initialized = glew_status == GLEW_OK ||
+      (backend_ == GlContextBackend::EGL_SURFACELESS &&
+       glew_status == GLEW_ERROR_NO_GLX_DISPLAY);
+#else
+  const bool glew_initialized = glew_status == GLEW_OK;
+#endif
+  if (!glew_initialized) {
+    if (error_info_log != nullptr) {
+      *error_info_log = "GLEW did not initialize properly.";
+    }
+    Destroy();
+    return false;
+  }
+  return true;
+}
+
+bool HeadlessGlContext::InitializeEgl(std::string* error_info_log) {
+#ifdef WVU_HAVE_EGL
+  const char* client_extensions =
+      eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+  if (client_extensions == nullptr ||
+      std::string(client_extensions).find("EGL_MESA_platform_surfaceless") ==
+      std::string::npos) {
+    *error_info_log = "EGL_MESA_platform_surfaceless is not supported.";
+    return false;
+  }
+  const PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display =
+      reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+          eglGetProcAddress("eglGetPlatformDisplayEXT"));
+  if (get_platform_display == nullptr) {
+    *error_info_log = "eglGetPlatformDisplayEXT is not available.";
+    return false;
+  }
+  const EGLDisplay display = get_platform_display(
+      EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+  EGLint major_version, minor_version;
+  if (display == EGL_NO_DISPLAY ||
+      !eglInitialize(display, &major_version, &minor_version)) {
+    *error_info_log = "Could not initialize the surfaceless EGL display.";
+    return false;
+  }
+  // The context renders into framebuffer objects only: it needs neither a
+  // surface nor a config with one.
+  const EGLint config_attributes[] = {
+    EGL_SURFACE_TYPE, 0,
+    EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+    EGL_NONE
+  };
+  EGLConfig config;
+  EGLint num_configs = 0;
+  const EGLint context_attributes[] = {
+    EGL_CONTEXT_MAJOR_VERSION, 3,
+    EGL_CONTEXT_MINOR_VERSION, 3,
+    EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+    EGL_NONE
+  };
+  EGLContext context = EGL_NO_CONTEXT;
+  if (eglBindAPI(EGL_OPENGL_API) &&
+      eglChooseConfig(display, config_attributes, &config, 1, &num_configs) &&
+      num_configs > 0) {
+    context = eglCreateContext(display, config, EGL_NO_CONTEXT,
+                               context_attributes);
+  }
+  if (context == EGL_NO_CONTEXT ||
+      !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+    *error_info_log = "Could not create an OpenGL 3.3 core EGL context.";
+    if (context != EGL_NO_CONTEXT) eglDestroyContext(display, context);
+    eglTerminate(display);
+    return false;
+  }
+  egl_display_ = display;
+  egl_context_ = context;
+  return true;
+#else
+  *error_info_log = "Built without EGL.";
+  return false;
+#endif
+}
+
+bool HeadlessGlContext::InitializeGlfw(std::string* error_info_log) {
+  if (std::getenv("DISPLAY") == nullptr &&
+      std::getenv("WAYLAND_DISPLAY") == nullptr) {
+    *error_info_log = "There is no display.";
+    return false;
+  }
+  if (!glfwInit()) {
+    *error_info_log = "GLFW did not initialize correctly.";
+    return false;
+  }
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+  glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+  glfwWindowHint(GLFW_RESIZABLE, GL_FALSE);
+  glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+  window_ = glfwCreateWindow(64, 64, "Headless", nullptr, nullptr);
+  if (window_ == nullptr) {
+    *error_info_log = "Could not create a hidden window.";
+    glfwTerminate();
+    return false;
+  }
+  glfwMakeContextCurrent(window_);
+  return true;
+}
+
+void HeadlessGlContext::Destroy() {
+#ifdef WVU_HAVE_EGL
+  if (egl_context_ != nullptr) {
+    eglMakeCurrent(egl_display_, EGL_NO_SURFACE, EGL_NO_SURFACE,
+                   EGL_NO_CONTEXT);
+    eglDestroyContext(egl_display_, egl_context_);
+    eglTerminate(egl_display_);
+  }
+#endif
+  egl_display_ = nullptr;
+  egl_context_ = nullptr;
+  if (window_ != nullptr) {
+    glfwDestroyWindow(window_);
+    glfwTerminate();
+    window_ = nullptr;
+  }
+  backend_ = GlContextBackend::NONE;
+}
+
+OffscreenFramebuffer::OffscreenFramebuffer() :
+    width_(0), height_(0), framebuffer_id_(0), renderbuffer_ids_{0, 0} {}
+
+OffscreenFramebuffer::~OffscreenFramebuffer() {
+  if (framebuffer_id_ == 0) return;
+  glDeleteRenderbuffers(2, renderbuffer_ids_);
+  glDeleteFramebuffers(1, &framebuffer_id_);
+}
+
+bool OffscreenFramebuffer::Initialize(const int width,
+                                      const int height,
+                                      std::string* error_info_log) {
+  CHECK_EQ(framebuffer_id_, 0) << "Initialized twice.";
+  width_ = width;
+  height_ = height;
+  glGenFramebuffers(1, &framebuffer_id_);
+  glGenRenderbuffers(2, renderbuffer_ids_);
+  glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer_ids_[0]);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+  glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer_ids_[1]);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_id_);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                            GL_RENDERBUFFER, renderbuffer_ids_[0]);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                            GL_RENDERBUFFER, renderbuffer_ids_[1]);
+  const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  if (status != GL_FRAMEBUFFER_COMPLETE) {
+    if (error_info_log != nullptr) {
+      *error_info_log = "The offscreen framebuffer is incomplete.";
+    }
+    return false;
+  }
+  return true;
+}
+
+void OffscreenFramebuffer::Bind() const {
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_id_);
+  glViewport(0, 0, width_, height_);
+}
+
+void OffscreenFramebuffer::Unbind() const {
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void OffscreenFramebuffer::ReadPixels(std::vector<uint8_t>* rgba_pixels) const {
+  if (rgba_pixels == nullptr) return;
+  rgba_pixels->resize(4 * width_ * height_);
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer_id_);
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glReadPixels(0, 0, width_, height_, GL_RGBA, GL_UNSIGNED_BYTE,
+               rgba_pixels->data());
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+}
+
+}  // namespace wvu
@@ -0,0 +1,150 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef HEADLESS_GL_H_
+#define HEADLESS_GL_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <GL/glew.h>
+
+struct GLFWwindow;
+
+namespace wvu {
+
+// The API that created an OpenGL context.
+enum struct GlContextBackend {
+  NONE = 0,
+  // An EGL context without any surface (EGL_MESA_platform_surfaceless). It
+  // needs neither a display nor a GPU: Mesa renders with llvmpipe.
+  EGL_SURFACELESS = 1,
+  // A hidden GLFW window, which needs a display.
+  GLFW = 2
+};
+
+// Returns the name of the backend, e.g., for logging.
+const char* GetGlContextBackendName(const GlContextBackend backend);
+
+// An OpenGL 3.3 core context for the programs and the tests that render
+// offscreen, e.g., on CI machines without X. Since there is no default
+// framebuffer to draw into, they render into an OffscreenFramebuffer. Usage
+// example:
+//
+// wvu::HeadlessGlContext context;
+// std::string error_info_log;
+// if (!context.Initialize(&error_info_log)) {
+//   LOG(ERROR) << error_info_log;
+// }
+// wvu::OffscreenFramebuffer framebuffer;
+// framebuffer.Initialize(640, 480, &error_info_log);
+// framebuffer.Bind();
+// model->Draw(shader_program, projection, view, texture_id);
+// std::vector<uint8_t> rgba_pixels;
+// framebuffer.ReadPixels(&rgba_pixels);
+class HeadlessGlContext {
+ public:
+  HeadlessGlContext();
+  ~HeadlessGlContext();
+
+  // Creates the context, makes it current in the calling thread and
+  // initializes GLEW. An EGL surfaceless context is preferred; a hidden GLFW
+  // window is the fallback when a display exists. Returns true upon success
+  // and false otherwise.
+  // Params:
+  //   error_info_log  A pointer to a string that holds the error log.
+  bool Initialize(std::string* error_info_log);
+
+  GlContextBackend backend() const { return backend_; }
+
+ private:
+  // Creates the EGL surfaceless context. Returns true upon success.
+  bool InitializeEgl(std::string* error_info_log);
+  // Creates the hidden GLFW window. Returns true upon success.
+  bool InitializeGlfw(std::string* error_info_log);
+  // Destroys the context, if any.
+  void Destroy();
+
+  GlContextBackend backend_;
+  // The EGLDisplay and the EGLContext of the EGL backend.
+  void* egl_display_;
+  void* egl_context_;
+  // The window of the GLFW backend.
+  GLFWwindow* window_;
+};
+
+// A framebuffer object with an RGBA8 color and a 24-bit depth renderbuffer,
+// e.g., to render tests and benchmarks without a window and to read back
+// their pixels.
+class OffscreenFramebuffer {
+ public:
+  OffscreenFramebuffer();
+  ~OffscreenFramebuffer();
+
+  // Creates the framebuffer. Returns true upon success and false otherwise.
+  // Params:
+  //   width  The width of the framebuffer in pixels.
+  //   height  The height of the framebuffer in pixels.
+  //   error_info_log  A pointer to a string that holds the error log.
+  bool Initialize(const int width,
+                  const int height,
+                  std::string* error_info_log);
+
+  // Binds the framebuffer and sets the viewport to cover it.
+  void Bind() const;
+
+  // Restores the default framebuffer.
+  void Unbind() const;
+
+  // Reads the color of the framebuffer. The rows are in the OpenGL order,
+  // i.e., the bottom row first.
+  // Params:
+  //   rgba_pixels  The RGBA8 pixels.
+  void ReadPixels(std::vector<uint8_t>* rgba_pixels) const;
+
+  int width() const { return width_; }
+  int height() const { return height_; }
+  GLuint framebuffer_id() const { return framebuffer_id_; }
+
+ private:
+  int width_;
+  int height_;
+  GLuint framebuffer_id_;
+  // Color and depth renderbuffers.
+  GLuint renderbuffer_ids_[2];
+};
+
+}  // namespace wvu
+
+#endif  // HEADLESS_GL_H_
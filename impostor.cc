@@ -0,0 +1,470 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#include "impostor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <GL/glew.h>
+#include <glog/logging.h>
+
+#include "camera_utils.h"
+#include "model.h"
+#include "shader_program.h"
+
+namespace wvu {
+namespace {
+// Texture units used by the impostor shader.
+constexpr GLint kColorTextureUnit = 0;
+constexpr GLint kNormalDepthTextureUnit = 1;
+// First attribute location of the per-instance model matrix. A matrix takes
+// four consecutive locations.
+constexpr GLuint kModelMatrixAttribute = 1;
+
+const std::string bake_vertex_shader_src =
+    "#version 330 core\n"
+    "layout (location = 0) in vec3 position;\n"
+    "layout (location = 1) in vec3 passed_color;\n"
+    "layout (location = 2) in vec2 passed_texel;\n"
+    "uniform mat4 view;\n"
+    "uniform mat4 projection;\n"
+    "out vec3 view_position;\n"
+    "out vec2 texel;\n"
+    "void main() {\n"
+    "  vec4 position_in_view = view * vec4(position, 1.0f);\n"
+    "  view_position = position_in_view.xyz;\n"
+    "  texel = passed_texel;\n"
+    "  gl_Position = projection * position_in_view;\n"
+    "}\n";
+
+// The models have no normals, so the face normal is computed from the
+// derivatives of the position (as in the deferred geometry pass).
+const std::string bake_fragment_shader_src =
+    "#version 330 core\n"
+    "in vec3 view_position;\n"
+    "in vec2 texel;\n"
+    "layout (location = 0) out vec4 color;\n"
+    "layout (location = 1) out vec4 normal_depth;\n"
+    "uniform sampler2D texture_sampler;\n"
+    "uniform mat3 view_to_model;\n"
+    "void main() {\n"
+    "  color = vec4(texture(texture_sampler, texel).rgb, 1.0f);\n"
+    "  vec3 normal = normalize(cross(dFdx(view_position),\n"
+    "                                dFdy(view_position)));\n"
+    "  normal_depth = vec4(0.5f * normalize(view_to_model * normal) + 0.5f,\n"
+    "                      gl_FragCoord.z);\n"
+    "}\n";
+
+// The frame selection and the frame basis mirror EncodeHemiOctahedral,
+// DecodeHemiOctahedral and ComputeFrameBasis.
+const std::string impostor_vertex_shader_src =
+    "#version 330 core\n"
+    "layout (location = 0) in vec2 corner;\n"
+    "layout (location = 1) in mat4 model;\n"
+    "uniform mat4 view;\n"
+    "uniform mat4 projection;\n"
+    "uniform vec3 camera_position;\n"
+    "uniform vec3 center;\n"
+    "uniform float radius;\n"
+    "uniform float frames_per_side;\n"
+    "out vec2 atlas_texel;\n"
+    "out vec3 model_position;\n"
+    "flat out vec3 frame_direction;\n"
+    "flat out mat4 model_view_projection;\n"
+    "flat out mat3 normal_matrix;\n"
+    "vec2 EncodeHemiOctahedral(vec3 direction) {\n"
+    "  direction.y = max(direction.y, 0.0f);\n"
+    "  vec2 p = direction.xz / max(abs(direction.x) + direction.y +\n"
+    "                              abs(direction.z), 1e-6f);\n"
+    "  return vec2(p.x + p.y, p.x - p.y);\n"
+    "}\n"
+    "vec3 DecodeHemiOctahedral(vec2 coordinates) {\n"
+    "  vec2 p = 0.5f * vec2(coordinates.x + coordinates.y,\n"
+    "                       coordinates.x - coordinates.y);\n"
+    "  return normalize(vec3(p.x, 1.0f - abs(p.x) - abs(p.y), p.y));\n"
+    "}\n"
+    "void main() {\n"
+    "  // Direction towards the camera in model coordinates.\n"
+    "  vec3 center_in_world = (model * vec4(center, 1.0f)).xyz;\n"
+    "  vec3 to_camera = normalize(transpose(mat3(model)) *\n"
+    "                             (camera_position - center_in_world));\n"
+    "  // The frame baked from the closest direction.\n"
+    "  vec2 cell = clamp(floor((0.5f * EncodeHemiOctahedral(to_camera) +\n"
+    "                           0.5f) * frames_per_side),\n"
+    "                    0.0f, frames_per_side - 1.0f);\n"
+    "  frame_direction =\n"
+    "      DecodeHemiOctahedral(2.0f * (cell + 0.5f) / frames_per_side - 1.0f);\n"
+    "  vec3 up_reference = abs(frame_direction.y) > 0.999f ?\n"
+    "      vec3(0.0f, 0.0f, -1.0f) : vec3(0.0f, 1.0f, 0.0f);\n"
+    "  vec3 right = normalize(cross(-frame_direction, up_reference));\n"
+    "  vec3 up = cross(right, -frame_direction);\n"
+    "  model_position = center + radius * (corner.x * right + corner.y * up);\n"
+    "  atlas_texel = (cell + 0.5f * corner + 0.5f) / frames_per_side;\n"
+    "  model_view_projection = projection * view * model;\n"
+    "  normal_matrix = mat3(model);\n"
+    "  gl_Position = model_view_projection * vec4(model_position, 1.0f);\n"
+    "}\n";
+
+const std::string impostor_fragment_shader_src =
+    "#version 330 core\n"
+    "in vec2 atlas_texel;\n"
+    "in vec3 model_position;\n"
+    "flat in vec3 frame_direction;\n"
+    "flat in mat4 model_view_projection;\n"
+    "flat in mat3 normal_matrix;\n"
+    "out vec4 color;\n"
+    "uniform sampler2D color_sampler;\n"
+    "uniform sampler2D normal_depth_sampler;\n"
+    "uniform float radius;\n"
+    "uniform vec3 light_direction;\n"
+    "uniform vec3 light_color;\n"
+    "uniform vec3 ambient_color;\n"
+    "void main() {\n"
+    "  vec4 albedo = texture(color_sampler, atlas_texel);\n"
+    "  if (albedo.a < 0.5f) {\n"
+    "    discard;\n"
+    "  }\n"
+    "  vec4 normal_depth = texture(normal_depth_sampler, atlas_texel);\n"
+    "  // Move from the quad to the baked surface to get the right depth.\n"
+    "  vec3 surface = model_position -\n"
+    "      frame_direction * radius * (2.0f * normal_depth.a - 1.0f);\n"
+    "  vec4 clip_position = model_view_projection * vec4(surface, 1.0f);\n"
+    "  gl_FragDepth = 0.5f * clip_position.z / clip_position.w + 0.5f;\n"
+    "  vec3 normal = normalize(normal_matrix * (2.0f * normal_depth.rgb - 1.0f));\n"
+    "  float diffuse = max(dot(normal, -light_direction), 0.0f);\n"
+    "  color = vec4(albedo.rgb * (ambient_color + diffuse * light_color), 1.0f);\n"
+    "}\n";
+
+bool CreateProgram(const std::string& vertex_shader_src,
+                   const std::string& fragment_shader_src,
+                   ShaderProgram* shader_program,
+                   std::string* error_info_log) {
+  shader_program->LoadVertexShaderFromString(vertex_shader_src);
+  shader_program->LoadFragmentShaderFromString(fragment_shader_src);
+  return shader_program->Create(error_info_log);
+}
+
+// Computes the rotation of the camera looking at the model from the given
+// direction: the rows are the right, up and backward axes.
+Eigen::Matrix3f ComputeFrameBasis(const Eigen::Vector3f& direction) {
+  const Eigen::Vector3f up_reference = std::abs(direction.y()) > 0.999f ?
+      Eigen::Vector3f(0.0f, 0.0f, -1.0f) : Eigen::Vector3f::UnitY();
+  const Eigen::Vector3f right =
+      (-direction).cross(up_reference).normalized();
+  const Eigen::Vector3f up = right.cross(-direction);
+  Eigen::Matrix3f rotation;
+  rotation.row(0) = right;
+  rotation.row(1) = up;
+  rotation.row(2) = direction;
+  return rotation;
+}
+
+GLuint CreateAtlas(const GLenum attachment,
+                   const int size,
+                   const int num_levels) {
+  GLuint texture_id;
+  glGenTextures(1, &texture_id);
+  glBindTexture(GL_TEXTURE_2D, texture_id);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size, size, 0, GL_RGBA,
+               GL_UNSIGNED_BYTE, nullptr);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                  num_levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  // Past this level the frames would bleed into each other.
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, num_levels - 1);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D,
+                         texture_id, 0);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  return texture_id;
+}
+
+}  // namespace
+
+Eigen::Vector2f EncodeHemiOctahedral(const Eigen::Vector3f& direction) {
+  const GLfloat y = std::max(direction.y(), 0.0f);
+  const GLfloat norm = std::max(
+      std::abs(direction.x()) + y + std::abs(direction.z()), 1e-6f);
+  const GLfloat p_x = direction.x() / norm;
+  const GLfloat p_z = direction.z() / norm;
+  return Eigen::Vector2f(p_x + p_z, p_x - p_z);
+}
+
+Eigen::Vector3f DecodeHemiOctahedral(const Eigen::Vector2f& coordinates) {
+  const GLfloat p_x = 0.5f * (coordinates.x() + coordinates.y());
+  const GLfloat p_z = 0.5f * (coordinates.x() - coordinates.y());
+  return Eigen::Vector3f(p_x, 1.0f - std::abs(p_x) - std::abs(p_z), p_z)
+      .normalized();
+}
+
+void DeleteImpostor(Impostor* impostor) {
+  glDeleteTextures(1, &impostor->color_texture_id);
+  glDeleteTextures(1, &impostor->normal_depth_texture_id);
+  impostor->color_texture_id = 0;
+  impostor->normal_depth_texture_id = 0;
+}
+
+ImpostorBaker::ImpostorBaker() {}
+
+ImpostorBaker::~ImpostorBaker() {}
+
+bool ImpostorBaker::Initialize(std::string* error_info_log) {
+  if (!CreateProgram(bake_vertex_shader_src, bake_fragment_shader_src,
+                     &bake_shader_program_, error_info_log)) {
+    return false;
+  }
+  bake_shader_program_.Use();
+  glUniform1i(glGetUniformLocation(bake_shader_program_.shader_program_id(),
+                                   "texture_sampler"), 0);
+  glUseProgram(0);
+  return true;
+}
+
+bool ImpostorBaker::Bake(const Model& model,
+                         const GLuint texture_id,
+                         const int frames_per_side,
+                         const int frame_resolution,
+                         Impostor* impostor,
+                         std::string* error_info_log) {
+  if (impostor == nullptr) return false;
+  CHECK_GT(frames_per_side, 0);
+  CHECK_GT(frame_resolution, 0);
+  // Bounding sphere centered at the center of the bounding box.
+  const Eigen::MatrixXf& vertices = model.vertices();
+  const Eigen::Vector3f min_corner = vertices.topRows<3>().rowwise().minCoeff();
+  const Eigen::Vector3f max_corner = vertices.topRows<3>().rowwise().maxCoeff();
+  impostor->center = 0.5f * (min_corner + max_corner);
+  impostor->radius = std::max(
+      (vertices.topRows<3>().colwise() - impostor->center)
+          .colwise().norm().maxCoeff(), 1e-6f);
+  impostor->frames_per_side = frames_per_side;
+
+  // Offscreen framebuffer covering the whole atlas.
+  const int atlas_size = frames_per_side * frame_resolution;
+  const int num_levels =
+      1 + static_cast<int>(std::floor(std::log2(frame_resolution)));
+  GLuint framebuffer_id;
+  glGenFramebuffers(1, &framebuffer_id);
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_id);
+  impostor->color_texture_id =
+      CreateAtlas(GL_COLOR_ATTACHMENT0, atlas_size, num_levels);
+  impostor->normal_depth_texture_id =
+      CreateAtlas(GL_COLOR_ATTACHMENT1, atlas_size, 1);
+  GLuint depth_renderbuffer_id;
+  glGenRenderbuffers(1, &depth_renderbuffer_id);
+  glBindRenderbuffer(GL_RENDERBUFFER, depth_renderbuffer_id);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, atlas_size,
+                        atlas_size);
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                            GL_RENDERBUFFER, depth_renderbuffer_id);
+  const GLenum draw_buffers[] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+  glDrawBuffers(2, draw_buffers);
+  if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &framebuffer_id);
+    glDeleteRenderbuffers(1, &depth_renderbuffer_id);
+    DeleteImpostor(impostor);
+    if (error_info_log) {
+      *error_info_log = "The impostor framebuffer is incomplete.";
+    }
+    return false;
+  }
+  GLint previous_viewport[4];
+  glGetIntegerv(GL_VIEWPORT, previous_viewport);
+  glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  glEnable(GL_DEPTH_TEST);
+  glDisable(GL_BLEND);
+  glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+
+  // Every frame is an orthographic view of the bounding sphere from a camera
+  // two radii away from its center.
+  const GLfloat radius = impostor->radius;
+  const Eigen::Matrix4f projection = ComputeOrthographicProjectionMatrix(
+      -radius, radius, -radius, radius, radius, 3.0f * radius);
+  bake_shader_program_.Use();
+  const GLuint program_id = bake_shader_program_.shader_program_id();
+  glUniformMatrix4fv(glGetUniformLocation(program_id, "projection"), 1,
+                     GL_FALSE, projection.data());
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, texture_id);
+  glBindVertexArray(model.vertex_array_object_id());
+  for (int j = 0; j < frames_per_side; ++j) {
+    for (int i = 0; i < frames_per_side; ++i) {
+      const Eigen::Vector2f coordinates =
+          2.0f * (Eigen::Vector2f(i, j).array() + 0.5f) / frames_per_side -
+          1.0f;
+      const Eigen::Vector3f direction = DecodeHemiOctahedral(coordinates);
+      const Eigen::Matrix3f rotation = ComputeFrameBasis(direction);
+      const Eigen::Vector3f eye = impostor->center + 2.0f * radius * direction;
+      Eigen::Matrix4f view = Eigen::Matrix4f::Identity();
+      view.block<3, 3>(0, 0) = rotation;
+      view.block<3, 1>(0, 3) = -rotation * eye;
+      const Eigen::Matrix3f view_to_model = rotation.transpose();
+      glUniformMatrix4fv(glGetUniformLocation(program_id, "view"), 1,
+                         GL_FALSE, view.data());
+      glUniformMatrix3fv(glGetUniformLocation(program_id, "view_to_model"), 1,
+                         GL_FALSE, view_to_model.data());
+      glViewport(i * frame_resolution, j * frame_resolution,
+                 frame_resolution, frame_resolution);
+      if (model.indices().empty()) {
+        glDrawArrays(GL_TRIANGLES, 0, vertices.cols());
+      } else {
+        glDrawElements(GL_TRIANGLES, model.indices().size(), GL_UNSIGNED_INT,
+                       nullptr);
+      }
+    }
+  }
+  glBindVertexArray(0);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glUseProgram(0);
+
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glViewport(previous_viewport[0], previous_viewport[1], previous_viewport[2],
+             previous_viewport[3]);
+  glDeleteFramebuffers(1, &framebuffer_id);
+  glDeleteRenderbuffers(1, &depth_renderbuffer_id);
+  glBindTexture(GL_TEXTURE_2D, impostor->color_texture_id);
+  glGenerateMipmap(GL_TEXTURE_2D);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  return true;
+}
+
+ImpostorRenderer::ImpostorRenderer() :
+    vertex_array_object_id_(0), quad_buffer_id_(0), instance_buffer_id_(0),
+    light_direction_(0.0f, -1.0f, 0.0f), light_color_(Eigen::Vector3f::Zero()),
+    ambient_color_(Eigen::Vector3f::Ones()) {}
+
+ImpostorRenderer::~ImpostorRenderer() {
+  glDeleteBuffers(1, &quad_buffer_id_);
+  glDeleteBuffers(1, &instance_buffer_id_);
+  glDeleteVertexArrays(1, &vertex_array_object_id_);
+}
+
+bool ImpostorRenderer::Initialize(std::string* error_info_log) {
+  if (!CreateProgram(impostor_vertex_shader_src, impostor_fragment_shader_src,
+                     &shader_program_, error_info_log)) {
+    return false;
+  }
+  shader_program_.Use();
+  const GLuint program_id = shader_program_.shader_program_id();
+  glUniform1i(glGetUniformLocation(program_id, "color_sampler"),
+              kColorTextureUnit);
+  glUniform1i(glGetUniformLocation(program_id, "normal_depth_sampler"),
+              kNormalDepthTextureUnit);
+  glUseProgram(0);
+
+  glGenVertexArrays(1, &vertex_array_object_id_);
+  glBindVertexArray(vertex_array_object_id_);
+  // Corners of the quad as a triangle strip.
+  const GLfloat corners[] = {-1.0f, -1.0f, 1.0f, -1.0f,
+                             -1.0f, 1.0f, 1.0f, 1.0f};
+  glGenBuffers(1, &quad_buffer_id_);
+  glBindBuffer(GL_ARRAY_BUFFER, quad_buffer_id_);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+  glEnableVertexAttribArray(0);
+  // One model matrix per instance, one column per attribute.
+  glGenBuffers(1, &instance_buffer_id_);
+  glBindBuffer(GL_ARRAY_BUFFER, instance_buffer_id_);
+  for (int i = 0; i < 4; ++i) {
+    glVertexAttribPointer(kModelMatrixAttribute + i, 4, GL_FLOAT, GL_FALSE,
+                          16 * sizeof(GLfloat),
+                          reinterpret_cast<GLvoid*>(4 * i * sizeof(GLfloat)));
+    glVertexAttribDivisor(kModelMatrixAttribute + i, 1);
+    glEnableVertexAttribArray(kModelMatrixAttribute + i);
+  }
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  return true;
+}
+
+void ImpostorRenderer::Draw(const Impostor& impostor,
+                            const std::vector<Eigen::Matrix4f>& model_matrices,
+                            const Eigen::Matrix4f& projection,
+                            const Eigen::Matrix4f& view) {
+  if (model_matrices.empty()) return;
+  // The matrices are column-major like OpenGL expects them.
+  instance_data_.resize(16 * model_matrices.size());
+  for (int i = 0; i < model_matrices.size(); ++i) {
+    std::copy(model_matrices[i].data(), model_matrices[i].data() + 16,
+              instance_data_.begin() + 16 * i);
+  }
+  glBindBuffer(GL_ARRAY_BUFFER, instance_buffer_id_);
+  glBufferData(GL_ARRAY_BUFFER, instance_data_.size() * sizeof(GLfloat),
+               instance_data_.data(), GL_STREAM_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  shader_program_.Use();
+  const GLuint program_id = shader_program_.shader_program_id();
+  const Eigen::Vector3f camera_position =
+      -view.block<3, 3>(0, 0).transpose() * view.block<3, 1>(0, 3);
+  glUniformMatrix4fv(glGetUniformLocation(program_id, "view"), 1, GL_FALSE,
+                     view.data());
+  glUniformMatrix4fv(glGetUniformLocation(program_id, "projection"), 1,
+                     GL_FALSE, projection.data());
+  glUniform3fv(glGetUniformLocation(program_id, "camera_position"), 1,
+               camera_position.data());
+  glUniform3fv(glGetUniformLocation(program_id, "center"), 1,
+               impostor.center.data());
+  glUniform1f(glGetUniformLocation(program_id, "radius"), impostor.radius);
+  glUniform1f(glGetUniformLocation(program_id, "frames_per_side"),
+              impostor.frames_per_side);
+  glUniform3fv(glGetUniformLocation(program_id, "light_direction"), 1,
+               light_direction_.data());
+  glUniform3fv(glGetUniformLocation(program_id, "light_color"), 1,
+               light_color_.data());
+  glUniform3fv(glGetUniformLocation(program_id, "ambient_color"), 1,
+               ambient_color_.data());
+  glActiveTexture(GL_TEXTURE0 + kColorTextureUnit);
+  glBindTexture(GL_TEXTURE_2D, impostor.color_texture_id);
+  glActiveTexture(GL_TEXTURE0 + kNormalDepthTextureUnit);
+  glBindTexture(GL_TEXTURE_2D, impostor.normal_depth_texture_id);
+  glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+  glBindVertexArray(vertex_array_object_id_);
+  glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, model_matrices.size());
+  glBindVertexArray(0);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glUseProgram(0);
+}
+
+}  // namespace wvu
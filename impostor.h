@@ -0,0 +1,189 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef IMPOSTOR_H_
+#define IMPOSTOR_H_
+
+#include <string>
+#include <vector>
+#include <Eigen/Core>
+#include <GL/glew.h>
+
+#include "shader_program.h"
+
+namespace wvu {
+class Model;
+
+// Maps a direction on the upper hemisphere (y >= 0) to the [-1, 1]^2 square
+// using the hemi-octahedral parameterization. Directions below the horizon
+// are clamped to it.
+// Params:
+//   direction  A unit direction.
+Eigen::Vector2f EncodeHemiOctahedral(const Eigen::Vector3f& direction);
+
+// Inverse of EncodeHemiOctahedral: maps a point of the [-1, 1]^2 square to a
+// unit direction on the upper hemisphere.
+// Params:
+//   coordinates  A point in [-1, 1]^2.
+Eigen::Vector3f DecodeHemiOctahedral(const Eigen::Vector2f& coordinates);
+
+// The baked views of a model. The atlases hold frames_per_side x
+// frames_per_side square frames, and the frame (i, j) is an orthographic view
+// of the bounding sphere of the model from the direction the cell center
+// decodes to (see DecodeHemiOctahedral).
+struct Impostor {
+  // RGBA8 atlas with the color of the model. The alpha is the coverage.
+  GLuint color_texture_id;
+  // RGBA8 atlas with the normal in model coordinates (rgb) and the depth
+  // across the bounding sphere (a, 0 at the front and 1 at the back).
+  GLuint normal_depth_texture_id;
+  // Number of frames along each side of the atlases.
+  int frames_per_side;
+  // Bounding sphere of the model in model coordinates.
+  Eigen::Vector3f center;
+  GLfloat radius;
+};
+
+// This class renders models into impostor atlases with an offscreen
+// framebuffer. The models are rendered in their own coordinate system, so the
+// impostors can be drawn with any model matrix. Usage example:
+//
+// wvu::ImpostorBaker baker;
+// wvu::Impostor impostor;
+// std::string error_info_log;
+// if (!baker.Initialize(&error_info_log) ||
+//     !baker.Bake(*model, texture_id, 8, 128, &impostor, &error_info_log)) {
+//   LOG(ERROR) << error_info_log;
+// }
+// ...
+// wvu::DeleteImpostor(&impostor);
+class ImpostorBaker {
+ public:
+  ImpostorBaker();
+  ~ImpostorBaker();
+
+  // Compiles the shader program used to bake the models. Returns true upon
+  // success and false otherwise.
+  // Params:
+  //   error_info_log  A pointer to a string that holds the error log.
+  bool Initialize(std::string* error_info_log);
+
+  // Bakes the impostor of a model whose vertices are already in the GPU.
+  // Returns true upon success and false otherwise.
+  // Params:
+  //   model  The model to bake.
+  //   texture_id  The texture of the model.
+  //   frames_per_side  The number of frames along each side of the atlas.
+  //   frame_resolution  The width and height of a frame in pixels.
+  //   impostor  The baked impostor. Its textures are owned by the caller.
+  //   error_info_log  A pointer to a string that holds the error log.
+  bool Bake(const Model& model,
+            const GLuint texture_id,
+            const int frames_per_side,
+            const int frame_resolution,
+            Impostor* impostor,
+            std::string* error_info_log);
+
+ private:
+  ShaderProgram bake_shader_program_;
+};
+
+// Releases the textures of an impostor.
+void DeleteImpostor(Impostor* impostor);
+
+// This class draws impostors as a single quad per instance. For every
+// instance, the vertex shader picks the frame of the atlas baked from the
+// direction closest to the camera and orients the quad like that frame. The
+// fragment shader reconstructs the depth of the baked surface, so impostors
+// intersect the rest of the scene correctly. Usage example:
+//
+// wvu::ImpostorRenderer impostor_renderer;
+// std::string error_info_log;
+// if (!impostor_renderer.Initialize(&error_info_log)) {
+//   LOG(ERROR) << error_info_log;
+// }
+// while (...) {  // Rendering loop.
+//   impostor_renderer.Draw(impostor, model_matrices, projection, view);
+// }
+class ImpostorRenderer {
+ public:
+  ImpostorRenderer();
+  ~ImpostorRenderer();
+
+  // Compiles the shader program and creates the instance buffer. Returns true
+  // upon success and false otherwise.
+  // Params:
+  //   error_info_log  A pointer to a string that holds the error log.
+  bool Initialize(std::string* error_info_log);
+
+  // Draws all the instances of an impostor with a single draw call.
+  // Params:
+  //   impostor  The impostor to draw.
+  //   model_matrices  The model matrix of every instance.
+  //   projection  The camera projection matrix.
+  //   view  The camera pose matrix (world -> camera transformation matrix).
+  void Draw(const Impostor& impostor,
+            const std::vector<Eigen::Matrix4f>& model_matrices,
+            const Eigen::Matrix4f& projection,
+            const Eigen::Matrix4f& view);
+
+  // Sets the directional light used to shade the baked normals. The
+  // direction is the one in which the light travels in world coordinates.
+  // By default the impostors are unlit, like the forward path.
+  void set_directional_light(const Eigen::Vector3f& direction,
+                             const Eigen::Vector3f& color,
+                             const Eigen::Vector3f& ambient_color) {
+    light_direction_ = direction.normalized();
+    light_color_ = color;
+    ambient_color_ = ambient_color;
+  }
+
+ private:
+  // Vertex array object with the quad corners and the per-instance model
+  // matrices.
+  GLuint vertex_array_object_id_;
+  GLuint quad_buffer_id_;
+  GLuint instance_buffer_id_;
+  // Scratch storage for the model matrices reused every draw.
+  std::vector<GLfloat> instance_data_;
+  // Lighting of the impostors.
+  Eigen::Vector3f light_direction_;
+  Eigen::Vector3f light_color_;
+  Eigen::Vector3f ambient_color_;
+  ShaderProgram shader_program_;
+};
+
+}  // namespace wvu
+
+#endif  // IMPOSTOR_H_
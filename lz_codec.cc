@@ -0,0 +1,200 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#include "lz_codec.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace wvu {
+namespace {
+// Shortest match worth encoding.
+constexpr int kMinMatchLength = 4;
+// Matches reach at most this far back (the offsets take 2 bytes).
+constexpr size_t kMaxOffset = 65535;
+constexpr int kHashBits = 14;
+
+uint32_t Read32(const uint8_t* data) {
+  uint32_t value;
+  std::memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+uint32_t Hash(const uint32_t value) {
+  // Fibonacci hashing of the next four bytes.
+  return (value * 2654435761u) >> (32 - kHashBits);
+}
+
+// Appends a length that did not fit in its nibble.
+void AppendExtraLength(size_t length, std::string* compressed) {
+  while (length >= 255) {
+    compressed->push_back(static_cast<char>(255));
+    length -= 255;
+  }
+  compressed->push_back(static_cast<char>(length));
+}
+
+void AppendSequence(const uint8_t* literals,
+                    const size_t num_literals,
+                    const size_t offset,
+                    const size_t match_length,
+                    std::string* compressed) {
+  const size_t extra_match_length =
+      match_length > 0 ? match_length - kMinMatchLength : 0;
+  const uint8_t token =
+      ((num_literals < 15 ? num_literals : 15) << 4) |
+      (extra_match_length < 15 ? extra_match_length : 15);
+  compressed->push_back(static_cast<char>(token));
+  if (num_literals >= 15) AppendExtraLength(num_literals - 15, compressed);
+  compressed->append(reinterpret_cast<const char*>(literals), num_literals);
+  // The last sequence has no match.
+  if (match_length == 0) return;
+  compressed->push_back(static_cast<char>(offset & 0xff));
+  compressed->push_back(static_cast<char>(offset >> 8));
+  if (extra_match_length >= 15) {
+    AppendExtraLength(extra_match_length - 15, compressed);
+  }
+}
+
+// Reads a length that did not fit in its nibble. Returns false past the end.
+bool ReadExtraLength(const uint8_t** input,
+                     const uint8_t* input_end,
+                     size_t* length) {
+  uint8_t byte;
+  do {
+    if (*input >= input_end) return false;
+    byte = *(*input)++;
+    *length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+}  // namespace
+
+size_t GetMaxLzCompressedSize(const size_t size) {
+  // Incompressible data is a single sequence of literals.
+  return size + size / 255 + 16;
+}
+
+void CompressLz(const char* data, const size_t size, std::string* compressed) {
+  if (compressed == nullptr) return;
+  compressed->clear();
+  compressed->reserve(GetMaxLzCompressedSize(size));
+  const uint8_t* input = reinterpret_cast<const uint8_t*>(data);
+  // Last position seen for every hash, or -1.
+  std::vector<int64_t> positions(1 << kHashBits, -1);
+  size_t anchor = 0;
+  size_t position = 0;
+  while (position + kMinMatchLength <= size) {
+    const uint32_t value = Read32(input + position);
+    const uint32_t hash = Hash(value);
+    const int64_t candidate = positions[hash];
+    positions[hash] = position;
+    if (candidate < 0 || position - candidate > kMaxOffset ||
+        Read32(input + candidate) != value) {
+      // Skip faster through data that does not compress.
+      position += 1 + ((position - anchor) >> 6);
+      continue;
+    }
+    size_t match_length = kMinMatchLength;
+    while (position + match_length < size &&
+           input[candidate + match_length] == input[position + match_length]) {
+      ++match_length;
+    }
+    AppendSequence(input + anchor, position - anchor, position - candidate,
+                   match_length, compressed);
+    position += match_length;
+    anchor = position;
+    // Seed the table within the match so that the next search finds it.
+    if (position >= 2 && position - 2 + kMinMatchLength <= size) {
+      positions[Hash(Read32(input + position - 2))] = position - 2;
+    }
+  }
+  AppendSequence(input + anchor, size - anchor, 0, 0, compressed);
+}
+
+bool DecompressLz(const char* data,
+                  const size_t size,
+                  char* decompressed,
+                  const size_t decompressed_size) {
+  const uint8_t* input = reinterpret_cast<const uint8_t*>(data);
+  const uint8_t* input_end = input + size;
+  uint8_t* output = reinterpret_cast<uint8_t*>(decompressed);
+  uint8_t* output_end = output + decompressed_size;
+  const uint8_t* output_begin = output;
+  while (input < input_end) {
+    const uint8_t token = *input++;
+    size_t num_literals = token >> 4;
+    if (num_literals == 15 &&
+        !ReadExtraLength(&input, input_end, &num_literals)) {
+      return false;
+    }
+    if (num_literals > static_cast<size_t>(input_end - input) ||
+        num_literals > static_cast<size_t>(output_end - output)) {
+      return false;
+    }
+    std::memcpy(output, input, num_literals);
+    input += num_literals;
+    output += num_literals;
+    // The last sequence ends after its literals.
+    if (input == input_end) break;
+
+    if (input_end - input < 2) return false;
+    const size_t offset = input[0] | (input[1] << 8);
+    input += 2;
+    size_t match_length = token & 0xf;
+    if (match_length == 15 &&
+        !ReadExtraLength(&input, input_end, &match_length)) {
+      return false;
+    }
+    match_length += kMinMatchLength;
+    if (offset == 0 || offset > static_cast<size_t>(output - output_begin) ||
+        match_length > static_cast<size_t>(output_end - output)) {
+      return false;
+    }
+    const uint8_t* match = output - offset;
+    if (offset >= match_length) {
+      std::memcpy(output, match, match_length);
+      output += match_length;
+    } else {
+      // Overlapping copies repeat the last offset bytes.
+      for (size_t i = 0; i < match_length; ++i) *output++ = *match++;
+    }
+  }
+  return output == output_end;
+}
+
+}  // namespace wvu
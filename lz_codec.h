@@ -0,0 +1,80 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef LZ_CODEC_H_
+#define LZ_CODEC_H_
+
+#include <cstddef>
+#include <string>
+
+namespace wvu {
+
+// A byte-oriented LZ77 codec in the spirit of LZ4: greedy matching with a
+// hash table on the compression side, and a decoder that is a tight loop of
+// literal and match copies. It trades ratio for decompression speed, which is
+// what loading assets needs.
+//
+// A compressed block is a sequence of (literals, match) pairs. Each pair
+// starts with a token byte: the high nibble is the number of literals and the
+// low nibble the match length minus 4; a nibble of 15 is followed by bytes
+// adding 255 until a byte smaller than 255. The literals follow, then the
+// match offset (2 bytes, little-endian) and the extra match length bytes. The
+// last pair has literals only.
+
+// Returns the largest compressed size of an input of the given size.
+size_t GetMaxLzCompressedSize(const size_t size);
+
+// Compresses a block of bytes.
+// Params:
+//   data  The bytes to compress.
+//   size  The number of bytes to compress.
+//   compressed  The compressed block.
+void CompressLz(const char* data, const size_t size, std::string* compressed);
+
+// Decompresses a block compressed with CompressLz. Returns true when the
+// block is valid and decompresses into exactly decompressed_size bytes, and
+// false otherwise. Corrupted blocks never read or write out of bounds.
+// Params:
+//   data  The compressed block.
+//   size  The number of bytes of the compressed block.
+//   decompressed  The buffer receiving the decompressed bytes.
+//   decompressed_size  The number of bytes of the decompressed block.
+bool DecompressLz(const char* data,
+                  const size_t size,
+                  char* decompressed,
+                  const size_t decompressed_size);
+
+}  // namespace wvu
+
+#endif  // LZ_CODEC_H_
@@ -0,0 +1,256 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#include "mesh_optimizer.h"
+
+#include <deque>
+#include <map>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+#include <Eigen/Core>
+#include <GL/glew.h>
+#include <glog/logging.h>
+
+#include "model_loader.h"
+
+namespace wvu {
+namespace {
+// Number of floats per vertex (see Model::SetVBO).
+constexpr int kNumFloatsPerVertex = 8;
+
+// Returns the next fanning vertex of Tipsify: the vertex of the candidates
+// that stays in the cache the longest after emitting its triangles, or a
+// vertex with triangles left when none of them does.
+int GetNextVertex(const std::vector<int>& candidates,
+                  const std::vector<int>& live_triangles,
+                  const std::vector<int>& cache_times,
+                  const int time_stamp,
+                  const int cache_size,
+                  std::vector<int>* dead_end_stack,
+                  int* cursor) {
+  int next_vertex = -1;
+  int best_priority = -1;
+  for (const int vertex : candidates) {
+    if (live_triangles[vertex] == 0) continue;
+    // Prefer the vertices that will still be in the cache, the oldest first.
+    int priority = 0;
+    if (time_stamp - cache_times[vertex] + 2 * live_triangles[vertex] <=
+        cache_size) {
+      priority = time_stamp - cache_times[vertex];
+    }
+    if (priority > best_priority) {
+      best_priority = priority;
+      next_vertex = vertex;
+    }
+  }
+  if (next_vertex >= 0) return next_vertex;
+  // Dead end: go back to a recently used vertex, or to the input order.
+  while (!dead_end_stack->empty()) {
+    const int vertex = dead_end_stack->back();
+    dead_end_stack->pop_back();
+    if (live_triangles[vertex] > 0) return vertex;
+  }
+  for (; *cursor < live_triangles.size(); ++*cursor) {
+    if (live_triangles[*cursor] > 0) return *cursor;
+  }
+  return -1;
+}
+
+}  // namespace
+
+void ConvertObjToMesh(const std::vector<Eigen::Vector3f>& obj_vertices,
+                      const std::vector<Eigen::Vector2f>& obj_texels,
+                      const std::vector<Eigen::Vector3f>& obj_normals,
+                      const std::vector<Face>& faces,
+                      Eigen::MatrixXf* vertices,
+                      std::vector<GLuint>* indices) {
+  // Index of every (vertex, texel, normal) triplet; -1 when absent.
+  std::map<std::tuple<int, int, int>, GLuint> vertex_ids;
+  std::vector<GLfloat> vertex_data;
+  indices->clear();
+  indices->reserve(3 * faces.size());
+  for (const Face& face : faces) {
+    for (int i = 0; i < 3; ++i) {
+      const int texel_index =
+          face.texel_indices.size() == 3 ? face.texel_indices[i] : -1;
+      const int normal_index =
+          face.normal_indices.size() == 3 ? face.normal_indices[i] : -1;
+      const std::tuple<int, int, int> key(face.vertex_indices[i], texel_index,
+                                          normal_index);
+      const auto inserted = vertex_ids.emplace(key, vertex_ids.size());
+      indices->push_back(inserted.first->second);
+      if (!inserted.second) continue;
+      const Eigen::Vector3f& position = obj_vertices[face.vertex_indices[i]];
+      const Eigen::Vector3f color = normal_index >= 0 ?
+          Eigen::Vector3f(0.5f * obj_normals[normal_index].array() + 0.5f) :
+          Eigen::Vector3f::Ones();
+      const Eigen::Vector2f texel = texel_index >= 0 ?
+          obj_texels[texel_index] : Eigen::Vector2f::Zero();
+      vertex_data.insert(vertex_data.end(),
+                         {position.x(), position.y(), position.z(),
+                          color.x(), color.y(), color.z(),
+                          texel.x(), texel.y()});
+    }
+  }
+  *vertices = Eigen::Map<const Eigen::MatrixXf>(
+      vertex_data.data(), kNumFloatsPerVertex,
+      vertex_data.size() / kNumFloatsPerVertex);
+}
+
+void WeldVertices(Eigen::MatrixXf* vertices, std::vector<GLuint>* indices) {
+  if (vertices == nullptr || indices == nullptr) return;
+  const int num_rows = vertices->rows();
+  const size_t num_bytes = num_rows * sizeof(float);
+  // The vertices are compared by their bytes.
+  std::unordered_map<std::string, GLuint> welded_ids;
+  std::vector<GLuint> remap(vertices->cols());
+  int num_welded_vertices = 0;
+  for (int i = 0; i < vertices->cols(); ++i) {
+    const std::string key(
+        reinterpret_cast<const char*>(vertices->col(i).data()), num_bytes);
+    const auto inserted = welded_ids.emplace(key, num_welded_vertices);
+    remap[i] = inserted.first->second;
+    if (!inserted.second) continue;
+    // Compact in place: the destination is never after the source.
+    vertices->col(num_welded_vertices) = vertices->col(i);
+    ++num_welded_vertices;
+  }
+  vertices->conservativeResize(num_rows, num_welded_vertices);
+  for (GLuint& index : *indices) {
+    index = remap[index];
+  }
+}
+
+void OptimizeVertexCache(const int num_vertices,
+                         const int cache_size,
+                         std::vector<GLuint>* indices) {
+  if (indices == nullptr) return;
+  CHECK_GT(cache_size, 0);
+  const int num_triangles = indices->size() / 3;
+  // Triangles adjacent to every vertex, in compressed row storage.
+  std::vector<int> live_triangles(num_vertices, 0);
+  for (const GLuint index : *indices) {
+    CHECK_LT(index, num_vertices);
+    ++live_triangles[index];
+  }
+  std::vector<int> offsets(num_vertices + 1, 0);
+  for (int i = 0; i < num_vertices; ++i) {
+    offsets[i + 1] = offsets[i] + live_triangles[i];
+  }
+  std::vector<int> adjacent_triangles(offsets.back());
+  std::vector<int> fill_offsets(offsets.begin(), offsets.end() - 1);
+  for (int i = 0; i < 3 * num_triangles; ++i) {
+    adjacent_triangles[fill_offsets[(*indices)[i]]++] = i / 3;
+  }
+
+  std::vector<GLuint> output_indices;
+  output_indices.reserve(3 * num_triangles);
+  std::vector<bool> emitted(num_triangles, false);
+  // Time stamp at which every vertex entered the cache. The time starts
+  // past the cache size so that no vertex is in the cache initially.
+  std::vector<int> cache_times(num_vertices, 0);
+  int time_stamp = cache_size + 1;
+  std::vector<int> dead_end_stack;
+  std::vector<int> candidates;
+  int cursor = 0;
+  int fanning_vertex = GetNextVertex(candidates, live_triangles, cache_times,
+                                     time_stamp, cache_size, &dead_end_stack,
+                                     &cursor);
+  while (fanning_vertex >= 0) {
+    candidates.clear();
+    for (int i = offsets[fanning_vertex]; i < offsets[fanning_vertex + 1];
+         ++i) {
+      const int triangle = adjacent_triangles[i];
+      if (emitted[triangle]) continue;
+      emitted[triangle] = true;
+      for (int j = 0; j < 3; ++j) {
+        const GLuint vertex = (*indices)[3 * triangle + j];
+        output_indices.push_back(vertex);
+        dead_end_stack.push_back(vertex);
+        candidates.push_back(vertex);
+        --live_triangles[vertex];
+        if (time_stamp - cache_times[vertex] > cache_size) {
+          cache_times[vertex] = time_stamp;
+          ++time_stamp;
+        }
+      }
+    }
+    fanning_vertex = GetNextVertex(candidates, live_triangles, cache_times,
+                                   time_stamp, cache_size, &dead_end_stack,
+                                   &cursor);
+  }
+  indices->swap(output_indices);
+}
+
+void OptimizeVertexFetch(Eigen::MatrixXf* vertices,
+                         std::vector<GLuint>* indices) {
+  if (vertices == nullptr || indices == nullptr) return;
+  const GLuint kUnused = static_cast<GLuint>(-1);
+  std::vector<GLuint> remap(vertices->cols(), kUnused);
+  Eigen::MatrixXf reordered_vertices(vertices->rows(), vertices->cols());
+  GLuint num_used_vertices = 0;
+  for (GLuint& index : *indices) {
+    if (remap[index] == kUnused) {
+      reordered_vertices.col(num_used_vertices) = vertices->col(index);
+      remap[index] = num_used_vertices++;
+    }
+    index = remap[index];
+  }
+  reordered_vertices.conservativeResize(vertices->rows(), num_used_vertices);
+  vertices->swap(reordered_vertices);
+}
+
+float ComputeAcmr(const std::vector<GLuint>& indices, const int cache_size) {
+  if (indices.size() < 3) return 0.0f;
+  std::deque<GLuint> cache;
+  int num_misses = 0;
+  for (const GLuint index : indices) {
+    bool hit = false;
+    for (const GLuint cached_index : cache) {
+      if (cached_index == index) {
+        hit = true;
+        break;
+      }
+    }
+    if (hit) continue;
+    ++num_misses;
+    cache.push_back(index);
+    if (cache.size() > cache_size) cache.pop_front();
+  }
+  return static_cast<float>(num_misses) / (indices.size() / 3);
+}
+
+}  // namespace wvu
@@ -0,0 +1,96 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef MESH_OPTIMIZER_H_
+#define MESH_OPTIMIZER_H_
+
+#include <vector>
+#include <Eigen/Core>
+#include <GL/glew.h>
+
+#include "model_loader.h"
+
+namespace wvu {
+
+// Converts a model loaded with LoadObjModel into vertices with the layout of
+// Model::SetVBO and triangle indices. Every distinct (vertex, texel, normal)
+// triplet of the faces becomes a vertex; its color is the normal mapped to
+// [0, 1], or white without normals.
+// Params:
+//   obj_vertices, obj_texels, obj_normals, faces  The output of
+//     LoadObjModel.
+//   vertices  The 8 x n vertex matrix.
+//   indices  Three indices per face.
+void ConvertObjToMesh(const std::vector<Eigen::Vector3f>& obj_vertices,
+                      const std::vector<Eigen::Vector2f>& obj_texels,
+                      const std::vector<Eigen::Vector3f>& obj_normals,
+                      const std::vector<Face>& faces,
+                      Eigen::MatrixXf* vertices,
+                      std::vector<GLuint>* indices);
+
+// Merges the vertices (columns) that are exactly equal and remaps the indices
+// accordingly. The first occurrence of a vertex keeps its relative order.
+// Params:
+//   vertices  The vertex matrix, one vertex per column.
+//   indices  The triangle indices.
+void WeldVertices(Eigen::MatrixXf* vertices, std::vector<GLuint>* indices);
+
+// Reorders the triangles to improve the hit rate of the post-transform vertex
+// cache, using the Tipsify algorithm (Sander et al., "Fast Triangle
+// Reordering for Vertex Locality and Reduced Overdraw", SIGGRAPH 2007). The
+// set of triangles and their winding are preserved.
+// Params:
+//   num_vertices  The number of vertices the indices refer to.
+//   cache_size  The number of vertices the targeted cache holds.
+//   indices  The triangle indices.
+void OptimizeVertexCache(const int num_vertices,
+                         const int cache_size,
+                         std::vector<GLuint>* indices);
+
+// Reorders the vertices in the order the indices first use them, so that the
+// vertex fetches walk the buffer linearly. Unreferenced vertices are removed.
+// Params:
+//   vertices  The vertex matrix, one vertex per column.
+//   indices  The triangle indices.
+void OptimizeVertexFetch(Eigen::MatrixXf* vertices,
+                         std::vector<GLuint>* indices);
+
+// Returns the average cache miss ratio (the number of vertex shader
+// invocations per triangle) of a FIFO post-transform cache of the given size.
+// It ranges from about 0.5 for an ideal order to 3.
+float ComputeAcmr(const std::vector<GLuint>& indices, const int cache_size);
+
+}  // namespace wvu
+
+#endif  // MESH_OPTIMIZER_H_
@@ -33,57 +33,112 @@
 // Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
 
 #include "model.h"
-#include <iostream>
+#include <algorithm>
 #include <Eigen/Core>
 #include <Eigen/Geometry>
 #include <GL/glew.h>
-#include <GLFW/glfw3.h>
 #include "shader_program.h"
+#include "simd_math.h"
 #include "transformations.h"
 
 namespace wvu {
+
+void Model::SetVertexAttributes() {
+  constexpr GLuint kIndex = 0;
+  constexpr GLuint kNumElementsPerVertex = 3;
+  constexpr GLuint kStride = 8 * sizeof(GLfloat);
+  const GLvoid* offset_ptr = nullptr;
+  glVertexAttribPointer(kIndex, kNumElementsPerVertex, GL_FLOAT, GL_FALSE, kStride, offset_ptr);
+  glEnableVertexAttribArray(kIndex);
+  const GLvoid* offset_color = reinterpret_cast<GLvoid*>(3 * sizeof(GLfloat));
+  glVertexAttribPointer(1, kNumElementsPerVertex, 
+                        GL_FLOAT, GL_FALSE,
+                        kStride, offset_color);
+  glEnableVertexAttribArray(1);
+  // Configure the texels.
+  const GLvoid* offset_texel = 
+    reinterpret_cast<GLvoid*>(6 * sizeof(GLfloat));
+  glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE,
+                        kStride, offset_texel);
+  glEnableVertexAttribArray(2);
+}
+
 Model::Model(const Eigen::Vector3f& orientation,
              const Eigen::Vector3f& position,
              const Eigen::MatrixXf& vertices) {
-  orientation_ = orientation;
+  rotation_ = ConvertRodriguesToQuaternion(orientation);
   position_ = position;
+  scale_ = Eigen::Vector3f::Ones();
   vertices_ = vertices;
   vertex_buffer_object_id_ = 0;
   vertex_array_object_id_ = 0;
   element_buffer_object_id_ = 0;
+  is_static_ = false;
+  opacity_ = 1.0f;
 }
 
 Model::Model(const Eigen::Vector3f& orientation,
              const Eigen::Vector3f& position,
              const Eigen::MatrixXf& vertices,
              const std::vector<GLuint>& indices) {
-  orientation_ = orientation;
+  rotation_ = ConvertRodriguesToQuaternion(orientation);
   position_ = position;
+  scale_ = Eigen::Vector3f::Ones();
   vertices_ = vertices;
   indices_ = indices;
   vertex_buffer_object_id_ = 0;
   vertex_array_object_id_ = 0;
   element_buffer_object_id_ = 0;
+  is_static_ = false;
+  opacity_ = 1.0f;
 }
 
 Model::~Model() {
+  // Models that never reached the GPU (e.g., in the benchmarks) may not have
+  // an OpenGL context to release the objects from.
+  if (vertex_array_object_id_ == 0) return;
   glDeleteVertexArrays(1, &vertex_array_object_id_);
   glDeleteBuffers(1, &vertex_buffer_object_id_);
   glDeleteBuffers(1, &element_buffer_object_id_);
 }
 
 // Builds the model matrix from the orientation and position members.
-Eigen::Matrix4f Model::ComputeModelMatrix() {
-  const float angle = orientation_.norm();
-  Eigen::Matrix4f rotation = ComputeRotationMatrix(orientation_.normalized(), angle);
-  Eigen::Matrix4f translation = ComputeTranslationMatrix(position_);
-  Eigen::Matrix4f model_matrix = translation * rotation;
+Eigen::Matrix4f Model::ComputeModelMatrix() const {
+  Eigen::Matrix4f model_matrix = ComputeRotationMatrix(rotation_);
+  model_matrix.topLeftCorner<3, 3>() *= scale_.asDiagonal();
+  model_matrix.block<3, 1>(0, 3) = position_;
   return model_matrix;
 }
 
+void Model::ComputeModelMatrices(const std::vector<Model*>& models,
+                                 std::vector<Eigen::Matrix4f>* model_matrices) {
+  const int num_models = models.size();
+  std::vector<Quat> rotations(num_models);
+  for (int i = 0; i < num_models; ++i) {
+    rotations[i] = ToQuat(models[i]->rotation_);
+  }
+  std::vector<Mat4> matrices(num_models);
+  QuatToMat4Batch(rotations.data(), num_models, matrices.data());
+  model_matrices->resize(num_models);
+  for (int i = 0; i < num_models; ++i) {
+    Eigen::Matrix4f& model_matrix = (*model_matrices)[i];
+    model_matrix = ToEigen(matrices[i]);
+    model_matrix.topLeftCorner<3, 3>() *= models[i]->scale_.asDiagonal();
+    model_matrix.block<3, 1>(0, 3) = models[i]->position_;
+  }
+}
+
 // Setters set members by *copying* input parameters.
 void Model::set_orientation(const Eigen::Vector3f& orientation) {
-  orientation_ = orientation;
+  rotation_ = ConvertRodriguesToQuaternion(orientation);
+}
+
+void Model::set_rotation(const Eigen::Quaternionf& rotation) {
+  rotation_ = rotation.normalized();
+}
+
+void Model::Rotate(const Eigen::Quaternionf& rotation) {
+  rotation_ = (rotation * rotation_).normalized();
 }
 
 // Setters set members by *copying* input parameters.
@@ -91,22 +146,50 @@ void Model::set_position(const Eigen::Vector3f& position) {
   position_ = position;
 }
 
-Eigen::Vector3f* Model::mutable_orientation() {
-  return &orientation_;
+void Model::set_scale(const Eigen::Vector3f& scale) {
+  scale_ = scale;
+}
+
+void Model::set_is_static(const bool is_static) {
+  is_static_ = is_static;
+}
+
+bool Model::is_static() const {
+  return is_static_;
+}
+
+void Model::set_opacity(const GLfloat opacity) {
+  opacity_ = std::min(std::max(opacity, 0.0f), 1.0f);
+}
+
+GLfloat Model::opacity() const {
+  return opacity_;
+}
+
+bool Model::is_transparent() const {
+  return opacity_ < 1.0f;
 }
 
 Eigen::Vector3f* Model::mutable_position() {
   return &position_;
 }
 
-const Eigen::Vector3f& Model::orientation() {
-  return orientation_;
+Eigen::Vector3f Model::orientation() const {
+  return ConvertQuaternionToRodrigues(rotation_);
+}
+
+const Eigen::Quaternionf& Model::rotation() const {
+  return rotation_;
 }
 
-const Eigen::Vector3f& Model::position() {
+const Eigen::Vector3f& Model::position() const {
   return position_;
 }
 
+const Eigen::Vector3f& Model::scale() const {
+  return scale_;
+}
+
 const Eigen::MatrixXf& Model::vertices() const {
   return vertices_;
 }
@@ -146,23 +229,7 @@ GLuint Model::SetVBO(){
   const Eigen::MatrixXf& vertices = vertices_;
   const int vertices_size_in_bytes = vertices.rows() * vertices.cols() * sizeof(vertices(0, 0));
   glBufferData(GL_ARRAY_BUFFER, vertices_size_in_bytes, vertices.data(), GL_STATIC_DRAW);
-  constexpr GLuint kIndex = 0;
-  constexpr GLuint kNumElementsPerVertex = 3;
-  constexpr GLuint kStride = 8 * sizeof(vertices(0, 0));
-  const GLvoid* offset_ptr = nullptr;
-  glVertexAttribPointer(kIndex, kNumElementsPerVertex, GL_FLOAT, GL_FALSE, kStride, offset_ptr);
-  glEnableVertexAttribArray(kIndex);
-  const GLvoid* offset_color = reinterpret_cast<GLvoid*>(3 * sizeof(vertices(0, 0)));
-  glVertexAttribPointer(1, kNumElementsPerVertex, 
-                        GL_FLOAT, GL_FALSE,
-                        kStride, offset_color);
-  glEnableVertexAttribArray(1);
-  // Configure the texels.
-  const GLvoid* offset_texel = 
-    reinterpret_cast<GLvoid*>(6 * sizeof(vertices(0, 0)));
-  glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE,
-                        kStride, offset_texel);
-  glEnableVertexAttribArray(2);
+  SetVertexAttributes();
   glBindBuffer(GL_ARRAY_BUFFER, 0);
   return vbo_id;
 }
@@ -186,6 +253,22 @@ void Model::SetVerticesIntoGpu() {
   glBindVertexArray(0);
 }
 
+void Model::SetUploadedBuffers(const GLuint vertex_buffer_object_id,
+                               const GLuint element_buffer_object_id) {
+  glDeleteVertexArrays(1, &vertex_array_object_id_);
+  glDeleteBuffers(1, &vertex_buffer_object_id_);
+  glDeleteBuffers(1, &element_buffer_object_id_);
+  vertex_buffer_object_id_ = vertex_buffer_object_id;
+  element_buffer_object_id_ = element_buffer_object_id;
+  glGenVertexArrays(1, &vertex_array_object_id_);
+  glBindVertexArray(vertex_array_object_id_);
+  glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_object_id_);
+  SetVertexAttributes();
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, element_buffer_object_id_);
+  glBindVertexArray(0);
+}
+
 void Model::Draw(const ShaderProgram& shader_program,
                  const Eigen::Matrix4f& projection,
                  const Eigen::Matrix4f& view, const GLuint texture_id) {
@@ -198,21 +281,15 @@ void Model::Draw(const ShaderProgram& shader_program,
     glGetUniformLocation(shader_program.shader_program_id(), "projection");
 
   // The model transformation must be computed using ComputeModelMatrix().
-  const GLfloat rotation_speed = 50.0f;
-  GLfloat angle = ConvertDegreesToRadians(rotation_speed * static_cast<GLfloat>(glfwGetTime()));
-  const Eigen::Vector3f orientation = Eigen::Vector3f(1.0f, angle, 1.0f);
-  set_orientation(orientation);
+  // Animations update the pose before the draw calls (see animation.h).
   const Eigen::Matrix4f model = ComputeModelMatrix();
 
-  std::cout << "Model: \n" << model << std::endl;
-  
   glBindTexture(GL_TEXTURE_2D, texture_id);
   
   glUniformMatrix4fv(model_location, 1, GL_FALSE, model.data());
   glUniformMatrix4fv(view_location, 1, GL_FALSE, view.data());
   glUniformMatrix4fv(projection_location, 1, GL_FALSE, projection.data());
   
-  GLfloat color_scalar = static_cast<GLfloat>(glfwGetTime());
   glBindVertexArray(vertex_array_object_id_);
   glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
   //glDrawArrays(GL_TRIANGLE_STRIP, 0, 5);
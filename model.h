@@ -39,14 +39,23 @@
 
 #include <vector>
 #include <Eigen/Core>
+#include <Eigen/Geometry>
 #include <GL/glew.h>
 
 #include "shader_program.h"
 
 namespace wvu {
 // Class that holds the necessary information of a 3D model in OpenGL.
+//
+// The orientation is stored as a unit quaternion: composing and interpolating
+// rotations (e.g., for animations) does not go through the Rodrigues vector,
+// which is only converted once when it is set.
 class Model {
 public:
+  // The quaternion is a fixed-size vectorizable Eigen member, and the models
+  // are allocated with new.
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
   // Constructor.
   // Params
   //  orientation  Axis of rotation whose norm is the angle
@@ -74,8 +83,17 @@ public:
   // created in the heap by using new operator.
   ~Model();
 
-  // Builds the model matrix from the orientation and position members.
-  Eigen::Matrix4f ComputeModelMatrix();
+  // Builds the model matrix from the position, orientation and scale
+  // members: translation * rotation * scaling.
+  Eigen::Matrix4f ComputeModelMatrix() const;
+
+  // Builds the model matrices of many models at once with the batched
+  // kernels of simd_math.h. The result matches ComputeModelMatrix.
+  // Params:
+  //   models  The models.
+  //   model_matrices  The model matrices, in the order of the models.
+  static void ComputeModelMatrices(const std::vector<Model*>& models,
+                                   std::vector<Eigen::Matrix4f>* model_matrices);
 
   GLuint SetVBO();
   GLuint SetEBO();
@@ -83,6 +101,19 @@ public:
   // Sets the VAO, VBO and EBO.
   void SetVerticesIntoGpu();
 
+  // Configures the position, color, and texel attributes of the bound VAO to
+  // read the vertex layout of SetVBO from the bound GL_ARRAY_BUFFER.
+  static void SetVertexAttributes();
+
+  // Takes ownership of a VBO and an EBO holding the vertices and the indices
+  // of the model, e.g., uploaded by an UploadThread, and builds the VAO.
+  // Replaces the buffers set previously.
+  // Params:
+  //   vertex_buffer_object_id  The buffer with the vertices.
+  //   element_buffer_object_id  The buffer with the indices.
+  void SetUploadedBuffers(const GLuint vertex_buffer_object_id,
+                          const GLuint element_buffer_object_id);
+
   // Draws the model. Executes OpenGL calls to render the set VAO.
   // Params:
   //   shader_program  The shader program that is currently in use.
@@ -94,28 +125,60 @@ public:
 
   // Sets the orientation or pose of the object using the Rodrigues
   // vector: angle-axis vector where the angle is the norm of the vector.
+  // The vector is converted to a quaternion.
   void set_orientation(const Eigen::Vector3f& orientation);
 
+  // Sets the orientation of the object. The quaternion is normalized.
+  void set_rotation(const Eigen::Quaternionf& rotation);
+
+  // Applies a rotation on top of the current orientation, i.e., the new
+  // orientation is rotation * orientation.
+  void Rotate(const Eigen::Quaternionf& rotation);
+
   // Sets the position of the model.
   void set_position(const Eigen::Vector3f& position);
 
+  // Sets the scale of the model along each of its axes.
+  void set_scale(const Eigen::Vector3f& scale);
+
+  // Marks the model as static: its transformation and geometry do not change
+  // after construction. Static models can be cached (e.g., shadow maps).
+  void set_is_static(const bool is_static);
+
+  // Returns true if the model is static.
+  bool is_static() const;
+
+  // Sets the opacity of the model in [0, 1]. Models with an opacity below one
+  // are drawn in the transparency pass (see transparency_pass.h).
+  void set_opacity(const GLfloat opacity);
+
+  // Returns the opacity of the model.
+  GLfloat opacity() const;
+
+  // Returns true if the model has to be drawn in the transparency pass.
+  bool is_transparent() const;
+
   // If we want to avoid copying, we can return a pointer to
   // the member. Note that making public the attributes work
   // if we want to modify directly the members. However, this
   // is a matter of design.
 
-  // Returns a mutable orientation vector.
-  Eigen::Vector3f* mutable_orientation();
-
   // Returns a mutable position.
   Eigen::Vector3f* mutable_position();
 
   // Getters, return a const reference to the member.
-  // Gets the orientation or pose of the object in the world.
-  const Eigen::Vector3f& orientation();
+  // Gets the orientation or pose of the object in the world as a Rodrigues
+  // vector. It is converted from the quaternion on every call.
+  Eigen::Vector3f orientation() const;
+
+  // Gets the orientation of the object in the world.
+  const Eigen::Quaternionf& rotation() const;
 
   // Gets the position of the object in the world.
-  const Eigen::Vector3f& position();
+  const Eigen::Vector3f& position() const;
+
+  // Gets the scale of the object along each of its axes.
+  const Eigen::Vector3f& scale() const;
 
   // Returns a const reference of the vertices.
   const Eigen::MatrixXf& vertices() const;
@@ -139,10 +202,12 @@ private:
   // Attributes.
   // The convention we will use is to define a '_' after the name
   // of the attribute.
-  // Orientation or pose of the object in the world.
-  Eigen::Vector3f orientation_;
+  // Orientation or pose of the object in the world (unit quaternion).
+  Eigen::Quaternionf rotation_;
   // Position of the object in the world.
   Eigen::Vector3f position_;
+  // Scale of the object along each of its axes.
+  Eigen::Vector3f scale_;
   // Vertex matrix.
   Eigen::MatrixXf vertices_;
   // Indices for EBO.
@@ -153,6 +218,10 @@ private:
   GLuint vertex_array_object_id_;
   // Element buffer object id.
   GLuint element_buffer_object_id_;
+  // True when the model does not change after construction.
+  bool is_static_;
+  // Opacity of the model.
+  GLfloat opacity_;
 };
 
 }  // namespace wvu
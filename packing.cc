@@ -0,0 +1,125 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#include "packing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <Eigen/Core>
+
+namespace wvu {
+
+uint16_t ConvertToHalf(const float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  const uint16_t sign = (bits >> 16) & 0x8000;
+  const int exponent = static_cast<int>((bits >> 23) & 0xff) - 127 + 15;
+  uint32_t mantissa = bits & 0x7fffff;
+  // NaN and infinity.
+  if ((bits & 0x7fffffff) > 0x7f800000) return sign | 0x7e00;
+  if (exponent >= 31) return sign | 0x7c00;
+  // Subnormal half floats, or zero when the value is too small.
+  if (exponent <= 0) {
+    if (exponent < -10) return sign;
+    mantissa |= 0x800000;
+    const int shift = 14 - exponent;
+    uint16_t half = mantissa >> shift;
+    if ((mantissa >> (shift - 1)) & 1) ++half;
+    return sign | half;
+  }
+  uint16_t half = sign | (exponent << 10) | (mantissa >> 13);
+  // A carry out of the mantissa correctly increments the exponent.
+  if (mantissa & 0x1000) ++half;
+  return half;
+}
+
+float ConvertFromHalf(const uint16_t half) {
+  const uint32_t sign = static_cast<uint32_t>(half & 0x8000) << 16;
+  const int exponent = (half >> 10) & 0x1f;
+  uint32_t mantissa = half & 0x3ff;
+  uint32_t bits;
+  if (exponent == 31) {
+    // NaN and infinity.
+    bits = sign | 0x7f800000 | (mantissa << 13);
+  } else if (exponent == 0) {
+    // Zero and subnormal half floats, which are normal floats.
+    if (mantissa == 0) {
+      bits = sign;
+    } else {
+      int shift = 0;
+      while ((mantissa & 0x400) == 0) {
+        mantissa <<= 1;
+        ++shift;
+      }
+      bits = sign | ((127 - 15 + 1 - shift) << 23) |
+          ((mantissa & 0x3ff) << 13);
+    }
+  } else {
+    bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+  }
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+uint32_t PackHalf2x16(const float first, const float second) {
+  return static_cast<uint32_t>(ConvertToHalf(first)) |
+      (static_cast<uint32_t>(ConvertToHalf(second)) << 16);
+}
+
+Eigen::Vector2f UnpackHalf2x16(const uint32_t word) {
+  return Eigen::Vector2f(ConvertFromHalf(word & 0xffff),
+                         ConvertFromHalf(word >> 16));
+}
+
+uint32_t PackUnorm4x8(const Eigen::Vector4f& values) {
+  uint32_t word = 0;
+  for (int i = 0; i < 4; ++i) {
+    const float value = std::min(std::max(values[i], 0.0f), 1.0f);
+    word |= static_cast<uint32_t>(std::round(255.0f * value)) << (8 * i);
+  }
+  return word;
+}
+
+Eigen::Vector4f UnpackUnorm4x8(const uint32_t word) {
+  Eigen::Vector4f values;
+  for (int i = 0; i < 4; ++i) {
+    values[i] = static_cast<float>((word >> (8 * i)) & 0xff) / 255.0f;
+  }
+  return values;
+}
+
+}  // namespace wvu
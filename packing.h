@@ -0,0 +1,66 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef PACKING_H_
+#define PACKING_H_
+
+#include <cstdint>
+#include <Eigen/Core>
+
+namespace wvu {
+
+// Converts a float into the bits of a half float, rounding to the nearest.
+// Values too large for a half float become infinity.
+uint16_t ConvertToHalf(const float value);
+
+// Converts the bits of a half float into a float.
+float ConvertFromHalf(const uint16_t half);
+
+// Packs two floats into a word as half floats, the first one in the low 16
+// bits. Matches packHalf2x16 in GLSL.
+uint32_t PackHalf2x16(const float first, const float second);
+
+// Unpacks a word packed with PackHalf2x16. Matches unpackHalf2x16 in GLSL.
+Eigen::Vector2f UnpackHalf2x16(const uint32_t word);
+
+// Packs four floats in [0, 1] into a word as 8-bit unorms, the first one in
+// the low 8 bits. Matches packUnorm4x8 in GLSL.
+uint32_t PackUnorm4x8(const Eigen::Vector4f& values);
+
+// Unpacks a word packed with PackUnorm4x8. Matches unpackUnorm4x8 in GLSL.
+Eigen::Vector4f UnpackUnorm4x8(const uint32_t word);
+
+}  // namespace wvu
+
+#endif  // PACKING_H_
@@ -0,0 +1,374 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#include "pak_archive.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <glog/logging.h>
+
+#include "cooked_assets.h"
+#include "lz_codec.h"
+#include "mapped_file.h"
+#include "thread_pool.h"
+
+namespace wvu {
+
+// A record of the index of an archive.
+struct PakIndexEntry {
+  uint64_t name_hash;
+  // Offset and size of the stored bytes from the start of the archive.
+  uint64_t offset;
+  uint64_t stored_size;
+  // Size of the entry once decompressed.
+  uint64_t size;
+  uint32_t name_offset;
+  uint32_t name_length;
+  // Number of compressed blocks, or zero for uncompressed entries.
+  uint32_t num_blocks;
+  uint32_t padding;
+};
+static_assert(sizeof(PakIndexEntry) == 48, "Unexpected padding.");
+
+namespace {
+constexpr uint32_t kPakVersion = 1;
+// The block sizes of a compressed entry have this bit set when the block is
+// stored uncompressed.
+constexpr uint32_t kStoredBlockBit = 0x80000000u;
+
+struct PakHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t num_entries;
+  uint32_t alignment;
+  uint64_t index_offset;
+  uint64_t names_offset;
+};
+static_assert(sizeof(PakHeader) == 32, "Unexpected padding.");
+
+bool CompareHashes(const PakIndexEntry& entry, const uint64_t hash) {
+  return entry.name_hash < hash;
+}
+
+// Decompresses the blocks [first_block, last_block) of an entry.
+bool DecompressBlocks(const char* stored_bytes,
+                      const PakIndexEntry& entry,
+                      const std::vector<uint32_t>& block_sizes,
+                      const std::vector<size_t>& block_offsets,
+                      const int first_block,
+                      const int last_block,
+                      char* decompressed) {
+  for (int i = first_block; i < last_block; ++i) {
+    const char* block = stored_bytes + block_offsets[i];
+    const size_t stored_size = block_sizes[i] & ~kStoredBlockBit;
+    const size_t size =
+        std::min<uint64_t>(kPakBlockSize, entry.size - i * kPakBlockSize);
+    char* output = decompressed + i * kPakBlockSize;
+    if (block_sizes[i] & kStoredBlockBit) {
+      if (stored_size != size) return false;
+      std::memcpy(output, block, size);
+    } else if (!DecompressLz(block, stored_size, output, size)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void SetError(const std::string& error, std::string* error_info_log) {
+  if (error_info_log != nullptr) *error_info_log = error;
+}
+
+}  // namespace
+
+PakWriter::PakWriter(const int alignment) : alignment_(alignment) {
+  CHECK_GT(alignment, 0);
+  CHECK_EQ(alignment & (alignment - 1), 0) << "Not a power of two.";
+}
+
+void PakWriter::AddEntry(const std::string& name,
+                         const std::string& contents,
+                         const bool compress) {
+  PendingEntry entry;
+  entry.name = name;
+  entry.size = contents.size();
+  entry.num_blocks = 0;
+  if (compress && !contents.empty()) {
+    const uint32_t num_blocks =
+        (contents.size() + kPakBlockSize - 1) / kPakBlockSize;
+    std::vector<uint32_t> block_sizes(num_blocks);
+    std::string blocks;
+    std::string compressed_block;
+    for (uint32_t i = 0; i < num_blocks; ++i) {
+      const size_t offset = i * kPakBlockSize;
+      const size_t size = std::min(kPakBlockSize, contents.size() - offset);
+      CompressLz(contents.data() + offset, size, &compressed_block);
+      if (compressed_block.size() < size) {
+        block_sizes[i] = compressed_block.size();
+        blocks += compressed_block;
+      } else {
+        block_sizes[i] = size | kStoredBlockBit;
+        blocks.append(contents, offset, size);
+      }
+    }
+    const size_t table_size = num_blocks * sizeof(uint32_t);
+    if (table_size + blocks.size() < contents.size()) {
+      entry.num_blocks = num_blocks;
+      entry.stored_bytes.assign(
+          reinterpret_cast<const char*>(block_sizes.data()), table_size);
+      entry.stored_bytes += blocks;
+    }
+  }
+  if (entry.num_blocks == 0) entry.stored_bytes = contents;
+  entries_.push_back(std::move(entry));
+}
+
+bool PakWriter::AddFile(const std::string& name,
+                        const std::string& filepath,
+                        const bool compress,
+                        std::string* error_info_log) {
+  std::string contents;
+  if (!ReadFileContents(filepath, &contents)) {
+    SetError("Could not read " + filepath, error_info_log);
+    return false;
+  }
+  AddEntry(name, contents, compress);
+  return true;
+}
+
+bool PakWriter::Write(const std::string& filepath,
+                      std::string* error_info_log) const {
+  std::vector<PakIndexEntry> index;
+  index.reserve(entries_.size());
+  std::string names;
+  std::string bytes(sizeof(PakHeader), '\0');
+  for (const PendingEntry& pending_entry : entries_) {
+    bytes.resize((bytes.size() + alignment_ - 1) & ~(alignment_ - 1), '\0');
+    PakIndexEntry entry;
+    entry.name_hash = HashBytes(pending_entry.name);
+    entry.offset = bytes.size();
+    entry.stored_size = pending_entry.stored_bytes.size();
+    entry.size = pending_entry.size;
+    entry.name_offset = names.size();
+    entry.name_length = pending_entry.name.size();
+    entry.num_blocks = pending_entry.num_blocks;
+    entry.padding = 0;
+    index.push_back(entry);
+    bytes += pending_entry.stored_bytes;
+    names += pending_entry.name;
+  }
+  std::stable_sort(index.begin(), index.end(),
+                   [](const PakIndexEntry& a, const PakIndexEntry& b) {
+                     return a.name_hash < b.name_hash;
+                   });
+  // The index is read in place, so it is aligned for its 64-bit fields.
+  bytes.resize((bytes.size() + 7) & ~7, '\0');
+  PakHeader header;
+  std::memcpy(header.magic, "WVUP", 4);
+  header.version = kPakVersion;
+  header.num_entries = index.size();
+  header.alignment = alignment_;
+  header.index_offset = bytes.size();
+  header.names_offset = header.index_offset +
+      index.size() * sizeof(PakIndexEntry);
+  bytes.append(reinterpret_cast<const char*>(index.data()),
+               index.size() * sizeof(PakIndexEntry));
+  bytes += names;
+  std::memcpy(&bytes[0], &header, sizeof(header));
+  if (!WriteFileContents(filepath, bytes)) {
+    SetError("Could not write " + filepath, error_info_log);
+    return false;
+  }
+  return true;
+}
+
+PakReader::PakReader() :
+    entries_(nullptr), names_(nullptr), num_entries_(0) {}
+
+PakReader::~PakReader() {
+  Close();
+}
+
+bool PakReader::Open(const std::string& filepath,
+                     std::string* error_info_log) {
+  Close();
+  if (!file_.Open(filepath, error_info_log)) return false;
+  if (file_.size() < sizeof(PakHeader)) {
+    Close();
+    SetError("Not a pak archive: " + filepath, error_info_log);
+    return false;
+  }
+  const char* data = file_.data();
+  PakHeader header;
+  std::memcpy(&header, data, sizeof(header));
+  const uint64_t index_size = static_cast<uint64_t>(header.num_entries) *
+      sizeof(PakIndexEntry);
+  if (std::memcmp(header.magic, "WVUP", 4) != 0 ||
+      header.version != kPakVersion || header.index_offset % 8 != 0 ||
+      header.index_offset > file_.size() ||
+      index_size > file_.size() - header.index_offset ||
+      header.names_offset != header.index_offset + index_size) {
+    Close();
+    SetError("Not a supported pak archive: " + filepath, error_info_log);
+    return false;
+  }
+  entries_ = reinterpret_cast<const PakIndexEntry*>(data + header.index_offset);
+  names_ = data + header.names_offset;
+  num_entries_ = header.num_entries;
+  // Validate the index once, so that the lookups can trust it.
+  const uint64_t names_size = file_.size() - header.names_offset;
+  for (int i = 0; i < num_entries_; ++i) {
+    const PakIndexEntry& entry = entries_[i];
+    const bool valid = entry.offset <= header.index_offset &&
+        entry.stored_size <= header.index_offset - entry.offset &&
+        entry.name_offset <= names_size &&
+        entry.name_length <= names_size - entry.name_offset &&
+        (i == 0 || entries_[i - 1].name_hash <= entry.name_hash) &&
+        (entry.num_blocks > 0 ? entry.num_blocks ==
+         (entry.size + kPakBlockSize - 1) / kPakBlockSize &&
+         entry.num_blocks * sizeof(uint32_t) <= entry.stored_size :
+         entry.stored_size == entry.size);
+    if (!valid) {
+      Close();
+      SetError("Corrupted pak index: " + filepath, error_info_log);
+      return false;
+    }
+  }
+  return true;
+}
+
+void PakReader::Close() {
+  file_.Close();
+  entries_ = nullptr;
+  names_ = nullptr;
+  num_entries_ = 0;
+}
+
+const PakIndexEntry* PakReader::Find(const std::string& name) const {
+  const uint64_t hash = HashBytes(name);
+  const PakIndexEntry* end = entries_ + num_entries_;
+  // Entries with colliding hashes are next to each other.
+  for (const PakIndexEntry* entry =
+           std::lower_bound(entries_, end, hash, CompareHashes);
+       entry != end && entry->name_hash == hash; ++entry) {
+    if (name.size() == entry->name_length &&
+        name.compare(0, name.size(), names_ + entry->name_offset,
+                     entry->name_length) == 0) {
+      return entry;
+    }
+  }
+  return nullptr;
+}
+
+bool PakReader::Contains(const std::string& name) const {
+  return Find(name) != nullptr;
+}
+
+bool PakReader::GetSpan(const std::string& name, ByteSpan* span) const {
+  if (span == nullptr) return false;
+  const PakIndexEntry* entry = Find(name);
+  if (entry == nullptr || entry->num_blocks > 0) return false;
+  span->data = file_.data() + entry->offset;
+  span->size = entry->size;
+  return true;
+}
+
+bool PakReader::Read(const std::string& name,
+                     ThreadPool* thread_pool,
+                     std::string* contents) const {
+  if (contents == nullptr) return false;
+  const PakIndexEntry* entry = Find(name);
+  if (entry == nullptr) return false;
+  const char* stored_bytes = file_.data() + entry->offset;
+  if (entry->num_blocks == 0) {
+    contents->assign(stored_bytes, entry->size);
+    return true;
+  }
+  // Offsets of the blocks, after the table of their sizes. The table is
+  // copied since the entries may not be aligned for it.
+  std::vector<uint32_t> block_sizes(entry->num_blocks);
+  std::memcpy(block_sizes.data(), stored_bytes,
+              entry->num_blocks * sizeof(uint32_t));
+  std::vector<size_t> block_offsets(entry->num_blocks);
+  size_t offset = entry->num_blocks * sizeof(uint32_t);
+  for (int i = 0; i < entry->num_blocks; ++i) {
+    block_offsets[i] = offset;
+    offset += block_sizes[i] & ~kStoredBlockBit;
+  }
+  if (offset > entry->stored_size) return false;
+  contents->resize(entry->size);
+  char* decompressed = &(*contents)[0];
+  if (thread_pool == nullptr || entry->num_blocks == 1) {
+    return DecompressBlocks(stored_bytes, *entry, block_sizes, block_offsets,
+                            0, entry->num_blocks, decompressed);
+  }
+  // One task per worker, each one with a contiguous range of blocks.
+  const int num_tasks = std::min<int>(thread_pool->num_threads(),
+                                      entry->num_blocks);
+  std::mutex mutex;
+  std::condition_variable tasks_done;
+  int num_pending_tasks = num_tasks;
+  bool success = true;
+  for (int i = 0; i < num_tasks; ++i) {
+    const int first_block = i * entry->num_blocks / num_tasks;
+    const int last_block = (i + 1) * entry->num_blocks / num_tasks;
+    thread_pool->Schedule([&, first_block, last_block] {
+      const bool decompressed_blocks = DecompressBlocks(
+          stored_bytes, *entry, block_sizes, block_offsets, first_block,
+          last_block, decompressed);
+      std::lock_guard<std::mutex> lock(mutex);
+      success &= decompressed_blocks;
+      if (--num_pending_tasks == 0) tasks_done.notify_one();
+    });
+  }
+  std::unique_lock<std::mutex> lock(mutex);
+  tasks_done.wait(lock, [&] { return num_pending_tasks == 0; });
+  return success;
+}
+
+std::vector<std::string> PakReader::GetEntryNames() const {
+  std::vector<std::string> names;
+  names.reserve(num_entries_);
+  for (int i = 0; i < num_entries_; ++i) {
+    names.emplace_back(names_ + entries_[i].name_offset,
+                       entries_[i].name_length);
+  }
+  return names;
+}
+
+}  // namespace wvu
@@ -0,0 +1,185 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef PAK_ARCHIVE_H_
+#define PAK_ARCHIVE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "mapped_file.h"
+
+namespace wvu {
+class ThreadPool;
+struct PakIndexEntry;
+
+// A view of bytes owned by someone else.
+struct ByteSpan {
+  const char* data;
+  size_t size;
+};
+
+// Layout of a pak archive ("WVUP"), a single file bundling many assets:
+//   - A header with the magic, the version, the number of entries, the
+//     alignment of the entries, and the offsets of the index and the names.
+//   - The data of the entries, each one starting at a multiple of the
+//     alignment so that it can be used in place from the mapped file.
+//   - The index: one fixed-size record per entry, sorted by the hash of the
+//     name so that lookups are a binary search.
+//   - The names of the entries, concatenated.
+// A compressed entry is split into blocks of kPakBlockSize bytes compressed
+// independently with CompressLz, so that they can be decompressed in
+// parallel. Its data starts with the compressed size of every block.
+
+// Number of uncompressed bytes per compressed block.
+constexpr size_t kPakBlockSize = 64 * 1024;
+
+// Builds a pak archive. Usage example:
+//
+// wvu::PakWriter writer(64);
+// writer.AddEntry("shader.vert", vertex_shader_src, false);
+// if (!writer.AddFile("brick.wvutex", "cooked/brick.wvutex", true, &error)) {
+//   ...
+// }
+// if (!writer.Write("assets.pak", &error)) {
+//   ...
+// }
+class PakWriter {
+ public:
+  // Params:
+  //   alignment  The alignment of the entries in bytes, a power of two.
+  explicit PakWriter(const int alignment);
+
+  // Adds an entry. Compressed entries are stored uncompressed when the
+  // compression does not pay off.
+  // Params:
+  //   name  The name of the entry, e.g., its relative path.
+  //   contents  The bytes of the entry.
+  //   compress  Whether to compress the entry.
+  void AddEntry(const std::string& name,
+                const std::string& contents,
+                const bool compress);
+
+  // Adds an entry with the contents of a file. Returns true upon success and
+  // false otherwise.
+  bool AddFile(const std::string& name,
+               const std::string& filepath,
+               const bool compress,
+               std::string* error_info_log);
+
+  // Writes the archive. Returns true upon success and false otherwise.
+  bool Write(const std::string& filepath, std::string* error_info_log) const;
+
+ private:
+  struct PendingEntry {
+    std::string name;
+    // The bytes as stored in the archive.
+    std::string stored_bytes;
+    uint64_t size;
+    uint32_t num_blocks;
+  };
+
+  int alignment_;
+  std::vector<PendingEntry> entries_;
+};
+
+// Reads a pak archive mapped in memory. The uncompressed entries are handed
+// out in place, without copies; the compressed ones are decompressed into
+// the caller's buffer, optionally splitting the blocks over a thread pool.
+// The reader is immutable once opened, so it can be shared by the loading
+// threads. Usage example:
+//
+// wvu::PakReader archive;
+// if (!archive.Open("assets.pak", &error)) {
+//   ...
+// }
+// wvu::ByteSpan span;
+// std::string contents;
+// if (archive.GetSpan("brick.wvutex", &span)) {
+//   ...  // Use span.data directly.
+// } else if (archive.Read("brick.wvutex", nullptr, &contents)) {
+//   ...
+// }
+class PakReader {
+ public:
+  PakReader();
+  ~PakReader();
+
+  // Maps an archive and validates its index. Returns true upon success and
+  // false otherwise.
+  bool Open(const std::string& filepath, std::string* error_info_log);
+
+  // Unmaps the archive. The spans handed out become invalid.
+  void Close();
+
+  // Returns true when the archive has an entry with the given name.
+  bool Contains(const std::string& name) const;
+
+  // Returns the bytes of an uncompressed entry in place. They stay valid
+  // until the archive is closed. Returns false when the entry does not exist
+  // or is compressed.
+  bool GetSpan(const std::string& name, ByteSpan* span) const;
+
+  // Copies or decompresses an entry. Returns true upon success and false
+  // otherwise.
+  // Params:
+  //   name  The name of the entry.
+  //   thread_pool  The pool the blocks are decompressed on, or nullptr to
+  //     decompress them on the calling thread. Do not pass the pool the
+  //     calling thread belongs to.
+  //   contents  The bytes of the entry.
+  bool Read(const std::string& name,
+            ThreadPool* thread_pool,
+            std::string* contents) const;
+
+  // Returns the names of the entries, in index order.
+  std::vector<std::string> GetEntryNames() const;
+
+  int num_entries() const { return num_entries_; }
+
+ private:
+  // Returns the entry with the given name, or nullptr.
+  const PakIndexEntry* Find(const std::string& name) const;
+
+  MappedFile file_;
+  const PakIndexEntry* entries_;
+  const char* names_;
+  int num_entries_;
+};
+
+}  // namespace wvu
+
+#endif  // PAK_ARCHIVE_H_
@@ -0,0 +1,456 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#include "particle_system.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <string>
+#include <vector>
+#include <Eigen/Core>
+#include <GL/glew.h>
+#include <glog/logging.h>
+
+#include "camera.h"
+#include "shader_program.h"
+
+namespace wvu {
+namespace {
+// Work group size of the per-particle compute shaders.
+constexpr GLuint kWorkGroupSize = 64;
+// Size of a particle in the pool (three vec4).
+constexpr GLsizeiptr kParticleSizeInBytes = 12 * sizeof(GLfloat);
+// Offset of the draw arguments in the indirect buffer. The dispatch arguments
+// are at the beginning.
+constexpr GLintptr kDrawArgumentsOffset = 4 * sizeof(GLuint);
+
+// Layout of a particle in the pool.
+const std::string particle_struct_src =
+    "struct Particle {\n"
+    "  // xyz: position, w: remaining life in seconds.\n"
+    "  vec4 position_life;\n"
+    "  // xyz: velocity, w: total lifetime in seconds.\n"
+    "  vec4 velocity_lifetime;\n"
+    "  vec4 color;\n"
+    "};\n";
+
+// Declarations shared by the compute shaders.
+const std::string particle_buffers_src = particle_struct_src +
+    "layout (std430, binding = 0) buffer Particles {\n"
+    "  Particle particles[];\n"
+    "};\n"
+    "layout (std430, binding = 1) buffer DeadList {\n"
+    "  uint dead_list[];\n"
+    "};\n"
+    "layout (std430, binding = 2) buffer AliveLists {\n"
+    "  uint alive_lists[];\n"
+    "};\n"
+    "layout (std430, binding = 3) buffer Counters {\n"
+    "  int dead_count;\n"
+    "  int alive_count[2];\n"
+    "};\n"
+    "layout (std430, binding = 4) buffer IndirectArguments {\n"
+    "  uint dispatch_arguments[4];\n"
+    "  uint draw_arguments[4];\n"
+    "};\n"
+    "uniform uint max_num_particles;\n"
+    "uniform int current_list;\n";
+
+const std::string emit_compute_shader_src =
+    "#version 430 core\n"
+    "layout (local_size_x = 64) in;\n" +
+    particle_buffers_src +
+    "uniform uint num_particles_to_emit;\n"
+    "uniform uint seed;\n"
+    "uniform vec3 emitter_position;\n"
+    "uniform float position_spread;\n"
+    "uniform vec3 emitter_velocity;\n"
+    "uniform float velocity_spread;\n"
+    "uniform vec4 emitter_color;\n"
+    "uniform vec2 lifetime_range;\n"
+    "// PCG hash.\n"
+    "uint Hash(uint value) {\n"
+    "  uint state = value * 747796405u + 2891336453u;\n"
+    "  uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;\n"
+    "  return (word >> 22u) ^ word;\n"
+    "}\n"
+    "// Returns a random number in [0, 1).\n"
+    "float Random(inout uint state) {\n"
+    "  state = Hash(state);\n"
+    "  return float(state >> 8u) / 16777216.0f;\n"
+    "}\n"
+    "vec3 RandomVector(inout uint state) {\n"
+    "  return 2.0f * vec3(Random(state), Random(state), Random(state)) - 1.0f;\n"
+    "}\n"
+    "void main() {\n"
+    "  uint id = gl_GlobalInvocationID.x;\n"
+    "  if (id >= num_particles_to_emit) {\n"
+    "    return;\n"
+    "  }\n"
+    "  // Pop a free slot. When the pool is exhausted the counter is restored\n"
+    "  // and the particle is dropped.\n"
+    "  int num_free_slots = atomicAdd(dead_count, -1);\n"
+    "  if (num_free_slots <= 0) {\n"
+    "    atomicAdd(dead_count, 1);\n"
+    "    return;\n"
+    "  }\n"
+    "  uint slot = dead_list[num_free_slots - 1];\n"
+    "  uint state = Hash(id ^ Hash(seed));\n"
+    "  vec3 direction = normalize(RandomVector(state) + vec3(1e-6f));\n"
+    "  float radius = position_spread * pow(Random(state), 1.0f / 3.0f);\n"
+    "  float lifetime = mix(lifetime_range.x, lifetime_range.y, Random(state));\n"
+    "  particles[slot].position_life =\n"
+    "      vec4(emitter_position + radius * direction, lifetime);\n"
+    "  particles[slot].velocity_lifetime = vec4(\n"
+    "      emitter_velocity + velocity_spread * RandomVector(state), lifetime);\n"
+    "  particles[slot].color = emitter_color;\n"
+    "  uint index = uint(atomicAdd(alive_count[current_list], 1));\n"
+    "  alive_lists[uint(current_list) * max_num_particles + index] = slot;\n"
+    "}\n";
+
+// Writes the arguments of the simulation dispatch and resets the list the
+// simulation appends to.
+const std::string prepare_compute_shader_src =
+    "#version 430 core\n"
+    "layout (local_size_x = 1) in;\n" +
+    particle_buffers_src +
+    "void main() {\n"
+    "  dispatch_arguments[0] = (uint(alive_count[current_list]) + 63u) / 64u;\n"
+    "  dispatch_arguments[1] = 1u;\n"
+    "  dispatch_arguments[2] = 1u;\n"
+    "  alive_count[1 - current_list] = 0;\n"
+    "}\n";
+
+const std::string simulate_compute_shader_src =
+    "#version 430 core\n"
+    "layout (local_size_x = 64) in;\n" +
+    particle_buffers_src +
+    "uniform float elapsed_time;\n"
+    "uniform vec3 gravity;\n"
+    "void main() {\n"
+    "  uint id = gl_GlobalInvocationID.x;\n"
+    "  if (id >= uint(alive_count[current_list])) {\n"
+    "    return;\n"
+    "  }\n"
+    "  uint slot = alive_lists[uint(current_list) * max_num_particles + id];\n"
+    "  Particle particle = particles[slot];\n"
+    "  particle.position_life.w -= elapsed_time;\n"
+    "  if (particle.position_life.w <= 0.0f) {\n"
+    "    dead_list[atomicAdd(dead_count, 1)] = slot;\n"
+    "    return;\n"
+    "  }\n"
+    "  particle.velocity_lifetime.xyz += gravity * elapsed_time;\n"
+    "  particle.position_life.xyz +=\n"
+    "      particle.velocity_lifetime.xyz * elapsed_time;\n"
+    "  particles[slot] = particle;\n"
+    "  int next_list = 1 - current_list;\n"
+    "  uint index = uint(atomicAdd(alive_count[next_list], 1));\n"
+    "  alive_lists[uint(next_list) * max_num_particles + index] = slot;\n"
+    "}\n";
+
+// Writes the arguments of the draw: one four-vertex strip per live particle.
+const std::string finish_compute_shader_src =
+    "#version 430 core\n"
+    "layout (local_size_x = 1) in;\n" +
+    particle_buffers_src +
+    "void main() {\n"
+    "  draw_arguments[0] = 4u;\n"
+    "  draw_arguments[1] = uint(alive_count[current_list]);\n"
+    "  draw_arguments[2] = 0u;\n"
+    "  draw_arguments[3] = 0u;\n"
+    "}\n";
+
+// Only reads the pool and the alive lists: vertex shaders may have fewer
+// storage blocks available than compute shaders.
+const std::string draw_vertex_shader_src =
+    "#version 430 core\n" +
+    particle_struct_src +
+    "layout (std430, binding = 0) readonly buffer Particles {\n"
+    "  Particle particles[];\n"
+    "};\n"
+    "layout (std430, binding = 2) readonly buffer AliveLists {\n"
+    "  uint alive_lists[];\n"
+    "};\n"
+    "uniform uint max_num_particles;\n"
+    "uniform int current_list;\n"
+    "uniform mat4 view;\n"
+    "uniform mat4 projection;\n"
+    "uniform float particle_size;\n"
+    "out vec2 corner;\n"
+    "out vec4 color;\n"
+    "void main() {\n"
+    "  uint slot = alive_lists[uint(current_list) * max_num_particles +\n"
+    "                          uint(gl_InstanceID)];\n"
+    "  Particle particle = particles[slot];\n"
+    "  corner = 2.0f * vec2(gl_VertexID & 1, gl_VertexID >> 1) - 1.0f;\n"
+    "  // Expanding the corners in camera coordinates keeps the billboards\n"
+    "  // facing the camera.\n"
+    "  vec4 position = view * vec4(particle.position_life.xyz, 1.0f);\n"
+    "  position.xy += 0.5f * particle_size * corner;\n"
+    "  gl_Position = projection * position;\n"
+    "  color = particle.color;\n"
+    "  color.a *= particle.position_life.w / particle.velocity_lifetime.w;\n"
+    "}\n";
+
+const std::string draw_fragment_shader_src =
+    "#version 430 core\n"
+    "in vec2 corner;\n"
+    "in vec4 color;\n"
+    "out vec4 fragment_color;\n"
+    "void main() {\n"
+    "  float squared_distance = dot(corner, corner);\n"
+    "  if (squared_distance > 1.0f) {\n"
+    "    discard;\n"
+    "  }\n"
+    "  fragment_color = vec4(color.rgb, color.a * (1.0f - squared_distance));\n"
+    "}\n";
+
+// Number of work groups needed to cover num_items.
+inline GLuint NumWorkGroups(const int num_items) {
+  return (static_cast<GLuint>(num_items) + kWorkGroupSize - 1) /
+      kWorkGroupSize;
+}
+
+// Sets the uniforms every shader program shares.
+void SetCommonUniforms(const ShaderProgram& program,
+                       const int max_num_particles,
+                       const int current_list) {
+  glUniform1ui(glGetUniformLocation(program.shader_program_id(),
+                                    "max_num_particles"),
+               max_num_particles);
+  glUniform1i(glGetUniformLocation(program.shader_program_id(),
+                                   "current_list"),
+              current_list);
+}
+
+}  // namespace
+
+int AccumulateEmission(const GLfloat emission_rate,
+                       const GLfloat elapsed_time,
+                       GLfloat* accumulator) {
+  if (accumulator == nullptr) return 0;
+  *accumulator += std::max(emission_rate * elapsed_time, 0.0f);
+  const GLfloat num_particles = std::floor(*accumulator);
+  *accumulator -= num_particles;
+  return static_cast<int>(num_particles);
+}
+
+ParticleSystem::ParticleSystem() :
+    max_num_particles_(0), current_alive_list_(0),
+    emission_accumulator_(0.0f), random_seed_(0),
+    gravity_(0.0f, -9.8f, 0.0f),
+    particle_buffer_id_(0), dead_list_buffer_id_(0),
+    alive_list_buffer_id_(0), counter_buffer_id_(0),
+    indirect_buffer_id_(0), empty_vertex_array_object_id_(0) {
+  emitter_.position.setZero();
+  emitter_.position_spread = 0.1f;
+  emitter_.velocity = Eigen::Vector3f(0.0f, 2.0f, 0.0f);
+  emitter_.velocity_spread = 1.0f;
+  emitter_.color = Eigen::Vector4f(1.0f, 0.6f, 0.2f, 1.0f);
+  emitter_.min_lifetime = 1.0f;
+  emitter_.max_lifetime = 2.0f;
+  emitter_.size = 0.05f;
+  emitter_.emission_rate = 0.0f;
+}
+
+ParticleSystem::~ParticleSystem() {
+  const GLuint buffers[] = {particle_buffer_id_,
+                            dead_list_buffer_id_,
+                            alive_list_buffer_id_,
+                            counter_buffer_id_,
+                            indirect_buffer_id_};
+  glDeleteBuffers(5, buffers);
+  glDeleteVertexArrays(1, &empty_vertex_array_object_id_);
+}
+
+bool ParticleSystem::IsSupported() {
+  return ShaderProgram::AreComputeShadersSupported();
+}
+
+bool ParticleSystem::Initialize(const int max_num_particles,
+                                std::string* error_info_log) {
+  CHECK_GT(max_num_particles, 0);
+  emit_program_.LoadComputeShaderFromString(emit_compute_shader_src);
+  prepare_program_.LoadComputeShaderFromString(prepare_compute_shader_src);
+  simulate_program_.LoadComputeShaderFromString(simulate_compute_shader_src);
+  finish_program_.LoadComputeShaderFromString(finish_compute_shader_src);
+  draw_program_.LoadVertexShaderFromString(draw_vertex_shader_src);
+  draw_program_.LoadFragmentShaderFromString(draw_fragment_shader_src);
+  if (!emit_program_.Create(error_info_log) ||
+      !prepare_program_.Create(error_info_log) ||
+      !simulate_program_.Create(error_info_log) ||
+      !finish_program_.Create(error_info_log) ||
+      !draw_program_.Create(error_info_log)) {
+    return false;
+  }
+  max_num_particles_ = max_num_particles;
+  current_alive_list_ = 0;
+  GLuint buffers[5];
+  glGenBuffers(5, buffers);
+  particle_buffer_id_ = buffers[0];
+  dead_list_buffer_id_ = buffers[1];
+  alive_list_buffer_id_ = buffers[2];
+  counter_buffer_id_ = buffers[3];
+  indirect_buffer_id_ = buffers[4];
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, particle_buffer_id_);
+  glBufferData(GL_SHADER_STORAGE_BUFFER,
+               max_num_particles * kParticleSizeInBytes, nullptr,
+               GL_DYNAMIC_COPY);
+  // All the slots start in the dead list. This is the only time the CPU
+  // touches per-particle data.
+  std::vector<GLuint> dead_list(max_num_particles);
+  std::iota(dead_list.begin(), dead_list.end(), 0);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, dead_list_buffer_id_);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, dead_list.size() * sizeof(GLuint),
+               dead_list.data(), GL_DYNAMIC_COPY);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, alive_list_buffer_id_);
+  glBufferData(GL_SHADER_STORAGE_BUFFER,
+               2 * max_num_particles * sizeof(GLuint), nullptr,
+               GL_DYNAMIC_COPY);
+  const GLint counters[] = {max_num_particles, 0, 0};
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, counter_buffer_id_);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(counters), counters,
+               GL_DYNAMIC_COPY);
+  const GLuint indirect_arguments[] = {0, 1, 1, 0, 4, 0, 0, 0};
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, indirect_buffer_id_);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(indirect_arguments),
+               indirect_arguments, GL_DYNAMIC_COPY);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+  glGenVertexArrays(1, &empty_vertex_array_object_id_);
+  return true;
+}
+
+void ParticleSystem::BindStorageBuffers() const {
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, particle_buffer_id_);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, dead_list_buffer_id_);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, alive_list_buffer_id_);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, counter_buffer_id_);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, indirect_buffer_id_);
+}
+
+void ParticleSystem::Update(const GLfloat elapsed_time) {
+  if (max_num_particles_ == 0) return;
+  BindStorageBuffers();
+  // 1. Emission.
+  const int num_particles_to_emit = std::min(
+      AccumulateEmission(emitter_.emission_rate, elapsed_time,
+                         &emission_accumulator_),
+      max_num_particles_);
+  if (num_particles_to_emit > 0) {
+    emit_program_.Use();
+    const GLuint program_id = emit_program_.shader_program_id();
+    SetCommonUniforms(emit_program_, max_num_particles_, current_alive_list_);
+    glUniform1ui(glGetUniformLocation(program_id, "num_particles_to_emit"),
+                 num_particles_to_emit);
+    glUniform1ui(glGetUniformLocation(program_id, "seed"), random_seed_++);
+    glUniform3fv(glGetUniformLocation(program_id, "emitter_position"), 1,
+                 emitter_.position.data());
+    glUniform1f(glGetUniformLocation(program_id, "position_spread"),
+                emitter_.position_spread);
+    glUniform3fv(glGetUniformLocation(program_id, "emitter_velocity"), 1,
+                 emitter_.velocity.data());
+    glUniform1f(glGetUniformLocation(program_id, "velocity_spread"),
+                emitter_.velocity_spread);
+    glUniform4fv(glGetUniformLocation(program_id, "emitter_color"), 1,
+                 emitter_.color.data());
+    glUniform2f(glGetUniformLocation(program_id, "lifetime_range"),
+                emitter_.min_lifetime, emitter_.max_lifetime);
+    glDispatchCompute(NumWorkGroups(num_particles_to_emit), 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+  }
+  // 2. Simulation, dispatched over the live particles only.
+  prepare_program_.Use();
+  SetCommonUniforms(prepare_program_, max_num_particles_,
+                    current_alive_list_);
+  glDispatchCompute(1, 1, 1);
+  glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+  simulate_program_.Use();
+  SetCommonUniforms(simulate_program_, max_num_particles_,
+                    current_alive_list_);
+  glUniform1f(glGetUniformLocation(simulate_program_.shader_program_id(),
+                                   "elapsed_time"),
+              elapsed_time);
+  glUniform3fv(glGetUniformLocation(simulate_program_.shader_program_id(),
+                                    "gravity"),
+               1, gravity_.data());
+  glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, indirect_buffer_id_);
+  glDispatchComputeIndirect(0);
+  glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
+  glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+  // The survivors are now in the other list.
+  current_alive_list_ = 1 - current_alive_list_;
+  // 3. Arguments of the draw.
+  finish_program_.Use();
+  SetCommonUniforms(finish_program_, max_num_particles_, current_alive_list_);
+  glDispatchCompute(1, 1, 1);
+  glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+  glUseProgram(0);
+}
+
+void ParticleSystem::Draw(const Camera& camera) {
+  Draw(camera.projection(), camera.look_at());
+}
+
+void ParticleSystem::Draw(const Eigen::Matrix4f& projection,
+                          const Eigen::Matrix4f& view) {
+  if (max_num_particles_ == 0) return;
+  draw_program_.Use();
+  const GLuint program_id = draw_program_.shader_program_id();
+  SetCommonUniforms(draw_program_, max_num_particles_, current_alive_list_);
+  glUniformMatrix4fv(glGetUniformLocation(program_id, "view"), 1, GL_FALSE,
+                     view.data());
+  glUniformMatrix4fv(glGetUniformLocation(program_id, "projection"), 1,
+                     GL_FALSE, projection.data());
+  glUniform1f(glGetUniformLocation(program_id, "particle_size"),
+              emitter_.size);
+  BindStorageBuffers();
+  // Depth-tested against the scene without writing depth, and blended
+  // additively so the order of the particles does not matter.
+  glEnable(GL_DEPTH_TEST);
+  glDepthMask(GL_FALSE);
+  glEnable(GL_BLEND);
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+  glBindVertexArray(empty_vertex_array_object_id_);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect_buffer_id_);
+  glDrawArraysIndirect(GL_TRIANGLE_STRIP,
+                       reinterpret_cast<const GLvoid*>(kDrawArgumentsOffset));
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+  glBindVertexArray(0);
+  glDisable(GL_BLEND);
+  glDepthMask(GL_TRUE);
+  glUseProgram(0);
+}
+
+}  // namespace wvu
@@ -0,0 +1,198 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef PARTICLE_SYSTEM_H_
+#define PARTICLE_SYSTEM_H_
+
+#include <string>
+#include <Eigen/Core>
+#include <GL/glew.h>
+
+#include "shader_program.h"
+
+namespace wvu {
+class Camera;
+
+// Describes how new particles are spawned. Every new particle gets a random
+// position inside a sphere around the emitter and a random velocity around
+// the emitter velocity.
+struct ParticleEmitter {
+  // Center of the emitter in the world coordinate system.
+  Eigen::Vector3f position;
+  // Radius of the sphere in which particles are spawned.
+  GLfloat position_spread;
+  // Mean initial velocity of the particles.
+  Eigen::Vector3f velocity;
+  // Maximum deviation of every component of the initial velocity.
+  GLfloat velocity_spread;
+  // RGBA color of the particles. The alpha fades to zero with the life.
+  Eigen::Vector4f color;
+  // Range of the lifetime of the particles in seconds.
+  GLfloat min_lifetime;
+  GLfloat max_lifetime;
+  // Width and height of the billboards in world units.
+  GLfloat size;
+  // Number of particles spawned per second.
+  GLfloat emission_rate;
+};
+
+// Returns the number of particles to spawn after elapsed_time seconds at the
+// given rate. The fractional part is carried over in the accumulator, so that
+// low rates still emit particles at high frame rates.
+// Params:
+//   emission_rate  Number of particles per second.
+//   elapsed_time  Time since the last call in seconds.
+//   accumulator  The fractional particles carried between calls.
+int AccumulateEmission(const GLfloat emission_rate,
+                       const GLfloat elapsed_time,
+                       GLfloat* accumulator);
+
+// This class implements a particle system that lives entirely in GPU memory.
+// The CPU only issues a fixed number of dispatches and one draw per frame,
+// regardless of the number of particles.
+//
+// The particles live in a pool of fixed capacity. Free slots are tracked in a
+// dead list, and the live slots in two alive lists used in a ping-pong
+// fashion. The lists and their counters are storage buffers updated with
+// atomic operations:
+//   1. Emission: every invocation pops a slot from the dead list, initializes
+//      the particle, and appends the slot to the current alive list.
+//   2. Simulation: dispatched indirectly over the current alive list. Live
+//      particles are integrated and appended to the next alive list, and dead
+//      ones are pushed back to the dead list, which compacts the alive list.
+//   3. Rendering: the next alive list is drawn as camera-facing billboards
+//      with an indirect instanced draw whose instance count was written by
+//      the GPU.
+//
+// The particles are depth-tested against the scene but do not write depth,
+// and they are blended additively, so they do not need to be sorted. Usage
+// example:
+//
+// wvu::ParticleSystem particles;
+// std::string error_info_log;
+// if (!wvu::ParticleSystem::IsSupported() ||
+//     !particles.Initialize(1 << 20, &error_info_log)) {
+//   ...  // Disable the particles.
+// }
+// particles.set_emitter(emitter);
+// while (...) {  // Rendering loop.
+//   ...  // Render the opaque scene.
+//   particles.Update(elapsed_time);
+//   particles.Draw(camera);
+// }
+class ParticleSystem {
+ public:
+  ParticleSystem();
+  ~ParticleSystem();
+
+  // Returns true when the current OpenGL context supports the compute shaders
+  // this class relies on (OpenGL 4.3).
+  static bool IsSupported();
+
+  // Allocates the particle pool and compiles the shader programs. Returns
+  // true upon success and false otherwise.
+  // Params:
+  //   max_num_particles  The capacity of the particle pool.
+  //   error_info_log  A pointer to a string that holds the error log.
+  bool Initialize(const int max_num_particles, std::string* error_info_log);
+
+  // Emits new particles and advances the simulation.
+  // Params:
+  //   elapsed_time  Time since the last update in seconds.
+  void Update(const GLfloat elapsed_time);
+
+  // Draws the live particles into the current framebuffer.
+  // Params:
+  //   camera  The camera providing the view and projection matrices.
+  void Draw(const Camera& camera);
+
+  // Same as above but with explicit matrices.
+  // Params:
+  //   projection  The camera projection matrix.
+  //   view  The camera pose matrix (world -> camera transformation matrix).
+  void Draw(const Eigen::Matrix4f& projection, const Eigen::Matrix4f& view);
+
+  // Sets the emitter used by the following updates.
+  void set_emitter(const ParticleEmitter& emitter) {
+    emitter_ = emitter;
+  }
+
+  // Sets the constant acceleration applied to all the particles.
+  void set_gravity(const Eigen::Vector3f& gravity) {
+    gravity_ = gravity;
+  }
+
+  // Returns the capacity of the particle pool.
+  int max_num_particles() const {
+    return max_num_particles_;
+  }
+
+ private:
+  // Binds the storage buffers at the binding points used by the shaders.
+  void BindStorageBuffers() const;
+
+  // Capacity of the particle pool.
+  int max_num_particles_;
+  // Index (0 or 1) of the alive list holding the particles of the last
+  // simulation step.
+  int current_alive_list_;
+  // Fractional particles carried between updates.
+  GLfloat emission_accumulator_;
+  // Seed of the random number generator of the emission shader.
+  GLuint random_seed_;
+  ParticleEmitter emitter_;
+  Eigen::Vector3f gravity_;
+  // Particle pool.
+  GLuint particle_buffer_id_;
+  // Free slot list, and the two alive slot lists stored back to back.
+  GLuint dead_list_buffer_id_;
+  GLuint alive_list_buffer_id_;
+  // Counters of the dead list and the alive lists.
+  GLuint counter_buffer_id_;
+  // Arguments of the indirect simulation dispatch and the indirect draw.
+  GLuint indirect_buffer_id_;
+  // Empty vertex array object: the billboard corners are generated from
+  // gl_VertexID.
+  GLuint empty_vertex_array_object_id_;
+  // Shader programs.
+  ShaderProgram emit_program_;
+  ShaderProgram prepare_program_;
+  ShaderProgram simulate_program_;
+  ShaderProgram finish_program_;
+  ShaderProgram draw_program_;
+};
+
+}  // namespace wvu
+
+#endif  // PARTICLE_SYSTEM_H_
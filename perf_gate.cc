@@ -0,0 +1,210 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#include "perf_gate.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "benchmark.h"
+#include "cooked_assets.h"
+
+namespace wvu {
+namespace {
+
+// The number of standard deviations of the noise a metric may move without
+// failing, on top of its tolerance.
+constexpr double kNumNoiseDeviations = 3.0;
+// Scales a MAD into the standard deviation of normally distributed samples.
+constexpr double kMadToStandardDeviation = 1.4826;
+
+const char* GetStatusName(const PerfStatus status) {
+  switch (status) {
+    case PerfStatus::PASSED: return "ok";
+    case PerfStatus::REGRESSED: return "REGRESSED";
+    case PerfStatus::IMPROVED: return "improved";
+    case PerfStatus::NO_BASELINE: return "new";
+    case PerfStatus::SKIPPED: return "skipped";
+  }
+  return "";
+}
+
+}  // namespace
+
+bool PerfBaselines::Load(const std::string& filepath,
+                         std::string* error_info_log) {
+  baselines_.clear();
+  std::ifstream in(filepath);
+  if (!in.is_open()) return true;
+  std::string line;
+  int line_number = 0;
+  while (std::getline(in, line)) {
+    ++line_number;
+    if (line.empty() || line[0] == '#') continue;
+    std::istringstream fields(line);
+    std::string name;
+    PerfBaseline baseline;
+    if (!std::getline(fields, name, '\t') ||
+        !(fields >> baseline.median >> baseline.median_absolute_deviation >>
+          baseline.tolerance)) {
+      if (error_info_log != nullptr) {
+        *error_info_log = "Malformed baseline line " +
+            std::to_string(line_number) + " in " + filepath;
+      }
+      return false;
+    }
+    baselines_[name] = baseline;
+  }
+  return true;
+}
+
+bool PerfBaselines::Save(const std::string& filepath,
+                         std::string* error_info_log) const {
+  // Sorted, so that the baselines diff well.
+  const std::map<std::string, PerfBaseline> sorted_baselines(
+      baselines_.begin(), baselines_.end());
+  std::ostringstream contents;
+  contents << "# Perf baselines: name, median ns, MAD ns, tolerance.\n"
+           << "# Regenerate with wvu_perf --update_baselines.\n";
+  contents << std::setprecision(6);
+  for (const auto& entry : sorted_baselines) {
+    contents << entry.first << "\t" << entry.second.median << "\t"
+             << entry.second.median_absolute_deviation << "\t"
+             << entry.second.tolerance << "\n";
+  }
+  if (!WriteFileContents(filepath, contents.str())) {
+    if (error_info_log != nullptr) {
+      *error_info_log = "Could not write " + filepath;
+    }
+    return false;
+  }
+  return true;
+}
+
+const PerfBaseline* PerfBaselines::Find(const std::string& name) const {
+  const auto baseline = baselines_.find(name);
+  return baseline == baselines_.end() ? nullptr : &baseline->second;
+}
+
+void PerfBaselines::Set(const std::string& name,
+                        const PerfBaseline& baseline) {
+  baselines_[name] = baseline;
+}
+
+PerfComparison ComparePerformance(const std::string& name,
+                                  const SampleSummary& measured,
+                                  const PerfBaseline* baseline) {
+  PerfComparison comparison;
+  comparison.name = name;
+  comparison.median = measured.median;
+  comparison.median_absolute_deviation = measured.median_absolute_deviation;
+  if (baseline == nullptr) {
+    comparison.status = PerfStatus::NO_BASELINE;
+    comparison.baseline_median = 0.0;
+    comparison.limit = 0.0;
+    return comparison;
+  }
+  comparison.baseline_median = baseline->median;
+  const double noise = kNumNoiseDeviations * kMadToStandardDeviation *
+      std::max(baseline->median_absolute_deviation,
+               measured.median_absolute_deviation);
+  const double margin = baseline->median * baseline->tolerance + noise;
+  comparison.limit = baseline->median + margin;
+  if (measured.median > comparison.limit) {
+    comparison.status = PerfStatus::REGRESSED;
+  } else if (measured.median < baseline->median - margin) {
+    comparison.status = PerfStatus::IMPROVED;
+  } else {
+    comparison.status = PerfStatus::PASSED;
+  }
+  return comparison;
+}
+
+bool PassesPerfGate(const std::vector<PerfComparison>& comparisons) {
+  for (const PerfComparison& comparison : comparisons) {
+    if (comparison.status == PerfStatus::REGRESSED) return false;
+  }
+  return true;
+}
+
+void PrintPerfComparisons(const std::vector<PerfComparison>& comparisons,
+                          std::ostream* stream) {
+  if (stream == nullptr) return;
+  size_t name_width = 6;
+  for (const PerfComparison& comparison : comparisons) {
+    name_width = std::max(name_width, comparison.name.size());
+  }
+  *stream << std::left << std::setw(name_width) << "Metric" << std::right
+          << std::setw(16) << "baseline ns" << std::setw(16) << "median ns"
+          << std::setw(12) << "MAD ns" << std::setw(10) << "change"
+          << std::setw(16) << "limit ns" << "  status\n";
+  *stream << std::fixed << std::setprecision(2);
+  for (const PerfComparison& comparison : comparisons) {
+    *stream << std::left << std::setw(name_width) << comparison.name
+            << std::right;
+    if (comparison.status == PerfStatus::SKIPPED) {
+      *stream << std::setw(70) << "" << "  " << GetStatusName(comparison.status)
+              << "\n";
+      continue;
+    }
+    const bool has_baseline = comparison.status != PerfStatus::NO_BASELINE;
+    *stream << std::setw(16);
+    if (has_baseline) {
+      *stream << comparison.baseline_median;
+    } else {
+      *stream << "-";
+    }
+    *stream << std::setw(16) << comparison.median << std::setw(12)
+            << comparison.median_absolute_deviation << std::setw(10);
+    if (has_baseline) {
+      std::ostringstream change;
+      change << std::showpos << std::fixed << std::setprecision(1)
+             << 100.0 * (comparison.median / comparison.baseline_median - 1.0)
+             << "%";
+      *stream << change.str() << std::setw(16) << comparison.limit;
+    } else {
+      *stream << "-" << std::setw(16) << "-";
+    }
+    *stream << "  " << GetStatusName(comparison.status) << "\n";
+  }
+  stream->unsetf(std::ios_base::floatfield);
+}
+
+}  // namespace wvu
@@ -0,0 +1,122 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef PERF_GATE_H_
+#define PERF_GATE_H_
+
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "benchmark.h"
+
+namespace wvu {
+
+// The committed timing of a perf metric, in nanoseconds per item, and the
+// relative slowdown it tolerates.
+struct PerfBaseline {
+  double median;
+  double median_absolute_deviation;
+  double tolerance;
+};
+
+// The baselines of the perf metrics. They are stored as a text file with one
+// tab-separated "name median mad tolerance" line per metric; lines starting
+// with '#' are comments.
+class PerfBaselines {
+ public:
+  // Loads the baselines. A missing file has no baselines. Returns true upon
+  // success and false otherwise.
+  bool Load(const std::string& filepath, std::string* error_info_log);
+
+  // Saves the baselines. Returns true upon success and false otherwise.
+  bool Save(const std::string& filepath, std::string* error_info_log) const;
+
+  // Returns the baseline of the metric, or nullptr if it has none.
+  const PerfBaseline* Find(const std::string& name) const;
+
+  // Sets the baseline of the metric.
+  void Set(const std::string& name, const PerfBaseline& baseline);
+
+  int num_entries() const { return baselines_.size(); }
+
+ private:
+  std::unordered_map<std::string, PerfBaseline> baselines_;
+};
+
+// Outcome of the comparison of a metric against its baseline.
+enum struct PerfStatus {
+  PASSED = 0,
+  REGRESSED = 1,
+  IMPROVED = 2,
+  // The metric has no baseline; it never fails.
+  NO_BASELINE = 3,
+  // The metric could not be measured, e.g., without an OpenGL context.
+  SKIPPED = 4
+};
+
+// A row of the diff table.
+struct PerfComparison {
+  std::string name;
+  PerfStatus status;
+  double baseline_median;
+  double median;
+  double median_absolute_deviation;
+  // The median above which the metric regressed.
+  double limit;
+};
+
+// Compares a measured metric against its baseline. The metric regressed when
+// its median is above the baseline median by more than the tolerance plus
+// three standard deviations of the noise, estimated from the largest MAD of
+// the two runs. Improvements are detected symmetrically.
+// Params:
+//   name  The name of the metric.
+//   measured  The samples of the metric, in nanoseconds per item.
+//   baseline  The baseline of the metric, or nullptr.
+PerfComparison ComparePerformance(const std::string& name,
+                                  const SampleSummary& measured,
+                                  const PerfBaseline* baseline);
+
+// Returns true when none of the metrics regressed.
+bool PassesPerfGate(const std::vector<PerfComparison>& comparisons);
+
+// Prints the comparisons as a diff table.
+void PrintPerfComparisons(const std::vector<PerfComparison>& comparisons,
+                          std::ostream* stream);
+
+}  // namespace wvu
+
+#endif  // PERF_GATE_H_
@@ -0,0 +1,579 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#include "scene_file.h"
+
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+#include "cooked_assets.h"
+#include "mapped_file.h"
+
+namespace wvu {
+namespace {
+
+struct SceneHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t num_entities;
+  uint32_t num_meshes;
+  uint32_t num_materials;
+  uint32_t num_textures;
+  uint32_t strings_size;
+  uint32_t padding;
+  // Offsets of the sections from the start of the scene.
+  uint64_t entities_offset;
+  uint64_t meshes_offset;
+  uint64_t materials_offset;
+  uint64_t textures_offset;
+  uint64_t strings_offset;
+};
+static_assert(sizeof(SceneHeader) == 72, "Unexpected padding.");
+static_assert(sizeof(SceneEntity) == 56, "Unexpected padding.");
+
+// A recursive descent parser for the text format (see ParseSceneText).
+class SceneTextParser {
+ public:
+  explicit SceneTextParser(const std::string& text) :
+      text_(text), position_(0), line_(1) {}
+
+  bool Parse(SceneDescription* scene, std::string* error_info_log);
+
+ private:
+  // Skips white space and // comments.
+  void SkipWhitespace();
+  // Consumes the next character when it is the given one.
+  bool Consume(const char character);
+  bool Expect(const char character);
+  bool ParseString(std::string* str);
+  bool ParseNumber(float* number);
+  bool ParseBool(bool* boolean);
+  bool ParseVector(const int size, float* values);
+  bool SkipValue();
+  // Parses {"key": value, ...}, calling parse_value for every key.
+  bool ParseObject(const std::function<bool(const std::string&)>& parse_value);
+  // Parses [value, ...], calling parse_value for every element.
+  bool ParseArray(const std::function<bool()>& parse_value);
+  bool ParseMaterial(SceneDescription::Material* material);
+  bool ParseEntity(SceneDescription::Entity* entity,
+                   std::string* mesh_name,
+                   std::string* material_name);
+  bool Fail(const std::string& message);
+
+  const std::string& text_;
+  size_t position_;
+  int line_;
+  std::string error_;
+};
+
+void SceneTextParser::SkipWhitespace() {
+  while (position_ < text_.size()) {
+    const char character = text_[position_];
+    if (character == '\n') ++line_;
+    if (std::isspace(static_cast<unsigned char>(character))) {
+      ++position_;
+    } else if (text_.compare(position_, 2, "//") == 0) {
+      while (position_ < text_.size() && text_[position_] != '\n') {
+        ++position_;
+      }
+    } else {
+      break;
+    }
+  }
+}
+
+bool SceneTextParser::Consume(const char character) {
+  SkipWhitespace();
+  if (position_ >= text_.size() || text_[position_] != character) {
+    return false;
+  }
+  ++position_;
+  return true;
+}
+
+bool SceneTextParser::Expect(const char character) {
+  return Consume(character) ||
+      Fail(std::string("expected '") + character + "'");
+}
+
+bool SceneTextParser::ParseString(std::string* str) {
+  if (!Expect('"')) return false;
+  str->clear();
+  while (position_ < text_.size() && text_[position_] != '"') {
+    char character = text_[position_++];
+    if (character == '\n') return Fail("unterminated string");
+    if (character == '\\') {
+      if (position_ >= text_.size()) break;
+      character = text_[position_++];
+      if (character == 'n') character = '\n';
+      if (character == 't') character = '\t';
+    }
+    str->push_back(character);
+  }
+  if (position_ >= text_.size()) return Fail("unterminated string");
+  ++position_;
+  return true;
+}
+
+bool SceneTextParser::ParseNumber(float* number) {
+  SkipWhitespace();
+  const char* begin = text_.c_str() + position_;
+  char* end;
+  *number = std::strtof(begin, &end);
+  if (end == begin) return Fail("expected a number");
+  position_ += end - begin;
+  return true;
+}
+
+bool SceneTextParser::ParseBool(bool* boolean) {
+  SkipWhitespace();
+  if (text_.compare(position_, 4, "true") == 0) {
+    *boolean = true;
+    position_ += 4;
+    return true;
+  }
+  if (text_.compare(position_, 5, "false") == 0) {
+    *boolean = false;
+    position_ += 5;
+    return true;
+  }
+  return Fail("expected true or false");
+}
+
+bool SceneTextParser::ParseVector(const int size, float* values) {
+  if (!Expect('[')) return false;
+  for (int i = 0; i < size; ++i) {
+    if (i > 0 && !Expect(',')) return false;
+    if (!ParseNumber(&values[i])) return false;
+  }
+  return Expect(']');
+}
+
+bool SceneTextParser::SkipValue() {
+  SkipWhitespace();
+  if (position_ >= text_.size()) return Fail("expected a value");
+  const char character = text_[position_];
+  if (character == '"') {
+    std::string str;
+    return ParseString(&str);
+  }
+  if (character == '{') {
+    return ParseObject([this](const std::string&) { return SkipValue(); });
+  }
+  if (character == '[') return ParseArray([this] { return SkipValue(); });
+  if (character == 't' || character == 'f') {
+    bool boolean;
+    return ParseBool(&boolean);
+  }
+  if (text_.compare(position_, 4, "null") == 0) {
+    position_ += 4;
+    return true;
+  }
+  float number;
+  return ParseNumber(&number);
+}
+
+bool SceneTextParser::ParseObject(
+    const std::function<bool(const std::string&)>& parse_value) {
+  if (!Expect('{')) return false;
+  if (Consume('}')) return true;
+  do {
+    std::string key;
+    if (!ParseString(&key) || !Expect(':') || !parse_value(key)) return false;
+  } while (Consume(','));
+  return Expect('}');
+}
+
+bool SceneTextParser::ParseArray(const std::function<bool()>& parse_value) {
+  if (!Expect('[')) return false;
+  if (Consume(']')) return true;
+  do {
+    if (!parse_value()) return false;
+  } while (Consume(','));
+  return Expect(']');
+}
+
+bool SceneTextParser::ParseMaterial(SceneDescription::Material* material) {
+  return ParseObject([this, material](const std::string& key) {
+    if (key == "vertex_shader") return ParseString(&material->vertex_shader);
+    if (key == "fragment_shader") {
+      return ParseString(&material->fragment_shader);
+    }
+    if (key == "textures") {
+      return ParseArray([this, material] {
+        material->textures.emplace_back();
+        return ParseString(&material->textures.back());
+      });
+    }
+    return SkipValue();
+  });
+}
+
+bool SceneTextParser::ParseEntity(SceneDescription::Entity* entity,
+                                  std::string* mesh_name,
+                                  std::string* material_name) {
+  return ParseObject([=](const std::string& key) {
+    if (key == "name") return ParseString(&entity->name);
+    if (key == "mesh") return ParseString(mesh_name);
+    if (key == "material") return ParseString(material_name);
+    if (key == "position") return ParseVector(3, entity->position.data());
+    if (key == "static") return ParseBool(&entity->is_static);
+    if (key == "rotation") {
+      Eigen::Vector3f rotation;
+      if (!ParseVector(3, rotation.data())) return false;
+      const float angle = rotation.norm();
+      entity->orientation = angle > 0.0f ?
+          Eigen::Quaternionf(Eigen::AngleAxisf(angle, rotation / angle)) :
+          Eigen::Quaternionf::Identity();
+      return true;
+    }
+    if (key == "orientation") {
+      // Stored as (x, y, z, w), as in the quaternion coefficients.
+      if (!ParseVector(4, entity->orientation.coeffs().data())) return false;
+      entity->orientation.normalize();
+      return true;
+    }
+    if (key == "scale") {
+      if (Consume('[')) {
+        --position_;
+        return ParseVector(3, entity->scale.data());
+      }
+      float scale;
+      if (!ParseNumber(&scale)) return false;
+      entity->scale.setConstant(scale);
+      return true;
+    }
+    return SkipValue();
+  });
+}
+
+bool SceneTextParser::Fail(const std::string& message) {
+  if (error_.empty()) {
+    error_ = "Line " + std::to_string(line_) + ": " + message;
+  }
+  return false;
+}
+
+bool SceneTextParser::Parse(SceneDescription* scene,
+                            std::string* error_info_log) {
+  std::unordered_map<std::string, int> mesh_indices;
+  std::unordered_map<std::string, int> material_indices;
+  // The references of the entities are resolved at the end, since the keys
+  // may come in any order.
+  std::vector<std::string> mesh_names;
+  std::vector<std::string> material_names;
+  const bool parsed = ParseObject([&](const std::string& key) {
+    if (key == "meshes") {
+      return ParseObject([&](const std::string& name) {
+        mesh_indices[name] = scene->meshes.size();
+        scene->meshes.emplace_back();
+        return ParseString(&scene->meshes.back());
+      });
+    }
+    if (key == "materials") {
+      return ParseObject([&](const std::string& name) {
+        material_indices[name] = scene->materials.size();
+        scene->materials.emplace_back();
+        return ParseMaterial(&scene->materials.back());
+      });
+    }
+    if (key == "entities") {
+      return ParseArray([&] {
+        SceneDescription::Entity entity;
+        entity.position.setZero();
+        entity.orientation.setIdentity();
+        entity.scale.setOnes();
+        entity.mesh_index = -1;
+        entity.material_index = -1;
+        entity.is_static = false;
+        mesh_names.emplace_back();
+        material_names.emplace_back();
+        scene->entities.push_back(entity);
+        return ParseEntity(&scene->entities.back(), &mesh_names.back(),
+                           &material_names.back());
+      });
+    }
+    return SkipValue();
+  });
+  SkipWhitespace();
+  if (parsed && position_ != text_.size()) Fail("trailing characters");
+  for (int i = 0; error_.empty() && i < scene->entities.size(); ++i) {
+    const auto mesh_index = mesh_indices.find(mesh_names[i]);
+    if (mesh_index == mesh_indices.end()) {
+      error_ = "Entity " + std::to_string(i) + " references the unknown "
+          "mesh '" + mesh_names[i] + "'";
+      break;
+    }
+    scene->entities[i].mesh_index = mesh_index->second;
+    if (material_names[i].empty()) continue;
+    const auto material_index = material_indices.find(material_names[i]);
+    if (material_index == material_indices.end()) {
+      error_ = "Entity " + std::to_string(i) + " references the unknown "
+          "material '" + material_names[i] + "'";
+      break;
+    }
+    scene->entities[i].material_index = material_index->second;
+  }
+  if (!error_.empty()) {
+    if (error_info_log != nullptr) *error_info_log = error_;
+    return false;
+  }
+  return true;
+}
+
+// The string table of an encoded scene. Equal strings are stored once, and
+// the empty string is at offset zero.
+class StringTable {
+ public:
+  StringTable() : strings_(1, '\0') { offsets_[""] = 0; }
+
+  uint32_t Add(const std::string& str) {
+    const auto inserted = offsets_.emplace(str, strings_.size());
+    if (inserted.second) strings_.append(str.c_str(), str.size() + 1);
+    return inserted.first->second;
+  }
+
+  const std::string& strings() const { return strings_; }
+
+ private:
+  std::string strings_;
+  std::unordered_map<std::string, uint32_t> offsets_;
+};
+
+// Appends a section aligned to 8 bytes and returns its offset.
+uint64_t AppendSection(const void* data,
+                       const size_t size,
+                       std::string* bytes) {
+  bytes->resize((bytes->size() + 7) & ~static_cast<size_t>(7), '\0');
+  const uint64_t offset = bytes->size();
+  bytes->append(static_cast<const char*>(data), size);
+  return offset;
+}
+
+// Returns true when the section [offset, offset + count * element_size) is
+// within the scene and aligned to 8 bytes.
+bool IsValidSection(const uint64_t offset,
+                    const uint64_t count,
+                    const uint64_t element_size,
+                    const size_t size) {
+  return offset % 8 == 0 && offset <= size &&
+      count * element_size <= size - offset;
+}
+
+bool HasSuffix(const std::string& str, const std::string& suffix) {
+  return str.size() >= suffix.size() &&
+      str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+}  // namespace
+
+bool ParseSceneText(const std::string& text,
+                    SceneDescription* scene,
+                    std::string* error_info_log) {
+  if (scene == nullptr) return false;
+  *scene = SceneDescription();
+  SceneTextParser parser(text);
+  return parser.Parse(scene, error_info_log);
+}
+
+void EncodeScene(const SceneDescription& scene, std::string* bytes) {
+  if (bytes == nullptr) return;
+  StringTable string_table;
+  std::vector<SceneEntity> entities(scene.entities.size());
+  for (int i = 0; i < scene.entities.size(); ++i) {
+    const SceneDescription::Entity& source = scene.entities[i];
+    SceneEntity& entity = entities[i];
+    std::copy(source.position.data(), source.position.data() + 3,
+              entity.position);
+    std::copy(source.orientation.coeffs().data(),
+              source.orientation.coeffs().data() + 4, entity.orientation);
+    std::copy(source.scale.data(), source.scale.data() + 3, entity.scale);
+    entity.mesh_index = source.mesh_index;
+    entity.material_index = source.material_index >= 0 ?
+        source.material_index : kNoSceneMaterial;
+    entity.flags = source.is_static ? kStaticSceneEntity : 0;
+    entity.name = string_table.Add(source.name);
+  }
+  std::vector<uint32_t> meshes;
+  for (const std::string& mesh : scene.meshes) {
+    meshes.push_back(string_table.Add(mesh));
+  }
+  std::vector<SceneMaterial> materials;
+  std::vector<uint32_t> textures;
+  for (const SceneDescription::Material& source : scene.materials) {
+    SceneMaterial material;
+    material.vertex_shader = string_table.Add(source.vertex_shader);
+    material.fragment_shader = string_table.Add(source.fragment_shader);
+    material.first_texture = textures.size();
+    material.num_textures = source.textures.size();
+    for (const std::string& texture : source.textures) {
+      textures.push_back(string_table.Add(texture));
+    }
+    materials.push_back(material);
+  }
+
+  SceneHeader header;
+  std::memcpy(header.magic, "WVUS", 4);
+  header.version = kSceneVersion;
+  header.num_entities = entities.size();
+  header.num_meshes = meshes.size();
+  header.num_materials = materials.size();
+  header.num_textures = textures.size();
+  header.strings_size = string_table.strings().size();
+  header.padding = 0;
+  bytes->assign(sizeof(header), '\0');
+  header.entities_offset = AppendSection(
+      entities.data(), entities.size() * sizeof(SceneEntity), bytes);
+  header.meshes_offset = AppendSection(
+      meshes.data(), meshes.size() * sizeof(uint32_t), bytes);
+  header.materials_offset = AppendSection(
+      materials.data(), materials.size() * sizeof(SceneMaterial), bytes);
+  header.textures_offset = AppendSection(
+      textures.data(), textures.size() * sizeof(uint32_t), bytes);
+  header.strings_offset = AppendSection(
+      string_table.strings().data(), string_table.strings().size(), bytes);
+  std::memcpy(&(*bytes)[0], &header, sizeof(header));
+}
+
+SceneView::SceneView() :
+    entities_(nullptr), meshes_(nullptr), materials_(nullptr),
+    textures_(nullptr), strings_(nullptr), num_entities_(0), num_meshes_(0),
+    num_materials_(0) {}
+
+bool SceneView::Initialize(const char* data,
+                           const size_t size,
+                           std::string* error_info_log) {
+  *this = SceneView();
+  const auto fail = [error_info_log](const std::string& error) {
+    if (error_info_log != nullptr) *error_info_log = error;
+    return false;
+  };
+  if (data == nullptr || size < sizeof(SceneHeader) ||
+      reinterpret_cast<uintptr_t>(data) % 8 != 0) {
+    return fail("Not a scene, or misaligned.");
+  }
+  const SceneHeader& header = *reinterpret_cast<const SceneHeader*>(data);
+  if (std::memcmp(header.magic, "WVUS", 4) != 0 ||
+      header.version != kSceneVersion) {
+    return fail("Not a supported scene.");
+  }
+  if (!IsValidSection(header.entities_offset, header.num_entities,
+                      sizeof(SceneEntity), size) ||
+      !IsValidSection(header.meshes_offset, header.num_meshes,
+                      sizeof(uint32_t), size) ||
+      !IsValidSection(header.materials_offset, header.num_materials,
+                      sizeof(SceneMaterial), size) ||
+      !IsValidSection(header.textures_offset, header.num_textures,
+                      sizeof(uint32_t), size) ||
+      !IsValidSection(header.strings_offset, header.strings_size, 1, size) ||
+      header.strings_size == 0 ||
+      data[header.strings_offset + header.strings_size - 1] != '\0' ||
+      header.num_entities > INT32_MAX) {
+    return fail("Truncated scene.");
+  }
+  const SceneEntity* entities =
+      reinterpret_cast<const SceneEntity*>(data + header.entities_offset);
+  const uint32_t* meshes =
+      reinterpret_cast<const uint32_t*>(data + header.meshes_offset);
+  const SceneMaterial* materials =
+      reinterpret_cast<const SceneMaterial*>(data + header.materials_offset);
+  const uint32_t* textures =
+      reinterpret_cast<const uint32_t*>(data + header.textures_offset);
+  // The string table ends with a null character, so every offset within it
+  // is a valid string.
+  for (uint32_t i = 0; i < header.num_meshes; ++i) {
+    if (meshes[i] >= header.strings_size) return fail("Corrupted mesh.");
+  }
+  for (uint32_t i = 0; i < header.num_textures; ++i) {
+    if (textures[i] >= header.strings_size) return fail("Corrupted texture.");
+  }
+  for (uint32_t i = 0; i < header.num_materials; ++i) {
+    const SceneMaterial& material = materials[i];
+    if (material.vertex_shader >= header.strings_size ||
+        material.fragment_shader >= header.strings_size ||
+        material.first_texture > header.num_textures ||
+        material.num_textures > header.num_textures - material.first_texture) {
+      return fail("Corrupted material " + std::to_string(i) + ".");
+    }
+  }
+  for (uint32_t i = 0; i < header.num_entities; ++i) {
+    const SceneEntity& entity = entities[i];
+    if (entity.mesh_index >= header.num_meshes ||
+        (entity.material_index >= header.num_materials &&
+         entity.material_index != kNoSceneMaterial) ||
+        entity.name >= header.strings_size) {
+      return fail("Corrupted entity " + std::to_string(i) + ".");
+    }
+  }
+  entities_ = entities;
+  meshes_ = meshes;
+  materials_ = materials;
+  textures_ = textures;
+  strings_ = data + header.strings_offset;
+  num_entities_ = header.num_entities;
+  num_meshes_ = header.num_meshes;
+  num_materials_ = header.num_materials;
+  return true;
+}
+
+bool SceneFile::Open(const std::string& filepath,
+                     std::string* error_info_log) {
+  file_.Close();
+  bytes_.clear();
+  if (HasSuffix(filepath, ".wvuscene")) {
+    return file_.Open(filepath, error_info_log) &&
+        view_.Initialize(file_.data(), file_.size(), error_info_log);
+  }
+  std::string text;
+  if (!ReadFileContents(filepath, &text)) {
+    if (error_info_log != nullptr) {
+      *error_info_log = "Could not read " + filepath;
+    }
+    return false;
+  }
+  SceneDescription scene;
+  if (!ParseSceneText(text, &scene, error_info_log)) return false;
+  EncodeScene(scene, &bytes_);
+  return view_.Initialize(bytes_.data(), bytes_.size(), error_info_log);
+}
+
+}  // namespace wvu
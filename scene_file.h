@@ -0,0 +1,210 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef SCENE_FILE_H_
+#define SCENE_FILE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+#include "mapped_file.h"
+
+namespace wvu {
+
+// Version of the binary scene format.
+constexpr uint32_t kSceneVersion = 1;
+// Material index of the entities without a material.
+constexpr uint32_t kNoSceneMaterial = 0xffffffffu;
+// Flags of the entities.
+constexpr uint32_t kStaticSceneEntity = 1;
+
+// An entity of a binary scene, used in place. The strings are offsets into
+// the string table of the scene.
+struct SceneEntity {
+  float position[3];
+  // Unit quaternion (x, y, z, w).
+  float orientation[4];
+  float scale[3];
+  uint32_t mesh_index;
+  uint32_t material_index;
+  uint32_t flags;
+  uint32_t name;
+};
+
+// A material of a binary scene. Its textures are the entries [first_texture,
+// first_texture + num_textures) of the texture table.
+struct SceneMaterial {
+  uint32_t vertex_shader;
+  uint32_t fragment_shader;
+  uint32_t first_texture;
+  uint32_t num_textures;
+};
+
+// Authoring representation of a scene, e.g., parsed from the text format.
+struct SceneDescription {
+  struct Material {
+    std::string vertex_shader;
+    std::string fragment_shader;
+    std::vector<std::string> textures;
+  };
+  struct Entity {
+    std::string name;
+    Eigen::Vector3f position;
+    // Unaligned, so that the entities can be stored in a std::vector.
+    Eigen::Quaternion<float, Eigen::DontAlign> orientation;
+    Eigen::Vector3f scale;
+    int mesh_index;
+    // -1 for no material.
+    int material_index;
+    bool is_static;
+  };
+  std::vector<std::string> meshes;
+  std::vector<Material> materials;
+  std::vector<Entity> entities;
+};
+
+// Parses the text format of a scene, a subset of JSON:
+//
+// {
+//   "meshes": {"pyramid": "builtin:pyramid", "bunny": "bunny.wvumesh"},
+//   "materials": {
+//     "bricks": {"vertex_shader": "model.vert", "fragment_shader":
+//                "model.frag", "textures": ["brick.bmp"]}
+//   },
+//   "entities": [
+//     {"name": "pyramid", "mesh": "pyramid", "material": "bricks",
+//      "position": [-3, -1, -15], "rotation": [1, 1, 1], "scale": 1,
+//      "static": true}
+//   ]
+// }
+//
+// The meshes and the materials are referenced by name. The rotation is a
+// Rodrigues vector, as taken by Model; "orientation" may give a quaternion
+// (x, y, z, w) instead. The scale is a number or a 3-vector. Unknown keys are
+// ignored. Returns true upon success and false otherwise.
+bool ParseSceneText(const std::string& text,
+                    SceneDescription* scene,
+                    std::string* error_info_log);
+
+// Encodes a scene in the binary format ("WVUS"): a header with the counts and
+// the offsets of the sections, followed by the entities, the meshes (string
+// offsets), the materials, the textures (string offsets), and the string
+// table (null-terminated strings). All the offsets are relative, so the bytes
+// can be used in place wherever they are mapped.
+void EncodeScene(const SceneDescription& scene, std::string* bytes);
+
+// A view of a binary scene. Initialize() validates the layout and the
+// references once, so that the accessors need no checks; it does not copy
+// anything, and the bytes must outlive the view.
+class SceneView {
+ public:
+  SceneView();
+
+  // Validates a binary scene. The bytes must be 8-byte aligned, as mapped
+  // files and heap allocations are. Returns true upon success and false
+  // otherwise.
+  bool Initialize(const char* data,
+                  const size_t size,
+                  std::string* error_info_log);
+
+  int num_entities() const { return num_entities_; }
+  const SceneEntity& entity(const int index) const {
+    return entities_[index];
+  }
+
+  int num_meshes() const { return num_meshes_; }
+  const char* mesh(const int index) const {
+    return strings_ + meshes_[index];
+  }
+
+  int num_materials() const { return num_materials_; }
+  const SceneMaterial& material(const int index) const {
+    return materials_[index];
+  }
+
+  // Returns a texture of a material.
+  const char* texture(const SceneMaterial& material, const int index) const {
+    return strings_ + textures_[material.first_texture + index];
+  }
+
+  // Returns a string of the string table.
+  const char* string(const uint32_t offset) const {
+    return strings_ + offset;
+  }
+
+ private:
+  const SceneEntity* entities_;
+  const uint32_t* meshes_;
+  const SceneMaterial* materials_;
+  const uint32_t* textures_;
+  const char* strings_;
+  int num_entities_;
+  int num_meshes_;
+  int num_materials_;
+};
+
+// A scene loaded from a file: a binary scene (.wvuscene) is mapped and used in
+// place, and a text scene (any other extension) is parsed and encoded first.
+// Usage example:
+//
+// wvu::SceneFile scene_file;
+// if (!scene_file.Open("level.wvuscene", &error_info_log)) {
+//   ...
+// }
+// const wvu::SceneView& scene = scene_file.view();
+// for (int i = 0; i < scene.num_entities(); ++i) {
+//   const wvu::SceneEntity& entity = scene.entity(i);
+//   ...
+// }
+class SceneFile {
+ public:
+  // Returns true upon success and false otherwise.
+  bool Open(const std::string& filepath, std::string* error_info_log);
+
+  const SceneView& view() const { return view_; }
+
+ private:
+  MappedFile file_;
+  // The encoded text scene.
+  std::string bytes_;
+  SceneView view_;
+};
+
+}  // namespace wvu
+
+#endif  // SCENE_FILE_H_
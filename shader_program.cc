@@ -48,7 +48,9 @@ constexpr int kNumCharsInfoLog = 512;
 // Enumeration to select the shader types.
 enum ShaderType {
   VERTEX = 0,
-  FRAGMENT = 1
+  FRAGMENT = 1,
+  COMPUTE = 2,
+  GEOMETRY = 3
 };
 
 // Compiles a shader that is contained in shader_src C++ string. The shader type
@@ -67,6 +69,12 @@ GLuint CompileShader(const std::string& shader_src,
     case FRAGMENT:
       shader_id = glCreateShader(GL_FRAGMENT_SHADER);
       break;
+    case COMPUTE:
+      shader_id = glCreateShader(GL_COMPUTE_SHADER);
+      break;
+    case GEOMETRY:
+      shader_id = glCreateShader(GL_GEOMETRY_SHADER);
+      break;
   }
   // Retrieving the pointer to the C string wrapped by shader_src.
   // This is to comply with the signature of glShaderSource() function.
@@ -98,18 +106,27 @@ GLuint CompileShader(const std::string& shader_src,
 }
 
 // Creates a shader program. This function requires the ids of the vertex and
-// fragment shaders which were successfully compiled. The function can return
+// fragment shaders which were successfully compiled. A compute program passes
+// its compute shader as the vertex shader and zero as the fragment shader. The
+// geometry shader is zero when the program has none. The function can return
 // the error info log string in case of a failure. The function returns the
 // shader program id if successfull, and returns zero otherwise.
 GLuint CreateShaderProgram(const GLuint vertex_shader,
                            const GLuint fragment_shader,
+                           const GLuint geometry_shader,
                            std::string* info_log) {
   // Create a program id.
   const GLuint shader_program = glCreateProgram();
   // Attach to the program the vertex shader.
   glAttachShader(shader_program, vertex_shader);
   // Attach to the program the fragment shader.
-  glAttachShader(shader_program, fragment_shader);
+  if (fragment_shader != 0) {
+    glAttachShader(shader_program, fragment_shader);
+  }
+  // Attach to the program the optional geometry shader.
+  if (geometry_shader != 0) {
+    glAttachShader(shader_program, geometry_shader);
+  }
   // Link the both shaders to get a shader program.
   glLinkProgram(shader_program);
   // Check if the operation was successful.
@@ -133,10 +150,12 @@ GLuint CreateShaderProgram(const GLuint vertex_shader,
 // Releases the resources allocated for compilation of shaders.
 // Clear the shader sources strings.
 void ReleaseShaderResources(const GLuint vertex_shader,
-                            const GLuint fragment_shader) {
+                            const GLuint fragment_shader,
+                            const GLuint geometry_shader) {
   // Delete shaders and set them to 0.
   glDeleteShader(vertex_shader);
   glDeleteShader(fragment_shader);
+  glDeleteShader(geometry_shader);
 }
 
 // Loads a shader source from a file. The function receives the filepath
@@ -175,6 +194,26 @@ bool ShaderProgram::LoadFragmentShaderFromString(
   return true;
 }
 
+bool ShaderProgram::LoadGeometryShaderFromString(
+    const std::string& geometry_shader_source) {
+  geometry_shader_src_ = geometry_shader_source;
+  return true;
+}
+
+bool ShaderProgram::LoadComputeShaderFromString(
+    const std::string& compute_shader_source) {
+  compute_shader_src_ = compute_shader_source;
+  return true;
+}
+
+bool ShaderProgram::AreComputeShadersSupported() {
+  GLint major_version = 0;
+  GLint minor_version = 0;
+  glGetIntegerv(GL_MAJOR_VERSION, &major_version);
+  glGetIntegerv(GL_MINOR_VERSION, &minor_version);
+  return major_version > 4 || (major_version == 4 && minor_version >= 3);
+}
+
 bool ShaderProgram::LoadVertexShaderFromFile(
     const std::string& vertex_shader_path) {
   return LoadShaderFromFile(vertex_shader_path, &vertex_shader_src_);
@@ -191,6 +230,25 @@ bool ShaderProgram::Create(std::string* error_info_log) {
   // sources are used, then a different instance should be called.
   if (created_) return true;
   std::string info_log;
+  if (!compute_shader_src_.empty()) {
+    if (!BuildComputeShader(&info_log)) {
+      if (error_info_log) {
+        *error_info_log = info_log;
+      }
+      return false;
+    }
+    shader_program_id_ =
+        CreateShaderProgram(compute_shader_, 0, 0, &info_log);
+    glDeleteShader(compute_shader_);
+    if (shader_program_id_ == 0) {
+      if (error_info_log) {
+        *error_info_log = info_log;
+      }
+      return false;
+    }
+    created_ = true;
+    return true;
+  }
   if (!BuildVertexShader(&info_log)) {
     if (error_info_log) {
       *error_info_log = info_log;
@@ -203,6 +261,12 @@ bool ShaderProgram::Create(std::string* error_info_log) {
     }
     return false;
   }
+  if (!geometry_shader_src_.empty() && !BuildGeometryShader(&info_log)) {
+    if (error_info_log) {
+      *error_info_log = info_log;
+    }
+    return false;
+  }
   if (!LinkProgram(&info_log)) {
     if (error_info_log) {
       *error_info_log = info_log;
@@ -223,11 +287,22 @@ bool ShaderProgram::BuildFragmentShader(std::string* info_log) {
   return fragment_shader_ != 0;
 }
 
+bool ShaderProgram::BuildComputeShader(std::string* info_log) {
+  compute_shader_ = CompileShader(compute_shader_src_, COMPUTE, info_log);
+  return compute_shader_ != 0;
+}
+
+bool ShaderProgram::BuildGeometryShader(std::string* info_log) {
+  geometry_shader_ = CompileShader(geometry_shader_src_, GEOMETRY, info_log);
+  return geometry_shader_ != 0;
+}
+
 bool ShaderProgram::LinkProgram(std::string* info_log) {
   shader_program_id_ = CreateShaderProgram(vertex_shader_,
                                            fragment_shader_,
+                                           geometry_shader_,
                                            info_log);
-  ReleaseShaderResources(vertex_shader_, fragment_shader_);
+  ReleaseShaderResources(vertex_shader_, fragment_shader_, geometry_shader_);
   return shader_program_id_ != 0;
 }
 
@@ -80,7 +80,18 @@ namespace wvu {
 //   ...
 // }
 //
-// 4) Passing uniform variables to shader example:
+// 4) Creating a compute shader program (requires OpenGL 4.3) example:
+//
+// wvu::ShaderProgram compute_program;
+// compute_program.LoadComputeShaderFromString(compute_shader_string_instance);
+// std::string error_info_log;
+// if (!compute_program.Create(&error_info_log)) {
+//   LOG(ERROR) << error_info_log;
+// }
+// compute_program.Use();
+// glDispatchCompute(num_groups_x, 1, 1);
+//
+// 5) Passing uniform variables to shader example:
 // When passing values to uniform variables in the shader program, the shader
 // program id is necessary. This class provides access to this id by calling the
 // accessor method shader_program_id().
@@ -96,8 +107,10 @@ class ShaderProgram {
   ShaderProgram() :
       // Initializing member attributes.
       vertex_shader_src_(""), fragment_shader_src_(""),
-      vertex_shader_(0), fragment_shader_(0), shader_program_id_(0),
-      created_(false) {}
+      compute_shader_src_(""), geometry_shader_src_(""),
+      vertex_shader_(0), fragment_shader_(0), compute_shader_(0),
+      geometry_shader_(0),
+      shader_program_id_(0), created_(false) {}
   // Destructor. Invoked automatically once the instance goes out of scope.
   virtual ~ShaderProgram() {
     if (created_) {
@@ -126,6 +139,26 @@ class ShaderProgram {
   //     source.
   bool LoadFragmentShaderFromString(const std::string& fragment_shader_source);
 
+  // Loads a geometry shader source code from a string. The geometry shader is
+  // optional and runs between the vertex and the fragment shaders. Returns
+  // true if successful, and false otherwise.
+  // Parameters:
+  //   geometry_shader_source  The C++ string containing the geometry shader
+  //     source.
+  bool LoadGeometryShaderFromString(const std::string& geometry_shader_source);
+
+  // Loads a compute shader source code from a string. A program with a
+  // compute shader cannot have vertex or fragment shaders. Returns true if
+  // successful, and false otherwise.
+  // Parameters:
+  //   compute_shader_source  The C++ string containing the compute shader
+  //     source.
+  bool LoadComputeShaderFromString(const std::string& compute_shader_source);
+
+  // Returns true when the current OpenGL context supports compute shaders
+  // (OpenGL 4.3 or later). Requires a current context.
+  static bool AreComputeShadersSupported();
+
   // Loads a vertex shader from a file. Returns true if
   // successful, and false otherwise.
   // Parameters:
@@ -138,11 +171,13 @@ class ShaderProgram {
   //   fragment_shader_path  The filepath for the fragment shader.
   bool LoadFragmentShaderFromFile(const std::string& fragment_shader_path);
 
-  // This function executes the following steps:
+  // This function executes the following steps (when a compute shader was
+  // loaded, steps 1 and 2 compile the compute shader instead):
   // 1. Compiles the vertex shader. If an error occurrs, the error information
   //    log is copied into error_info_log pointer.
-  // 2. Compiles the fragment shader. If an error occurrs, the error information
-  //    log is copied into error_info_log pointer.
+  // 2. Compiles the fragment shader, and the geometry shader when one was
+  //    loaded. If an error occurrs, the error information log is copied into
+  //    error_info_log pointer.
   // 3. Links the shaders to form a shader program. If an error occurrs, the
   //    error information log is copied into error_info_log pointer.
   // 4. Cleans up temporary variables.
@@ -169,6 +204,10 @@ class ShaderProgram {
   bool BuildVertexShader(std::string* info_log);
   // Compiles the fragment shader.
   bool BuildFragmentShader(std::string* info_log);
+  // Compiles the compute shader.
+  bool BuildComputeShader(std::string* info_log);
+  // Compiles the geometry shader.
+  bool BuildGeometryShader(std::string* info_log);
   // Links the shaders to form a shader program.
   bool LinkProgram(std::string* info_log);
 
@@ -177,10 +216,18 @@ class ShaderProgram {
   std::string vertex_shader_src_;
   // Fragment shader program source.
   std::string fragment_shader_src_;
+  // Compute shader program source.
+  std::string compute_shader_src_;
+  // Geometry shader program source.
+  std::string geometry_shader_src_;
   // Vertex shader id.
   GLuint vertex_shader_;
   // Fragment shader id.
   GLuint fragment_shader_;
+  // Compute shader id.
+  GLuint compute_shader_;
+  // Geometry shader id. Zero when the program has no geometry shader.
+  GLuint geometry_shader_;
   // Program shader id.
   GLuint shader_program_id_;
   // Created state variable. True when this shader program is created, and false
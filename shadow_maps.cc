@@ -0,0 +1,344 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#include "shadow_maps.h"
+
+#define _USE_MATH_DEFINES  // For using M_PI.
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <GL/glew.h>
+#include <glog/logging.h>
+
+#include "camera.h"
+#include "camera_utils.h"
+#include "model.h"
+#include "shader_program.h"
+
+namespace wvu {
+namespace {
+// Blending weight between the logarithmic and uniform split schemes.
+constexpr GLfloat kSplitLambda = 0.75f;
+// Scale applied to the radius of a cascade so that the camera can move a bit
+// before the cached static cascade has to be re-rendered.
+constexpr GLfloat kCacheMarginScale = 1.25f;
+// Distance covered towards the light beyond the cascade bounds, so that
+// casters outside the view frustum still cast shadows into it.
+constexpr GLfloat kCasterDistance = 50.0f;
+// Granularity used when rounding the radius of a cascade.
+constexpr GLfloat kRadiusGranularity = 1.0f / 16.0f;
+
+const std::string depth_vertex_shader_src =
+    "#version 330 core\n"
+    "layout (location = 0) in vec3 position;\n"
+    "uniform mat4 model;\n"
+    "uniform mat4 view;\n"
+    "uniform mat4 projection;\n"
+    "void main() {\n"
+    "  gl_Position = projection * view * model * vec4(position, 1.0f);\n"
+    "}\n";
+
+const std::string depth_fragment_shader_src =
+    "#version 330 core\n"
+    "void main() {\n"
+    "}\n";
+
+// Creates a depth texture usable for hardware depth comparisons and attaches
+// it to a new framebuffer.
+void CreateDepthAtlas(const int width,
+                      const int height,
+                      GLuint* framebuffer_id,
+                      GLuint* texture_id) {
+  glGenTextures(1, texture_id);
+  glBindTexture(GL_TEXTURE_2D, *texture_id);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, width, height, 0,
+               GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, nullptr);
+  // Linear filtering with comparison mode gives 2x2 PCF for free.
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE,
+                  GL_COMPARE_REF_TO_TEXTURE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glGenFramebuffers(1, framebuffer_id);
+  glBindFramebuffer(GL_FRAMEBUFFER, *framebuffer_id);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D,
+                         *texture_id, 0);
+  glDrawBuffer(GL_NONE);
+  glReadBuffer(GL_NONE);
+}
+
+}  // namespace
+
+std::vector<GLfloat> ComputeCascadeSplits(const GLfloat near_plane_distance,
+                                          const GLfloat far_plane_distance,
+                                          const int num_cascades,
+                                          const GLfloat lambda) {
+  std::vector<GLfloat> splits(num_cascades);
+  const GLfloat ratio = far_plane_distance / near_plane_distance;
+  const GLfloat range = far_plane_distance - near_plane_distance;
+  for (int i = 1; i < num_cascades; ++i) {
+    const GLfloat fraction = static_cast<GLfloat>(i) / num_cascades;
+    const GLfloat logarithmic_split =
+        near_plane_distance * std::pow(ratio, fraction);
+    const GLfloat uniform_split = near_plane_distance + range * fraction;
+    splits[i - 1] =
+        lambda * logarithmic_split + (1.0f - lambda) * uniform_split;
+  }
+  splits[num_cascades - 1] = far_plane_distance;
+  return splits;
+}
+
+CascadedShadowMaps::CascadedShadowMaps() :
+    num_cascades_(0), cascade_resolution_(0),
+    light_direction_(0.0f, -1.0f, 0.0f),
+    light_rotation_(Eigen::Matrix3f::Identity()),
+    static_framebuffer_id_(0), static_atlas_texture_id_(0),
+    dynamic_framebuffer_id_(0), dynamic_atlas_texture_id_(0),
+    has_dynamic_casters_(false), num_static_refreshes_(0) {
+  set_light_direction(light_direction_);
+}
+
+CascadedShadowMaps::~CascadedShadowMaps() {
+  glDeleteFramebuffers(1, &static_framebuffer_id_);
+  glDeleteFramebuffers(1, &dynamic_framebuffer_id_);
+  glDeleteTextures(1, &static_atlas_texture_id_);
+  glDeleteTextures(1, &dynamic_atlas_texture_id_);
+}
+
+bool CascadedShadowMaps::Initialize(const int num_cascades,
+                                    const int cascade_resolution,
+                                    std::string* error_info_log) {
+  if (num_cascades < 1 || num_cascades > kMaxNumCascades ||
+      cascade_resolution < 1) {
+    if (error_info_log) {
+      *error_info_log = "Invalid number of cascades or cascade resolution.";
+    }
+    return false;
+  }
+  num_cascades_ = num_cascades;
+  cascade_resolution_ = cascade_resolution;
+  cascades_.resize(num_cascades_);
+  for (Cascade& cascade : cascades_) {
+    cascade.snapped_center.setZero();
+    cascade.radius = 0.0f;
+    cascade.dirty = true;
+  }
+  cascade_texture_matrices_.resize(num_cascades_);
+  depth_shader_program_.LoadVertexShaderFromString(depth_vertex_shader_src);
+  depth_shader_program_.LoadFragmentShaderFromString(
+      depth_fragment_shader_src);
+  if (!depth_shader_program_.Create(error_info_log)) {
+    return false;
+  }
+  const int atlas_width = num_cascades_ * cascade_resolution_;
+  CreateDepthAtlas(atlas_width, cascade_resolution_,
+                   &static_framebuffer_id_, &static_atlas_texture_id_);
+  bool complete =
+      glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+  CreateDepthAtlas(atlas_width, cascade_resolution_,
+                   &dynamic_framebuffer_id_, &dynamic_atlas_texture_id_);
+  complete &=
+      glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  if (!complete) {
+    if (error_info_log) {
+      *error_info_log = "The shadow atlas framebuffer is incomplete.";
+    }
+    return false;
+  }
+  return true;
+}
+
+void CascadedShadowMaps::set_light_direction(
+    const Eigen::Vector3f& light_direction) {
+  const Eigen::Vector3f direction = light_direction.normalized();
+  // The light "camera" looks along the light direction, i.e., its -z axis.
+  const Eigen::Vector3f up = std::fabs(direction.y()) < 0.99f ?
+      Eigen::Vector3f::UnitY() : Eigen::Vector3f::UnitX();
+  const Eigen::Vector3f x_axis = direction.cross(up).normalized();
+  light_rotation_.row(0) = x_axis;
+  light_rotation_.row(1) = x_axis.cross(direction);
+  light_rotation_.row(2) = -direction;
+  if (direction != light_direction_) {
+    MarkStaticCastersDirty();
+  }
+  light_direction_ = direction;
+}
+
+void CascadedShadowMaps::MarkStaticCastersDirty() {
+  for (Cascade& cascade : cascades_) {
+    cascade.dirty = true;
+  }
+}
+
+void CascadedShadowMaps::FitCascade(const Camera& camera,
+                                    const GLfloat split_near,
+                                    const GLfloat split_far,
+                                    Cascade* cascade) {
+  // Corners of the frustum slice in camera coordinates.
+  const GLfloat tan_half_fov_y = std::tan(0.5f * camera.field_of_view());
+  const GLfloat tan_half_fov_x = tan_half_fov_y * camera.aspect_ratio();
+  // The look-at matrix is rigid, so its inverse is cheap to compute.
+  const Eigen::Matrix3f camera_rotation =
+      camera.look_at().block<3, 3>(0, 0).transpose();
+  const Eigen::Vector3f camera_position =
+      -camera_rotation * camera.look_at().block<3, 1>(0, 3);
+  Eigen::Vector3f corners[8];
+  Eigen::Vector3f center = Eigen::Vector3f::Zero();
+  for (int i = 0; i < 8; ++i) {
+    const GLfloat depth = (i & 4) ? split_far : split_near;
+    const Eigen::Vector3f corner_in_camera(
+        ((i & 1) ? 1.0f : -1.0f) * tan_half_fov_x * depth,
+        ((i & 2) ? 1.0f : -1.0f) * tan_half_fov_y * depth,
+        -depth);
+    corners[i] = camera_rotation * corner_in_camera + camera_position;
+    center += corners[i];
+  }
+  center /= 8.0f;
+  GLfloat radius = 0.0f;
+  for (int i = 0; i < 8; ++i) {
+    radius = std::max(radius, (corners[i] - center).norm());
+  }
+  // The radius only depends on the projection parameters. Rounding it keeps it
+  // constant from frame to frame despite floating point noise.
+  radius = std::ceil(radius / kRadiusGranularity) * kRadiusGranularity;
+  const GLfloat margin_radius = kCacheMarginScale * radius;
+  // The center snaps to a grid whose step is a multiple of the texel size
+  // (avoids shimmering edges) and smaller than the margin (the snapped bounds
+  // always contain the frustum slice).
+  const GLfloat texel_size = 2.0f * margin_radius / cascade_resolution_;
+  const GLfloat step = texel_size * std::max(
+      1.0f, std::floor((margin_radius - radius) / texel_size));
+  const Eigen::Vector3f center_in_light = light_rotation_ * center;
+  const Eigen::Vector3f snapped_center(
+      std::round(center_in_light.x() / step) * step,
+      std::round(center_in_light.y() / step) * step,
+      std::round(center_in_light.z() / step) * step);
+  if (snapped_center != cascade->snapped_center ||
+      margin_radius != cascade->radius) {
+    cascade->dirty = true;
+  }
+  cascade->snapped_center = snapped_center;
+  cascade->radius = margin_radius;
+  cascade->view = Eigen::Matrix4f::Identity();
+  cascade->view.block<3, 3>(0, 0) = light_rotation_;
+  cascade->view.block<3, 1>(0, 3) = -snapped_center;
+  cascade->projection = ComputeOrthographicProjectionMatrix(
+      -margin_radius, margin_radius, -margin_radius, margin_radius,
+      -margin_radius - kCasterDistance, margin_radius);
+}
+
+void CascadedShadowMaps::RenderCasters(const int cascade_index,
+                                       const std::vector<Model*>& casters) {
+  const Cascade& cascade = cascades_[cascade_index];
+  glViewport(cascade_index * cascade_resolution_, 0, cascade_resolution_,
+             cascade_resolution_);
+  for (Model* model : casters) {
+    model->Draw(depth_shader_program_, cascade.projection, cascade.view, 0);
+  }
+}
+
+void CascadedShadowMaps::Render(const Camera& camera,
+                                const std::vector<Model*>& static_casters,
+                                const std::vector<Model*>& dynamic_casters) {
+  CHECK_GT(num_cascades_, 0) << "Initialize() must be called first.";
+  cascade_splits_ = ComputeCascadeSplits(camera.near_plane_distance(),
+                                         camera.far_plane_distance(),
+                                         num_cascades_, kSplitLambda);
+  for (int i = 0; i < num_cascades_; ++i) {
+    const GLfloat split_near =
+        i == 0 ? camera.near_plane_distance() : cascade_splits_[i - 1];
+    FitCascade(camera, split_near, cascade_splits_[i], &cascades_[i]);
+  }
+
+  GLint viewport[4];
+  glGetIntegerv(GL_VIEWPORT, viewport);
+  glEnable(GL_DEPTH_TEST);
+  glEnable(GL_POLYGON_OFFSET_FILL);
+  glPolygonOffset(2.0f, 4.0f);
+  depth_shader_program_.Use();
+
+  // Refresh the stale static cascades.
+  glBindFramebuffer(GL_FRAMEBUFFER, static_framebuffer_id_);
+  glEnable(GL_SCISSOR_TEST);
+  for (int i = 0; i < num_cascades_; ++i) {
+    if (!cascades_[i].dirty) continue;
+    glScissor(i * cascade_resolution_, 0, cascade_resolution_,
+              cascade_resolution_);
+    glClear(GL_DEPTH_BUFFER_BIT);
+    RenderCasters(i, static_casters);
+    cascades_[i].dirty = false;
+    ++num_static_refreshes_;
+  }
+  glDisable(GL_SCISSOR_TEST);
+
+  // Copy the cached atlas and render the dynamic casters on top of it.
+  has_dynamic_casters_ = !dynamic_casters.empty();
+  if (has_dynamic_casters_) {
+    const int atlas_width = num_cascades_ * cascade_resolution_;
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, static_framebuffer_id_);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, dynamic_framebuffer_id_);
+    glBlitFramebuffer(0, 0, atlas_width, cascade_resolution_,
+                      0, 0, atlas_width, cascade_resolution_,
+                      GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, dynamic_framebuffer_id_);
+    for (int i = 0; i < num_cascades_; ++i) {
+      RenderCasters(i, dynamic_casters);
+    }
+  }
+
+  glDisable(GL_POLYGON_OFFSET_FILL);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+
+  // Matrices mapping world coordinates to atlas texture coordinates.
+  Eigen::Matrix4f bias = Eigen::Matrix4f::Identity();
+  bias.block<3, 3>(0, 0) *= 0.5f;
+  bias.block<3, 1>(0, 3).setConstant(0.5f);
+  for (int i = 0; i < num_cascades_; ++i) {
+    Eigen::Matrix4f atlas_offset = Eigen::Matrix4f::Identity();
+    atlas_offset(0, 0) = 1.0f / num_cascades_;
+    atlas_offset(0, 3) = static_cast<GLfloat>(i) / num_cascades_;
+    cascade_texture_matrices_[i] = atlas_offset * bias *
+        cascades_[i].projection * cascades_[i].view;
+  }
+}
+
+}  // namespace wvu
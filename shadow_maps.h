@@ -0,0 +1,210 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef SHADOW_MAPS_H_
+#define SHADOW_MAPS_H_
+
+#include <string>
+#include <vector>
+#include <Eigen/Core>
+#include <GL/glew.h>
+
+#include "camera.h"
+#include "model.h"
+#include "shader_program.h"
+
+namespace wvu {
+// Maximum number of cascades supported by the shaders.
+constexpr int kMaxNumCascades = 4;
+
+// Computes the far distance of every cascade using the practical split scheme,
+// which blends a logarithmic and a uniform distribution of the splits. The
+// last split is always far_plane_distance.
+// Params:
+//   near_plane_distance  The near plane distance of the camera.
+//   far_plane_distance  The far plane distance of the camera.
+//   num_cascades  The number of cascades.
+//   lambda  Blending weight in [0, 1]: 1 is logarithmic and 0 is uniform.
+std::vector<GLfloat> ComputeCascadeSplits(const GLfloat near_plane_distance,
+                                          const GLfloat far_plane_distance,
+                                          const int num_cascades,
+                                          const GLfloat lambda);
+
+// This class renders directional cascaded shadow maps. The cascades are
+// fitted to the near_plane_distance/far_plane_distance range of a Camera and
+// stored side by side in a single depth atlas.
+//
+// Redrawing every shadow caster each frame does not scale with the size of
+// the scene, so the casters are split in two sets:
+//
+// - Static casters are rendered into a cached atlas. A cascade of the cache is
+//   only re-rendered when the light direction changes, when the static set
+//   changes (see MarkStaticCastersDirty()), or when the camera moves far
+//   enough that the cascade no longer covers its slice of the view frustum.
+//   The cascade bounds are enlarged by a margin and snapped to a coarse grid
+//   in light space to make the latter rare.
+//
+// - Dynamic casters are rendered every frame on top of a copy of the cached
+//   atlas.
+//
+// Hence the per-frame cost scales with the dynamic content, not with the size
+// of the scene.
+//
+// Usage example:
+//
+// wvu::CascadedShadowMaps shadow_maps;
+// std::string error_info_log;
+// if (!shadow_maps.Initialize(4, 1024, &error_info_log)) {
+//   LOG(ERROR) << error_info_log;
+// }
+// shadow_maps.set_light_direction(light_direction);
+// ...
+// while (...) {  // Rendering loop.
+//   shadow_maps.Render(camera, static_models, dynamic_models);
+//   ...  // Sample shadow_maps.shadow_atlas_texture_id() when shading.
+// }
+class CascadedShadowMaps {
+ public:
+  CascadedShadowMaps();
+  ~CascadedShadowMaps();
+
+  // Creates the atlases and the depth-only shader program. Returns true upon
+  // success and false otherwise.
+  // Params:
+  //   num_cascades  The number of cascades (at most kMaxNumCascades).
+  //   cascade_resolution  The width and height of a cascade in texels.
+  //   error_info_log  A pointer to a string that holds the error log.
+  bool Initialize(const int num_cascades,
+                  const int cascade_resolution,
+                  std::string* error_info_log);
+
+  // Sets the direction in which the light travels (world coordinates).
+  // Changing the direction invalidates the cached static cascades.
+  void set_light_direction(const Eigen::Vector3f& light_direction);
+
+  // Invalidates the cached static cascades. Call it whenever a static caster
+  // is added, removed or moved.
+  void MarkStaticCastersDirty();
+
+  // Fits the cascades to the camera, refreshes the stale static cascades and
+  // renders the dynamic casters. The viewport and framebuffer bindings are
+  // restored to the default framebuffer afterwards.
+  // Params:
+  //   camera  The camera whose frustum is covered by the cascades.
+  //   static_casters  The shadow casters that rarely change.
+  //   dynamic_casters  The shadow casters that change every frame.
+  void Render(const Camera& camera,
+              const std::vector<Model*>& static_casters,
+              const std::vector<Model*>& dynamic_casters);
+
+  // Returns the depth atlas that holds the shadows of the last Render() call.
+  GLuint shadow_atlas_texture_id() const {
+    return has_dynamic_casters_ ? dynamic_atlas_texture_id_ :
+        static_atlas_texture_id_;
+  }
+
+  // Returns the number of cascades.
+  int num_cascades() const {
+    return num_cascades_;
+  }
+
+  // Returns the view-space distance at which each cascade ends.
+  const std::vector<GLfloat>& cascade_splits() const {
+    return cascade_splits_;
+  }
+
+  // Returns, for every cascade, the matrix mapping world coordinates to the
+  // texture coordinates (and depth) of the cascade in the atlas. The
+  // cascades are side by side, so the shaders have to clamp the x
+  // coordinate to [i / n, (i + 1) / n] (minus half a texel) for cascade i of
+  // n; otherwise the filtering reads the neighboring cascade.
+  const std::vector<Eigen::Matrix4f>& cascade_texture_matrices() const {
+    return cascade_texture_matrices_;
+  }
+
+  // Returns the number of static cascade refreshes since initialization. This
+  // is useful to verify that the cache is effective.
+  int num_static_refreshes() const {
+    return num_static_refreshes_;
+  }
+
+ private:
+  // Shadow parameters of a single cascade.
+  struct Cascade {
+    // Light view and orthographic projection matrices.
+    Eigen::Matrix4f view;
+    Eigen::Matrix4f projection;
+    // Snapped center of the cascade in light coordinates and radius of the
+    // cascade bounds. Used to detect when the cached static cascade no longer
+    // covers the frustum slice.
+    Eigen::Vector3f snapped_center;
+    GLfloat radius;
+    // True when the static cascade has to be re-rendered.
+    bool dirty;
+  };
+
+  // Computes the cascade bounds for the slice [split_near, split_far] of the
+  // camera frustum, and flags the cascade dirty when they changed.
+  void FitCascade(const Camera& camera,
+                  const GLfloat split_near,
+                  const GLfloat split_far,
+                  Cascade* cascade);
+  // Renders the casters into a cascade of the currently bound atlas.
+  void RenderCasters(const int cascade_index,
+                     const std::vector<Model*>& casters);
+
+  int num_cascades_;
+  int cascade_resolution_;
+  // Direction of the light and the rotation from world to light coordinates.
+  Eigen::Vector3f light_direction_;
+  Eigen::Matrix3f light_rotation_;
+  // Cached atlas with the static casters only.
+  GLuint static_framebuffer_id_;
+  GLuint static_atlas_texture_id_;
+  // Per-frame copy of the static atlas with the dynamic casters on top.
+  GLuint dynamic_framebuffer_id_;
+  GLuint dynamic_atlas_texture_id_;
+  // True when the last Render() call had dynamic casters.
+  bool has_dynamic_casters_;
+  int num_static_refreshes_;
+  std::vector<Cascade> cascades_;
+  std::vector<GLfloat> cascade_splits_;
+  std::vector<Eigen::Matrix4f> cascade_texture_matrices_;
+  // Depth-only shader program passed to Model::Draw.
+  ShaderProgram depth_shader_program_;
+};
+
+}  // namespace wvu
+
+#endif  // SHADOW_MAPS_H_
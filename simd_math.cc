@@ -0,0 +1,645 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#include "simd_math.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+#include "frustum.h"
+#include "simd_math_kernels.h"
+
+namespace wvu {
+
+Mat4 ToMat4(const Eigen::Matrix4f& matrix) {
+  Mat4 result;
+  std::memcpy(result.data, matrix.data(), sizeof(result.data));
+  return result;
+}
+
+Vec4 ToVec4(const Eigen::Vector4f& vector) {
+  Vec4 result;
+  std::memcpy(result.data, vector.data(), sizeof(result.data));
+  return result;
+}
+
+Quat ToQuat(const Eigen::Quaternionf& quaternion) {
+  Quat result;
+  std::memcpy(result.data, quaternion.coeffs().data(), sizeof(result.data));
+  return result;
+}
+
+Eigen::Matrix4f ToEigen(const Mat4& matrix) {
+  return Eigen::Map<const Eigen::Matrix4f>(matrix.data);
+}
+
+Eigen::Vector4f ToEigen(const Vec4& vector) {
+  return Eigen::Map<const Eigen::Vector4f>(vector.data);
+}
+
+Eigen::Quaternionf ToEigen(const Quat& quaternion) {
+  return Eigen::Quaternionf(quaternion.data);
+}
+
+namespace {
+
+// Scalar kernels.
+
+void MultiplyMat4Scalar(const Mat4& lhs, const Mat4& rhs, Mat4* product) {
+  for (int column = 0; column < 4; ++column) {
+    for (int row = 0; row < 4; ++row) {
+      float sum = 0.0f;
+      for (int k = 0; k < 4; ++k) {
+        sum += lhs.data[4 * k + row] * rhs.data[4 * column + k];
+      }
+      product->data[4 * column + row] = sum;
+    }
+  }
+}
+
+void MultiplyMat4BatchScalar(const Mat4* lhs,
+                             const Mat4* rhs,
+                             const int num_matrices,
+                             Mat4* products) {
+  for (int i = 0; i < num_matrices; ++i) {
+    MultiplyMat4Scalar(lhs[i], rhs[i], &products[i]);
+  }
+}
+
+void MultiplyMat4ByMat4BatchScalar(const Mat4& lhs,
+                                   const Mat4* rhs,
+                                   const int num_matrices,
+                                   Mat4* products) {
+  for (int i = 0; i < num_matrices; ++i) {
+    MultiplyMat4Scalar(lhs, rhs[i], &products[i]);
+  }
+}
+
+void InvertMat4BatchScalar(const Mat4* matrices,
+                           const int num_matrices,
+                           Mat4* inverses) {
+  for (int i = 0; i < num_matrices; ++i) {
+    InvertMat4Lanes(matrices[i].data, inverses[i].data);
+  }
+}
+
+void TransformPointBatchScalar(const Mat4& matrix,
+                               const Vec4* points,
+                               const int num_points,
+                               Vec4* transformed_points) {
+  for (int i = 0; i < num_points; ++i) {
+    for (int row = 0; row < 4; ++row) {
+      float sum = 0.0f;
+      for (int k = 0; k < 4; ++k) {
+        sum += matrix.data[4 * k + row] * points[i].data[k];
+      }
+      transformed_points[i].data[row] = sum;
+    }
+  }
+}
+
+void ExtractFrustumPlanesBatchScalar(const Mat4* view_projections,
+                                     const int num_matrices,
+                                     Vec4* planes) {
+  for (int i = 0; i < num_matrices; ++i) {
+    const float* m = view_projections[i].data;
+    Vec4* matrix_planes = planes + kNumFrustumPlanes * i;
+    // The planes are the sums and differences of the last row with the
+    // others (see ExtractFrustumPlanes).
+    for (int plane = 0; plane < kNumFrustumPlanes; ++plane) {
+      const int row = plane / 2;
+      const float sign = plane % 2 == 0 ? 1.0f : -1.0f;
+      for (int column = 0; column < 4; ++column) {
+        matrix_planes[plane].data[column] =
+            m[4 * column + 3] + sign * m[4 * column + row];
+      }
+      const float* n = matrix_planes[plane].data;
+      const float norm = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+      for (int column = 0; column < 4; ++column) {
+        matrix_planes[plane].data[column] /= norm;
+      }
+    }
+  }
+}
+
+void MultiplyQuatBatchScalar(const Quat* lhs,
+                             const Quat* rhs,
+                             const int num_quaternions,
+                             Quat* products) {
+  for (int i = 0; i < num_quaternions; ++i) {
+    MultiplyQuatLanes(lhs[i].data, rhs[i].data, products[i].data);
+  }
+}
+
+void QuatToMat4BatchScalar(const Quat* rotations,
+                           const int num_quaternions,
+                           Mat4* matrices) {
+  for (int i = 0; i < num_quaternions; ++i) {
+    QuatToMat4Lanes(rotations[i].data, matrices[i].data);
+  }
+}
+
+void NlerpQuatBatchScalar(const Quat* from,
+                          const Quat* to,
+                          const float* t,
+                          const int num_quaternions,
+                          Quat* interpolations) {
+  for (int i = 0; i < num_quaternions; ++i) {
+    NlerpQuatLanes(from[i].data, to[i].data, t[i], interpolations[i].data);
+  }
+}
+
+void SlerpQuatBatchScalar(const Quat* from,
+                          const Quat* to,
+                          const float* t,
+                          const int num_quaternions,
+                          Quat* interpolations) {
+  for (int i = 0; i < num_quaternions; ++i) {
+    SlerpQuatLanes(from[i].data, to[i].data, t[i], interpolations[i].data);
+  }
+}
+
+#if defined(__SSE2__)
+
+// SSE2 kernels. The matrix kernels combine the columns of the left factor
+// with the broadcast coefficients of the right one; the inverse and the
+// quaternion product work on 4 elements at once, one per lane.
+
+// A register of 4 lanes for the lane kernels of simd_math_kernels.h.
+struct Lanes4 {
+  Lanes4() {}
+  explicit Lanes4(const float value) : v(_mm_set1_ps(value)) {}
+  explicit Lanes4(const __m128 value) : v(value) {}
+  __m128 v;
+};
+
+inline Lanes4 operator+(const Lanes4& a, const Lanes4& b) {
+  return Lanes4(_mm_add_ps(a.v, b.v));
+}
+inline Lanes4 operator-(const Lanes4& a, const Lanes4& b) {
+  return Lanes4(_mm_sub_ps(a.v, b.v));
+}
+inline Lanes4 operator*(const Lanes4& a, const Lanes4& b) {
+  return Lanes4(_mm_mul_ps(a.v, b.v));
+}
+inline Lanes4 operator/(const Lanes4& a, const Lanes4& b) {
+  return Lanes4(_mm_div_ps(a.v, b.v));
+}
+inline Lanes4 Sqrt(const Lanes4& a) {
+  return Lanes4(_mm_sqrt_ps(a.v));
+}
+inline Lanes4 Sign(const Lanes4& a) {
+  const __m128 sign_bit = _mm_set1_ps(-0.0f);
+  return Lanes4(_mm_or_ps(_mm_set1_ps(1.0f), _mm_and_ps(a.v, sign_bit)));
+}
+
+// Returns the linear combination of the columns with the coefficients of a
+// vector, i.e., the product of the matrix with the vector.
+inline __m128 CombineColumns(const __m128 columns[4], const float* vector) {
+  const __m128 x = _mm_mul_ps(columns[0], _mm_set1_ps(vector[0]));
+  const __m128 y = _mm_mul_ps(columns[1], _mm_set1_ps(vector[1]));
+  const __m128 z = _mm_mul_ps(columns[2], _mm_set1_ps(vector[2]));
+  const __m128 w = _mm_mul_ps(columns[3], _mm_set1_ps(vector[3]));
+  return _mm_add_ps(_mm_add_ps(x, y), _mm_add_ps(z, w));
+}
+
+inline void LoadColumns(const Mat4& matrix, __m128 columns[4]) {
+  for (int i = 0; i < 4; ++i) {
+    columns[i] = _mm_loadu_ps(matrix.data + 4 * i);
+  }
+}
+
+void MultiplyMat4BatchSse2(const Mat4* lhs,
+                           const Mat4* rhs,
+                           const int num_matrices,
+                           Mat4* products) {
+  __m128 columns[4];
+  for (int i = 0; i < num_matrices; ++i) {
+    LoadColumns(lhs[i], columns);
+    for (int column = 0; column < 4; ++column) {
+      _mm_storeu_ps(products[i].data + 4 * column,
+                    CombineColumns(columns, rhs[i].data + 4 * column));
+    }
+  }
+}
+
+void MultiplyMat4ByMat4BatchSse2(const Mat4& lhs,
+                                 const Mat4* rhs,
+                                 const int num_matrices,
+                                 Mat4* products) {
+  __m128 columns[4];
+  LoadColumns(lhs, columns);
+  for (int i = 0; i < num_matrices; ++i) {
+    for (int column = 0; column < 4; ++column) {
+      _mm_storeu_ps(products[i].data + 4 * column,
+                    CombineColumns(columns, rhs[i].data + 4 * column));
+    }
+  }
+}
+
+// Loads 4 matrices with one matrix per lane: the lanes of elements[k] hold
+// the coefficient k of the matrices.
+inline void LoadMat4Lanes(const Mat4* matrices, Lanes4 elements[16]) {
+  for (int column = 0; column < 4; ++column) {
+    __m128 rows[4];
+    for (int i = 0; i < 4; ++i) {
+      rows[i] = _mm_loadu_ps(matrices[i].data + 4 * column);
+    }
+    _MM_TRANSPOSE4_PS(rows[0], rows[1], rows[2], rows[3]);
+    for (int i = 0; i < 4; ++i) {
+      elements[4 * column + i].v = rows[i];
+    }
+  }
+}
+
+inline void StoreMat4Lanes(const Lanes4 elements[16], Mat4* matrices) {
+  for (int column = 0; column < 4; ++column) {
+    __m128 rows[4];
+    for (int i = 0; i < 4; ++i) {
+      rows[i] = elements[4 * column + i].v;
+    }
+    _MM_TRANSPOSE4_PS(rows[0], rows[1], rows[2], rows[3]);
+    for (int i = 0; i < 4; ++i) {
+      _mm_storeu_ps(matrices[i].data + 4 * column, rows[i]);
+    }
+  }
+}
+
+void InvertMat4BatchSse2(const Mat4* matrices,
+                         const int num_matrices,
+                         Mat4* inverses) {
+  Lanes4 elements[16];
+  Lanes4 inverse_elements[16];
+  int i = 0;
+  for (; i + 4 <= num_matrices; i += 4) {
+    LoadMat4Lanes(matrices + i, elements);
+    InvertMat4Lanes(elements, inverse_elements);
+    StoreMat4Lanes(inverse_elements, inverses + i);
+  }
+  InvertMat4BatchScalar(matrices + i, num_matrices - i, inverses + i);
+}
+
+void TransformPointBatchSse2(const Mat4& matrix,
+                             const Vec4* points,
+                             const int num_points,
+                             Vec4* transformed_points) {
+  __m128 columns[4];
+  LoadColumns(matrix, columns);
+  for (int i = 0; i < num_points; ++i) {
+    _mm_storeu_ps(transformed_points[i].data,
+                  CombineColumns(columns, points[i].data));
+  }
+}
+
+// Divides 4 planes by the norms of their normals.
+inline void NormalizePlanes(__m128 planes[4]) {
+  __m128 squares[4];
+  for (int i = 0; i < 4; ++i) {
+    squares[i] = _mm_mul_ps(planes[i], planes[i]);
+  }
+  _MM_TRANSPOSE4_PS(squares[0], squares[1], squares[2], squares[3]);
+  const __m128 inverse_norms = _mm_div_ps(
+      _mm_set1_ps(1.0f),
+      _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(squares[0], squares[1]),
+                             squares[2])));
+  planes[0] = _mm_mul_ps(planes[0], _mm_shuffle_ps(
+      inverse_norms, inverse_norms, _MM_SHUFFLE(0, 0, 0, 0)));
+  planes[1] = _mm_mul_ps(planes[1], _mm_shuffle_ps(
+      inverse_norms, inverse_norms, _MM_SHUFFLE(1, 1, 1, 1)));
+  planes[2] = _mm_mul_ps(planes[2], _mm_shuffle_ps(
+      inverse_norms, inverse_norms, _MM_SHUFFLE(2, 2, 2, 2)));
+  planes[3] = _mm_mul_ps(planes[3], _mm_shuffle_ps(
+      inverse_norms, inverse_norms, _MM_SHUFFLE(3, 3, 3, 3)));
+}
+
+void ExtractFrustumPlanesBatchSse2(const Mat4* view_projections,
+                                   const int num_matrices,
+                                   Vec4* planes) {
+  for (int i = 0; i < num_matrices; ++i) {
+    __m128 rows[4];
+    LoadColumns(view_projections[i], rows);
+    _MM_TRANSPOSE4_PS(rows[0], rows[1], rows[2], rows[3]);
+    // Left, right, bottom, top, and near, far twice to fill the registers.
+    __m128 side_planes[4] = {
+      _mm_add_ps(rows[3], rows[0]), _mm_sub_ps(rows[3], rows[0]),
+      _mm_add_ps(rows[3], rows[1]), _mm_sub_ps(rows[3], rows[1])};
+    __m128 depth_planes[4] = {
+      _mm_add_ps(rows[3], rows[2]), _mm_sub_ps(rows[3], rows[2]),
+      _mm_add_ps(rows[3], rows[2]), _mm_sub_ps(rows[3], rows[2])};
+    NormalizePlanes(side_planes);
+    NormalizePlanes(depth_planes);
+    Vec4* matrix_planes = planes + kNumFrustumPlanes * i;
+    for (int plane = 0; plane < 4; ++plane) {
+      _mm_storeu_ps(matrix_planes[plane].data, side_planes[plane]);
+    }
+    _mm_storeu_ps(matrix_planes[4].data, depth_planes[0]);
+    _mm_storeu_ps(matrix_planes[5].data, depth_planes[1]);
+  }
+}
+
+// Loads 4 quaternions with one quaternion per lane.
+inline void LoadQuatLanes(const Quat* quaternions, Lanes4 coefficients[4]) {
+  __m128 rows[4];
+  for (int i = 0; i < 4; ++i) {
+    rows[i] = _mm_loadu_ps(quaternions[i].data);
+  }
+  _MM_TRANSPOSE4_PS(rows[0], rows[1], rows[2], rows[3]);
+  for (int i = 0; i < 4; ++i) {
+    coefficients[i].v = rows[i];
+  }
+}
+
+inline void StoreQuatLanes(const Lanes4 coefficients[4], Quat* quaternions) {
+  __m128 rows[4];
+  for (int i = 0; i < 4; ++i) {
+    rows[i] = coefficients[i].v;
+  }
+  _MM_TRANSPOSE4_PS(rows[0], rows[1], rows[2], rows[3]);
+  for (int i = 0; i < 4; ++i) {
+    _mm_storeu_ps(quaternions[i].data, rows[i]);
+  }
+}
+
+void MultiplyQuatBatchSse2(const Quat* lhs,
+                           const Quat* rhs,
+                           const int num_quaternions,
+                           Quat* products) {
+  Lanes4 lhs_lanes[4], rhs_lanes[4], product_lanes[4];
+  int i = 0;
+  for (; i + 4 <= num_quaternions; i += 4) {
+    LoadQuatLanes(lhs + i, lhs_lanes);
+    LoadQuatLanes(rhs + i, rhs_lanes);
+    MultiplyQuatLanes(lhs_lanes, rhs_lanes, product_lanes);
+    StoreQuatLanes(product_lanes, products + i);
+  }
+  MultiplyQuatBatchScalar(lhs + i, rhs + i, num_quaternions - i,
+                          products + i);
+}
+
+void QuatToMat4BatchSse2(const Quat* rotations,
+                         const int num_quaternions,
+                         Mat4* matrices) {
+  Lanes4 rotation_lanes[4], matrix_lanes[16];
+  int i = 0;
+  for (; i + 4 <= num_quaternions; i += 4) {
+    LoadQuatLanes(rotations + i, rotation_lanes);
+    QuatToMat4Lanes(rotation_lanes, matrix_lanes);
+    StoreMat4Lanes(matrix_lanes, matrices + i);
+  }
+  QuatToMat4BatchScalar(rotations + i, num_quaternions - i, matrices + i);
+}
+
+void NlerpQuatBatchSse2(const Quat* from,
+                        const Quat* to,
+                        const float* t,
+                        const int num_quaternions,
+                        Quat* interpolations) {
+  Lanes4 from_lanes[4], to_lanes[4], interpolation_lanes[4];
+  int i = 0;
+  for (; i + 4 <= num_quaternions; i += 4) {
+    LoadQuatLanes(from + i, from_lanes);
+    LoadQuatLanes(to + i, to_lanes);
+    NlerpQuatLanes(from_lanes, to_lanes, Lanes4(_mm_loadu_ps(t + i)),
+                   interpolation_lanes);
+    StoreQuatLanes(interpolation_lanes, interpolations + i);
+  }
+  NlerpQuatBatchScalar(from + i, to + i, t + i, num_quaternions - i,
+                       interpolations + i);
+}
+
+void SlerpQuatBatchSse2(const Quat* from,
+                        const Quat* to,
+                        const float* t,
+                        const int num_quaternions,
+                        Quat* interpolations) {
+  Lanes4 from_lanes[4], to_lanes[4], interpolation_lanes[4];
+  int i = 0;
+  for (; i + 4 <= num_quaternions; i += 4) {
+    LoadQuatLanes(from + i, from_lanes);
+    LoadQuatLanes(to + i, to_lanes);
+    SlerpQuatLanes(from_lanes, to_lanes, Lanes4(_mm_loadu_ps(t + i)),
+                   interpolation_lanes);
+    StoreQuatLanes(interpolation_lanes, interpolations + i);
+  }
+  SlerpQuatBatchScalar(from + i, to + i, t + i, num_quaternions - i,
+                       interpolations + i);
+}
+
+#endif  // __SSE2__
+
+const SimdMathKernels kScalarKernels = {
+  MultiplyMat4BatchScalar,
+  MultiplyMat4ByMat4BatchScalar,
+  InvertMat4BatchScalar,
+  TransformPointBatchScalar,
+  ExtractFrustumPlanesBatchScalar,
+  MultiplyQuatBatchScalar,
+  QuatToMat4BatchScalar,
+  NlerpQuatBatchScalar,
+  SlerpQuatBatchScalar
+};
+
+#if defined(__SSE2__)
+const SimdMathKernels kSse2Kernels = {
+  MultiplyMat4BatchSse2,
+  MultiplyMat4ByMat4BatchSse2,
+  InvertMat4BatchSse2,
+  TransformPointBatchSse2,
+  ExtractFrustumPlanesBatchSse2,
+  MultiplyQuatBatchSse2,
+  QuatToMat4BatchSse2,
+  NlerpQuatBatchSse2,
+  SlerpQuatBatchSse2
+};
+#endif
+
+// The AVX2/FMA kernels, or nullptr when the build has none.
+const SimdMathKernels* GetAvx2FmaKernels() {
+#if defined(__SSE2__)
+  static const SimdMathKernels* avx2_fma_kernels = []() {
+    static SimdMathKernels kernels = kSse2Kernels;
+    return SetAvx2FmaKernels(&kernels) ? &kernels : nullptr;
+  }();
+  return avx2_fma_kernels;
+#else
+  return nullptr;
+#endif
+}
+
+const SimdMathKernels* GetKernels(const SimdIsa isa) {
+  switch (isa) {
+    case SimdIsa::SCALAR:
+      return &kScalarKernels;
+    case SimdIsa::SSE2:
+#if defined(__SSE2__)
+      return &kSse2Kernels;
+#else
+      return nullptr;
+#endif
+    case SimdIsa::AVX2_FMA:
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+      if (!__builtin_cpu_supports("avx2") || !__builtin_cpu_supports("fma")) {
+        return nullptr;
+      }
+      return GetAvx2FmaKernels();
+#else
+      return nullptr;
+#endif
+  }
+  return nullptr;
+}
+
+const SimdMathKernels* GetBestKernels() {
+  for (const SimdIsa isa : {SimdIsa::AVX2_FMA, SimdIsa::SSE2}) {
+    const SimdMathKernels* kernels = GetKernels(isa);
+    if (kernels != nullptr) return kernels;
+  }
+  return &kScalarKernels;
+}
+
+// The selected kernels. They are selected on first use, so that the
+// functions can be called from static initializers.
+std::atomic<const SimdMathKernels*> selected_kernels(nullptr);
+
+const SimdMathKernels& Kernels() {
+  const SimdMathKernels* kernels =
+      selected_kernels.load(std::memory_order_relaxed);
+  if (kernels == nullptr) {
+    const SimdMathKernels* best_kernels = GetBestKernels();
+    // Keeps the kernels of a concurrent SetSimdIsa().
+    selected_kernels.compare_exchange_strong(kernels, best_kernels);
+    kernels = selected_kernels.load(std::memory_order_relaxed);
+  }
+  return *kernels;
+}
+
+}  // namespace
+
+const char* GetSimdIsaName(const SimdIsa isa) {
+  switch (isa) {
+    case SimdIsa::SCALAR: return "scalar";
+    case SimdIsa::SSE2: return "sse2";
+    case SimdIsa::AVX2_FMA: return "avx2_fma";
+  }
+  return "";
+}
+
+bool IsSimdIsaSupported(const SimdIsa isa) {
+  return GetKernels(isa) != nullptr;
+}
+
+SimdIsa GetSimdIsa() {
+  const SimdMathKernels* kernels = &Kernels();
+  for (const SimdIsa isa : {SimdIsa::AVX2_FMA, SimdIsa::SSE2}) {
+    if (kernels == GetKernels(isa)) return isa;
+  }
+  return SimdIsa::SCALAR;
+}
+
+bool SetSimdIsa(const SimdIsa isa) {
+  const SimdMathKernels* kernels = GetKernels(isa);
+  if (kernels == nullptr) return false;
+  selected_kernels.store(kernels, std::memory_order_relaxed);
+  return true;
+}
+
+void MultiplyMat4Batch(const Mat4* lhs,
+                       const Mat4* rhs,
+                       const int num_matrices,
+                       Mat4* products) {
+  Kernels().multiply_mat4(lhs, rhs, num_matrices, products);
+}
+
+void MultiplyMat4Batch(const Mat4& lhs,
+                       const Mat4* rhs,
+                       const int num_matrices,
+                       Mat4* products) {
+  Kernels().multiply_mat4_by_mat4(lhs, rhs, num_matrices, products);
+}
+
+void InvertMat4Batch(const Mat4* matrices,
+                     const int num_matrices,
+                     Mat4* inverses) {
+  Kernels().invert_mat4(matrices, num_matrices, inverses);
+}
+
+void TransformPointBatch(const Mat4& matrix,
+                         const Vec4* points,
+                         const int num_points,
+                         Vec4* transformed_points) {
+  Kernels().transform_point(matrix, points, num_points, transformed_points);
+}
+
+void ExtractFrustumPlanesBatch(const Mat4* view_projections,
+                               const int num_matrices,
+                               Vec4* planes) {
+  Kernels().extract_frustum_planes(view_projections, num_matrices, planes);
+}
+
+void MultiplyQuatBatch(const Quat* lhs,
+                       const Quat* rhs,
+                       const int num_quaternions,
+                       Quat* products) {
+  Kernels().multiply_quat(lhs, rhs, num_quaternions, products);
+}
+
+void QuatToMat4Batch(const Quat* rotations,
+                     const int num_quaternions,
+                     Mat4* matrices) {
+  Kernels().quat_to_mat4(rotations, num_quaternions, matrices);
+}
+
+void NlerpQuatBatch(const Quat* from,
+                    const Quat* to,
+                    const float* t,
+                    const int num_quaternions,
+                    Quat* interpolations) {
+  Kernels().nlerp_quat(from, to, t, num_quaternions, interpolations);
+}
+
+void SlerpQuatBatch(const Quat* from,
+                    const Quat* to,
+                    const float* t,
+                    const int num_quaternions,
+                    Quat* interpolations) {
+  Kernels().slerp_quat(from, to, t, num_quaternions, interpolations);
+}
+
+}  // namespace wvu
@@ -0,0 +1,213 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef SIMD_MATH_H_
+#define SIMD_MATH_H_
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+#include "frustum.h"
+
+namespace wvu {
+
+// The types of the SIMD math functions. They are plain arrays with the memory
+// layout of their Eigen counterparts, so arrays of them can also be viewed
+// through Eigen::Map, e.g.,
+//   Eigen::Map<Eigen::Matrix4f>(matrices[i].data).
+// A 4x4 matrix stored in column-major order like Eigen::Matrix4f, i.e.,
+// data[4 * column + row].
+struct alignas(16) Mat4 {
+  float data[16];
+};
+
+// A 4D vector, e.g., a point (x, y, z, 1) or a plane (n, d).
+struct alignas(16) Vec4 {
+  float data[4];
+};
+
+// A quaternion stored as (x, y, z, w) with w the real part, the storage order
+// of Eigen::Quaternionf.
+struct alignas(16) Quat {
+  float data[4];
+};
+
+// Conversions from and to the Eigen types at the API boundaries.
+Mat4 ToMat4(const Eigen::Matrix4f& matrix);
+Vec4 ToVec4(const Eigen::Vector4f& vector);
+Quat ToQuat(const Eigen::Quaternionf& quaternion);
+Eigen::Matrix4f ToEigen(const Mat4& matrix);
+Eigen::Vector4f ToEigen(const Vec4& vector);
+Eigen::Quaternionf ToEigen(const Quat& quaternion);
+
+// The instruction sets the functions below are implemented with.
+enum struct SimdIsa {
+  // Plain C++, for the CPUs without the instructions below.
+  SCALAR = 0,
+  // The baseline of x86-64.
+  SSE2 = 1,
+  // 256-bit AVX2 with fused multiply-adds (Haswell and later). This variant
+  // is compiled separately with -mavx2 -mfma and only called after checking
+  // the CPU, so the binaries still run on SSE2-only CPUs.
+  AVX2_FMA = 2
+};
+
+// Returns the name of the instruction set, e.g., for logging.
+const char* GetSimdIsaName(const SimdIsa isa);
+
+// Returns true when the CPU and the build support the instruction set.
+bool IsSimdIsaSupported(const SimdIsa isa);
+
+// Returns the instruction set of the functions below. It defaults to the best
+// one supported.
+SimdIsa GetSimdIsa();
+
+// Selects the instruction set of the functions below, e.g., to compare the
+// variants. Returns false, and keeps the current one, when it is not
+// supported.
+bool SetSimdIsa(const SimdIsa isa);
+
+// The functions below process arrays and are dispatched at runtime to the
+// selected instruction set. The outputs must not alias the inputs.
+
+// Computes products[i] = lhs[i] * rhs[i].
+// Params:
+//   lhs  The left factors.
+//   rhs  The right factors.
+//   num_matrices  The number of products.
+//   products  The products.
+void MultiplyMat4Batch(const Mat4* lhs,
+                       const Mat4* rhs,
+                       const int num_matrices,
+                       Mat4* products);
+
+// Computes products[i] = lhs * rhs[i], e.g., the model-view-projection
+// matrices of a set of models.
+// Params:
+//   lhs  The common left factor.
+//   rhs  The right factors.
+//   num_matrices  The number of products.
+//   products  The products.
+void MultiplyMat4Batch(const Mat4& lhs,
+                       const Mat4* rhs,
+                       const int num_matrices,
+                       Mat4* products);
+
+// Computes the inverses of general matrices with their cofactors. The
+// inverses of singular matrices are not finite.
+// Params:
+//   matrices  The matrices.
+//   num_matrices  The number of matrices.
+//   inverses  The inverses.
+void InvertMat4Batch(const Mat4* matrices,
+                     const int num_matrices,
+                     Mat4* inverses);
+
+// Computes transformed_points[i] = matrix * points[i]. The points are
+// homogeneous: no division by w is done.
+// Params:
+//   matrix  The transformation.
+//   points  The points.
+//   num_points  The number of points.
+//   transformed_points  The transformed points.
+void TransformPointBatch(const Mat4& matrix,
+                         const Vec4* points,
+                         const int num_points,
+                         Vec4* transformed_points);
+
+// Extracts the frustum planes of view-projection matrices, e.g., of the
+// cascades of a shadow map. The planes are the ones of ExtractFrustumPlanes
+// (see frustum.h), in the same order.
+// Params:
+//   view_projections  The products projection * view.
+//   num_matrices  The number of matrices.
+//   planes  kNumFrustumPlanes planes per matrix.
+void ExtractFrustumPlanesBatch(const Mat4* view_projections,
+                               const int num_matrices,
+                               Vec4* planes);
+
+// Computes products[i] = lhs[i] * rhs[i], i.e., the rotation rhs[i] followed
+// by lhs[i].
+// Params:
+//   lhs  The left factors.
+//   rhs  The right factors.
+//   num_quaternions  The number of products.
+//   products  The products.
+void MultiplyQuatBatch(const Quat* lhs,
+                       const Quat* rhs,
+                       const int num_quaternions,
+                       Quat* products);
+
+// Computes the rotation matrices of unit quaternions. The translations of
+// the matrices are zero.
+// Params:
+//   rotations  The unit quaternions.
+//   num_quaternions  The number of quaternions.
+//   matrices  The rotation matrices.
+void QuatToMat4Batch(const Quat* rotations,
+                     const int num_quaternions,
+                     Mat4* matrices);
+
+// Computes Nlerp(from[i], to[i], t[i]) (see transformations.h).
+// Params:
+//   from  The unit quaternions for t = 0.
+//   to  The unit quaternions for t = 1.
+//   t  The interpolation parameters in [0, 1].
+//   num_quaternions  The number of interpolations.
+//   interpolations  The interpolated unit quaternions.
+void NlerpQuatBatch(const Quat* from,
+                    const Quat* to,
+                    const float* t,
+                    const int num_quaternions,
+                    Quat* interpolations);
+
+// Computes Slerp(from[i], to[i], t[i]) (see transformations.h) without any
+// trigonometric function: the weights of the quaternions are polynomials of
+// their dot product and of t (D. Eberly, "A fast and accurate algorithm for
+// computing SLERP"). Their error is below 1e-6.
+// Params:
+//   from  The unit quaternions for t = 0.
+//   to  The unit quaternions for t = 1.
+//   t  The interpolation parameters in [0, 1].
+//   num_quaternions  The number of interpolations.
+//   interpolations  The interpolated unit quaternions.
+void SlerpQuatBatch(const Quat* from,
+                    const Quat* to,
+                    const float* t,
+                    const int num_quaternions,
+                    Quat* interpolations);
+
+}  // namespace wvu
+
+#endif  // SIMD_MATH_H_
@@ -0,0 +1,315 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+// The AVX2/FMA variants of the kernels of simd_math.h. This file is compiled
+// with -mavx2 -mfma (see CMakeLists.txt), and its kernels are only called
+// after simd_math.cc checked the CPU. Nothing here may be shared with the
+// other translation units: every function has internal linkage, and the
+// kernels delegate the remainders of the batches to the SSE2 ones.
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#endif
+
+#include "simd_math_kernels.h"
+
+namespace wvu {
+
+#if defined(__AVX2__) && defined(__FMA__)
+
+namespace {
+
+// The kernels the remainders are delegated to.
+SimdMathKernels fallback_kernels;
+
+// A register of 8 lanes for the lane kernels of simd_math_kernels.h.
+struct Lanes8 {
+  Lanes8() {}
+  explicit Lanes8(const float value) : v(_mm256_set1_ps(value)) {}
+  explicit Lanes8(const __m256 value) : v(value) {}
+  __m256 v;
+};
+
+inline Lanes8 operator+(const Lanes8& a, const Lanes8& b) {
+  return Lanes8(_mm256_add_ps(a.v, b.v));
+}
+inline Lanes8 operator-(const Lanes8& a, const Lanes8& b) {
+  return Lanes8(_mm256_sub_ps(a.v, b.v));
+}
+inline Lanes8 operator*(const Lanes8& a, const Lanes8& b) {
+  return Lanes8(_mm256_mul_ps(a.v, b.v));
+}
+inline Lanes8 operator/(const Lanes8& a, const Lanes8& b) {
+  return Lanes8(_mm256_div_ps(a.v, b.v));
+}
+inline Lanes8 Sqrt(const Lanes8& a) {
+  return Lanes8(_mm256_sqrt_ps(a.v));
+}
+inline Lanes8 Sign(const Lanes8& a) {
+  const __m256 sign_bit = _mm256_set1_ps(-0.0f);
+  return Lanes8(
+      _mm256_or_ps(_mm256_set1_ps(1.0f), _mm256_and_ps(a.v, sign_bit)));
+}
+
+// Loads the columns of a matrix into both halves of the registers.
+inline void LoadColumnPairs(const Mat4& matrix, __m256 columns[4]) {
+  for (int i = 0; i < 4; ++i) {
+    columns[i] = _mm256_broadcast_ps(
+        reinterpret_cast<const __m128*>(matrix.data + 4 * i));
+  }
+}
+
+// Returns the products of the matrix with the two vectors of the halves of
+// a register.
+inline __m256 CombineColumnPairs(const __m256 columns[4],
+                                 const __m256 vectors) {
+  __m256 result = _mm256_mul_ps(
+      columns[3], _mm256_permute_ps(vectors, _MM_SHUFFLE(3, 3, 3, 3)));
+  result = _mm256_fmadd_ps(
+      columns[2], _mm256_permute_ps(vectors, _MM_SHUFFLE(2, 2, 2, 2)),
+      result);
+  result = _mm256_fmadd_ps(
+      columns[1], _mm256_permute_ps(vectors, _MM_SHUFFLE(1, 1, 1, 1)),
+      result);
+  return _mm256_fmadd_ps(
+      columns[0], _mm256_permute_ps(vectors, _MM_SHUFFLE(0, 0, 0, 0)),
+      result);
+}
+
+void MultiplyMat4BatchAvx2(const Mat4* lhs,
+                           const Mat4* rhs,
+                           const int num_matrices,
+                           Mat4* products) {
+  __m256 columns[4];
+  for (int i = 0; i < num_matrices; ++i) {
+    LoadColumnPairs(lhs[i], columns);
+    for (int column = 0; column < 4; column += 2) {
+      _mm256_storeu_ps(
+          products[i].data + 4 * column,
+          CombineColumnPairs(columns,
+                             _mm256_loadu_ps(rhs[i].data + 4 * column)));
+    }
+  }
+}
+
+void MultiplyMat4ByMat4BatchAvx2(const Mat4& lhs,
+                                 const Mat4* rhs,
+                                 const int num_matrices,
+                                 Mat4* products) {
+  __m256 columns[4];
+  LoadColumnPairs(lhs, columns);
+  for (int i = 0; i < num_matrices; ++i) {
+    for (int column = 0; column < 4; column += 2) {
+      _mm256_storeu_ps(
+          products[i].data + 4 * column,
+          CombineColumnPairs(columns,
+                             _mm256_loadu_ps(rhs[i].data + 4 * column)));
+    }
+  }
+}
+
+// Transposes the columns of 4 matrices: rows[k] holds the coefficient k of
+// the column of every matrix.
+inline void Transpose4(__m128 rows[4]) {
+  _MM_TRANSPOSE4_PS(rows[0], rows[1], rows[2], rows[3]);
+}
+
+// Loads 8 matrices with one matrix per lane: the lanes of elements[k] hold
+// the coefficient k of the matrices.
+inline void LoadMat4Lanes(const Mat4* matrices, Lanes8 elements[16]) {
+  for (int column = 0; column < 4; ++column) {
+    __m128 low[4], high[4];
+    for (int i = 0; i < 4; ++i) {
+      low[i] = _mm_loadu_ps(matrices[i].data + 4 * column);
+      high[i] = _mm_loadu_ps(matrices[i + 4].data + 4 * column);
+    }
+    Transpose4(low);
+    Transpose4(high);
+    for (int i = 0; i < 4; ++i) {
+      elements[4 * column + i].v =
+          _mm256_insertf128_ps(_mm256_castps128_ps256(low[i]), high[i], 1);
+    }
+  }
+}
+
+inline void StoreMat4Lanes(const Lanes8 elements[16], Mat4* matrices) {
+  for (int column = 0; column < 4; ++column) {
+    __m128 low[4], high[4];
+    for (int i = 0; i < 4; ++i) {
+      low[i] = _mm256_castps256_ps128(elements[4 * column + i].v);
+      high[i] = _mm256_extractf128_ps(elements[4 * column + i].v, 1);
+    }
+    Transpose4(low);
+    Transpose4(high);
+    for (int i = 0; i < 4; ++i) {
+      _mm_storeu_ps(matrices[i].data + 4 * column, low[i]);
+      _mm_storeu_ps(matrices[i + 4].data + 4 * column, high[i]);
+    }
+  }
+}
+
+void InvertMat4BatchAvx2(const Mat4* matrices,
+                         const int num_matrices,
+                         Mat4* inverses) {
+  Lanes8 elements[16];
+  Lanes8 inverse_elements[16];
+  int i = 0;
+  for (; i + 8 <= num_matrices; i += 8) {
+    LoadMat4Lanes(matrices + i, elements);
+    InvertMat4Lanes(elements, inverse_elements);
+    StoreMat4Lanes(inverse_elements, inverses + i);
+  }
+  fallback_kernels.invert_mat4(matrices + i, num_matrices - i, inverses + i);
+}
+
+void TransformPointBatchAvx2(const Mat4& matrix,
+                             const Vec4* points,
+                             const int num_points,
+                             Vec4* transformed_points) {
+  __m256 columns[4];
+  LoadColumnPairs(matrix, columns);
+  int i = 0;
+  for (; i + 2 <= num_points; i += 2) {
+    // The points are contiguous: two of them fill a register.
+    _mm256_storeu_ps(
+        transformed_points[i].data,
+        CombineColumnPairs(columns, _mm256_loadu_ps(points[i].data)));
+  }
+  fallback_kernels.transform_point(matrix, points + i, num_points - i,
+                                   transformed_points + i);
+}
+
+// Loads 8 quaternions with one quaternion per lane.
+inline void LoadQuatLanes(const Quat* quaternions, Lanes8 coefficients[4]) {
+  __m128 low[4], high[4];
+  for (int i = 0; i < 4; ++i) {
+    low[i] = _mm_loadu_ps(quaternions[i].data);
+    high[i] = _mm_loadu_ps(quaternions[i + 4].data);
+  }
+  Transpose4(low);
+  Transpose4(high);
+  for (int i = 0; i < 4; ++i) {
+    coefficients[i].v =
+        _mm256_insertf128_ps(_mm256_castps128_ps256(low[i]), high[i], 1);
+  }
+}
+
+inline void StoreQuatLanes(const Lanes8 coefficients[4], Quat* quaternions) {
+  __m128 low[4], high[4];
+  for (int i = 0; i < 4; ++i) {
+    low[i] = _mm256_castps256_ps128(coefficients[i].v);
+    high[i] = _mm256_extractf128_ps(coefficients[i].v, 1);
+  }
+  Transpose4(low);
+  Transpose4(high);
+  for (int i = 0; i < 4; ++i) {
+    _mm_storeu_ps(quaternions[i].data, low[i]);
+    _mm_storeu_ps(quaternions[i + 4].data, high[i]);
+  }
+}
+
+void QuatToMat4BatchAvx2(const Quat* rotations,
+                         const int num_quaternions,
+                         Mat4* matrices) {
+  Lanes8 rotation_lanes[4], matrix_lanes[16];
+  int i = 0;
+  for (; i + 8 <= num_quaternions; i += 8) {
+    LoadQuatLanes(rotations + i, rotation_lanes);
+    QuatToMat4Lanes(rotation_lanes, matrix_lanes);
+    StoreMat4Lanes(matrix_lanes, matrices + i);
+  }
+  fallback_kernels.quat_to_mat4(rotations + i, num_quaternions - i,
+                                matrices + i);
+}
+
+void NlerpQuatBatchAvx2(const Quat* from,
+                        const Quat* to,
+                        const float* t,
+                        const int num_quaternions,
+                        Quat* interpolations) {
+  Lanes8 from_lanes[4], to_lanes[4], interpolation_lanes[4];
+  int i = 0;
+  for (; i + 8 <= num_quaternions; i += 8) {
+    LoadQuatLanes(from + i, from_lanes);
+    LoadQuatLanes(to + i, to_lanes);
+    NlerpQuatLanes(from_lanes, to_lanes, Lanes8(_mm256_loadu_ps(t + i)),
+                   interpolation_lanes);
+    StoreQuatLanes(interpolation_lanes, interpolations + i);
+  }
+  fallback_kernels.nlerp_quat(from + i, to + i, t + i, num_quaternions - i,
+                              interpolations + i);
+}
+
+void SlerpQuatBatchAvx2(const Quat* from,
+                        const Quat* to,
+                        const float* t,
+                        const int num_quaternions,
+                        Quat* interpolations) {
+  Lanes8 from_lanes[4], to_lanes[4], interpolation_lanes[4];
+  int i = 0;
+  for (; i + 8 <= num_quaternions; i += 8) {
+    LoadQuatLanes(from + i, from_lanes);
+    LoadQuatLanes(to + i, to_lanes);
+    SlerpQuatLanes(from_lanes, to_lanes, Lanes8(_mm256_loadu_ps(t + i)),
+                   interpolation_lanes);
+    StoreQuatLanes(interpolation_lanes, interpolations + i);
+  }
+  fallback_kernels.slerp_quat(from + i, to + i, t + i, num_quaternions - i,
+                              interpolations + i);
+}
+
+}  // namespace
+
+bool SetAvx2FmaKernels(SimdMathKernels* kernels) {
+  fallback_kernels = *kernels;
+  kernels->multiply_mat4 = MultiplyMat4BatchAvx2;
+  kernels->multiply_mat4_by_mat4 = MultiplyMat4ByMat4BatchAvx2;
+  kernels->invert_mat4 = InvertMat4BatchAvx2;
+  kernels->transform_point = TransformPointBatchAvx2;
+  kernels->quat_to_mat4 = QuatToMat4BatchAvx2;
+  kernels->nlerp_quat = NlerpQuatBatchAvx2;
+  kernels->slerp_quat = SlerpQuatBatchAvx2;
+  return true;
+}
+
+#else
+
+// The build has no AVX2/FMA, e.g., on other architectures.
+bool SetAvx2FmaKernels(SimdMathKernels* /* kernels */) {
+  return false;
+}
+
+#endif  // __AVX2__ && __FMA__
+
+}  // namespace wvu
@@ -0,0 +1,270 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef SIMD_MATH_KERNELS_H_
+#define SIMD_MATH_KERNELS_H_
+
+// The kernels behind the dispatch of simd_math.h. Only simd_math.cc and the
+// translation units of the instruction sets (e.g., simd_math_avx2.cc)
+// include this header.
+
+#include <cmath>
+
+#include "simd_math.h"
+
+namespace wvu {
+
+// The implementations of the functions of simd_math.h for an instruction
+// set.
+struct SimdMathKernels {
+  void (*multiply_mat4)(const Mat4* lhs, const Mat4* rhs,
+                        const int num_matrices, Mat4* products);
+  void (*multiply_mat4_by_mat4)(const Mat4& lhs, const Mat4* rhs,
+                                const int num_matrices, Mat4* products);
+  void (*invert_mat4)(const Mat4* matrices, const int num_matrices,
+                      Mat4* inverses);
+  void (*transform_point)(const Mat4& matrix, const Vec4* points,
+                          const int num_points, Vec4* transformed_points);
+  void (*extract_frustum_planes)(const Mat4* view_projections,
+                                 const int num_matrices, Vec4* planes);
+  void (*multiply_quat)(const Quat* lhs, const Quat* rhs,
+                        const int num_quaternions, Quat* products);
+  void (*quat_to_mat4)(const Quat* rotations, const int num_quaternions,
+                       Mat4* matrices);
+  void (*nlerp_quat)(const Quat* from, const Quat* to, const float* t,
+                     const int num_quaternions, Quat* interpolations);
+  void (*slerp_quat)(const Quat* from, const Quat* to, const float* t,
+                     const int num_quaternions, Quat* interpolations);
+};
+
+// Replaces the kernels that have an AVX2/FMA variant, or returns false when
+// the build has none. The others are left as they are (the SSE2 ones).
+bool SetAvx2FmaKernels(SimdMathKernels* kernels);
+
+// The kernels below work on "lanes": T is either float, for one element, or
+// a SIMD register wrapper with the arithmetic operators, for one element per
+// lane (structure of arrays). Besides the operators, T needs a constructor
+// from a float that sets every lane, and the functions Sqrt(T) and Sign(T),
+// which returns -1 for the negative lanes and 1 for the others. The wrappers of a variant are local to its
+// translation unit, so that no code built for one instruction set is shared
+// with another one.
+
+// The functions of the float lanes. They are static, so that the copies
+// built for different instruction sets are not merged by the linker.
+static inline float Sqrt(const float x) {
+  return std::sqrt(x);
+}
+static inline float Sign(const float x) {
+  return x < 0.0f ? -1.0f : 1.0f;
+}
+
+// Inverts a matrix stored in column-major order with its 2x2 minors.
+template <typename T>
+inline void InvertMat4Lanes(const T m[16], T inverse[16]) {
+  // The coefficient (row, column).
+#define WVU_M(row, column) m[4 * (column) + (row)]
+  const T s0 = WVU_M(0, 0) * WVU_M(1, 1) - WVU_M(1, 0) * WVU_M(0, 1);
+  const T s1 = WVU_M(0, 0) * WVU_M(1, 2) - WVU_M(1, 0) * WVU_M(0, 2);
+  const T s2 = WVU_M(0, 0) * WVU_M(1, 3) - WVU_M(1, 0) * WVU_M(0, 3);
+  const T s3 = WVU_M(0, 1) * WVU_M(1, 2) - WVU_M(1, 1) * WVU_M(0, 2);
+  const T s4 = WVU_M(0, 1) * WVU_M(1, 3) - WVU_M(1, 1) * WVU_M(0, 3);
+  const T s5 = WVU_M(0, 2) * WVU_M(1, 3) - WVU_M(1, 2) * WVU_M(0, 3);
+  const T c5 = WVU_M(2, 2) * WVU_M(3, 3) - WVU_M(3, 2) * WVU_M(2, 3);
+  const T c4 = WVU_M(2, 1) * WVU_M(3, 3) - WVU_M(3, 1) * WVU_M(2, 3);
+  const T c3 = WVU_M(2, 1) * WVU_M(3, 2) - WVU_M(3, 1) * WVU_M(2, 2);
+  const T c2 = WVU_M(2, 0) * WVU_M(3, 3) - WVU_M(3, 0) * WVU_M(2, 3);
+  const T c1 = WVU_M(2, 0) * WVU_M(3, 2) - WVU_M(3, 0) * WVU_M(2, 2);
+  const T c0 = WVU_M(2, 0) * WVU_M(3, 1) - WVU_M(3, 0) * WVU_M(2, 1);
+  const T determinant =
+      s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+  const T d = T(1.0f) / determinant;
+  // The coefficient (row, column) of the inverse.
+#define WVU_INVERSE(row, column) inverse[4 * (column) + (row)]
+  WVU_INVERSE(0, 0) =
+      (WVU_M(1, 1) * c5 - WVU_M(1, 2) * c4 + WVU_M(1, 3) * c3) * d;
+  WVU_INVERSE(0, 1) =
+      (WVU_M(0, 2) * c4 - WVU_M(0, 1) * c5 - WVU_M(0, 3) * c3) * d;
+  WVU_INVERSE(0, 2) =
+      (WVU_M(3, 1) * s5 - WVU_M(3, 2) * s4 + WVU_M(3, 3) * s3) * d;
+  WVU_INVERSE(0, 3) =
+      (WVU_M(2, 2) * s4 - WVU_M(2, 1) * s5 - WVU_M(2, 3) * s3) * d;
+  WVU_INVERSE(1, 0) =
+      (WVU_M(1, 2) * c2 - WVU_M(1, 0) * c5 - WVU_M(1, 3) * c1) * d;
+  WVU_INVERSE(1, 1) =
+      (WVU_M(0, 0) * c5 - WVU_M(0, 2) * c2 + WVU_M(0, 3) * c1) * d;
+  WVU_INVERSE(1, 2) =
+      (WVU_M(3, 2) * s2 - WVU_M(3, 0) * s5 - WVU_M(3, 3) * s1) * d;
+  WVU_INVERSE(1, 3) =
+      (WVU_M(2, 0) * s5 - WVU_M(2, 2) * s2 + WVU_M(2, 3) * s1) * d;
+  WVU_INVERSE(2, 0) =
+      (WVU_M(1, 0) * c4 - WVU_M(1, 1) * c2 + WVU_M(1, 3) * c0) * d;
+  WVU_INVERSE(2, 1) =
+      (WVU_M(0, 1) * c2 - WVU_M(0, 0) * c4 - WVU_M(0, 3) * c0) * d;
+  WVU_INVERSE(2, 2) =
+      (WVU_M(3, 0) * s4 - WVU_M(3, 1) * s2 + WVU_M(3, 3) * s0) * d;
+  WVU_INVERSE(2, 3) =
+      (WVU_M(2, 1) * s2 - WVU_M(2, 0) * s4 - WVU_M(2, 3) * s0) * d;
+  WVU_INVERSE(3, 0) =
+      (WVU_M(1, 1) * c1 - WVU_M(1, 0) * c3 - WVU_M(1, 2) * c0) * d;
+  WVU_INVERSE(3, 1) =
+      (WVU_M(0, 0) * c3 - WVU_M(0, 1) * c1 + WVU_M(0, 2) * c0) * d;
+  WVU_INVERSE(3, 2) =
+      (WVU_M(3, 1) * s1 - WVU_M(3, 0) * s3 - WVU_M(3, 2) * s0) * d;
+  WVU_INVERSE(3, 3) =
+      (WVU_M(2, 0) * s3 - WVU_M(2, 1) * s1 + WVU_M(2, 2) * s0) * d;
+#undef WVU_INVERSE
+#undef WVU_M
+}
+
+// Computes the Hamilton product of quaternions stored as (x, y, z, w).
+template <typename T>
+inline void MultiplyQuatLanes(const T lhs[4], const T rhs[4], T product[4]) {
+  product[0] = lhs[3] * rhs[0] + lhs[0] * rhs[3] + lhs[1] * rhs[2] -
+      lhs[2] * rhs[1];
+  product[1] = lhs[3] * rhs[1] + lhs[1] * rhs[3] + lhs[2] * rhs[0] -
+      lhs[0] * rhs[2];
+  product[2] = lhs[3] * rhs[2] + lhs[2] * rhs[3] + lhs[0] * rhs[1] -
+      lhs[1] * rhs[0];
+  product[3] = lhs[3] * rhs[3] - lhs[0] * rhs[0] - lhs[1] * rhs[1] -
+      lhs[2] * rhs[2];
+}
+
+// Computes the rotation matrix, stored in column-major order, of a unit
+// quaternion stored as (x, y, z, w).
+template <typename T>
+inline void QuatToMat4Lanes(const T rotation[4], T matrix[16]) {
+  const T x2 = rotation[0] + rotation[0];
+  const T y2 = rotation[1] + rotation[1];
+  const T z2 = rotation[2] + rotation[2];
+  const T xx2 = rotation[0] * x2;
+  const T yy2 = rotation[1] * y2;
+  const T zz2 = rotation[2] * z2;
+  const T xy2 = rotation[0] * y2;
+  const T xz2 = rotation[0] * z2;
+  const T yz2 = rotation[1] * z2;
+  const T wx2 = rotation[3] * x2;
+  const T wy2 = rotation[3] * y2;
+  const T wz2 = rotation[3] * z2;
+  const T zero(0.0f);
+  const T one(1.0f);
+  matrix[0] = one - yy2 - zz2;
+  matrix[1] = xy2 + wz2;
+  matrix[2] = xz2 - wy2;
+  matrix[3] = zero;
+  matrix[4] = xy2 - wz2;
+  matrix[5] = one - xx2 - zz2;
+  matrix[6] = yz2 + wx2;
+  matrix[7] = zero;
+  matrix[8] = xz2 + wy2;
+  matrix[9] = yz2 - wx2;
+  matrix[10] = one - xx2 - yy2;
+  matrix[11] = zero;
+  matrix[12] = zero;
+  matrix[13] = zero;
+  matrix[14] = zero;
+  matrix[15] = one;
+}
+
+// Returns the dot product of quaternions.
+template <typename T>
+inline T DotQuatLanes(const T lhs[4], const T rhs[4]) {
+  return lhs[0] * rhs[0] + lhs[1] * rhs[1] + lhs[2] * rhs[2] +
+      lhs[3] * rhs[3];
+}
+
+// Interpolates quaternions linearly along the shortest arc and normalizes
+// the result.
+template <typename T>
+inline void NlerpQuatLanes(const T from[4],
+                           const T to[4],
+                           const T& t,
+                           T interpolation[4]) {
+  const T from_weight = T(1.0f) - t;
+  const T to_weight = Sign(DotQuatLanes(from, to)) * t;
+  for (int i = 0; i < 4; ++i) {
+    interpolation[i] = from_weight * from[i] + to_weight * to[i];
+  }
+  const T inverse_norm =
+      T(1.0f) / Sqrt(DotQuatLanes(interpolation, interpolation));
+  for (int i = 0; i < 4; ++i) {
+    interpolation[i] = interpolation[i] * inverse_norm;
+  }
+}
+
+// Interpolates quaternions spherically along the shortest arc. The weights,
+// sin(t * angle) / sin(angle) and its counterpart for 1 - t, are evaluated
+// with the polynomial of Eberly: with x the cosine of the angle,
+//   t * (1 + b_0 (1 + b_1 (... (1 + b_{n-1})))),
+//   b_i = (u_i t^2 - v_i) (x - 1),
+// u_i = 1 / ((i + 1) (2 i + 3)) and v_i = (i + 1) / (2 i + 3). The last
+// coefficients are scaled to compensate for the truncation of the series.
+// With 12 terms, the error of the weights is below 1e-6 for angles up to
+// pi / 2, which the shortest arc guarantees.
+template <typename T>
+inline void SlerpQuatLanes(const T from[4],
+                           const T to[4],
+                           const T& t,
+                           T interpolation[4]) {
+  constexpr int kNumTerms = 12;
+  constexpr float kCorrection = 1.8924f;
+  T cos_angle = DotQuatLanes(from, to);
+  const T sign = Sign(cos_angle);
+  cos_angle = cos_angle * sign;
+  const T x_minus_one = cos_angle - T(1.0f);
+  const T s = T(1.0f) - t;
+  const T t_squared = t * t;
+  const T s_squared = s * s;
+  T to_weight(1.0f);
+  T from_weight(1.0f);
+  for (int i = kNumTerms - 1; i >= 0; --i) {
+    float u = 1.0f / ((i + 1) * (2 * i + 3));
+    float v = (i + 1) / static_cast<float>(2 * i + 3);
+    if (i == kNumTerms - 1) {
+      u *= kCorrection;
+      v *= kCorrection;
+    }
+    to_weight = T(1.0f) + (T(u) * t_squared - T(v)) * x_minus_one * to_weight;
+    from_weight =
+        T(1.0f) + (T(u) * s_squared - T(v)) * x_minus_one * from_weight;
+  }
+  to_weight = to_weight * t * sign;
+  from_weight = from_weight * s;
+  for (int i = 0; i < 4; ++i) {
+    interpolation[i] = from_weight * from[i] + to_weight * to[i];
+  }
+}
+
+}  // namespace wvu
+
+#endif  // SIMD_MATH_KERNELS_H_
@@ -0,0 +1,589 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#include "skinning.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <GL/glew.h>
+#include <glog/logging.h>
+
+#include "animation.h"
+#include "shader_program.h"
+#include "thread_pool.h"
+#include "transformations.h"
+
+namespace wvu {
+namespace {
+// Number of floats per vertex in the input matrices (see Model::SetVBO).
+constexpr int kNumFloatsPerVertex = 8;
+// The skinned vertices add the joint indices and the weights.
+constexpr int kNumWordsPerSkinnedVertex = kNumFloatsPerVertex + 2;
+// Attribute locations of the vertex shader. The model matrix takes four.
+constexpr GLuint kJointsAttribute = 3;
+constexpr GLuint kWeightsAttribute = 4;
+constexpr GLuint kModelMatrixAttribute = 5;
+// Binding point of the joint palette, in both kinds of buffer.
+constexpr GLuint kPaletteBinding = 0;
+// Upper bound of the uniform buffer: larger blocks are slower to update
+// than the draws they save.
+constexpr GLint kMaxUniformPaletteBytes = 65536;
+// Characters per range of the parallel palette evaluation.
+constexpr int kMinCharactersPerRange = 8;
+
+// The methods and the buffers are selected with the defines prepended by
+// SkinnedMeshRenderer::Initialize, along with the version.
+const std::string vertex_shader_src =
+    "layout (location = 0) in vec3 position;\n"
+    "layout (location = 1) in vec3 vertex_color;\n"
+    "layout (location = 2) in vec2 vertex_texel;\n"
+    "layout (location = 3) in uvec4 joints;\n"
+    "layout (location = 4) in vec4 weights;\n"
+    "layout (location = 5) in mat4 model;\n"
+    "#ifdef USE_STORAGE_BUFFER\n"
+    "layout (std430, binding = 0) readonly buffer JointPalette {\n"
+    "  vec4 palette[];\n"
+    "};\n"
+    "#else\n"
+    "layout (std140) uniform JointPalette {\n"
+    "  vec4 palette[PALETTE_SIZE];\n"
+    "};\n"
+    "#endif\n"
+    "uniform mat4 view;\n"
+    "uniform mat4 projection;\n"
+    "uniform int num_joints;\n"
+    "out vec2 texel;\n"
+    "void main() {\n"
+    "  ivec4 joint_ids = gl_InstanceID * num_joints + ivec4(joints);\n"
+    "#ifdef DUAL_QUATERNION_SKINNING\n"
+    "  // The quaternions are blended in the hemisphere of the first one.\n"
+    "  ivec4 first_vector = 2 * joint_ids;\n"
+    "  vec4 first_real = palette[first_vector.x];\n"
+    "  vec4 real = vec4(0.0f);\n"
+    "  vec4 dual = vec4(0.0f);\n"
+    "  for (int i = 0; i < 4; ++i) {\n"
+    "    vec4 joint_real = palette[first_vector[i]];\n"
+    "    float weight = dot(joint_real, first_real) < 0.0f ? -weights[i] :\n"
+    "                                                          weights[i];\n"
+    "    real += weight * joint_real;\n"
+    "    dual += weight * palette[first_vector[i] + 1];\n"
+    "  }\n"
+    "  float norm = length(real);\n"
+    "  real /= norm;\n"
+    "  dual /= norm;\n"
+    "  vec3 skinned_position = position + 2.0f * cross(\n"
+    "      real.xyz, cross(real.xyz, position) + real.w * position);\n"
+    "  skinned_position += 2.0f * (real.w * dual.xyz - dual.w * real.xyz +\n"
+    "                              cross(real.xyz, dual.xyz));\n"
+    "#else\n"
+    "  ivec4 first_vector = 3 * joint_ids;\n"
+    "  vec4 rows[3] = vec4[3](vec4(0.0f), vec4(0.0f), vec4(0.0f));\n"
+    "  for (int i = 0; i < 4; ++i) {\n"
+    "    for (int row = 0; row < 3; ++row) {\n"
+    "      rows[row] += weights[i] * palette[first_vector[i] + row];\n"
+    "    }\n"
+    "  }\n"
+    "  vec4 bind_position = vec4(position, 1.0f);\n"
+    "  vec3 skinned_position = vec3(dot(rows[0], bind_position),\n"
+    "                               dot(rows[1], bind_position),\n"
+    "                               dot(rows[2], bind_position));\n"
+    "#endif\n"
+    "  gl_Position =\n"
+    "      projection * view * model * vec4(skinned_position, 1.0f);\n"
+    "  texel = vertex_texel;\n"
+    "}\n";
+
+const std::string fragment_shader_src =
+    "in vec2 texel;\n"
+    "out vec4 fragment_color;\n"
+    "uniform sampler2D texture_sampler;\n"
+    "void main() {\n"
+    "  fragment_color = texture(texture_sampler, texel);\n"
+    "}\n";
+
+// Returns translation * rotation * scaling.
+Eigen::Matrix4f ComputeTransformationMatrix(
+    const Eigen::Vector3f& position,
+    const Eigen::Quaternionf& rotation,
+    const Eigen::Vector3f& scale) {
+  Eigen::Matrix4f matrix = ComputeRotationMatrix(rotation);
+  matrix.topLeftCorner<3, 3>() *= scale.asDiagonal();
+  matrix.block<3, 1>(0, 3) = position;
+  return matrix;
+}
+
+GLuint PackBytes(const int bytes[kMaxJointInfluences]) {
+  GLuint word = 0;
+  for (int i = 0; i < kMaxJointInfluences; ++i) {
+    word |= static_cast<GLuint>(bytes[i]) << (8 * i);
+  }
+  return word;
+}
+
+GLuint FloatToWord(const GLfloat value) {
+  GLuint word;
+  std::memcpy(&word, &value, sizeof(word));
+  return word;
+}
+
+}  // namespace
+
+int NumPaletteVectorsPerJoint(const SkinningMethod method) {
+  return method == SkinningMethod::LINEAR_BLEND ? 3 : 2;
+}
+
+bool IsValidSkeleton(const Skeleton& skeleton, std::string* error_info_log) {
+  if (skeleton.joints.size() > kMaxSkeletonJoints) {
+    *error_info_log = "The skeleton has more than " +
+                      std::to_string(kMaxSkeletonJoints) + " joints.";
+    return false;
+  }
+  for (int i = 0; i < skeleton.joints.size(); ++i) {
+    const int parent = skeleton.joints[i].parent;
+    if (parent < -1 || parent >= i) {
+      *error_info_log = "The parent of the joint " + std::to_string(i) +
+                        " does not come before it.";
+      return false;
+    }
+  }
+  return true;
+}
+
+void ComputeInverseBindMatrices(Skeleton* skeleton) {
+  std::vector<Eigen::Matrix4f> global_matrices(skeleton->joints.size());
+  for (int i = 0; i < skeleton->joints.size(); ++i) {
+    Joint& joint = skeleton->joints[i];
+    const Eigen::Matrix4f local_matrix = ComputeTransformationMatrix(
+        joint.position, joint.rotation, joint.scale);
+    global_matrices[i] = joint.parent < 0 ?
+        local_matrix : global_matrices[joint.parent] * local_matrix;
+    joint.inverse_bind_matrix = global_matrices[i].inverse();
+  }
+}
+
+void PackSkinInfluences(const SkinInfluences& influences,
+                        GLuint* joint_word,
+                        GLuint* weight_word) {
+  float weight_sum = 0.0f;
+  for (int i = 0; i < kMaxJointInfluences; ++i) {
+    CHECK_GE(influences.joints[i], 0);
+    CHECK_LT(influences.joints[i], kMaxSkeletonJoints);
+    weight_sum += std::max(influences.weights[i], 0.0f);
+  }
+  CHECK_GT(weight_sum, 0.0f);
+  // The weights are rounded down, and the units left go to the weights with
+  // the largest remainders, so that the weights the shader reads add up to
+  // one and every one of them is within one unit of its value.
+  int weights[kMaxJointInfluences];
+  float remainders[kMaxJointInfluences];
+  int quantized_sum = 0;
+  for (int i = 0; i < kMaxJointInfluences; ++i) {
+    const float weight =
+        255.0f * std::max(influences.weights[i], 0.0f) / weight_sum;
+    weights[i] = std::min(static_cast<int>(weight), 255);
+    remainders[i] = weight - weights[i];
+    quantized_sum += weights[i];
+  }
+  for (; quantized_sum < 255; ++quantized_sum) {
+    const int largest =
+        std::max_element(remainders, remainders + kMaxJointInfluences) -
+        remainders;
+    ++weights[largest];
+    remainders[largest] = -1.0f;
+  }
+  *joint_word = PackBytes(influences.joints);
+  *weight_word = PackBytes(weights);
+}
+
+void ComputeJointPalette(const Skeleton& skeleton,
+                         const TransformStore& local_poses,
+                         const int first_transform,
+                         const SkinningMethod method,
+                         std::vector<Eigen::Matrix4f>* global_matrices,
+                         GLfloat* palette) {
+  const int num_joints = skeleton.joints.size();
+  const int num_floats_per_joint = 4 * NumPaletteVectorsPerJoint(method);
+  global_matrices->resize(num_joints);
+  for (int i = 0; i < num_joints; ++i) {
+    const Joint& joint = skeleton.joints[i];
+    const int transform = first_transform + i;
+    const Eigen::Matrix4f local_matrix = ComputeTransformationMatrix(
+        local_poses.positions[transform], local_poses.rotations[transform],
+        local_poses.scales[transform]);
+    // The parents come first: their global matrices are already computed.
+    Eigen::Matrix4f& global_matrix = (*global_matrices)[i];
+    global_matrix = joint.parent < 0 ?
+        local_matrix : (*global_matrices)[joint.parent] * local_matrix;
+    const Eigen::Matrix4f skinning_matrix =
+        global_matrix * joint.inverse_bind_matrix;
+    GLfloat* joint_palette = palette + num_floats_per_joint * i;
+    if (method == SkinningMethod::LINEAR_BLEND) {
+      for (int row = 0; row < 3; ++row) {
+        for (int col = 0; col < 4; ++col) {
+          joint_palette[4 * row + col] = skinning_matrix(row, col);
+        }
+      }
+      continue;
+    }
+    // The scales are removed from the rotation before the conversion.
+    Eigen::Matrix3f rotation_matrix = skinning_matrix.topLeftCorner<3, 3>();
+    rotation_matrix.colwise().normalize();
+    const Eigen::Quaternionf real =
+        Eigen::Quaternionf(rotation_matrix).normalized();
+    const Eigen::Vector3f translation = skinning_matrix.block<3, 1>(0, 3);
+    // dual = translation * real / 2, with the translation as a quaternion.
+    Eigen::Quaternionf dual = Eigen::Quaternionf(
+        0.0f, translation.x(), translation.y(), translation.z()) * real;
+    dual.coeffs() *= 0.5f;
+    std::copy(real.coeffs().data(), real.coeffs().data() + 4, joint_palette);
+    std::copy(dual.coeffs().data(), dual.coeffs().data() + 4,
+              joint_palette + 4);
+  }
+}
+
+Eigen::Vector3f SkinPosition(const GLfloat* palette,
+                             const SkinningMethod method,
+                             const SkinInfluences& influences,
+                             const Eigen::Vector3f& position) {
+  float weight_sum = 0.0f;
+  for (int i = 0; i < kMaxJointInfluences; ++i) {
+    weight_sum += std::max(influences.weights[i], 0.0f);
+  }
+  const int num_floats_per_joint = 4 * NumPaletteVectorsPerJoint(method);
+  if (method == SkinningMethod::LINEAR_BLEND) {
+    Eigen::Matrix<float, 3, 4> blended_matrix =
+        Eigen::Matrix<float, 3, 4>::Zero();
+    for (int i = 0; i < kMaxJointInfluences; ++i) {
+      const float weight =
+          std::max(influences.weights[i], 0.0f) / weight_sum;
+      // The palette holds the rows of the matrices.
+      blended_matrix += weight * Eigen::Map<
+          const Eigen::Matrix<float, 3, 4, Eigen::RowMajor> >(
+              palette + num_floats_per_joint * influences.joints[i]);
+    }
+    return blended_matrix * position.homogeneous();
+  }
+  const Eigen::Map<const Eigen::Vector4f> first_real(
+      palette + num_floats_per_joint * influences.joints[0]);
+  Eigen::Vector4f real = Eigen::Vector4f::Zero();
+  Eigen::Vector4f dual = Eigen::Vector4f::Zero();
+  for (int i = 0; i < kMaxJointInfluences; ++i) {
+    const GLfloat* joint_palette =
+        palette + num_floats_per_joint * influences.joints[i];
+    const Eigen::Map<const Eigen::Vector4f> joint_real(joint_palette);
+    float weight = std::max(influences.weights[i], 0.0f) / weight_sum;
+    if (joint_real.dot(first_real) < 0.0f) weight = -weight;
+    real += weight * joint_real;
+    dual += weight * Eigen::Map<const Eigen::Vector4f>(joint_palette + 4);
+  }
+  const float norm = real.norm();
+  real /= norm;
+  dual /= norm;
+  const Eigen::Quaternionf rotation(real);
+  const Eigen::Quaternionf translation =
+      Eigen::Quaternionf(dual) * rotation.conjugate();
+  return rotation * position + 2.0f * translation.vec();
+}
+
+SkeletalAnimator::SkeletalAnimator(const Skeleton* skeleton) :
+    skeleton_(CHECK_NOTNULL(skeleton)), num_characters_(0) {
+  std::string error_info_log;
+  CHECK(IsValidSkeleton(*skeleton_, &error_info_log)) << error_info_log;
+}
+
+int SkeletalAnimator::AddCharacter(
+    const std::vector<AnimationClip>* joint_clips,
+    const float start_time) {
+  const int num_joints = skeleton_->joints.size();
+  const int first_transform = local_poses_.positions.size();
+  for (const Joint& joint : skeleton_->joints) {
+    local_poses_.positions.push_back(joint.position);
+    local_poses_.rotations.push_back(joint.rotation);
+    local_poses_.scales.push_back(joint.scale);
+  }
+  if (joint_clips != nullptr) {
+    CHECK_EQ(joint_clips->size(), num_joints);
+    for (int i = 0; i < num_joints; ++i) {
+      const AnimationClip& clip = (*joint_clips)[i];
+      if (clip.position.values.empty() && clip.rotation.values.empty() &&
+          clip.scale.values.empty()) {
+        continue;
+      }
+      animator_.Play(&clip, first_transform + i, start_time);
+    }
+  }
+  return num_characters_++;
+}
+
+void SkeletalAnimator::Evaluate(const float time,
+                                const SkinningMethod method,
+                                ThreadPool* thread_pool) {
+  animator_.Evaluate(time, thread_pool, &local_poses_);
+  const int num_joints = skeleton_->joints.size();
+  const int num_floats_per_character =
+      4 * NumPaletteVectorsPerJoint(method) * num_joints;
+  palette_.resize(num_floats_per_character * num_characters_);
+  // Every character writes its own palette.
+  ParallelFor(num_characters_, kMinCharactersPerRange, thread_pool,
+              [&](const int begin, const int end) {
+    std::vector<Eigen::Matrix4f> global_matrices;
+    for (int i = begin; i < end; ++i) {
+      ComputeJointPalette(*skeleton_, local_poses_, num_joints * i, method,
+                          &global_matrices,
+                          &palette_[num_floats_per_character * i]);
+    }
+  });
+}
+
+SkinnedMeshRenderer::SkinnedMeshRenderer() :
+    method_(SkinningMethod::LINEAR_BLEND),
+    palette_buffer_(JointPaletteBuffer::UNIFORM_BUFFER),
+    uniform_palette_size_(0), instance_buffer_id_(0), palette_buffer_id_(0) {}
+
+SkinnedMeshRenderer::~SkinnedMeshRenderer() {
+  for (const MeshData& mesh : meshes_) {
+    glDeleteVertexArrays(1, &mesh.vertex_array_object_id);
+    const GLuint buffers[] = {mesh.vertex_buffer_id, mesh.element_buffer_id};
+    glDeleteBuffers(2, buffers);
+  }
+  const GLuint buffers[] = {instance_buffer_id_, palette_buffer_id_};
+  glDeleteBuffers(2, buffers);
+}
+
+bool SkinnedMeshRenderer::IsSupported(
+    const JointPaletteBuffer palette_buffer) {
+  // Uniform buffers are core since OpenGL 3.1, below the contexts we create.
+  return palette_buffer == JointPaletteBuffer::UNIFORM_BUFFER ||
+         ShaderProgram::AreComputeShadersSupported();
+}
+
+bool SkinnedMeshRenderer::Initialize(const SkinningMethod method,
+                                     const JointPaletteBuffer palette_buffer,
+                                     std::string* error_info_log) {
+  if (!IsSupported(palette_buffer)) {
+    *error_info_log = "Storage buffers require OpenGL 4.3.";
+    return false;
+  }
+  method_ = method;
+  palette_buffer_ = palette_buffer;
+  std::string header;
+  if (palette_buffer_ == JointPaletteBuffer::STORAGE_BUFFER) {
+    header = "#version 430 core\n#define USE_STORAGE_BUFFER\n";
+    uniform_palette_size_ = 0;
+  } else {
+    GLint max_uniform_block_size = 0;
+    glGetIntegerv(GL_MAX_UNIFORM_BLOCK_SIZE, &max_uniform_block_size);
+    uniform_palette_size_ =
+        std::min(max_uniform_block_size, kMaxUniformPaletteBytes) /
+        (4 * sizeof(GLfloat));
+    header = "#version 330 core\n#define PALETTE_SIZE " +
+             std::to_string(uniform_palette_size_) + "\n";
+  }
+  if (method_ == SkinningMethod::DUAL_QUATERNION) {
+    header += "#define DUAL_QUATERNION_SKINNING\n";
+  }
+  shader_program_.LoadVertexShaderFromString(header + vertex_shader_src);
+  shader_program_.LoadFragmentShaderFromString(
+      header + fragment_shader_src);
+  if (!shader_program_.Create(error_info_log)) return false;
+  shader_program_.Use();
+  const GLuint program_id = shader_program_.shader_program_id();
+  glUniform1i(glGetUniformLocation(program_id, "texture_sampler"), 0);
+  if (palette_buffer_ == JointPaletteBuffer::UNIFORM_BUFFER) {
+    glUniformBlockBinding(program_id,
+                          glGetUniformBlockIndex(program_id, "JointPalette"),
+                          kPaletteBinding);
+  }
+  glUseProgram(0);
+
+  GLuint buffers[2];
+  glGenBuffers(2, buffers);
+  instance_buffer_id_ = buffers[0];
+  palette_buffer_id_ = buffers[1];
+  return true;
+}
+
+int SkinnedMeshRenderer::AddMesh(
+    const Eigen::MatrixXf& vertices,
+    const std::vector<SkinInfluences>& influences,
+    const std::vector<GLuint>& indices) {
+  CHECK_EQ(vertices.rows(), kNumFloatsPerVertex);
+  CHECK_EQ(vertices.cols(), influences.size());
+  std::vector<GLuint> words;
+  words.reserve(kNumWordsPerSkinnedVertex * vertices.cols());
+  for (int i = 0; i < vertices.cols(); ++i) {
+    for (int j = 0; j < kNumFloatsPerVertex; ++j) {
+      words.push_back(FloatToWord(vertices(j, i)));
+    }
+    GLuint joint_word, weight_word;
+    PackSkinInfluences(influences[i], &joint_word, &weight_word);
+    words.push_back(joint_word);
+    words.push_back(weight_word);
+  }
+
+  MeshData mesh;
+  mesh.num_indices = indices.size();
+  glGenVertexArrays(1, &mesh.vertex_array_object_id);
+  glBindVertexArray(mesh.vertex_array_object_id);
+  GLuint buffers[2];
+  glGenBuffers(2, buffers);
+  mesh.vertex_buffer_id = buffers[0];
+  mesh.element_buffer_id = buffers[1];
+  glBindBuffer(GL_ARRAY_BUFFER, mesh.vertex_buffer_id);
+  glBufferData(GL_ARRAY_BUFFER, words.size() * sizeof(words[0]),
+               words.data(), GL_STATIC_DRAW);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.element_buffer_id);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(indices[0]),
+               indices.data(), GL_STATIC_DRAW);
+  // Position, color and texel, like Model::SetVertexAttributes.
+  constexpr GLsizei kStride = kNumWordsPerSkinnedVertex * sizeof(GLuint);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, kStride, nullptr);
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, kStride,
+                        reinterpret_cast<GLvoid*>(3 * sizeof(GLfloat)));
+  glEnableVertexAttribArray(1);
+  glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, kStride,
+                        reinterpret_cast<GLvoid*>(6 * sizeof(GLfloat)));
+  glEnableVertexAttribArray(2);
+  // The joint indices are integers; the weights are normalized bytes.
+  glVertexAttribIPointer(kJointsAttribute, 4, GL_UNSIGNED_BYTE, kStride,
+                         reinterpret_cast<GLvoid*>(8 * sizeof(GLuint)));
+  glEnableVertexAttribArray(kJointsAttribute);
+  glVertexAttribPointer(kWeightsAttribute, 4, GL_UNSIGNED_BYTE, GL_TRUE,
+                        kStride,
+                        reinterpret_cast<GLvoid*>(9 * sizeof(GLuint)));
+  glEnableVertexAttribArray(kWeightsAttribute);
+  // One model matrix per instance, one column per attribute.
+  glBindBuffer(GL_ARRAY_BUFFER, instance_buffer_id_);
+  for (int i = 0; i < 4; ++i) {
+    glVertexAttribPointer(kModelMatrixAttribute + i, 4, GL_FLOAT, GL_FALSE,
+                          16 * sizeof(GLfloat),
+                          reinterpret_cast<GLvoid*>(4 * i * sizeof(GLfloat)));
+    glVertexAttribDivisor(kModelMatrixAttribute + i, 1);
+    glEnableVertexAttribArray(kModelMatrixAttribute + i);
+  }
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  meshes_.push_back(mesh);
+  return meshes_.size() - 1;
+}
+
+void SkinnedMeshRenderer::Draw(
+    const int mesh_id,
+    const int num_joints,
+    const std::vector<Eigen::Matrix4f>& model_matrices,
+    const GLfloat* palette,
+    const Eigen::Matrix4f& projection,
+    const Eigen::Matrix4f& view,
+    const GLuint texture_id) {
+  if (model_matrices.empty()) return;
+  const MeshData& mesh = meshes_[mesh_id];
+  const int num_instances = model_matrices.size();
+  const int num_vectors_per_instance =
+      NumPaletteVectorsPerJoint(method_) * num_joints;
+  const int num_floats_per_instance = 4 * num_vectors_per_instance;
+
+  shader_program_.Use();
+  const GLuint program_id = shader_program_.shader_program_id();
+  glUniformMatrix4fv(glGetUniformLocation(program_id, "view"), 1, GL_FALSE,
+                     view.data());
+  glUniformMatrix4fv(glGetUniformLocation(program_id, "projection"), 1,
+                     GL_FALSE, projection.data());
+  glUniform1i(glGetUniformLocation(program_id, "num_joints"), num_joints);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, texture_id);
+  glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+
+  // A storage buffer holds all the palettes: a single draw. A uniform buffer
+  // holds the palettes of as many instances as fit in it per draw.
+  int num_instances_per_draw = num_instances;
+  if (palette_buffer_ == JointPaletteBuffer::STORAGE_BUFFER) {
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, palette_buffer_id_);
+    glBufferData(GL_SHADER_STORAGE_BUFFER,
+                 num_floats_per_instance * num_instances * sizeof(GLfloat),
+                 palette, GL_STREAM_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kPaletteBinding,
+                     palette_buffer_id_);
+  } else {
+    num_instances_per_draw = uniform_palette_size_ / num_vectors_per_instance;
+    CHECK_GT(num_instances_per_draw, 0)
+        << "The palette of the skeleton does not fit in a uniform buffer.";
+    glBindBufferBase(GL_UNIFORM_BUFFER, kPaletteBinding, palette_buffer_id_);
+  }
+
+  glBindVertexArray(mesh.vertex_array_object_id);
+  for (int first_instance = 0; first_instance < num_instances;
+       first_instance += num_instances_per_draw) {
+    const int num_draw_instances =
+        std::min(num_instances_per_draw, num_instances - first_instance);
+    // The matrices are column-major like OpenGL expects them.
+    instance_data_.resize(16 * num_draw_instances);
+    for (int i = 0; i < num_draw_instances; ++i) {
+      const Eigen::Matrix4f& model_matrix =
+          model_matrices[first_instance + i];
+      std::copy(model_matrix.data(), model_matrix.data() + 16,
+                instance_data_.begin() + 16 * i);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, instance_buffer_id_);
+    glBufferData(GL_ARRAY_BUFFER, instance_data_.size() * sizeof(GLfloat),
+                 instance_data_.data(), GL_STREAM_DRAW);
+    if (palette_buffer_ == JointPaletteBuffer::UNIFORM_BUFFER) {
+      // The buffer is orphaned and allocated with the size of the block,
+      // which the shader may read entirely.
+      glBindBuffer(GL_UNIFORM_BUFFER, palette_buffer_id_);
+      glBufferData(GL_UNIFORM_BUFFER,
+                   uniform_palette_size_ * 4 * sizeof(GLfloat), nullptr,
+                   GL_STREAM_DRAW);
+      glBufferSubData(
+          GL_UNIFORM_BUFFER, 0,
+          num_floats_per_instance * num_draw_instances * sizeof(GLfloat),
+          palette + num_floats_per_instance * first_instance);
+      glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+    glDrawElementsInstanced(GL_TRIANGLES, mesh.num_indices, GL_UNSIGNED_INT,
+                            nullptr, num_draw_instances);
+  }
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glUseProgram(0);
+}
+
+}  // namespace wvu
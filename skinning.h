@@ -0,0 +1,322 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef SKINNING_H_
+#define SKINNING_H_
+
+#include <string>
+#include <vector>
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <GL/glew.h>
+
+#include "animation.h"
+#include "shader_program.h"
+
+namespace wvu {
+class ThreadPool;
+
+// Maximum number of joints influencing a vertex.
+constexpr int kMaxJointInfluences = 4;
+// Maximum number of joints of a skeleton: the joint indices of the vertices
+// are stored in bytes.
+constexpr int kMaxSkeletonJoints = 256;
+
+// How the vertex shader blends the transformations of the joints.
+enum struct SkinningMethod {
+  // Weighted sum of the joint matrices. It supports scaled joints, but the
+  // mesh collapses around twisted joints (candy-wrapper effect).
+  LINEAR_BLEND = 0,
+  // Weighted sum of the joint dual quaternions, which preserves the volume
+  // around twisted joints. The dual quaternions only hold the rotation and
+  // the translation of the joints: their scales are ignored.
+  DUAL_QUATERNION = 1
+};
+
+// Returns the number of vec4 a joint takes in the joint palette: the three
+// rows of its affine matrix for LINEAR_BLEND, and the real and the dual
+// parts of its dual quaternion for DUAL_QUATERNION.
+int NumPaletteVectorsPerJoint(const SkinningMethod method);
+
+// A joint of a skeleton and its rest pose, relative to its parent.
+struct Joint {
+  // Index of the parent joint, or -1 for the root.
+  int parent;
+  Eigen::Vector3f position;
+  Eigen::Quaternionf rotation;
+  Eigen::Vector3f scale;
+  // Transforms the mesh from its bind pose into the coordinate system of
+  // the joint.
+  Eigen::Matrix4f inverse_bind_matrix;
+};
+
+// A joint hierarchy. The joints are sorted so that every parent comes before
+// its children, which lets the hierarchy be flattened in a single pass.
+struct Skeleton {
+  std::vector<Joint> joints;
+};
+
+// Returns true if the skeleton has at most kMaxSkeletonJoints joints and its
+// parents come before their children.
+bool IsValidSkeleton(const Skeleton& skeleton, std::string* error_info_log);
+
+// Sets the inverse bind matrices of the joints from their rest poses, i.e.,
+// the mesh is bound to the skeleton in its rest pose.
+void ComputeInverseBindMatrices(Skeleton* skeleton);
+
+// The joints influencing a vertex and their weights. The unused influences
+// have a zero weight.
+struct SkinInfluences {
+  int joints[kMaxJointInfluences];
+  float weights[kMaxJointInfluences];
+};
+
+// Packs the influences of a vertex into its two skinning attributes: the
+// joint indices as four bytes, and the normalized weights as four unorm8
+// that add up to exactly 255.
+// Params:
+//   influences  The influences. The weights must not all be zero.
+//   joint_word  The packed joint indices.
+//   weight_word  The packed weights.
+void PackSkinInfluences(const SkinInfluences& influences,
+                        GLuint* joint_word,
+                        GLuint* weight_word);
+
+// Flattens the joint hierarchy of a character and writes its joint palette:
+// the transformation of every joint from the bind pose to the current pose
+// (global transformation * inverse bind matrix), in the layout of the
+// method.
+// Params:
+//   skeleton  The skeleton.
+//   local_poses  The store with the poses of the joints relative to their
+//     parents.
+//   first_transform  The index of the pose of the first joint in the store.
+//     The poses of the joints are consecutive.
+//   method  The skinning method the palette is for.
+//   global_matrices  Scratch storage for the global transformations.
+//   palette  The NumPaletteVectorsPerJoint * 4 floats per joint of the
+//     palette.
+void ComputeJointPalette(const Skeleton& skeleton,
+                         const TransformStore& local_poses,
+                         const int first_transform,
+                         const SkinningMethod method,
+                         std::vector<Eigen::Matrix4f>* global_matrices,
+                         GLfloat* palette);
+
+// Skins a position on the CPU like the vertex shader does, e.g., to compute
+// bounds or to pick skinned meshes.
+// Params:
+//   palette  The joint palette of the character.
+//   method  The skinning method of the palette.
+//   influences  The influences of the vertex.
+//   position  The position in the bind pose.
+Eigen::Vector3f SkinPosition(const GLfloat* palette,
+                             const SkinningMethod method,
+                             const SkinInfluences& influences,
+                             const Eigen::Vector3f& position);
+
+// Animates characters sharing a skeleton. Every frame, the local poses of
+// all the joints of all the characters are sampled from their clips in
+// parallel (see Animator), and then the hierarchy of every character is
+// flattened into its joint palette, also in parallel. Usage example:
+//
+// wvu::SkeletalAnimator animator(&skeleton);
+// for (int i = 0; i < num_characters; ++i) {
+//   animator.AddCharacter(&walk_clips, 0.1f * i);
+// }
+// while (...) {  // Rendering loop.
+//   animator.Evaluate(glfwGetTime(), wvu::SkinningMethod::LINEAR_BLEND,
+//                     &thread_pool);
+//   renderer.Draw(mesh_id, skeleton.joints.size(), model_matrices,
+//                 animator.palette().data(), projection, view, texture_id);
+// }
+class SkeletalAnimator {
+ public:
+  // Params:
+  //   skeleton  The skeleton. It is not owned and must outlive the
+  //     animator.
+  explicit SkeletalAnimator(const Skeleton* skeleton);
+
+  // Adds a character and returns its index. Its palette is the one at
+  // index * num_joints * NumPaletteVectorsPerJoint * 4 in the palette.
+  // Params:
+  //   joint_clips  One clip per joint animating its local pose, or nullptr
+  //     for a character in the rest pose. The clips are not owned and must
+  //     outlive the animator. The joints without tracks keep their rest
+  //     pose.
+  //   start_time  The time at which the clips start, in seconds.
+  int AddCharacter(const std::vector<AnimationClip>* joint_clips,
+                   const float start_time);
+
+  // Evaluates the poses of all the characters at the given time and writes
+  // their joint palettes.
+  // Params:
+  //   time  The time in seconds.
+  //   method  The skinning method of the palettes.
+  //   thread_pool  The pool the characters are evaluated on, or nullptr to
+  //     evaluate them on the calling thread.
+  void Evaluate(const float time,
+                const SkinningMethod method,
+                ThreadPool* thread_pool);
+
+  // Returns the joint palettes of the characters, one after the other.
+  const std::vector<GLfloat>& palette() const {
+    return palette_;
+  }
+
+  // Returns the number of characters.
+  int num_characters() const {
+    return num_characters_;
+  }
+
+ private:
+  const Skeleton* skeleton_;
+  int num_characters_;
+  // The local poses of the joints of all the characters, one character
+  // after the other.
+  TransformStore local_poses_;
+  Animator animator_;
+  std::vector<GLfloat> palette_;
+};
+
+// Where the vertex shader reads the joint palettes from.
+enum struct JointPaletteBuffer {
+  // A uniform buffer, available everywhere (OpenGL 3.1). Its size is
+  // limited (16 KB at least), so the instances are split into as many draws
+  // as needed.
+  UNIFORM_BUFFER = 0,
+  // A shader storage buffer (OpenGL 4.3), which holds the palettes of all
+  // the instances of a draw.
+  STORAGE_BUFFER = 1
+};
+
+// This class draws instanced skinned meshes. The vertices hold their
+// position, color and texel like Model::SetVBO, followed by their joint
+// indices (four bytes) and weights (four unorm8), so skinning adds 8 bytes
+// per vertex. The vertex shader blends the joint palette of the instance,
+// selected with gl_InstanceID, and applies the model matrix of the instance,
+// which is a per-instance attribute. Usage example:
+//
+// wvu::SkinnedMeshRenderer renderer;
+// std::string error_info_log;
+// if (!renderer.Initialize(wvu::SkinningMethod::DUAL_QUATERNION,
+//                          wvu::SkinnedMeshRenderer::IsSupported(
+//                              wvu::JointPaletteBuffer::STORAGE_BUFFER) ?
+//                          wvu::JointPaletteBuffer::STORAGE_BUFFER :
+//                          wvu::JointPaletteBuffer::UNIFORM_BUFFER,
+//                          &error_info_log)) {
+//   LOG(ERROR) << error_info_log;
+// }
+// const int mesh_id = renderer.AddMesh(vertices, influences, indices);
+// while (...) {  // Rendering loop.
+//   renderer.Draw(mesh_id, num_joints, model_matrices, palette, projection,
+//                 view, texture_id);
+// }
+class SkinnedMeshRenderer {
+ public:
+  SkinnedMeshRenderer();
+  ~SkinnedMeshRenderer();
+
+  // Returns true when the current OpenGL context supports the buffer.
+  static bool IsSupported(const JointPaletteBuffer palette_buffer);
+
+  // Compiles the shader program and creates the buffers. Returns true upon
+  // success and false otherwise.
+  // Params:
+  //   method  The skinning method of the vertex shader. The palettes passed
+  //     to Draw must have its layout.
+  //   palette_buffer  The buffer the palettes are read from.
+  //   error_info_log  A pointer to a string that holds the error log.
+  bool Initialize(const SkinningMethod method,
+                  const JointPaletteBuffer palette_buffer,
+                  std::string* error_info_log);
+
+  // Uploads a mesh and returns its id.
+  // Params:
+  //   vertices  The 8 x n vertex matrix with the layout of Model::SetVBO.
+  //   influences  The influences of every vertex.
+  //   indices  The triangle indices.
+  int AddMesh(const Eigen::MatrixXf& vertices,
+              const std::vector<SkinInfluences>& influences,
+              const std::vector<GLuint>& indices);
+
+  // Draws the instances of a mesh.
+  // Params:
+  //   mesh_id  The id of the mesh returned by AddMesh.
+  //   num_joints  The number of joints of the skeleton of the mesh.
+  //   model_matrices  The model matrix of every instance.
+  //   palette  The joint palettes of the instances, one after the other
+  //     (see SkeletalAnimator::palette).
+  //   projection  The camera projection matrix.
+  //   view  The camera pose matrix (world -> camera transformation matrix).
+  //   texture_id  The texture of the mesh.
+  void Draw(const int mesh_id,
+            const int num_joints,
+            const std::vector<Eigen::Matrix4f>& model_matrices,
+            const GLfloat* palette,
+            const Eigen::Matrix4f& projection,
+            const Eigen::Matrix4f& view,
+            const GLuint texture_id);
+
+  // Returns the number of vec4 of the uniform buffer, or zero when the
+  // palettes are read from a storage buffer.
+  int uniform_palette_size() const {
+    return uniform_palette_size_;
+  }
+
+ private:
+  // The vertex array object of a mesh and its buffers.
+  struct MeshData {
+    GLuint vertex_array_object_id;
+    GLuint vertex_buffer_id;
+    GLuint element_buffer_id;
+    GLsizei num_indices;
+  };
+
+  SkinningMethod method_;
+  JointPaletteBuffer palette_buffer_;
+  // Number of vec4 of the palette array of the uniform block.
+  int uniform_palette_size_;
+  std::vector<MeshData> meshes_;
+  // The model matrices of the instances of a draw.
+  GLuint instance_buffer_id_;
+  GLuint palette_buffer_id_;
+  // Scratch storage for the model matrices reused every draw.
+  std::vector<GLfloat> instance_data_;
+  ShaderProgram shader_program_;
+};
+
+}  // namespace wvu
+
+#endif  // SKINNING_H_
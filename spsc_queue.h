@@ -0,0 +1,112 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef SPSC_QUEUE_H_
+#define SPSC_QUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace wvu {
+
+// Bounded lock-free queue for exactly one producer thread and one consumer
+// thread. The producer only writes tail_ and the consumer only writes head_,
+// so neither side ever waits for the other: Push() fails when the queue is
+// full and Front() returns nullptr when it is empty. Usage example:
+//
+// wvu::SpscQueue<int> queue(64);
+// // Producer thread.
+// while (!queue.Push(value)) std::this_thread::yield();
+// // Consumer thread.
+// if (int* value = queue.Front()) {
+//   ...  // Use *value.
+//   queue.Pop();
+// }
+template <typename T>
+class SpscQueue {
+ public:
+  // Params:
+  //   capacity  The maximum number of elements. It is rounded up to a power
+  //     of two.
+  explicit SpscQueue(const int capacity) : head_(0), tail_(0) {
+    size_t num_slots = 1;
+    while (num_slots < static_cast<size_t>(capacity)) num_slots <<= 1;
+    slots_.resize(num_slots);
+    mask_ = num_slots - 1;
+  }
+
+  // Appends a value. Returns false when the queue is full. Producer only.
+  bool Push(const T& value) {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) == slots_.size()) {
+      return false;
+    }
+    slots_[tail & mask_] = value;
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Returns the oldest value, or nullptr when the queue is empty. The value
+  // stays valid until Pop() is called. Consumer only.
+  T* Front() {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire)) return nullptr;
+    return &slots_[head & mask_];
+  }
+
+  // Removes the oldest value. The queue must not be empty. Consumer only.
+  void Pop() {
+    head_.store(head_.load(std::memory_order_relaxed) + 1,
+                std::memory_order_release);
+  }
+
+  // Returns the maximum number of elements.
+  int capacity() const {
+    return slots_.size();
+  }
+
+ private:
+  std::vector<T> slots_;
+  size_t mask_;
+  // Number of values popped and pushed. They only grow; the slot of a value
+  // is its count modulo the capacity. They live in separate cache lines so
+  // that the two threads do not invalidate each other's line.
+  alignas(64) std::atomic<size_t> head_;
+  alignas(64) std::atomic<size_t> tail_;
+};
+
+}  // namespace wvu
+
+#endif  // SPSC_QUEUE_H_
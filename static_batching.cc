@@ -0,0 +1,222 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#include "static_batching.h"
+
+#include <cmath>
+#include <limits>
+#include <map>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <Eigen/Core>
+#include <GL/glew.h>
+#include <glog/logging.h>
+
+#include "frustum.h"
+#include "model.h"
+#include "shader_program.h"
+
+namespace wvu {
+namespace {
+// Number of floats per vertex (see Model::SetVBO).
+constexpr int kNumFloatsPerVertex = 8;
+
+// Identifies a batch: a texture and a cell of the grid.
+typedef std::tuple<GLuint, int, int, int> BatchKey;
+
+// Appends the vertices of a model, transformed into world coordinates, and
+// its indices to a batch.
+void AppendModel(const Eigen::Matrix4f& model_matrix,
+                 const Eigen::MatrixXf& vertices,
+                 const std::vector<GLuint>& indices,
+                 StaticBatch* batch) {
+  const GLuint base_vertex = batch->vertices.size() / kNumFloatsPerVertex;
+  for (int i = 0; i < vertices.cols(); ++i) {
+    const Eigen::Vector3f position =
+        model_matrix.topLeftCorner<3, 3>() * vertices.col(i).head<3>() +
+        model_matrix.topRightCorner<3, 1>();
+    batch->vertices.insert(batch->vertices.end(),
+                           {position.x(), position.y(), position.z()});
+    batch->vertices.insert(batch->vertices.end(), vertices.col(i).data() + 3,
+                           vertices.col(i).data() + kNumFloatsPerVertex);
+    batch->min_corner = batch->min_corner.cwiseMin(position);
+    batch->max_corner = batch->max_corner.cwiseMax(position);
+  }
+  // Models without indices are drawn as a plain triangle list.
+  if (indices.empty()) {
+    for (int i = 0; i < vertices.cols(); ++i) {
+      batch->indices.push_back(base_vertex + i);
+    }
+  } else {
+    for (const GLuint index : indices) {
+      batch->indices.push_back(base_vertex + index);
+    }
+  }
+}
+
+}  // namespace
+
+void BuildStaticBatches(const std::vector<Model*>& models,
+                        const std::vector<GLuint>& texture_ids,
+                        const GLfloat cell_size,
+                        std::vector<StaticBatch>* batches) {
+  CHECK_EQ(models.size(), texture_ids.size());
+  CHECK_GT(cell_size, 0.0f);
+  batches->clear();
+  // The map keeps the batches sorted by texture.
+  std::map<BatchKey, StaticBatch> batches_by_key;
+  for (int i = 0; i < models.size(); ++i) {
+    Model* model = models[i];
+    // The transparent models are drawn by the transparency pass.
+    if (!model->is_static() || model->is_transparent()) continue;
+    const Eigen::MatrixXf& vertices = model->vertices();
+    if (vertices.cols() == 0) continue;
+    CHECK_EQ(vertices.rows(), kNumFloatsPerVertex);
+    const Eigen::Matrix4f model_matrix = model->ComputeModelMatrix();
+    // The cell of the model is given by the center of its world-space box.
+    const Eigen::Matrix3Xf positions =
+        (model_matrix.topLeftCorner<3, 3>() * vertices.topRows<3>())
+            .colwise() + model_matrix.topRightCorner<3, 1>();
+    const Eigen::Vector3f center = 0.5f * (positions.rowwise().minCoeff() +
+                                           positions.rowwise().maxCoeff());
+    const Eigen::Vector3i cell =
+        (center / cell_size).array().floor().cast<int>();
+    const BatchKey key(texture_ids[i], cell.x(), cell.y(), cell.z());
+    auto it = batches_by_key.find(key);
+    if (it == batches_by_key.end()) {
+      StaticBatch batch;
+      batch.texture_id = texture_ids[i];
+      batch.min_corner.setConstant(std::numeric_limits<GLfloat>::max());
+      batch.max_corner.setConstant(-std::numeric_limits<GLfloat>::max());
+      it = batches_by_key.insert(std::make_pair(key, batch)).first;
+    }
+    AppendModel(model_matrix, vertices, model->indices(), &it->second);
+  }
+  batches->reserve(batches_by_key.size());
+  for (auto& key_and_batch : batches_by_key) {
+    batches->push_back(std::move(key_and_batch.second));
+  }
+}
+
+StaticBatchRenderer::StaticBatchRenderer() : num_visible_batches_(0) {}
+
+StaticBatchRenderer::~StaticBatchRenderer() {
+  Clear();
+}
+
+void StaticBatchRenderer::Clear() {
+  for (GpuBatch& batch : batches_) {
+    glDeleteVertexArrays(1, &batch.vertex_array_object_id);
+    glDeleteBuffers(1, &batch.vertex_buffer_object_id);
+    glDeleteBuffers(1, &batch.element_buffer_object_id);
+  }
+  batches_.clear();
+}
+
+void StaticBatchRenderer::Build(const std::vector<Model*>& models,
+                                const std::vector<GLuint>& texture_ids,
+                                const GLfloat cell_size) {
+  Clear();
+  std::vector<StaticBatch> batches;
+  BuildStaticBatches(models, texture_ids, cell_size, &batches);
+  for (const StaticBatch& batch : batches) {
+    GpuBatch gpu_batch;
+    gpu_batch.texture_id = batch.texture_id;
+    gpu_batch.min_corner = batch.min_corner;
+    gpu_batch.max_corner = batch.max_corner;
+    gpu_batch.num_indices = batch.indices.size();
+    glGenVertexArrays(1, &gpu_batch.vertex_array_object_id);
+    glBindVertexArray(gpu_batch.vertex_array_object_id);
+    glGenBuffers(1, &gpu_batch.vertex_buffer_object_id);
+    glBindBuffer(GL_ARRAY_BUFFER, gpu_batch.vertex_buffer_object_id);
+    glBufferData(GL_ARRAY_BUFFER, batch.vertices.size() * sizeof(GLfloat),
+                 batch.vertices.data(), GL_STATIC_DRAW);
+    constexpr GLsizei kStride = kNumFloatsPerVertex * sizeof(GLfloat);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, kStride, nullptr);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, kStride,
+                          reinterpret_cast<GLvoid*>(3 * sizeof(GLfloat)));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, kStride,
+                          reinterpret_cast<GLvoid*>(6 * sizeof(GLfloat)));
+    glEnableVertexAttribArray(2);
+    glGenBuffers(1, &gpu_batch.element_buffer_object_id);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, gpu_batch.element_buffer_object_id);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                 batch.indices.size() * sizeof(GLuint), batch.indices.data(),
+                 GL_STATIC_DRAW);
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    batches_.push_back(gpu_batch);
+  }
+}
+
+void StaticBatchRenderer::Draw(const ShaderProgram& shader_program,
+                               const Eigen::Matrix4f& projection,
+                               const Eigen::Matrix4f& view) {
+  num_visible_batches_ = 0;
+  if (batches_.empty()) return;
+  const GLuint program_id = shader_program.shader_program_id();
+  // The vertices are already in world coordinates.
+  const Eigen::Matrix4f model = Eigen::Matrix4f::Identity();
+  glUniformMatrix4fv(glGetUniformLocation(program_id, "model"), 1, GL_FALSE,
+                     model.data());
+  glUniformMatrix4fv(glGetUniformLocation(program_id, "view"), 1, GL_FALSE,
+                     view.data());
+  glUniformMatrix4fv(glGetUniformLocation(program_id, "projection"), 1,
+                     GL_FALSE, projection.data());
+  Eigen::Vector4f planes[kNumFrustumPlanes];
+  ExtractFrustumPlanes(projection * view, planes);
+  glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+  // The batches are sorted by texture, so textures are bound once per group.
+  GLuint bound_texture_id = 0;
+  for (const GpuBatch& batch : batches_) {
+    if (!IsBoxInFrustum(planes, batch.min_corner, batch.max_corner)) {
+      continue;
+    }
+    if (batch.texture_id != bound_texture_id) {
+      glBindTexture(GL_TEXTURE_2D, batch.texture_id);
+      bound_texture_id = batch.texture_id;
+    }
+    glBindVertexArray(batch.vertex_array_object_id);
+    glDrawElements(GL_TRIANGLES, batch.num_indices, GL_UNSIGNED_INT, nullptr);
+    ++num_visible_batches_;
+  }
+  glBindVertexArray(0);
+  glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+}  // namespace wvu
@@ -0,0 +1,148 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef STATIC_BATCHING_H_
+#define STATIC_BATCHING_H_
+
+#include <vector>
+#include <Eigen/Core>
+#include <GL/glew.h>
+
+namespace wvu {
+class Model;
+class ShaderProgram;
+
+// A set of static models sharing a texture and a region of space, merged into
+// a single mesh in world coordinates.
+struct StaticBatch {
+  // Texture shared by all the merged models.
+  GLuint texture_id;
+  // World-space bounding box of the merged models.
+  Eigen::Vector3f min_corner;
+  Eigen::Vector3f max_corner;
+  // Interleaved vertices with the layout of Model::SetVBO: position (3),
+  // color (3), and texel (2).
+  std::vector<GLfloat> vertices;
+  // Triangle indices into the merged vertices.
+  std::vector<GLuint> indices;
+};
+
+// Merges the static models (see Model::is_static) into batches. The vertices
+// of every model are transformed into world coordinates with its model
+// matrix, and the models are grouped by texture and by the cell of a regular
+// grid their bounding box center falls into. The grid keeps the batches small
+// enough to be culled individually. The batches are sorted by texture.
+// Params:
+//   models  The models of the scene. Non-static and transparent models are
+//     skipped.
+//   texture_ids  The texture of every model.
+//   cell_size  The size of the cells of the grid in world units.
+//   batches  The resulting batches.
+void BuildStaticBatches(const std::vector<Model*>& models,
+                        const std::vector<GLuint>& texture_ids,
+                        const GLfloat cell_size,
+                        std::vector<StaticBatch>* batches);
+
+// This class uploads static batches into the GPU and draws the ones inside
+// the view frustum, one draw call per batch. The batches are drawn with the
+// same shader programs as Model::Draw, with an identity model matrix. Usage
+// example:
+//
+// wvu::StaticBatchRenderer static_batch_renderer;
+// static_batch_renderer.Build(models, texture_ids, 10.0f);
+// while (...) {  // Rendering loop.
+//   shader_program.Use();
+//   static_batch_renderer.Draw(shader_program, projection, view);
+//   for (Model* model : models) {
+//     if (!model->is_static()) model->Draw(...);
+//   }
+// }
+class StaticBatchRenderer {
+ public:
+  StaticBatchRenderer();
+  ~StaticBatchRenderer();
+
+  // Builds the batches of the static models and uploads them. Any previous
+  // batches are released.
+  // Params:
+  //   models  The models of the scene. Non-static and transparent models are
+//     skipped.
+  //   texture_ids  The texture of every model.
+  //   cell_size  The size of the cells of the grid in world units.
+  void Build(const std::vector<Model*>& models,
+             const std::vector<GLuint>& texture_ids,
+             const GLfloat cell_size);
+
+  // Draws the batches inside the view frustum. The shader program must be in
+  // use.
+  // Params:
+  //   shader_program  The shader program, with the uniforms of Model::Draw.
+  //   projection  The camera projection matrix.
+  //   view  The camera pose matrix (world -> camera transformation matrix).
+  void Draw(const ShaderProgram& shader_program,
+            const Eigen::Matrix4f& projection,
+            const Eigen::Matrix4f& view);
+
+  // Returns the number of batches.
+  int num_batches() const {
+    return batches_.size();
+  }
+
+  // Returns the number of batches drawn by the last Draw() call.
+  int num_visible_batches() const {
+    return num_visible_batches_;
+  }
+
+ private:
+  // A batch uploaded into the GPU.
+  struct GpuBatch {
+    GLuint texture_id;
+    Eigen::Vector3f min_corner;
+    Eigen::Vector3f max_corner;
+    GLsizei num_indices;
+    GLuint vertex_array_object_id;
+    GLuint vertex_buffer_object_id;
+    GLuint element_buffer_object_id;
+  };
+
+  // Releases the GPU resources of the batches.
+  void Clear();
+
+  std::vector<GpuBatch> batches_;
+  int num_visible_batches_;
+};
+
+}  // namespace wvu
+
+#endif  // STATIC_BATCHING_H_
@@ -0,0 +1,155 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#include "stress_scene.h"
+
+#define _USE_MATH_DEFINES  // For using M_PI.
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include <Eigen/Core>
+#include <GL/glew.h>
+#include <glog/logging.h>
+
+namespace wvu {
+
+void GenerateStressMesh(const int num_triangles,
+                        const float radius,
+                        const int variant,
+                        Eigen::MatrixXf* vertices,
+                        std::vector<GLuint>* indices) {
+  if (vertices == nullptr || indices == nullptr) return;
+  // A grid of rings x segments quads, two triangles each.
+  const int num_rings = std::max(1, static_cast<int>(
+      std::round(std::sqrt(num_triangles / 4.0))));
+  const int num_segments = std::max(3, (num_triangles + 2 * num_rings - 1) /
+                                       (2 * num_rings));
+  const int num_columns = num_segments + 1;
+  vertices->resize(8, (num_rings + 1) * num_columns);
+  const float frequency = variant + 2.0f;
+  for (int ring = 0; ring <= num_rings; ++ring) {
+    const float theta = M_PI * ring / num_rings;
+    for (int segment = 0; segment <= num_segments; ++segment) {
+      const float phi = 2.0f * M_PI * segment / num_segments;
+      const Eigen::Vector3f direction(std::sin(theta) * std::cos(phi),
+                                      std::cos(theta),
+                                      std::sin(theta) * std::sin(phi));
+      const float bump = 1.0f + 0.15f * std::sin(frequency * theta) *
+          std::cos(frequency * phi);
+      const int column = ring * num_columns + segment;
+      vertices->block<3, 1>(0, column) = radius * bump * direction;
+      vertices->block<3, 1>(3, column) =
+          0.5f * (direction + Eigen::Vector3f::Ones());
+      (*vertices)(6, column) = static_cast<float>(segment) / num_segments;
+      (*vertices)(7, column) = static_cast<float>(ring) / num_rings;
+    }
+  }
+  indices->clear();
+  indices->reserve(6 * num_rings * num_segments);
+  for (int ring = 0; ring < num_rings; ++ring) {
+    for (int segment = 0; segment < num_segments; ++segment) {
+      const GLuint top_left = ring * num_columns + segment;
+      const GLuint bottom_left = top_left + num_columns;
+      indices->insert(indices->end(),
+                      {top_left, bottom_left, top_left + 1,
+                       top_left + 1, bottom_left, bottom_left + 1});
+    }
+  }
+}
+
+void GenerateStressScene(const StressSceneOptions& options,
+                         StressScene* scene) {
+  if (scene == nullptr) return;
+  CHECK_GT(options.num_unique_meshes, 0);
+  CHECK_GT(options.num_unique_textures, 0);
+  std::mt19937 engine(options.seed);
+  // About one object per cell of a grid covering the box.
+  const float box_volume = 4.0f * options.extent * options.extent *
+      2.0f * options.extent;
+  const float radius = std::min(
+      0.5f, 0.5f * std::cbrt(box_volume / std::max(1, options.num_objects)));
+
+  scene->mesh_vertices.resize(options.num_unique_meshes);
+  scene->mesh_indices.resize(options.num_unique_meshes);
+  for (int i = 0; i < options.num_unique_meshes; ++i) {
+    GenerateStressMesh(options.triangles_per_mesh, radius, i,
+                       &scene->mesh_vertices[i], &scene->mesh_indices[i]);
+  }
+
+  // Checkerboards of different colors.
+  const int size = options.texture_size;
+  scene->textures.resize(options.num_unique_textures);
+  for (int i = 0; i < options.num_unique_textures; ++i) {
+    const float hue = static_cast<float>(i) / options.num_unique_textures;
+    const uint8_t color[3] = {
+      static_cast<uint8_t>(127.5f * (1.0f + std::cos(2.0f * M_PI * hue))),
+      static_cast<uint8_t>(127.5f * (1.0f + std::cos(2.0f * M_PI *
+                                                     (hue - 1.0f / 3.0f)))),
+      static_cast<uint8_t>(127.5f * (1.0f + std::cos(2.0f * M_PI *
+                                                     (hue - 2.0f / 3.0f))))};
+    std::vector<uint8_t>& pixels = scene->textures[i];
+    pixels.resize(3 * size * size);
+    for (int y = 0; y < size; ++y) {
+      for (int x = 0; x < size; ++x) {
+        const bool is_dark = ((x * 8 / size) + (y * 8 / size)) % 2 == 1;
+        for (int c = 0; c < 3; ++c) {
+          pixels[3 * (y * size + x) + c] = is_dark ? color[c] / 4 : color[c];
+        }
+      }
+    }
+  }
+
+  std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+  std::uniform_real_distribution<float> angle(-M_PI, M_PI);
+  std::uniform_int_distribution<int> mesh_index(
+      0, options.num_unique_meshes - 1);
+  std::uniform_int_distribution<int> texture_index(
+      0, options.num_unique_textures - 1);
+  scene->objects.resize(options.num_objects);
+  for (StressObject& object : scene->objects) {
+    object.position = Eigen::Vector3f(
+        options.extent * (2.0f * unit(engine) - 1.0f),
+        0.5f * options.extent * (2.0f * unit(engine) - 1.0f),
+        -2.0f - 2.0f * options.extent * unit(engine));
+    object.orientation =
+        Eigen::Vector3f(angle(engine), angle(engine), angle(engine));
+    object.mesh_index = mesh_index(engine);
+    object.texture_index = texture_index(engine);
+    object.is_static = unit(engine) < options.static_fraction;
+  }
+}
+
+}  // namespace wvu
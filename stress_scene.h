@@ -0,0 +1,108 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef STRESS_SCENE_H_
+#define STRESS_SCENE_H_
+
+#include <cstdint>
+#include <vector>
+#include <Eigen/Core>
+#include <GL/glew.h>
+
+namespace wvu {
+
+// Parameters of a procedurally generated scene.
+struct StressSceneOptions {
+  StressSceneOptions() :
+      num_objects(1000), triangles_per_mesh(128), num_unique_meshes(8),
+      num_unique_textures(4), static_fraction(0.5f), extent(8.0f),
+      texture_size(64), seed(0) {}
+  int num_objects;
+  // Triangles of every mesh, rounded up to fill a sphere grid.
+  int triangles_per_mesh;
+  int num_unique_meshes;
+  int num_unique_textures;
+  // Fraction of the objects flagged as static.
+  float static_fraction;
+  // The objects are placed in the box [-extent, extent] x [-extent / 2,
+  // extent / 2] x [-2 extent - 2, -2], i.e., in front of a camera at the
+  // origin looking down -z.
+  float extent;
+  // Width and height of the RGB textures.
+  int texture_size;
+  uint32_t seed;
+};
+
+// An object of a stress scene. The orientation is a Rodrigues vector, as in
+// Model.
+struct StressObject {
+  Eigen::Vector3f position;
+  Eigen::Vector3f orientation;
+  int mesh_index;
+  int texture_index;
+  bool is_static;
+};
+
+// A generated scene: the meshes and the textures are shared by the objects.
+struct StressScene {
+  // 8 x n vertex matrices with the layout of Model::SetVBO.
+  std::vector<Eigen::MatrixXf> mesh_vertices;
+  std::vector<std::vector<GLuint> > mesh_indices;
+  // RGB pixels of the textures, row by row.
+  std::vector<std::vector<uint8_t> > textures;
+  std::vector<StressObject> objects;
+};
+
+// Generates a bumpy sphere. Different variants have different bumps.
+// Params:
+//   num_triangles  The minimum number of triangles.
+//   radius  The radius of the sphere without the bumps.
+//   variant  The shape of the bumps.
+//   vertices  The 8 x n vertex matrix with the layout of Model::SetVBO.
+//   indices  Three indices per triangle.
+void GenerateStressMesh(const int num_triangles,
+                        const float radius,
+                        const int variant,
+                        Eigen::MatrixXf* vertices,
+                        std::vector<GLuint>* indices);
+
+// Generates a scene. The same options and seed generate the same scene. The
+// size of the meshes shrinks as the number of objects grows so that the
+// density of the scene stays about the same.
+void GenerateStressScene(const StressSceneOptions& options,
+                         StressScene* scene);
+
+}  // namespace wvu
+
+#endif  // STRESS_SCENE_H_
@@ -0,0 +1,249 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#include "texture_compression.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include <Eigen/Core>
+#include <glog/logging.h>
+
+namespace wvu {
+namespace {
+// Bytes per BC1 block.
+constexpr int kBc1BlockSize = 8;
+// Number of power iterations used to find the principal axis of a block.
+constexpr int kNumPowerIterations = 8;
+
+// Quantizes a color in [0, 255] into RGB565.
+uint16_t ConvertToRgb565(const Eigen::Vector3f& color) {
+  const int red = std::round(std::min(std::max(color.x(), 0.0f), 255.0f) *
+                             31.0f / 255.0f);
+  const int green = std::round(std::min(std::max(color.y(), 0.0f), 255.0f) *
+                               63.0f / 255.0f);
+  const int blue = std::round(std::min(std::max(color.z(), 0.0f), 255.0f) *
+                              31.0f / 255.0f);
+  return (red << 11) | (green << 5) | blue;
+}
+
+// Expands an RGB565 color to 8 bits per channel, as the GPU does.
+Eigen::Vector3i ConvertFromRgb565(const uint16_t color) {
+  const int red = (color >> 11) & 0x1f;
+  const int green = (color >> 5) & 0x3f;
+  const int blue = color & 0x1f;
+  return Eigen::Vector3i((red << 3) | (red >> 2), (green << 2) | (green >> 4),
+                         (blue << 3) | (blue >> 2));
+}
+
+// Computes the four colors of a block from its endpoints.
+void ComputePalette(const uint16_t color0,
+                    const uint16_t color1,
+                    Eigen::Vector3i palette[4]) {
+  palette[0] = ConvertFromRgb565(color0);
+  palette[1] = ConvertFromRgb565(color1);
+  if (color0 > color1) {
+    palette[2] = (2 * palette[0] + palette[1]) / 3;
+    palette[3] = (palette[0] + 2 * palette[1]) / 3;
+  } else {
+    // Three-color mode; the fourth color is black.
+    palette[2] = (palette[0] + palette[1]) / 2;
+    palette[3].setZero();
+  }
+}
+
+// Compresses the 16 pixels of a block, in row-major order.
+void CompressBlock(const Eigen::Vector3f pixels[16], uint8_t block[8]) {
+  Eigen::Vector3f mean = Eigen::Vector3f::Zero();
+  for (int i = 0; i < 16; ++i) mean += pixels[i];
+  mean /= 16.0f;
+  Eigen::Matrix3f covariance = Eigen::Matrix3f::Zero();
+  for (int i = 0; i < 16; ++i) {
+    const Eigen::Vector3f centered = pixels[i] - mean;
+    covariance += centered * centered.transpose();
+  }
+  // The principal axis of the colors, by power iteration. It starts from the
+  // column of the channel with the largest variance, which cannot be
+  // orthogonal to the axis unless the block is flat.
+  int max_variance_channel;
+  covariance.diagonal().maxCoeff(&max_variance_channel);
+  Eigen::Vector3f axis = covariance.col(max_variance_channel);
+  if (axis.squaredNorm() < 1e-6f) axis = Eigen::Vector3f::Ones();
+  for (int i = 0; i < kNumPowerIterations; ++i) {
+    const Eigen::Vector3f next_axis = covariance * axis;
+    const float norm = next_axis.norm();
+    if (norm < 1e-6f) break;
+    axis = next_axis / norm;
+  }
+  axis.normalize();
+  float min_projection = 0.0f;
+  float max_projection = 0.0f;
+  for (int i = 0; i < 16; ++i) {
+    const float projection = (pixels[i] - mean).dot(axis);
+    min_projection = std::min(min_projection, projection);
+    max_projection = std::max(max_projection, projection);
+  }
+  uint16_t color0 = ConvertToRgb565(mean + max_projection * axis);
+  uint16_t color1 = ConvertToRgb565(mean + min_projection * axis);
+  // The four-color mode needs color0 > color1.
+  if (color0 < color1) std::swap(color0, color1);
+  uint32_t indices = 0;
+  if (color0 != color1) {
+    Eigen::Vector3i palette[4];
+    ComputePalette(color0, color1, palette);
+    for (int i = 0; i < 16; ++i) {
+      int best_index = 0;
+      float best_distance = std::numeric_limits<float>::max();
+      for (int j = 0; j < 4; ++j) {
+        const float distance =
+            (palette[j].cast<float>() - pixels[i]).squaredNorm();
+        if (distance < best_distance) {
+          best_distance = distance;
+          best_index = j;
+        }
+      }
+      indices |= best_index << (2 * i);
+    }
+  }
+  block[0] = color0 & 0xff;
+  block[1] = color0 >> 8;
+  block[2] = color1 & 0xff;
+  block[3] = color1 >> 8;
+  for (int i = 0; i < 4; ++i) {
+    block[4 + i] = (indices >> (8 * i)) & 0xff;
+  }
+}
+
+int GetNumBlocks(const int size) {
+  return (size + 3) / 4;
+}
+
+}  // namespace
+
+void GenerateMipmaps(const int width,
+                     const int height,
+                     const std::vector<uint8_t>& rgb_pixels,
+                     std::vector<MipLevel>* levels) {
+  if (levels == nullptr) return;
+  CHECK_EQ(rgb_pixels.size(), 3 * width * height);
+  levels->clear();
+  levels->push_back({width, height, rgb_pixels});
+  while (levels->back().width > 1 || levels->back().height > 1) {
+    const MipLevel& previous = levels->back();
+    MipLevel level;
+    level.width = std::max(previous.width / 2, 1);
+    level.height = std::max(previous.height / 2, 1);
+    level.data.resize(3 * level.width * level.height);
+    for (int y = 0; y < level.height; ++y) {
+      // Odd dimensions clamp the last row or column.
+      const int y0 = std::min(2 * y, previous.height - 1);
+      const int y1 = std::min(2 * y + 1, previous.height - 1);
+      for (int x = 0; x < level.width; ++x) {
+        const int x0 = std::min(2 * x, previous.width - 1);
+        const int x1 = std::min(2 * x + 1, previous.width - 1);
+        for (int c = 0; c < 3; ++c) {
+          const int sum = previous.data[3 * (y0 * previous.width + x0) + c] +
+              previous.data[3 * (y0 * previous.width + x1) + c] +
+              previous.data[3 * (y1 * previous.width + x0) + c] +
+              previous.data[3 * (y1 * previous.width + x1) + c];
+          level.data[3 * (y * level.width + x) + c] = (sum + 2) / 4;
+        }
+      }
+    }
+    levels->push_back(std::move(level));
+  }
+}
+
+int GetBc1Size(const int width, const int height) {
+  return kBc1BlockSize * GetNumBlocks(width) * GetNumBlocks(height);
+}
+
+void CompressBc1(const int width,
+                 const int height,
+                 const std::vector<uint8_t>& rgb_pixels,
+                 std::vector<uint8_t>* blocks) {
+  if (blocks == nullptr) return;
+  CHECK_EQ(rgb_pixels.size(), 3 * width * height);
+  blocks->resize(GetBc1Size(width, height));
+  uint8_t* block = blocks->data();
+  Eigen::Vector3f pixels[16];
+  for (int block_y = 0; block_y < GetNumBlocks(height); ++block_y) {
+    for (int block_x = 0; block_x < GetNumBlocks(width); ++block_x) {
+      for (int i = 0; i < 16; ++i) {
+        // Partial blocks repeat the border pixels.
+        const int x = std::min(4 * block_x + i % 4, width - 1);
+        const int y = std::min(4 * block_y + i / 4, height - 1);
+        const uint8_t* pixel = &rgb_pixels[3 * (y * width + x)];
+        pixels[i] = Eigen::Vector3f(pixel[0], pixel[1], pixel[2]);
+      }
+      CompressBlock(pixels, block);
+      block += kBc1BlockSize;
+    }
+  }
+}
+
+void DecompressBc1(const int width,
+                   const int height,
+                   const std::vector<uint8_t>& blocks,
+                   std::vector<uint8_t>* rgb_pixels) {
+  if (rgb_pixels == nullptr) return;
+  CHECK_EQ(blocks.size(), GetBc1Size(width, height));
+  rgb_pixels->resize(3 * width * height);
+  const uint8_t* block = blocks.data();
+  Eigen::Vector3i palette[4];
+  for (int block_y = 0; block_y < GetNumBlocks(height); ++block_y) {
+    for (int block_x = 0; block_x < GetNumBlocks(width); ++block_x) {
+      const uint16_t color0 = block[0] | (block[1] << 8);
+      const uint16_t color1 = block[2] | (block[3] << 8);
+      const uint32_t indices = block[4] | (block[5] << 8) |
+          (block[6] << 16) | (static_cast<uint32_t>(block[7]) << 24);
+      ComputePalette(color0, color1, palette);
+      for (int i = 0; i < 16; ++i) {
+        const int x = 4 * block_x + i % 4;
+        const int y = 4 * block_y + i / 4;
+        if (x >= width || y >= height) continue;
+        const Eigen::Vector3i& color = palette[(indices >> (2 * i)) & 3];
+        uint8_t* pixel = &(*rgb_pixels)[3 * (y * width + x)];
+        pixel[0] = color.x();
+        pixel[1] = color.y();
+        pixel[2] = color.z();
+      }
+      block += kBc1BlockSize;
+    }
+  }
+}
+
+}  // namespace wvu
@@ -0,0 +1,94 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef TEXTURE_COMPRESSION_H_
+#define TEXTURE_COMPRESSION_H_
+
+#include <cstdint>
+#include <vector>
+
+namespace wvu {
+
+// A level of a mipmap chain. The data is either interleaved RGB8 pixels in
+// row-major order or BC1 blocks, depending on the texture it belongs to.
+struct MipLevel {
+  int width;
+  int height;
+  std::vector<uint8_t> data;
+};
+
+// Builds the full mipmap chain of an RGB8 image, down to 1 x 1, with a 2 x 2
+// box filter. The first level is the image itself.
+// Params:
+//   width  The width of the image in pixels.
+//   height  The height of the image in pixels.
+//   rgb_pixels  The interleaved RGB8 pixels in row-major order.
+//   levels  The levels, the largest first.
+void GenerateMipmaps(const int width,
+                     const int height,
+                     const std::vector<uint8_t>& rgb_pixels,
+                     std::vector<MipLevel>* levels);
+
+// Returns the number of bytes of a BC1 (DXT1) compressed image: 8 bytes per
+// 4 x 4 block, with partial blocks at the borders.
+int GetBc1Size(const int width, const int height);
+
+// Compresses an RGB8 image into BC1 (GL_COMPRESSED_RGB_S3TC_DXT1_EXT)
+// blocks. The endpoints of every block are fit along the principal axis of
+// its colors, so the blocks always use the four-color mode.
+// Params:
+//   width  The width of the image in pixels.
+//   height  The height of the image in pixels.
+//   rgb_pixels  The interleaved RGB8 pixels in row-major order.
+//   blocks  The blocks in row-major order.
+void CompressBc1(const int width,
+                 const int height,
+                 const std::vector<uint8_t>& rgb_pixels,
+                 std::vector<uint8_t>* blocks);
+
+// Decompresses BC1 blocks into an RGB8 image. Used when the GPU does not
+// support S3TC textures.
+// Params:
+//   width  The width of the image in pixels.
+//   height  The height of the image in pixels.
+//   blocks  The blocks in row-major order.
+//   rgb_pixels  The interleaved RGB8 pixels in row-major order.
+void DecompressBc1(const int width,
+                   const int height,
+                   const std::vector<uint8_t>& blocks,
+                   std::vector<uint8_t>* rgb_pixels);
+
+}  // namespace wvu
+
+#endif  // TEXTURE_COMPRESSION_H_
@@ -0,0 +1,131 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace wvu {
+
+ThreadPool::ThreadPool(const int num_threads) :
+    num_running_tasks_(0), stop_requested_(false) {
+  for (int i = 0; i < std::max(num_threads, 1); ++i) {
+    workers_.emplace_back(&ThreadPool::Run, this);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_requested_ = true;
+  }
+  task_available_.notify_all();
+  for (std::thread& worker : workers_) {
+    worker.join();
+  }
+}
+
+void ThreadPool::Schedule(const std::function<void()>& task) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks_.push_back(task);
+  }
+  task_available_.notify_one();
+}
+
+void ThreadPool::Wait() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  tasks_done_.wait(lock, [this] {
+    return tasks_.empty() && num_running_tasks_ == 0;
+  });
+}
+
+void ThreadPool::Run() {
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      task_available_.wait(lock, [this] {
+        return stop_requested_ || !tasks_.empty();
+      });
+      // The queued tasks are run before stopping.
+      if (tasks_.empty()) return;
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+      ++num_running_tasks_;
+    }
+    task();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      --num_running_tasks_;
+      if (tasks_.empty() && num_running_tasks_ == 0) {
+        tasks_done_.notify_all();
+      }
+    }
+  }
+}
+
+void ParallelFor(const int num_items,
+                 const int min_items_per_range,
+                 ThreadPool* thread_pool,
+                 const std::function<void(int, int)>& body) {
+  const int num_ranges = thread_pool == nullptr ? 1 :
+      std::min(thread_pool->num_threads(),
+               num_items / std::max(min_items_per_range, 1));
+  if (num_ranges <= 1) {
+    body(0, num_items);
+    return;
+  }
+  std::mutex mutex;
+  std::condition_variable ranges_done;
+  int num_pending_ranges = num_ranges;
+  for (int i = 0; i < num_ranges; ++i) {
+    const int begin = i * num_items / num_ranges;
+    const int end = (i + 1) * num_items / num_ranges;
+    thread_pool->Schedule([&, begin, end] {
+      body(begin, end);
+      std::lock_guard<std::mutex> lock(mutex);
+      if (--num_pending_ranges == 0) ranges_done.notify_one();
+    });
+  }
+  std::unique_lock<std::mutex> lock(mutex);
+  ranges_done.wait(lock, [&] { return num_pending_ranges == 0; });
+}
+
+}  // namespace wvu
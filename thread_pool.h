@@ -0,0 +1,105 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace wvu {
+
+// A fixed set of worker threads running tasks in the order they were
+// scheduled. The destructor runs the tasks still queued before joining the
+// workers. Usage example:
+//
+// wvu::ThreadPool thread_pool(4);
+// for (...) {
+//   thread_pool.Schedule([...] { ... });
+// }
+// thread_pool.Wait();  // All the tasks are done.
+class ThreadPool {
+ public:
+  // Params:
+  //   num_threads  The number of workers. At least one worker is created.
+  explicit ThreadPool(const int num_threads);
+  ~ThreadPool();
+
+  // Queues a task. It runs on one of the workers.
+  void Schedule(const std::function<void()>& task);
+
+  // Blocks until all the scheduled tasks have finished.
+  void Wait();
+
+  // Returns the number of workers.
+  int num_threads() const {
+    return workers_.size();
+  }
+
+ private:
+  // Body of the workers.
+  void Run();
+
+  std::vector<std::thread> workers_;
+  // Queued tasks and the number of tasks running, guarded by mutex_.
+  std::mutex mutex_;
+  std::condition_variable task_available_;
+  std::condition_variable tasks_done_;
+  std::deque<std::function<void()> > tasks_;
+  int num_running_tasks_;
+  bool stop_requested_;
+};
+
+// Runs body(begin, end) on contiguous ranges covering [0, num_items), one
+// range per worker, and blocks until all of them are done. It only waits
+// for its own tasks, so the pool can be shared with other work.
+// Params:
+//   num_items  The number of items.
+//   min_items_per_range  The ranges are not split below this size: small
+//     inputs run on the calling thread.
+//   thread_pool  The pool the ranges run on, or nullptr to run them on the
+//     calling thread.
+//   body  The function processing a range.
+void ParallelFor(const int num_items,
+                 const int min_items_per_range,
+                 ThreadPool* thread_pool,
+                 const std::function<void(int, int)>& body);
+
+}  // namespace wvu
+
+#endif  // THREAD_POOL_H_
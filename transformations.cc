@@ -33,6 +33,7 @@
 // Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
 
 #include "transformations.h"
+#include <cmath>
 #include <Eigen/Core>
 #include <Eigen/Geometry>
 
@@ -59,6 +60,56 @@ Eigen::Matrix4f ComputeRotationMatrix(const Eigen::Vector3f& rotation_axis,
   return transformation;
 }
 
+// Compute rotation transformation matrix.
+// Params:
+//   rotation  The rotation as a unit quaternion.
+Eigen::Matrix4f ComputeRotationMatrix(const Eigen::Quaternionf& rotation) {
+  Eigen::Matrix4f transformation = Eigen::Matrix4f::Identity();
+  transformation.block<3, 3>(0, 0) = rotation.toRotationMatrix();
+  return transformation;
+}
+
+Eigen::Quaternionf ConvertRodriguesToQuaternion(
+    const Eigen::Vector3f& rodrigues) {
+  const float angle = rodrigues.norm();
+  if (angle == 0.0f) return Eigen::Quaternionf::Identity();
+  return Eigen::Quaternionf(Eigen::AngleAxisf(angle, rodrigues / angle));
+}
+
+Eigen::Vector3f ConvertQuaternionToRodrigues(
+    const Eigen::Quaternionf& rotation) {
+  const Eigen::AngleAxisf angle_axis(rotation);
+  return angle_axis.angle() * angle_axis.axis();
+}
+
+Eigen::Quaternionf Slerp(const Eigen::Quaternionf& from,
+                         const Eigen::Quaternionf& to,
+                         const float t) {
+  // q and -q are the same rotation: the shortest arc goes to the closest.
+  float cos_angle = from.dot(to);
+  const float sign = cos_angle < 0.0f ? -1.0f : 1.0f;
+  cos_angle *= sign;
+  float from_weight = 1.0f - t;
+  float to_weight = t;
+  // Nearly equal rotations: the interpolation is linear.
+  if (cos_angle < 1.0f - 1e-6f) {
+    const float angle = std::acos(cos_angle);
+    const float inverse_sin_angle = 1.0f / std::sin(angle);
+    from_weight = std::sin((1.0f - t) * angle) * inverse_sin_angle;
+    to_weight = std::sin(t * angle) * inverse_sin_angle;
+  }
+  return Eigen::Quaternionf(from_weight * from.coeffs() +
+                            sign * to_weight * to.coeffs());
+}
+
+Eigen::Quaternionf Nlerp(const Eigen::Quaternionf& from,
+                         const Eigen::Quaternionf& to,
+                         const float t) {
+  const float sign = from.dot(to) < 0.0f ? -1.0f : 1.0f;
+  return Eigen::Quaternionf((1.0f - t) * from.coeffs() +
+                            sign * t * to.coeffs()).normalized();
+}
+
 // Compute scaling transformation matrix.
 // Params:
 //   scale  Scale factor.
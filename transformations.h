@@ -33,6 +33,7 @@
 // Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
 
 #include <Eigen/Core>
+#include <Eigen/Geometry>
 
 namespace wvu {
 // Compute translation transformation matrix.
@@ -47,6 +48,48 @@ Eigen::Matrix4f ComputeTranslationMatrix(const Eigen::Vector3f& offset);
 Eigen::Matrix4f ComputeRotationMatrix(const Eigen::Vector3f& rotation_axis,
                                       const float angle_in_radians);
 
+// Compute rotation transformation matrix.
+// Params:
+//   rotation  The rotation as a unit quaternion.
+Eigen::Matrix4f ComputeRotationMatrix(const Eigen::Quaternionf& rotation);
+
+// Converts a Rodrigues vector (angle-axis vector where the angle is the norm
+// of the vector) into a unit quaternion.
+// Params:
+//   rodrigues  The Rodrigues vector.
+Eigen::Quaternionf ConvertRodriguesToQuaternion(
+    const Eigen::Vector3f& rodrigues);
+
+// Converts a unit quaternion into a Rodrigues vector with an angle in
+// [0, pi].
+// Params:
+//   rotation  The unit quaternion.
+Eigen::Vector3f ConvertQuaternionToRodrigues(
+    const Eigen::Quaternionf& rotation);
+
+// Spherical linear interpolation between two rotations: the rotation at a
+// constant angular velocity along the shortest arc. The batched version is
+// SlerpQuatBatch (see simd_math.h).
+// Params:
+//   from  The unit quaternion for t = 0.
+//   to  The unit quaternion for t = 1.
+//   t  The interpolation parameter in [0, 1].
+Eigen::Quaternionf Slerp(const Eigen::Quaternionf& from,
+                         const Eigen::Quaternionf& to,
+                         const float t);
+
+// Normalized linear interpolation between two rotations. It follows the
+// shortest arc of Slerp but not at a constant angular velocity, which is
+// hardly noticeable between close rotations, e.g., animation keys, and is
+// cheaper. The batched version is NlerpQuatBatch (see simd_math.h).
+// Params:
+//   from  The unit quaternion for t = 0.
+//   to  The unit quaternion for t = 1.
+//   t  The interpolation parameter in [0, 1].
+Eigen::Quaternionf Nlerp(const Eigen::Quaternionf& from,
+                         const Eigen::Quaternionf& to,
+                         const float t);
+
 // Compute scaling transformation matrix.
 // Params:
 //   scale  Scale factor.
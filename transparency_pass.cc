@@ -0,0 +1,278 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#include "transparency_pass.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <Eigen/Core>
+#include <GL/glew.h>
+
+#include "model.h"
+#include "shader_program.h"
+
+namespace wvu {
+namespace {
+// Texture units used by the composite pass.
+constexpr GLint kAccumulationTextureUnit = 0;
+constexpr GLint kRevealageTextureUnit = 1;
+
+const std::string accumulation_vertex_shader_src =
+    "#version 330 core\n"
+    "layout (location = 0) in vec3 position;\n"
+    "layout (location = 1) in vec3 passed_color;\n"
+    "layout (location = 2) in vec2 passed_texel;\n"
+    "uniform mat4 model;\n"
+    "uniform mat4 view;\n"
+    "uniform mat4 projection;\n"
+    "out vec2 texel;\n"
+    "void main() {\n"
+    "  gl_Position = projection * view * model * vec4(position, 1.0f);\n"
+    "  texel = passed_texel;\n"
+    "}\n";
+
+// The weight function mirrors ComputeTransparencyWeight.
+const std::string accumulation_fragment_shader_src =
+    "#version 330 core\n"
+    "in vec2 texel;\n"
+    "layout (location = 0) out vec4 accumulation;\n"
+    "layout (location = 1) out float revealage;\n"
+    "uniform sampler2D texture_sampler;\n"
+    "uniform float opacity;\n"
+    "float ComputeWeight(float depth, float alpha) {\n"
+    "  float distance = 1.0f - depth;\n"
+    "  return alpha * clamp(3e3f * distance * distance * distance, 1e-2f,\n"
+    "                       3e3f);\n"
+    "}\n"
+    "void main() {\n"
+    "  vec4 color = texture(texture_sampler, texel);\n"
+    "  float alpha = color.a * opacity;\n"
+    "  float weight = ComputeWeight(gl_FragCoord.z, alpha);\n"
+    "  accumulation = vec4(color.rgb, 1.0f) * weight;\n"
+    "  revealage = alpha;\n"
+    "}\n";
+
+// Generates a full-screen triangle from gl_VertexID.
+const std::string composite_vertex_shader_src =
+    "#version 330 core\n"
+    "void main() {\n"
+    "  vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);\n"
+    "  gl_Position = vec4(2.0f * position - 1.0f, 0.0f, 1.0f);\n"
+    "}\n";
+
+const std::string composite_fragment_shader_src =
+    "#version 330 core\n"
+    "out vec4 color;\n"
+    "uniform sampler2D accumulation_sampler;\n"
+    "uniform sampler2D revealage_sampler;\n"
+    "void main() {\n"
+    "  ivec2 pixel = ivec2(gl_FragCoord.xy);\n"
+    "  float revealage = texelFetch(revealage_sampler, pixel, 0).r;\n"
+    "  // Nothing transparent covers this pixel.\n"
+    "  if (revealage >= 1.0f) {\n"
+    "    discard;\n"
+    "  }\n"
+    "  vec4 accumulation = texelFetch(accumulation_sampler, pixel, 0);\n"
+    "  vec3 average_color =\n"
+    "      accumulation.rgb / clamp(accumulation.a, 1e-4f, 5e4f);\n"
+    "  color = vec4(average_color, revealage);\n"
+    "}\n";
+
+GLuint CreateAttachment(const GLenum internal_format,
+                        const GLenum format,
+                        const GLenum type,
+                        const GLenum attachment,
+                        const int width,
+                        const int height) {
+  GLuint texture_id;
+  glGenTextures(1, &texture_id);
+  glBindTexture(GL_TEXTURE_2D, texture_id);
+  glTexImage2D(GL_TEXTURE_2D, 0, internal_format, width, height, 0, format,
+               type, nullptr);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D,
+                         texture_id, 0);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  return texture_id;
+}
+
+bool CreateProgram(const std::string& vertex_shader_src,
+                   const std::string& fragment_shader_src,
+                   ShaderProgram* shader_program,
+                   std::string* error_info_log) {
+  shader_program->LoadVertexShaderFromString(vertex_shader_src);
+  shader_program->LoadFragmentShaderFromString(fragment_shader_src);
+  return shader_program->Create(error_info_log);
+}
+
+}  // namespace
+
+GLfloat ComputeTransparencyWeight(const GLfloat depth, const GLfloat alpha) {
+  const GLfloat distance = 1.0f - depth;
+  return alpha *
+      std::min(std::max(3e3f * distance * distance * distance, 1e-2f), 3e3f);
+}
+
+TransparencyPass::TransparencyPass() :
+    width_(0), height_(0), default_framebuffer_id_(0), framebuffer_id_(0),
+    accumulation_texture_id_(0),
+    revealage_texture_id_(0), depth_renderbuffer_id_(0),
+    empty_vertex_array_object_id_(0) {}
+
+TransparencyPass::~TransparencyPass() {
+  glDeleteFramebuffers(1, &framebuffer_id_);
+  glDeleteTextures(1, &accumulation_texture_id_);
+  glDeleteTextures(1, &revealage_texture_id_);
+  glDeleteRenderbuffers(1, &depth_renderbuffer_id_);
+  glDeleteVertexArrays(1, &empty_vertex_array_object_id_);
+}
+
+bool TransparencyPass::IsSupported() {
+  GLint major_version = 0;
+  glGetIntegerv(GL_MAJOR_VERSION, &major_version);
+  return major_version >= 4;
+}
+
+bool TransparencyPass::Initialize(const int width,
+                                  const int height,
+                                  std::string* error_info_log) {
+  width_ = width;
+  height_ = height;
+  if (!CreateProgram(accumulation_vertex_shader_src,
+                     accumulation_fragment_shader_src,
+                     &accumulation_shader_program_, error_info_log) ||
+      !CreateProgram(composite_vertex_shader_src,
+                     composite_fragment_shader_src,
+                     &composite_shader_program_, error_info_log)) {
+    return false;
+  }
+  glGenFramebuffers(1, &framebuffer_id_);
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_id_);
+  accumulation_texture_id_ = CreateAttachment(GL_RGBA16F, GL_RGBA, GL_FLOAT,
+                                              GL_COLOR_ATTACHMENT0,
+                                              width_, height_);
+  revealage_texture_id_ = CreateAttachment(GL_R8, GL_RED, GL_UNSIGNED_BYTE,
+                                           GL_COLOR_ATTACHMENT1,
+                                           width_, height_);
+  // The depth format matches the usual default framebuffer format so the
+  // opaque depth can be blitted into it.
+  glGenRenderbuffers(1, &depth_renderbuffer_id_);
+  glBindRenderbuffer(GL_RENDERBUFFER, depth_renderbuffer_id_);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width_,
+                        height_);
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT,
+                            GL_RENDERBUFFER, depth_renderbuffer_id_);
+  const GLenum draw_buffers[] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+  glDrawBuffers(2, draw_buffers);
+  const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  if (status != GL_FRAMEBUFFER_COMPLETE) {
+    if (error_info_log) {
+      *error_info_log = "The transparency framebuffer is incomplete.";
+    }
+    return false;
+  }
+  glGenVertexArrays(1, &empty_vertex_array_object_id_);
+
+  // The sampler bindings never change, so they are set once.
+  const GLuint program_id = composite_shader_program_.shader_program_id();
+  composite_shader_program_.Use();
+  glUniform1i(glGetUniformLocation(program_id, "accumulation_sampler"),
+              kAccumulationTextureUnit);
+  glUniform1i(glGetUniformLocation(program_id, "revealage_sampler"),
+              kRevealageTextureUnit);
+  glUseProgram(0);
+  return true;
+}
+
+void TransparencyPass::Begin() {
+  // The transparent models are occluded by the opaque ones.
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, default_framebuffer_id_);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer_id_);
+  glBlitFramebuffer(0, 0, width_, height_, 0, 0, width_, height_,
+                    GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_id_);
+  glViewport(0, 0, width_, height_);
+  const GLfloat zero[] = {0.0f, 0.0f, 0.0f, 0.0f};
+  const GLfloat one[] = {1.0f, 1.0f, 1.0f, 1.0f};
+  glClearBufferfv(GL_COLOR, 0, zero);
+  glClearBufferfv(GL_COLOR, 1, one);
+  // Depth-tested but not depth-written: every transparent fragment in front
+  // of the opaque scene contributes.
+  glEnable(GL_DEPTH_TEST);
+  glDepthMask(GL_FALSE);
+  glEnable(GL_BLEND);
+  glBlendFunci(0, GL_ONE, GL_ONE);
+  glBlendFunci(1, GL_ZERO, GL_ONE_MINUS_SRC_COLOR);
+  accumulation_shader_program_.Use();
+}
+
+void TransparencyPass::Draw(Model* model,
+                            const Eigen::Matrix4f& projection,
+                            const Eigen::Matrix4f& view,
+                            const GLuint texture_id) {
+  glUniform1f(glGetUniformLocation(
+      accumulation_shader_program_.shader_program_id(), "opacity"),
+              model->opacity());
+  model->Draw(accumulation_shader_program_, projection, view, texture_id);
+}
+
+void TransparencyPass::Composite() {
+  glBindFramebuffer(GL_FRAMEBUFFER, default_framebuffer_id_);
+  glDepthMask(GL_TRUE);
+  glDisable(GL_DEPTH_TEST);
+  // The revealage is the fraction of the opaque color that remains.
+  glBlendFunc(GL_ONE_MINUS_SRC_ALPHA, GL_SRC_ALPHA);
+  composite_shader_program_.Use();
+  glActiveTexture(GL_TEXTURE0 + kAccumulationTextureUnit);
+  glBindTexture(GL_TEXTURE_2D, accumulation_texture_id_);
+  glActiveTexture(GL_TEXTURE0 + kRevealageTextureUnit);
+  glBindTexture(GL_TEXTURE_2D, revealage_texture_id_);
+  glBindVertexArray(empty_vertex_array_object_id_);
+  glDrawArrays(GL_TRIANGLES, 0, 3);
+  glBindVertexArray(0);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glDisable(GL_BLEND);
+  glEnable(GL_DEPTH_TEST);
+  glUseProgram(0);
+}
+
+}  // namespace wvu
@@ -0,0 +1,154 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef TRANSPARENCY_PASS_H_
+#define TRANSPARENCY_PASS_H_
+
+#include <string>
+#include <Eigen/Core>
+#include <GL/glew.h>
+
+#include "shader_program.h"
+
+namespace wvu {
+class Model;
+
+// Returns the weight of a transparent fragment in the weighted blended
+// order-independent transparency accumulation (McGuire and Bavoil, 2013,
+// equation 10). The weight includes the opacity of the fragment: closer and
+// more opaque fragments get larger weights, so they dominate the average
+// color. The transparency shader evaluates the same function.
+// Params:
+//   depth  The window-space depth of the fragment in [0, 1].
+//   alpha  The opacity of the fragment in [0, 1].
+GLfloat ComputeTransparencyWeight(const GLfloat depth, const GLfloat alpha);
+
+// This class renders transparent models with weighted blended
+// order-independent transparency. Instead of sorting the models back to
+// front, every transparent fragment is accumulated into two render targets:
+//   - Accumulation: RGBA16F with the sums of the colors and of the weights
+//     given by ComputeTransparencyWeight, i.e., the weighted sum of the
+//     premultiplied colors and of the opacities. Blended additively.
+//   - Revealage: R8 with the product of (1 - alpha) of all the fragments,
+//     i.e., how much of the background shows through. Blended
+//     multiplicatively.
+// The composite pass then blends the weighted average color over the opaque
+// scene using the revealage. The result does not depend on the draw order,
+// so transparent models can be drawn in any order and batched by state, and
+// intersecting models are handled without artifacts.
+//
+// The transparent models are depth-tested against the depth of the opaque
+// scene, which is copied from the default framebuffer. The pass requires
+// per-render-target blend functions (OpenGL 4.0). Usage example:
+//
+// wvu::TransparencyPass transparency_pass;
+// std::string error_info_log;
+// if (!transparency_pass.Initialize(width, height, &error_info_log)) {
+//   LOG(ERROR) << error_info_log;
+// }
+// ...
+// while (...) {  // Rendering loop.
+//   ...  // Render the opaque models.
+//   transparency_pass.Begin();
+//   for (Model* model : transparent_models) {
+//     transparency_pass.Draw(model, projection, view, texture_id);
+//   }
+//   transparency_pass.Composite();
+// }
+class TransparencyPass {
+ public:
+  TransparencyPass();
+  ~TransparencyPass();
+
+  // Returns true when the current OpenGL context supports per-render-target
+  // blend functions.
+  static bool IsSupported();
+
+  // Creates the render targets and compiles the shader programs. Returns true
+  // upon success and false otherwise.
+  // Params:
+  //   width  The width of the default framebuffer in pixels.
+  //   height  The height of the default framebuffer in pixels.
+  //   error_info_log  A pointer to a string that holds the error log.
+  bool Initialize(const int width,
+                  const int height,
+                  std::string* error_info_log);
+
+  // Copies the opaque depth, clears the render targets, and sets up the
+  // blend state and the shader program for the transparent models.
+  void Begin();
+
+  // Accumulates a model with its opacity. Must be called between Begin()
+  // and Composite().
+  // Params:
+  //   model  The model to draw.
+  //   projection  The camera projection matrix.
+  //   view  The camera pose matrix (world -> camera transformation matrix).
+  //   texture_id  The texture of the model.
+  void Draw(Model* model,
+            const Eigen::Matrix4f& projection,
+            const Eigen::Matrix4f& view,
+            const GLuint texture_id);
+
+  // Restores the default framebuffer and blends the accumulated transparent
+  // models over it.
+  void Composite();
+
+  // Sets the framebuffer used in place of the default framebuffer, e.g., an
+  // OffscreenFramebuffer in a headless context. Its dimensions must match.
+  void set_default_framebuffer_id(const GLuint framebuffer_id) {
+    default_framebuffer_id_ = framebuffer_id;
+  }
+
+ private:
+  // Dimensions of the render targets.
+  int width_;
+  int height_;
+  // Framebuffer holding the opaque scene, 0 for the default framebuffer.
+  GLuint default_framebuffer_id_;
+  // Framebuffer object and its attachments.
+  GLuint framebuffer_id_;
+  GLuint accumulation_texture_id_;
+  GLuint revealage_texture_id_;
+  GLuint depth_renderbuffer_id_;
+  // Empty vertex array object used to draw the full-screen triangle.
+  GLuint empty_vertex_array_object_id_;
+  // Shader programs.
+  ShaderProgram accumulation_shader_program_;
+  ShaderProgram composite_shader_program_;
+};
+
+}  // namespace wvu
+
+#endif  // TRANSPARENCY_PASS_H_
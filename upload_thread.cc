@@ -0,0 +1,222 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#include "upload_thread.h"
+
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <Eigen/Core>
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include "spsc_queue.h"
+
+namespace wvu {
+namespace {
+// Maximum number of uploads waiting to be polled. The thread waits when the
+// main thread falls this far behind.
+constexpr int kMaxNumCompletedUploads = 64;
+
+// Deletes the GPU objects of a resource. Zero ids are ignored by OpenGL.
+void DeleteResource(const UploadedResource& resource) {
+  const GLuint buffer_ids[] = {resource.vertex_buffer_object_id,
+                               resource.element_buffer_object_id};
+  glDeleteBuffers(2, buffer_ids);
+  glDeleteTextures(1, &resource.texture_id);
+}
+
+}  // namespace
+
+UploadThread::UploadThread() :
+    upload_window_(nullptr), stop_requested_(false), next_request_id_(0),
+    completed_uploads_(kMaxNumCompletedUploads) {}
+
+UploadThread::~UploadThread() {
+  Stop();
+}
+
+bool UploadThread::Start(GLFWwindow* main_window,
+                         std::string* error_info_log) {
+  if (main_window == nullptr) return false;
+  // The window hints of the main window are still set, so the shared context
+  // gets the same version and profile.
+  glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+  upload_window_ = glfwCreateWindow(1, 1, "Upload", nullptr, main_window);
+  glfwWindowHint(GLFW_VISIBLE, GL_TRUE);
+  if (upload_window_ == nullptr) {
+    if (error_info_log) {
+      *error_info_log = "Could not create the shared upload context.";
+    }
+    return false;
+  }
+  stop_requested_ = false;
+  thread_ = std::thread(&UploadThread::Run, this);
+  return true;
+}
+
+void UploadThread::Stop() {
+  if (!thread_.joinable()) return;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_requested_ = true;
+    requests_.clear();
+  }
+  condition_.notify_one();
+  thread_.join();
+  // The objects are shared, so the main context can delete them.
+  CompletedUpload* completed_upload;
+  while ((completed_upload = completed_uploads_.Front()) != nullptr) {
+    glDeleteSync(completed_upload->fence);
+    DeleteResource(completed_upload->resource);
+    completed_uploads_.Pop();
+  }
+  glfwDestroyWindow(upload_window_);
+  upload_window_ = nullptr;
+}
+
+int UploadThread::UploadMesh(const Eigen::MatrixXf& vertices,
+                             const std::vector<GLuint>& indices) {
+  UploadRequest request;
+  request.is_texture = false;
+  request.vertices = vertices;
+  request.indices = indices;
+  return QueueRequest(&request);
+}
+
+int UploadThread::UploadTexture(const int width,
+                                const int height,
+                                const std::vector<GLubyte>& rgb_pixels) {
+  UploadRequest request;
+  request.is_texture = true;
+  request.width = width;
+  request.height = height;
+  request.rgb_pixels = rgb_pixels;
+  return QueueRequest(&request);
+}
+
+int UploadThread::QueueRequest(UploadRequest* request) {
+  int request_id;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    request_id = next_request_id_++;
+    request->request_id = request_id;
+    requests_.push_back(std::move(*request));
+  }
+  condition_.notify_one();
+  return request_id;
+}
+
+bool UploadThread::PollCompleted(UploadedResource* resource) {
+  if (resource == nullptr) return false;
+  CompletedUpload* completed_upload = completed_uploads_.Front();
+  if (completed_upload == nullptr) return false;
+  // A zero timeout only queries the fence.
+  const GLenum status = glClientWaitSync(completed_upload->fence, 0, 0);
+  if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+    return false;
+  }
+  glDeleteSync(completed_upload->fence);
+  *resource = completed_upload->resource;
+  completed_uploads_.Pop();
+  return true;
+}
+
+void UploadThread::Run() {
+  glfwMakeContextCurrent(upload_window_);
+  while (true) {
+    UploadRequest request;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      condition_.wait(lock, [this] {
+        return stop_requested_ || !requests_.empty();
+      });
+      if (stop_requested_) break;
+      request = std::move(requests_.front());
+      requests_.pop_front();
+    }
+    CompletedUpload completed_upload;
+    completed_upload.resource = Upload(request);
+    completed_upload.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    // Submit the commands; otherwise the fence may never be signaled.
+    glFlush();
+    while (!completed_uploads_.Push(completed_upload)) {
+      if (stop_requested_) {
+        glDeleteSync(completed_upload.fence);
+        DeleteResource(completed_upload.resource);
+        break;
+      }
+      std::this_thread::yield();
+    }
+  }
+  glfwMakeContextCurrent(nullptr);
+}
+
+UploadedResource UploadThread::Upload(const UploadRequest& request) {
+  UploadedResource resource = {request.request_id, 0, 0, 0};
+  if (request.is_texture) {
+    glGenTextures(1, &resource.texture_id);
+    glBindTexture(GL_TEXTURE_2D, resource.texture_id);
+    // Same sampling parameters as LoadTexture in draw_scene.cc.
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    // RGB rows are not necessarily aligned to four bytes.
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, request.width, request.height, 0,
+                 GL_RGB, GL_UNSIGNED_BYTE, request.rgb_pixels.data());
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return resource;
+  }
+  // The element array binding is state of a VAO, and this context has none,
+  // so both buffers are filled through the copy-write target.
+  GLuint buffer_ids[2];
+  glGenBuffers(2, buffer_ids);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, buffer_ids[0]);
+  glBufferData(GL_COPY_WRITE_BUFFER, request.vertices.size() * sizeof(GLfloat),
+               request.vertices.data(), GL_STATIC_DRAW);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, buffer_ids[1]);
+  glBufferData(GL_COPY_WRITE_BUFFER, request.indices.size() * sizeof(GLuint),
+               request.indices.data(), GL_STATIC_DRAW);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+  resource.vertex_buffer_object_id = buffer_ids[0];
+  resource.element_buffer_object_id = buffer_ids[1];
+  return resource;
+}
+
+}  // namespace wvu
@@ -0,0 +1,174 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef UPLOAD_THREAD_H_
+#define UPLOAD_THREAD_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <Eigen/Core>
+#include <GL/glew.h>
+
+#include "spsc_queue.h"
+
+struct GLFWwindow;
+
+namespace wvu {
+
+// GPU resources created by the UploadThread. A mesh upload fills the buffer
+// ids and a texture upload fills the texture id; the other ids are zero.
+struct UploadedResource {
+  // Id returned by UploadMesh() or UploadTexture().
+  int request_id;
+  GLuint vertex_buffer_object_id;
+  GLuint element_buffer_object_id;
+  GLuint texture_id;
+};
+
+// This class runs the glBufferData and glTexImage2D calls of large assets on a
+// dedicated thread, so the render loop does not stall while they stream in.
+//
+// The thread owns a hidden window whose context shares its objects with the
+// main window. After the upload of a request, the thread inserts a fence and
+// publishes the resource through a lock-free single-producer single-consumer
+// queue. PollCompleted() hands the resource to the main thread once its
+// fence is signaled, i.e., once the data is in GPU memory.
+//
+// Vertex array objects are not shared between contexts, so the main thread
+// builds the VAO of an uploaded mesh (see Model::SetUploadedBuffers), which
+// is cheap. Usage example:
+//
+// wvu::UploadThread upload_thread;
+// std::string error_info_log;
+// if (!upload_thread.Start(window, &error_info_log)) {
+//   LOG(ERROR) << error_info_log;
+// }
+// const int request_id = upload_thread.UploadMesh(vertices, indices);
+// while (...) {  // Rendering loop.
+//   wvu::UploadedResource resource;
+//   while (upload_thread.PollCompleted(&resource)) {
+//     model->SetUploadedBuffers(resource.vertex_buffer_object_id,
+//                               resource.element_buffer_object_id);
+//   }
+//   ...
+// }
+class UploadThread {
+ public:
+  UploadThread();
+  // Stops the thread.
+  ~UploadThread();
+
+  // Creates the shared context and starts the thread. Must be called from the
+  // main thread, with the context of the main window current. Returns true
+  // upon success and false otherwise.
+  // Params:
+  //   main_window  The window whose context the uploaded objects are shared
+  //     with.
+  //   error_info_log  A pointer to a string that holds the error log.
+  bool Start(GLFWwindow* main_window, std::string* error_info_log);
+
+  // Stops the thread once the upload in progress is done and destroys the
+  // shared context. Queued requests are dropped and resources not polled yet
+  // are deleted. Main thread only.
+  void Stop();
+
+  // Queues the upload of a mesh with the layout of Model::SetVBO. Returns the
+  // id of the request.
+  // Params:
+  //   vertices  The 8 x n vertex matrix.
+  //   indices  The triangle indices.
+  int UploadMesh(const Eigen::MatrixXf& vertices,
+                 const std::vector<GLuint>& indices);
+
+  // Queues the upload of an RGB texture with mipmaps. Returns the id of the
+  // request.
+  // Params:
+  //   width  The width of the texture in pixels.
+  //   height  The height of the texture in pixels.
+  //   rgb_pixels  The interleaved RGB values, row by row.
+  int UploadTexture(const int width,
+                    const int height,
+                    const std::vector<GLubyte>& rgb_pixels);
+
+  // Returns the oldest completed upload whose data reached the GPU. Returns
+  // false when there is none. Main thread only; never blocks.
+  // Params:
+  //   resource  The uploaded resource.
+  bool PollCompleted(UploadedResource* resource);
+
+ private:
+  // Data of a queued upload.
+  struct UploadRequest {
+    int request_id;
+    bool is_texture;
+    Eigen::MatrixXf vertices;
+    std::vector<GLuint> indices;
+    int width;
+    int height;
+    std::vector<GLubyte> rgb_pixels;
+  };
+
+  // An upload waiting for its fence.
+  struct CompletedUpload {
+    UploadedResource resource;
+    GLsync fence;
+  };
+
+  // Body of the thread.
+  void Run();
+  // Executes the GL calls of a request in the shared context.
+  UploadedResource Upload(const UploadRequest& request);
+  // Appends a request to the queue and wakes the thread up.
+  int QueueRequest(UploadRequest* request);
+
+  GLFWwindow* upload_window_;
+  std::thread thread_;
+  // Queued requests, guarded by mutex_.
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::deque<UploadRequest> requests_;
+  std::atomic<bool> stop_requested_;
+  int next_request_id_;
+  // Uploads handed from the thread to the main thread.
+  SpscQueue<CompletedUpload> completed_uploads_;
+};
+
+}  // namespace wvu
+
+#endif  // UPLOAD_THREAD_H_
@@ -0,0 +1,289 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#include "vertex_pulling.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <Eigen/Core>
+#include <GL/glew.h>
+#include <glog/logging.h>
+
+#include "packing.h"
+#include "shader_program.h"
+
+namespace wvu {
+namespace {
+// Number of floats per vertex in the input matrices (see Model::SetVBO).
+constexpr int kNumFloatsPerVertex = 8;
+// Binding points of the storage buffers.
+constexpr GLuint kVertexBinding = 0;
+constexpr GLuint kIndexBinding = 1;
+constexpr GLuint kDrawRecordBinding = 2;
+
+// The decoding of the formats mirrors PackVertices.
+const std::string vertex_shader_src =
+    "#version 430 core\n"
+    "struct DrawRecord {\n"
+    "  mat4 model;\n"
+    "  uint format;\n"
+    "  uint first_word;\n"
+    "  uint first_index;\n"
+    "  uint padding;\n"
+    "};\n"
+    "layout (std430, binding = 0) readonly buffer VertexWords {\n"
+    "  uint vertex_words[];\n"
+    "};\n"
+    "layout (std430, binding = 1) readonly buffer Indices {\n"
+    "  uint indices[];\n"
+    "};\n"
+    "layout (std430, binding = 2) readonly buffer DrawRecords {\n"
+    "  DrawRecord draw_records[];\n"
+    "};\n"
+    "uniform uint draw_id;\n"
+    "uniform mat4 view;\n"
+    "uniform mat4 projection;\n"
+    "out vec3 color;\n"
+    "out vec2 texel;\n"
+    "vec3 FetchVec3(uint word) {\n"
+    "  return uintBitsToFloat(uvec3(vertex_words[word],\n"
+    "                               vertex_words[word + 1u],\n"
+    "                               vertex_words[word + 2u]));\n"
+    "}\n"
+    "void main() {\n"
+    "  DrawRecord record = draw_records[draw_id];\n"
+    "  uint index = indices[record.first_index + uint(gl_VertexID)];\n"
+    "  vec3 position;\n"
+    "  if (record.format == 0u) {\n"
+    "    uint word = record.first_word + 8u * index;\n"
+    "    position = FetchVec3(word);\n"
+    "    color = FetchVec3(word + 3u);\n"
+    "    texel = uintBitsToFloat(uvec2(vertex_words[word + 6u],\n"
+    "                                  vertex_words[word + 7u]));\n"
+    "  } else {\n"
+    "    uint word = record.first_word + 5u * index;\n"
+    "    position = FetchVec3(word);\n"
+    "    color = unpackUnorm4x8(vertex_words[word + 3u]).rgb;\n"
+    "    texel = unpackHalf2x16(vertex_words[word + 4u]);\n"
+    "  }\n"
+    "  gl_Position = projection * view * record.model * vec4(position, 1.0f);\n"
+    "}\n";
+
+const std::string fragment_shader_src =
+    "#version 430 core\n"
+    "in vec3 color;\n"
+    "in vec2 texel;\n"
+    "out vec4 fragment_color;\n"
+    "uniform sampler2D texture_sampler;\n"
+    "void main() {\n"
+    "  fragment_color = texture(texture_sampler, texel);\n"
+    "}\n";
+
+bool CreateProgram(const std::string& vertex_shader_src,
+                   const std::string& fragment_shader_src,
+                   ShaderProgram* shader_program,
+                   std::string* error_info_log) {
+  shader_program->LoadVertexShaderFromString(vertex_shader_src);
+  shader_program->LoadFragmentShaderFromString(fragment_shader_src);
+  return shader_program->Create(error_info_log);
+}
+
+GLuint FloatToWord(const GLfloat value) {
+  GLuint word;
+  std::memcpy(&word, &value, sizeof(word));
+  return word;
+}
+
+}  // namespace
+
+int NumWordsPerVertex(const VertexFormat format) {
+  return format == VertexFormat::FULL ? 8 : 5;
+}
+
+void PackVertices(const Eigen::MatrixXf& vertices,
+                  const VertexFormat format,
+                  std::vector<GLuint>* words) {
+  CHECK_EQ(vertices.rows(), kNumFloatsPerVertex);
+  words->reserve(words->size() + NumWordsPerVertex(format) * vertices.cols());
+  for (int i = 0; i < vertices.cols(); ++i) {
+    for (int j = 0; j < 3; ++j) {
+      words->push_back(FloatToWord(vertices(j, i)));
+    }
+    if (format == VertexFormat::FULL) {
+      for (int j = 3; j < kNumFloatsPerVertex; ++j) {
+        words->push_back(FloatToWord(vertices(j, i)));
+      }
+    } else {
+      words->push_back(PackUnorm4x8(Eigen::Vector4f(
+          vertices(3, i), vertices(4, i), vertices(5, i), 1.0f)));
+      words->push_back(PackHalf2x16(vertices(6, i), vertices(7, i)));
+    }
+  }
+}
+
+VertexPullingRenderer::VertexPullingRenderer() :
+    meshes_dirty_(false), vertex_buffer_id_(0), index_buffer_id_(0),
+    draw_record_buffer_id_(0), empty_vertex_array_object_id_(0) {}
+
+VertexPullingRenderer::~VertexPullingRenderer() {
+  const GLuint buffers[] = {vertex_buffer_id_, index_buffer_id_,
+                            draw_record_buffer_id_};
+  glDeleteBuffers(3, buffers);
+  glDeleteVertexArrays(1, &empty_vertex_array_object_id_);
+}
+
+bool VertexPullingRenderer::IsSupported() {
+  return ShaderProgram::AreComputeShadersSupported();
+}
+
+bool VertexPullingRenderer::Initialize(std::string* error_info_log) {
+  if (!CreateProgram(vertex_shader_src, fragment_shader_src, &shader_program_,
+                     error_info_log)) {
+    return false;
+  }
+  shader_program_.Use();
+  glUniform1i(glGetUniformLocation(shader_program_.shader_program_id(),
+                                   "texture_sampler"), 0);
+  glUseProgram(0);
+  GLuint buffers[3];
+  glGenBuffers(3, buffers);
+  vertex_buffer_id_ = buffers[0];
+  index_buffer_id_ = buffers[1];
+  draw_record_buffer_id_ = buffers[2];
+  glGenVertexArrays(1, &empty_vertex_array_object_id_);
+  return true;
+}
+
+int VertexPullingRenderer::AddMesh(const Eigen::MatrixXf& vertices,
+                                   const std::vector<GLuint>& indices,
+                                   const VertexFormat format) {
+  MeshData mesh;
+  mesh.format = format;
+  mesh.first_word = vertex_words_.size();
+  mesh.first_index = indices_.size();
+  PackVertices(vertices, format, &vertex_words_);
+  // The indices are relative to the first vertex of the mesh.
+  if (indices.empty()) {
+    for (int i = 0; i < vertices.cols(); ++i) {
+      indices_.push_back(i);
+    }
+  } else {
+    indices_.insert(indices_.end(), indices.begin(), indices.end());
+  }
+  mesh.num_indices = indices_.size() - mesh.first_index;
+  meshes_.push_back(mesh);
+  meshes_dirty_ = true;
+  return static_cast<int>(meshes_.size()) - 1;
+}
+
+void VertexPullingRenderer::UploadMeshes() {
+  if (!meshes_dirty_) return;
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, vertex_buffer_id_);
+  glBufferData(GL_SHADER_STORAGE_BUFFER,
+               vertex_words_.size() * sizeof(GLuint), vertex_words_.data(),
+               GL_STATIC_DRAW);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, index_buffer_id_);
+  glBufferData(GL_SHADER_STORAGE_BUFFER, indices_.size() * sizeof(GLuint),
+               indices_.data(), GL_STATIC_DRAW);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+  meshes_dirty_ = false;
+}
+
+void VertexPullingRenderer::Begin(const Eigen::Matrix4f& projection,
+                                  const Eigen::Matrix4f& view) {
+  draw_records_.clear();
+  draw_texture_ids_.clear();
+  draw_num_indices_.clear();
+  shader_program_.Use();
+  const GLuint program_id = shader_program_.shader_program_id();
+  glUniformMatrix4fv(glGetUniformLocation(program_id, "view"), 1, GL_FALSE,
+                     view.data());
+  glUniformMatrix4fv(glGetUniformLocation(program_id, "projection"), 1,
+                     GL_FALSE, projection.data());
+}
+
+void VertexPullingRenderer::Draw(const int mesh_id,
+                                 const Eigen::Matrix4f& model_matrix,
+                                 const GLuint texture_id) {
+  CHECK_GE(mesh_id, 0);
+  CHECK_LT(mesh_id, meshes_.size());
+  const MeshData& mesh = meshes_[mesh_id];
+  DrawRecord record;
+  std::copy(model_matrix.data(), model_matrix.data() + 16, record.model);
+  record.format = static_cast<GLuint>(mesh.format);
+  record.first_word = mesh.first_word;
+  record.first_index = mesh.first_index;
+  record.padding = 0;
+  draw_records_.push_back(record);
+  draw_texture_ids_.push_back(texture_id);
+  draw_num_indices_.push_back(mesh.num_indices);
+}
+
+void VertexPullingRenderer::End() {
+  if (draw_records_.empty()) {
+    glUseProgram(0);
+    return;
+  }
+  UploadMeshes();
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, draw_record_buffer_id_);
+  glBufferData(GL_SHADER_STORAGE_BUFFER,
+               draw_records_.size() * sizeof(DrawRecord),
+               draw_records_.data(), GL_STREAM_DRAW);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kVertexBinding,
+                   vertex_buffer_id_);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kIndexBinding, index_buffer_id_);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kDrawRecordBinding,
+                   draw_record_buffer_id_);
+  const GLint draw_id_location = glGetUniformLocation(
+      shader_program_.shader_program_id(), "draw_id");
+  // The same vertex array object serves every mesh and every format.
+  glBindVertexArray(empty_vertex_array_object_id_);
+  GLuint bound_texture_id = 0;
+  for (int i = 0; i < draw_records_.size(); ++i) {
+    if (draw_texture_ids_[i] != bound_texture_id) {
+      glBindTexture(GL_TEXTURE_2D, draw_texture_ids_[i]);
+      bound_texture_id = draw_texture_ids_[i];
+    }
+    glUniform1ui(draw_id_location, i);
+    glDrawArrays(GL_TRIANGLES, 0, draw_num_indices_[i]);
+  }
+  glBindVertexArray(0);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glUseProgram(0);
+}
+
+}  // namespace wvu
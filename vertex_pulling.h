@@ -0,0 +1,185 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef VERTEX_PULLING_H_
+#define VERTEX_PULLING_H_
+
+#include <string>
+#include <vector>
+#include <Eigen/Core>
+#include <GL/glew.h>
+
+#include "packing.h"
+#include "shader_program.h"
+
+namespace wvu {
+
+// Layouts of the vertices stored by the VertexPullingRenderer. The vertex
+// shader decodes them, so every mesh can use its own layout without any VAO
+// setup.
+enum struct VertexFormat {
+  // Eight floats: position (3), color (3), and texel (2). The layout of
+  // Model::SetVBO.
+  FULL = 0,
+  // Five words: position (3 floats), color (RGBA8 unorm), and texel (two
+  // half floats).
+  COMPACT = 1
+};
+
+// Returns the number of 32-bit words a vertex takes in the given format.
+int NumWordsPerVertex(const VertexFormat format);
+
+// Converts vertices with the layout of Model::SetVBO (one vertex per column)
+// into 32-bit words in the given format, and appends them to words.
+// Params:
+//   vertices  The 8 x n vertex matrix.
+//   format  The format of the words.
+//   words  The words the vertices are appended to.
+void PackVertices(const Eigen::MatrixXf& vertices,
+                  const VertexFormat format,
+                  std::vector<GLuint>* words);
+
+// This class implements programmable vertex pulling: the vertices and the
+// indices of all the meshes live in shader storage buffers, and the vertex
+// shader fetches and decodes them from gl_VertexID and a per-draw record
+// holding the format, the offsets into the buffers, and the model matrix.
+// All the meshes are drawn with the same empty VAO, so there is no VAO
+// switching nor attribute setup, and every mesh can use a compact format.
+//
+// gl_BaseVertex and gl_DrawID need OpenGL 4.6, so the record of a draw is
+// selected with a uniform and every record stores its own offsets. The class
+// requires OpenGL 4.3 for the storage buffers. Usage example:
+//
+// wvu::VertexPullingRenderer renderer;
+// std::string error_info_log;
+// if (!wvu::VertexPullingRenderer::IsSupported() ||
+//     !renderer.Initialize(&error_info_log)) {
+//   ...  // Fall back to Model::Draw.
+// }
+// const int mesh = renderer.AddMesh(vertices, indices,
+//                                   wvu::VertexFormat::COMPACT);
+// while (...) {  // Rendering loop.
+//   renderer.Begin(projection, view);
+//   renderer.Draw(mesh, model_matrix, texture_id);
+//   renderer.End();
+// }
+class VertexPullingRenderer {
+ public:
+  VertexPullingRenderer();
+  ~VertexPullingRenderer();
+
+  // Returns true when the current OpenGL context supports storage buffers.
+  static bool IsSupported();
+
+  // Compiles the shader program and creates the buffers. Returns true upon
+  // success and false otherwise.
+  // Params:
+  //   error_info_log  A pointer to a string that holds the error log.
+  bool Initialize(std::string* error_info_log);
+
+  // Adds a mesh and returns its id.
+  // Params:
+  //   vertices  The 8 x n vertex matrix with the layout of Model::SetVBO.
+  //   indices  The triangle indices. When empty, the vertices are drawn as a
+  //     plain triangle list.
+  //   format  The format the vertices are stored in.
+  int AddMesh(const Eigen::MatrixXf& vertices,
+              const std::vector<GLuint>& indices,
+              const VertexFormat format);
+
+  // Starts recording the draws of a frame.
+  // Params:
+  //   projection  The camera projection matrix.
+  //   view  The camera pose matrix (world -> camera transformation matrix).
+  void Begin(const Eigen::Matrix4f& projection, const Eigen::Matrix4f& view);
+
+  // Records the draw of a mesh.
+  // Params:
+  //   mesh_id  The id of the mesh returned by AddMesh.
+  //   model_matrix  The model matrix of the mesh.
+  //   texture_id  The texture of the mesh.
+  void Draw(const int mesh_id,
+            const Eigen::Matrix4f& model_matrix,
+            const GLuint texture_id);
+
+  // Uploads the draw records of the frame and issues the draws.
+  void End();
+
+  // Returns the number of meshes.
+  int num_meshes() const {
+    return meshes_.size();
+  }
+
+ private:
+  // Location of a mesh in the storage buffers.
+  struct MeshData {
+    VertexFormat format;
+    GLuint first_word;
+    GLuint first_index;
+    GLuint num_indices;
+  };
+
+  // Per-draw record with the std430 layout of the shader.
+  struct DrawRecord {
+    GLfloat model[16];
+    GLuint format;
+    GLuint first_word;
+    GLuint first_index;
+    GLuint padding;
+  };
+
+  // Uploads the vertices and the indices when meshes were added.
+  void UploadMeshes();
+
+  // Meshes and their data.
+  std::vector<MeshData> meshes_;
+  std::vector<GLuint> vertex_words_;
+  std::vector<GLuint> indices_;
+  bool meshes_dirty_;
+  // Draws recorded in the current frame.
+  std::vector<DrawRecord> draw_records_;
+  std::vector<GLuint> draw_texture_ids_;
+  std::vector<GLuint> draw_num_indices_;
+  // Storage buffers.
+  GLuint vertex_buffer_id_;
+  GLuint index_buffer_id_;
+  GLuint draw_record_buffer_id_;
+  // The only vertex array object: core profiles need one bound to draw.
+  GLuint empty_vertex_array_object_id_;
+  ShaderProgram shader_program_;
+};
+
+}  // namespace wvu
+
+#endif  // VERTEX_PULLING_H_
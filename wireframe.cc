@@ -0,0 +1,169 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#include "wireframe.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <Eigen/Core>
+#include <GL/glew.h>
+
+#include "shader_program.h"
+
+namespace wvu {
+namespace {
+// Smallest edge length considered, to avoid dividing by zero on degenerate
+// triangles.
+constexpr GLfloat kMinEdgeLength = 1e-6f;
+
+// Same inputs and uniforms as the forward vertex shader of draw_scene.cc.
+const std::string vertex_shader_src =
+    "#version 330 core\n"
+    "layout (location = 0) in vec3 position;\n"
+    "layout (location = 1) in vec3 passed_color;\n"
+    "layout (location = 2) in vec2 passed_texel;\n"
+    "uniform mat4 model;\n"
+    "uniform mat4 view;\n"
+    "uniform mat4 projection;\n"
+    "out vec2 vertex_texel;\n"
+    "void main() {\n"
+    "  gl_Position = projection * view * model * vec4(position, 1.0f);\n"
+    "  vertex_texel = passed_texel;\n"
+    "}\n";
+
+// Mirrors ComputeEdgeDistances. The distances are interpolated without
+// perspective correction since they are measured in window coordinates.
+const std::string geometry_shader_src =
+    "#version 330 core\n"
+    "layout (triangles) in;\n"
+    "layout (triangle_strip, max_vertices = 3) out;\n"
+    "in vec2 vertex_texel[];\n"
+    "uniform vec2 viewport_size;\n"
+    "out vec2 texel;\n"
+    "noperspective out vec3 edge_distance;\n"
+    "void main() {\n"
+    "  vec2 p[3];\n"
+    "  for (int i = 0; i < 3; ++i) {\n"
+    "    p[i] = 0.5f * viewport_size * gl_in[i].gl_Position.xy /\n"
+    "        gl_in[i].gl_Position.w;\n"
+    "  }\n"
+    "  vec2 e0 = p[2] - p[1];\n"
+    "  vec2 e1 = p[2] - p[0];\n"
+    "  vec2 e2 = p[1] - p[0];\n"
+    "  float twice_area = abs(e1.x * e2.y - e1.y * e2.x);\n"
+    "  vec3 heights = twice_area / max(vec3(length(e0), length(e1),\n"
+    "                                       length(e2)), 1e-6f);\n"
+    "  for (int i = 0; i < 3; ++i) {\n"
+    "    gl_Position = gl_in[i].gl_Position;\n"
+    "    texel = vertex_texel[i];\n"
+    "    edge_distance = vec3(0.0f);\n"
+    "    edge_distance[i] = heights[i];\n"
+    "    EmitVertex();\n"
+    "  }\n"
+    "  EndPrimitive();\n"
+    "}\n";
+
+// The line is anti-aliased over one pixel around its border.
+const std::string fragment_shader_src =
+    "#version 330 core\n"
+    "in vec2 texel;\n"
+    "noperspective in vec3 edge_distance;\n"
+    "uniform sampler2D texture_sampler;\n"
+    "uniform vec3 line_color;\n"
+    "uniform float line_width;\n"
+    "uniform bool fill;\n"
+    "out vec4 color;\n"
+    "void main() {\n"
+    "  float distance = min(min(edge_distance.x, edge_distance.y),\n"
+    "                       edge_distance.z);\n"
+    "  float half_width = 0.5f * line_width;\n"
+    "  float coverage = 1.0f - smoothstep(half_width - 0.5f,\n"
+    "                                     half_width + 0.5f, distance);\n"
+    "  if (!fill && coverage <= 0.0f) discard;\n"
+    "  vec4 base_color = fill ? texture(texture_sampler, texel) :\n"
+    "      vec4(0.0f, 0.0f, 0.0f, 1.0f);\n"
+    "  color = mix(base_color, vec4(line_color, 1.0f), coverage);\n"
+    "}\n";
+
+}  // namespace
+
+Eigen::Vector3f ComputeEdgeDistances(const Eigen::Vector2f& p0,
+                                     const Eigen::Vector2f& p1,
+                                     const Eigen::Vector2f& p2) {
+  const Eigen::Vector2f e0 = p2 - p1;
+  const Eigen::Vector2f e1 = p2 - p0;
+  const Eigen::Vector2f e2 = p1 - p0;
+  const GLfloat twice_area = std::abs(e1.x() * e2.y() - e1.y() * e2.x());
+  return Eigen::Vector3f(twice_area / std::max(e0.norm(), kMinEdgeLength),
+                         twice_area / std::max(e1.norm(), kMinEdgeLength),
+                         twice_area / std::max(e2.norm(), kMinEdgeLength));
+}
+
+WireframeShader::WireframeShader() :
+    viewport_width_(0), viewport_height_(0),
+    line_color_(1.0f, 1.0f, 1.0f), line_width_(1.5f), fill_(true) {}
+
+WireframeShader::~WireframeShader() {}
+
+bool WireframeShader::Initialize(const int viewport_width,
+                                 const int viewport_height,
+                                 std::string* error_info_log) {
+  viewport_width_ = viewport_width;
+  viewport_height_ = viewport_height;
+  shader_program_.LoadVertexShaderFromString(vertex_shader_src);
+  shader_program_.LoadGeometryShaderFromString(geometry_shader_src);
+  shader_program_.LoadFragmentShaderFromString(fragment_shader_src);
+  if (!shader_program_.Create(error_info_log)) {
+    return false;
+  }
+  shader_program_.Use();
+  glUniform1i(glGetUniformLocation(shader_program_.shader_program_id(),
+                                   "texture_sampler"), 0);
+  glUseProgram(0);
+  return true;
+}
+
+void WireframeShader::Use() const {
+  shader_program_.Use();
+  const GLuint program_id = shader_program_.shader_program_id();
+  glUniform2f(glGetUniformLocation(program_id, "viewport_size"),
+              viewport_width_, viewport_height_);
+  glUniform3fv(glGetUniformLocation(program_id, "line_color"), 1,
+               line_color_.data());
+  glUniform1f(glGetUniformLocation(program_id, "line_width"), line_width_);
+  glUniform1i(glGetUniformLocation(program_id, "fill"), fill_);
+}
+
+}  // namespace wvu
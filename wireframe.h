@@ -0,0 +1,130 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+#ifndef WIREFRAME_H_
+#define WIREFRAME_H_
+
+#include <string>
+#include <Eigen/Core>
+#include <GL/glew.h>
+
+#include "shader_program.h"
+
+namespace wvu {
+
+// Computes the distance in pixels from every vertex of a triangle to its
+// opposite edge. Interpolating (d0, 0, 0), (0, d1, 0), and (0, 0, d2) across
+// the triangle yields the distance of a fragment to each edge, which is what
+// the wireframe shader uses to draw the edges.
+// Params:
+//   p0, p1, p2  The vertices of the triangle in window coordinates.
+Eigen::Vector3f ComputeEdgeDistances(const Eigen::Vector2f& p0,
+                                     const Eigen::Vector2f& p1,
+                                     const Eigen::Vector2f& p2);
+
+// This class implements single-pass wireframe rendering. The triangles are
+// rasterized filled and the edges are drawn analytically in the fragment
+// shader: a geometry shader computes the window-space distances of the
+// vertices to the opposite edges (see ComputeEdgeDistances) and the fragment
+// shader blends in the line color near an edge. Unlike the GL_LINE polygon
+// mode, the cost is about the one of regular shading, the lines are
+// anti-aliased, and the edges can be drawn over the shaded models.
+//
+// The shader program has the uniforms and the vertex layout of the forward
+// shader program of draw_scene.cc, so it can be passed to Model::Draw. As in
+// the original technique, triangles crossing the camera plane are not
+// handled. Usage example:
+//
+// wvu::WireframeShader wireframe_shader;
+// std::string error_info_log;
+// if (!wireframe_shader.Initialize(width, height, &error_info_log)) {
+//   LOG(ERROR) << error_info_log;
+// }
+// while (...) {  // Rendering loop.
+//   wireframe_shader.Use();
+//   model->Draw(wireframe_shader.shader_program(), projection, view, texture);
+// }
+class WireframeShader {
+ public:
+  WireframeShader();
+  ~WireframeShader();
+
+  // Compiles the shader program. Returns true upon success and false
+  // otherwise.
+  // Params:
+  //   viewport_width  The width of the viewport in pixels.
+  //   viewport_height  The height of the viewport in pixels.
+  //   error_info_log  A pointer to a string that holds the error log.
+  bool Initialize(const int viewport_width,
+                  const int viewport_height,
+                  std::string* error_info_log);
+
+  // Activates the shader program and passes the wireframe settings to it.
+  void Use() const;
+
+  // Returns the shader program to pass to Model::Draw.
+  const ShaderProgram& shader_program() const {
+    return shader_program_;
+  }
+
+  // Sets the color of the lines.
+  void set_line_color(const Eigen::Vector3f& line_color) {
+    line_color_ = line_color;
+  }
+
+  // Sets the width of the lines in pixels.
+  void set_line_width(const GLfloat line_width) {
+    line_width_ = line_width;
+  }
+
+  // When true, the edges are drawn over the textured triangles. Otherwise
+  // only the edges are drawn.
+  void set_fill(const bool fill) {
+    fill_ = fill;
+  }
+
+ private:
+  // Dimensions of the viewport.
+  int viewport_width_;
+  int viewport_height_;
+  // Wireframe settings.
+  Eigen::Vector3f line_color_;
+  GLfloat line_width_;
+  bool fill_;
+  ShaderProgram shader_program_;
+};
+
+}  // namespace wvu
+
+#endif  // WIREFRAME_H_
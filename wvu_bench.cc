@@ -0,0 +1,1037 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+// Use the right namespace for google flags (gflags).
+#ifdef GFLAGS_NAMESPACE_GOOGLE
+#define GLUTILS_GFLAGS_NAMESPACE google
+#else
+#define GLUTILS_GFLAGS_NAMESPACE gflags
+#endif
+
+// wvu_bench measures the math the render loop runs every frame: the
+// transformations of transformations.h, the model matrices, and the camera
+// matrices. Every function is measured in two forms:
+//   - scalar: one call per iteration, i.e., the latency of a call.
+//   - batched: a call per element of an array of kBatchSize inputs, i.e., the
+//     throughput when many objects are updated at once.
+// The times are reported per call. The batched functions of simd_math.h are
+// compared with Eigen for every instruction set the CPU supports, e.g.,
+// Mat4Invert/eigen, Mat4Invert/sse2 and Mat4Invert/avx2_fma. The keyframe
+// animations of animation.h are evaluated for kBatchSize objects on the
+// calling thread and on a thread pool, and so are the joint palettes of
+// kNumCharacters skinned characters (see skinning.h) for both skinning
+// methods.
+//
+// It also measures the asset pipeline on a corpus it generates (see
+// asset_corpus.h), reporting MB/s and triangles/s (or Mpixels/s):
+//   - Parsing: LoadObjModel for every attribute mix of the faces, and the
+//     image decoders (CImg and the cooked textures).
+//   - Welding: ConvertObjToMesh and WeldVertices.
+//   - Uploading: glBufferData and glTexImage2D, in a headless OpenGL
+//     context (see headless_gl.h).
+// The benchmarks reading files run with a warm page cache and with a cold
+// one, i.e., with the file evicted from the page cache before every
+// iteration. The eviction is a hint: it has no effect on tmpfs, and dirty
+// pages are written back first.
+//
+// Usage example:
+//   ./wvu_bench --benchmark_filter=Rotation --json_output=bench.json
+//   ./wvu_bench --benchmark_filter=LoadObjModel --obj_triangles=1000000
+
+// Include first C-Headers.
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+// Include second C++-Headers.
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <GL/glew.h>
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+// The macro below disables the capabilities of displaying images in CImg.
+#define cimg_display 0
+#include <CImg.h>
+
+#include "animation.h"
+#include "asset_corpus.h"
+#include "benchmark.h"
+#include "camera.h"
+#include "camera_controller.h"
+#include "cooked_assets.h"
+#include "frustum.h"
+#include "headless_gl.h"
+#include "mesh_optimizer.h"
+#include "model.h"
+#include "model_loader.h"
+#include "simd_math.h"
+#include "skinning.h"
+#include "texture_compression.h"
+#include "thread_pool.h"
+#include "transformations.h"
+
+DEFINE_string(benchmark_filter, "",
+              "Only the benchmarks whose name contains it are run.");
+DEFINE_int32(num_warmup_repetitions, 2,
+             "Repetitions run before the measured ones.");
+DEFINE_int32(num_repetitions, 10, "Measured repetitions of a benchmark.");
+DEFINE_double(min_repetition_time_ms, 20.0,
+              "Minimum duration of a repetition.");
+DEFINE_string(json_output, "",
+              "When set, the results are also written to this JSON file.");
+DEFINE_string(corpus_dir, "wvu_bench_corpus",
+              "Directory the generated assets are written to.");
+DEFINE_string(obj_triangles, "1000,100000",
+              "Comma-separated triangle counts of the generated OBJ models.");
+DEFINE_string(image_sizes, "256,1024",
+              "Comma-separated widths of the generated square images.");
+DEFINE_bool(upload_benchmarks, true,
+            "Whether to measure the uploads, which need an OpenGL context.");
+
+namespace {
+
+// Number of inputs of the batched benchmarks. The inputs of the scalar
+// benchmarks cycle through the same number of values, so that the calls
+// cannot be hoisted out of the loops.
+constexpr int kBatchSize = 1024;
+
+// Deterministic, non-trivial inputs.
+std::vector<Eigen::Vector3f> GenerateVectors(const int seed) {
+  std::srand(seed);
+  std::vector<Eigen::Vector3f> vectors(kBatchSize);
+  for (Eigen::Vector3f& vector : vectors) {
+    vector = Eigen::Vector3f::Random();
+  }
+  return vectors;
+}
+
+wvu::CameraParameters GetCameraParameters() {
+  wvu::CameraParameters camera_params;
+  camera_params.field_of_view = wvu::ConvertDegreesToRadians(45.0f);
+  camera_params.aspect_ratio = 4.0f / 3.0f;
+  camera_params.near_plane_distance = 0.1f;
+  camera_params.far_plane_distance = 100.0f;
+  camera_params.position = Eigen::Vector3f::Zero();
+  camera_params.view_direction = -Eigen::Vector3f::UnitZ();
+  camera_params.up_vector = Eigen::Vector3f::UnitY();
+  return camera_params;
+}
+
+void AddTransformationBenchmarks(wvu::BenchmarkSuite* suite) {
+  const std::vector<Eigen::Vector3f> offsets = GenerateVectors(0);
+  std::vector<Eigen::Vector3f> axes = GenerateVectors(1);
+  std::vector<float> angles(kBatchSize);
+  for (int i = 0; i < kBatchSize; ++i) {
+    angles[i] = axes[i].norm();
+    axes[i].normalize();
+  }
+  std::vector<float> scales(kBatchSize);
+  for (int i = 0; i < kBatchSize; ++i) {
+    scales[i] = 0.5f + offsets[i].squaredNorm();
+  }
+  // Shared by the batched benchmarks, which run one after the other.
+  auto matrices = std::make_shared<std::vector<Eigen::Matrix4f> >(kBatchSize);
+
+  suite->Add("ComputeTranslationMatrix/scalar", 1,
+             [offsets](const int num_iterations) {
+    for (int i = 0; i < num_iterations; ++i) {
+      wvu::DoNotOptimize(
+          wvu::ComputeTranslationMatrix(offsets[i % kBatchSize]));
+    }
+  });
+  suite->Add("ComputeTranslationMatrix/batched", kBatchSize,
+             [offsets, matrices](const int num_iterations) {
+    for (int i = 0; i < num_iterations; ++i) {
+      for (int j = 0; j < kBatchSize; ++j) {
+        (*matrices)[j] = wvu::ComputeTranslationMatrix(offsets[j]);
+      }
+      wvu::DoNotOptimize(*matrices);
+    }
+  });
+  suite->Add("ComputeRotationMatrix/scalar", 1,
+             [axes, angles](const int num_iterations) {
+    for (int i = 0; i < num_iterations; ++i) {
+      wvu::DoNotOptimize(wvu::ComputeRotationMatrix(axes[i % kBatchSize],
+                                                    angles[i % kBatchSize]));
+    }
+  });
+  suite->Add("ComputeRotationMatrix/batched", kBatchSize,
+             [axes, angles, matrices](const int num_iterations) {
+    for (int i = 0; i < num_iterations; ++i) {
+      for (int j = 0; j < kBatchSize; ++j) {
+        (*matrices)[j] = wvu::ComputeRotationMatrix(axes[j], angles[j]);
+      }
+      wvu::DoNotOptimize(*matrices);
+    }
+  });
+  suite->Add("ComputeScalingMatrix/scalar", 1,
+             [scales](const int num_iterations) {
+    for (int i = 0; i < num_iterations; ++i) {
+      wvu::DoNotOptimize(wvu::ComputeScalingMatrix(scales[i % kBatchSize]));
+    }
+  });
+  suite->Add("ComputeScalingMatrix/batched", kBatchSize,
+             [scales, matrices](const int num_iterations) {
+    for (int i = 0; i < num_iterations; ++i) {
+      for (int j = 0; j < kBatchSize; ++j) {
+        (*matrices)[j] = wvu::ComputeScalingMatrix(scales[j]);
+      }
+      wvu::DoNotOptimize(*matrices);
+    }
+  });
+}
+
+void AddModelBenchmarks(wvu::BenchmarkSuite* suite) {
+  const std::vector<Eigen::Vector3f> orientations = GenerateVectors(2);
+  const std::vector<Eigen::Vector3f> positions = GenerateVectors(3);
+  // The models never reach the GPU: only their pose matters.
+  auto models = std::make_shared<std::vector<std::unique_ptr<wvu::Model> > >();
+  for (int i = 0; i < kBatchSize; ++i) {
+    models->emplace_back(new wvu::Model(orientations[i], positions[i],
+                                        Eigen::MatrixXf::Zero(8, 3)));
+  }
+  auto matrices = std::make_shared<std::vector<Eigen::Matrix4f> >(kBatchSize);
+
+  suite->Add("Model::ComputeModelMatrix/scalar", 1,
+             [models](const int num_iterations) {
+    for (int i = 0; i < num_iterations; ++i) {
+      wvu::DoNotOptimize((*models)[i % kBatchSize]->ComputeModelMatrix());
+    }
+  });
+  suite->Add("Model::ComputeModelMatrix/batched", kBatchSize,
+             [models, matrices](const int num_iterations) {
+    for (int i = 0; i < num_iterations; ++i) {
+      for (int j = 0; j < kBatchSize; ++j) {
+        (*matrices)[j] = (*models)[j]->ComputeModelMatrix();
+      }
+      wvu::DoNotOptimize(*matrices);
+    }
+  });
+  auto model_pointers = std::make_shared<std::vector<wvu::Model*> >();
+  for (const std::unique_ptr<wvu::Model>& model : *models) {
+    model_pointers->push_back(model.get());
+  }
+  suite->Add("Model::ComputeModelMatrices/simd", kBatchSize,
+             [models, model_pointers, matrices](const int num_iterations) {
+    for (int i = 0; i < num_iterations; ++i) {
+      wvu::Model::ComputeModelMatrices(*model_pointers, matrices.get());
+      wvu::DoNotOptimize(*matrices);
+    }
+  });
+}
+
+// Compares the batched functions of simd_math.h, for every instruction set
+// the CPU supports, against the same computations with Eigen, which is
+// vectorized for the instruction sets the build enables (only SSE2 by
+// default).
+void AddSimdMathBenchmarks(wvu::BenchmarkSuite* suite) {
+  std::srand(4);
+  struct SimdMathInputs {
+    std::vector<Eigen::Matrix4f> eigen_lhs;
+    std::vector<Eigen::Matrix4f> eigen_rhs;
+    std::vector<Eigen::Matrix4f> eigen_results;
+    std::vector<Eigen::Vector4f> eigen_points;
+    std::vector<Eigen::Vector4f> eigen_transformed_points;
+    std::vector<Eigen::Quaternionf> eigen_quaternions;
+    std::vector<Eigen::Quaternionf> eigen_quaternion_products;
+    std::vector<Eigen::Quaternionf> eigen_target_quaternions;
+    std::vector<Eigen::Vector4f> eigen_planes;
+    std::vector<wvu::Mat4> lhs;
+    std::vector<wvu::Mat4> rhs;
+    std::vector<wvu::Mat4> results;
+    std::vector<wvu::Vec4> points;
+    std::vector<wvu::Vec4> transformed_points;
+    std::vector<wvu::Quat> quaternions;
+    std::vector<wvu::Quat> quaternion_products;
+    std::vector<wvu::Quat> target_quaternions;
+    std::vector<float> weights;
+    std::vector<wvu::Vec4> planes;
+  };
+  auto inputs = std::make_shared<SimdMathInputs>();
+  for (int i = 0; i < kBatchSize; ++i) {
+    // Well conditioned, so that the inverses are meaningful.
+    inputs->eigen_lhs.push_back(Eigen::Matrix4f::Random() +
+                                4.0f * Eigen::Matrix4f::Identity());
+    inputs->eigen_rhs.push_back(Eigen::Matrix4f::Random());
+    inputs->eigen_points.push_back(Eigen::Vector4f::Random());
+    inputs->eigen_quaternions.push_back(
+        Eigen::Quaternionf(Eigen::Vector4f::Random()).normalized());
+    inputs->lhs.push_back(wvu::ToMat4(inputs->eigen_lhs.back()));
+    inputs->rhs.push_back(wvu::ToMat4(inputs->eigen_rhs.back()));
+    inputs->points.push_back(wvu::ToVec4(inputs->eigen_points.back()));
+    inputs->quaternions.push_back(
+        wvu::ToQuat(inputs->eigen_quaternions.back()));
+    inputs->eigen_target_quaternions.push_back(
+        Eigen::Quaternionf(Eigen::Vector4f::Random()).normalized());
+    inputs->target_quaternions.push_back(
+        wvu::ToQuat(inputs->eigen_target_quaternions.back()));
+    inputs->weights.push_back(static_cast<float>(i) / kBatchSize);
+  }
+  inputs->eigen_results.resize(kBatchSize);
+  inputs->eigen_transformed_points.resize(kBatchSize);
+  inputs->eigen_quaternion_products.resize(kBatchSize);
+  inputs->eigen_planes.resize(wvu::kNumFrustumPlanes * kBatchSize);
+  inputs->results.resize(kBatchSize);
+  inputs->transformed_points.resize(kBatchSize);
+  inputs->quaternion_products.resize(kBatchSize);
+  inputs->planes.resize(wvu::kNumFrustumPlanes * kBatchSize);
+
+  suite->Add("Mat4Multiply/eigen", kBatchSize,
+             [inputs](const int num_iterations) {
+    for (int i = 0; i < num_iterations; ++i) {
+      for (int j = 0; j < kBatchSize; ++j) {
+        inputs->eigen_results[j].noalias() =
+            inputs->eigen_lhs[j] * inputs->eigen_rhs[j];
+      }
+      wvu::DoNotOptimize(inputs->eigen_results);
+    }
+  });
+  suite->Add("Mat4MultiplyByMat4/eigen", kBatchSize,
+             [inputs](const int num_iterations) {
+    for (int i = 0; i < num_iterations; ++i) {
+      for (int j = 0; j < kBatchSize; ++j) {
+        inputs->eigen_results[j].noalias() =
+            inputs->eigen_lhs[0] * inputs->eigen_rhs[j];
+      }
+      wvu::DoNotOptimize(inputs->eigen_results);
+    }
+  });
+  suite->Add("Mat4Invert/eigen", kBatchSize,
+             [inputs](const int num_iterations) {
+    for (int i = 0; i < num_iterations; ++i) {
+      for (int j = 0; j < kBatchSize; ++j) {
+        inputs->eigen_results[j] = inputs->eigen_lhs[j].inverse();
+      }
+      wvu::DoNotOptimize(inputs->eigen_results);
+    }
+  });
+  suite->Add("TransformPoint/eigen", kBatchSize,
+             [inputs](const int num_iterations) {
+    for (int i = 0; i < num_iterations; ++i) {
+      for (int j = 0; j < kBatchSize; ++j) {
+        inputs->eigen_transformed_points[j].noalias() =
+            inputs->eigen_lhs[0] * inputs->eigen_points[j];
+      }
+      wvu::DoNotOptimize(inputs->eigen_transformed_points);
+    }
+  });
+  suite->Add("ExtractFrustumPlanes/eigen", kBatchSize,
+             [inputs](const int num_iterations) {
+    for (int i = 0; i < num_iterations; ++i) {
+      for (int j = 0; j < kBatchSize; ++j) {
+        wvu::ExtractFrustumPlanes(
+            inputs->eigen_lhs[j],
+            &inputs->eigen_planes[wvu::kNumFrustumPlanes * j]);
+      }
+      wvu::DoNotOptimize(inputs->eigen_planes);
+    }
+  });
+  suite->Add("QuatMultiply/eigen", kBatchSize,
+             [inputs](const int num_iterations) {
+    for (int i = 0; i < num_iterations; ++i) {
+      for (int j = 0; j < kBatchSize; ++j) {
+        inputs->eigen_quaternion_products[j] =
+            inputs->eigen_quaternions[j] * inputs->eigen_quaternions[j];
+      }
+      wvu::DoNotOptimize(inputs->eigen_quaternion_products);
+    }
+  });
+  suite->Add("QuatSlerp/eigen", kBatchSize,
+             [inputs](const int num_iterations) {
+    for (int i = 0; i < num_iterations; ++i) {
+      for (int j = 0; j < kBatchSize; ++j) {
+        inputs->eigen_quaternion_products[j] =
+            inputs->eigen_quaternions[j].slerp(
+                inputs->weights[j], inputs->eigen_target_quaternions[j]);
+      }
+      wvu::DoNotOptimize(inputs->eigen_quaternion_products);
+    }
+  });
+  suite->Add("QuatToMat4/eigen", kBatchSize,
+             [inputs](const int num_iterations) {
+    for (int i = 0; i < num_iterations; ++i) {
+      for (int j = 0; j < kBatchSize; ++j) {
+        inputs->eigen_results[j].setIdentity();
+        inputs->eigen_results[j].topLeftCorner<3, 3>() =
+            inputs->eigen_quaternions[j].toRotationMatrix();
+      }
+      wvu::DoNotOptimize(inputs->eigen_results);
+    }
+  });
+
+  for (const wvu::SimdIsa isa :
+       {wvu::SimdIsa::SCALAR, wvu::SimdIsa::SSE2, wvu::SimdIsa::AVX2_FMA}) {
+    if (!wvu::IsSimdIsaSupported(isa)) continue;
+    const std::string name = wvu::GetSimdIsaName(isa);
+    suite->Add("Mat4Multiply/" + name, kBatchSize,
+               [inputs, isa](const int num_iterations) {
+      wvu::SetSimdIsa(isa);
+      for (int i = 0; i < num_iterations; ++i) {
+        wvu::MultiplyMat4Batch(inputs->lhs.data(), inputs->rhs.data(),
+                               kBatchSize, inputs->results.data());
+        wvu::DoNotOptimize(inputs->results);
+      }
+    });
+    suite->Add("Mat4MultiplyByMat4/" + name, kBatchSize,
+               [inputs, isa](const int num_iterations) {
+      wvu::SetSimdIsa(isa);
+      for (int i = 0; i < num_iterations; ++i) {
+        wvu::MultiplyMat4Batch(inputs->lhs[0], inputs->rhs.data(),
+                               kBatchSize, inputs->results.data());
+        wvu::DoNotOptimize(inputs->results);
+      }
+    });
+    suite->Add("Mat4Invert/" + name, kBatchSize,
+               [inputs, isa](const int num_iterations) {
+      wvu::SetSimdIsa(isa);
+      for (int i = 0; i < num_iterations; ++i) {
+        wvu::InvertMat4Batch(inputs->lhs.data(), kBatchSize,
+                             inputs->results.data());
+        wvu::DoNotOptimize(inputs->results);
+      }
+    });
+    suite->Add("TransformPoint/" + name, kBatchSize,
+               [inputs, isa](const int num_iterations) {
+      wvu::SetSimdIsa(isa);
+      for (int i = 0; i < num_iterations; ++i) {
+        wvu::TransformPointBatch(inputs->lhs[0], inputs->points.data(),
+                                 kBatchSize,
+                                 inputs->transformed_points.data());
+        wvu::DoNotOptimize(inputs->transformed_points);
+      }
+    });
+    suite->Add("ExtractFrustumPlanes/" + name, kBatchSize,
+               [inputs, isa](const int num_iterations) {
+      wvu::SetSimdIsa(isa);
+      for (int i = 0; i < num_iterations; ++i) {
+        wvu::ExtractFrustumPlanesBatch(inputs->lhs.data(), kBatchSize,
+                                       inputs->planes.data());
+        wvu::DoNotOptimize(inputs->planes);
+      }
+    });
+    suite->Add("QuatMultiply/" + name, kBatchSize,
+               [inputs, isa](const int num_iterations) {
+      wvu::SetSimdIsa(isa);
+      for (int i = 0; i < num_iterations; ++i) {
+        wvu::MultiplyQuatBatch(inputs->quaternions.data(),
+                               inputs->quaternions.data(), kBatchSize,
+                               inputs->quaternion_products.data());
+        wvu::DoNotOptimize(inputs->quaternion_products);
+      }
+    });
+    suite->Add("QuatSlerp/" + name, kBatchSize,
+               [inputs, isa](const int num_iterations) {
+      wvu::SetSimdIsa(isa);
+      for (int i = 0; i < num_iterations; ++i) {
+        wvu::SlerpQuatBatch(inputs->quaternions.data(),
+                            inputs->target_quaternions.data(),
+                            inputs->weights.data(), kBatchSize,
+                            inputs->quaternion_products.data());
+        wvu::DoNotOptimize(inputs->quaternion_products);
+      }
+    });
+    suite->Add("QuatNlerp/" + name, kBatchSize,
+               [inputs, isa](const int num_iterations) {
+      wvu::SetSimdIsa(isa);
+      for (int i = 0; i < num_iterations; ++i) {
+        wvu::NlerpQuatBatch(inputs->quaternions.data(),
+                            inputs->target_quaternions.data(),
+                            inputs->weights.data(), kBatchSize,
+                            inputs->quaternion_products.data());
+        wvu::DoNotOptimize(inputs->quaternion_products);
+      }
+    });
+    suite->Add("QuatToMat4/" + name, kBatchSize,
+               [inputs, isa](const int num_iterations) {
+      wvu::SetSimdIsa(isa);
+      for (int i = 0; i < num_iterations; ++i) {
+        wvu::QuatToMat4Batch(inputs->quaternions.data(), kBatchSize,
+                             inputs->results.data());
+        wvu::DoNotOptimize(inputs->results);
+      }
+    });
+  }
+}
+
+void AddAnimationBenchmarks(wvu::BenchmarkSuite* suite) {
+  std::srand(5);
+  constexpr int kNumKeyframes = 32;
+  constexpr float kFrameTime = 1.0f / 60.0f;
+  struct AnimationInputs {
+    wvu::AnimationClip linear_clip;
+    wvu::AnimationClip cubic_clip;
+    wvu::TransformStore transforms;
+    wvu::Animator linear_animator;
+    wvu::Animator cubic_animator;
+  };
+  auto inputs = std::make_shared<AnimationInputs>();
+  for (int i = 0; i < kNumKeyframes; ++i) {
+    const float time = 0.5f * i;
+    const Eigen::Vector3f position = Eigen::Vector3f::Random();
+    const Eigen::Quaternionf rotation =
+        Eigen::Quaternionf(Eigen::Vector4f::Random()).normalized();
+    for (wvu::AnimationClip* clip :
+         {&inputs->linear_clip, &inputs->cubic_clip}) {
+      clip->position.times.push_back(time);
+      clip->position.values.push_back(position);
+      clip->rotation.times.push_back(time);
+      clip->rotation.values.push_back(rotation);
+    }
+  }
+  inputs->cubic_clip.position.interpolation =
+      wvu::KeyframeInterpolation::CUBIC;
+  inputs->cubic_clip.rotation.interpolation =
+      wvu::KeyframeInterpolation::CUBIC;
+  inputs->linear_clip.loop = true;
+  inputs->cubic_clip.loop = true;
+  for (int i = 0; i < kBatchSize; ++i) {
+    inputs->transforms.positions.push_back(Eigen::Vector3f::Zero());
+    inputs->transforms.rotations.push_back(Eigen::Quaternionf::Identity());
+    inputs->transforms.scales.push_back(Eigen::Vector3f::Ones());
+    // Different start times, so that the objects are at different keyframes.
+    const float start_time = -0.1f * i;
+    inputs->linear_animator.Play(&inputs->linear_clip, i, start_time);
+    inputs->cubic_animator.Play(&inputs->cubic_clip, i, start_time);
+  }
+  auto thread_pool = std::make_shared<wvu::ThreadPool>(
+      std::thread::hardware_concurrency());
+
+  // Every iteration is a frame: the time moves forward as in the render
+  // loop, which is what the cursors of the tracks are for.
+  suite->Add("Animator::Evaluate/linear", kBatchSize,
+             [inputs](const int num_iterations) {
+    for (int i = 0; i < num_iterations; ++i) {
+      inputs->linear_animator.Evaluate(i * kFrameTime, nullptr,
+                                       &inputs->transforms);
+      wvu::DoNotOptimize(inputs->transforms.rotations);
+    }
+  });
+  suite->Add("Animator::Evaluate/cubic", kBatchSize,
+             [inputs](const int num_iterations) {
+    for (int i = 0; i < num_iterations; ++i) {
+      inputs->cubic_animator.Evaluate(i * kFrameTime, nullptr,
+                                      &inputs->transforms);
+      wvu::DoNotOptimize(inputs->transforms.rotations);
+    }
+  });
+  suite->Add("Animator::Evaluate/linear_thread_pool", kBatchSize,
+             [inputs, thread_pool](const int num_iterations) {
+    for (int i = 0; i < num_iterations; ++i) {
+      inputs->linear_animator.Evaluate(i * kFrameTime, thread_pool.get(),
+                                       &inputs->transforms);
+      wvu::DoNotOptimize(inputs->transforms.rotations);
+    }
+  });
+}
+
+// The characters are a chain of joints that sway around their parents, which
+// is as deep as a hierarchy gets and hence the worst case of the flattening.
+void AddSkinningBenchmarks(wvu::BenchmarkSuite* suite) {
+  constexpr int kNumCharacters = 256;
+  constexpr int kNumJoints = 32;
+  constexpr int kNumKeyframes = 16;
+  constexpr float kFrameTime = 1.0f / 60.0f;
+  struct SkinningInputs {
+    wvu::Skeleton skeleton;
+    std::vector<wvu::AnimationClip> joint_clips;
+    std::unique_ptr<wvu::SkeletalAnimator> animator;
+  };
+  auto inputs = std::make_shared<SkinningInputs>();
+  inputs->skeleton.joints.resize(kNumJoints);
+  inputs->joint_clips.resize(kNumJoints);
+  for (int i = 0; i < kNumJoints; ++i) {
+    wvu::Joint& joint = inputs->skeleton.joints[i];
+    joint.parent = i - 1;
+    joint.position = Eigen::Vector3f(0.0f, i == 0 ? 0.0f : 0.1f, 0.0f);
+    joint.rotation = Eigen::Quaternionf::Identity();
+    joint.scale = Eigen::Vector3f::Ones();
+    wvu::AnimationClip& clip = inputs->joint_clips[i];
+    for (int j = 0; j < kNumKeyframes; ++j) {
+      const float angle = 0.2f * std::sin(0.5f * j + 0.1f * i);
+      clip.rotation.times.push_back(0.25f * j);
+      clip.rotation.values.push_back(Eigen::Quaternionf(
+          Eigen::AngleAxisf(angle, Eigen::Vector3f::UnitZ())));
+    }
+    clip.loop = true;
+  }
+  wvu::ComputeInverseBindMatrices(&inputs->skeleton);
+  inputs->animator.reset(new wvu::SkeletalAnimator(&inputs->skeleton));
+  for (int i = 0; i < kNumCharacters; ++i) {
+    inputs->animator->AddCharacter(&inputs->joint_clips, -0.1f * i);
+  }
+  auto thread_pool = std::make_shared<wvu::ThreadPool>(
+      std::thread::hardware_concurrency());
+
+  const struct {
+    const char* name;
+    wvu::SkinningMethod method;
+  } kMethods[] = {
+    {"linear_blend", wvu::SkinningMethod::LINEAR_BLEND},
+    {"dual_quaternion", wvu::SkinningMethod::DUAL_QUATERNION},
+  };
+  for (const auto& method : kMethods) {
+    const wvu::SkinningMethod skinning_method = method.method;
+    suite->Add(std::string("SkeletalAnimator::Evaluate/") + method.name,
+               kNumCharacters,
+               [inputs, skinning_method](const int num_iterations) {
+      for (int i = 0; i < num_iterations; ++i) {
+        inputs->animator->Evaluate(i * kFrameTime, skinning_method, nullptr);
+        wvu::DoNotOptimize(inputs->animator->palette());
+      }
+    });
+    suite->Add(std::string("SkeletalAnimator::Evaluate/") + method.name +
+               "_thread_pool", kNumCharacters,
+               [inputs, skinning_method, thread_pool](
+                   const int num_iterations) {
+      for (int i = 0; i < num_iterations; ++i) {
+        inputs->animator->Evaluate(i * kFrameTime, skinning_method,
+                                   thread_pool.get());
+        wvu::DoNotOptimize(inputs->animator->palette());
+      }
+    });
+  }
+}
+
+void AddCameraBenchmarks(wvu::BenchmarkSuite* suite) {
+  const std::vector<Eigen::Vector3f> positions = GenerateVectors(4);
+  const wvu::CameraParameters camera_params = GetCameraParameters();
+  auto camera = std::make_shared<wvu::Camera>(camera_params);
+  CHECK(camera->Initialize() == wvu::CameraInitializationError::NO_ERROR);
+  auto cameras = std::make_shared<std::vector<wvu::Camera> >();
+  for (int i = 0; i < kBatchSize; ++i) {
+    wvu::CameraParameters params = camera_params;
+    params.position = positions[i];
+    cameras->emplace_back(params);
+    CHECK(cameras->back().Initialize() ==
+          wvu::CameraInitializationError::NO_ERROR);
+  }
+  auto controllers = std::make_shared<
+      std::vector<std::unique_ptr<wvu::CameraController> > >();
+  for (int i = 0; i < kBatchSize; ++i) {
+    wvu::CameraParameters params = camera_params;
+    params.position = positions[i];
+    controllers->emplace_back(new wvu::CameraController(
+        wvu::CameraControllerParams(), params));
+    CHECK(controllers->back()->Initialize() ==
+          wvu::ControllerInitializationError::NO_ERROR);
+  }
+
+  suite->Add("Camera::ComputeLookAtMatrix/scalar", 1,
+             [camera, positions](const int num_iterations) {
+    for (int i = 0; i < num_iterations; ++i) {
+      camera->set_position(positions[i % kBatchSize]);
+      wvu::DoNotOptimize(camera->ComputeLookAtMatrix());
+    }
+  });
+  suite->Add("Camera::ComputeLookAtMatrix/batched", kBatchSize,
+             [cameras](const int num_iterations) {
+    for (int i = 0; i < num_iterations; ++i) {
+      for (wvu::Camera& camera : *cameras) {
+        wvu::DoNotOptimize(camera.ComputeLookAtMatrix());
+      }
+    }
+  });
+  suite->Add("Camera::ComputeProjectionMatrix/scalar", 1,
+             [camera](const int num_iterations) {
+    for (int i = 0; i < num_iterations; ++i) {
+      camera->set_field_of_view(0.5f + (i % kBatchSize) * 1e-3f);
+      wvu::DoNotOptimize(camera->ComputeProjectionMatrix());
+    }
+  });
+  suite->Add("Camera::ComputeProjectionMatrix/batched", kBatchSize,
+             [cameras](const int num_iterations) {
+    for (int i = 0; i < num_iterations; ++i) {
+      for (wvu::Camera& camera : *cameras) {
+        wvu::DoNotOptimize(camera.ComputeProjectionMatrix());
+      }
+    }
+  });
+  // The controllers turn and move a little every update, as when driven by
+  // the mouse and the keyboard.
+  suite->Add("CameraController::UpdatePose/scalar", 1,
+             [controllers](const int num_iterations) {
+    wvu::CameraController* controller = controllers->front().get();
+    for (int i = 0; i < num_iterations; ++i) {
+      controller->AddYawOffset(0.1f);
+      controller->MoveFront();
+      wvu::DoNotOptimize(controller->UpdatePose());
+    }
+  });
+  suite->Add("CameraController::UpdatePose/batched", kBatchSize,
+             [controllers](const int num_iterations) {
+    for (int i = 0; i < num_iterations; ++i) {
+      for (const std::unique_ptr<wvu::CameraController>& controller :
+               *controllers) {
+        controller->AddYawOffset(0.1f);
+        controller->MoveFront();
+        wvu::DoNotOptimize(controller->UpdatePose());
+      }
+    }
+  });
+}
+
+// Parses a comma-separated list of positive integers.
+std::vector<int> ParseIntegerList(const std::string& list) {
+  std::vector<int> values;
+  std::stringstream stream(list);
+  std::string value;
+  while (std::getline(stream, value, ',')) {
+    if (value.empty()) continue;
+    values.push_back(std::atoi(value.c_str()));
+    CHECK_GT(values.back(), 0) << "Invalid value in the list " << list;
+  }
+  return values;
+}
+
+// Returns the size of a file in MB.
+double GetFileSizeInMb(const std::string& filepath) {
+  struct stat file_status;
+  CHECK_EQ(stat(filepath.c_str(), &file_status), 0)
+      << "Could not stat " << filepath;
+  return file_status.st_size * 1e-6;
+}
+
+// Asks the kernel to drop the cached pages of a file, so that the next read
+// goes to the disk.
+void EvictFromPageCache(const std::string& filepath) {
+  const int file_descriptor = open(filepath.c_str(), O_RDONLY);
+  if (file_descriptor < 0) return;
+  // Only clean pages are dropped.
+  fdatasync(file_descriptor);
+  posix_fadvise(file_descriptor, 0, 0, POSIX_FADV_DONTNEED);
+  close(file_descriptor);
+}
+
+// Adds the warm and the cold page cache variants of a benchmark loading the
+// file.
+void AddFileBenchmarks(const std::string& name,
+                       const std::string& filepath,
+                       const std::vector<wvu::BenchmarkCounter>& counters,
+                       const std::function<void()>& load,
+                       wvu::BenchmarkSuite* suite) {
+  suite->Add(name + "/warm", 1, [load](const int num_iterations) {
+    for (int i = 0; i < num_iterations; ++i) {
+      load();
+    }
+  }, counters);
+  suite->Add(name + "/cold", 1, [filepath, load](const int num_iterations) {
+    for (int i = 0; i < num_iterations; ++i) {
+      EvictFromPageCache(filepath);
+      load();
+    }
+  }, counters);
+}
+
+// The parsed and the welded OBJ models of the corpus, kept for the
+// benchmarks of the following stages.
+struct CorpusMesh {
+  std::string name;
+  int num_triangles;
+  Eigen::MatrixXf vertices;
+  std::vector<GLuint> indices;
+};
+
+void AddMeshBenchmarks(const std::vector<int>& triangle_counts,
+                       std::vector<CorpusMesh>* meshes,
+                       wvu::BenchmarkSuite* suite) {
+  const wvu::ObjAttributes kAttributes[] = {
+    wvu::ObjAttributes::POSITIONS,
+    wvu::ObjAttributes::POSITIONS_TEXELS,
+    wvu::ObjAttributes::POSITIONS_NORMALS,
+    wvu::ObjAttributes::POSITIONS_TEXELS_NORMALS
+  };
+  for (const int num_triangles : triangle_counts) {
+    for (const wvu::ObjAttributes attributes : kAttributes) {
+      const std::string name = std::string(
+          wvu::GetObjAttributesName(attributes)) + "/" +
+          std::to_string(num_triangles);
+      const std::string filepath = FLAGS_corpus_dir + "/mesh_" +
+          wvu::GetObjAttributesName(attributes) + "_" +
+          std::to_string(num_triangles) + ".obj";
+      std::string contents;
+      wvu::GenerateObjModel(num_triangles, attributes, &contents);
+      CHECK(wvu::WriteFileContents(filepath, contents))
+          << "Could not write " << filepath;
+
+      auto obj_vertices = std::make_shared<std::vector<Eigen::Vector3f> >();
+      auto obj_texels = std::make_shared<std::vector<Eigen::Vector2f> >();
+      auto obj_normals = std::make_shared<std::vector<Eigen::Vector3f> >();
+      auto faces = std::make_shared<std::vector<wvu::Face> >();
+      CHECK(wvu::LoadObjModel(filepath, obj_vertices.get(), obj_texels.get(),
+                              obj_normals.get(), faces.get()));
+      const std::vector<wvu::BenchmarkCounter> counters = {
+        {"MB", GetFileSizeInMb(filepath)},
+        {"triangles", static_cast<double>(faces->size())}};
+      AddFileBenchmarks(
+          "LoadObjModel/" + name, filepath, counters,
+          [filepath]() {
+            std::vector<Eigen::Vector3f> vertices;
+            std::vector<Eigen::Vector2f> texels;
+            std::vector<Eigen::Vector3f> normals;
+            std::vector<wvu::Face> faces;
+            wvu::LoadObjModel(filepath, &vertices, &texels, &normals, &faces);
+            wvu::DoNotOptimize(faces);
+          },
+          suite);
+      suite->Add("ConvertAndWeld/" + name, 1,
+                 [obj_vertices, obj_texels, obj_normals, faces](
+                     const int num_iterations) {
+        for (int i = 0; i < num_iterations; ++i) {
+          Eigen::MatrixXf vertices;
+          std::vector<GLuint> indices;
+          wvu::ConvertObjToMesh(*obj_vertices, *obj_texels, *obj_normals,
+                                *faces, &vertices, &indices);
+          wvu::WeldVertices(&vertices, &indices);
+          wvu::DoNotOptimize(indices);
+        }
+      }, {counters.back()});
+
+      CorpusMesh mesh;
+      mesh.name = name;
+      mesh.num_triangles = faces->size();
+      wvu::ConvertObjToMesh(*obj_vertices, *obj_texels, *obj_normals, *faces,
+                            &mesh.vertices, &mesh.indices);
+      wvu::WeldVertices(&mesh.vertices, &mesh.indices);
+      meshes->push_back(mesh);
+    }
+  }
+}
+
+// The images of the corpus, kept for the upload benchmarks.
+struct CorpusImage {
+  int size;
+  std::vector<uint8_t> rgb_pixels;
+  std::vector<uint8_t> bc1_blocks;
+};
+
+void AddImageBenchmarks(const std::vector<int>& image_sizes,
+                        std::vector<CorpusImage>* images,
+                        wvu::BenchmarkSuite* suite) {
+  for (const int size : image_sizes) {
+    CorpusImage image;
+    image.size = size;
+    wvu::GenerateImage(size, size, size, &image.rgb_pixels);
+    wvu::CompressBc1(size, size, image.rgb_pixels, &image.bc1_blocks);
+    const std::string prefix = FLAGS_corpus_dir + "/image_" +
+        std::to_string(size);
+    const double num_megapixels = size * size * 1e-6;
+
+    // CImg decodes BMP and PPM natively; JPEG and PNG would be decoded by an
+    // external tool unless CImg is built with libjpeg and libpng.
+    cimg_library::CImg<unsigned char> cimg_image(image.rgb_pixels.data(), 3,
+                                                 size, size, 1);
+    cimg_image.permute_axes("yzcx");
+    for (const std::string extension : {"bmp", "ppm"}) {
+      const std::string filepath = prefix + "." + extension;
+      cimg_image.save(filepath.c_str());
+      AddFileBenchmarks(
+          "LoadImage/" + extension + "/" + std::to_string(size), filepath,
+          {{"MB", GetFileSizeInMb(filepath)}, {"Mpixels", num_megapixels}},
+          [filepath]() {
+            cimg_library::CImg<unsigned char> image(filepath.c_str());
+            wvu::DoNotOptimize(image);
+          },
+          suite);
+    }
+
+    // The cooked textures, as wvu_cook writes them.
+    wvu::CookedTexture texture;
+    texture.format = wvu::CookedTextureFormat::RGB8;
+    wvu::GenerateMipmaps(size, size, image.rgb_pixels, &texture.levels);
+    for (const std::string format : {"rgb8", "bc1"}) {
+      if (format == "bc1") {
+        texture.format = wvu::CookedTextureFormat::BC1;
+        for (wvu::MipLevel& level : texture.levels) {
+          std::vector<uint8_t> blocks;
+          wvu::CompressBc1(level.width, level.height, level.data, &blocks);
+          level.data.swap(blocks);
+        }
+      }
+      std::string bytes;
+      wvu::EncodeCookedTexture(texture, &bytes);
+      const std::string filepath = prefix + "_" + format + ".wvutex";
+      CHECK(wvu::WriteFileContents(filepath, bytes))
+          << "Could not write " << filepath;
+      AddFileBenchmarks(
+          "DecodeCookedTexture/" + format + "/" + std::to_string(size),
+          filepath,
+          {{"MB", GetFileSizeInMb(filepath)}, {"Mpixels", num_megapixels}},
+          [filepath]() {
+            std::string bytes;
+            wvu::CookedTexture texture;
+            std::string error_info_log;
+            wvu::ReadFileContents(filepath, &bytes);
+            wvu::DecodeCookedTexture(bytes.data(), bytes.size(), &texture,
+                                     &error_info_log);
+            wvu::DoNotOptimize(texture);
+          },
+          suite);
+    }
+
+    // The fallback of the GPUs without S3TC support.
+    auto blocks = std::make_shared<std::vector<uint8_t> >(image.bc1_blocks);
+    suite->Add("DecompressBc1/" + std::to_string(size), 1,
+               [size, blocks](const int num_iterations) {
+      std::vector<uint8_t> rgb_pixels;
+      for (int i = 0; i < num_iterations; ++i) {
+        wvu::DecompressBc1(size, size, *blocks, &rgb_pixels);
+        wvu::DoNotOptimize(rgb_pixels);
+      }
+    }, {{"Mpixels", num_megapixels}});
+    images->push_back(image);
+  }
+}
+
+// The uploads are synchronous (glFinish), so that the time includes the
+// transfer and not only the copy into the driver.
+void AddUploadBenchmarks(const std::vector<CorpusMesh>& meshes,
+                         const std::vector<CorpusImage>& images,
+                         wvu::BenchmarkSuite* suite) {
+  for (const CorpusMesh& corpus_mesh : meshes) {
+    auto mesh = std::make_shared<CorpusMesh>(corpus_mesh);
+    const double num_megabytes =
+        (mesh->vertices.size() * sizeof(GLfloat) +
+         mesh->indices.size() * sizeof(GLuint)) * 1e-6;
+    suite->Add("UploadMesh/" + mesh->name, 1, [mesh](const int num_iterations) {
+      GLuint buffer_ids[2];
+      glGenBuffers(2, buffer_ids);
+      for (int i = 0; i < num_iterations; ++i) {
+        glBindBuffer(GL_ARRAY_BUFFER, buffer_ids[0]);
+        glBufferData(GL_ARRAY_BUFFER, mesh->vertices.size() * sizeof(GLfloat),
+                     mesh->vertices.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer_ids[1]);
+        glBufferData(GL_ARRAY_BUFFER, mesh->indices.size() * sizeof(GLuint),
+                     mesh->indices.data(), GL_STATIC_DRAW);
+        glFinish();
+      }
+      glBindBuffer(GL_ARRAY_BUFFER, 0);
+      glDeleteBuffers(2, buffer_ids);
+    }, {{"MB", num_megabytes},
+        {"triangles", static_cast<double>(mesh->num_triangles)}});
+  }
+  for (const CorpusImage& corpus_image : images) {
+    auto image = std::make_shared<CorpusImage>(corpus_image);
+    const int size = image->size;
+    const double num_megapixels = size * size * 1e-6;
+    suite->Add("UploadTexture/rgb8/" + std::to_string(size), 1,
+               [image, size](const int num_iterations) {
+      GLuint texture_id;
+      glGenTextures(1, &texture_id);
+      glBindTexture(GL_TEXTURE_2D, texture_id);
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+      for (int i = 0; i < num_iterations; ++i) {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, size, size, 0, GL_RGB,
+                     GL_UNSIGNED_BYTE, image->rgb_pixels.data());
+        glFinish();
+      }
+      glBindTexture(GL_TEXTURE_2D, 0);
+      glDeleteTextures(1, &texture_id);
+    }, {{"MB", image->rgb_pixels.size() * 1e-6},
+        {"Mpixels", num_megapixels}});
+    if (!GLEW_EXT_texture_compression_s3tc) continue;
+    suite->Add("UploadTexture/bc1/" + std::to_string(size), 1,
+               [image, size](const int num_iterations) {
+      GLuint texture_id;
+      glGenTextures(1, &texture_id);
+      glBindTexture(GL_TEXTURE_2D, texture_id);
+      for (int i = 0; i < num_iterations; ++i) {
+        glCompressedTexImage2D(GL_TEXTURE_2D, 0,
+                               GL_COMPRESSED_RGB_S3TC_DXT1_EXT, size, size, 0,
+                               image->bc1_blocks.size(),
+                               image->bc1_blocks.data());
+        glFinish();
+      }
+      glBindTexture(GL_TEXTURE_2D, 0);
+      glDeleteTextures(1, &texture_id);
+    }, {{"MB", image->bc1_blocks.size() * 1e-6},
+        {"Mpixels", num_megapixels}});
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  GLUTILS_GFLAGS_NAMESPACE::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  wvu::BenchmarkOptions options;
+  options.num_warmup_repetitions = FLAGS_num_warmup_repetitions;
+  options.num_repetitions = FLAGS_num_repetitions;
+  options.min_repetition_time_ms = FLAGS_min_repetition_time_ms;
+  wvu::BenchmarkSuite suite(options);
+  AddTransformationBenchmarks(&suite);
+  AddModelBenchmarks(&suite);
+  AddAnimationBenchmarks(&suite);
+  AddSkinningBenchmarks(&suite);
+  AddCameraBenchmarks(&suite);
+  AddSimdMathBenchmarks(&suite);
+  if (mkdir(FLAGS_corpus_dir.c_str(), 0755) != 0 && errno != EEXIST) {
+    LOG(ERROR) << "Could not create " << FLAGS_corpus_dir;
+    return -1;
+  }
+  std::vector<CorpusMesh> meshes;
+  AddMeshBenchmarks(ParseIntegerList(FLAGS_obj_triangles), &meshes, &suite);
+  std::vector<CorpusImage> images;
+  AddImageBenchmarks(ParseIntegerList(FLAGS_image_sizes), &images, &suite);
+  wvu::HeadlessGlContext context;
+  if (FLAGS_upload_benchmarks) {
+    std::string error_info_log;
+    if (!context.Initialize(&error_info_log)) {
+      LOG(WARNING) << error_info_log << " The uploads are not measured.";
+    } else {
+      AddUploadBenchmarks(meshes, images, &suite);
+    }
+  }
+  suite.Run(FLAGS_benchmark_filter);
+  suite.PrintTable(&std::cout);
+  if (!FLAGS_json_output.empty()) {
+    std::ofstream json_file(FLAGS_json_output);
+    json_file << suite.ToJson();
+    if (!json_file) {
+      LOG(ERROR) << "Could not write " << FLAGS_json_output;
+      return -1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,405 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+// Use the right namespace for google flags (gflags).
+#ifdef GFLAGS_NAMESPACE_GOOGLE
+#define GLUTILS_GFLAGS_NAMESPACE google
+#else
+#define GLUTILS_GFLAGS_NAMESPACE gflags
+#endif
+
+// wvu_cook converts the source assets of a directory into the cooked formats
+// of cooked_assets.h, which the AssetManager loads without any decoding:
+//   - OBJ meshes (.obj -> .wvumesh): welded, reordered for the vertex cache
+//     and for linear vertex fetches, and quantized.
+//   - Images (.bmp, .jpg, .png -> .wvutex): mipmapped and, optionally, BC1
+//     compressed.
+//   - Text scenes (.scene -> .wvuscene): encoded in the binary layout of
+//     scene_file.h, referencing the cooked meshes and textures.
+// The directory structure of the input is preserved in the output. A
+// manifest of the hashes of the inputs (and of the cooking options) makes
+// the builds incremental: only the changed inputs are cooked again. The
+// cooked assets can also be bundled into a single pak archive (see
+// pak_archive.h).
+//
+// Usage example:
+//   ./wvu_cook --input_dir=assets --output_dir=cooked
+
+// Include first C-Headers.
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+// Include second C++-Headers.
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <Eigen/Core>
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+// The macro below disables the capabilities of displaying images in CImg.
+#define cimg_display 0
+#include <CImg.h>
+
+#include "cooked_assets.h"
+#include "mesh_optimizer.h"
+#include "model_loader.h"
+#include "pak_archive.h"
+#include "scene_file.h"
+#include "texture_compression.h"
+#include "thread_pool.h"
+
+DEFINE_string(input_dir, "", "Directory with the source assets.");
+DEFINE_string(output_dir, "", "Directory the cooked assets are written to.");
+DEFINE_string(manifest, "",
+              "Filepath of the manifest. Defaults to cook_manifest.txt in "
+              "the output directory.");
+DEFINE_int32(num_threads, 4, "Number of assets cooked in parallel.");
+DEFINE_string(texture_compression, "bc1",
+              "Pixel format of the cooked textures: bc1 or none.");
+DEFINE_int32(vertex_cache_size, 16,
+             "Size of the post-transform vertex cache the meshes are "
+             "optimized for.");
+DEFINE_bool(force, false, "Cook every asset, even the up-to-date ones.");
+DEFINE_string(pak, "",
+              "When set, the cooked assets are also bundled into a pak "
+              "archive at this filepath. The entries are named after the "
+              "cooked files relative to the output directory.");
+DEFINE_bool(pak_compression, true,
+            "Whether to LZ-compress the entries of the pak archive.");
+
+namespace {
+
+enum struct AssetKind { MESH, TEXTURE, SCENE };
+
+// A source asset and the cooked file it produces. Paths are relative to the
+// input and output directories.
+struct CookJob {
+  AssetKind kind;
+  std::string input_path;
+  std::string output_path;
+};
+
+bool HasSuffix(const std::string& str, const std::string& suffix) {
+  return str.size() >= suffix.size() &&
+      str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Returns the path with its extension replaced.
+std::string ReplaceExtension(const std::string& path,
+                             const std::string& extension) {
+  const size_t dot = path.rfind('.');
+  return path.substr(0, dot) + extension;
+}
+
+// Returns the path of the cooked version of an asset referenced by a scene.
+// Builtin meshes and unknown extensions are kept as they are.
+std::string GetCookedAssetPath(const std::string& path) {
+  std::string lowercase_path = path;
+  std::transform(path.begin(), path.end(), lowercase_path.begin(), ::tolower);
+  if (HasSuffix(lowercase_path, ".obj")) {
+    return ReplaceExtension(path, ".wvumesh");
+  }
+  if (HasSuffix(lowercase_path, ".bmp") || HasSuffix(lowercase_path, ".jpg") ||
+      HasSuffix(lowercase_path, ".png")) {
+    return ReplaceExtension(path, ".wvutex");
+  }
+  return path;
+}
+
+// Appends the jobs of the cookable files under input_dir/relative_dir.
+void FindJobs(const std::string& input_dir,
+              const std::string& relative_dir,
+              std::vector<CookJob>* jobs) {
+  const std::string dir_path = relative_dir.empty() ? input_dir :
+      input_dir + "/" + relative_dir;
+  DIR* dir = opendir(dir_path.c_str());
+  if (dir == nullptr) {
+    LOG(ERROR) << "Could not open the directory " << dir_path;
+    return;
+  }
+  while (const dirent* entry = readdir(dir)) {
+    const std::string name = entry->d_name;
+    if (name == "." || name == "..") continue;
+    const std::string relative_path = relative_dir.empty() ? name :
+        relative_dir + "/" + name;
+    struct stat status;
+    if (stat((input_dir + "/" + relative_path).c_str(), &status) != 0) {
+      continue;
+    }
+    if (S_ISDIR(status.st_mode)) {
+      FindJobs(input_dir, relative_path, jobs);
+      continue;
+    }
+    std::string lowercase_name = name;
+    std::transform(name.begin(), name.end(), lowercase_name.begin(),
+                   ::tolower);
+    if (HasSuffix(lowercase_name, ".obj")) {
+      jobs->push_back({AssetKind::MESH, relative_path,
+                       ReplaceExtension(relative_path, ".wvumesh")});
+    } else if (HasSuffix(lowercase_name, ".bmp") ||
+               HasSuffix(lowercase_name, ".jpg") ||
+               HasSuffix(lowercase_name, ".png")) {
+      jobs->push_back({AssetKind::TEXTURE, relative_path,
+                       ReplaceExtension(relative_path, ".wvutex")});
+    } else if (HasSuffix(lowercase_name, ".scene")) {
+      jobs->push_back({AssetKind::SCENE, relative_path,
+                       ReplaceExtension(relative_path, ".wvuscene")});
+    }
+  }
+  closedir(dir);
+}
+
+// Creates the parent directories of a file.
+bool CreateParentDirectories(const std::string& filepath) {
+  for (size_t slash = filepath.find('/', 1); slash != std::string::npos;
+       slash = filepath.find('/', slash + 1)) {
+    const std::string dir_path = filepath.substr(0, slash);
+    if (mkdir(dir_path.c_str(), 0755) != 0 && errno != EEXIST) return false;
+  }
+  return true;
+}
+
+bool FileExists(const std::string& filepath) {
+  struct stat status;
+  return stat(filepath.c_str(), &status) == 0;
+}
+
+bool CookMesh(const std::string& filepath,
+              std::string* bytes,
+              std::string* error_info_log) {
+  std::vector<Eigen::Vector3f> obj_vertices;
+  std::vector<Eigen::Vector2f> obj_texels;
+  std::vector<Eigen::Vector3f> obj_normals;
+  std::vector<wvu::Face> faces;
+  if (!wvu::LoadObjModel(filepath, &obj_vertices, &obj_texels, &obj_normals,
+                         &faces) || faces.empty()) {
+    *error_info_log = "Could not load the mesh " + filepath;
+    return false;
+  }
+  Eigen::MatrixXf vertices;
+  std::vector<GLuint> indices;
+  wvu::ConvertObjToMesh(obj_vertices, obj_texels, obj_normals, faces,
+                        &vertices, &indices);
+  wvu::WeldVertices(&vertices, &indices);
+  wvu::OptimizeVertexCache(vertices.cols(), FLAGS_vertex_cache_size,
+                           &indices);
+  wvu::OptimizeVertexFetch(&vertices, &indices);
+  wvu::EncodeCookedMesh(vertices, indices, bytes);
+  return true;
+}
+
+bool CookTexture(const std::string& filepath,
+                 std::string* bytes,
+                 std::string* error_info_log) {
+  cimg_library::CImg<unsigned char> image;
+  try {
+    image.load(filepath.c_str());
+  } catch (const cimg_library::CImgException& exception) {
+    *error_info_log = "Could not load the texture " + filepath;
+    return false;
+  }
+  // Grayscale images are expanded and alpha channels are dropped.
+  if (image.spectrum() == 1) {
+    image.resize(-100, -100, -100, 3);
+  } else if (image.spectrum() > 3) {
+    image.channels(0, 2);
+  }
+  const int width = image.width();
+  const int height = image.height();
+  // Interleave the channels, as OpenGL expects them.
+  image.permute_axes("cxyz");
+  const std::vector<uint8_t> rgb_pixels(image.data(),
+                                        image.data() + image.size());
+  wvu::CookedTexture texture;
+  wvu::GenerateMipmaps(width, height, rgb_pixels, &texture.levels);
+  texture.format = wvu::CookedTextureFormat::RGB8;
+  if (FLAGS_texture_compression == "bc1") {
+    texture.format = wvu::CookedTextureFormat::BC1;
+    for (wvu::MipLevel& level : texture.levels) {
+      std::vector<uint8_t> blocks;
+      wvu::CompressBc1(level.width, level.height, level.data, &blocks);
+      level.data.swap(blocks);
+    }
+  }
+  wvu::EncodeCookedTexture(texture, bytes);
+  return true;
+}
+
+// Encodes a text scene into its binary representation. The meshes and
+// textures it references are redirected to their cooked versions.
+bool CookScene(const std::string& contents,
+               std::string* bytes,
+               std::string* error_info_log) {
+  wvu::SceneDescription scene;
+  if (!wvu::ParseSceneText(contents, &scene, error_info_log)) return false;
+  for (std::string& mesh : scene.meshes) {
+    mesh = GetCookedAssetPath(mesh);
+  }
+  for (wvu::SceneDescription::Material& material : scene.materials) {
+    for (std::string& texture : material.textures) {
+      texture = GetCookedAssetPath(texture);
+    }
+  }
+  wvu::EncodeScene(scene, bytes);
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  GLUTILS_GFLAGS_NAMESPACE::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  if (FLAGS_input_dir.empty() || FLAGS_output_dir.empty()) {
+    LOG(ERROR) << "Both --input_dir and --output_dir are required.";
+    return -1;
+  }
+  if (FLAGS_texture_compression != "bc1" &&
+      FLAGS_texture_compression != "none") {
+    LOG(ERROR) << "Unknown texture compression " << FLAGS_texture_compression;
+    return -1;
+  }
+  const std::string manifest_filepath = FLAGS_manifest.empty() ?
+      FLAGS_output_dir + "/cook_manifest.txt" : FLAGS_manifest;
+  wvu::CookManifest manifest;
+  std::string error_info_log;
+  if (!manifest.Load(manifest_filepath, &error_info_log)) {
+    LOG(ERROR) << error_info_log;
+    return -1;
+  }
+
+  std::vector<CookJob> jobs;
+  FindJobs(FLAGS_input_dir, "", &jobs);
+  // Anything that changes the cooked bytes goes into the hashes.
+  const std::string options = "version=" +
+      std::to_string(wvu::kCookedAssetVersion) + ";texture_compression=" +
+      FLAGS_texture_compression + ";vertex_cache_size=" +
+      std::to_string(FLAGS_vertex_cache_size) + ";";
+
+  std::mutex mutex;
+  std::atomic<int> num_cooked(0);
+  std::atomic<int> num_up_to_date(0);
+  std::atomic<int> num_failed(0);
+  {
+    wvu::ThreadPool thread_pool(FLAGS_num_threads);
+    for (const CookJob& job : jobs) {
+      thread_pool.Schedule([&, job] {
+        const std::string input_filepath =
+            FLAGS_input_dir + "/" + job.input_path;
+        const std::string output_filepath =
+            FLAGS_output_dir + "/" + job.output_path;
+        std::string contents;
+        if (!wvu::ReadFileContents(input_filepath, &contents)) {
+          LOG(ERROR) << "Could not read " << input_filepath;
+          ++num_failed;
+          return;
+        }
+        const uint64_t hash = wvu::HashBytes(options + contents);
+        bool is_up_to_date;
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          is_up_to_date = manifest.IsUpToDate(job.input_path, hash);
+        }
+        if (!FLAGS_force && is_up_to_date && FileExists(output_filepath)) {
+          ++num_up_to_date;
+          return;
+        }
+        std::string bytes;
+        std::string job_error_info_log;
+        bool cooked = false;
+        switch (job.kind) {
+          case AssetKind::MESH:
+            cooked = CookMesh(input_filepath, &bytes, &job_error_info_log);
+            break;
+          case AssetKind::TEXTURE:
+            cooked = CookTexture(input_filepath, &bytes, &job_error_info_log);
+            break;
+          case AssetKind::SCENE:
+            cooked = CookScene(contents, &bytes, &job_error_info_log);
+            if (!cooked) {
+              job_error_info_log = input_filepath + ": " + job_error_info_log;
+            }
+            break;
+        }
+        if (!cooked) {
+          LOG(ERROR) << job_error_info_log;
+          ++num_failed;
+          return;
+        }
+        if (!CreateParentDirectories(output_filepath) ||
+            !wvu::WriteFileContents(output_filepath, bytes)) {
+          LOG(ERROR) << "Could not write " << output_filepath;
+          ++num_failed;
+          return;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        manifest.Set(job.input_path, job.output_path, hash);
+        ++num_cooked;
+      });
+    }
+    thread_pool.Wait();
+  }
+
+  if (!CreateParentDirectories(manifest_filepath) ||
+      !manifest.Save(manifest_filepath, &error_info_log)) {
+    LOG(ERROR) << error_info_log;
+    return -1;
+  }
+  if (!FLAGS_pak.empty()) {
+    // Aligned to cache lines, since the entries are read in place.
+    wvu::PakWriter pak_writer(64);
+    for (const CookJob& job : jobs) {
+      const std::string output_filepath =
+          FLAGS_output_dir + "/" + job.output_path;
+      if (!FileExists(output_filepath)) continue;
+      if (!pak_writer.AddFile(job.output_path, output_filepath,
+                              FLAGS_pak_compression, &error_info_log)) {
+        LOG(ERROR) << error_info_log;
+        return -1;
+      }
+    }
+    if (!pak_writer.Write(FLAGS_pak, &error_info_log)) {
+      LOG(ERROR) << error_info_log;
+      return -1;
+    }
+  }
+  std::cout << "Cooked: " << num_cooked << ", up to date: " << num_up_to_date
+            << ", failed: " << num_failed << std::endl;
+  return num_failed == 0 ? 0 : -1;
+}
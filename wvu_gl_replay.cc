@@ -0,0 +1,158 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+// Use the right namespace for google flags (gflags).
+#ifdef GFLAGS_NAMESPACE_GOOGLE
+#define GLUTILS_GFLAGS_NAMESPACE google
+#else
+#define GLUTILS_GFLAGS_NAMESPACE gflags
+#endif
+
+// wvu_gl_replay replays an OpenGL trace recorded by draw_scene
+// (--gl_trace_output, see gl_trace.h) as fast as possible in a headless
+// context. The trace holds the calls of the renderer and the data they
+// upload, but none of the scene logic (culling, sorting, animation), so the
+// replay measures the cost of the driver and of the GPU alone:
+//   - submit: the CPU time to issue the calls of a frame.
+//   - finish: the same plus a glFinish, i.e., until the GPU is done.
+// The frames of the trace are replayed --repetitions times. The prologue (the
+// loading of the assets) is replayed and timed once.
+//
+//   ./draw_scene --gl_trace_output=scene.wvutrace --gl_trace_frames=100
+//   ./wvu_gl_replay --trace=scene.wvutrace
+
+// Include second C++-Headers.
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "benchmark.h"
+#include "gl_trace.h"
+#include "headless_gl.h"
+
+DEFINE_string(trace, "", "The trace to replay.");
+DEFINE_int32(width, 1024, "Width of the framebuffer.");
+DEFINE_int32(height, 768, "Height of the framebuffer.");
+DEFINE_int32(repetitions, 10, "Replays of the frames of the trace.");
+
+namespace {
+
+double ElapsedMilliseconds(
+    const std::chrono::steady_clock::time_point& start) {
+  return std::chrono::duration<double, std::milli>(
+      std::chrono::steady_clock::now() - start).count();
+}
+
+void PrintSummary(const std::string& name,
+                  const std::vector<double>& samples) {
+  const wvu::SampleSummary summary = wvu::SummarizeSamples(samples);
+  std::printf("%-8s %10.3f %10.3f %10.3f %10.3f\n", name.c_str(),
+              summary.min, summary.median, summary.mean,
+              summary.median_absolute_deviation);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  GLUTILS_GFLAGS_NAMESPACE::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  std::string error_info_log;
+  wvu::GlTraceReplayer replayer;
+  if (!replayer.Open(FLAGS_trace, &error_info_log)) {
+    LOG(ERROR) << error_info_log;
+    return -1;
+  }
+  if (replayer.num_frames() == 0) {
+    LOG(ERROR) << "The trace " << FLAGS_trace << " has no frames.";
+    return -1;
+  }
+  std::map<std::string, int> unsupported_calls;
+  for (const std::string& call : replayer.unsupported_calls()) {
+    ++unsupported_calls[call];
+  }
+  for (const auto& call : unsupported_calls) {
+    LOG(WARNING) << "The trace calls " << call.first << " " << call.second
+                 << " times, which are not replayed.";
+  }
+
+  wvu::HeadlessGlContext context;
+  if (!context.Initialize(&error_info_log)) {
+    LOG(ERROR) << error_info_log;
+    return -1;
+  }
+  wvu::OffscreenFramebuffer framebuffer;
+  if (!framebuffer.Initialize(FLAGS_width, FLAGS_height, &error_info_log)) {
+    LOG(ERROR) << error_info_log;
+    return -1;
+  }
+  framebuffer.Bind();
+  replayer.set_default_framebuffer_id(framebuffer.framebuffer_id());
+
+  auto start = std::chrono::steady_clock::now();
+  replayer.ReplayPrologue();
+  glFinish();
+  const double prologue_time = ElapsedMilliseconds(start);
+
+  std::vector<double> submit_times;
+  std::vector<double> finish_times;
+  for (int i = 0; i < FLAGS_repetitions; ++i) {
+    for (int frame = 0; frame < replayer.num_frames(); ++frame) {
+      start = std::chrono::steady_clock::now();
+      replayer.ReplayFrame(frame);
+      submit_times.push_back(ElapsedMilliseconds(start));
+      glFinish();
+      finish_times.push_back(ElapsedMilliseconds(start));
+    }
+  }
+  replayer.ReplayEpilogue();
+  framebuffer.Unbind();
+
+  std::cout << "Trace: " << FLAGS_trace << " (" << replayer.num_commands()
+            << " commands, " << replayer.num_frames() << " frames, "
+            << replayer.unsupported_calls().size() << " unsupported calls)"
+            << std::endl;
+  std::printf("Prologue: %.3f ms\n", prologue_time);
+  std::printf("%-8s %10s %10s %10s %10s\n", "ms/frame", "min", "median",
+              "mean", "mad");
+  PrintSummary("submit", submit_times);
+  PrintSummary("finish", finish_times);
+  return 0;
+}
@@ -0,0 +1,355 @@
+// Copyright (C) 2016 West Virginia University.
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//
+//     * Redistributions in binary form must reproduce the above
+//       copyright notice, this list of conditions and the following
+//       disclaimer in the documentation and/or other materials provided
+//       with the distribution.
+//
+//     * Neither the name of West Virginia University nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Please contact the author of this library if you have any questions.
+// Author: Victor Fragoso (victor.fragoso@mail.wvu.edu)
+
+// Use the right namespace for google flags (gflags).
+#ifdef GFLAGS_NAMESPACE_GOOGLE
+#define GLUTILS_GFLAGS_NAMESPACE google
+#else
+#define GLUTILS_GFLAGS_NAMESPACE gflags
+#endif
+
+// wvu_perf is the performance regression gate. It times representative
+// workloads of the renderer and compares them against the committed
+// baselines of perf_baselines.txt (see perf_gate.h):
+//   - model_matrix: Model::ComputeModelMatrix over a batch of models.
+//   - load_obj: LoadObjModel on a generated OBJ file.
+//   - texture_upload: glTexImage2D of an RGB8 texture.
+//   - render_fbo: a generated scene rendered with a fixed camera into a
+//     framebuffer object.
+// Every metric is the median of --num_repetitions samples, with its MAD. The
+// program prints a diff table and fails when a metric regressed. The OpenGL
+// workloads are skipped, not failed, when no context can be created.
+//
+// The baselines are only meaningful on the machine they were measured on.
+// After an intended change of the performance, or on a new reference
+// machine, regenerate them:
+//   ./wvu_perf --baselines=../perf_baselines.txt --update_baselines
+//
+// CTest runs every workload as a test labeled perf:
+//   ctest -L perf
+
+// Include second C++-Headers.
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <Eigen/Core>
+#include <GL/glew.h>
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include "asset_corpus.h"
+#include "benchmark.h"
+#include "camera.h"
+#include "cooked_assets.h"
+#include "headless_gl.h"
+#include "model.h"
+#include "model_loader.h"
+#include "perf_gate.h"
+#include "shader_program.h"
+#include "stress_scene.h"
+#include "transformations.h"
+
+DEFINE_string(baselines, "perf_baselines.txt",
+              "The baselines the metrics are compared against.");
+DEFINE_bool(update_baselines, false,
+            "Whether to overwrite the baselines with the measured metrics "
+            "instead of comparing them.");
+DEFINE_double(default_tolerance, 0.15,
+              "Tolerance of the metrics added to the baselines.");
+DEFINE_string(perf_filter, "",
+              "Only the metrics whose name contains it are measured.");
+DEFINE_int32(num_repetitions, 15, "Samples of every metric.");
+DEFINE_string(corpus_file, "wvu_perf_corpus.obj",
+              "The generated OBJ file of the load_obj workload.");
+
+namespace {
+
+constexpr int kNumModels = 1024;
+constexpr int kObjTriangles = 20000;
+constexpr int kTextureSize = 512;
+constexpr int kFramebufferWidth = 640;
+constexpr int kFramebufferHeight = 480;
+
+// The shaders of draw_scene.cc.
+const std::string vertex_shader_src =
+    "#version 330 core\n"
+    "layout (location = 0) in vec3 position;\n"
+    "layout (location = 1) in vec3 passed_color;\n"
+    "layout (location = 2) in vec2 passed_texel;\n"
+    "uniform mat4 model;\n"
+    "uniform mat4 view;\n"
+    "uniform mat4 projection;\n"
+    "out vec2 texel;\n"
+    "void main() {\n"
+    "  gl_Position = projection * view * model * vec4(position, 1.0f);\n"
+    "  texel = passed_texel;\n"
+    "}\n";
+
+const std::string fragment_shader_src =
+    "#version 330 core\n"
+    "in vec2 texel;\n"
+    "out vec4 color;\n"
+    "uniform sampler2D texture_sampler;\n"
+    "void main() {\n"
+    "  color = texture(texture_sampler, texel);\n"
+    "}\n";
+
+void AddModelMatrixWorkload(wvu::BenchmarkSuite* suite) {
+  std::srand(0);
+  auto models = std::make_shared<std::vector<std::unique_ptr<wvu::Model> > >();
+  for (int i = 0; i < kNumModels; ++i) {
+    models->emplace_back(new wvu::Model(Eigen::Vector3f::Random(),
+                                        Eigen::Vector3f::Random(),
+                                        Eigen::MatrixXf::Zero(8, 3)));
+  }
+  auto matrices = std::make_shared<std::vector<Eigen::Matrix4f> >(kNumModels);
+  suite->Add("model_matrix/1024", kNumModels,
+             [models, matrices](const int num_iterations) {
+    for (int i = 0; i < num_iterations; ++i) {
+      for (int j = 0; j < kNumModels; ++j) {
+        (*matrices)[j] = (*models)[j]->ComputeModelMatrix();
+      }
+      wvu::DoNotOptimize(*matrices);
+    }
+  });
+}
+
+void AddLoadObjWorkload(wvu::BenchmarkSuite* suite) {
+  std::string contents;
+  wvu::GenerateObjModel(kObjTriangles,
+                        wvu::ObjAttributes::POSITIONS_TEXELS_NORMALS,
+                        &contents);
+  CHECK(wvu::WriteFileContents(FLAGS_corpus_file, contents))
+      << "Could not write " << FLAGS_corpus_file;
+  const std::string filepath = FLAGS_corpus_file;
+  suite->Add("load_obj/v_vt_vn/20000", 1, [filepath](const int num_iterations) {
+    for (int i = 0; i < num_iterations; ++i) {
+      std::vector<Eigen::Vector3f> vertices;
+      std::vector<Eigen::Vector2f> texels;
+      std::vector<Eigen::Vector3f> normals;
+      std::vector<wvu::Face> faces;
+      wvu::LoadObjModel(filepath, &vertices, &texels, &normals, &faces);
+      wvu::DoNotOptimize(faces);
+    }
+  });
+}
+
+void AddTextureUploadWorkload(wvu::BenchmarkSuite* suite) {
+  auto rgb_pixels = std::make_shared<std::vector<uint8_t> >();
+  wvu::GenerateImage(kTextureSize, kTextureSize, 0, rgb_pixels.get());
+  suite->Add("texture_upload/rgb8/512", 1,
+             [rgb_pixels](const int num_iterations) {
+    GLuint texture_id;
+    glGenTextures(1, &texture_id);
+    glBindTexture(GL_TEXTURE_2D, texture_id);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (int i = 0; i < num_iterations; ++i) {
+      glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, kTextureSize, kTextureSize, 0,
+                   GL_RGB, GL_UNSIGNED_BYTE, rgb_pixels->data());
+      glFinish();
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDeleteTextures(1, &texture_id);
+  });
+}
+
+// The GL objects of the render_fbo workload. They are released when the
+// suite, which holds the workload, is destroyed.
+struct RenderWorkload {
+  ~RenderWorkload() {
+    glDeleteTextures(texture_ids.size(), texture_ids.data());
+  }
+
+  wvu::ShaderProgram shader_program;
+  wvu::OffscreenFramebuffer framebuffer;
+  std::vector<std::unique_ptr<wvu::Model> > models;
+  std::vector<GLuint> model_texture_ids;
+  std::vector<GLuint> texture_ids;
+  Eigen::Matrix4f projection;
+  Eigen::Matrix4f view;
+};
+
+bool AddRenderWorkload(wvu::BenchmarkSuite* suite) {
+  auto workload = std::make_shared<RenderWorkload>();
+  workload->shader_program.LoadVertexShaderFromString(vertex_shader_src);
+  workload->shader_program.LoadFragmentShaderFromString(fragment_shader_src);
+  std::string error_info_log;
+  if (!workload->shader_program.Create(&error_info_log)) {
+    LOG(ERROR) << error_info_log;
+    return false;
+  }
+
+  if (!workload->framebuffer.Initialize(kFramebufferWidth, kFramebufferHeight,
+                                        &error_info_log)) {
+    LOG(ERROR) << error_info_log;
+    return false;
+  }
+
+  // A fixed scene.
+  wvu::StressSceneOptions options;
+  options.num_objects = 500;
+  wvu::StressScene scene;
+  wvu::GenerateStressScene(options, &scene);
+  workload->texture_ids.resize(scene.textures.size());
+  glGenTextures(workload->texture_ids.size(), workload->texture_ids.data());
+  for (int i = 0; i < scene.textures.size(); ++i) {
+    glBindTexture(GL_TEXTURE_2D, workload->texture_ids[i]);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, options.texture_size,
+                 options.texture_size, 0, GL_RGB, GL_UNSIGNED_BYTE,
+                 scene.textures[i].data());
+  }
+  glBindTexture(GL_TEXTURE_2D, 0);
+  for (const wvu::StressObject& object : scene.objects) {
+    workload->models.emplace_back(new wvu::Model(
+        object.orientation, object.position,
+        scene.mesh_vertices[object.mesh_index],
+        scene.mesh_indices[object.mesh_index]));
+    workload->models.back()->SetVerticesIntoGpu();
+    workload->model_texture_ids.push_back(
+        workload->texture_ids[object.texture_index]);
+  }
+
+  // A fixed camera at the origin looking into the scene.
+  wvu::CameraParameters camera_params;
+  camera_params.field_of_view = wvu::ConvertDegreesToRadians(45.0f);
+  camera_params.aspect_ratio =
+      static_cast<float>(kFramebufferWidth) / kFramebufferHeight;
+  camera_params.near_plane_distance = 0.1f;
+  camera_params.far_plane_distance = 100.0f;
+  camera_params.position = Eigen::Vector3f::Zero();
+  camera_params.view_direction = -Eigen::Vector3f::UnitZ();
+  camera_params.up_vector = Eigen::Vector3f::UnitY();
+  wvu::Camera camera(camera_params);
+  CHECK(camera.Initialize() == wvu::CameraInitializationError::NO_ERROR);
+  workload->projection = camera.ComputeProjectionMatrix();
+  workload->view = camera.ComputeLookAtMatrix();
+
+  suite->Add("render_fbo/stress_500", 1, [workload](const int num_iterations) {
+    workload->framebuffer.Bind();
+    glEnable(GL_DEPTH_TEST);
+    for (int i = 0; i < num_iterations; ++i) {
+      glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+      workload->shader_program.Use();
+      for (int j = 0; j < workload->models.size(); ++j) {
+        workload->models[j]->Draw(workload->shader_program,
+                                  workload->projection, workload->view,
+                                  workload->model_texture_ids[j]);
+      }
+      glFinish();
+    }
+    workload->framebuffer.Unbind();
+  });
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  GLUTILS_GFLAGS_NAMESPACE::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  wvu::PerfBaselines baselines;
+  std::string error_info_log;
+  if (!baselines.Load(FLAGS_baselines, &error_info_log)) {
+    LOG(ERROR) << error_info_log;
+    return -1;
+  }
+
+  wvu::BenchmarkOptions options;
+  options.num_repetitions = FLAGS_num_repetitions;
+  std::unique_ptr<wvu::BenchmarkSuite> suite(
+      new wvu::BenchmarkSuite(options));
+  AddModelMatrixWorkload(suite.get());
+  AddLoadObjWorkload(suite.get());
+  std::vector<std::string> skipped_workloads;
+  std::unique_ptr<wvu::HeadlessGlContext> context(
+      new wvu::HeadlessGlContext);
+  if (!context->Initialize(&error_info_log)) {
+    LOG(WARNING) << error_info_log
+                 << " The OpenGL workloads are skipped.";
+    skipped_workloads = {"texture_upload/rgb8/512", "render_fbo/stress_500"};
+  } else {
+    AddTextureUploadWorkload(suite.get());
+    if (!AddRenderWorkload(suite.get())) return -1;
+  }
+  suite->Run(FLAGS_perf_filter);
+
+  std::vector<wvu::PerfComparison> comparisons;
+  for (const wvu::BenchmarkResult& result : suite->results()) {
+    const wvu::PerfBaseline* baseline = baselines.Find(result.name);
+    comparisons.push_back(
+        wvu::ComparePerformance(result.name, result.ns_per_item, baseline));
+    if (FLAGS_update_baselines) {
+      wvu::PerfBaseline updated_baseline;
+      updated_baseline.median = result.ns_per_item.median;
+      updated_baseline.median_absolute_deviation =
+          result.ns_per_item.median_absolute_deviation;
+      // The tolerances are tuned by hand: keep them.
+      updated_baseline.tolerance = baseline != nullptr ?
+          baseline->tolerance : FLAGS_default_tolerance;
+      baselines.Set(result.name, updated_baseline);
+    }
+  }
+  for (const std::string& name : skipped_workloads) {
+    if (name.find(FLAGS_perf_filter) == std::string::npos) continue;
+    wvu::PerfComparison comparison;
+    comparison.name = name;
+    comparison.status = wvu::PerfStatus::SKIPPED;
+    comparisons.push_back(comparison);
+  }
+  wvu::PrintPerfComparisons(comparisons, &std::cout);
+
+  // The GL objects of the workloads need the context.
+  suite.reset();
+  context.reset();
+  if (FLAGS_update_baselines) {
+    if (!baselines.Save(FLAGS_baselines, &error_info_log)) {
+      LOG(ERROR) << error_info_log;
+      return -1;
+    }
+    std::cout << "Updated " << FLAGS_baselines << "\n";
+    return 0;
+  }
+  if (!wvu::PassesPerfGate(comparisons)) {
+    std::cout << "Performance regressed: see the metrics marked REGRESSED.\n";
+    return 1;
+  }
+  return 0;
+}